@@ -485,6 +485,65 @@ def ApplyPlatformSpecificSettings(env, platform):
 		pass
 
 
+##################################
+# AddBuildVariant
+##################################
+def AddBuildVariant(env):
+
+	# Adds the compile and link flags of the build variant chosen with
+	# VARIANT= on the scons command line. This is called by the
+	# SConscript files of the code whose speed matters (the amplitude
+	# and data I/O libraries and the fit programs) so that the rest of
+	# the tree is built as usual. The variants are:
+	#
+	#   opt-native  -O3 for the ISA of the build machine (MARCH=, default
+	#               native) with link-time optimization
+	#   pgo-gen     as opt-native without LTO, instrumented to write
+	#               profiles to PGO_DIR when the programs run
+	#   pgo-use     as opt-native, optimized with the profiles in PGO_DIR
+	#
+	# The objects are built in the same place for all variants since gcc
+	# looks up the profile of an object by its path. The LTO objects are
+	# fat, so programs that are linked without -flto still link with them.
+	variant = env['BUILD_VARIANT']
+	if variant == '': return
+
+	if variant not in ['opt-native', 'pgo-gen', 'pgo-use']:
+		print('sbms : unknown VARIANT=%s (opt-native, pgo-gen or pgo-use)' % variant)
+		sys.exit(1)
+
+	archflags = ['-O3', '-march=%s' % env['MARCH']]
+	ltoflags = ['-flto', '-ffat-lto-objects']
+	if env['COMPILER'] == 'clang': ltoflags = ['-flto=thin']
+
+	# gcc writes one .gcda per object under the profile directory, clang
+	# .profraw files that have to be merged into default.profdata with
+	# llvm-profdata before the pgo-use build
+	pgodir = env.Dir(env['PGO_DIR']).abspath
+	if variant == 'pgo-gen':
+		flags = archflags + ['-fprofile-generate=%s' % pgodir]
+		if env['COMPILER'] == 'gcc': flags.append('-fprofile-update=prefer-atomic')
+		linkflags = ['-fprofile-generate=%s' % pgodir]
+	elif variant == 'pgo-use':
+		if env['COMPILER'] == 'clang':
+			pgoflags = ['-fprofile-use=%s/default.profdata' % pgodir]
+		else:
+			pgoflags = ['-fprofile-use=%s' % pgodir, '-fprofile-correction', '-Wno-missing-profile']
+		flags = archflags + ltoflags + pgoflags
+		linkflags = ltoflags + pgoflags
+	else:
+		flags = archflags + ltoflags
+		linkflags = ltoflags
+
+	env.AppendUnique(CFLAGS = flags)
+	env.AppendUnique(CXXFLAGS = flags)
+	env.AppendUnique(LINKFLAGS = archflags + linkflags)
+
+	# the archive index has to list the symbols of the LTO objects
+	if env['COMPILER'] == 'gcc' and '-flto' in flags:
+		env.Replace(AR = 'gcc-ar', RANLIB = 'gcc-ranlib')
+
+
 
 ##################################
 # OptionallyBuild
@@ -1040,8 +1099,27 @@ def AddCUDA(env):
 		
 		# Create Builder that can compile .cu file into object files
 		NVCC = '%s/bin/nvcc' % CUDA
-#		CUDAFLAGS = '-I%s/include -arch=compute_13 -code=compute_13' % CUDA
-		CUDAFLAGS = ['-g', '-I%s/include' % CUDA]
+		CUDAFLAGS = ['-I%s/include' % CUDA]
+
+		# CUDA_RELEASE=1 builds without host debug symbols (-lineinfo
+		# keeps the source lines for the profilers) and, with
+		# CUDA_FAST_MATH=1, with the fast intrinsics for the kernels
+		# whose fit results have been checked against the exact build
+		if int(env['CUDA_RELEASE']) == 1:
+			CUDAFLAGS.extend(['-O3', '-lineinfo'])
+			if int(env['CUDA_FAST_MATH']) == 1: CUDAFLAGS.append('-use_fast_math')
+		else:
+			CUDAFLAGS.append('-g')
+
+		# One cubin per SM version in CUDA_ARCH (e.g. "80 90" for A100 and
+		# H100) in a fatbin, plus the PTX of the newest for the GPUs that
+		# come after it. Without CUDA_ARCH nvcc builds for its default.
+		archs = sorted(set(env['CUDA_ARCH'].replace(',', ' ').split()), key=int)
+		for sm in archs:
+			CUDAFLAGS.append('-gencode arch=compute_%s,code=sm_%s' % (sm, sm))
+		if len(archs) > 0:
+			CUDAFLAGS.append('-gencode arch=compute_%s,code=compute_%s' % (archs[-1], archs[-1]))
+
 		try:
 			CUDAFLAGS.extend(env['CUDAFLAGS'])
 		except:
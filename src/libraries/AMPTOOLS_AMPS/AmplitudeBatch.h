@@ -0,0 +1,145 @@
+#if !defined(AMPLITUDEBATCH)
+#define AMPLITUDEBATCH
+
+#include <complex>
+#include <utility>
+
+#include "IUAmpTools/Amplitude.h"
+#include "GPUManager/GPUCustomTypes.h"
+
+using std::complex;
+
+// An optional batch entry point for amplitudes.  An amplitude class may
+// provide the (non-virtual) member
+//
+//   void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+//                            int nEvents, complex< GDouble >* amps ) const;
+//
+// where pKin[i] is the pKin array of event i (it may be NULL for amplitudes
+// with needsUserVarsOnly()), userVars holds numUserVars() values per event
+// one event after the other, and amps[i] receives the amplitude of event i.
+// Inside the batch function the amplitude can hoist everything that does
+// not depend on the event out of the loop, and the loop is free of virtual
+// calls.
+//
+// calcAmplitudeBlock() calls the batch function of an amplitude if it has
+// one and otherwise falls back to the scalar calcAmplitude for each event.
+
+template< class A >
+struct hasAmplitudeBatch {
+
+  template< class U, void (U::*)( GDouble** const*, const GDouble*, int,
+                                  complex< GDouble >* ) const >
+  struct Check;
+
+  template< class U >
+  static char test( Check< U, &U::calcAmplitudeBatch >* );
+
+  template< class U >
+  static long test( ... );
+
+  static const bool value = ( sizeof( test< A >( 0 ) ) == 1 );
+};
+
+namespace amplitudeBatchDetail {
+
+  template< bool batch > struct Dispatch;
+
+  template<>
+  struct Dispatch< true > {
+
+    template< class A >
+    static void calc( const A& amp, GDouble** const* pKin, const GDouble* userVars,
+                      int nEvents, complex< GDouble >* amps ){
+
+      amp.calcAmplitudeBatch( pKin, userVars, nEvents, amps );
+    }
+  };
+
+  template<>
+  struct Dispatch< false > {
+
+    template< class A >
+    static void calc( const A& amp, GDouble** const* pKin, const GDouble* userVars,
+                      int nEvents, complex< GDouble >* amps ){
+
+      // go through the base class so that amplitudes that only implement
+      // calcAmplitude( pKin ) are handled as well
+      const Amplitude& base = amp;
+      unsigned int stride = amp.numUserVars();
+
+      for( int i = 0; i < nEvents; ++i ){
+
+        amps[i] = base.calcAmplitude( pKin[i],
+                                      const_cast< GDouble* >( userVars + i * stride ) );
+      }
+    }
+  };
+}
+
+// An amplitude may also declare that its value does not depend on the
+// event, the permutation or the user variables (only on its arguments and
+// parameters) with the member
+//
+//   bool isEventIndependent() const;
+//
+// (Uniform, polCoef).  calcAmplitudeBlock() and ThreadedAmplitude then
+// compute the amplitude once and copy it to every event.
+
+template< class A >
+struct hasEventIndependence {
+
+  // an expression test, so that the member is also found in a wrapper
+  // derived from the amplitude (ProfiledAmplitude)
+  template< class U >
+  static char test( decltype( std::declval< const U& >().isEventIndependent() )* );
+
+  template< class U >
+  static long test( ... );
+
+  static const bool value = ( sizeof( test< A >( 0 ) ) == 1 );
+};
+
+namespace amplitudeBatchDetail {
+
+  template< bool declared > struct Independence;
+
+  template<>
+  struct Independence< true > {
+
+    template< class A >
+    static bool of( const A& amp ){ return amp.isEventIndependent(); }
+  };
+
+  template<>
+  struct Independence< false > {
+
+    template< class A >
+    static bool of( const A& ){ return false; }
+  };
+}
+
+template< class A >
+bool isEventIndependent( const A& amp ){
+
+  return amplitudeBatchDetail::Independence< hasEventIndependence< A >::value >::of( amp );
+}
+
+template< class A >
+void calcAmplitudeBlock( const A& amp, GDouble** const* pKin, const GDouble* userVars,
+                         int nEvents, complex< GDouble >* amps ){
+
+  if( nEvents > 1 && isEventIndependent( amp ) ){
+
+    amplitudeBatchDetail::Dispatch< hasAmplitudeBatch< A >::value >::
+      calc( amp, pKin, userVars, 1, amps );
+
+    for( int i = 1; i < nEvents; ++i ) amps[i] = amps[0];
+    return;
+  }
+
+  amplitudeBatchDetail::Dispatch< hasAmplitudeBatch< A >::value >::
+    calc( amp, pKin, userVars, nEvents, amps );
+}
+
+#endif
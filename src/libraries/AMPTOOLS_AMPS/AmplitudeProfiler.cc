@@ -0,0 +1,380 @@
+
+#include <cassert>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+#ifdef GPU_ACCELERATION
+#include <cuda_runtime.h>
+#endif
+
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+namespace {
+
+  const char* kPhaseNames[AmplitudeProfiler::kNumPhases] =
+    { "other", "setup", "firstLikelihood", "fit" };
+  const char* kCallNames[AmplitudeProfiler::kNumCalls] =
+    { "userVars", "amplitude", "gpuKernel" };
+
+  struct Registry {
+
+    mutex lock;
+    list< AmplitudeProfiler::Entry > entries;
+    map< pair< string, string >, AmplitudeProfiler::Entry* > index;
+
+    // amplitudes of the configurations that are not computed at all
+    vector< string > dropped;
+
+    // wall time per phase, the current one up to phaseStart
+    double phaseSeconds[AmplitudeProfiler::kNumPhases];
+    chrono::steady_clock::time_point phaseStart;
+    bool started;
+
+    Registry() : started( false ) {
+
+      for( int i = 0; i < AmplitudeProfiler::kNumPhases; ++i ) phaseSeconds[i] = 0;
+    }
+  };
+
+  Registry& registry(){
+
+    static Registry reg;
+    return reg;
+  }
+
+  double seconds( const AmplitudeProfiler::Counter& counter ){
+
+    return 1e-9 * counter.nanoseconds.load();
+  }
+
+  double totalSeconds( const AmplitudeProfiler::Entry& entry ){
+
+    double total = 0;
+    for( int p = 0; p < AmplitudeProfiler::kNumPhases; ++p )
+      for( int c = 0; c < AmplitudeProfiler::kNumCalls; ++c )
+        total += seconds( entry.counters[p][c] );
+    return total;
+  }
+
+  // the current phase is closed so that its wall time is up to date
+  void updatePhaseTime( Registry& reg ){
+
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if( reg.started )
+      reg.phaseSeconds[AmplitudeProfiler::phase()] +=
+        chrono::duration< double >( now - reg.phaseStart ).count();
+    reg.phaseStart = now;
+    reg.started = true;
+  }
+
+  string jsonString( const string& value ){
+
+    ostringstream out;
+    out << '"';
+    for( unsigned int i = 0; i < value.size(); ++i ){
+
+      if( value[i] == '"' || value[i] == '\\' ) out << '\\' << value[i];
+      else if( (unsigned char)value[i] < 0x20 ) out << ' ';
+      else out << value[i];
+    }
+    out << '"';
+    return out.str();
+  }
+
+  // the sums over the instances of each class, in the layout of an entry
+  struct ClassSum {
+
+    string className;
+    int nInstances;
+    long long calls[AmplitudeProfiler::kNumCalls];
+    double seconds[AmplitudeProfiler::kNumCalls];
+    double total;
+  };
+}
+
+atomic< int >&
+AmplitudeProfiler::currentPhase(){
+
+  static atomic< int > current( kOther );
+  return current;
+}
+
+AmplitudeProfiler::Entry*
+AmplitudeProfiler::entry( const string& className, const string& instance ){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  if( !reg.started ) updatePhaseTime( reg );
+
+  pair< string, string > key( className, instance );
+  map< pair< string, string >, Entry* >::iterator found = reg.index.find( key );
+  if( found != reg.index.end() ) return found->second;
+
+  reg.entries.emplace_back();
+  Entry* newEntry = &( reg.entries.back() );
+  newEntry->className = className;
+  newEntry->instance = instance;
+  for( int p = 0; p < kNumPhases; ++p )
+    for( int c = 0; c < kNumCalls; ++c ){
+
+      newEntry->counters[p][c].calls = 0;
+      newEntry->counters[p][c].nanoseconds = 0;
+    }
+
+  reg.index[key] = newEntry;
+  return newEntry;
+}
+
+void
+AmplitudeProfiler::addDropped( const vector< string >& fullNames ){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  reg.dropped.insert( reg.dropped.end(), fullNames.begin(), fullNames.end() );
+}
+
+void
+AmplitudeProfiler::setPhase( Phase phase ){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  updatePhaseTime( reg );
+  currentPhase().store( phase );
+}
+
+void
+AmplitudeProfiler::reset(){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  for( list< Entry >::iterator it = reg.entries.begin(); it != reg.entries.end(); ++it )
+    for( int p = 0; p < kNumPhases; ++p )
+      for( int c = 0; c < kNumCalls; ++c ){
+
+        it->counters[p][c].calls = 0;
+        it->counters[p][c].nanoseconds = 0;
+      }
+
+  for( int p = 0; p < kNumPhases; ++p ) reg.phaseSeconds[p] = 0;
+  reg.phaseStart = chrono::steady_clock::now();
+}
+
+vector< long long >
+AmplitudeProfiler::counterValues(){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  vector< long long > values;
+  for( list< Entry >::const_iterator it = reg.entries.begin(); it != reg.entries.end(); ++it )
+    for( int p = 0; p < kNumPhases; ++p )
+      for( int c = 0; c < kNumCalls; ++c ){
+
+        values.push_back( it->counters[p][c].calls );
+        values.push_back( it->counters[p][c].nanoseconds );
+      }
+
+  return values;
+}
+
+void
+AmplitudeProfiler::setCounterValues( const vector< long long >& values ){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  assert( values.size() == reg.entries.size() * kNumPhases * kNumCalls * 2 );
+
+  unsigned int i = 0;
+  for( list< Entry >::iterator it = reg.entries.begin(); it != reg.entries.end(); ++it )
+    for( int p = 0; p < kNumPhases; ++p )
+      for( int c = 0; c < kNumCalls; ++c ){
+
+        it->counters[p][c].calls = values[i++];
+        it->counters[p][c].nanoseconds = values[i++];
+      }
+}
+
+void
+AmplitudeProfiler::synchronizeGPU(){
+
+#ifdef GPU_ACCELERATION
+  cudaDeviceSynchronize();
+#endif
+}
+
+void
+AmplitudeProfiler::report( ostream& out ){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  updatePhaseTime( reg );
+
+  vector< const Entry* > entries;
+  for( list< Entry >::const_iterator it = reg.entries.begin(); it != reg.entries.end(); ++it )
+    if( totalSeconds( *it ) > 0 ) entries.push_back( &( *it ) );
+
+  sort( entries.begin(), entries.end(),
+        []( const Entry* a, const Entry* b ){ return totalSeconds( *a ) > totalSeconds( *b ); } );
+
+  double wall = 0, amplitudes = 0;
+  for( int p = 0; p < kNumPhases; ++p ) wall += reg.phaseSeconds[p];
+  for( unsigned int i = 0; i < entries.size(); ++i ) amplitudes += totalSeconds( *entries[i] );
+
+  // per class
+  vector< ClassSum > classes;
+  for( unsigned int i = 0; i < entries.size(); ++i ){
+
+    unsigned int k = 0;
+    while( k < classes.size() && classes[k].className != entries[i]->className ) ++k;
+    if( k == classes.size() ){
+
+      ClassSum sum;
+      sum.className = entries[i]->className;
+      sum.nInstances = 0;
+      sum.total = 0;
+      for( int c = 0; c < kNumCalls; ++c ){ sum.calls[c] = 0; sum.seconds[c] = 0; }
+      classes.push_back( sum );
+    }
+
+    ClassSum& sum = classes[k];
+    ++sum.nInstances;
+    for( int p = 0; p < kNumPhases; ++p )
+      for( int c = 0; c < kNumCalls; ++c ){
+
+        sum.calls[c] += entries[i]->counters[p][c].calls;
+        sum.seconds[c] += seconds( entries[i]->counters[p][c] );
+      }
+    sum.total += totalSeconds( *entries[i] );
+  }
+
+  ios::fmtflags flags = out.flags();
+  streamsize precision = out.precision();
+  out << fixed << setprecision( 3 );
+
+  out << endl << "AMPLITUDE PROFILE" << endl << endl;
+  out << "   wall time:  " << wall << " s  (";
+  for( int p = 0; p < kNumPhases; ++p )
+    out << ( p ? ", " : "" ) << kPhaseNames[p] << " " << reg.phaseSeconds[p] << " s";
+  out << ")" << endl;
+  out << "   in amplitudes:  " << amplitudes << " s" << endl;
+  if( reg.dropped.size() != 0 )
+    out << "   dropped amplitudes (fixed to zero):  " << reg.dropped.size() << endl;
+  out << endl;
+
+  out << setw( 24 ) << left << "   class" << right
+      << setw( 6 ) << "inst" << setw( 11 ) << "total [s]" << setw( 8 ) << "share"
+      << setw( 14 ) << "userVars" << setw( 11 ) << "[s]"
+      << setw( 14 ) << "amplitudes" << setw( 11 ) << "[s]" << setw( 11 ) << "[ns/call]"
+      << setw( 10 ) << "kernels" << setw( 11 ) << "[s]" << endl;
+
+  for( unsigned int k = 0; k < classes.size(); ++k ){
+
+    const ClassSum& sum = classes[k];
+    out << "   " << setw( 21 ) << left << sum.className << right
+        << setw( 6 ) << sum.nInstances << setw( 11 ) << sum.total
+        << setw( 7 ) << setprecision( 1 ) << ( amplitudes > 0 ? 100 * sum.total / amplitudes : 0 ) << "%"
+        << setprecision( 3 )
+        << setw( 14 ) << sum.calls[kUserVars] << setw( 11 ) << sum.seconds[kUserVars]
+        << setw( 14 ) << sum.calls[kAmplitude] << setw( 11 ) << sum.seconds[kAmplitude]
+        << setw( 11 ) << setprecision( 1 )
+        << ( sum.calls[kAmplitude] > 0 ? 1e9 * sum.seconds[kAmplitude] / sum.calls[kAmplitude] : 0 )
+        << setprecision( 3 )
+        << setw( 10 ) << sum.calls[kGPUKernel] << setw( 11 ) << sum.seconds[kGPUKernel] << endl;
+  }
+
+  // per instance and phase
+  out << endl << "   instance" << endl;
+  for( unsigned int i = 0; i < entries.size(); ++i ){
+
+    const Entry& e = *entries[i];
+    out << "   " << setw( 11 ) << totalSeconds( e ) << " s   " << e.className << " " << e.instance << endl;
+
+    for( int p = 0; p < kNumPhases; ++p ){
+
+      bool any = false;
+      for( int c = 0; c < kNumCalls; ++c ) any = any || e.counters[p][c].calls > 0;
+      if( !any ) continue;
+
+      out << "   " << setw( 20 ) << kPhaseNames[p];
+      for( int c = 0; c < kNumCalls; ++c ){
+
+        if( e.counters[p][c].calls == 0 ) continue;
+        out << "   " << kCallNames[c] << " " << e.counters[p][c].calls << " calls "
+            << seconds( e.counters[p][c] ) << " s";
+      }
+      out << endl;
+    }
+  }
+  out << endl;
+
+  out.flags( flags );
+  out.precision( precision );
+}
+
+bool
+AmplitudeProfiler::writeJSON( const string& fileName ){
+
+  Registry& reg = registry();
+  lock_guard< mutex > guard( reg.lock );
+
+  updatePhaseTime( reg );
+
+  ofstream out( fileName.c_str() );
+  if( !out ){
+
+    cout << "AmplitudeProfiler ERROR:  cannot write " << fileName << endl;
+    return false;
+  }
+
+  out.precision( 9 );
+  out << "{" << endl;
+
+  out << "  \"phases\": {";
+  for( int p = 0; p < kNumPhases; ++p )
+    out << ( p ? ", " : " " ) << "\"" << kPhaseNames[p] << "\": " << reg.phaseSeconds[p];
+  out << " }," << endl;
+
+  out << "  \"dropped\": [";
+  for( unsigned int i = 0; i < reg.dropped.size(); ++i )
+    out << ( i ? ", " : " " ) << jsonString( reg.dropped[i] );
+  out << ( reg.dropped.size() ? " ]," : "]," ) << endl;
+
+  out << "  \"amplitudes\": [";
+  bool first = true;
+  for( list< Entry >::const_iterator it = reg.entries.begin(); it != reg.entries.end(); ++it ){
+
+    if( totalSeconds( *it ) == 0 ) continue;
+
+    out << ( first ? "" : "," ) << endl;
+    first = false;
+
+    out << "    { \"class\": " << jsonString( it->className )
+        << ", \"instance\": " << jsonString( it->instance )
+        << ", \"seconds\": " << totalSeconds( *it );
+
+    for( int p = 0; p < kNumPhases; ++p ){
+
+      out << "," << endl << "      \"" << kPhaseNames[p] << "\": {";
+      for( int c = 0; c < kNumCalls; ++c )
+        out << ( c ? ", " : " " ) << "\"" << kCallNames[c] << "\": { \"calls\": "
+            << it->counters[p][c].calls << ", \"seconds\": " << seconds( it->counters[p][c] ) << " }";
+      out << " }";
+    }
+    out << " }";
+  }
+  out << endl << "  ]" << endl << "}" << endl;
+
+  return true;
+}
@@ -0,0 +1,119 @@
+#if !defined(AMPLITUDEPROFILER)
+#define AMPLITUDEPROFILER
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Timing and call counts of the amplitudes of a fit, collected by the
+// ProfiledAmplitude wrapper (see ProfiledAmplitude.h) for every amplitude
+// instance, i.e., every amplitude class with a distinct list of arguments.
+//
+// The calls are counted separately for the phases of a fit, which the fit
+// program marks with setPhase:  the construction of the AmpToolsInterface,
+// where the user variables of the data and MC are computed; the first
+// likelihood, which computes the amplitudes of the data and the accepted MC
+// and from them the normalization integrals; and the minimization.  The wall
+// time of each phase is kept as well, so the time spent outside of the
+// amplitudes can be read off.
+//
+// Timing every call costs two clock reads, so a profiled fit is somewhat
+// slower than an unprofiled one; the relative cost of the amplitudes is
+// what the report is meant for.
+//
+// Calls before the first setPhase or in processes that do not mark phases,
+// e.g., the worker ranks of fitMPI, are counted as "other".
+
+class AmplitudeProfiler
+{
+
+public:
+
+  enum Phase { kOther = 0, kSetup, kFirstLikelihood, kFit, kNumPhases };
+  enum Call { kUserVars = 0, kAmplitude, kGPUKernel, kNumCalls };
+
+  struct Counter {
+
+    atomic< long long > calls;
+    atomic< long long > nanoseconds;
+  };
+
+  struct Entry {
+
+    string className;
+    string instance;
+    Counter counters[kNumPhases][kNumCalls];
+  };
+
+  /**
+   * The entry of an amplitude instance, created on the first call; entries
+   * live until the end of the job.
+   */
+  static Entry* entry( const string& className, const string& instance );
+
+  static void setPhase( Phase phase );
+
+  /**
+   * Records amplitudes that were dropped from the configuration and are
+   * never computed (see WavePruner), so that the report shows them.
+   */
+  static void addDropped( const vector< string >& fullNames );
+  static Phase phase() { return (Phase)currentPhase().load( memory_order_relaxed ); }
+
+  // zeroes all counters and phase times, e.g., in a forked worker
+  static void reset();
+
+  // waits for the GPU so that the time of a kernel launch covers the kernel
+  static void synchronizeGPU();
+
+  /**
+   * Prints the time and call counts per amplitude class and per instance,
+   * largest first.
+   */
+  static void report( ostream& out = cout );
+
+  static bool writeJSON( const string& fileName );
+
+  /**
+   * All counters in the order of the entries, and the same with values
+   * from elsewhere, e.g., the sums over the ranks of an MPI job, which
+   * have the same entries if they run the same configuration.
+   */
+  static vector< long long > counterValues();
+  static void setCounterValues( const vector< long long >& values );
+
+private:
+
+  static atomic< int >& currentPhase();
+};
+
+// adds the time of its scope to a counter of the current phase
+class AmplitudeTimer
+{
+
+public:
+
+  AmplitudeTimer( AmplitudeProfiler::Entry* entry, AmplitudeProfiler::Call call ) :
+    m_counter( entry->counters[AmplitudeProfiler::phase()][call] ),
+    m_start( chrono::steady_clock::now() ) {}
+
+  ~AmplitudeTimer(){
+
+    long long ns = chrono::duration_cast< chrono::nanoseconds >
+                   ( chrono::steady_clock::now() - m_start ).count();
+
+    m_counter.calls.fetch_add( 1, memory_order_relaxed );
+    m_counter.nanoseconds.fetch_add( ns, memory_order_relaxed );
+  }
+
+private:
+
+  AmplitudeProfiler::Counter& m_counter;
+  chrono::steady_clock::time_point m_start;
+};
+
+#endif
@@ -0,0 +1,267 @@
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TROOT.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeBatch.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+#include "AMPTOOLS_AMPS/ThreadedAmplitude.h"
+#include "AMPTOOLS_AMPS/ProfiledAmplitude.h"
+#include "AMPTOOLS_AMPS/UserVarsCache.h"
+
+#include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_AMPS/BreitWigner3body.h"
+#include "AMPTOOLS_AMPS/Compton.h"
+#include "AMPTOOLS_AMPS/EtaPb_tdist.h"
+#include "AMPTOOLS_AMPS/Flatte.h"
+#include "AMPTOOLS_AMPS/Hist2D.h"
+#include "AMPTOOLS_AMPS/Lambda1520Angles.h"
+#include "AMPTOOLS_AMPS/Lambda1520tdist.h"
+#include "AMPTOOLS_AMPS/Pi0Regge.h"
+#include "AMPTOOLS_AMPS/Pi0SAID.h"
+#include "AMPTOOLS_AMPS/PiPlusRegge.h"
+#include "AMPTOOLS_AMPS/Piecewise.h"
+#include "AMPTOOLS_AMPS/ThreePiAngles.h"
+#include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
+#include "AMPTOOLS_AMPS/TwoPSAngles.h"
+#include "AMPTOOLS_AMPS/TwoPSHelicity.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles.h"
+#include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles_amp.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles_primakoff.h"
+#include "AMPTOOLS_AMPS/TwoPiEtas_tdist.h"
+#include "AMPTOOLS_AMPS/TwoPiNC_tdist.h"
+#include "AMPTOOLS_AMPS/TwoPiW_brokenetas.h"
+#include "AMPTOOLS_AMPS/TwoPiWt_primakoff.h"
+#include "AMPTOOLS_AMPS/TwoPiWt_sigma.h"
+#include "AMPTOOLS_AMPS/TwoPitdist.h"
+#include "AMPTOOLS_AMPS/Uniform.h"
+#include "AMPTOOLS_AMPS/Vec_ps_refl.h"
+#include "AMPTOOLS_AMPS/Ylm.h"
+#include "AMPTOOLS_AMPS/Zlm.h"
+#include "AMPTOOLS_AMPS/b1piAngAmp.h"
+#include "AMPTOOLS_AMPS/dblRegge.h"
+#include "AMPTOOLS_AMPS/dblReggeMod.h"
+#include "AMPTOOLS_AMPS/omegapiAngAmp.h"
+#include "AMPTOOLS_AMPS/omegapi_amplitude.h"
+#include "AMPTOOLS_AMPS/polCoef.h"
+
+namespace {
+
+  // A, with its static user variables kept between interfaces if asked
+  template< class A >
+  void registerCached( const AmplitudeRegistry::Options& options ){
+
+    if( options.cacheUserVars ) AmpToolsInterface::registerAmplitude( CachedUserVars< A >() );
+    else AmpToolsInterface::registerAmplitude( A() );
+  }
+
+  // the prototype of A is only made here, when A is registered
+  template< class A >
+  void registerAs( const AmplitudeRegistry::Options& options, bool threadSafe ){
+
+    // ThreadedAmplitude also computes an event-independent amplitude once
+    // and calls the calcAmplitudeBatch of A, on the calling thread if
+    // there is only one
+    bool threaded = ( ( ( AmplitudeThreads::numThreads() > 1 || hasAmplitudeBatch< A >::value ) &&
+                        threadSafe ) || isEventIndependent( A() ) );
+
+    if( options.profile ){
+
+      if( threaded ) registerCached< ThreadedAmplitude< ProfiledAmplitude< A > > >( options );
+      else registerCached< ProfiledAmplitude< A > >( options );
+    }
+    else{
+
+      if( threaded ) registerCached< ThreadedAmplitude< A > >( options );
+      else registerCached< A >( options );
+    }
+
+    if( options.onRegister ) options.onRegister( A() );
+  }
+
+  struct Entry {
+
+    const char* name;
+    void (*registerAs)( const AmplitudeRegistry::Options&, bool );
+    // false for the classes that ask for the current permutation, which
+    // ThreadedAmplitude cannot share between threads
+    bool threadSafe;
+    // the loader of the shared tables of an instance, for the classes
+    // that have them
+    void (*loadShared)( const vector< string >& );
+  };
+
+  #define AMPLITUDE_ENTRY( A, threadSafe ) { #A, registerAs< A >, threadSafe, NULL }
+  #define AMPLITUDE_ENTRY_SHARED( A, threadSafe ) { #A, registerAs< A >, threadSafe, A::loadShared }
+
+  const Entry kEntries[] = {
+
+    AMPLITUDE_ENTRY( BreitWigner,                   true ),
+    AMPLITUDE_ENTRY( BreitWigner3body,              true ),
+    AMPLITUDE_ENTRY_SHARED( Compton,                true ),
+    AMPLITUDE_ENTRY( EtaPb_tdist,                   true ),
+    AMPLITUDE_ENTRY( Flatte,                        true ),
+    AMPLITUDE_ENTRY_SHARED( Hist2D,                 true ),
+    AMPLITUDE_ENTRY_SHARED( Lambda1520Angles,       true ),
+    AMPLITUDE_ENTRY( Lambda1520tdist,               true ),
+    AMPLITUDE_ENTRY_SHARED( Pi0Regge,               true ),
+    AMPLITUDE_ENTRY_SHARED( Pi0SAID,                true ),
+    AMPLITUDE_ENTRY_SHARED( PiPlusRegge,            true ),
+    AMPLITUDE_ENTRY( Piecewise,                     true ),
+    AMPLITUDE_ENTRY( ThreePiAngles,                 false ),
+    AMPLITUDE_ENTRY_SHARED( ThreePiAnglesSchilling, true ),
+    AMPLITUDE_ENTRY( TwoPSAngles,                   true ),
+    AMPLITUDE_ENTRY( TwoPSHelicity,                 true ),
+    AMPLITUDE_ENTRY_SHARED( TwoPiAngles,            true ),
+    AMPLITUDE_ENTRY_SHARED( TwoPiAnglesRadiative,   true ),
+    AMPLITUDE_ENTRY( TwoPiAngles_amp,               true ),
+    AMPLITUDE_ENTRY( TwoPiAngles_primakoff,         true ),
+    AMPLITUDE_ENTRY( TwoPiEtas_tdist,               true ),
+    AMPLITUDE_ENTRY( TwoPiNC_tdist,                 true ),
+    AMPLITUDE_ENTRY( TwoPiW_brokenetas,             true ),
+    AMPLITUDE_ENTRY_SHARED( TwoPiWt_primakoff,      true ),
+    AMPLITUDE_ENTRY( TwoPiWt_sigma,                 true ),
+    AMPLITUDE_ENTRY( TwoPitdist,                    true ),
+    AMPLITUDE_ENTRY( Uniform,                       true ),
+    AMPLITUDE_ENTRY_SHARED( Vec_ps_refl,            true ),
+    AMPLITUDE_ENTRY( Ylm,                           true ),
+    AMPLITUDE_ENTRY_SHARED( Zlm,                    true ),
+    AMPLITUDE_ENTRY( b1piAngAmp,                    false ),
+    AMPLITUDE_ENTRY( dblRegge,                      true ),
+    AMPLITUDE_ENTRY( dblReggeMod,                   true ),
+    AMPLITUDE_ENTRY( omegapiAngAmp,                 true ),
+    AMPLITUDE_ENTRY( omegapi_amplitude,             true ),
+    AMPLITUDE_ENTRY( polCoef,                       true )
+  };
+
+  #undef AMPLITUDE_ENTRY
+  #undef AMPLITUDE_ENTRY_SHARED
+
+  const unsigned int kNumEntries = sizeof( kEntries ) / sizeof( kEntries[0] );
+
+  const Entry* findEntry( const string& name ){
+
+    for( unsigned int i = 0; i < kNumEntries; ++i )
+      if( name == kEntries[i].name ) return &( kEntries[i] );
+
+    return NULL;
+  }
+
+  set< string >& registered(){
+
+    static set< string > names;
+    return names;
+  }
+}
+
+bool
+AmplitudeRegistry::registerClass( const string& name, const Options& options ){
+
+  for( unsigned int i = 0; i < kNumEntries; ++i ){
+
+    if( name != kEntries[i].name ) continue;
+
+    if( registered().insert( name ).second )
+      kEntries[i].registerAs( options, kEntries[i].threadSafe );
+
+    return true;
+  }
+
+  return false;
+}
+
+int
+AmplitudeRegistry::registerUsed( const ConfigurationInfo* cfgInfo, const Options& options ){
+
+  unsigned int before = registered().size();
+
+  vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList();
+  for( unsigned int a = 0; a < amps.size(); ++a ){
+
+    vector< vector< string > > factors = amps[a]->factors();
+    for( unsigned int f = 0; f < factors.size(); ++f ){
+
+      if( factors[f].empty() || registered().count( factors[f][0] ) ) continue;
+
+      if( !registerClass( factors[f][0], options ) ){
+
+        cout << "AmplitudeRegistry WARNING:  " << factors[f][0]
+             << " is not in the registry and has to be registered by the program" << endl;
+      }
+    }
+  }
+
+  loadShared( cfgInfo );
+
+  return registered().size() - before;
+}
+
+void
+AmplitudeRegistry::loadShared( const ConfigurationInfo* cfgInfo ){
+
+  // the class and the arguments of every distinct factor with shared tables
+  set< vector< string > > distinct;
+
+  vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList();
+  for( unsigned int a = 0; a < amps.size(); ++a ){
+
+    vector< vector< string > > factors = amps[a]->factors();
+    for( unsigned int f = 0; f < factors.size(); ++f ){
+
+      if( factors[f].empty() ) continue;
+
+      const Entry* entry = findEntry( factors[f][0] );
+      if( entry != NULL && entry->loadShared != NULL ) distinct.insert( factors[f] );
+    }
+  }
+
+  vector< vector< string > > factors( distinct.begin(), distinct.end() );
+  if( factors.empty() ) return;
+
+  // the tables are read from ROOT files on several threads
+  if( factors.size() > 1 ) ROOT::EnableThreadSafety();
+
+  atomic< unsigned int > next( 0 );
+  auto load = [&](){
+
+    unsigned int i;
+    while( ( i = next++ ) < factors.size() ){
+
+      vector< string > args( factors[i].begin() + 1, factors[i].end() );
+      findEntry( factors[i][0] )->loadShared( args );
+    }
+  };
+
+  unsigned int nThreads = min< unsigned int >( factors.size(),
+                                               max( thread::hardware_concurrency(), 1u ) );
+
+  vector< thread > threads;
+  for( unsigned int t = 1; t < nThreads; ++t ) threads.push_back( thread( load ) );
+  load();
+  for( unsigned int t = 0; t < threads.size(); ++t ) threads[t].join();
+}
+
+void
+AmplitudeRegistry::registerAll( const Options& options ){
+
+  for( unsigned int i = 0; i < kNumEntries; ++i ) registerClass( kEntries[i].name, options );
+}
+
+vector< string >
+AmplitudeRegistry::names(){
+
+  vector< string > result;
+  for( unsigned int i = 0; i < kNumEntries; ++i ) result.push_back( kEntries[i].name );
+  return result;
+}
@@ -0,0 +1,76 @@
+#if !defined(AMPLITUDEREGISTRY)
+#define AMPLITUDEREGISTRY
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Amplitude;
+class ConfigurationInfo;
+
+// The amplitude classes of this library by name, registered with
+// AmpToolsInterface on demand.  A program registers the classes that its
+// configuration uses,
+//
+//   AmplitudeRegistry::registerUsed( cfgInfo );
+//
+// before the AmpToolsInterface is built, so that only their prototypes are
+// made and every program knows the same classes.  New amplitudes are added
+// to the table in AmplitudeRegistry.cc.
+//
+// The options wrap the classes as the fit programs ask:  as
+// ThreadedAmplitude if AmplitudeThreads has more than one thread (except
+// the classes that ask for the current permutation), as ProfiledAmplitude
+// with profile, as CachedUserVars (see UserVarsCache.h) with cacheUserVars,
+// and onRegister is called with the prototype of every class that is
+// registered, e.g., for MemoryReport::registerAmplitude.
+
+class AmplitudeRegistry
+{
+
+public:
+
+  struct Options {
+
+    Options() : profile( false ), cacheUserVars( false ) {}
+
+    bool profile;
+    bool cacheUserVars;
+    function< void( const Amplitude& ) > onRegister;
+  };
+
+  /**
+   * Registers every class of the amplitudes of cfgInfo and returns the
+   * number of classes registered by this call; classes that are not in
+   * the table are reported and left to the program.  The shared tables of
+   * the amplitudes are loaded as well (see loadShared).
+   */
+  static int registerUsed( const ConfigurationInfo* cfgInfo,
+                           const Options& options = Options() );
+
+  /**
+   * Registers a class by name and returns false if it is not in the
+   * table.  A class is only registered once per program.
+   */
+  static bool registerClass( const string& name, const Options& options = Options() );
+
+  static void registerAll( const Options& options = Options() );
+
+  /**
+   * Loads the shared tables of the amplitudes of cfgInfo (polarization
+   * tables, histograms of Hist2D, the grids of Pi0SAID and Pi0Regge) on
+   * several threads, one distinct class and argument list at a time.  The
+   * AmpToolsInterface built next constructs its amplitudes one after the
+   * other and finds the tables loaded, so the files are read and the
+   * model tables computed concurrently instead of in the order of the
+   * configuration.  Classes without shared tables are not touched.
+   */
+  static void loadShared( const ConfigurationInfo* cfgInfo );
+
+  // the names of the classes in the table
+  static vector< string > names();
+};
+
+#endif
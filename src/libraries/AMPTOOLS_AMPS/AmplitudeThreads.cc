@@ -0,0 +1,261 @@
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <stdint.h>
+
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+
+namespace {
+
+  // fewer events than this per thread are not worth the wake-up
+  const int kMinEventsPerThread = 256;
+
+  thread_local bool insideWork = false;
+
+  const size_t kHugePage = 2 << 20;
+
+  struct Pool {
+
+    vector< thread > threads;
+
+    // one call at a time
+    mutex runLock;
+
+    mutex lock;
+    condition_variable start;
+    condition_variable done;
+
+    // the work of the current call; generation counts the calls
+    const function< void( int, int ) >* work;
+    int n;
+
+    // with chunk > 0 the threads take chunks from next, otherwise a
+    // fixed share each
+    int chunk;
+    atomic< int > next;
+    unsigned long generation;
+    unsigned int pending;
+    bool stop;
+
+    bool pinned;
+    bool hugePages;
+
+    // the blocks that have been advised, with their own lock since they
+    // are advised from inside the work
+    mutex adviseLock;
+    set< const void* > advised;
+
+    Pool() : work( NULL ), n( 0 ), chunk( 0 ), next( 0 ), generation( 0 ), pending( 0 ), stop( false ),
+             pinned( false ), hugePages( false ) {}
+
+    ~Pool() { resize( 1 ); }
+
+    unsigned int size() const { return threads.size() + 1; }
+
+    // thread i of size() does its share of [0, n)
+    void share( unsigned int i ){
+
+      insideWork = true;
+
+      if( chunk > 0 ){
+
+        int begin;
+        while( ( begin = next.fetch_add( chunk ) ) < n )
+          (*work)( begin, min( begin + chunk, n ) );
+      }
+      else{
+
+        int begin = (long long)n * i / size();
+        int end = (long long)n * ( i + 1 ) / size();
+        if( begin != end ) (*work)( begin, end );
+      }
+
+      insideWork = false;
+    }
+
+    void dispatch( int nWork, int chunkSize, const function< void( int, int ) >& w ){
+
+      lock_guard< mutex > runGuard( runLock );
+
+      {
+        lock_guard< mutex > guard( lock );
+        work = &w;
+        n = nWork;
+        chunk = chunkSize;
+        next = 0;
+        pending = threads.size();
+        ++generation;
+      }
+      start.notify_all();
+
+      share( 0 );
+
+      unique_lock< mutex > guard( lock );
+      done.wait( guard, [&](){ return pending == 0; } );
+      work = NULL;
+    }
+
+    // seen is the generation of the last call before the thread started
+    void loop( unsigned int i, unsigned long seen ){
+
+      while( true ){
+
+        {
+          unique_lock< mutex > guard( lock );
+          start.wait( guard, [&](){ return stop || generation != seen; } );
+          if( stop ) return;
+          seen = generation;
+        }
+
+        share( i );
+
+        lock_guard< mutex > guard( lock );
+        if( --pending == 0 ) done.notify_one();
+      }
+    }
+
+    void resize( unsigned int nThreads ){
+
+      {
+        lock_guard< mutex > guard( lock );
+        stop = true;
+      }
+      start.notify_all();
+      for( unsigned int i = 0; i < threads.size(); ++i ) threads[i].join();
+      threads.clear();
+      stop = false;
+
+      // the calling thread is number 0
+      for( unsigned int i = 1; i < nThreads; ++i )
+        threads.push_back( thread( &Pool::loop, this, i, generation ) );
+
+      if( pinned ) pin();
+    }
+
+    // thread i to the i-th CPU of those the process may run on, e.g.,
+    // those an MPI launcher bound the rank to
+    void pin(){
+
+      cpu_set_t allowed;
+      if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) return;
+
+      vector< int > cpus;
+      for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+        if( CPU_ISSET( cpu, &allowed ) ) cpus.push_back( cpu );
+      if( cpus.empty() ) return;
+
+      for( unsigned int i = 0; i < size(); ++i ){
+
+        cpu_set_t one;
+        CPU_ZERO( &one );
+        CPU_SET( cpus[i % cpus.size()], &one );
+
+        pthread_t handle = ( i == 0 ? pthread_self() : threads[i - 1].native_handle() );
+        pthread_setaffinity_np( handle, sizeof( one ), &one );
+      }
+    }
+  };
+
+  Pool& pool(){
+
+    static Pool thePool;
+    return thePool;
+  }
+}
+
+void
+AmplitudeThreads::setNumThreads( unsigned int nThreads ){
+
+  Pool& p = pool();
+  lock_guard< mutex > guard( p.runLock );
+  p.resize( max( nThreads, 1u ) );
+}
+
+unsigned int
+AmplitudeThreads::numThreads(){
+
+  return pool().size();
+}
+
+void
+AmplitudeThreads::setPinned( bool pinned ){
+
+  Pool& p = pool();
+  lock_guard< mutex > guard( p.runLock );
+  p.pinned = pinned;
+  if( pinned ) p.pin();
+}
+
+bool
+AmplitudeThreads::isPinned(){
+
+  return pool().pinned;
+}
+
+void
+AmplitudeThreads::setHugePages( bool hugePages ){
+
+  pool().hugePages = hugePages;
+}
+
+void
+AmplitudeThreads::adviseHugePages( const void* p, size_t bytes ){
+
+  Pool& thePool = pool();
+  if( !thePool.hugePages || p == NULL ) return;
+
+  {
+    lock_guard< mutex > guard( thePool.adviseLock );
+    if( !thePool.advised.insert( p ).second ) return;
+  }
+
+#ifdef MADV_HUGEPAGE
+  // only whole huge pages inside the block
+  uintptr_t begin = ( (uintptr_t)p + kHugePage - 1 ) & ~( (uintptr_t)kHugePage - 1 );
+  uintptr_t end = ( (uintptr_t)p + bytes ) & ~( (uintptr_t)kHugePage - 1 );
+  if( end > begin ) madvise( (void*)begin, end - begin, MADV_HUGEPAGE );
+#endif
+}
+
+void
+AmplitudeThreads::run( int n, const function< void( int, int ) >& work ){
+
+  Pool& p = pool();
+
+  if( insideWork || p.size() == 1 || n < 2 * kMinEventsPerThread ){
+
+    if( n > 0 ) work( 0, n );
+    return;
+  }
+
+  p.dispatch( n, 0, work );
+}
+
+void
+AmplitudeThreads::runChunks( int n, int chunk, const function< void( int, int ) >& work ){
+
+  Pool& p = pool();
+
+  if( insideWork || p.size() == 1 || n <= chunk ){
+
+    if( n > 0 ) work( 0, n );
+    return;
+  }
+
+  if( p.pinned ){
+
+    run( n, work );
+    return;
+  }
+
+  p.dispatch( n, max( chunk, 1 ), work );
+}
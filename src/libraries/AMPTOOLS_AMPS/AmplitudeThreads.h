@@ -0,0 +1,59 @@
+#if !defined(AMPLITUDETHREADS)
+#define AMPLITUDETHREADS
+
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+// The threads that ThreadedAmplitude shares the events of a rank over.
+// The threads are started once and wait for work between the calls, so a
+// call costs a wake-up of the threads, not their creation.  With one
+// thread (the default) everything runs on the calling thread.
+//
+// On nodes with several sockets the arrays of user variables and
+// amplitudes, which the framework allocates without writing them, get
+// their pages on the socket of the thread that first writes them.  With
+// setPinned( true ) thread i of the pool stays on the i-th CPU the process
+// may use and every loop shares the events in the same fixed ranges, so
+// the thread that writes an event's values first is the one that reads
+// them on every later call, from its own socket.  setHugePages( true )
+// asks the kernel to back these arrays with 2 MB transparent huge pages
+// (see adviseHugePages); explicit huge pages would have to be allocated
+// by the framework.
+
+class AmplitudeThreads
+{
+
+public:
+
+  // the number of threads, the calling thread included
+  static void setNumThreads( unsigned int nThreads );
+  static unsigned int numThreads();
+
+  // pins the threads (the calling thread included) to CPUs and keeps the
+  // ranges of the events fixed; set after setNumThreads
+  static void setPinned( bool pinned );
+  static bool isPinned();
+
+  static void setHugePages( bool hugePages );
+
+  // Advises transparent huge pages for the 2 MB pages inside the block
+  // at p, once per block and only with setHugePages( true ).  Pages the
+  // framework has written before are collapsed later by the kernel.
+  static void adviseHugePages( const void* p, size_t bytes );
+
+  // Calls work( begin, end ) for consecutive ranges that cover [0, n) on
+  // all threads and returns when all of them are done.  Calls from inside
+  // work, and short ranges, run on the calling thread alone.
+  static void run( int n, const function< void( int, int ) >& work );
+
+  // As run, but the threads take chunks of [0, n) of chunk entries in turn
+  // as they finish the last one, for work whose cost differs from entry to
+  // entry.  work is called once per chunk.  Every entry is done once, so
+  // results written per entry do not depend on the threads.  If the
+  // threads are pinned this is run, so that the ranges stay fixed.
+  static void runChunks( int n, int chunk, const function< void( int, int ) >& work );
+};
+
+#endif
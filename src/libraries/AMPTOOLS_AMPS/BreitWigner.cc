@@ -5,14 +5,15 @@
 #include <string>
 #include <complex>
 #include <cstdlib>
-
-#include "TLorentzVector.h"
+#include <vector>
 
 #include "barrierFactor.h"
 #include "breakupMomentum.h"
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
+#include "AMPTOOLS_AMPS/PermutationUserVars.h"
 
 BreitWigner::BreitWigner( const vector< string >& args ) :
 UserAmplitude< BreitWigner >( args )
@@ -23,7 +24,8 @@ UserAmplitude< BreitWigner >( args )
 	m_mass0 = AmpParameter( args[0] );
 	m_width0 = AmpParameter( args[1] );
 	m_orbitL = atoi( args[2].c_str() );
-	m_daughters = pair< string, string >( args[3], args[4] );
+	m_daughters = pair< ParticleCombination, ParticleCombination >
+    ( ParticleCombination( args[3] ), ParticleCombination( args[4] ) );
   
   // need to register any free parameters so the framework knows about them
   registerParameter( m_mass0 );
@@ -34,40 +36,19 @@ UserAmplitude< BreitWigner >( args )
 }
 
 complex< GDouble >
-BreitWigner::calcAmplitude( GDouble** pKin ) const
+BreitWigner::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector P1, P2, Ptot, Ptemp;
-  
-  for( unsigned int i = 0; i < m_daughters.first.size(); ++i ){
-    
-    string num; num += m_daughters.first[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );
-    P1 += Ptemp;
-    Ptot += Ptemp;
-  }
-  
-  for( unsigned int i = 0; i < m_daughters.second.size(); ++i ){
-    
-    string num; num += m_daughters.second[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );
-    P2 += Ptemp;
-    Ptot += Ptemp;
-  }
-  
-  GDouble mass  = Ptot.M();
-  GDouble mass1 = P1.M();
-  GDouble mass2 = P2.M();
+  GDouble mass  = userVars[kMass];
+  GDouble mass1 = userVars[kMass1];
+  GDouble mass2 = userVars[kMass2];
+  GDouble q     = userVars[kQ];
+  GDouble F     = userVars[kF];
+
+  // only the pieces below depend on the floating parameters
   
   // assert positive breakup momenta     
   GDouble q0 = fabs( breakupMomentum(m_mass0, mass1, mass2) );
-  GDouble q  = fabs( breakupMomentum(mass,    mass1, mass2) );
-  
   GDouble F0 = barrierFactor(q0, m_orbitL);
-  GDouble F  = barrierFactor(q,  m_orbitL);
   
   GDouble width = m_width0*(m_mass0/mass)*(q/q0)*((F*F)/(F0*F0));
   //GDouble width = m_width0;
@@ -82,10 +63,112 @@ BreitWigner::calcAmplitude( GDouble** pKin ) const
   return( F * bwtop / bwbottom );
 }
 
+void
+BreitWigner::calcUserVars( GDouble** pKin, GDouble* userVars ) const
+{
+  GDouble P1[4], P2[4];
+  m_daughters.first.sum( pKin, P1 );
+  m_daughters.second.sum( pKin, P2 );
+
+  GDouble Ptot[4] = { P1[0] + P2[0], P1[1] + P2[1], P1[2] + P2[2], P1[3] + P2[3] };
+
+  GDouble mass  = ParticleCombination::mass( Ptot );
+  GDouble mass1 = ParticleCombination::mass( P1 );
+  GDouble mass2 = ParticleCombination::mass( P2 );
+  
+  GDouble q  = fabs( breakupMomentum(mass,    mass1, mass2) );
+
+  userVars[kMass]  = mass;
+  userVars[kMass1] = mass1;
+  userVars[kMass2] = mass2;
+  userVars[kQ]     = q;
+  userVars[kF]     = barrierFactor(q,  m_orbitL);
+}
+
+bool
+BreitWigner::sameUserVars( const vector< int >& a, const vector< int >& b ) const
+{
+  unsigned int a1 = m_daughters.first.mask( a ), a2 = m_daughters.second.mask( a );
+  unsigned int b1 = m_daughters.first.mask( b ), b2 = m_daughters.second.mask( b );
+
+  // the swap of the daughters swaps mass1 and mass2, which enter the
+  // amplitude only through the symmetric breakup momentum
+  return ( a1 == b1 && a2 == b2 ) || ( a1 == b2 && a2 == b1 );
+}
+
+void
+BreitWigner::calcUserVarsAll( GDouble* pdData, GDouble* pdUserVars, int iNEvents,
+                              const vector< vector< int > >* pvPermutations ) const
+{
+  if( pdData == NULL ){
+
+    UserAmplitude< BreitWigner >::calcUserVarsAll( pdData, pdUserVars, iNEvents, pvPermutations );
+    return;
+  }
+
+  PermutationUserVars::calcUserVarsOfPermutations( *this, pdData, pdUserVars, iNEvents,
+                                                   pvPermutations );
+}
+
+void
+BreitWigner::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                 int nEvents, complex< GDouble >* amps ) const
+{
+  if( nEvents <= 0 ) return;
+
+  GDouble mass0 = m_mass0;
+  GDouble width0 = m_width0;
+
+  // q0 and F0 depend on the daughter masses of each event and on mass0
+  // but not on width0, so they are cached with mass0 and a step in the
+  // width only redoes the loop below; the real parts hold q0, the
+  // imaginary parts F0
+  bool filled;
+  complex< GDouble >* qF0 =
+    FactorCache::lookup( FactorCache::kBreitWignerBarrier, &m_orbitL, 1, userVars,
+                         nEvents, kNumUserVars, 1, mass0, filled );
+
+  if( !filled ){
+
+    // computed for the whole batch, with the spin resolved once
+    vector< double > q0( nEvents ), F0( nEvents );
+    breakupMomentum( nEvents, m_mass0, userVars + kMass1, userVars + kMass2,
+                     kNumUserVars, &(q0[0]) );
+    barrierFactor( nEvents, m_orbitL, &(q0[0]), 1, &(F0[0]) );
+
+    for( int i = 0; i < nEvents; ++i ) qF0[i] = complex< GDouble >( q0[i], F0[i] );
+  }
+
+  complex<GDouble> bwtop( sqrt( mass0 * width0 / 3.1416 ), 0.0 );
+
+  for( int i = 0; i < nEvents; ++i ){
+
+    const GDouble* uv = userVars + i * kNumUserVars;
+
+    GDouble mass = uv[kMass];
+    GDouble q    = uv[kQ];
+    GDouble F    = uv[kF];
+
+    GDouble q0 = real( qF0[i] );
+    GDouble F0 = imag( qF0[i] );
+
+    GDouble width = width0*(mass0/mass)*(q/q0)*((F*F)/(F0*F0));
+
+    complex<GDouble> bwbottom( ( mass0*mass0 - mass*mass ) ,
+                               -1.0 * ( mass0 * width ) );
+
+    amps[i] = F * bwtop / bwbottom;
+  }
+}
+
 void
 BreitWigner::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates
+  // all parameter-dependent pieces (q0, F0 and the denominator) also
+  // depend on the daughter masses of each event, so there is nothing to
+  // precompute here; the framework only recomputes this amplitude when
+  // one of its parameters changes, and the batch keeps q0 and F0 of the
+  // current mass0 in the factor cache
   
 }
 
@@ -93,14 +176,9 @@ BreitWigner::updatePar( const AmpParameter& par ){
 void
 BreitWigner::launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const {
   
-  // use integers to endcode the string of daughters -- one index in each
-  // decimal place
-  
-  int daught1 = atoi( m_daughters.first.c_str() );
-  int daught2 = atoi( m_daughters.second.c_str() );
-  
+  // the daughter masses are in the user variables
   GPUBreitWigner_exec( dimGrid,  dimBlock, GPU_AMP_ARGS, 
-                       m_mass0, m_width0, m_orbitL, daught1, daught2 );
+                       m_mass0, m_width0, m_orbitL );
 
 }
 #endif //GPU_ACCELERATION
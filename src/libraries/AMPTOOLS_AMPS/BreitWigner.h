@@ -5,6 +5,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 
 #include <utility>
 #include <string>
@@ -13,8 +14,7 @@
 
 #ifdef GPU_ACCELERATION
 void GPUBreitWigner_exec( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO,
-                          GDouble mass0, GDouble width0, int orbitL,
-                          int daught1, int daught2 );
+                          GDouble mass0, GDouble width0, int orbitL );
 
 #endif // GPU_ACCELERATION
 
@@ -35,7 +35,30 @@ public:
   
 	string name() const { return "BreitWigner"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the pieces that only depend on the kinematics are computed once
+  // per event and stored here; they depend on the daughters given as
+  // arguments, so they are not static
+  enum UserVars { kMass = 0, kMass1, kMass2, kQ, kF, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  // the user variables only depend on the pair of sets of daughters:  they
+  // are computed once for the permutations of identical particles that
+  // give the same pair (see PermutationUserVars.h)
+  bool sameUserVars( const vector< int >& a, const vector< int >& b ) const;
+
+  void calcUserVarsAll( GDouble* pdData, GDouble* pdUserVars, int iNEvents,
+                        const vector< vector< int > >* pvPermutations ) const;
+
+  // the amplitude can be computed from the user variables alone
+  bool needsUserVarsOnly() const { return true; }
+
+  // evaluates a block of events in one call (see AmplitudeBatch.h)
+  void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                           int nEvents, complex< GDouble >* amps ) const;
 	  
   void updatePar( const AmpParameter& par );
     
@@ -53,7 +76,7 @@ private:
   AmpParameter m_width0;
   int m_orbitL;
   
-  pair< string, string > m_daughters;  
+  pair< ParticleCombination, ParticleCombination > m_daughters;  
 };
 
 #endif
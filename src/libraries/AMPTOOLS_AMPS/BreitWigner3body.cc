@@ -6,8 +6,6 @@
 #include <complex>
 #include <cstdlib>
 
-#include "TLorentzVector.h"
-
 #include "barrierFactor.h"
 #include "breakupMomentum.h"
 
@@ -22,7 +20,7 @@ UserAmplitude< BreitWigner3body >( args )
 	
 	m_mass0 = AmpParameter( args[0] );
 	m_width0 = AmpParameter( args[1] );
-	m_daughters = args[2];
+	m_daughters = ParticleCombination( args[2] );
   
   // need to register any free parameters so the framework knows about them
   registerParameter( m_mass0 );
@@ -30,21 +28,16 @@ UserAmplitude< BreitWigner3body >( args )
   
 }
 
+void
+BreitWigner3body::calcUserVars( GDouble** pKin, GDouble* userVars ) const
+{
+  userVars[kMass] = m_daughters.mass( pKin );
+}
+
 complex< GDouble >
-BreitWigner3body::calcAmplitude( GDouble** pKin ) const
+BreitWigner3body::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector Ptot, Ptemp;
-  
-  for( unsigned int i = 0; i < m_daughters.size(); ++i ){
-    
-    string num; num += m_daughters[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );
-    Ptot += Ptemp;
-  }
-  
-  GDouble mass  = Ptot.M();
+  GDouble mass  = userVars[kMass];
   
   GDouble width = m_width0;
   //GDouble width = m_width0;
@@ -62,7 +55,7 @@ BreitWigner3body::calcAmplitude( GDouble** pKin ) const
 void
 BreitWigner3body::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates
+  // the width is constant, so there is nothing to precompute here
   
 }
 
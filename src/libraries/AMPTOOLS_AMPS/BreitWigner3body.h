@@ -5,6 +5,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 
 #include <utility>
 #include <string>
@@ -35,7 +36,16 @@ public:
   
 	string name() const { return "BreitWigner3body"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the mass of the daughter system is computed once per event; it
+  // depends on the daughters given as argument, so it is not static
+  enum UserVars { kMass = 0, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
 	  
   void updatePar( const AmpParameter& par );
     
@@ -50,7 +60,7 @@ private:
   AmpParameter m_mass0;
   AmpParameter m_width0;
   
-  string m_daughters;  
+  ParticleCombination m_daughters;  
 };
 
 #endif
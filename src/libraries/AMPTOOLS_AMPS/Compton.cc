@@ -11,9 +11,17 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Compton.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+
+void
+Compton::loadShared( const vector< string >& args ){
+
+	if( args.size() == 5 ) PolarizationTable::get( args[3], args[4] );
+}
 
 Compton::Compton( const vector< string >& args ) :
-UserAmplitude< Compton >( args )
+UserAmplitude< Compton >( args ),
+polAngle( 0. ), polFraction( 0. ), polFrac_vs_E( NULL )
 {
 	assert( args.size() == 1 ||  args.size() == 3 || args.size() == 5 );
 
@@ -37,17 +45,15 @@ UserAmplitude< Compton >( args )
 		polInTree = false;
 		polAngle = atof( args[1].c_str() );	
 		polFraction = 0.;
-		TFile* f = new TFile( args[3].c_str() );
-        polFrac_vs_E = (TH1D*)f->Get( args[4].c_str() );
-        assert( polFrac_vs_E != NULL );
+		polFrac_vs_E = PolarizationTable::get( args[3], args[4] );
 	}
 	
 	// do some sanity checks?
 }
 
 
-complex< GDouble >
-Compton::calcAmplitude( GDouble** pKin ) const {
+void
+Compton::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
 	TLorentzVector target  ( 0., 0., 0., 0.938);
 
@@ -84,18 +90,15 @@ Compton::calcAmplitude( GDouble** pKin ) const {
 		if(polFraction > 0.) { // for fitting with constant polarization 
 			Pgamma = polFraction;
 		} else{
-			int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-			if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-				Pgamma = 0.;
-			} else 
-				Pgamma = polFrac_vs_E->GetBinContent(bin);
+			Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
 		}
 	}
 
 	// factors needed to calculate cross section from model
 	GDouble s = cm.M2();
 	GDouble t = (recoil - target).M2();
-	if(fabs(t) < 0.4) return 0.; // interested in high -t behavior, so temporarily exclude low -t 
+	userVars[kAmp] = 0.;
+	if(fabs(t) < 0.4) return; // interested in high -t behavior, so temporarily exclude low -t 
 
 	// model parameters from PAC42 proposal PR12-14-003
 	GDouble s_0 = 10.92;
@@ -106,6 +109,12 @@ Compton::calcAmplitude( GDouble** pKin ) const {
 	GDouble BeamSigma = 0.1;	
 	W *= (1 - Pgamma * BeamSigma * cos2Phi);
 
-	return complex< GDouble > ( sqrt( fabs(W) ) );
+	userVars[kAmp] = sqrt( fabs(W) );
+}
+
+complex< GDouble >
+Compton::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+	return complex< GDouble > ( userVars[kAmp] );
 }
 
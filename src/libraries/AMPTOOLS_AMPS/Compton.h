@@ -6,7 +6,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -21,19 +21,33 @@ class Compton : public UserAmplitude< Compton >
     
 public:
 	
-	Compton() : UserAmplitude< Compton >() { };
+	Compton() : UserAmplitude< Compton >(), polFrac_vs_E( NULL ) { };
 	Compton( const vector< string >& args );
 	
 	string name() const { return "Compton"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
-	
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the amplitude has no free parameters, so it is computed once and
+	// kept in the user variables
+	enum UserVars { kAmp = 0, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
+
 private:
 
 	GDouble polAngle;
 	GDouble polFraction;
     bool polInTree;
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E;
 };
 
 #endif
@@ -28,7 +28,16 @@ public:
   
 	string name() const { return "EtaPb_tdist"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the momentum transfer and the eta angle
+  enum UserVars { kT = 0, kThEta, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
+  bool areUserVarsStatic() const { return true; }
 	  
   void updatePar( const AmpParameter& par );
     
@@ -45,6 +54,10 @@ private:
   AmpParameter ThetaSigma;    // for the moment assume W cross section has 5 parameters
   AmpParameter Phase;
   AmpParameter Bgen;
+
+  // 1 / ( 2 ThetaSigma^2 ) and the phase factor
+  GDouble m_halfInvSigmaSq;
+  complex< GDouble > m_phase;
 };
 
 #endif
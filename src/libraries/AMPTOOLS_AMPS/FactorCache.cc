@@ -0,0 +1,165 @@
+
+#include <cassert>
+#include <cmath>
+#include <mutex>
+#include <algorithm>
+
+#include "AMPTOOLS_AMPS/FactorCache.h"
+
+bool
+FactorCache::Key::operator<( const Key& other ) const {
+
+  if( factorId != other.factorId ) return factorId < other.factorId;
+  if( userVars != other.userVars ) return userVars < other.userVars;
+  if( nEvents != other.nEvents ) return nEvents < other.nEvents;
+
+  return lexicographical_compare( quantumNumbers, quantumNumbers + kMaxQuantumNumbers,
+                                  other.quantumNumbers,
+                                  other.quantumNumbers + kMaxQuantumNumbers );
+}
+
+map< FactorCache::Key, FactorCache::Entry >&
+FactorCache::entries(){
+
+  static thread_local map< Key, Entry > cache;
+  return cache;
+}
+
+complex< GDouble >*
+FactorCache::lookup( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                     const GDouble* userVars, int nEvents, int stride,
+                     int width, bool& filled ){
+
+  return lookup( factorId, quantumNumbers, nQuantumNumbers, userVars, nEvents,
+                 stride, width, 0, filled );
+}
+
+complex< GDouble >*
+FactorCache::lookup( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                     const GDouble* userVars, int nEvents, int stride,
+                     int width, GDouble parameter, bool& filled ){
+
+  Entry& found = entry( factorId, quantumNumbers, nQuantumNumbers, userVars, nEvents,
+                        stride, nEvents * width, false, parameter, filled );
+
+  return &(found.values[0]);
+}
+
+complex< float >*
+FactorCache::lookupCompact( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                            const GDouble* userVars, int nEvents, int stride,
+                            int width, bool& filled ){
+
+  Entry& found = entry( factorId, quantumNumbers, nQuantumNumbers, userVars, nEvents,
+                        stride, nEvents * width, true, 0, filled );
+
+  return &(found.compactValues[0]);
+}
+
+FactorCache::Entry&
+FactorCache::entry( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                    const GDouble* userVars, int nEvents, int stride,
+                    size_t size, bool compact, GDouble parameter, bool& filled ){
+
+  assert( nQuantumNumbers <= kMaxQuantumNumbers );
+  assert( nEvents > 0 );
+
+  Key key;
+  key.factorId = factorId;
+  key.userVars = userVars;
+  key.nEvents = nEvents;
+  for( int i = 0; i < kMaxQuantumNumbers; ++i ){
+
+    key.quantumNumbers[i] = ( i < nQuantumNumbers ? quantumNumbers[i] : 0 );
+  }
+
+  const GDouble* first = userVars;
+  const GDouble* last = userVars + ( nEvents - 1 ) * stride;
+
+  Entry& entry = entries()[key];
+
+  size_t held = ( compact ? entry.compactValues.size() : entry.values.size() );
+  filled = ( held == size &&
+             entry.parameter == parameter &&
+             equal( first, first + stride, entry.firstEvent.begin() ) &&
+             equal( last, last + stride, entry.lastEvent.begin() ) );
+
+  if( !filled ){
+
+    entry.parameter = parameter;
+    entry.firstEvent.assign( first, first + stride );
+    entry.lastEvent.assign( last, last + stride );
+
+    // an entry is held in one of the two forms
+    if( compact ){
+
+      entry.compactValues.resize( size );
+      vector< complex< GDouble > >().swap( entry.values );
+    }
+    else{
+
+      entry.values.resize( size );
+      vector< complex< float > >().swap( entry.compactValues );
+    }
+  }
+
+  return entry;
+}
+
+bool FactorCache::m_compact = false;
+bool FactorCache::m_validate = false;
+
+namespace {
+
+  mutex validationLock;
+  double largestError = 0;
+  long long validated = 0;
+}
+
+void
+FactorCache::setCompact( bool compact, bool validate ){
+
+  m_compact = compact;
+  m_validate = compact && validate;
+}
+
+void
+FactorCache::store( const complex< GDouble >* values, int n, complex< float >* stored ){
+
+  for( int i = 0; i < n; ++i ) stored[i] = complex< float >( values[i] );
+
+  if( !m_validate ) return;
+
+  // relative to the magnitude, so a part that is zero is not counted
+  double largest = 0;
+  for( int i = 0; i < n; ++i ){
+
+    double magnitude = abs( values[i] );
+    if( magnitude == 0 ) continue;
+    largest = max( largest, abs( values[i] - complex< GDouble >( stored[i] ) ) / magnitude );
+  }
+
+  lock_guard< mutex > lock( validationLock );
+  largestError = max( largestError, largest );
+  validated += n;
+}
+
+double
+FactorCache::maxRoundingError(){
+
+  lock_guard< mutex > lock( validationLock );
+  return largestError;
+}
+
+long long
+FactorCache::numValidated(){
+
+  lock_guard< mutex > lock( validationLock );
+  return validated;
+}
+
+void
+FactorCache::clear(){
+
+  entries().clear();
+}
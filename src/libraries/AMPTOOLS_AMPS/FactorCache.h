@@ -0,0 +1,126 @@
+#if !defined(FACTORCACHE)
+#define FACTORCACHE
+
+#include <complex>
+#include <map>
+#include <vector>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+using std::complex;
+using namespace std;
+
+// A cache for factors of an amplitude that several amplitude instances have
+// in common, e.g., the production D-function of Vec_ps_refl, which is the
+// same for all reflectivities and partial waves of a given (j, m).  Such
+// factors only depend on static user data and a few quantum numbers, so the
+// first instance that evaluates a block of events stores them here and the
+// instances that follow read them back.
+//
+// Entries are identified by a factor id, up to kMaxQuantumNumbers quantum
+// numbers and the block of user data they were computed from.  Because
+// static user data are shared between instances, the address of the block
+// identifies the events; a copy of the first and last event's user data is
+// kept to detect a block that has been reused for other events.  The cache
+// is per thread and lives as long as the thread.
+//
+// Factors that also depend on an amplitude parameter are looked up with the
+// value of that parameter; an entry computed for another value is refilled
+// in place, so a floating parameter does not grow the cache.  An amplitude
+// can also keep its own factors here that depend on only some of its
+// parameters, so that a step in the others does not recompute them.
+//
+// For fits that are limited by memory, the factors that do not depend on
+// a parameter (the fixed shapes:  the harmonics of Zlm, the helicity sums
+// of Vec_ps_refl) can be kept as complex< float > (setCompact), which
+// halves their size.  An amplitude that supports this asks for compact
+// storage with lookupCompact, fills it with store from values computed in
+// GDouble and computes its amplitude in GDouble from the stored values, so
+// only the storage is rounded.  In the validation mode store also keeps
+// the largest relative error of a stored value against the value it was
+// rounded from, which a program can print after the fit.
+
+class FactorCache
+{
+
+public:
+
+  enum { kMaxQuantumNumbers = 4 };
+
+  // the factors that amplitudes in this library share
+  enum FactorId { kVecPsProductionD = 0, kDblReggeVertices,
+                  kVecPsHelicitySum, kBreitWignerBarrier, kZlmHarmonic,
+                  kYlmHarmonic };
+
+  /**
+   * Return storage for width values per event for the nEvents events of
+   * the user data block userVars (stride values per event).  On return
+   * filled is true if another instance already stored the values;
+   * otherwise the caller is responsible for filling them.
+   */
+  static complex< GDouble >* lookup( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                                     const GDouble* userVars, int nEvents, int stride,
+                                     int width, bool& filled );
+
+  // as above for factors that also depend on the value of a parameter
+  static complex< GDouble >* lookup( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                                     const GDouble* userVars, int nEvents, int stride,
+                                     int width, GDouble parameter, bool& filled );
+
+  // drops all entries of the calling thread
+  static void clear();
+
+  // keep factors without a parameter as complex< float >; validate keeps
+  // the largest rounding error (default off)
+  static void setCompact( bool compact, bool validate = false );
+  static bool compact() { return m_compact; }
+
+  /**
+   * As lookup for the factors without a parameter, in compact storage.
+   * Unless filled is true, the caller fills it with store.
+   */
+  static complex< float >* lookupCompact( int factorId, const int* quantumNumbers,
+                                          int nQuantumNumbers, const GDouble* userVars,
+                                          int nEvents, int stride, int width, bool& filled );
+
+  // stores n values in compact storage
+  static void store( const complex< GDouble >* values, int n, complex< float >* stored );
+
+  // the largest relative error of round in the validation mode, over all
+  // threads, and the number of values it was taken over
+  static double maxRoundingError();
+  static long long numValidated();
+
+private:
+
+  struct Key {
+
+    int factorId;
+    int quantumNumbers[kMaxQuantumNumbers];
+    const GDouble* userVars;
+    int nEvents;
+
+    bool operator<( const Key& other ) const;
+  };
+
+  struct Entry {
+
+    GDouble parameter;
+    vector< GDouble > firstEvent;
+    vector< GDouble > lastEvent;
+    vector< complex< GDouble > > values;
+    vector< complex< float > > compactValues;
+  };
+
+  static map< Key, Entry >& entries();
+
+  // the entry of the key, which is refilled if it holds other events
+  static Entry& entry( int factorId, const int* quantumNumbers, int nQuantumNumbers,
+                       const GDouble* userVars, int nEvents, int stride,
+                       size_t size, bool compact, GDouble parameter, bool& filled );
+
+  static bool m_compact;
+  static bool m_validate;
+};
+
+#endif
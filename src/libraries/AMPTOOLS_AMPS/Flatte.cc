@@ -31,12 +31,20 @@ Flatte::Flatte( const vector< string >& args ) :
    m_g2=AmpParameter(args[2]); 
    m_daughter1 = atoi(args[3].c_str());
    m_daughter2 = atoi(args[4].c_str());
+   m_daughters = ParticleCombination( args[3] + args[4] );
    m_mass11 = atof(args[5].c_str());
    m_mass12 = atof(args[6].c_str());
    m_mass21 = atof(args[7].c_str());
    m_mass22 = atof(args[8].c_str());
    m_chan = atoi(args[9].c_str());
 
+   if( m_chan != 1 && m_chan != 2 ){
+
+      cout << "Flatte ERROR:  possible channel indices for Flatte amplitude are 1 or 2!" << endl;
+      assert( false );
+   }
+
+   m_lowChan = ( (m_mass11+m_mass12) < (m_mass21+m_mass22) ? 1 : 2 );
 
    // need to register any free parameters so the framework knows about them
    registerParameter(m_mass);
@@ -47,33 +55,37 @@ Flatte::Flatte( const vector< string >& args ) :
 
 
 complex< GDouble > Flatte::calcAmplitude( GDouble** pKin, GDouble* userData ) const {
-   TLorentzVector P1, P2;
 
-   P1.SetPxPyPzE( pKin[m_daughter1][1], pKin[m_daughter1][2], pKin[m_daughter1][3], pKin[m_daughter1][0] );
-   P2.SetPxPyPzE( pKin[m_daughter2][1], pKin[m_daughter2][2], pKin[m_daughter2][3], pKin[m_daughter2][0] );
-
-   double curMass = (P1+P2).M();
+   double curMass = userData[kMass];
    complex<double> imag(0.,1.);
 
-   complex<double> gamma11 = (double)m_g1 * Flatte::breakupMom( curMass, m_mass11, m_mass12 );
-   complex<double> gamma22 = (double)m_g2 * Flatte::breakupMom( curMass, m_mass21, m_mass22 );
-
-   complex<double> gammaLow;
-   if( (m_mass11+m_mass12) < (m_mass21+m_mass22) ) gammaLow = gamma11;
-   else gammaLow = gamma22;
+   complex<double> gamma11 = (double)m_g1 * complex<double>( userData[kReQ1], userData[kImQ1] );
+   complex<double> gamma22 = (double)m_g2 * complex<double>( userData[kReQ2], userData[kImQ2] );
 
-   complex<double> gamma_j;
-   if(m_chan==1) gamma_j = gamma11;
-   else if(m_chan==2) gamma_j = gamma22;
-   else cout << "ERROR: possible channel indices for Flatte amplitude are 1 or 2!" << endl;
+   complex<double> gammaLow = ( m_lowChan == 1 ? gamma11 : gamma22 );
+   complex<double> gamma_j = ( m_chan == 1 ? gamma11 : gamma22 );
 
    complex<double>  result = (double)m_mass * sqrt( gammaLow*gamma_j ) / ( (double)m_mass*(double)m_mass - curMass*curMass - imag * (double)m_mass * (gamma11+gamma22) );
    return result;
 }
 
 
-//void Flatte::calcUserData( GDouble** pKin, GDouble* userData ) const {
-//}
+void Flatte::calcUserVars( GDouble** pKin, GDouble* userData ) const {
+
+   GDouble P[4];
+   m_daughters.sum( pKin, P );
+
+   double curMass = ParticleCombination::mass( P );
+
+   complex<double> q1 = Flatte::breakupMom( curMass, m_mass11, m_mass12 );
+   complex<double> q2 = Flatte::breakupMom( curMass, m_mass21, m_mass22 );
+
+   userData[kMass] = curMass;
+   userData[kReQ1] = real( q1 );
+   userData[kImQ1] = imag( q1 );
+   userData[kReQ2] = real( q2 );
+   userData[kImQ2] = imag( q2 );
+}
 
 
 complex<double> Flatte::phaseSpaceFac(double m, double mDec1, double mDec2) const{
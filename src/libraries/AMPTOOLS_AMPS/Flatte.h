@@ -4,6 +4,7 @@
 #include "IUAmpTools/Amplitude.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 //#include "GPUManager/GPUCustomTypes.h"
 
 #include <utility>
@@ -39,6 +40,18 @@ class Flatte : public UserAmplitude< Flatte >{
 
       complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userData ) const;
 
+      // the mass and the breakup momenta of both channels, which are
+      // imaginary below threshold, only depend on the kinematics; they
+      // depend on the daughters and masses given as arguments, so they
+      // are not static
+      enum UserVars { kMass = 0, kReQ1, kImQ1, kReQ2, kImQ2, kNumUserVars };
+      unsigned int numUserVars() const { return kNumUserVars; }
+
+      void calcUserVars( GDouble** pKin, GDouble* userData ) const;
+
+      // the amplitude is a rational function of the couplings
+      bool needsUserVarsOnly() const { return true; }
+
 //#ifdef GPU_ACCELERATION
 //
 //      void launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const;
@@ -54,11 +67,13 @@ class Flatte : public UserAmplitude< Flatte >{
       AmpParameter m_g2;	
       int m_daughter1;
       int m_daughter2;  
+      ParticleCombination m_daughters;
       double m_mass11;
       double m_mass12;
       double m_mass21;
       double m_mass22;
       int m_chan;
+      int m_lowChan;    // the channel with the lower threshold
 
       complex<double> phaseSpaceFac( double m, double mDec1, double mDec2 ) const;
       template<typename mType>
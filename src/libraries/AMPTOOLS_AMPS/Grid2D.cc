@@ -0,0 +1,138 @@
+
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TH2.h"
+
+#include "AMPTOOLS_AMPS/Grid2D.h"
+#include "AMPTOOLS_AMPS/SharedResources.h"
+
+Grid2D::Grid2D() :
+  m_uniform( true ),
+  m_values( 1, 0 )
+{
+  m_view.nx = m_view.ny = 1;
+  m_view.xLow = m_view.xHigh = m_view.yLow = m_view.yHigh = 0;
+  m_view.invWidthX = m_view.invWidthY = 0;
+  m_view.interpolate = false;
+  m_view.values = NULL;
+}
+
+Grid2D::Grid2D( int nx, GDouble xLow, GDouble xHigh,
+                int ny, GDouble yLow, GDouble yHigh,
+                const GDouble* values, bool interpolate ) :
+  m_uniform( true ),
+  m_values( values, values + nx * ny )
+{
+  assert( nx > 0 && ny > 0 && xHigh > xLow && yHigh > yLow );
+
+  m_view.nx = nx;
+  m_view.ny = ny;
+  m_view.xLow = xLow;
+  m_view.xHigh = xHigh;
+  m_view.yLow = yLow;
+  m_view.yHigh = yHigh;
+  m_view.invWidthX = nx / ( xHigh - xLow );
+  m_view.invWidthY = ny / ( yHigh - yLow );
+  m_view.interpolate = interpolate;
+  m_view.values = NULL;
+}
+
+Grid2D::Grid2D( const TH2* hist, bool interpolate ) :
+  m_uniform( true )
+{
+  const TAxis* xAxis = hist->GetXaxis();
+  const TAxis* yAxis = hist->GetYaxis();
+
+  int nx = xAxis->GetNbins();
+  int ny = yAxis->GetNbins();
+
+  m_values.resize( nx * ny );
+  for( int ix = 0; ix < nx; ++ix ){
+    for( int iy = 0; iy < ny; ++iy ){
+
+      m_values[ix*ny+iy] = hist->GetBinContent( ix + 1, iy + 1 );
+    }
+  }
+
+  m_view.nx = nx;
+  m_view.ny = ny;
+  m_view.xLow = xAxis->GetBinLowEdge( 1 );
+  m_view.xHigh = xAxis->GetBinUpEdge( nx );
+  m_view.yLow = yAxis->GetBinLowEdge( 1 );
+  m_view.yHigh = yAxis->GetBinUpEdge( ny );
+  m_view.invWidthX = nx / ( m_view.xHigh - m_view.xLow );
+  m_view.invWidthY = ny / ( m_view.yHigh - m_view.yLow );
+  m_view.interpolate = interpolate;
+  m_view.values = NULL;
+
+  if( xAxis->IsVariableBinSize() || yAxis->IsVariableBinSize() ){
+
+    m_uniform = false;
+
+    if( interpolate ){
+
+      cout << "Grid2D WARNING:  interpolation is not supported for variable"
+           << " bins in " << hist->GetName() << "; using bin contents" << endl;
+      m_view.interpolate = false;
+    }
+
+    m_edgesX.resize( nx + 1 );
+    for( int ix = 0; ix < nx; ++ix ) m_edgesX[ix] = xAxis->GetBinLowEdge( ix + 1 );
+    m_edgesX[nx] = m_view.xHigh;
+
+    m_edgesY.resize( ny + 1 );
+    for( int iy = 0; iy < ny; ++iy ) m_edgesY[iy] = yAxis->GetBinLowEdge( iy + 1 );
+    m_edgesY[ny] = m_view.yHigh;
+  }
+}
+
+const Grid2D*
+Grid2D::get( const string& fileName, const string& histName, bool interpolate ){
+
+  static SharedResources< Grid2D > grids;
+
+  string key = fileName + ":" + histName + ( interpolate ? ":interpolate" : "" );
+
+  return grids.get( key, [&](){
+
+    TFile* f = TFile::Open( fileName.c_str() );
+
+    if( f == NULL || f->IsZombie() ){
+
+      cout << "Grid2D ERROR:  unable to open " << fileName << endl;
+      assert( false );
+    }
+
+    TH2* hist = (TH2*)f->Get( histName.c_str() );
+
+    if( hist == NULL ){
+
+      cout << "Grid2D ERROR:  no histogram " << histName
+           << " in " << fileName << endl;
+      assert( false );
+    }
+
+    // only the bin contents are needed once the file is closed
+    const Grid2D* newGrid = new Grid2D( hist, interpolate );
+
+    f->Close();
+    delete f;
+
+    return newGrid;
+  } );
+}
+
+GDouble
+Grid2D::variableValue( GDouble x, GDouble y ) const
+{
+  if( !( x >= m_view.xLow && x < m_view.xHigh &&
+         y >= m_view.yLow && y < m_view.yHigh ) ) return 0;
+
+  int ix = upper_bound( m_edgesX.begin(), m_edgesX.end(), x ) - m_edgesX.begin() - 1;
+  int iy = upper_bound( m_edgesY.begin(), m_edgesY.end(), y ) - m_edgesY.begin() - 1;
+
+  return m_values[ix*m_view.ny+iy];
+}
@@ -0,0 +1,129 @@
+#if !defined(GRID2D)
+#define GRID2D
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+class TH2;
+
+using namespace std;
+
+// A tabulated function of two variables on a rectangular grid, stored as a
+// flat row-major array (all y bins of the first x bin, then the next x bin,
+// ...).  A lookup is a couple of multiplies instead of TH2::FindBin and
+// GetBinContent.  Values outside of the grid are zero.  With interpolation
+// enabled the values are interpolated bilinearly between bin centers.
+//
+// The plain view below carries everything a lookup on a uniform grid needs.
+
+struct Grid2DView {
+
+  int nx, ny;
+  GDouble xLow, xHigh, yLow, yHigh;
+  GDouble invWidthX, invWidthY;
+  bool interpolate;
+  const GDouble* values;
+};
+
+inline GDouble
+grid2DValue( const Grid2DView& g, GDouble x, GDouble y ){
+
+  if( !( x >= g.xLow && x < g.xHigh && y >= g.yLow && y < g.yHigh ) ) return 0;
+
+  if( !g.interpolate ){
+
+    int ix = (int)( ( x - g.xLow ) * g.invWidthX );
+    int iy = (int)( ( y - g.yLow ) * g.invWidthY );
+    if( ix >= g.nx ) ix = g.nx - 1;
+    if( iy >= g.ny ) iy = g.ny - 1;
+
+    return g.values[ix*g.ny+iy];
+  }
+
+  // position in units of bins measured from the first bin center
+  GDouble u = ( x - g.xLow ) * g.invWidthX - 0.5;
+  GDouble v = ( y - g.yLow ) * g.invWidthY - 0.5;
+
+  int ix = (int)u; if( u < 0 ) ix = 0;
+  int iy = (int)v; if( v < 0 ) iy = 0;
+  if( ix > g.nx - 2 ) ix = ( g.nx > 1 ? g.nx - 2 : 0 );
+  if( iy > g.ny - 2 ) iy = ( g.ny > 1 ? g.ny - 2 : 0 );
+
+  int ix2 = ( g.nx > 1 ? ix + 1 : ix );
+  int iy2 = ( g.ny > 1 ? iy + 1 : iy );
+
+  // clamp to the outer bin centers
+  GDouble fx = u - ix; if( fx < 0 ) fx = 0; if( fx > 1 ) fx = 1;
+  GDouble fy = v - iy; if( fy < 0 ) fy = 0; if( fy > 1 ) fy = 1;
+
+  return ( 1 - fx ) * ( ( 1 - fy ) * g.values[ix*g.ny+iy] + fy * g.values[ix*g.ny+iy2] ) +
+    fx * ( ( 1 - fy ) * g.values[ix2*g.ny+iy] + fy * g.values[ix2*g.ny+iy2] );
+}
+
+class Grid2D
+{
+
+public:
+
+  Grid2D();
+
+  /**
+   * A uniform grid; values holds nx*ny values with value[ix*ny+iy] for
+   * the bin (ix, iy).
+   */
+  Grid2D( int nx, GDouble xLow, GDouble xHigh,
+          int ny, GDouble yLow, GDouble yHigh,
+          const GDouble* values, bool interpolate = false );
+
+  /**
+   * A copy of the bin contents of a histogram, which may have variable
+   * bins; interpolation is only supported for uniform bins.
+   */
+  explicit Grid2D( const TH2* hist, bool interpolate = false );
+
+  /**
+   * Return the shared grid of histogram histName in fileName, reading it
+   * on the first call.  Every amplitude that asks for the same histogram
+   * gets the same immutable grid, which lives until the end of the job,
+   * so the file is opened only once.
+   */
+  static const Grid2D* get( const string& fileName, const string& histName,
+                            bool interpolate = false );
+
+  GDouble value( GDouble x, GDouble y ) const {
+
+    if( m_uniform ) return grid2DValue( view(), x, y );
+    return variableValue( x, y );
+  }
+
+  bool isUniform() const { return m_uniform; }
+
+  int size() const { return m_values.size(); }
+  const GDouble* values() const { return &(m_values[0]); }
+
+  // the view of this grid
+  Grid2DView view() const {
+
+    Grid2DView g = m_view;
+    g.values = &(m_values[0]);
+    return g;
+  }
+
+private:
+
+  GDouble variableValue( GDouble x, GDouble y ) const;
+
+  bool m_uniform;
+  Grid2DView m_view;
+
+  vector< GDouble > m_values;
+
+  // bin edges, only used for variable bins
+  vector< GDouble > m_edgesX;
+  vector< GDouble > m_edgesY;
+};
+
+#endif
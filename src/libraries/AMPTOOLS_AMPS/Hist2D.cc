@@ -4,10 +4,17 @@
 #include <string>
 #include <sstream>
 #include <cstdlib>
+#include <cmath>
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Hist2D.h"
 
+void
+Hist2D::loadShared( const vector< string >& args ){
+
+	if( args.size() == 4 ) Grid2D::get( args[0], args[1] );
+}
+
 Hist2D::Hist2D( const vector< string >& args ) :
 UserAmplitude< Hist2D >( args )
 {
@@ -21,68 +28,50 @@ UserAmplitude< Hist2D >( args )
 	cout<<"Model provided in histogram named "<<histName.data()<<endl;
 	cout<<"Histogram type for generator "<<histType.data()<<endl;
 	cout<<"Summing particle indices "<<particleList.data()<<" for invariant mass"<<endl;
-	for(uint i=0; i<particleList.length(); i++) {
-		string num; num += particleList[i];
-		int index = atoi(num.c_str());
-		cout<<index<<endl;
+	m_particles = ParticleCombination( particleList );
+	for(int i=0; i<m_particles.size(); i++) {
+		cout<<m_particles[i]<<endl;
 	}
 
-	TFile *finput = TFile::Open(fileName.data());
-	if(!finput->IsOpen()) {
-		cout<<"Can't find file "<<fileName.data()<<endl;
-		exit(1);
+	if(histType == "MassVsEgamma") {
+		m_type = kMassVsEgamma;
 	}
-
-	hist2D = (TH2*)finput->Get(histName.data());
-	if(!hist2D) {
-		cout<<"Can't find histogram "<<histName.data()<<" in file "<<fileName.data()<<endl;
-		exit(1);
-	}		
-
-	if(histType != "MassVsEgamma" && histType != "MassVst") {
+	else if(histType == "MassVst") {
+		m_type = kMassVst;
+	}
+	else {
 		cout<<"Type of 2D histogram is not currently supported, please add necessary kinematics and options to Hist2D amplitude"<<endl;
 		exit(1);
 	}
 
-	// keep in memory after file is closed
-        hist2D->SetDirectory(gROOT);
-	finput->Close();
+	m_grid = Grid2D::get( fileName, histName );
 }
 
 
-complex< GDouble >
-Hist2D::calcAmplitude( GDouble** pKin ) const {
+void
+Hist2D::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
-	TLorentzVector target  ( 0., 0., 0., 0.938);
-	TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
-	TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
-	
 	// compute particle P4 sum for invariant mass
-	TLorentzVector sum;
-	for(uint i=0; i<particleList.length(); i++) {
-		string num; num += particleList[i];
-		int index = atoi(num.c_str());
-		TLorentzVector particleP4 ( pKin[index][1], pKin[index][2], pKin[index][3], pKin[index][0] ); 
-		sum += particleP4;
-	}
-	
-	double beamE = beam.E();
-	double t = fabs((sum - beam).M2()); 
+	GDouble sum[4];
+	m_particles.sum( pKin, sum );
 
-	double userVarX = 0;
-	double userVarY = sum.M();
-	if(histType == "MassVsEgamma") {
-		userVarX = beamE;
+	userVars[kY] = ParticleCombination::mass( sum );
+
+	if(m_type == kMassVsEgamma) {
+		userVars[kX] = pKin[0][0];
 	}
-	if(histType == "MassVst") {
-		userVarX = t;
+	else {
+		GDouble diff[4] = { sum[0] - pKin[0][0], sum[1] - pKin[0][1],
+		                    sum[2] - pKin[0][2], sum[3] - pKin[0][3] };
+		userVars[kX] = fabs( ParticleCombination::mass2( diff ) );
 	}
+}
 
-	// weighted model of intensity from histogram 
-	GDouble W = 0.; // initialized to zero
-
-	int bin = hist2D->FindBin(userVarX, userVarY); // generic bin index from 2D histogram (negative value if values outside defined range)
-	if(bin > 0) W = hist2D->GetBinContent(bin); 
+complex< GDouble >
+Hist2D::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+  
+	// weighted model of intensity from histogram, zero outside of its range
+	GDouble W = m_grid->value(userVars[kX], userVars[kY]);
 
 	return complex< GDouble > ( sqrt(W) );
 }
@@ -1,14 +1,12 @@
 #if !defined(HIST2D)
 #define HIST2D
 
-#include "TROOT.h"
-#include "TFile.h"
-#include "TH2.h"
-
 #include "IUAmpTools/Amplitude.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
+#include "AMPTOOLS_AMPS/Grid2D.h"
 
 #include <string>
 #include <complex>
@@ -24,17 +22,35 @@ class Hist2D : public UserAmplitude< Hist2D >
     
 public:
 	
-	Hist2D() : UserAmplitude< Hist2D >() { };
+	Hist2D() : UserAmplitude< Hist2D >(), m_grid( NULL ) { };
 	Hist2D( const vector< string >& args );
 	
 	string name() const { return "Hist2D"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the histogram coordinates of the event; they depend on the
+	// histogram type and particle list, so are not static
+	enum UserVars { kX = 0, kY, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
 	
 private:
 	
+	enum HistType { kMassVsEgamma, kMassVst };
+
         string fileName, histName, histType, particleList;
-	TH2 *hist2D;
+        HistType m_type;
+        ParticleCombination m_particles;
+	// shared by all instances with the same histogram (see Grid2D::get)
+	const Grid2D* m_grid;
 };
 
 #endif
@@ -11,9 +11,42 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Lambda1520Angles.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
 
+namespace {
+
+  // SDMEs for 3/2- -> 1/2+ + 0- (doi.org/10.1103/PhysRevC.96.025208),
+  // W = 3 ( 1/2 - rho011 ) sin^2 theta + rho011 ( 1 + 3 cos^2 theta ) + ...
+  void lambda1520Basis( GDouble Pgamma, GDouble cosSqTheta, GDouble sinSqTheta,
+                        GDouble sin2Theta, GDouble Phi, GDouble phi, GDouble* basis ){
+
+    const GDouble norm = 1./(4.*PI);
+    const GDouble sqrt3 = TMath::Sqrt(3.);
+    GDouble polCos = Pgamma*cos(2.*Phi);
+    GDouble polSin = Pgamma*sin(2.*Phi);
+
+    basis[0] = norm * 1.5*sinSqTheta;
+    basis[1] = norm * ( 1. + 3.*cosSqTheta - 3.*sinSqTheta );
+    basis[2] = -norm * 2.*sqrt3*cos(phi)*sin2Theta;
+    basis[3] = -norm * 2.*sqrt3*cos(2.*phi)*sinSqTheta;
+
+    basis[4] = -norm * polCos * ( 1. + 3.*cosSqTheta );
+    basis[5] = -norm * polCos * 3.*sinSqTheta;
+    basis[6] = norm * polCos * 2.*sqrt3*cos(phi)*sin2Theta;
+    basis[7] = norm * polCos * 2.*sqrt3*cos(2.*phi)*sinSqTheta;
+    basis[8] = -norm * polSin * 2.*sqrt3*sin(phi)*sin2Theta;
+    basis[9] = -norm * polSin * 2.*sqrt3*sin(2.*phi)*sinSqTheta;
+  }
+}
+
+void
+Lambda1520Angles::loadShared( const vector< string >& args ){
+
+	if( args.size() == 13 ) PolarizationTable::get( args[11], args[12] );
+}
+
 Lambda1520Angles::Lambda1520Angles( const vector< string >& args ) :
 UserAmplitude< Lambda1520Angles >( args )
 {
@@ -61,15 +94,13 @@ UserAmplitude< Lambda1520Angles >( args )
 		polInTree = false;
 		polAngle = atof( args[9].c_str() );	
 		polFraction = 0.;
-		TFile* f = new TFile( args[11].c_str() );
-        polFrac_vs_E = (TH1D*)f->Get( args[12].c_str() );
-        assert( polFrac_vs_E != NULL );
+		polFrac_vs_E = PolarizationTable::get( args[11], args[12] );
 	}
 }
 
 
-complex< GDouble >
-Lambda1520Angles::calcAmplitude( GDouble** pKin ) const {
+void
+Lambda1520Angles::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 	
 	TLorentzVector target ( 0, 0, 0, 0.9382720813);
 
@@ -122,25 +153,39 @@ Lambda1520Angles::calcAmplitude( GDouble** pKin ) const {
 		if(polFraction > 0.) { // for fitting with constant polarization 
 			Pgamma = polFraction;
 		} else{
-			int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-			if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-				Pgamma = 0.;
-			} else 
-				Pgamma = polFrac_vs_E->GetBinContent(bin);
+			Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
 		}
 	}
 
-	
-	// SDMEs for 3/2- -> 1/2+ + 0- (doi.org/10.1103/PhysRevC.96.025208)
-	GDouble W = 3.*(0.5 - rho011)*sinSqTheta + rho011*(1.+3.*cosSqTheta) - 2.*TMath::Sqrt(3.)*rho031*cos(phi)*sin2Theta - 2.*TMath::Sqrt(3.)*rho03m1*cos(2.*phi)*sinSqTheta;
-	
-	W -= Pgamma*cos(2.*Phi) * (3.*rho133*sinSqTheta + rho111*(1.+3.*cosSqTheta) - 2.*TMath::Sqrt(3.)*rho131*cos(phi)*sin2Theta - 2.*TMath::Sqrt(3.)*rho13m1*cos(2.*phi)*sinSqTheta);
-	
-	W -= Pgamma*sin(2.*Phi) * (2.*TMath::Sqrt(3.)*rho231*sin(phi)*sin2Theta + 2.*TMath::Sqrt(3.)*rho23m1*sin(2.*phi)*sinSqTheta);
-	
-	W *= 1./(4.*PI);
-	
-// 	return W;
+
+	lambda1520Basis( Pgamma, cosSqTheta, sinSqTheta, sin2Theta, Phi, phi, userVars + kBasis );
+}
+
+complex< GDouble >
+Lambda1520Angles::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+	GDouble rho[kNumRho];
+	parameters( rho );
+
+	GDouble W = linearIntensity< kNumRho >( userVars + kBasis, rho );
+
 	return complex< GDouble > ( sqrt(fabs(W)) );
 }
 
+void
+Lambda1520Angles::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                      int nEvents, complex< GDouble >* amps ) const {
+
+	GDouble rho[kNumRho];
+	parameters( rho );
+
+	linearAmplitudeBatch< kNumRho >( rho, userVars + kBasis, kNumUserVars, nEvents, amps );
+}
+
+void
+Lambda1520Angles::parameters( GDouble* rho ) const {
+
+	rho[0] = rho011;  rho[1] = rho031;  rho[2] = rho03m1;
+	rho[3] = rho111;  rho[4] = rho133;  rho[5] = rho131;  rho[6] = rho13m1;
+	rho[7] = rho231;  rho[8] = rho23m1;
+}
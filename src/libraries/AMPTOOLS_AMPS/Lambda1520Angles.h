@@ -6,7 +6,8 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_AMPS/LinearAmplitude.h"
 
 #include <string>
 #include <complex>
@@ -28,11 +29,34 @@ public:
 	Lambda1520Angles( const vector< string >& args );
 	
 	string name() const { return "Lambda1520Angles"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	// the angular functions of W for the constant and the nine rho, in
+	// the order of the arguments
+	enum { kNumRho = 9 };
+	enum UserVars { kBasis = 0, kNumUserVars = kBasis + kNumRho + 1 };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	// evaluates a block of events in one call (see AmplitudeBatch.h), W
+	// is linear in the spin density matrix elements (LinearAmplitude.h)
+	void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+	                         int nEvents, complex< GDouble >* amps ) const;
+
+	// the spin density matrix elements are the only free parameters, so
+	// everything else is computed once in the userVars block, and the
+	// frames and angles are not recomputed when a fit is repeated
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
 
-  
 private:
+
+	void parameters( GDouble* rho ) const;
   
 	AmpParameter rho011;
 	AmpParameter rho031;
@@ -48,7 +72,7 @@ private:
 
 	GDouble polFraction=0.;
 	GDouble polAngle=-1;
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E=NULL;
     bool polInTree;
 
 };
@@ -5,13 +5,14 @@
 #include <complex>
 #include <cstdlib>
 
-#include "TLorentzVector.h"
+#include "TMath.h"
 
 #include "barrierFactor.h"
 #include "breakupMomentum.h"
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Lambda1520tdist.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 
 // Class modeled after TwoPitdist amplitude function
 // 
@@ -29,34 +30,43 @@ UserAmplitude< Lambda1520tdist >( args )
   // need to register any free parameters so the framework knows about them
   registerParameter( Bslope );
   registerParameter( Bgen );
+
+  updatePar( Bslope );
   
   // make sure the input variables look reasonable
   assert( ( Bgen >= 1 ) && ( Bslope >= Bgen ) );     // Make sure generated value is lower than actual.         
 }
 
-complex< GDouble >
-Lambda1520tdist::calcAmplitude( GDouble** pKin ) const
+void
+Lambda1520tdist::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector d1, d2;
-  TLorentzVector target( 0, 0, 0, 0.938272046 );   // proton at rest
+  // get momentum transfer, daughters are particles 2 and 3 and the
+  // proton target is at rest
+  GDouble q[4];
+  for( int i = 0; i < 4; ++i ) q[i] = pKin[2][i] + pKin[3][i];
+  q[0] -= 0.938272046;
 
-  // get momentum transfer
-  d1.SetPxPyPzE (pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0]);   // daughter1 is particle 2
-  d2.SetPxPyPzE (pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);   // daughter2 is particle 3
-  GDouble t = (d1+d2-target).M2()*(-1.);
+  GDouble t = ParticleCombination::mass2( q )*(-1.);
 
-    complex<GDouble> Arel(sqrt(TMath::Power(t,exponent)*exp(-Bslope*t)/exp(-Bgen*t)),0.);  // Divide out generated exponential. This must be the same as in GammaZToXYZ.cc. Return sqrt(exp^Bt) 
-  
+  userVars[kT] = t;
+  // the exponent is not a free parameter:  sqrt( t^exponent ) is static
+  userVars[kTPower] = sqrt(TMath::Power(t,exponent));
+}
+
+complex< GDouble >
+Lambda1520tdist::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
+{
+  GDouble t = userVars[kT];
 
-    // cout << " Lambda1520tdist" << " Bslope=" << Bslope << " Bgen=" << Bgen << " t=" << t <<  " Re(Arel)=" << real(Arel) << " imag(Arel)=" << imag(Arel) << endl; 
+    // Divide out generated exponential. This must be the same as in GammaZToXYZ.cc. Return sqrt(exp^Bt) 
+    complex<GDouble> Arel(userVars[kTPower]*exp(-m_halfSlope*t),0.);
+  
   return( Arel );
 }
 
 void
 Lambda1520tdist::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates
-  
+  // sqrt( exp( -Bslope t ) / exp( -Bgen t ) ) is a single exponential
+  m_halfSlope = 0.5*( Bslope - Bgen );
 }
-
-
@@ -0,0 +1,42 @@
+#if !defined(LINEARAMPLITUDE)
+#define LINEARAMPLITUDE
+
+#include <cmath>
+#include <complex>
+
+// Amplitudes A = sqrt( |W| ) whose intensity is linear in their N
+// parameters p (the spin density matrix elements of TwoPiAngles,
+// ThreePiAnglesSchilling, TwoPiAnglesRadiative and Lambda1520Angles):
+//
+//   W = basis[0] + sum_k p[k] basis[k+1]
+//
+// The N + 1 basis functions only depend on the event and are kept in the
+// user variables, so the amplitudes of a block of events are one product
+// of the basis matrix with ( 1, p ).  linearAmplitudeBatch is the
+// calcAmplitudeBatch of these amplitudes (see AmplitudeBatch.h).
+
+#define LINEAR_FUNC inline
+
+template< int N, class T, class P >
+LINEAR_FUNC T
+linearIntensity( const T* basis, const P* p ){
+
+  T W = basis[0];
+  for( int k = 0; k < N; ++k ) W += T( p[k] ) * basis[k + 1];
+  return W;
+}
+
+// the basis of event i at userVars[i * stride]
+template< int N, class T >
+inline void
+linearAmplitudeBatch( const T* p, const T* userVars, unsigned int stride,
+                      int nEvents, std::complex< T >* amps ){
+
+  for( int i = 0; i < nEvents; ++i ){
+
+    T W = linearIntensity< N >( userVars + (size_t)i * stride, p );
+    amps[i] = std::complex< T >( std::sqrt( std::fabs( W ) ) );
+  }
+}
+
+#endif
@@ -0,0 +1,101 @@
+#if !defined(PARTICLECOMBINATION)
+#define PARTICLECOMBINATION
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+using namespace std;
+
+// A list of particle indices that is summed to form a composite four-vector,
+// e.g., the daughters of a resonance.  In configuration files the list is
+// given as a string of single-digit indices, e.g., "23" for particles 2 and 3.
+// The string is parsed once when the amplitude is constructed; the sums
+// below then work directly on pKin, with four-vectors in the AmpTools order
+// (E, px, py, pz).
+
+class ParticleCombination
+{
+
+public:
+
+  enum { kMaxIndices = 10 };
+
+  ParticleCombination() : m_size( 0 ) {}
+
+  explicit ParticleCombination( const string& indices ) : m_size( 0 ) {
+
+    assert( indices.size() <= kMaxIndices );
+
+    for( unsigned int i = 0; i < indices.size(); ++i ){
+
+      if( indices[i] < '0' || indices[i] > '9' ){
+
+        cout << "ParticleCombination ERROR:  invalid particle index list "
+             << indices << endl;
+        assert( false );
+      }
+
+      m_index[m_size++] = indices[i] - '0';
+    }
+  }
+
+  int size() const { return m_size; }
+  int operator[]( int i ) const { return m_index[i]; }
+
+  // the bits of the particles of the event that the list takes under a
+  // permutation of the framework, where pKin[i] is particle permutation[i]
+  unsigned int mask( const vector< int >& permutation ) const {
+
+    unsigned int bits = 0;
+    for( int i = 0; i < m_size; ++i ) bits |= 1u << permutation[m_index[i]];
+    return bits;
+  }
+
+  // adds the four-momenta of all particles in the list to p4
+  inline void addTo( GDouble** pKin, GDouble* p4 ) const {
+
+    for( int i = 0; i < m_size; ++i ){
+
+      const GDouble* p = pKin[m_index[i]];
+      p4[0] += p[0]; p4[1] += p[1]; p4[2] += p[2]; p4[3] += p[3];
+    }
+  }
+
+  // sets p4 to the summed four-momentum
+  inline void sum( GDouble** pKin, GDouble* p4 ) const {
+
+    p4[0] = p4[1] = p4[2] = p4[3] = 0;
+    addTo( pKin, p4 );
+  }
+
+  inline GDouble mass( GDouble** pKin ) const {
+
+    GDouble p4[4];
+    sum( pKin, p4 );
+    return ParticleCombination::mass( p4 );
+  }
+
+  // same sign convention as TLorentzVector::M()
+  static inline GDouble mass2( const GDouble* p4 ){
+
+    return p4[0] * p4[0] - p4[1] * p4[1] - p4[2] * p4[2] - p4[3] * p4[3];
+  }
+
+  static inline GDouble mass( const GDouble* p4 ){
+
+    GDouble m2 = mass2( p4 );
+    return ( m2 < 0 ? -sqrt( -m2 ) : sqrt( m2 ) );
+  }
+
+private:
+
+  int m_size;
+  int m_index[kMaxIndices];
+};
+
+#endif
@@ -0,0 +1,117 @@
+#if !defined(PERMUTATIONUSERVARS)
+#define PERMUTATIONUSERVARS
+
+#include <cstring>
+#include <vector>
+
+#include "IUAmpTools/Amplitude.h"
+#include "GPUManager/GPUCustomTypes.h"
+
+using namespace std;
+
+// User variables shared by the permutations of identical particles.  The
+// framework computes the user variables of every amplitude for every
+// permutation of an event, but many only depend on the sets of particles
+// that are summed:  the mass of a pi0 pi0 pair is the same when the two
+// pi0 are swapped.  An amplitude declares this with
+//
+//   bool sameUserVars( const vector< int >& a, const vector< int >& b ) const;
+//
+// true if its user variables under the permutations a and b are the same
+// (up to the order of additions), and calls
+// calcUserVarsOfPermutations from its calcUserVarsAll.  The user variables
+// are then computed for the first permutation of each group only and
+// copied to the others.  ThreadedAmplitude does the same for amplitudes
+// that declare sameUserVars.
+//
+// The framework allocates the user variables of each permutation, so the
+// memory stays the same; the copies keep the layout of the arrays that
+// the amplitude kernels read.
+
+namespace PermutationUserVars {
+
+  // sameUserVars of A if it has one, else false
+  template< class A >
+  auto same( const A& amp, const vector< int >& a, const vector< int >& b, int )
+    -> decltype( amp.sameUserVars( a, b ) ) {
+
+    return amp.sameUserVars( a, b );
+  }
+
+  template< class A >
+  bool same( const A&, const vector< int >&, const vector< int >&, long ){
+
+    return false;
+  }
+
+  /**
+   * The index of the first permutation with the same user variables as
+   * permutation p, for each p; p itself if there is none.
+   */
+  template< class A >
+  vector< int > sources( const A& amp, const vector< vector< int > >& permutations ){
+
+    vector< int > source( permutations.size() );
+    for( unsigned int p = 0; p < permutations.size(); ++p ){
+
+      source[p] = p;
+      for( unsigned int q = 0; q < p; ++q ){
+
+        if( source[q] == (int)q && same( amp, permutations[q], permutations[p], 0 ) ){
+
+          source[p] = q;
+          break;
+        }
+      }
+    }
+
+    return source;
+  }
+
+  // copies the user variables of the events of each permutation from its source
+  inline void copy( const vector< int >& source, GDouble* pdUserVars,
+                    unsigned int numVars, int iNEvents ){
+
+    size_t block = (size_t)numVars * iNEvents;
+    for( unsigned int p = 0; p < source.size(); ++p )
+      if( source[p] != (int)p )
+        memcpy( pdUserVars + block * p, pdUserVars + block * source[p], block * sizeof( GDouble ) );
+  }
+
+  /**
+   * The loop of Amplitude::calcUserVarsAll over the events and the
+   * permutations that have no source.
+   */
+  template< class A >
+  void calcUserVarsOfPermutations( const A& amp, GDouble* pdData, GDouble* pdUserVars,
+                                   int iNEvents,
+                                   const vector< vector< int > >* pvPermutations ){
+
+    const Amplitude& base = amp;
+    unsigned int numVars = base.numUserVars();
+    int nPermutations = pvPermutations->size();
+    if( nPermutations == 0 || numVars == 0 ) return;
+
+    vector< int > source = sources( amp, *pvPermutations );
+    int nParticles = (*pvPermutations)[0].size();
+    vector< GDouble* > pKin( nParticles, (GDouble*)NULL );
+
+    for( int iPerm = 0; iPerm < nPermutations; ++iPerm ){
+
+      if( source[iPerm] != iPerm ) continue;
+
+      const vector< int >& permutation = (*pvPermutations)[iPerm];
+      for( int iEvent = 0; iEvent < iNEvents; ++iEvent ){
+
+        for( int i = 0; i < nParticles; ++i )
+          pKin[i] = &( pdData[4 * ( iNEvents * permutation[i] + iEvent )] );
+
+        amp.calcUserVars( &( pKin[0] ), &( pdUserVars[numVars * ( iNEvents * iPerm + iEvent )] ) );
+      }
+    }
+
+    copy( source, pdUserVars, numVars, iNEvents );
+  }
+}
+
+#endif
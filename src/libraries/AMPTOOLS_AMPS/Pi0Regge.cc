@@ -4,6 +4,7 @@
 #include <string>
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
 
 #include "TLorentzVector.h"
 #include "TLorentzRotation.h"
@@ -11,41 +12,77 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Pi0Regge.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_AMPS/Pi0ReggeTable.h"
+
+void
+Pi0Regge::loadShared( const vector< string >& args ){
+
+	// as the constructor, without its checks of the arguments
+	vector< string > polArgs( args.begin(), find( args.begin(), args.end(), "grid" ) );
+	vector< string > gridArgs( args.begin() + min( polArgs.size() + 1, args.size() ), args.end() );
+
+	if( gridArgs.size() == 4 || gridArgs.size() == 5 )
+		Pi0ReggeTable::get( atoi( gridArgs[0].c_str() ), atof( gridArgs[1].c_str() ),
+		                    atof( gridArgs[2].c_str() ), atoi( gridArgs[3].c_str() ),
+		                    gridArgs.size() == 5 ? gridArgs[4] : "" );
+
+	if( polArgs.size() == 5 ) PolarizationTable::get( polArgs[3], polArgs[4] );
+}
 
 Pi0Regge::Pi0Regge( const vector< string >& args ) :
-UserAmplitude< Pi0Regge >( args )
+UserAmplitude< Pi0Regge >( args ),
+polAngle( 0. ), polFraction( 0. ), polFrac_vs_E( NULL )
 {
-	assert( args.size() == 1 ||  args.size() == 3 || args.size() == 5 );
+	// optionally the model is tabulated in (E, cos(theta)) and interpolated,
+	// which is much faster for large samples (see Pi0ReggeTable.h); the
+	// grid is appended to any of the argument lists below
+	//    Usage: ... grid <nE> <Emin> <Emax> <nCosTheta> [<tableFile>]
+	m_table = NULL;
+	vector< string > polArgs( args.begin(), find( args.begin(), args.end(), "grid" ) );
+	if( polArgs.size() < args.size() ){
+
+		vector< string > gridArgs( args.begin() + polArgs.size() + 1, args.end() );
+		if( gridArgs.size() != 4 && gridArgs.size() != 5 ){
+
+			cout << "Pi0Regge ERROR:  grid needs <nE> <Emin> <Emax> <nCosTheta> [<tableFile>]" << endl;
+			assert( false );
+		}
+
+		m_table = Pi0ReggeTable::get( atoi( gridArgs[0].c_str() ), atof( gridArgs[1].c_str() ),
+		                              atof( gridArgs[2].c_str() ), atoi( gridArgs[3].c_str() ),
+		                              gridArgs.size() == 5 ? gridArgs[4] : "" );
+	}
+
+	assert( polArgs.size() == 1 ||  polArgs.size() == 3 || polArgs.size() == 5 );
 
 	// three ways to pass on polarization information
 	// (adapted from Zlm.cc)
 	
-	if( args.size() == 1 ) {
+	if( polArgs.size() == 1 ) {
 		// 1. polarization information must be included in beam photon four vector
 		//    Usage: amplitude <reaction>::<sum>::<ampName>
 
 		polInTree = true;
-	} else if( args.size() == 3 ) {
+	} else if( polArgs.size() == 3 ) {
 		// 2. polarization fixed per amplitude and passed as flag
 		//    Usage: amplitude <reaction>::<sum>::<ampName> <polAngle> <polFraction>
 		polInTree = false;
-		polAngle = atof( args[1].c_str() );
-		polFraction = atof( args[2].c_str() );
+		polAngle = atof( polArgs[1].c_str() );
+		polFraction = atof( polArgs[2].c_str() );
 	} else {
 		// 2. polarization fixed per amplitude and passed as flag
 		//    Usage: amplitude <reaction>::<sum>::<ampName> <polAngle> <polFraction=0.> <rootFile> <hist>
 		polInTree = false;
-		polAngle = atof( args[1].c_str() );	
+		polAngle = atof( polArgs[1].c_str() );	
 		polFraction = 0.;
-		TFile* f = new TFile( args[3].c_str() );
-        polFrac_vs_E = (TH1D*)f->Get( args[4].c_str() );
-        assert( polFrac_vs_E != NULL );
+		polFrac_vs_E = PolarizationTable::get( polArgs[3], polArgs[4] );
 	}
 }
 
 
-complex< GDouble >
-Pi0Regge::calcAmplitude( GDouble** pKin ) const {
+void
+Pi0Regge::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
 	TLorentzVector target  ( 0., 0., 0., 0.938);
 
@@ -82,11 +119,7 @@ Pi0Regge::calcAmplitude( GDouble** pKin ) const {
 		if(polFraction > 0.) { // for fitting with constant polarization 
 			Pgamma = polFraction;
 		} else{
-			int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-			if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-				Pgamma = 0.;
-			} else 
-				Pgamma = polFrac_vs_E->GetBinContent(bin);
+			Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
 		}
 	}
 
@@ -96,9 +129,16 @@ Pi0Regge::calcAmplitude( GDouble** pKin ) const {
 
 	// amplitude coded in c++ (include calculation of beam asymmetry)
 	GDouble BeamSigma = 0.;
-	GDouble W = Pi0PhotCS_S(Ecom, theta, BeamSigma);
+	GDouble W = ( m_table != NULL ? m_table->crossSection(Ecom, theta, BeamSigma) :
+	              Pi0PhotCS_S(Ecom, theta, BeamSigma) );
 	W *= (1 - Pgamma * BeamSigma * cos2Phi);
 
-	return complex< GDouble > ( sqrt( fabs(W) ) );
+	userVars[kAmp] = sqrt( fabs(W) );
+}
+
+complex< GDouble >
+Pi0Regge::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+	return complex< GDouble > ( userVars[kAmp] );
 }
 
@@ -6,7 +6,8 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_AMPS/Pi0ReggeTable.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -23,19 +24,36 @@ class Pi0Regge : public UserAmplitude< Pi0Regge >
     
 public:
 	
-	Pi0Regge() : UserAmplitude< Pi0Regge >() { };
+	Pi0Regge() : UserAmplitude< Pi0Regge >(), polFrac_vs_E( NULL ), m_table( NULL ) { };
 	Pi0Regge( const vector< string >& args );
 	
 	string name() const { return "Pi0Regge"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
-	
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the amplitude has no free parameters, so it is computed once, from
+	// the model or the table, and kept in the user variables
+	enum UserVars { kAmp = 0, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
+
 private:
 
 	GDouble polAngle;
 	GDouble polFraction;
     bool polInTree;
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E;
+
+	// the tabulated model, NULL if the model is evaluated for every event
+	const Pi0ReggeTable* m_table;
 };
 
 #endif
@@ -308,7 +308,7 @@ complex<double> cgamma(complex<double> z,int OPT)
   x1=9e9;
   na=9e9;
   
-  static double a[] = {
+  static const double a[] = {
     8.333333333333333e-02,
     -2.777777777777778e-03,
     7.936507936507937e-04,
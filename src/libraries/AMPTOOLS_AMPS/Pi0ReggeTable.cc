@@ -0,0 +1,186 @@
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "TFile.h"
+#include "TH2.h"
+#include "TH2D.h"
+#include "TSystem.h"
+
+#include "AMPTOOLS_AMPS/Pi0ReggeTable.h"
+#include "AMPTOOLS_AMPS/Pi0ReggeModel.h"
+#include "AMPTOOLS_AMPS/SharedResources.h"
+
+static const char* kDsdtName = "Pi0Regge_dsdt";
+static const char* kSigmaName = "Pi0Regge_SigmaDsdt";
+
+const Pi0ReggeTable*
+Pi0ReggeTable::get( int nE, double eLow, double eHigh, int nCosTheta,
+                    const string& fileName ){
+
+  static SharedResources< Pi0ReggeTable > tables;
+
+  ostringstream key;
+  key.precision( 17 );
+  key << nE << ":" << eLow << ":" << eHigh << ":" << nCosTheta << ":" << fileName;
+
+  return tables.get( key.str(), [&](){
+
+    return new Pi0ReggeTable( nE, eLow, eHigh, nCosTheta, fileName );
+  } );
+}
+
+Pi0ReggeTable::Pi0ReggeTable( int nE, double eLow, double eHigh, int nCosTheta,
+                              const string& fileName ) :
+  m_nE( nE ),
+  m_nCosTheta( nCosTheta ),
+  m_eLow( eLow ),
+  m_eHigh( eHigh )
+{
+  if( nE < 2 || nCosTheta < 2 || !( eHigh > eLow ) ){
+
+    cout << "Pi0ReggeTable ERROR:  invalid grid " << nE << " x " << nCosTheta
+         << " points for E in [" << eLow << ", " << eHigh << "]" << endl;
+    assert( false );
+  }
+
+  if( fileName.empty() || !read( fileName ) ){
+
+    tabulate();
+    if( !fileName.empty() ) write( fileName );
+  }
+}
+
+double
+Pi0ReggeTable::crossSection( double E, double theta, double& beamSigma ) const {
+
+  double cosTheta = cos( theta );
+
+  if( !( E >= m_eLow && E <= m_eHigh ) )
+    return Pi0PhotCS_S( E, theta, beamSigma );
+
+  double dsdt = m_dsdt.value( E, cosTheta );
+  beamSigma = ( dsdt > 0 ? m_sigma.value( E, cosTheta ) / dsdt : 0. );
+
+  return dsdt;
+}
+
+void
+Pi0ReggeTable::tabulate(){
+
+  cout << "Pi0ReggeTable:  tabulating the pi0 Regge model on " << m_nE << " x "
+       << m_nCosTheta << " points for E in [" << m_eLow << ", " << m_eHigh << "]" << endl;
+
+  vector< GDouble > dsdt( m_nE * m_nCosTheta );
+  vector< GDouble > sigma( m_nE * m_nCosTheta );
+
+  for( int iE = 0; iE < m_nE; ++iE ){
+    for( int iCos = 0; iCos < m_nCosTheta; ++iCos ){
+
+      double E = m_eLow + iE * stepE();
+      double theta = acos( min( -1. + iCos * stepCos(), 1. ) );
+
+      double beamSigma = 0.;
+      dsdt[iE*m_nCosTheta+iCos] = Pi0PhotCS_S( E, theta, beamSigma );
+      sigma[iE*m_nCosTheta+iCos] = beamSigma * dsdt[iE*m_nCosTheta+iCos];
+    }
+  }
+
+  m_dsdt = Grid2D( m_nE, gridLowE(), gridHighE(), m_nCosTheta, gridLowCos(), gridHighCos(),
+                   &(dsdt[0]), true );
+  m_sigma = Grid2D( m_nE, gridLowE(), gridHighE(), m_nCosTheta, gridLowCos(), gridHighCos(),
+                    &(sigma[0]), true );
+}
+
+bool
+Pi0ReggeTable::read( const string& fileName ){
+
+  // a missing file is not an error, the table is written to it
+  if( gSystem->AccessPathName( fileName.c_str() ) ) return false;
+
+  TFile* f = TFile::Open( fileName.c_str() );
+  if( f == NULL ) return false;
+
+  bool found = false;
+
+  if( !f->IsZombie() ){
+
+    TH2* dsdt = (TH2*)f->Get( kDsdtName );
+    TH2* sigma = (TH2*)f->Get( kSigmaName );
+
+    if( dsdt != NULL && sigma != NULL ){
+
+      // an existing table is only used if it has the requested binning
+      const TAxis* xAxis = dsdt->GetXaxis();
+      const TAxis* yAxis = dsdt->GetYaxis();
+      double tolerance = 1e-9 * ( m_eHigh - m_eLow );
+
+      found = ( xAxis->GetNbins() == m_nE && yAxis->GetNbins() == m_nCosTheta &&
+                fabs( xAxis->GetXmin() - gridLowE() ) < tolerance &&
+                fabs( xAxis->GetXmax() - gridHighE() ) < tolerance );
+
+      if( found ){
+
+        m_dsdt = Grid2D( dsdt, true );
+        m_sigma = Grid2D( sigma, true );
+
+        cout << "Pi0ReggeTable:  read the pi0 Regge model table from " << fileName << endl;
+      }
+      else{
+
+        cout << "Pi0ReggeTable WARNING:  the table in " << fileName
+             << " has a different binning; it will be replaced" << endl;
+      }
+    }
+  }
+
+  f->Close();
+  delete f;
+
+  return found;
+}
+
+void
+Pi0ReggeTable::write( const string& fileName ) const {
+
+  TFile* f = TFile::Open( fileName.c_str(), "RECREATE" );
+
+  if( f == NULL || f->IsZombie() ){
+
+    cout << "Pi0ReggeTable WARNING:  unable to write the table to " << fileName << endl;
+    delete f;
+    return;
+  }
+
+  TH2D dsdt( kDsdtName, "d#sigma/dt", m_nE, gridLowE(), gridHighE(),
+             m_nCosTheta, gridLowCos(), gridHighCos() );
+  TH2D sigma( kSigmaName, "#Sigma d#sigma/dt", m_nE, gridLowE(), gridHighE(),
+              m_nCosTheta, gridLowCos(), gridHighCos() );
+
+  // the histograms are local, so keep the file from taking ownership
+  dsdt.SetDirectory( 0 );
+  sigma.SetDirectory( 0 );
+
+  const GDouble* dsdtValues = m_dsdt.values();
+  const GDouble* sigmaValues = m_sigma.values();
+
+  for( int iE = 0; iE < m_nE; ++iE ){
+    for( int iCos = 0; iCos < m_nCosTheta; ++iCos ){
+
+      dsdt.SetBinContent( iE + 1, iCos + 1, dsdtValues[iE*m_nCosTheta+iCos] );
+      sigma.SetBinContent( iE + 1, iCos + 1, sigmaValues[iE*m_nCosTheta+iCos] );
+    }
+  }
+
+  f->WriteTObject( &dsdt );
+  f->WriteTObject( &sigma );
+
+  f->Close();
+  delete f;
+
+  cout << "Pi0ReggeTable:  wrote the pi0 Regge model table to " << fileName << endl;
+}
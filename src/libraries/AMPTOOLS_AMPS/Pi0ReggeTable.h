@@ -0,0 +1,82 @@
+#if !defined(PI0REGGETABLE)
+#define PI0REGGETABLE
+
+#include <string>
+
+#include "AMPTOOLS_AMPS/Grid2D.h"
+
+using namespace std;
+
+// The cross section dsigma/dt and the beam asymmetry Sigma of the pi0 Regge
+// model (Pi0PhotCS_S in Pi0ReggeModel.cc) tabulated on a grid in the gamma p
+// center-of-mass energy E and cos(theta), the pi0 angle in that frame.  The
+// model only depends on (E, theta), so a job that evaluates it for many
+// events can interpolate in the table instead of evaluating four Regge
+// helicity amplitudes per event.
+//
+// The model is evaluated on a uniform grid of points in E, including both
+// ends of the energy range, and in cos(theta) over [-1, 1], and interpolated
+// bilinearly between them.  The table holds Sigma times dsigma/dt, which is
+// smooth where dsigma/dt vanishes and Sigma is not.  Energies outside of the
+// range are computed from the model directly.  The accuracy is set by the
+// number of points: the cross section is strongly forward peaked, so
+// cos(theta) needs many more points than E.  For E from 3 to 4.6 GeV,
+// 81 x 2001 points reproduce the polarized cross section to 0.06% on
+// average (10% in the worst place, close to cos(theta) = 1), and 161 x 8001
+// points to 0.004% (2.5%).  The stored grid has one bin centered on each
+// point.
+//
+// With a file name the table is read from that ROOT file if it holds a table
+// with the same binning, and otherwise computed and written to it, so that
+// later jobs skip the tabulation.  Tables are shared like PolarizationTable:
+// every amplitude that asks for the same binning and file gets the same
+// immutable object.
+
+class Pi0ReggeTable
+{
+
+public:
+
+  /**
+   * Return the shared table with nE points in E from eLow to eHigh and
+   * nCosTheta points in cos(theta), creating it on the first call.  The
+   * returned table lives until the end of the job.
+   */
+  static const Pi0ReggeTable* get( int nE, double eLow, double eHigh, int nCosTheta,
+                                   const string& fileName = "" );
+
+  /**
+   * Same arguments and results as Pi0PhotCS_S: returns dsigma/dt and sets
+   * beamSigma.
+   */
+  double crossSection( double E, double theta, double& beamSigma ) const;
+
+private:
+
+  Pi0ReggeTable( int nE, double eLow, double eHigh, int nCosTheta,
+                 const string& fileName );
+
+  // tables are shared and never copied
+  Pi0ReggeTable( const Pi0ReggeTable& );
+  Pi0ReggeTable& operator=( const Pi0ReggeTable& );
+
+  bool read( const string& fileName );
+  void tabulate();
+  void write( const string& fileName ) const;
+
+  // spacing of the points and the edges of the bins centered on them
+  double stepE() const { return ( m_eHigh - m_eLow ) / ( m_nE - 1 ); }
+  double stepCos() const { return 2. / ( m_nCosTheta - 1 ); }
+  double gridLowE() const { return m_eLow - 0.5 * stepE(); }
+  double gridHighE() const { return m_eHigh + 0.5 * stepE(); }
+  double gridLowCos() const { return -1. - 0.5 * stepCos(); }
+  double gridHighCos() const { return 1. + 0.5 * stepCos(); }
+
+  int m_nE, m_nCosTheta;
+  double m_eLow, m_eHigh;
+
+  Grid2D m_dsdt;
+  Grid2D m_sigma;   // Sigma * dsigma/dt
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <string>
 #include <sstream>
 #include <cstdlib>
+#include <vector>
 
 #include "TLorentzVector.h"
 #include "TLorentzRotation.h"
@@ -11,30 +12,57 @@
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Pi0SAID.h"
 
+void
+Pi0SAID::loadShared( const vector< string >& args ){
+
+	sharedGrids();
+}
+
 Pi0SAID::Pi0SAID( const vector< string >& args ) :
 UserAmplitude< Pi0SAID >( args )
 {
 	assert( args.size() == 1 );
 	Pgamma = atof( args[0].c_str() );
 
-	FillDataTables();
+	m_dsgGrid = &( sharedGrids()[0] );
+	m_sigmaGrid = &( sharedGrids()[1] );
+}
+
+vector< Grid2D >
+Pi0SAID::buildGrids(){
 
-	hCosTheta_Ebeam = new TH2F("hCosTheta_Ebeam","; E_{#gamma}; cos#theta; d#sigma/dcos#theta", 31, 1.475, 3.025, 41, -1.025, 1.025);
-	hSigma_Ebeam = new TH2F("hSigma_Ebeam","; E_{#gamma}; cos#theta; #Sigma", 31, 1.475, 3.025, 41, -1.025, 1.025);
+	double DSG[31][41];
+	double Sigma[31][41];
+	FillDataTables( DSG, Sigma );
 
-	for(int i=0; i<hCosTheta_Ebeam->GetXaxis()->GetNbins(); i++){
-		for(int j=0; j<hCosTheta_Ebeam->GetYaxis()->GetNbins(); j++){
-			hCosTheta_Ebeam->SetBinContent(i+1,j+1,DSG[i][j]);
-			hSigma_Ebeam->SetBinContent(i+1,j+1,Sigma[i][j]);
+	// 31 bins in E_gamma from 1.475 to 3.025 GeV and 41 bins in cos(theta)
+	// from -1.025 to 1.025, centered on the tabulated points
+	vector< GDouble > dsg( 31*41 ), sigma( 31*41 );
+	for(int i=0; i<31; i++){
+		for(int j=0; j<41; j++){
+			dsg[i*41+j] = DSG[i][j];
+			sigma[i*41+j] = Sigma[i][j];
 		}
-	}		
+	}
+
+	vector< Grid2D > grids;
+	grids.push_back( Grid2D( 31, 1.475, 3.025, 41, -1.025, 1.025, &(dsg[0]) ) );
+	grids.push_back( Grid2D( 31, 1.475, 3.025, 41, -1.025, 1.025, &(sigma[0]) ) );
+	return grids;
 }
 
+const Grid2D*
+Pi0SAID::sharedGrids(){
+
+	// built on first use, which C++11 makes thread safe
+	static const vector< Grid2D > grids = buildGrids();
+
+	return &( grids[0] );
+}
+
+void
+Pi0SAID::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 
-complex< GDouble >
-Pi0SAID::calcAmplitude( GDouble** pKin ) const {
-  
-	TLorentzVector target  ( 0., 0., 0., 0.938);
 	TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
 	TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
 	TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] ); 
@@ -42,27 +70,30 @@ Pi0SAID::calcAmplitude( GDouble** pKin ) const {
 	TLorentzVector cm = recoil + p1;
 	TLorentzRotation cmBoost( -cm.BoostVector() );
 	
-	TLorentzVector target_cm = cmBoost * target;
-	TLorentzVector recoil_cm = cmBoost * recoil;
-	
 	TLorentzVector p1_cm = cmBoost * p1;
-	GDouble phi = p1_cm.Phi();
-	GDouble cosTheta = p1_cm.CosTheta();
-	GDouble cos2Phi = cos(2.*phi);
-	GDouble Eg = beam.E();
 
-	int bin = hCosTheta_Ebeam->FindBin(Eg, cosTheta);
-	GDouble DSG = hCosTheta_Ebeam->GetBinContent(bin);
-	GDouble Sigma = hSigma_Ebeam->GetBinContent(bin);
+	userVars[kEg] = beam.E();
+	userVars[kCosTheta] = p1_cm.CosTheta();
+	userVars[kCos2Phi] = cos(2.*p1_cm.Phi());
+}
+
+complex< GDouble >
+Pi0SAID::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+  
+	GDouble Eg = userVars[kEg];
+	GDouble cosTheta = userVars[kCosTheta];
+
+	GDouble DSG = m_dsgGrid->value(Eg, cosTheta);
+	GDouble Sigma = m_sigmaGrid->value(Eg, cosTheta);
 	
 	// weighted cross section from Igor Strakovsky (GWU/SAID collaboration)
-	GDouble W = DSG * (1 - Pgamma * Sigma * cos2Phi);
+	GDouble W = DSG * (1 - Pgamma * Sigma * userVars[kCos2Phi]);
 
 	return complex< GDouble > ( sqrt(W) );
 }
 
 // select proper index for given Eg and CosTheta
-void Pi0SAID::FillDataTables() {
+void Pi0SAID::FillDataTables( double DSG[31][41], double Sigma[31][41] ) {
 	
 	// Fill DSG data tables
 	double DSG1500[41] = {1.1446, 1.232, 1.2297, 1.1623, 1.0535, 0.9252, 0.7962, 0.6814, 0.5913, 0.5325, 0.5073, 0.5145, 0.5499, 0.607, 0.6777, 0.7533, 0.8248, 0.8838, 0.9233, 0.9378, 0.9238, 0.8806, 0.8098, 0.7158, 0.6057, 0.489, 0.3773, 0.284, 0.2233, 0.2094, 0.2551, 0.3705, 0.5609, 0.824, 1.1475, 1.5043, 1.8486, 2.11, 2.1861, 1.9348, 1.1637};
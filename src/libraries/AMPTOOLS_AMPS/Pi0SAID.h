@@ -1,12 +1,11 @@
 #if !defined(PI0SAID)
 #define PI0SAID
 
-#include "TH2.h"
-
 #include "IUAmpTools/Amplitude.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/Grid2D.h"
 
 #include <string>
 #include <complex>
@@ -22,20 +21,38 @@ class Pi0SAID : public UserAmplitude< Pi0SAID >
     
 public:
 	
-	Pi0SAID() : UserAmplitude< Pi0SAID >() { };
+	Pi0SAID() : UserAmplitude< Pi0SAID >(), m_dsgGrid( NULL ), m_sigmaGrid( NULL ) { };
 	Pi0SAID( const vector< string >& args );
 	
 	string name() const { return "Pi0SAID"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the beam energy and the pi0 angles in the pi0 p rest frame are
+	// computed once per event
+	enum UserVars { kEg = 0, kCosTheta, kCos2Phi, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
 	
 private:
 	
-	void FillDataTables();
-	double DSG[31][41];
-	double Sigma[31][41];
-
-	TH2F *hCosTheta_Ebeam, *hSigma_Ebeam;
+	static void FillDataTables( double DSG[31][41], double Sigma[31][41] );
+
+	// DSG and Sigma tabulated in (E_gamma, cos(theta)); the grids do not
+	// depend on the arguments, so they are filled once and shared by all
+	// instances for the life of the job
+	static const Grid2D* sharedGrids();
+	static vector< Grid2D > buildGrids();
+	const Grid2D* m_dsgGrid;
+	const Grid2D* m_sigmaGrid;
 	GDouble Pgamma;
 };
 
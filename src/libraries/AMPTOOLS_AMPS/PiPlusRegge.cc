@@ -11,9 +11,17 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/PiPlusRegge.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+
+void
+PiPlusRegge::loadShared( const vector< string >& args ){
+
+	if( args.size() == 5 ) PolarizationTable::get( args[3], args[4] );
+}
 
 PiPlusRegge::PiPlusRegge( const vector< string >& args ) :
-UserAmplitude< PiPlusRegge >( args )
+UserAmplitude< PiPlusRegge >( args ),
+polAngle( 0. ), polFraction( 0. ), polFrac_vs_E( NULL )
 {
 	assert( args.size() == 1 ||  args.size() == 3 || args.size() == 5 );
 
@@ -37,15 +45,13 @@ UserAmplitude< PiPlusRegge >( args )
 		polInTree = false;
 		polAngle = atof( args[1].c_str() );	
 		polFraction = 0.;
-		TFile* f = new TFile( args[3].c_str() );
-        polFrac_vs_E = (TH1D*)f->Get( args[4].c_str() );
-        assert( polFrac_vs_E != NULL );
+		polFrac_vs_E = PolarizationTable::get( args[3], args[4] );
 	}
 }
 
 
-complex< GDouble >
-PiPlusRegge::calcAmplitude( GDouble** pKin ) const {
+void
+PiPlusRegge::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
 	TLorentzVector target  ( 0., 0., 0., 0.938);
 
@@ -82,11 +88,7 @@ PiPlusRegge::calcAmplitude( GDouble** pKin ) const {
 		if(polFraction > 0.) { // for fitting with constant polarization 
 			Pgamma = polFraction;
 		} else{
-			int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-			if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-				Pgamma = 0.;
-			} else 
-				Pgamma = polFrac_vs_E->GetBinContent(bin);
+			Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
 		}
 	}
 
@@ -97,6 +99,12 @@ PiPlusRegge::calcAmplitude( GDouble** pKin ) const {
 	GDouble BeamSigma = 0.8;
 	W *= (1 - Pgamma * BeamSigma * cos2Phi);
 
-	return complex< GDouble > ( sqrt( fabs(W) ) );
+	userVars[kAmp] = sqrt( fabs(W) );
+}
+
+complex< GDouble >
+PiPlusRegge::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+	return complex< GDouble > ( userVars[kAmp] );
 }
 
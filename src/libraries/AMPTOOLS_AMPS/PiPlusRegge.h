@@ -1,12 +1,12 @@
-#if !defined(PI0REGGE)
-#define PI0REGGE
+#if !defined(PIPLUSREGGE)
+#define PIPLUSREGGE
 
 #include "IUAmpTools/Amplitude.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -21,19 +21,33 @@ class PiPlusRegge : public UserAmplitude< PiPlusRegge >
     
 public:
 	
-	PiPlusRegge() : UserAmplitude< PiPlusRegge >() { };
+	PiPlusRegge() : UserAmplitude< PiPlusRegge >(), polFrac_vs_E( NULL ) { };
 	PiPlusRegge( const vector< string >& args );
 	
 	string name() const { return "PiPlusRegge"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
-	
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the amplitude has no free parameters, so it is computed once and
+	// kept in the user variables
+	enum UserVars { kAmp = 0, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
+
 private:
 
 	GDouble polAngle;
 	GDouble polFraction;
     bool polInTree;
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E;
 };
 
 #endif
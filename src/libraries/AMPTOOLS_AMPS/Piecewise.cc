@@ -3,6 +3,8 @@
 #include <string>
 #include <complex>
 #include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 #include "TLorentzVector.h"
 
@@ -21,7 +23,7 @@ UserAmplitude< Piecewise >( args )
   m_massMin   = atof( args[0].c_str() );
   m_massMax   = atof( args[1].c_str() );
   m_nBins     = atoi( args[2].c_str() );
-  m_daughters = string( args[3] );
+  m_daughters = ParticleCombination( args[3] );
 
   m_suffix = args[4]; // in case more than one piecewise amplitude is used in the cfg file, this string may contain a suffix to be added to all parameter names
 
@@ -56,6 +58,18 @@ UserAmplitude< Piecewise >( args )
      registerParameter( m_params1[i] );
      registerParameter( m_params2[i] );
   }
+
+  m_values.resize( m_nBins );
+  for(int i=0; i<m_nBins; i++) updateBin( i );
+}
+
+void
+Piecewise::updateBin( int bin ){
+
+  if( m_represReIm )
+    m_values[bin] = complex< GDouble >( m_params1[bin], m_params2[bin] );
+  else
+    m_values[bin] = polar( fabs( GDouble( m_params1[bin] ) ), GDouble( m_params2[bin] ) );
 }
 
 complex< GDouble >
@@ -63,33 +77,40 @@ Piecewise::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
 {
 	// convert double back to long for array index
 	long* tempBin = (long*)&(userVars[uv_imassbin]);
-	complex<double> ans(m_params1[*tempBin],m_params2[*tempBin]);
-	if(!m_represReIm)
-		ans = polar(fabs(GDouble(m_params1[*tempBin])),GDouble(m_params2[*tempBin]));
-		
-	return ans;
+	return m_values[*tempBin];
 }
 
 void
-Piecewise::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
+Piecewise::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                               int nEvents, complex< GDouble >* amps ) const
+{
+  for( int i = 0; i < nEvents; ++i ){
 
-  TLorentzVector Ptemp, Ptot;
-  
-  for( unsigned int i = 0; i < m_daughters.size(); ++i ){
-    string num; num += m_daughters[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );
-    Ptot += Ptemp;
+    const long* tempBin = (const long*)&( userVars[i*kNumUserVars+uv_imassbin] );
+    amps[i] = m_values[*tempBin];
   }
+}
 
-  GDouble mass = Ptot.M();
+void
+Piecewise::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
+
+  GDouble p4[4];
+  m_daughters.sum( pKin, p4 );
+  GDouble mass = TLorentzVector( p4[1], p4[2], p4[3], p4[0] ).M();
 
+  // the bin whose open interval holds the mass; events on an edge or
+  // outside of the range are put in bin 0.  Only the bins next to the
+  // estimate are tested, with the same comparisons as a scan of all bins,
+  // so rounding in the estimate cannot move an event to another bin.
   long tempBin = 0;
 
-  for(int i=0; i<m_nBins; i++) {
-    if(mass>(m_massMin+(i*m_width)) && mass<(m_massMin+((i+1)*m_width)))
-       tempBin = i;
+  if( mass > m_massMin && mass < m_massMax ){
+
+    long guess = static_cast< long >( floor( ( mass - m_massMin ) / m_width ) );
+    for(long i=max(guess-1,0L); i<=min(guess+1,(long)m_nBins-1); i++) {
+      if(mass>(m_massMin+(i*m_width)) && mass<(m_massMin+((i+1)*m_width)))
+         tempBin = i;
+    }
   }
   
   // from Matt: use the memory allocated to a double type user variable to write the bin index as a long int
@@ -100,8 +121,15 @@ Piecewise::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 void
 Piecewise::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates
-  
+  // each parameter belongs to one bin, the others keep their values
+  for( int i = 0; i < m_nBins; ++i ){
+
+    if( par.name() == m_params1[i].name() || par.name() == m_params2[i].name() ){
+
+      updateBin( i );
+      return;
+    }
+  }
 }
 
 #ifdef GPU_ACCELERATION
@@ -5,6 +5,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 
 #include <utility>
 #include <string>
@@ -33,6 +34,10 @@ public:
 	string name() const { return "Piecewise"; }
   
   complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars  ) const;
+
+  // evaluates a block of events in one call (see AmplitudeBatch.h)
+  void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                           int nEvents, complex< GDouble >* amps ) const;
 	  
   // **********************
   // The following lines are optional and can be used to precalcualte
@@ -75,7 +80,7 @@ private:
 	
   float m_massMin, m_massMax;
   int m_nBins;
-  string m_daughters;  
+  ParticleCombination m_daughters;
   complex<GDouble> one;
   complex<GDouble> zero;
 
@@ -85,6 +90,11 @@ private:
   string m_suffix;
   AmpParameter paramTest;
   bool m_represReIm;
+
+  // the value of each bin, updated in updatePar for the bin whose
+  // parameter changed
+  vector< complex< GDouble > > m_values;
+  void updateBin( int bin );
 };
 
 #endif
@@ -0,0 +1,112 @@
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TH1.h"
+
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_AMPS/SharedResources.h"
+
+const PolarizationTable*
+PolarizationTable::get( const string& fileName, const string& histName,
+                        bool interpolate ){
+
+  static SharedResources< PolarizationTable > tables;
+
+  string key = fileName + ":" + histName + ( interpolate ? ":interpolate" : "" );
+
+  return tables.get( key, [&](){
+
+    return new PolarizationTable( fileName, histName, interpolate );
+  } );
+}
+
+PolarizationTable::PolarizationTable( const string& fileName, const string& histName,
+                                      bool interpolate ) :
+  m_name( histName ),
+  m_interpolate( interpolate )
+{
+  TFile* f = TFile::Open( fileName.c_str() );
+
+  if( f == NULL || f->IsZombie() ){
+
+    cout << "PolarizationTable ERROR:  unable to open " << fileName << endl;
+    assert( false );
+  }
+
+  TH1* hist = (TH1*)f->Get( histName.c_str() );
+
+  if( hist == NULL ){
+
+    cout << "PolarizationTable ERROR:  no histogram " << histName
+         << " in " << fileName << endl;
+    assert( false );
+  }
+
+  TAxis* axis = hist->GetXaxis();
+  int nBins = axis->GetNbins();
+
+  m_edges.resize( nBins + 1 );
+  m_content.resize( nBins );
+
+  for( int i = 0; i < nBins; ++i ){
+
+    m_edges[i] = axis->GetBinLowEdge( i + 1 );
+    m_content[i] = hist->GetBinContent( i + 1 );
+  }
+  m_edges[nBins] = axis->GetBinUpEdge( nBins );
+
+  m_low = m_edges[0];
+  m_high = m_edges[nBins];
+  m_invWidth = nBins / ( m_high - m_low );
+
+  m_uniform = !axis->IsVariableBinSize();
+
+  f->Close();
+  delete f;
+
+  cout << "PolarizationTable:  loaded " << histName << " from " << fileName
+       << " (" << nBins << " bins)" << endl;
+}
+
+int
+PolarizationTable::findBin( GDouble energy ) const {
+
+  // same convention as TAxis::FindBin: bins include their low edge
+  if( !( energy >= m_low && energy < m_high ) ) return -1;
+
+  int nBins = m_content.size();
+
+  if( m_uniform ){
+
+    int bin = static_cast< int >( ( energy - m_low ) * m_invWidth );
+    return ( bin < nBins ? bin : nBins - 1 );
+  }
+
+  return static_cast< int >( upper_bound( m_edges.begin(), m_edges.end(), energy ) -
+                             m_edges.begin() ) - 1;
+}
+
+GDouble
+PolarizationTable::fraction( GDouble energy ) const {
+
+  int bin = findBin( energy );
+  if( bin < 0 ) return 0;
+
+  if( !m_interpolate || m_content.size() < 2 ) return m_content[bin];
+
+  // interpolate between the centers of this bin and its neighbor on the
+  // side of the energy; the edge half-bins use the nearest two centers
+  GDouble center = 0.5 * ( m_edges[bin] + m_edges[bin+1] );
+  int other = ( energy < center ? bin - 1 : bin + 1 );
+  if( other < 0 ) other = 1;
+  if( other >= (int)m_content.size() ) other = m_content.size() - 2;
+
+  GDouble otherCenter = 0.5 * ( m_edges[other] + m_edges[other+1] );
+
+  return m_content[bin] + ( m_content[other] - m_content[bin] ) *
+    ( energy - center ) / ( otherCenter - center );
+}
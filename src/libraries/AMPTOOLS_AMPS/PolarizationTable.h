@@ -0,0 +1,64 @@
+#if !defined(POLARIZATIONTABLE)
+#define POLARIZATIONTABLE
+
+#include <string>
+#include <vector>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+using namespace std;
+
+// The beam polarization fraction as a function of beam energy, read once
+// from a histogram in a ROOT file.  Tables are shared: every amplitude that
+// asks for the same file and histogram gets the same immutable object, so a
+// fit with many amplitude instances keeps a single copy and the file is
+// opened only once.
+//
+// The lookup returns the content of the bin that contains the energy, and
+// zero outside of the histogram range, which is how the amplitudes used the
+// histogram directly.  For histograms with uniform bins the bin is found
+// with one multiply; variable bins fall back to a binary search.  When the
+// table is created with interpolate = true the values are interpolated
+// linearly between bin centers instead.
+
+class PolarizationTable
+{
+
+public:
+
+  /**
+   * Return the shared table for histogram histName in fileName, loading
+   * it on the first call.  The returned table lives until the end of the
+   * job.
+   */
+  static const PolarizationTable* get( const string& fileName, const string& histName,
+                                       bool interpolate = false );
+
+  GDouble fraction( GDouble energy ) const;
+
+  const string& name() const { return m_name; }
+
+private:
+
+  PolarizationTable( const string& fileName, const string& histName, bool interpolate );
+
+  // tables are shared and never copied
+  PolarizationTable( const PolarizationTable& );
+  PolarizationTable& operator=( const PolarizationTable& );
+
+  int findBin( GDouble energy ) const;
+
+  string m_name;
+  bool m_interpolate;
+  bool m_uniform;
+
+  GDouble m_low;
+  GDouble m_high;
+  GDouble m_invWidth;
+
+  // m_edges has one more entry than m_content
+  vector< GDouble > m_edges;
+  vector< GDouble > m_content;
+};
+
+#endif
@@ -0,0 +1,175 @@
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+#include "AMPTOOLS_AMPS/PrimakoffTable.h"
+#include "AMPTOOLS_AMPS/SharedResources.h"
+
+static const double kHbarc = 0.19733;      // GeV*fm
+
+// the number of points is doubled at most this many times
+static const int kMaxRefinements = 20;
+
+const PrimakoffTable*
+PrimakoffTable::get( double R0, double a0, double mtMax, double tolerance ){
+
+  static SharedResources< PrimakoffTable > tables;
+
+  ostringstream key;
+  key.precision( 17 );
+  key << R0 << ":" << a0 << ":" << mtMax << ":" << tolerance;
+
+  return tables.get( key.str(), [&](){
+
+    return new PrimakoffTable( R0, a0, mtMax, tolerance );
+  } );
+}
+
+PrimakoffTable::PrimakoffTable( double R0, double a0, double mtMax, double tolerance ) :
+  m_R0( R0 ),
+  m_a0( a0 ),
+  m_qMax( sqrt( mtMax ) / kHbarc )
+{
+  if( !( R0 > 0 && a0 > 0 && mtMax > 0 && tolerance > 0 ) ){
+
+    cout << "PrimakoffTable ERROR:  invalid parameters R0 = " << R0 << " a0 = " << a0
+         << " mtMax = " << mtMax << " tolerance = " << tolerance << endl;
+    assert( false );
+  }
+
+  m_sum = 0;
+  int jmax = 4;
+  for( int j = 1; j < jmax; j++ ){                 // truncate after 3 terms, first term dominates.
+    m_sum += pow( -1., j - 1 ) * exp( -j * R0 / a0 ) / ( j * j * j );
+  }
+
+  m_rho0 = ( 4 * PI * R0 / 3 ) * ( PI * a0 * PI * a0 + R0 * R0 + 8 * PI * a0 * a0 * a0 * m_sum );
+  m_rho0 = 1 / m_rho0;
+
+  // the form factor is normalized to one at q = 0, where the expression
+  // itself is 0/0
+  int nIntervals = 64;
+  double maxError = 0;
+
+  for( int i = 0; i <= kMaxRefinements; ++i, nIntervals *= 2 ){
+
+    m_values.resize( nIntervals + 1 );
+    m_invStep = nIntervals / m_qMax;
+
+    m_values[0] = 1;
+    for( int k = 1; k <= nIntervals; ++k ) m_values[k] = formFactorQ( k / m_invStep );
+
+    maxError = 0;
+    for( int k = 0; k < nIntervals; ++k ){
+
+      double q = ( k + 0.5 ) / m_invStep;
+      double error = fabs( interpolate( q ) - formFactorQ( q ) );
+      if( error > maxError ) maxError = error;
+    }
+
+    if( maxError < tolerance ) break;
+  }
+
+  if( maxError >= tolerance ){
+
+    cout << "PrimakoffTable WARNING:  the form factor table reaches an error of "
+         << maxError << " > " << tolerance << endl;
+  }
+
+  cout << "PrimakoffTable:  tabulated the form factor for R0 = " << R0 << " fm, a0 = " << a0
+       << " fm at " << m_values.size() << " points up to -t = " << mtMax << " GeV^2" << endl;
+}
+
+double
+PrimakoffTable::formFactorQ( double q ) const {
+
+  // See Journall of Research of the National Bureau of Standards - B Mathenatics and Mathematical Physics
+  // Vol. 70B, No. 1, Jan-Mar 1966. "The Form Factor of the Fermi Model Spatial Distribution," by Maximon and Schrack
+  double R0 = m_R0;
+  double a0 = m_a0;
+
+  return ( 4 * PI * PI * m_rho0 * a0 * a0 * a0 ) / ( q * q * a0 * a0 * sinh( PI * q * a0 ) * sinh( PI * q * a0 ) )
+    * ( PI * q * a0 * cosh( PI * q * a0 ) * sin( q * R0 ) - q * R0 * cos( q * R0 ) * sinh( PI * q * a0 ) )
+    + 8 * PI * m_rho0 * a0 * a0 * a0 * m_sum;
+}
+
+double
+PrimakoffTable::interpolate( double q ) const {
+
+  double u = q * m_invStep;
+  int k = (int)u;
+  if( k >= (int)m_values.size() - 1 ) k = m_values.size() - 2;
+
+  double f = u - k;
+  return ( 1 - f ) * m_values[k] + f * m_values[k+1];
+}
+
+double
+PrimakoffTable::formFactorExact( double mt ) const {
+
+  // Note that q is the 3-vector momentum, but for low -t, q ~ sqrt(-t).
+  return formFactorQ( sqrt( mt ) / kHbarc );
+}
+
+double
+PrimakoffTable::formFactor( double mt ) const {
+
+  double q = sqrt( mt ) / kHbarc;
+
+  if( !( q >= 0 && q <= m_qMax ) ) return formFactorQ( q );
+  return interpolate( q );
+}
+
+double
+PrimakoffTable::sigmat( double mt, double W, double Eg ) const {
+
+  // return the cross section for Primakoff production of pi+pi-. CPP proposal PR12-13-008 Eq 8.
+
+  // constants
+  double alpha = 1/137.;
+  double betapipi = 0.999;      // beta=0.999 (W=0.3), beta=0.997 (W=0.4), beta= 0.986 (W=1.0 GeV)
+  double Z = 82;                // Z of Pb, target
+  double coef = 4*alpha*Z*Z/(PI);
+
+  double t = -mt;
+
+  double FF = formFactor( mt );
+
+  double m1 = 0;                // mass of photon, incident beam
+  double m2 = 208.*0.931494;    // use Pb mass because it is in the particle list
+  double m3 = W;                // mass of 2pi system, scattered system
+  double m4 = m2;               // recoil target
+
+  double s = m2*m2 + 2*Eg*m2;
+  if (s < 0) {
+    cout << "*** sigma_func: s =" << s << " < 0!" << endl;
+    return 0;
+  }
+  double sqrts = sqrt(s);
+
+  double E1cm = (s+m1*m1-m2*m2)/(2*sqrts);
+  double E3cm = (s+m3*m3-m4*m4)/(2*sqrts);
+
+  double p1cm = E1cm*E1cm - m1*m1? sqrt(E1cm*E1cm - m1*m1) : 0;
+  double p3cm = E3cm*E3cm - m3*m3? sqrt(E3cm*E3cm - m3*m3) : 0;
+
+  double arg = (m1*m1-m3*m3-m2*m2+m4*m4)/(2*sqrts);
+  double t0 = arg*arg - (p1cm - p3cm)*(p1cm - p3cm);
+
+  double betastar = Eg/(Eg + m2);
+  double gammastar = (Eg + m2)/sqrts;
+  double betapipicm = p3cm/E3cm;
+
+  double conv = 1./(gammastar*(1 + betastar/betapipicm));
+
+  if (-t > -t0) {
+    return (coef/2)* Eg*Eg*Eg*Eg * (t0-t)* betapipi*betapipi * (FF*FF/(t*t))*conv*conv*conv*conv/(p1cm*p3cm*p1cm*p3cm);
+  }
+
+  return 0;
+}
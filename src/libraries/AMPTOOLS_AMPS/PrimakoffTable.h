@@ -0,0 +1,71 @@
+#if !defined(PRIMAKOFFTABLE)
+#define PRIMAKOFFTABLE
+
+#include <vector>
+
+using namespace std;
+
+// The Primakoff cross section sigma(t; W, E_gamma) of pi pi production on a
+// nucleus (CPP proposal PR12-13-008 Eq 8) with the nuclear form factor of a
+// two parameter Fermi distribution (Maximon and Schrack, J. Res. NBS 70B
+// (1966)).  The form factor only depends on the momentum transfer and the
+// fixed nuclear parameters, so it is tabulated once in q = sqrt(-t)/hbarc and
+// interpolated linearly; the rest of the cross section is closed-form
+// kinematics in (W, E_gamma).
+//
+// The table is refined by doubling the number of points until the
+// interpolation error, measured at the midpoints of all intervals, is below
+// the requested absolute tolerance (the form factor is one at t = 0).
+// Momentum transfers beyond the table are computed directly.  Tables are
+// shared like PolarizationTable: every amplitude that asks for the same
+// nuclear parameters gets the same immutable object.
+
+class PrimakoffTable
+{
+
+public:
+
+  /**
+   * Return the shared table for the half-density radius R0 and diffuseness
+   * a0 (both in fm), tabulated for -t up to mtMax (GeV^2), creating it on
+   * the first call.  The returned table lives until the end of the job.
+   */
+  static const PrimakoffTable* get( double R0, double a0, double mtMax = 1.,
+                                    double tolerance = 1e-6 );
+
+  // the form factor for the momentum transfer -t = mt > 0 (GeV^2)
+  double formFactor( double mt ) const;
+
+  // the form factor computed without the table
+  double formFactorExact( double mt ) const;
+
+  /**
+   * The cross section for -t = mt (GeV^2), the pi pi mass W and the beam
+   * energy Eg (GeV); zero below the kinematic limit -t0.
+   */
+  double sigmat( double mt, double W, double Eg ) const;
+
+private:
+
+  PrimakoffTable( double R0, double a0, double mtMax, double tolerance );
+
+  // tables are shared and never copied
+  PrimakoffTable( const PrimakoffTable& );
+  PrimakoffTable& operator=( const PrimakoffTable& );
+
+  double formFactorQ( double q ) const;
+  double interpolate( double q ) const;
+
+  double m_R0;
+  double m_a0;
+
+  // the normalization and the series of the Fermi distribution
+  double m_rho0;
+  double m_sum;
+
+  double m_qMax;
+  double m_invStep;
+  vector< double > m_values;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#if !defined(PROFILEDAMPLITUDE)
+#define PROFILEDAMPLITUDE
+
+#include <complex>
+#include <string>
+#include <vector>
+
+#include "IUAmpTools/Amplitude.h"
+#include "GPUManager/GPUCustomTypes.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+using std::complex;
+using namespace std;
+
+// An amplitude A with the calls that the framework makes to it timed by
+// AmplitudeProfiler.  It has the name of A, so registering
+//
+//   AmpToolsInterface::registerAmplitude( ProfiledAmplitude< BreitWigner >() );
+//
+// in place of BreitWigner() profiles every BreitWigner of a configuration
+// without changes to the configuration file.  calcUserVars, calcAmplitude
+// and launchGPUKernel are timed; a kernel launch waits for the GPU so that
+// its time includes the kernel.  Kernels that evaluate several instances at
+// once (the waves of Vec_ps_refl) count for the instance that launches them.
+
+namespace profiledAmplitudeDetail {
+
+  // true if A itself declares calcAmplitude( pKin, userVars ); amplitudes
+  // that only declare calcAmplitude( pKin ) hide the other overload
+  template< class A >
+  struct declaresUserVarsAmplitude {
+
+    template< class U, complex< GDouble > (U::*)( GDouble**, GDouble* ) const >
+    struct Check;
+
+    template< class U >
+    static char test( Check< U, &U::calcAmplitude >* );
+
+    template< class U >
+    static long test( ... );
+
+    static const bool value = ( sizeof( test< A >( 0 ) ) == 1 );
+  };
+
+  template< bool declared > struct Dispatch;
+
+  template<>
+  struct Dispatch< true > {
+
+    template< class A >
+    static complex< GDouble > calc( const A& amp, GDouble** pKin, GDouble* userVars ){
+
+      return amp.A::calcAmplitude( pKin, userVars );
+    }
+  };
+
+  template<>
+  struct Dispatch< false > {
+
+    // the base class forwards to calcAmplitude( pKin )
+    template< class A >
+    static complex< GDouble > calc( const A& amp, GDouble** pKin, GDouble* userVars ){
+
+      return amp.Amplitude::calcAmplitude( pKin, userVars );
+    }
+  };
+}
+
+template< class A >
+class ProfiledAmplitude : public A
+{
+
+public:
+
+  ProfiledAmplitude() : A(), m_entry( NULL ) {}
+
+  ProfiledAmplitude( const vector< string >& args ) :
+    A( args ),
+    m_entry( AmplitudeProfiler::entry( A::name(), instanceName( args ) ) ) {}
+
+  Amplitude* newAmplitude( const vector< string >& args ) const {
+
+    return new ProfiledAmplitude< A >( args );
+  }
+
+  Amplitude* clone() const {
+
+    return ( this->isDefault() ? new ProfiledAmplitude< A >() :
+             new ProfiledAmplitude< A >( *this ) );
+  }
+
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+    AmplitudeTimer timer( entry(), AmplitudeProfiler::kAmplitude );
+    return profiledAmplitudeDetail::Dispatch<
+      profiledAmplitudeDetail::declaresUserVarsAmplitude< A >::value >::template calc< A >( *this, pKin, userVars );
+  }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const {
+
+    AmplitudeTimer timer( entry(), AmplitudeProfiler::kUserVars );
+    A::calcUserVars( pKin, userVars );
+  }
+
+#ifdef GPU_ACCELERATION
+
+  void launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const {
+
+    AmplitudeTimer timer( entry(), AmplitudeProfiler::kGPUKernel );
+    A::launchGPUKernel( dimGrid, dimBlock, GPU_AMP_ARGS );
+    AmplitudeProfiler::synchronizeGPU();
+  }
+
+#endif // GPU_ACCELERATION
+
+private:
+
+  static string instanceName( const vector< string >& args ){
+
+    string name;
+    for( unsigned int i = 0; i < args.size(); ++i ) name += ( i ? " " : "" ) + args[i];
+    return name;
+  }
+
+  // the default instance is only used to make the others
+  AmplitudeProfiler::Entry* entry() const {
+
+    if( m_entry == NULL ) m_entry = AmplitudeProfiler::entry( A::name(), "" );
+    return m_entry;
+  }
+
+  mutable AmplitudeProfiler::Entry* m_entry;
+};
+
+#endif
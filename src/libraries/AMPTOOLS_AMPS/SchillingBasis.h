@@ -0,0 +1,83 @@
+#if !defined(SCHILLINGBASIS)
+#define SCHILLINGBASIS
+
+#include <cmath>
+
+// The decay distribution of a vector meson of K. Schilling et al. is
+// linear in the nine spin density matrix elements, in the order
+//
+//   rho000, rho100, rho1m10, rho111, rho001, rho101, rho1m11, rho102, rho1m12
+//
+// so that W = basis[0] + sum_i rho_i basis[i+1] with angular functions
+// that only depend on the event.  The amplitudes keep the basis in their
+// user variables and the likelihood is one dot product per event (see
+// LinearAmplitude.h).  These are shared by TwoPiAngles and
+// ThreePiAnglesSchilling; T is the real type.
+//
+// Phi is the angle between the polarization and the production plane.  A
+// rotation of the polarization by alpha is
+//
+//   W( Phi + alpha ) = unpolarized + cos(2 alpha) polarized( Phi )
+//                                  + sin(2 alpha) polarized( Phi + pi/4 )
+//
+// so a free polarization angle needs the polarized part of the basis at
+// Phi + pi/4 as well.
+
+#define SCHILLING_FUNC inline
+
+enum { kSchillingNumRho = 9, kSchillingNumBasis = kSchillingNumRho + 1,
+       kSchillingNumUnpolarized = 4,
+       kSchillingNumPolarized = kSchillingNumBasis - kSchillingNumUnpolarized };
+
+// basis[0] ... basis[3]:  the constant and the rho000, rho100 and rho1m10
+// terms; basis[4] ... basis[9]:  the polarized terms, weighted by Pgamma
+template< class T >
+SCHILLING_FUNC void
+schillingBasis( T cosTheta, T phi, T Pgamma, T bigPhi, T* basis ){
+
+  const T sqrt2 = 1.4142135623730951;
+  const T norm = 3. / ( 4. * 3.14159265358979323846 );
+
+  T cosSqTheta = cosTheta * cosTheta;
+  T sinSqTheta = T(1) - cosSqTheta;
+  // sin( 2 theta ) with sin theta >= 0
+  T sin2Theta = T(2) * cosTheta * sqrt( sinSqTheta > T(0) ? sinSqTheta : T(0) );
+
+  T cosPhi = cos( phi ), sinPhi = sin( phi );
+  T cos2Phi = cos( T(2) * phi ), sin2Phi = sin( T(2) * phi );
+  T polCos = Pgamma * cos( T(2) * bigPhi );
+  T polSin = Pgamma * sin( T(2) * bigPhi );
+
+  basis[0] = norm * T(0.5) * sinSqTheta;
+  basis[1] = norm * ( T(1.5) * cosSqTheta - T(0.5) );
+  basis[2] = -norm * sqrt2 * sin2Theta * cosPhi;
+  basis[3] = -norm * sinSqTheta * cos2Phi;
+
+  basis[4] = -norm * polCos * sinSqTheta;
+  basis[5] = -norm * polCos * cosSqTheta;
+  basis[6] = norm * polCos * sqrt2 * sin2Theta * cosPhi;
+  basis[7] = norm * polCos * sinSqTheta * cos2Phi;
+  basis[8] = -norm * polSin * sqrt2 * sin2Theta * sinPhi;
+  basis[9] = -norm * polSin * sinSqTheta * sin2Phi;
+}
+
+// With the polarization rotated by alpha the user variables are the basis
+// and its polarized part at Phi + pi/4, and W is linear (LinearAmplitude.h)
+// in these kSchillingNumRotated parameters
+enum { kSchillingNumRotated = kSchillingNumRho + kSchillingNumPolarized };
+
+template< class T, class R >
+SCHILLING_FUNC void
+schillingRotatedParameters( const R* rho, T cos2Alpha, T sin2Alpha, T* p ){
+
+  for( int i = 0; i < kSchillingNumUnpolarized - 1; ++i ) p[i] = rho[i];
+
+  for( int i = 0; i < kSchillingNumPolarized; ++i ){
+
+    T r = rho[kSchillingNumUnpolarized - 1 + i];
+    p[kSchillingNumUnpolarized - 1 + i] = cos2Alpha * r;
+    p[kSchillingNumRho + i] = sin2Alpha * r;
+  }
+}
+
+#endif
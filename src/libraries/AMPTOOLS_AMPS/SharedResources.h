@@ -0,0 +1,59 @@
+#if !defined(SHAREDRESOURCES)
+#define SHAREDRESOURCES
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+// The objects of a class that are loaded once per key and shared by all
+// amplitudes for the life of the job:  the polarization tables, the
+// histograms of Grid2D, the model tables.  The map is only locked to find
+// the entry of a key, and the object is loaded under the lock of its
+// entry, so objects with different keys load at the same time on
+// different threads (see AmplitudeRegistry::loadShared) while a second
+// caller of the same key waits for the first.
+
+template< class T >
+class SharedResources
+{
+
+public:
+
+  /**
+   * Returns the object of key, calling load to make it on the first call.
+   */
+  const T* get( const string& key, const function< const T*() >& load ){
+
+    shared_ptr< Entry > entry;
+    {
+      lock_guard< mutex > lock( m_mutex );
+
+      shared_ptr< Entry >& slot = m_entries[key];
+      if( !slot ) slot.reset( new Entry() );
+      entry = slot;
+    }
+
+    call_once( entry->loaded, [&](){ entry->value = load(); } );
+
+    return entry->value;
+  }
+
+private:
+
+  struct Entry {
+
+    Entry() : value( NULL ) {}
+
+    once_flag loaded;
+    const T* value;
+  };
+
+  map< string, shared_ptr< Entry > > m_entries;
+  mutex m_mutex;
+};
+
+#endif
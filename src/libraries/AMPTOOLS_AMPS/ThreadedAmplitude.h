@@ -0,0 +1,199 @@
+#if !defined(THREADEDAMPLITUDE)
+#define THREADEDAMPLITUDE
+
+#include <algorithm>
+#include <complex>
+#include <string>
+#include <vector>
+
+#include "IUAmpTools/Amplitude.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "GPUManager/GPUCustomTypes.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeBatch.h"
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+#include "AMPTOOLS_AMPS/PermutationUserVars.h"
+
+using std::complex;
+using namespace std;
+
+// An amplitude A whose user variables and amplitudes are computed for the
+// events of a process on the threads of AmplitudeThreads.  It has the name
+// of A, so registering
+//
+//   AmpToolsInterface::registerAmplitude( ThreadedAmplitude< BreitWigner >() );
+//
+// in place of BreitWigner() threads every BreitWigner of a configuration.
+// calcAmplitudeAll and calcUserVarsAll run the loop of the framework over
+// events and permutations with the same layout of the arrays:  the four-
+// vectors of particle j of event i at pdData[4*(nEvents*j + i)], the user
+// variables of permutation p of event i at pdUserVars[numUserVars()*
+// (nEvents*p + i)] and the amplitude at pdAmps[2*(nEvents*p + i)].
+// The amplitudes of a thread are computed in blocks of events of one
+// permutation with calcAmplitudeBlock, so that an amplitude with a
+// calcAmplitudeBatch evaluates a block in one call (see AmplitudeBatch.h).
+//
+// calcAmplitude and calcUserVars of A must be safe to call from several
+// threads at once.  Amplitudes that ask for getCurrentPermutation()
+// (ThreePiAngles, b1piAngAmp) are not:  the permutation is a single member
+// of the amplitude.  The sums of the intensities over the events are done
+// by the framework and are not threaded.  On the GPU this is A itself.
+
+template< class A >
+class ThreadedAmplitude : public A
+{
+
+public:
+
+  ThreadedAmplitude() : A() {}
+
+  ThreadedAmplitude( const vector< string >& args ) : A( args ) {}
+
+  Amplitude* newAmplitude( const vector< string >& args ) const {
+
+    return new ThreadedAmplitude< A >( args );
+  }
+
+  Amplitude* clone() const {
+
+    return ( this->isDefault() ? new ThreadedAmplitude< A >() :
+             new ThreadedAmplitude< A >( *this ) );
+  }
+
+#ifndef GPU_ACCELERATION
+
+  void calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+                         const vector< vector< int > >* pvPermutations,
+                         GDouble* pdUserVars ) const {
+
+    // an amplitude that does not depend on the event is computed once for
+    // the first event and copied (see AmplitudeBatch.h)
+    if( iNEvents > 0 && !pvPermutations->empty() &&
+        isEventIndependent( static_cast< const A& >( *this ) ) ){
+
+      const Amplitude& amp = *this;
+      unsigned int numVars = amp.numUserVars();
+      vector< GDouble* > pKin( (*pvPermutations)[0].size(), (GDouble*)NULL );
+
+      setKinematics( pKin.data(), pdData, iNEvents, (*pvPermutations)[0], 0 );
+
+      complex< GDouble > value = ( numVars != 0 ?
+        amp.calcAmplitude( &( pKin[0] ), pdUserVars ) :
+        amp.calcAmplitude( &( pKin[0] ) ) );
+
+      int nAmps = iNEvents * pvPermutations->size();
+      for( int i = 0; i < nAmps; ++i ){
+
+        pdAmps[2 * i] = value.real();
+        pdAmps[2 * i + 1] = value.imag();
+      }
+      return;
+    }
+
+    // before the first writes, which place the pages (see AmplitudeThreads)
+    size_t nValues = (size_t)iNEvents * pvPermutations->size();
+    AmplitudeThreads::adviseHugePages( pdAmps, 2 * sizeof( GDouble ) * nValues );
+
+    AmplitudeThreads::run( iNEvents, [&]( int begin, int end ){
+
+      const A& self = *this;
+      const Amplitude& amp = *this;
+      unsigned int numVars = amp.numUserVars();
+      int nPermutations = pvPermutations->size();
+      int nParticles = ( nPermutations ? (*pvPermutations)[0].size() : 0 );
+
+      // the pKin arrays of the events of a block
+      vector< GDouble* > kin( nParticles * kAmplitudeBlock + 1, (GDouble*)NULL );
+      vector< GDouble** > pKin( kAmplitudeBlock );
+      for( int i = 0; i < kAmplitudeBlock; ++i ) pKin[i] = &( kin[nParticles * i] );
+
+      for( int iPerm = 0; iPerm < nPermutations; ++iPerm ){
+        for( int first = begin; first < end; first += kAmplitudeBlock ){
+
+          int nBlock = min( (int)kAmplitudeBlock, end - first );
+          for( int i = 0; i < nBlock; ++i )
+            setKinematics( pKin[i], pdData, iNEvents, (*pvPermutations)[iPerm], first + i );
+
+          // complex< GDouble > has the layout of the real and imaginary parts in pdAmps
+          size_t index = (size_t)iNEvents * iPerm + first;
+          calcAmplitudeBlock( self, &( pKin[0] ), pdUserVars + numVars * index, nBlock,
+                              reinterpret_cast< complex< GDouble >* >( pdAmps + 2 * index ) );
+        }
+      }
+    } );
+  }
+
+  // The user variables are computed once when a fit starts, for all events
+  // of the data and the MC.  Their cost depends on the event (the boosts of
+  // Vec_ps_refl and omegapi_amplitude, the tables of Zlm), so the threads
+  // take chunks of events as they finish the last one, unless they are
+  // pinned:  then each writes the user variables it reads later.  The
+  // permutations that share the user variables of an earlier one (see
+  // PermutationUserVars.h) are copied at the end.
+  void calcUserVarsAll( GDouble* pdData, GDouble* pdUserVars, int iNEvents,
+                        const vector< vector< int > >* pvPermutations ) const {
+
+    const A& self = *this;
+    vector< int > source = ( pdData == NULL ? vector< int >() :
+                             PermutationUserVars::sources( self, *pvPermutations ) );
+
+    if( !pvPermutations->empty() ){
+
+      const Amplitude& amp = *this;
+      size_t nValues = (size_t)iNEvents * pvPermutations->size();
+      AmplitudeThreads::adviseHugePages( pdUserVars, amp.numUserVars() * sizeof( GDouble ) * nValues );
+      AmplitudeThreads::adviseHugePages( pdData, 4 * sizeof( GDouble ) * iNEvents *
+                                         (*pvPermutations)[0].size() );
+    }
+
+    AmplitudeThreads::runChunks( iNEvents, kUserVarsChunk, [&]( int begin, int end ){
+
+      const Amplitude& amp = *this;
+      unsigned int numVars = amp.numUserVars();
+      int nPermutations = pvPermutations->size();
+      int nParticles = ( nPermutations ? (*pvPermutations)[0].size() : 0 );
+      vector< GDouble* > pKin( nParticles, (GDouble*)NULL );
+
+      for( int iEvent = begin; iEvent < end; ++iEvent ){
+        for( int iPerm = 0; iPerm < nPermutations; ++iPerm ){
+
+          if( !source.empty() && source[iPerm] != iPerm ) continue;
+
+          setKinematics( pKin.data(), pdData, iNEvents, (*pvPermutations)[iPerm], iEvent );
+          amp.calcUserVars( &( pKin[0] ), &( pdUserVars[numVars * ( iNEvents * iPerm + iEvent )] ) );
+        }
+      }
+    } );
+
+    const Amplitude& amp = *this;
+    if( !source.empty() )
+      PermutationUserVars::copy( source, pdUserVars, amp.numUserVars(), iNEvents );
+  }
+
+#endif // GPU_ACCELERATION
+
+private:
+
+  enum { kUserVarsChunk = 128, kAmplitudeBlock = 256 };
+
+  // the data may be gone once all user variables are static
+  static void setKinematics( GDouble** pKin, GDouble* pdData, int iNEvents,
+                             const vector< int >& permutation, int iEvent ){
+
+    for( unsigned int i = 0; i < permutation.size(); ++i )
+      pKin[i] = ( pdData == NULL ? NULL : &( pdData[4 * ( iNEvents * permutation[i] + iEvent )] ) );
+  }
+};
+
+// Registers A, as ThreadedAmplitude< A > if AmplitudeThreads has more
+// than one thread, so that a program can thread with an option.
+template< class A >
+void registerThreadedAmplitude(){
+
+  if( AmplitudeThreads::numThreads() > 1 )
+    AmpToolsInterface::registerAmplitude( ThreadedAmplitude< A >() );
+  else
+    AmpToolsInterface::registerAmplitude( A() );
+}
+
+#endif
@@ -11,10 +11,17 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
 
 
+void
+ThreePiAnglesSchilling::loadShared( const vector< string >& args ){
+
+	if( args.size() == 13 ) PolarizationTable::get( args[11], args[12] );
+}
+
 ThreePiAnglesSchilling::ThreePiAnglesSchilling( const vector< string >& args ) :
     UserAmplitude< ThreePiAnglesSchilling >( args )
 {
@@ -49,9 +56,7 @@ ThreePiAnglesSchilling::ThreePiAnglesSchilling( const vector< string >& args ) :
 		polInTree = false;
 		polAngle = atof( args[9].c_str() );	
 		polFraction = 0.;
-		TFile* f = new TFile( args[11].c_str() );
-        polFrac_vs_E = (TH1D*)f->Get( args[12].c_str() );
-        assert( polFrac_vs_E != NULL );
+		polFrac_vs_E = PolarizationTable::get( args[11], args[12] );
 	}
 
     // need to register any free parameters so the framework knows about them
@@ -70,8 +75,8 @@ ThreePiAnglesSchilling::ThreePiAnglesSchilling( const vector< string >& args ) :
     //registerParameter( polAngle );
 }
 
-complex< GDouble >
-ThreePiAnglesSchilling::calcAmplitude( GDouble** pKin ) const 
+void
+ThreePiAnglesSchilling::calcUserVars( GDouble** pKin, GDouble* userVars ) const 
 {
 
 	TLorentzVector beam;
@@ -112,10 +117,6 @@ ThreePiAnglesSchilling::calcAmplitude( GDouble** pKin ) const
           norm.Dot(z) );
 
     GDouble cosTheta = angles.CosTheta();
-    GDouble cosSqTheta = cosTheta*cosTheta;
-    GDouble sin2Theta = sin(2.*angles.Theta());
-    GDouble sinSqTheta = 1. - cosSqTheta;
-
     GDouble phi = angles.Phi();
 
     GDouble Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
@@ -128,24 +129,39 @@ ThreePiAnglesSchilling::calcAmplitude( GDouble** pKin ) const
 		if(polFraction > 0.) { // for fitting with constant polarization 
 			Pgamma = polFraction;
 		} else{
-			int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-			if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-				Pgamma = 0.;
-			} else 
-				Pgamma = polFrac_vs_E->GetBinContent(bin);
+			Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
 		}
 	}
 
-    // vector meson production from K. Schilling et. al.
+    schillingBasis( cosTheta, phi, Pgamma, Phi, userVars + kBasis );
+}
 
-    GDouble W = 0.5*(1. - rho000) + 0.5*(3.*rho000 - 1.)*cosTheta*cosTheta - sqrt(2.)*rho100*sin2Theta*cos(phi) - rho1m10*sinSqTheta*cos(2.*phi);
+complex< GDouble >
+ThreePiAnglesSchilling::calcAmplitude( GDouble** pKin, GDouble* userVars ) const 
+{
+    // vector meson production from K. Schilling et. al.
+    GDouble rho[kSchillingNumRho];
+    parameters( rho );
 
-    W -= Pgamma*cos(2.*Phi) * (rho111*sinSqTheta + rho001*cosTheta*cosTheta - sqrt(2.)*rho101*sin2Theta*cos(phi) - rho1m11*sinSqTheta*cos(2.*phi));
+    GDouble W = linearIntensity< kSchillingNumRho >( userVars + kBasis, rho );
 
-    W -= Pgamma*sin(2.*Phi) * (sqrt(2.)*rho102*sin2Theta*sin(phi) + rho1m12*sinSqTheta*sin(2.*phi));
+    return complex< GDouble > ( sqrt(fabs(W)) );
+}
 
-    W *= 3./(4.*PI);
+void
+ThreePiAnglesSchilling::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                            int nEvents, complex< GDouble >* amps ) const
+{
+    GDouble rho[kSchillingNumRho];
+    parameters( rho );
 
-    return complex< GDouble > ( sqrt(fabs(W)) );
+    linearAmplitudeBatch< kSchillingNumRho >( rho, userVars + kBasis, kNumUserVars, nEvents, amps );
 }
 
+void
+ThreePiAnglesSchilling::parameters( GDouble* rho ) const
+{
+    rho[0] = rho000;  rho[1] = rho100;  rho[2] = rho1m10;
+    rho[3] = rho111;  rho[4] = rho001;  rho[5] = rho101;  rho[6] = rho1m11;
+    rho[7] = rho102;  rho[8] = rho1m12;
+}
@@ -6,7 +6,9 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_AMPS/SchillingBasis.h"
+#include "AMPTOOLS_AMPS/LinearAmplitude.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -32,8 +34,27 @@ public:
 	ThreePiAnglesSchilling( const vector< string >& args );
 	
 	string name() const { return "ThreePiAnglesSchilling"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	// the angular functions of W, see SchillingBasis.h
+	enum UserVars { kBasis = 0, kNumUserVars = kBasis + kSchillingNumBasis };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	// evaluates a block of events in one call (see AmplitudeBatch.h), W
+	// is linear in the spin density matrix elements (LinearAmplitude.h)
+	void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+	                         int nEvents, complex< GDouble >* amps ) const;
+
+	// the spin density matrix elements are the only free parameters and W
+	// is linear in them, so everything else is computed once in the
+	// userVars block
+	bool needsUserVarsOnly() const { return true; }
 	
 #ifdef GPU_ACCELERATION
   
@@ -45,6 +66,9 @@ public:
   
 private:
 
+  // the spin density matrix elements in the order of SchillingBasis.h
+  void parameters( GDouble* rho ) const;
+
   AmpParameter rho000;
   AmpParameter rho100;
   AmpParameter rho1m10;
@@ -60,7 +84,7 @@ private:
 	GDouble polAngle;
 	GDouble polFraction;
     bool polInTree;
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E;
 
 };
 
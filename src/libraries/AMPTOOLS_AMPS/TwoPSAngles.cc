@@ -12,6 +12,7 @@
 #include "AMPTOOLS_AMPS/TwoPSAngles.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
 
 TwoPSAngles::TwoPSAngles( const vector< string >& args ) :
 UserAmplitude< TwoPSAngles >( args )
@@ -35,32 +36,21 @@ UserAmplitude< TwoPSAngles >( args )
 }
 
 
-complex< GDouble >
-TwoPSAngles::calcAmplitude( GDouble** pKin ) const {
-  
-  TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
-  TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
-  TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] ); 
-  TLorentzVector p2     ( pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0] ); 
-  
-  TLorentzVector resonance = p1 + p2;
-  
-  TLorentzRotation resRestBoost( -resonance.BoostVector() );
-  
-  TLorentzVector beam_res   = resRestBoost * beam;
-  TLorentzVector recoil_res = resRestBoost * recoil;
-  TLorentzVector p1_res = resRestBoost * p1;
-  
-  TVector3 z = beam_res.Vect().Unit();
-  TVector3 y = recoil_res.Vect().Cross(z).Unit();
-  TVector3 x = y.Cross(z);
+void
+TwoPSAngles::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
-  TVector3 angles( (p1_res.Vect()).Dot(x),
-                   (p1_res.Vect()).Dot(y),
-                   (p1_res.Vect()).Dot(z) );
+  GDouble cosTheta, phi;
+  twoBodyAngles( kGottfriedJackson, pKin[0], pKin[1], pKin[2], pKin[3], cosTheta, phi );
+
+  userVars[kCosTheta] = cosTheta;
+  userVars[kPhi] = phi;
+}
+
+complex< GDouble >
+TwoPSAngles::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
   
-  GDouble cosTheta = angles.CosTheta();
-  GDouble phi = angles.Phi();
+  GDouble cosTheta = userVars[kCosTheta];
+  GDouble phi = userVars[kPhi];
   
   GDouble coef = sqrt( ( 2. * m_j + 1 ) / ( 4 * 3.1416 ) );
   
@@ -39,7 +39,21 @@ public:
 	
 	string name() const { return "TwoPSAngles"; }
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the Gottfried-Jackson angles are the same for all instances of this
+	// amplitude
+	enum UserVars { kCosTheta = 0, kPhi, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool areUserVarsStatic() const { return true; }
+
+	// the GPU kernel computes the angles from the four-vectors
+#ifndef GPU_ACCELERATION
+	bool needsUserVarsOnly() const { return true; }
+#endif
 	
 #ifdef GPU_ACCELERATION
   
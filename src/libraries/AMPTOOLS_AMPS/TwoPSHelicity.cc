@@ -12,6 +12,7 @@
 #include "AMPTOOLS_AMPS/TwoPSHelicity.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
 
 TwoPSHelicity::TwoPSHelicity( const vector< string >& args ) :
 UserAmplitude< TwoPSHelicity >( args )
@@ -35,36 +36,21 @@ UserAmplitude< TwoPSHelicity >( args )
 }
 
 
-complex< GDouble >
-TwoPSHelicity::calcAmplitude( GDouble** pKin ) const {
-  
-  TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
-  TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
-  TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] ); 
-  TLorentzVector p2     ( pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0] ); 
-  
-  TLorentzVector resonance = p1 + p2;
-  
-  TLorentzRotation resRestBoost( -resonance.BoostVector() );
-  
-  TLorentzVector beam_res   = resRestBoost * beam;
-  TLorentzVector recoil_res = resRestBoost * recoil;
-  TLorentzVector p1_res = resRestBoost * p1;
+void
+TwoPSHelicity::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
-  // helicity frame: z-axis is propagation of resonance X => opposite recoil proton in X rest frame
-  TVector3 z = -1. * recoil_res.Vect().Unit();
+  GDouble cosTheta, phi;
+  twoBodyAngles( kHelicity, pKin[0], pKin[1], pKin[2], pKin[3], cosTheta, phi );
 
-  // y axis perpendicular to production plane
-  TVector3 y = beam_res.Vect().Cross(z).Unit();
+  userVars[kCosTheta] = cosTheta;
+  userVars[kPhi] = phi;
+}
 
-  TVector3 x = y.Cross(z);
-  
-  TVector3 angles( (p1_res.Vect()).Dot(x),
-                   (p1_res.Vect()).Dot(y),
-                   (p1_res.Vect()).Dot(z) );
+complex< GDouble >
+TwoPSHelicity::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
   
-  GDouble cosTheta = angles.CosTheta();
-  GDouble phi = angles.Phi();
+  GDouble cosTheta = userVars[kCosTheta];
+  GDouble phi = userVars[kPhi];
   
   GDouble coef = sqrt( ( 2. * m_j + 1 ) / ( 4 * 3.1416 ) );
   
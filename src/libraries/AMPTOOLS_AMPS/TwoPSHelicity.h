@@ -39,7 +39,16 @@ public:
 	
 	string name() const { return "TwoPSHelicity"; }
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the helicity angles are the same for all instances of this amplitude
+	enum UserVars { kCosTheta = 0, kPhi, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
 	
 #ifdef GPU_ACCELERATION
   
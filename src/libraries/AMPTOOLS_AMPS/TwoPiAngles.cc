@@ -11,9 +11,16 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/TwoPiAngles.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
 
+void
+TwoPiAngles::loadShared( const vector< string >& args ){
+
+	if( args.size() == 12 ) PolarizationTable::get( args[10], args[11] );
+}
+
 TwoPiAngles::TwoPiAngles( const vector< string >& args ) :
   UserAmplitude< TwoPiAngles >( args )
 {
@@ -48,6 +55,7 @@ TwoPiAngles::TwoPiAngles( const vector< string >& args ) :
   registerParameter( rho1m12 );
 
   registerParameter( polAngle );
+  updatePar( polAngle );
 
   // Two possibilities to initialize this amplitude:
   // 1: 11 arguments, fixed polarization
@@ -60,10 +68,8 @@ TwoPiAngles::TwoPiAngles( const vector< string >& args ) :
   //    Usage: amplitude <reaction>::<sum>::<ampName> TwoPiAngles <rho000> ... <rho1m12> <polAngle> <rootFile> <hist>
   else if(args.size() == 12) {
     polFraction = 0.; 
-    TFile* f = new TFile( args[10].c_str() );
-    polFrac_vs_E = (TH1D*)f->Get( args[11].c_str() );
-    assert( polFrac_vs_E != NULL );
-    cout << "Fitting with polarization from " << polFrac_vs_E->GetName() << endl;
+    polFrac_vs_E = PolarizationTable::get( args[10], args[11] );
+    cout << "Fitting with polarization from " << polFrac_vs_E->name() << endl;
   }
 }
 
@@ -72,25 +78,36 @@ TwoPiAngles::TwoPiAngles( const vector< string >& args ) :
 complex< GDouble >
 TwoPiAngles::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
 
-  GDouble sinSqTheta = userVars[kSinSqTheta];
-  GDouble sin2Theta = userVars[kSin2Theta];  
-  GDouble cosTheta = userVars[kCosTheta];
-  GDouble phi = userVars[kPhi];
-  GDouble bigPhi = polAngle*0.017453293 + userVars[kBigPhi]; // rotate Phi (in rad)
-  GDouble Pgamma = userVars[kPgamma];
-  
- // vector meson production from K. Schilling et. al.
-  GDouble W = 0.5*(1. - rho000) + 0.5*(3.*rho000 - 1.)*cosTheta*cosTheta - sqrt(2.)*rho100*sin2Theta*cos(phi) - rho1m10*sinSqTheta*cos(2.*phi);
-	
-  W -= Pgamma*cos(2.*bigPhi) * (rho111*sinSqTheta + rho001*cosTheta*cosTheta - sqrt(2.)*rho101*sin2Theta*cos(phi) - rho1m11*sinSqTheta*cos(2.*phi));
-	
-  W -= Pgamma*sin(2.*bigPhi) * (sqrt(2.)*rho102*sin2Theta*sin(phi) + rho1m12*sinSqTheta*sin(2.*phi));
-	
-  W *= 3./(4.*PI);
+  // vector meson production from K. Schilling et. al.
+  GDouble p[kSchillingNumRotated];
+  parameters( p );
+
+  GDouble W = linearIntensity< kSchillingNumRotated >( userVars + kBasis, p );
 
   return complex< GDouble > ( sqrt(fabs(W)) );
 }
 
+void
+TwoPiAngles::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                 int nEvents, complex< GDouble >* amps ) const {
+
+  GDouble p[kSchillingNumRotated];
+  parameters( p );
+
+  linearAmplitudeBatch< kSchillingNumRotated >( p, userVars + kBasis, kNumUserVars, nEvents, amps );
+}
+
+void
+TwoPiAngles::parameters( GDouble* p ) const {
+
+  GDouble rho[kSchillingNumRho] = { rho000, rho100, rho1m10,
+                                    rho111, rho001, rho101, rho1m11,
+                                    rho102, rho1m12 };
+
+  // rotate Phi by the polarization angle
+  schillingRotatedParameters( rho, cos2PolAngle, sin2PolAngle, p );
+}
+
 void
 TwoPiAngles::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
@@ -116,13 +133,11 @@ TwoPiAngles::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 		   (p1_res.Vect()).Dot(y),
 		   (p1_res.Vect()).Dot(z) );
 
-  userVars[kCosTheta]   = angles.CosTheta();
-  userVars[kSinSqTheta] = sin(angles.Theta())*sin(angles.Theta());
-  userVars[kSin2Theta]  = sin(2.*angles.Theta());
-  userVars[kPhi] = angles.Phi();
+  GDouble cosTheta = angles.CosTheta();
+  GDouble phi = angles.Phi();
 
   TVector3 eps(1.0, 0.0, 0.0); // reference beam polarization vector at 0 degrees
-  userVars[kBigPhi] = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
+  GDouble bigPhi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
 	
   // vector meson production from K. Schilling et. al.
   GDouble Pgamma;
@@ -130,13 +145,33 @@ TwoPiAngles::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
     Pgamma = polFraction;
   }
   else{
-    int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-    if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-      Pgamma = 0.;
-    }
-    else Pgamma = polFrac_vs_E->GetBinContent(bin);
+    Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
   }
-  userVars[kPgamma] = Pgamma;
+
+  // the polarized part at 45 degrees is the sin(2 polAngle) term
+  GDouble rotated[kSchillingNumBasis];
+  schillingBasis( cosTheta, phi, Pgamma, bigPhi, userVars + kBasis );
+  schillingBasis( cosTheta, phi, Pgamma, GDouble( bigPhi + 0.25*PI ), rotated );
+  for( int i = 0; i < kSchillingNumPolarized; ++i )
+    userVars[kRotated + i] = rotated[kSchillingNumUnpolarized + i];
+
+#ifdef GPU_ACCELERATION
+  userVars[kPgamma]     = Pgamma;
+  userVars[kCosTheta]   = cosTheta;
+  userVars[kSinSqTheta] = sin(angles.Theta())*sin(angles.Theta());
+  userVars[kSin2Theta]  = sin(2.*angles.Theta());
+  userVars[kBigPhi]     = bigPhi;
+  userVars[kPhi]        = phi;
+#endif
+}
+
+void
+TwoPiAngles::updatePar( const AmpParameter& par ){
+
+  if( par.name() != polAngle.name() ) return;
+
+  cos2PolAngle = cos( 2.*polAngle*0.017453293 );
+  sin2PolAngle = sin( 2.*polAngle*0.017453293 );
 }
 
 #ifdef GPU_ACCELERATION
@@ -6,7 +6,9 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_AMPS/SchillingBasis.h"
+#include "AMPTOOLS_AMPS/LinearAmplitude.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -34,18 +36,40 @@ public:
 	TwoPiAngles() : UserAmplitude< TwoPiAngles >() { };
 	TwoPiAngles( const vector< string >& args );
 
+	// the angular functions of W for the polarization at 0 degrees and
+	// their polarized part at 45 degrees, see SchillingBasis.h; the GPU
+	// kernel computes W from the angles in front of them
+#ifdef GPU_ACCELERATION
 	enum UserVars { kPgamma = 0, kCosTheta, kSinSqTheta, kSin2Theta,
-			kBigPhi, kPhi, kNumUserVars };
+			kBigPhi, kPhi, kBasis,
+#else
+	enum UserVars { kBasis = 0,
+#endif
+			kRotated = kBasis + kSchillingNumBasis,
+			kNumUserVars = kRotated + kSchillingNumPolarized };
 	unsigned int numUserVars() const { return kNumUserVars; }
 
 	string name() const { return "TwoPiAngles"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
 	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
 	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
 
+	// evaluates a block of events in one call (see AmplitudeBatch.h), W
+	// is linear in the spin density matrix elements (LinearAmplitude.h)
+	void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+	                         int nEvents, complex< GDouble >* amps ) const;
+
 	// we can calcualte everythign we need from userVars block so allow
 	// the framework to purge the four-vectors
 	bool needsUserVarsOnly() const { return true; }
+
+	// W is linear in the spin density matrix elements; the rotation by
+	// the polarization angle is kept here
+	void updatePar( const AmpParameter& par );
 	
 #ifdef GPU_ACCELERATION
   
@@ -56,6 +80,10 @@ public:
   
 private:
 
+  // the parameters of W in the user variables, with the rotation by the
+  // polarization angle (schillingRotatedParameters)
+  void parameters( GDouble* p ) const;
+
   AmpParameter rho000;
   AmpParameter rho100;
   AmpParameter rho1m10;
@@ -69,10 +97,11 @@ private:
   AmpParameter rho1m12;
 
   AmpParameter polAngle;
+  GDouble cos2PolAngle, sin2PolAngle;
 
 	GDouble polFraction;
     bool polInTree;
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E;
 
 };
 
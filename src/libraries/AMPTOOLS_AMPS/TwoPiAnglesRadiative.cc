@@ -11,11 +11,47 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
 
+namespace {
+
+  // W of the radiative decay, the angles are those of the bachelor photon:
+  //
+  //   W = 1 - sin^2 theta rho110 - cos^2 theta rho000 + ...
+  //
+  // with rho110 = ( 1 - rho000 ) / 2
+  void radiativeBasis( GDouble Pgamma, GDouble cosTheta, GDouble sinSqTheta,
+                       GDouble sin2Theta, GDouble Phi, GDouble phi, GDouble* basis ){
+
+    const GDouble norm = 3./(8.*PI);
+    GDouble polCos = Pgamma*cos(2.*Phi);
+    GDouble polSin = Pgamma*sin(2.*Phi);
+
+    basis[0] = norm * ( 1.0 - 0.5*sinSqTheta );
+    basis[1] = norm * ( 0.5*sinSqTheta - cosTheta*cosTheta );
+    basis[2] = norm * sqrt(2.)*sin2Theta*cos(phi);
+    basis[3] = norm * sinSqTheta*cos(2.*phi);
+
+    basis[4] = -norm * polCos * ( 2. - sinSqTheta );
+    basis[5] = -norm * polCos * sinSqTheta;
+    basis[6] = -norm * polCos * sqrt(2.)*sin2Theta*cos(phi);
+    basis[7] = -norm * polCos * sinSqTheta*cos(2.*phi);
+    basis[8] = norm * polSin * sqrt(2.)*sin2Theta*sin(phi);
+    basis[9] = norm * polSin * sinSqTheta*sin(2.*phi);
+  }
+}
+
+void
+TwoPiAnglesRadiative::loadShared( const vector< string >& args ){
+
+	if( args.size() == 13 ) PolarizationTable::get( args[11], args[12] );
+}
+
 TwoPiAnglesRadiative::TwoPiAnglesRadiative( const vector< string >& args ) :
-    UserAmplitude< TwoPiAnglesRadiative >( args )
+    UserAmplitude< TwoPiAnglesRadiative >( args ),
+    polAngle( 0. ), polFraction( 0. ), polFrac_vs_E( NULL )
 {
 	assert( args.size() == 9 ||  args.size() == 11 || args.size() == 13 );
 
@@ -48,9 +84,7 @@ TwoPiAnglesRadiative::TwoPiAnglesRadiative( const vector< string >& args ) :
 		polInTree = false;
 		polAngle = atof( args[9].c_str() );	
 		polFraction = 0.;
-		TFile* f = new TFile( args[11].c_str() );
-        polFrac_vs_E = (TH1D*)f->Get( args[12].c_str() );
-        assert( polFrac_vs_E != NULL );
+		polFrac_vs_E = PolarizationTable::get( args[11], args[12] );
 	}
 
     // need to register any free parameters so the framework knows about them
@@ -70,8 +104,8 @@ TwoPiAnglesRadiative::TwoPiAnglesRadiative( const vector< string >& args ) :
 
 }
 
-complex< GDouble >
-TwoPiAnglesRadiative::calcAmplitude( GDouble** pKin ) const 
+void
+TwoPiAnglesRadiative::calcUserVars( GDouble** pKin, GDouble* userVars ) const 
 {
 
 	TLorentzVector beam;
@@ -200,34 +234,39 @@ TwoPiAnglesRadiative::calcAmplitude( GDouble** pKin ) const
 		if(polFraction > 0.) { // for fitting with constant polarization 
 			Pgamma = polFraction;
 		} else{
-			int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-			if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-				Pgamma = 0.;
-			} else 
-				Pgamma = polFrac_vs_E->GetBinContent(bin);
+			Pgamma = polFrac_vs_E->fraction(pKin[0][0]);
 		}
 	}
 
-    // vector meson production from K. Schilling et. al.
-/*
-    GDouble W = 1.0 - 0.5*(1. - rho000)*sinSqTheta - rho000*cosTheta*cosTheta + sqrt(2.)*rho100*sin2Theta*cos(phi) + rho1m10*sinSqTheta*cos(2.*phi);
-
-    W -= Pgamma*cos(2.*Phi) * (2.*rho111 + (rho001-rho111)*sinSqTheta + sqrt(2.)*rho101*sin2Theta*cos(phi) + rho1m11*sinSqTheta*cos(2.*phi));
-
-    W += Pgamma*sin(2.*Phi) * (sqrt(2.)*rho102*sin2Theta*sin(phi) + rho1m12*sinSqTheta*sin(2.*phi));
-
-    */
-
-   double rho110 = 0.5*(1.-rho000);
+    radiativeBasis( Pgamma, cosTheta, sinSqTheta, sin2Theta, Phi, phi, userVars + kBasis );
+}
 
-   GDouble W = 1.0 - sinSqTheta * rho110 - cosTheta*cosTheta*rho000 + sinSqTheta*cos(2.*phi)*rho1m10 + sqrt(2.)*rho100*sin2Theta*cos(phi);
+complex< GDouble >
+TwoPiAnglesRadiative::calcAmplitude( GDouble** pKin, GDouble* userVars ) const 
+{
+    // vector meson production from K. Schilling et. al.
+    GDouble rho[kSchillingNumRho];
+    parameters( rho );
 
-   W -= Pgamma*cos(2.*Phi) * (2.*rho111 + sinSqTheta*(rho001-rho111) + sinSqTheta*cos(2.*phi)*rho1m11 + sqrt(2.)*rho101*sin2Theta*cos(phi));
+    GDouble W = linearIntensity< kSchillingNumRho >( userVars + kBasis, rho );
 
-   W += Pgamma*sin(2.*Phi) * (rho1m12*sinSqTheta*sin(2.*phi) + sqrt(2.)*rho102*sin2Theta*sin(phi));
+    return complex< GDouble > ( sqrt(fabs(W)) );
+}
 
-    W *= 3./(8.*PI);
+void
+TwoPiAnglesRadiative::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                          int nEvents, complex< GDouble >* amps ) const
+{
+    GDouble rho[kSchillingNumRho];
+    parameters( rho );
 
-    return complex< GDouble > ( sqrt(fabs(W)) );
+    linearAmplitudeBatch< kSchillingNumRho >( rho, userVars + kBasis, kNumUserVars, nEvents, amps );
 }
 
+void
+TwoPiAnglesRadiative::parameters( GDouble* rho ) const
+{
+    rho[0] = rho000;  rho[1] = rho100;  rho[2] = rho1m10;
+    rho[3] = rho111;  rho[4] = rho001;  rho[5] = rho101;  rho[6] = rho1m11;
+    rho[7] = rho102;  rho[8] = rho1m12;
+}
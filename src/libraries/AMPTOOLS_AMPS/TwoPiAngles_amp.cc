@@ -36,8 +36,8 @@ UserAmplitude< TwoPiAngles_amp >( args )
 }
 
 
-complex< GDouble >
-TwoPiAngles_amp::calcAmplitude( GDouble** pKin ) const {
+void
+TwoPiAngles_amp::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
 	TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
 	TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
@@ -73,7 +73,17 @@ TwoPiAngles_amp::calcAmplitude( GDouble** pKin ) const {
         GDouble Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
 	Phi = Phi > 0? Phi : Phi + 3.14159;
 
-	// cout << "Phi_test=" << Phi_test << " Phi=" << Phi << " Sum=" << Phi_test+Phi << " Diff=" << Phi_test-Phi << " PhaseFactor=" << PhaseFactor << endl;
+	userVars[kCosTheta] = cosTheta;
+	userVars[kPhi] = phi;
+	userVars[kBigPhi] = Phi;
+}
+
+complex< GDouble >
+TwoPiAngles_amp::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+	GDouble cosTheta = userVars[kCosTheta];
+	GDouble phi = userVars[kPhi];
+	GDouble Phi = userVars[kBigPhi];
      
 	complex< GDouble > i( 0, 1 );
 	complex< GDouble > prefactor( 0, 0 );
@@ -130,4 +140,3 @@ TwoPiAngles_amp::calcAmplitude( GDouble** pKin ) const {
 
 	return Amp;
 }
-
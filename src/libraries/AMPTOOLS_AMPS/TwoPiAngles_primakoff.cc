@@ -36,19 +36,8 @@ UserAmplitude< TwoPiAngles_primakoff >( args )
 }
 
 
-complex< GDouble >
-TwoPiAngles_primakoff::calcAmplitude( GDouble** pKin ) const {
-
-	complex< GDouble > i( 0, 1 );
-	complex< GDouble > factor( 0, 0 );
-	complex< GDouble > Amp( 0, 0 );
-	Int_t Mrho=0;
-
-  if (flat == 1) { // no computations needed
-     Amp = 1;
-     return Amp;
-  }
-
+void
+TwoPiAngles_primakoff::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 
   // for Primakoff, all calculations are in the lab frame. Keep recoil but remember that it cannot be measured by detector.
   
@@ -81,18 +70,27 @@ TwoPiAngles_primakoff::calcAmplitude( GDouble** pKin ) const {
 
         GDouble Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
 
-        GDouble psi = Phi - phi;               // define angle difference 
-        if(psi < -1*PI) psi += 2*PI;
-        if  (psi > PI) psi -= 2*PI;
+	userVars[kCosTheta] = CosTheta;
+	userVars[kPhi] = phi;
+	userVars[kBigPhi] = Phi;
+}
+
+complex< GDouble >
+TwoPiAngles_primakoff::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
 
-	/*cout << " recoil_res Angles="; recoil_res.Vect().Print();
-	cout << " p1_res Angles="; p1_res.Vect().Print();
-	cout << "Phi_pip= " << Phi_pip << endl;
-	cout << "Phi= " << Phi << endl;
-	cout << "Phi_prod= " << Phi_prod << endl;
-	cout << "phi= " << phi << endl;
-	cout << " psi=" << psi << endl;*/
-     
+	complex< GDouble > i( 0, 1 );
+	complex< GDouble > factor( 0, 0 );
+	complex< GDouble > Amp( 0, 0 );
+	Int_t Mrho=0;
+
+  if (flat == 1) { // no computations needed
+     Amp = 1;
+     return Amp;
+  }
+
+	GDouble CosTheta = userVars[kCosTheta];
+	GDouble phi = userVars[kPhi];
+	GDouble Phi = userVars[kBigPhi];
 
 	switch (PhaseFactor) {
         case 0:
@@ -120,4 +118,3 @@ TwoPiAngles_primakoff::calcAmplitude( GDouble** pKin ) const {
 
 	return Amp;
 }
-
@@ -25,7 +25,14 @@ public:
 	
 	string name() const { return "TwoPiAngles_primakoff"; }
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	enum UserVars { kCosTheta = 0, kPhi, kBigPhi, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	// the angles only depend on the kinematics and the polarization angle
+	bool needsUserVarsOnly() const { return true; }
 	
 #ifdef GPU_ACCELERATION
 	bool isGPUEnabled() const { return false; }
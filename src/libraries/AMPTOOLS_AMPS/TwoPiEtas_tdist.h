@@ -5,6 +5,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 
 #include <utility>
 #include <string>
@@ -28,7 +29,16 @@ public:
   
 	string name() const { return "TwoPiEtas_tdist"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the momentum transfer and the pi pi angle
+  enum UserVars { kT = 0, kThpipi, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
+  bool areUserVarsStatic() const { return true; }
 	  
   void updatePar( const AmpParameter& par );
     
@@ -45,8 +55,12 @@ private:
   AmpParameter ThetaSigma;    // for the moment assume W cross section has 5 parameters
   AmpParameter Phase;
   AmpParameter Bgen;
+
+  // 1 / ( 2 ThetaSigma^2 ) and the phase factor
+  GDouble m_halfInvSigmaSq;
+  complex< GDouble > m_phase;
   
-  pair< string, string > m_daughters;  
+  pair< ParticleCombination, ParticleCombination > m_daughters;  
 };
 
 #endif
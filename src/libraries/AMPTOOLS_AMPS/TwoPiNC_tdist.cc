@@ -5,8 +5,6 @@
 #include <complex>
 #include <cstdlib>
 
-#include "TLorentzVector.h"
-
 #include "barrierFactor.h"
 #include "breakupMomentum.h"
 
@@ -26,92 +24,67 @@ UserAmplitude< TwoPiNC_tdist >( args )
   ThetaSigma = AmpParameter( args[0] );
   Phase = AmpParameter( args[1] );    // convert phase to radians
   Bgen = AmpParameter( args[2] );
-  m_daughters = pair< string, string >( args[3], args[4] );    // specify indices of pions in event
+  m_daughters = pair< ParticleCombination, ParticleCombination >
+    ( ParticleCombination( args[3] ), ParticleCombination( args[4] ) );    // specify indices of pions in event
   
   // need to register any free parameters so the framework knows about them
   registerParameter( ThetaSigma );
   registerParameter( Phase );
   registerParameter( Bgen );
+
+  updatePar( ThetaSigma );
   
   // make sure the input variables look reasonable
   assert( ( ThetaSigma >= 0) &&( Bgen >= 2 ) && (Phase >=0 && Phase <=180) );     // Make sure generated value is lower than actual.         
 }
 
-complex< GDouble >
-TwoPiNC_tdist::calcAmplitude( GDouble** pKin ) const
+void
+TwoPiNC_tdist::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector P1, P2, Ptot, Ptemp, Precoil;
-  
-  for( unsigned int i = 0; i < m_daughters.first.size(); ++i ){
-    
-    string num; num += m_daughters.first[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi+ is index 1
-    P1 += Ptemp;
-    Ptot += Ptemp;
-
-    /* cout << " 1i=" << i << " num=" << num << " index=" << index  << " P1.M=" << P1.M() << endl;
-    P1.Print();
-    Ptot.Print();*/
-  }
-  
-  for( unsigned int i = 0; i < m_daughters.second.size(); ++i ){
-    
-    string num; num += m_daughters.second[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi- is index 2
-    P2 += Ptemp;
-    Ptot += Ptemp;   
-
-    /* cout << " 2i=" << i << " num=" << num << " index=" << index << " P2.M=" << P2.M() << endl;
-    P2.Print();
-    Ptot.Print();*/
-  }
+  GDouble P1[4], Ptot[4];
+
+  m_daughters.first.sum( pKin, P1 );      // pi+ is index 1
+  m_daughters.first.sum( pKin, Ptot );
+  m_daughters.second.addTo( pKin, Ptot );  // pi- is index 2
   
-  GDouble Wpipi  = Ptot.M();
-  GDouble mass1 = P1.M();
-  // GDouble mass2 = P2.M();
-  GDouble Ppipi = Ptot.E() > Wpipi? sqrt(Ptot.E()*Ptot.E() - Wpipi*Wpipi): 0;
-
-
-  // get momentum transfer
-  Precoil.SetPxPyPzE (pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);   // Recoil is particle 3
-  GDouble Et = Precoil.E();
-  GDouble Mt = Precoil.M();
-  GDouble t = -2*Precoil.M()*(Et - Mt);  
-  GDouble Eg = Ptot.E();
+  GDouble Wpipi  = ParticleCombination::mass( Ptot );
+  GDouble mass1 = ParticleCombination::mass( P1 );
+  GDouble Ppipi = Ptot[0] > Wpipi? sqrt(Ptot[0]*Ptot[0] - Wpipi*Wpipi): 0;
+
+
+  // get momentum transfer, recoil is particle 3
+  GDouble Et = pKin[3][0];
+  GDouble Mt = ParticleCombination::mass( pKin[3] );
+  GDouble t = -2*Mt*(Et - Mt);  
+  GDouble Eg = Ptot[0];
   GDouble tpar = (mass1*mass1/(2*Eg)) * (mass1*mass1/(2*Eg));
 
   GDouble Thpipi = -t > tpar? (180/PI)*sqrt( (-t-tpar)/(Eg*Ppipi) ): 0;
 
-  // complex<GDouble> Arel(sqrt(exp(Bslope*t)/exp(Bgen*t)),0.);  // Divide out generated exponential. This must be the same as in GammaZToXYZ.cc. Return sqrt(exp^Bt) 
-  //  complex<GDouble> Arel(sqrt(-t*exp(Bslope*t)/exp(Bgen*t)),0.);  // Divide out generated exponential. This must be the same as in GammaZToXYZ.cc. Return sqrt(-t*exp^Bt)   Add -t factor for pions 
-  
-  // Estimate of k2 sinthe / (-t) * F_strong(-t)  . PRC 80 055201 (2009) Eq. 4 and Fig 6.
-
-  // complex<GDouble> Arel( (Eg*Eg/(-t)) * Thpipi * sqrt(exp(-Thpipi*Thpipi/(2*0.45*0.45))) /exp(Bgen*t),0. );   // 1/-t for photon exchange.
+  userVars[kT] = t;
+  userVars[kThpipi] = Thpipi;
+}
 
-  complex<GDouble> Arel;
-  complex<GDouble> ImagOne(0,1);
+complex< GDouble >
+TwoPiNC_tdist::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
+{
+  GDouble t = userVars[kT];
+  GDouble Thpipi = userVars[kThpipi];
 
+  // Estimate of k2 sinthe / (-t) * F_strong(-t)  . PRC 80 055201 (2009) Eq. 4 and Fig 6.
 
-    Double_t arg = Thpipi*Thpipi/(2*ThetaSigma*ThetaSigma)<100? Thpipi*Thpipi/(2*ThetaSigma*ThetaSigma) : 0;
-    Arel = arg > 0? Thpipi * sqrt(exp(-arg) /exp(Bgen*t)) :0;   // Can Change phase of sigma relative to Primakoff
-    // cout << " arg=" << arg << " num=" << Thpipi * sqrt(exp(-arg)) << " den=" << exp(Bgen*t) << " Re(ImagOne)=" << real(ImagOne) << " imag(ImagOne)=" << imag(ImagOne)  << endl;
-  // Adjust phase for this amplitude relative to other amplitudes
-    Arel = Arel * (cos(Phase*PI/180.) + ImagOne*sin(Phase*PI/180.));
+    GDouble arg = Thpipi*Thpipi*m_halfInvSigmaSq;
+    if( !( arg < 100 ) ) arg = 0;
+    if( !( arg > 0 ) ) return 0;
 
-    // cout << "TwoPiNC_tdist" << " ThetaSigma=" << ThetaSigma << " Phase=" << Phase << " Bgen=" << Bgen << " t=" << t <<  " Re(Arel)=" << real(Arel) << " imag(Arel)=" << imag(Arel)  << " Eg=" << Eg << " tpar=" << tpar << " Wpipi=" << Wpipi << " Ppipi=" << Ppipi << " Thpipi=" << Thpipi << endl; 
-  return( Arel );
+  // sqrt(exp(-arg) /exp(Bgen*t)) as one exponential, with the phase of this
+  // amplitude relative to other amplitudes
+    return Thpipi * exp( -0.5*( arg + Bgen*t ) ) * m_phase;   // Can Change phase of sigma relative to Primakoff
 }
 
 void
 TwoPiNC_tdist::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates
-  
+  m_halfInvSigmaSq = 1./(2*ThetaSigma*ThetaSigma);
+  m_phase = complex< GDouble >( cos(Phase*PI/180.), sin(Phase*PI/180.) );
 }
-
-
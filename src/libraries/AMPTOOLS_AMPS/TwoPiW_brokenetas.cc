@@ -25,7 +25,8 @@ UserAmplitude< TwoPiW_brokenetas >( args )
   assert( args.size() == 4 );
 	m_par1 = AmpParameter( args[0] );
 	m_par2 = AmpParameter( args[1] );
-	m_daughters = pair< string, string >( args[2], args[3] );
+	m_daughters = pair< ParticleCombination, ParticleCombination >
+    ( ParticleCombination( args[2] ), ParticleCombination( args[3] ) );
   
   // need to register any free parameters so the framework knows about them
   // for brokenetas, parameters are Gmean and Gsigma of the Gaussian in GeV
@@ -36,50 +37,23 @@ UserAmplitude< TwoPiW_brokenetas >( args )
   // assert( ( m_orbitL >= 0 ) && ( m_orbitL <= 4 ) );
 }
 
-complex< GDouble >
-TwoPiW_brokenetas::calcAmplitude( GDouble** pKin ) const
+void
+TwoPiW_brokenetas::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector P1, P2, Ptot, Ptemp, Precoil;
-  
-  for( unsigned int i = 0; i < m_daughters.first.size(); ++i ){
-    
-    string num; num += m_daughters.first[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi+ is index 1
-    P1 += Ptemp;
-    Ptot += Ptemp;
+  GDouble P1[4], P2[4];
+  m_daughters.first.sum( pKin, P1 );
+  m_daughters.second.sum( pKin, P2 );
 
-    /* cout << " 1i=" << i << " num=" << num << " index=" << index  << " P1.M=" << P1.M() << endl;
-    P1.Print();
-    Ptot.Print();*/
-  }
-  
-  for( unsigned int i = 0; i < m_daughters.second.size(); ++i ){
-    
-    string num; num += m_daughters.second[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi- is index 2
-    P2 += Ptemp;
-    Ptot += Ptemp;   
+  GDouble Ptot[4] = { P1[0] + P2[0], P1[1] + P2[1], P1[2] + P2[2], P1[3] + P2[3] };
 
-    /* cout << " 2i=" << i << " num=" << num << " index=" << index << " P2.M=" << P2.M() << endl;
-    P2.Print();
-    Ptot.Print();*/
-  }
-  
-  Double_t Eg = pKin[0][0];          // incident photon energy
-  GDouble Wpipi  = Ptot.M();
-  GDouble mass1 = P1.M();
-  GDouble mass2 = P2.M();
+  userVars[kWpipi] = ParticleCombination::mass( Ptot );
+  userVars[kThreshold] = ParticleCombination::mass( P1 ) + ParticleCombination::mass( P2 );
+}
 
-  // get momentum transfer
-  Precoil.SetPxPyPzE (pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);   // Recoil is particle 3
-  // next three lines commented out, unused variables
-  GDouble Et = Precoil.E();
-  GDouble Mt = Precoil.M();
-  GDouble t = -2*Precoil.M()*(Et - Mt);  
+complex< GDouble >
+TwoPiW_brokenetas::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
+{
+  GDouble Wpipi = userVars[kWpipi];
 
   complex<GDouble> ImagOne(0,1);
     complex<GDouble> Aw;
@@ -91,9 +65,8 @@ TwoPiW_brokenetas::calcAmplitude( GDouble** pKin ) const
 
     Aw = isfinite(real(Aw))  && isfinite(imag(Aw))? Aw : 0;   // protect against infitinites
 
-    if (Wpipi < mass1+mass2) Aw = 0;
+    if (Wpipi < userVars[kThreshold]) Aw = 0;
     
-    // cout << "TwoPiW_brokenetas: calcAmplitude: 2pi mass=" << Wpipi << " Eg=" << Eg << " t=" << t << " Gmean=" << Gmean << " Gsigma=" << Gsigma << " AwNorm=" << std::norm(Aw) << " AwPhase=" << std::arg(Aw) << endl;
   
   return( Aw );
 }
@@ -104,5 +77,3 @@ TwoPiW_brokenetas::updatePar( const AmpParameter& par ){
   // could do expensive calculations here on parameter updates
   
 }
-
-
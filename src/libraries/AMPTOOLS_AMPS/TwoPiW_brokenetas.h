@@ -6,6 +6,8 @@
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
 
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
+
 #include <utility>
 #include <string>
 #include <complex>
@@ -28,7 +30,15 @@ public:
   
 	string name() const { return "TwoPiW_brokenetas"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the pi pi mass and its threshold
+  enum UserVars { kWpipi = 0, kThreshold, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
 	  
   void updatePar( const AmpParameter& par );
     
@@ -45,7 +55,7 @@ private:
   AmpParameter m_par1;    // for the moment assume W cross section has 2 parameters
   AmpParameter m_par2;
   
-  pair< string, string > m_daughters;  
+  pair< ParticleCombination, ParticleCombination > m_daughters;  
 };
 
 #endif
@@ -15,6 +15,7 @@ using std::complex;
 using namespace std;
 
 class Kinematics;
+class PrimakoffTable;
 
 class TwoPiWt_primakoff : public UserAmplitude< TwoPiWt_primakoff >
 {
@@ -27,8 +28,22 @@ public:
 	~TwoPiWt_primakoff(){}
   
 	string name() const { return "TwoPiWt_primakoff"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the pi pi mass, t and the Primakoff cross section sigma(t; W, E_gamma)
+  // only depend on the kinematics; they depend on the daughters given as
+  // arguments, so they are not static
+  enum UserVars { kWpipi = 0, kT, kSigmat, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
 	  
   void updatePar( const AmpParameter& par );
     
@@ -48,6 +63,8 @@ private:
   AmpParameter mtmax;
   
   pair< string, string > m_daughters;  
+
+  const PrimakoffTable* m_primakoff;
 };
 
 #endif
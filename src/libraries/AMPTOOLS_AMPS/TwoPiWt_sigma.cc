@@ -85,7 +85,8 @@ UserAmplitude< TwoPiWt_sigma >( args )
   assert( args.size() == 4 );
 	m_par1 = AmpParameter( args[0] );
 	m_par2 = AmpParameter( args[1] );
-	m_daughters = pair< string, string >( args[2], args[3] );
+	m_daughters = pair< ParticleCombination, ParticleCombination >
+    ( ParticleCombination( args[2] ), ParticleCombination( args[3] ) );
   
   // need to register any free parameters so the framework knows about them
   registerParameter( m_par1 );
@@ -95,55 +96,23 @@ UserAmplitude< TwoPiWt_sigma >( args )
   // assert( ( m_orbitL >= 0 ) && ( m_orbitL <= 4 ) );
 }
 
-complex< GDouble >
-TwoPiWt_sigma::calcAmplitude( GDouble** pKin ) const
+void
+TwoPiWt_sigma::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector P1, P2, Ptot, Ptemp, Precoil;
-  
-  for( unsigned int i = 0; i < m_daughters.first.size(); ++i ){
-    
-    string num; num += m_daughters.first[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi+ is index 1
-    P1 += Ptemp;
-    Ptot += Ptemp;
-
-    /* cout << " 1i=" << i << " num=" << num << " index=" << index  << " P1.M=" << P1.M() << endl;
-    P1.Print();
-    Ptot.Print();*/
-  }
-  
-  for( unsigned int i = 0; i < m_daughters.second.size(); ++i ){
-    
-    string num; num += m_daughters.second[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi- is index 2
-    P2 += Ptemp;
-    Ptot += Ptemp;   
-
-    /* cout << " 2i=" << i << " num=" << num << " index=" << index << " P2.M=" << P2.M() << endl;
-    P2.Print();
-    Ptot.Print();*/
-  }
-  
-  GDouble Wpipi  = Ptot.M();
-  GDouble mass1 = P1.M();
-  GDouble mass2 = P2.M();
+  GDouble P1[4], P2[4];
+  m_daughters.first.sum( pKin, P1 );
+  m_daughters.second.sum( pKin, P2 );
+
+  GDouble Ptot[4] = { P1[0] + P2[0], P1[1] + P2[1], P1[2] + P2[2], P1[3] + P2[3] };
 
-  // get momentum transfer
-  Precoil.SetPxPyPzE (pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);   // Recoil is particle 3
-  // next three lines commented out, unused variables
-  GDouble Et = Precoil.E();
-  GDouble Mt = Precoil.M();
-  GDouble t = -2*Precoil.M()*(Et - Mt);  
+  GDouble Wpipi  = ParticleCombination::mass( Ptot );
+  GDouble mass1 = ParticleCombination::mass( P1 );
+  GDouble mass2 = ParticleCombination::mass( P2 );
 
   
     Int_t const npar = 8;
     Double_t xin[1];
     xin[0] = Wpipi;                // W, 2pi mass
-    Double_t Eg = pKin[0][0];          // incident photon energy
 
     Double_t alpha1Re=0.378129;
     Double_t alpha1Im=0;
@@ -174,9 +143,14 @@ TwoPiWt_sigma::calcAmplitude( GDouble** pKin ) const
 
     if (Wpipi < mass1+mass2) Aw = 0;
     
-    // cout << "TwoPiWt_sigma: calcAmplitude: 2pi mass=" << Wpipi << " Eg=" << Eg << " t=" << t << " AwNorm=" << std::norm(Aw) << " AwPhase=" << std::arg(Aw) << endl;
-  
-  return( Aw );
+  userVars[kReAw] = real( Aw );
+  userVars[kImAw] = imag( Aw );
+}
+
+complex< GDouble >
+TwoPiWt_sigma::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
+{
+  return complex< GDouble >( userVars[kReAw], userVars[kImAw] );
 }
 
 void
@@ -185,5 +159,3 @@ TwoPiWt_sigma::updatePar( const AmpParameter& par ){
   // could do expensive calculations here on parameter updates
   
 }
-
-
@@ -5,13 +5,12 @@
 #include <complex>
 #include <cstdlib>
 
-#include "TLorentzVector.h"
-
 #include "barrierFactor.h"
 #include "breakupMomentum.h"
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/TwoPitdist.h"
+#include "AMPTOOLS_AMPS/ParticleCombination.h"
 
 // Class modeled after BreitWigner amplitude function provided for examples with AmpTools.
 // Dependence of swave 2pi cross section on W (mass of 2pi system) Elton 4/17/2017
@@ -32,6 +31,8 @@ UserAmplitude< TwoPitdist >( args )
   registerParameter( Bslope );
   registerParameter( Bgen );
   registerParameter( mtmax );
+
+  updatePar( Bslope );
   
   // make sure the input variables look reasonable
   // assert( ( Bgen >= 1 ) && ( Bslope >= Bgen ) );     // Make sure generated value is lower than actual.  
@@ -39,65 +40,30 @@ UserAmplitude< TwoPitdist >( args )
   assert( mtmax > 0);         
 }
 
-complex< GDouble >
-TwoPitdist::calcAmplitude( GDouble** pKin ) const
+void
+TwoPitdist::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 {
-  TLorentzVector P1, P2, Ptot, Ptemp, Precoil;
-  
-  for( unsigned int i = 0; i < m_daughters.first.size(); ++i ){
-    
-    string num; num += m_daughters.first[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi+ is index 1
-    P1 += Ptemp;
-    Ptot += Ptemp;
-
-    /* cout << " 1i=" << i << " num=" << num << " index=" << index  << " P1.M=" << P1.M() << endl;
-    P1.Print();
-    Ptot.Print();*/
-  }
-  
-  for( unsigned int i = 0; i < m_daughters.second.size(); ++i ){
-    
-    string num; num += m_daughters.second[i];
-    int index = atoi(num.c_str());
-    Ptemp.SetPxPyPzE( pKin[index][1], pKin[index][2],
-                      pKin[index][3], pKin[index][0] );    // pi- is index 2
-    P2 += Ptemp;
-    Ptot += Ptemp;   
+  // get momentum transfer, recoil is particle 3
+  GDouble Et = pKin[3][0];
+  GDouble Mt = ParticleCombination::mass( pKin[3] );
 
-    /* cout << " 2i=" << i << " num=" << num << " index=" << index << " P2.M=" << P2.M() << endl;
-    P2.Print();
-    Ptot.Print();*/
-  }
-  
-  /*GDouble Wpipi  = Ptot.M();
-  GDouble mass1 = P1.M();
-  GDouble mass2 = P2.M();*/
-  GDouble Thetapipi = Ptot.Theta()*180./PI;
+  userVars[kT] = -2*Mt*(Et - Mt);  
+}
 
-  // get momentum transfer
-  Precoil.SetPxPyPzE (pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);   // Recoil is particle 3
-  GDouble Et = Precoil.E();
-  GDouble Mt = Precoil.M();
-  GDouble t = -2*Precoil.M()*(Et - Mt);  
-  complex<GDouble> RealOne(1,0);
-  complex<GDouble> ImagOne(0,1);
-  complex<GDouble> Arel; 
+complex< GDouble >
+TwoPitdist::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
+{
+  GDouble t = userVars[kT];
 
-  Arel = sqrt(exp(Bslope*t)/exp(Bgen*t)) * RealOne;  // Divide out generated exponential. This must be the same as in GammaZToXYZ.cc. Return sqrt(exp^Bt) 
-  if (-t > mtmax) Arel = 0;      // eliminate events at high t with large weights
+  if (-t > mtmax) return 0;      // eliminate events at high t with large weights
 
-  // if (Thetapipi > 1.5) cout << " TwoPitdist" << " Thetapipi=" << Thetapipi << " Bslope=" << Bslope << " Bgen=" << Bgen << " t=" << t <<  " Re(Arel)=" << real(Arel) << " imag(Arel)=" << imag(Arel) << endl; 
-  return( Arel );
+  // Divide out generated exponential. This must be the same as in GammaZToXYZ.cc. Return sqrt(exp^Bt) 
+  return complex< GDouble >( exp( m_halfSlope*t ) );
 }
 
 void
 TwoPitdist::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates
-  
+  // sqrt( exp( Bslope t ) / exp( Bgen t ) ) is a single exponential
+  m_halfSlope = 0.5*( Bslope - Bgen );
 }
-
-
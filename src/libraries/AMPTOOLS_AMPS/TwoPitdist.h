@@ -28,7 +28,16 @@ public:
   
 	string name() const { return "TwoPitdist"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // the momentum transfer
+  enum UserVars { kT = 0, kNumUserVars };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
+  bool areUserVarsStatic() const { return true; }
 	  
   void updatePar( const AmpParameter& par );
     
@@ -45,6 +54,9 @@ private:
   AmpParameter Bslope;    // for the moment assume W cross section has 4 parameters
   AmpParameter Bgen;
   AmpParameter mtmax;
+
+  // the slopes only enter through ( Bslope - Bgen ) / 2
+  GDouble m_halfSlope;
   
   pair< string, string > m_daughters;  
 };
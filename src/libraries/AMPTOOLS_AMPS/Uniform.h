@@ -34,6 +34,9 @@ public:
   string name() const { return "Uniform"; }
   
   complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+
+  // the amplitude is 1 for every event
+  bool isEventIndependent() const { return true; }
       
 #ifdef GPU_ACCELERATION
   void launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const{
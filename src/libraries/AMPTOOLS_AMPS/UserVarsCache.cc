@@ -0,0 +1,272 @@
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdint.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "AMPTOOLS_AMPS/UserVarsCache.h"
+
+double UserVarsCache::m_maxBytes = 2e9;
+double UserVarsCache::m_bytes = 0;
+int UserVarsCache::m_hits = 0;
+
+string UserVarsCache::m_directory;
+int UserVarsCache::m_read = 0;
+int UserVarsCache::m_written = 0;
+
+namespace {
+
+  const char kFileMagic[8] = { 'U', 'V', 'C', 'A', 'C', 'H', 'E', '1' };
+
+  // the start of a file, followed by the key and the values
+  struct FileHeader {
+
+    char magic[8];
+    uint32_t valueSize;
+    uint32_t keyLength;
+    uint64_t block;
+    uint64_t count;
+  };
+
+  bool writeFailed = false;
+
+  unsigned long long hashString( const string& text ){
+
+    const unsigned long long prime = 1099511628211ULL;
+    unsigned long long h = 14695981039346656037ULL;
+    for( unsigned int i = 0; i < text.size(); ++i )
+      h = ( h ^ (unsigned char)text[i] ) * prime;
+    return h;
+  }
+}
+
+map< pair< string, unsigned long long >, vector< GDouble > >&
+UserVarsCache::blocks(){
+
+  static map< pair< string, unsigned long long >, vector< GDouble > > stored;
+  return stored;
+}
+
+mutex&
+UserVarsCache::lock(){
+
+  static mutex blocksMutex;
+  return blocksMutex;
+}
+
+void
+UserVarsCache::setMaxBytes( double maxBytes ){
+
+  lock_guard< mutex > guard( lock() );
+  m_maxBytes = maxBytes;
+}
+
+void
+UserVarsCache::setDirectory( const string& directory ){
+
+  lock_guard< mutex > guard( lock() );
+  m_directory = directory;
+
+  if( directory.size() != 0 ) mkdir( directory.c_str(), 0755 );
+}
+
+bool
+UserVarsCache::find( const string& amplitude, unsigned long long block,
+                     GDouble* userVars, size_t count ){
+
+  {
+    lock_guard< mutex > guard( lock() );
+
+    map< pair< string, unsigned long long >, vector< GDouble > >::const_iterator stored =
+      blocks().find( make_pair( amplitude, block ) );
+    if( stored != blocks().end() && stored->second.size() == count ){
+
+      copy( stored->second.begin(), stored->second.end(), userVars );
+      ++m_hits;
+      return true;
+    }
+
+    if( m_directory.size() == 0 ) return false;
+  }
+
+  // the files are read without the lock, so the threads of a pool read
+  // the blocks of their amplitudes at the same time
+  if( !readFile( amplitude, block, userVars, count ) ) return false;
+
+  lock_guard< mutex > guard( lock() );
+  ++m_read;
+  return true;
+}
+
+void
+UserVarsCache::store( const string& amplitude, unsigned long long block,
+                      const GDouble* userVars, size_t count ){
+
+  bool toFile;
+  {
+    lock_guard< mutex > guard( lock() );
+
+    toFile = ( m_directory.size() != 0 );
+
+    double bytes = (double)count * sizeof( GDouble );
+    if( m_bytes + bytes <= m_maxBytes ){
+
+      vector< GDouble >& values = blocks()[make_pair( amplitude, block )];
+      m_bytes += bytes - (double)values.size() * sizeof( GDouble );
+      values.assign( userVars, userVars + count );
+    }
+  }
+
+  if( toFile ) writeFile( amplitude, block, userVars, count );
+}
+
+string
+UserVarsCache::fileName( const string& amplitude, unsigned long long block ){
+
+  lock_guard< mutex > guard( lock() );
+
+  ostringstream name;
+  name << m_directory << "/" << hex << setfill( '0' ) << setw( 16 ) << hashString( amplitude )
+       << "_" << setw( 16 ) << block << ".uv";
+  return name.str();
+}
+
+bool
+UserVarsCache::readFile( const string& amplitude, unsigned long long block,
+                         GDouble* userVars, size_t count ){
+
+  string name = fileName( amplitude, block );
+
+  int fd = open( name.c_str(), O_RDONLY );
+  if( fd < 0 ) return false;
+
+  struct stat st;
+  size_t size = 0;
+  void* map = MAP_FAILED;
+  if( fstat( fd, &st ) == 0 && (size_t)st.st_size >= sizeof( FileHeader ) ){
+
+    size = st.st_size;
+    map = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+  }
+  close( fd );
+  if( map == MAP_FAILED ) return false;
+
+  // a file of another key with the same hashes, of another precision or
+  // of a sample of another size is not used
+  const FileHeader* header = static_cast< const FileHeader* >( map );
+  const char* key = reinterpret_cast< const char* >( header + 1 );
+
+  bool usable =
+    memcmp( header->magic, kFileMagic, sizeof( kFileMagic ) ) == 0 &&
+    header->valueSize == sizeof( GDouble ) && header->block == block &&
+    header->count == count && header->keyLength == amplitude.size() &&
+    size == sizeof( FileHeader ) + amplitude.size() + count * sizeof( GDouble ) &&
+    memcmp( key, amplitude.data(), amplitude.size() ) == 0;
+
+  if( usable ) memcpy( userVars, key + amplitude.size(), count * sizeof( GDouble ) );
+
+  munmap( map, size );
+  return usable;
+}
+
+void
+UserVarsCache::writeFile( const string& amplitude, unsigned long long block,
+                          const GDouble* userVars, size_t count ){
+
+  string name = fileName( amplitude, block );
+  if( access( name.c_str(), F_OK ) == 0 ) return;
+
+  ostringstream temporary;
+  temporary << name << "." << getpid() << "." << hex << (unsigned long long)userVars << ".tmp";
+
+  FileHeader header;
+  memcpy( header.magic, kFileMagic, sizeof( kFileMagic ) );
+  header.valueSize = sizeof( GDouble );
+  header.keyLength = amplitude.size();
+  header.block = block;
+  header.count = count;
+
+  FILE* file = fopen( temporary.str().c_str(), "wb" );
+  bool written = ( file != NULL &&
+                   fwrite( &header, sizeof( header ), 1, file ) == 1 &&
+                   fwrite( amplitude.data(), 1, amplitude.size(), file ) == amplitude.size() &&
+                   fwrite( userVars, sizeof( GDouble ), count, file ) == count );
+  if( file != NULL && fclose( file ) != 0 ) written = false;
+
+  if( written && rename( temporary.str().c_str(), name.c_str() ) != 0 ) written = false;
+  if( !written ) remove( temporary.str().c_str() );
+
+  lock_guard< mutex > guard( lock() );
+
+  // the blocks of a directory that cannot be written are only kept in
+  // memory, which is reported once
+  if( !written && !writeFailed )
+    cout << "UserVarsCache ERROR:  cannot write " << name << ", the user variables are not kept on disk" << endl;
+  writeFailed = writeFailed || !written;
+
+  if( written ) ++m_written;
+}
+
+unsigned long long
+UserVarsCache::hash( const GDouble* pdData, int iNEvents,
+                     const vector< vector< int > >& permutations ){
+
+  // FNV-1a over 64-bit words
+  const unsigned long long prime = 1099511628211ULL;
+  unsigned long long h = 14695981039346656037ULL;
+
+  h = ( h ^ (unsigned long long)iNEvents ) * prime;
+  for( unsigned int p = 0; p < permutations.size(); ++p ){
+
+    h = ( h ^ 0xffffffffULL ) * prime;
+    for( unsigned int i = 0; i < permutations[p].size(); ++i )
+      h = ( h ^ (unsigned long long)permutations[p][i] ) * prime;
+  }
+
+  // the four-vectors of all particles of the permutations
+  size_t nValues = 4 * (size_t)iNEvents * permutations[0].size();
+  for( size_t i = 0; i < nValues; ++i ){
+
+    unsigned long long word = 0;
+    memcpy( &word, &( pdData[i] ), sizeof( GDouble ) );
+    h = ( h ^ word ) * prime;
+  }
+
+  return h;
+}
+
+int
+UserVarsCache::numHits(){
+
+  lock_guard< mutex > guard( lock() );
+  return m_hits;
+}
+
+int
+UserVarsCache::numStored(){
+
+  lock_guard< mutex > guard( lock() );
+  return blocks().size();
+}
+
+int
+UserVarsCache::numRead(){
+
+  lock_guard< mutex > guard( lock() );
+  return m_read;
+}
+
+int
+UserVarsCache::numWritten(){
+
+  lock_guard< mutex > guard( lock() );
+  return m_written;
+}
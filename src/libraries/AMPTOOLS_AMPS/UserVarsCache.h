@@ -0,0 +1,192 @@
+#if !defined(USERVARSCACHE)
+#define USERVARSCACHE
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IUAmpTools/Amplitude.h"
+#include "GPUManager/GPUCustomTypes.h"
+
+using namespace std;
+
+// Static user variables of the amplitudes, kept for the life of the
+// process.  A program that builds one AmpToolsInterface after the other,
+// e.g., fit -l over the configurations of a list or the samplers of the
+// studies, computes the static user variables of every sample again for
+// each interface, although they only depend on the events:  the boosts of
+// Vec_ps_refl, the harmonics of Zlm.  Here the values of a block are
+// stored with the class, the arguments of the instance that computed them
+// and a hash of the four-vectors and permutations of the block, and the
+// next interface that loads the same events copies them instead.  The
+// copy then goes to the device as before on GPU builds; the transfer
+// itself is made by the framework.
+//
+// A sample is stored in blocks of kBlockEvents events from the first, so
+// that a sample with events appended, e.g., the data of fit --follow after
+// a new run, finds the blocks of the events it had before and only
+// computes those of the new events (and of the last block before them).
+//
+// Blocks are stored until maxBytes are held; later blocks are computed as
+// usual.  Amplitudes whose user variables are not static are not cached,
+// since they can depend on parameters set after the interface is built.
+//
+// With a directory (setDirectory) every block is also written to a file
+// there, named by the hashes of its key, and a block that is not held in
+// memory is read from its file, so the fits of later processes over the
+// same events (the restarts and systematic variations of a bin run as
+// separate jobs) map the files instead of calling calcUserVars.  A file
+// holds the key, the size of GDouble and the number of values, which are
+// checked before it is used; it is written under a temporary name and
+// renamed, so jobs that share the directory never read a partial file.
+// Old files are not removed:  the directory can be cleared at any time.
+
+class UserVarsCache
+{
+
+public:
+
+  enum { kBlockEvents = 65536 };
+
+  // the largest number of bytes kept (default 2e9)
+  static void setMaxBytes( double maxBytes );
+
+  // the directory of the files of the blocks; none if empty (the default)
+  static void setDirectory( const string& directory );
+
+  /**
+   * Copies the count values stored for the block into userVars and
+   * returns true, or returns false if the block is not stored.
+   */
+  static bool find( const string& amplitude, unsigned long long block,
+                    GDouble* userVars, size_t count );
+
+  static void store( const string& amplitude, unsigned long long block,
+                     const GDouble* userVars, size_t count );
+
+  // the hash of the four-vectors of nEvents events and the permutations
+  static unsigned long long hash( const GDouble* pdData, int iNEvents,
+                                  const vector< vector< int > >& permutations );
+
+  // the number of blocks copied and stored so far
+  static int numHits();
+  static int numStored();
+
+  // the number of blocks read from and written to the directory so far
+  static int numRead();
+  static int numWritten();
+
+private:
+
+  // the file of a block in the directory
+  static string fileName( const string& amplitude, unsigned long long block );
+
+  static bool readFile( const string& amplitude, unsigned long long block,
+                        GDouble* userVars, size_t count );
+  static void writeFile( const string& amplitude, unsigned long long block,
+                         const GDouble* userVars, size_t count );
+
+  static map< pair< string, unsigned long long >, vector< GDouble > >& blocks();
+  static mutex& lock();
+
+  static double m_maxBytes;
+  static double m_bytes;
+  static int m_hits;
+
+  static string m_directory;
+  static int m_read;
+  static int m_written;
+};
+
+// An amplitude A whose static user variables are taken from UserVarsCache
+// when the events have been seen before in the process, or by an earlier
+// process with the directory of the cache.  It has the name of
+// A and is registered in its place, like ThreadedAmplitude, by
+// AmplitudeRegistry with the cacheUserVars option.
+
+template< class A >
+class CachedUserVars : public A
+{
+
+public:
+
+  CachedUserVars() : A() {}
+
+  CachedUserVars( const vector< string >& args ) : A( args ) {}
+
+  Amplitude* newAmplitude( const vector< string >& args ) const {
+
+    return new CachedUserVars< A >( args );
+  }
+
+  Amplitude* clone() const {
+
+    return ( this->isDefault() ? new CachedUserVars< A >() :
+             new CachedUserVars< A >( *this ) );
+  }
+
+  void calcUserVarsAll( GDouble* pdData, GDouble* pdUserVars, int iNEvents,
+                        const vector< vector< int > >* pvPermutations ) const {
+
+    const Amplitude& amp = *this;
+    if( !amp.areUserVarsStatic() || pdData == NULL || iNEvents <= 0 || pvPermutations->empty() ){
+
+      A::calcUserVarsAll( pdData, pdUserVars, iNEvents, pvPermutations );
+      return;
+    }
+
+    // the instance that computes static user variables sets them for all
+    // instances, so its arguments (e.g., a polarization) are part of the key
+    string key = A::name();
+    const vector< string >& args = amp.arguments();
+    for( unsigned int i = 0; i < args.size(); ++i ) key += " " + args[i];
+
+    unsigned int numVars = amp.numUserVars();
+    int nPerms = pvPermutations->size();
+    int nParticles = (*pvPermutations)[0].size();
+
+    // the four-vectors are by particle and the user variables by
+    // permutation, so a block that is not the whole sample is copied
+    vector< GDouble > data, userVars;
+
+    for( int first = 0; first < iNEvents; first += UserVarsCache::kBlockEvents ){
+
+      int nEvents = min( (int)UserVarsCache::kBlockEvents, iNEvents - first );
+      bool whole = ( nEvents == iNEvents );
+
+      GDouble* blockData = pdData;
+      if( !whole ){
+
+        data.resize( 4 * nParticles * nEvents );
+        for( int i = 0; i < nParticles; ++i )
+          memcpy( &( data[4 * nEvents * i] ), &( pdData[4 * ( iNEvents * i + first )] ),
+                  4 * nEvents * sizeof( GDouble ) );
+        blockData = &( data[0] );
+      }
+
+      size_t count = (size_t)numVars * nEvents * nPerms;
+      if( !whole ) userVars.resize( count );
+      GDouble* blockUserVars = ( whole ? pdUserVars : &( userVars[0] ) );
+
+      unsigned long long block = UserVarsCache::hash( blockData, nEvents, *pvPermutations );
+      if( !UserVarsCache::find( key, block, blockUserVars, count ) ){
+
+        A::calcUserVarsAll( blockData, blockUserVars, nEvents, pvPermutations );
+        UserVarsCache::store( key, block, blockUserVars, count );
+      }
+
+      if( whole ) continue;
+
+      for( int perm = 0; perm < nPerms; ++perm )
+        memcpy( &( pdUserVars[(size_t)numVars * ( (size_t)iNEvents * perm + first )] ),
+                &( userVars[(size_t)numVars * nEvents * perm] ),
+                (size_t)numVars * nEvents * sizeof( GDouble ) );
+    }
+  }
+};
+
+#endif
@@ -11,10 +11,42 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Vec_ps_refl.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
 #include "AMPTOOLS_AMPS/omegapiAngles.h"
 #include "AMPTOOLS_AMPS/barrierFactor.h"
+#include "AMPTOOLS_AMPS/breakupMomentum.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
+
+namespace {
+
+  template< bool THREE_PI, int R >
+  void polarize( const complex< GDouble >* helicitySum, const GDouble* userVars, int nEvents,
+                 const GDouble* dalitz, GDouble polAngleRad, GDouble polFactor,
+                 complex< GDouble >* amps ){
+
+    for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      const GDouble* uv = userVars + iEvent * Vec_ps_refl::kNumUserVars;
+
+      GDouble G = 1;
+      if( THREE_PI ) G = sqrt(1 + 2 * dalitz[0] * uv[Vec_ps_refl::uv_dalitz_z] + 2 * dalitz[1] * uv[Vec_ps_refl::uv_dalitz_z32_sin3theta] + 2 * dalitz[2] * uv[Vec_ps_refl::uv_dalitz_z2] + 2 * dalitz[3] * uv[Vec_ps_refl::uv_dalitz_z52_sin3theta] );
+
+      complex< GDouble > rotated = G * helicitySum[iEvent] * polar(1., -1.*(uv[Vec_ps_refl::uv_prod_Phi] - polAngleRad));
+      amps[iEvent] = ( R == 1 ? complex< GDouble >( polFactor * real(rotated), 0 ) :
+                                complex< GDouble >( 0, polFactor * imag(rotated) ) );
+    }
+  }
+
+}
+
+void
+Vec_ps_refl::loadShared( const vector< string >& args ){
+
+	if( args.size() > 12 && atof( args[6].c_str() ) == 0 )
+		PolarizationTable::get( args[11], args[12] );
+}
 
 Vec_ps_refl::Vec_ps_refl( const vector< string >& args ) :
 UserAmplitude< Vec_ps_refl >( args )
@@ -33,9 +65,7 @@ UserAmplitude< Vec_ps_refl >( args )
   polFraction = atof(args[6].c_str());
   
   if (polFraction == 0){
-	TFile* f = new TFile( args[11].c_str() );
-	polFrac_vs_E = (TH1D*)f->Get( args[12].c_str() );
-	assert( polFrac_vs_E != NULL );
+	polFrac_vs_E = PolarizationTable::get( args[11], args[12] );
   }
 
   m_3pi = false;
@@ -62,7 +92,18 @@ UserAmplitude< Vec_ps_refl >( args )
   // m_s = +1 for 1 + Pgamma
   // m_s = -1 for 1 - Pgamma
   assert( abs( m_s ) == 1 );
-  
+  // the barrier factor is a user variable for l <= kMaxL
+  if( m_l < 0 || m_l > kMaxL ){
+
+    cout << "Vec_ps_refl ERROR:  partial wave l = " << m_l << " is not in 0 ... " << kMaxL << endl;
+    assert( false );
+  }
+
+  for (int lambda = -1; lambda <= 1; lambda++)
+	  m_cg[lambda+1] = clebschGordan(m_l, 1, 0, lambda, m_j, lambda);
+
+  if( m_3pi ) m_polarize = ( m_r == 1 ? &polarize< true, 1 > : &polarize< true, -1 > );
+  else m_polarize = ( m_r == 1 ? &polarize< false, 1 > : &polarize< false, -1 > );
 }
 
 void
@@ -99,6 +140,11 @@ Vec_ps_refl::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 	  
 	  userVars[uv_dalitz_z] = dalitz_z;
 	  userVars[uv_dalitz_sin3theta] = dalitz_sin3theta;
+
+	  double dalitz_z32 = dalitz_z * sqrt(dalitz_z);
+	  userVars[uv_dalitz_z32_sin3theta] = dalitz_z32 * dalitz_sin3theta;
+	  userVars[uv_dalitz_z2] = dalitz_z * dalitz_z;
+	  userVars[uv_dalitz_z52_sin3theta] = dalitz_z32 * dalitz_z * dalitz_sin3theta;
   }
   else {
 	  // omega ps proton, omega -> pi0 g (4 particles)
@@ -110,6 +156,12 @@ Vec_ps_refl::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 	  vec_daught1 = TLorentzVector(pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);
 	  vec_daught2 = TLorentzVector(pKin[4][1], pKin[4][2], pKin[4][3], pKin[4][0]);
 	  vec = vec_daught1 + vec_daught2;
+
+	  userVars[uv_dalitz_z] = 0;
+	  userVars[uv_dalitz_sin3theta] = 0;
+	  userVars[uv_dalitz_z32_sin3theta] = 0;
+	  userVars[uv_dalitz_z2] = 0;
+	  userVars[uv_dalitz_z52_sin3theta] = 0;
   }
 
   // final meson system P4
@@ -122,25 +174,37 @@ Vec_ps_refl::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   TLorentzVector Gammap = beam + target;
 
   // Calculate decay angles in helicity frame (same for all vectors)
-  vector <double> locthetaphi = getomegapiAngles(0, vec, X, beam, Gammap);
+  OmegaPiProductionAngles< double > locthetaphi =
+    omegapiProductionAngles(omegapiP4(vec), omegapiP4(X), omegapiP4(beam), omegapiP4(Gammap));
 
   // Calculate vector decay angles (unique for each vector)
-  vector <double> locthetaphih;
-  if(m_3pi) locthetaphih = getomegapiAngles(vec_daught1, vec, X, Gammap, vec_daught2);
-  else locthetaphih = getomegapiAngles(vec_daught1, vec, X, Gammap, TLorentzVector(0,0,0,0));
+  OmegaPiDecayAngles< double > locthetaphih =
+    omegapiDecayAngles(omegapiP4(vec_daught1), omegapiP4(vec), omegapiP4(X), omegapiP4(Gammap),
+                       m_3pi ? omegapiP4(vec_daught2) : omegapiP4(0., 0., 0., 0.));
+
+  userVars[uv_cosTheta] = TMath::Cos(locthetaphi.theta);
+  userVars[uv_Phi] = locthetaphi.phi;
 
-  userVars[uv_cosTheta] = TMath::Cos(locthetaphi[0]);
-  userVars[uv_Phi] = locthetaphi[1];
+  userVars[uv_cosThetaH] = TMath::Cos(locthetaphih.theta);
+  userVars[uv_PhiH] = locthetaphih.phi;
 
-  userVars[uv_cosThetaH] = TMath::Cos(locthetaphih[0]);
-  userVars[uv_PhiH] = locthetaphih[1];
+  userVars[uv_prod_Phi] = locthetaphi.bigPhi;
 
-  userVars[uv_prod_Phi] = locthetaphi[2];
+  for (int lambda = -1; lambda <= 1; lambda++) {
+	  complex< GDouble > decayD = conj(wignerD( 1, lambda, 0, userVars[uv_cosThetaH], userVars[uv_PhiH] ));
+	  userVars[uv_reDH_m1 + 2*(lambda+1)] = real(decayD);
+	  userVars[uv_imDH_m1 + 2*(lambda+1)] = imag(decayD);
+  }
 
   userVars[uv_MX] = X.M();
   userVars[uv_MVec] = vec.M();
   userVars[uv_MPs] = ps.M();
 
+  // E852 Nozar thesis has sqrt(2*s+1)*sqrt(2*l+1)*F_l(p_omega)*sqrt(omega)
+  double q = breakupMomentum(userVars[uv_MX], userVars[uv_MVec], userVars[uv_MPs]);
+  for (int l = 0; l <= kMaxL; l++)
+	  userVars[uv_barrier_l0 + l] = barrierFactor(q, l);
+
   return;
 }
 
@@ -153,26 +217,20 @@ Vec_ps_refl::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
 
   GDouble cosTheta = userVars[uv_cosTheta];
   GDouble Phi = userVars[uv_Phi];
-  GDouble cosThetaH = userVars[uv_cosThetaH];
-  GDouble PhiH = userVars[uv_PhiH];
   GDouble prod_angle = userVars[uv_prod_Phi];
-  GDouble dalitz_z = userVars[uv_dalitz_z];
-  GDouble dalitz_sin3theta = userVars[uv_dalitz_sin3theta];
-  GDouble MX = userVars[uv_MX];
-  GDouble MVec = userVars[uv_MVec];
-  GDouble MPs = userVars[uv_MPs];
 
   // dalitz parameters for 3-body vector decay
   GDouble G = 1; // not relevant for 2-body vector decays
-  if(m_3pi) G = sqrt(1 + 2 * dalitz_alpha * dalitz_z + 2 * dalitz_beta * pow(dalitz_z,3/2.) * dalitz_sin3theta + 2 * dalitz_gamma * pow(dalitz_z,2) + 2 * dalitz_delta * pow(dalitz_z,5/2.) * dalitz_sin3theta );
+  if(m_3pi) G = sqrt(1 + 2 * dalitz_alpha * userVars[uv_dalitz_z] + 2 * dalitz_beta * userVars[uv_dalitz_z32_sin3theta] + 2 * dalitz_gamma * userVars[uv_dalitz_z2] + 2 * dalitz_delta * userVars[uv_dalitz_z52_sin3theta] );
 
   complex <GDouble> amplitude(0,0);
   complex <GDouble> i(0,1);
 
   for (int lambda = -1; lambda <= 1; lambda++) { // sum over vector helicity
-	  GDouble hel_amp = clebschGordan(m_l, 1, 0, lambda, m_j, lambda);
-	  amplitude += conj(wignerD( m_j, m_m, lambda, cosTheta, Phi )) * hel_amp * conj(wignerD( 1, lambda, 0, cosThetaH, PhiH )) * G;
+	  complex< GDouble > decayD( userVars[uv_reDH_m1 + 2*(lambda+1)], userVars[uv_imDH_m1 + 2*(lambda+1)] );
+	  amplitude += conj(wignerD( m_j, m_m, lambda, cosTheta, Phi )) * m_cg[lambda+1] * decayD;
   } 
+  amplitude *= G;
 
   GDouble Factor = sqrt(1 + m_s * polFraction);
   complex< GDouble > zjm = 0;
@@ -182,14 +240,92 @@ Vec_ps_refl::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
   if (m_r == -1) 
 	  zjm = i*imag(amplitude * rotateY);
 
-  // E852 Nozar thesis has sqrt(2*s+1)*sqrt(2*l+1)*F_l(p_omega)*sqrt(omega)
-  double kinFactor = barrierFactor(MX, m_l, MVec, MPs);
-  //kinFactor *= sqrt(3.) * sqrt(2.*m_l + 1.);
-  Factor *= kinFactor;
+  Factor *= userVars[uv_barrier_l0 + m_l];
 
   return complex< GDouble >( static_cast< GDouble>( Factor ) * zjm );
 }
 
+void
+Vec_ps_refl::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                 int nEvents, complex< GDouble >* amps ) const
+{
+  if( nEvents <= 0 ) return;
+
+  // the helicity sum times the barrier factor does not depend on the
+  // parameters, which only enter through the Dalitz factor G and the
+  // rotation by polAngle; it is cached per (j, m, l), so a step in a
+  // parameter only redoes the last loop below.  In single precision if
+  // the cache is compact, then it is expanded for the last loop.
+  bool sumFilled;
+  int jml[3] = { m_j, m_m, m_l };
+  complex< float >* compactSum = NULL;
+  vector< complex< GDouble > > sumValues;
+  complex< GDouble >* helicitySum;
+
+  if( FactorCache::compact() ){
+
+    compactSum = FactorCache::lookupCompact( FactorCache::kVecPsHelicitySum, jml, 3, userVars,
+                                             nEvents, kNumUserVars, 1, sumFilled );
+    sumValues.resize( nEvents );
+    helicitySum = &(sumValues[0]);
+
+    if( sumFilled )
+      for( int iEvent = 0; iEvent < nEvents; ++iEvent )
+        helicitySum[iEvent] = complex< GDouble >( compactSum[iEvent] );
+  }
+  else{
+
+    helicitySum = FactorCache::lookup( FactorCache::kVecPsHelicitySum, jml, 3, userVars,
+                                       nEvents, kNumUserVars, 1, sumFilled );
+  }
+
+  if( !sumFilled ){
+
+    // the production D-functions only depend on (j, m), so instances that
+    // share them take them from the factor cache instead of computing them
+    // again; the barrier factor is a user variable
+    bool prodFilled;
+    int jm[2] = { m_j, m_m };
+    complex< GDouble >* prodD =
+      FactorCache::lookup( FactorCache::kVecPsProductionD, jm, 2, userVars,
+                           nEvents, kNumUserVars, 3, prodFilled );
+
+    if( !prodFilled ){
+
+      for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+        const GDouble* uv = userVars + iEvent * kNumUserVars;
+
+        for (int lambda = -1; lambda <= 1; lambda++)
+          prodD[3*iEvent+lambda+1] = conj(wignerD( m_j, m_m, lambda, uv[uv_cosTheta], uv[uv_Phi] ));
+      }
+    }
+
+    for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      const GDouble* uv = userVars + iEvent * kNumUserVars;
+
+      complex< GDouble > amplitude(0,0);
+      for (int lambda = -1; lambda <= 1; lambda++) {
+
+        complex< GDouble > decayD( uv[uv_reDH_m1 + 2*(lambda+1)], uv[uv_imDH_m1 + 2*(lambda+1)] );
+        amplitude += prodD[3*iEvent+lambda+1] * m_cg[lambda+1] * decayD;
+      }
+
+      helicitySum[iEvent] = uv[uv_barrier_l0 + m_l] * amplitude;
+    }
+
+    if( compactSum != NULL ) FactorCache::store( helicitySum, nEvents, compactSum );
+  }
+
+  GDouble polFactor = sqrt(1 + m_s * polFraction);
+  GDouble polAngleRad = polAngle*TMath::DegToRad();
+
+  GDouble dalitz[4] = { dalitz_alpha, dalitz_beta, dalitz_gamma, dalitz_delta };
+
+  m_polarize( helicitySum, userVars, nEvents, dalitz, polAngleRad, polFactor, amps );
+}
+
 
 void Vec_ps_refl::updatePar( const AmpParameter& par ){
 
@@ -202,7 +338,7 @@ void Vec_ps_refl::updatePar( const AmpParameter& par ){
 void
 Vec_ps_refl::launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const {
 
-	GPUVec_ps_refl_exec( dimGrid, dimBlock, GPU_AMP_ARGS, m_j, m_m, m_l, m_r, m_s, m_3pi, dalitz_alpha, dalitz_beta, dalitz_gamma, dalitz_delta, polAngle, polFraction );
+	GPUVec_ps_refl_exec( dimGrid, dimBlock, GPU_AMP_ARGS, m_j, m_m, m_l, m_r, m_s, m_3pi, m_cg[0], m_cg[1], m_cg[2], dalitz_alpha, dalitz_beta, dalitz_gamma, dalitz_delta, polAngle, polFraction );
 
 }
 
@@ -6,7 +6,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -24,7 +24,7 @@ using namespace std;
 
 #ifdef GPU_ACCELERATION
 void
-GPUVec_ps_refl_exec( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO, int m_j, int m_m, int m_l, int m_r, int m_s, int m_3pi, GDouble dalitz_alpha, GDouble dalitz_beta, GDouble dalitz_gamma, GDouble dalitz_delta, GDouble polAngle, GDouble polFraction );
+GPUVec_ps_refl_exec( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO, int m_j, int m_m, int m_l, int m_r, int m_s, int m_3pi, GDouble cg_m1, GDouble cg_0, GDouble cg_p1, GDouble dalitz_alpha, GDouble dalitz_beta, GDouble dalitz_gamma, GDouble dalitz_delta, GDouble polAngle, GDouble polFraction );
 #endif
 
 class Kinematics;
@@ -34,14 +34,22 @@ class Vec_ps_refl : public UserAmplitude< Vec_ps_refl >
     
 public:
 	
-	Vec_ps_refl() : UserAmplitude< Vec_ps_refl >() { };
+	Vec_ps_refl() : UserAmplitude< Vec_ps_refl >(), m_polarize( NULL ) { };
 	Vec_ps_refl( const vector< string >& args );
 	Vec_ps_refl( int m_j, int m_m, int m_l, int m_r, int m_s, int m_3pi, GDouble dalitz_alpha, GDouble dalitz_beta, GDouble dalitz_gamma, GDouble dalitz_delta, GDouble polAngle, GDouble polFraction);
 	
 	string name() const { return "Vec_ps_refl"; }
+
+	// loads the shared tables of an instance with args ahead of its
+	// construction (see AmplitudeRegistry::loadShared)
+	static void loadShared( const vector< string >& args );
     
 	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
 
+	// evaluates a block of events in one call (see AmplitudeBatch.h)
+	void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+	                         int nEvents, complex< GDouble >* amps ) const;
+
 	// **********************
 	// The following lines are optional and can be used to precalcualte
 	// user-defined data that the amplitudes depend on.
@@ -49,7 +57,17 @@ public:
 	// Use this for indexing a user-defined data array and notifying
 	// the framework of the number of user-defined variables.
 	
-	enum UserVars { uv_cosTheta = 0, uv_Phi = 1, uv_cosThetaH = 2, uv_PhiH = 3, uv_prod_Phi = 4, uv_dalitz_z = 5, uv_dalitz_sin3theta = 6, uv_MX = 7, uv_MVec = 8, uv_MPs = 9, kNumUserVars };
+	// The powers of the Dalitz z and the conjugated vector decay
+	// D^1_{lambda,0}(thetaH, phiH) for lambda = -1, 0, 1 do not depend on
+	// the amplitude arguments, so they are computed once per event and
+	// shared by all instances through the static user data.  So are the
+	// barrier factors of the partial waves l = 0 ... kMaxL, which only
+	// depend on the masses; an instance reads the one of its l.
+	enum { kMaxL = 4 };
+	enum UserVars { uv_cosTheta = 0, uv_Phi = 1, uv_cosThetaH = 2, uv_PhiH = 3, uv_prod_Phi = 4, uv_dalitz_z = 5, uv_dalitz_sin3theta = 6, uv_MX = 7, uv_MVec = 8, uv_MPs = 9,
+	                uv_dalitz_z32_sin3theta = 10, uv_dalitz_z2 = 11, uv_dalitz_z52_sin3theta = 12,
+	                uv_reDH_m1 = 13, uv_imDH_m1 = 14, uv_reDH_0 = 15, uv_imDH_0 = 16, uv_reDH_p1 = 17, uv_imDH_p1 = 18,
+	                uv_barrier_l0 = 19, kNumUserVars = uv_barrier_l0 + kMaxL + 1 };
 	unsigned int numUserVars() const { return kNumUserVars; }
 	
 	// This function needs to be defined -- see comments and discussion
@@ -87,6 +105,9 @@ private:
 	int m_r;
 	int m_s;
 	int m_3pi;
+
+	// <l 0; 1 lambda | j lambda> for lambda = -1, 0, 1
+	GDouble m_cg[3];
 	
 	AmpParameter dalitz_alpha;
 	AmpParameter dalitz_beta;
@@ -97,7 +118,17 @@ private:
 	
 	GDouble polFraction;
     bool polInTree = false;        // not implemented at the moment
-	TH1D *polFrac_vs_E;
+	const PolarizationTable* polFrac_vs_E;
+
+	// The last step of calcAmplitudeBatch, which applies the Dalitz factor,
+	// the rotation by polAngle and the real or imaginary part to the
+	// helicity sums.  It is instantiated for each (3pi, r) and chosen in
+	// the constructor, so the loop over the events has no branch on them.
+	typedef void (*PolarizeFunction)( const complex< GDouble >* helicitySum,
+	                                  const GDouble* userVars, int nEvents,
+	                                  const GDouble* dalitz, GDouble polAngleRad,
+	                                  GDouble polFactor, complex< GDouble >* amps );
+	PolarizeFunction m_polarize;
 };
 
 #endif
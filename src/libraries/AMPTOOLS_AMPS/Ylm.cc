@@ -12,6 +12,8 @@
 #include "AMPTOOLS_AMPS/Ylm.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
 
 Ylm::Ylm( const vector< string >& args ) :
 UserAmplitude< Ylm >( args )
@@ -32,43 +34,90 @@ UserAmplitude< Ylm >( args )
     m_phaseFactor = ( m_m % 2 == 0 ? 1 : -1 );
     m_m *= -1;
   }
-  
+
+  // Y_{j,-m} = (-1)^m Y_{j,m}*
+  m_absM = abs( m_m );
+  m_conjugate = ( m_m < 0 );
+  m_sign = m_phaseFactor * ( m_conjugate && m_absM % 2 == 1 ? -1 : 1 );
 }
 
 
-complex< GDouble >
-Ylm::calcAmplitude( GDouble** pKin ) const {
-  
-  TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
-  TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
-  TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] ); 
-  TLorentzVector p2     ( pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0] ); 
-  
-  TLorentzVector resonance = p1 + p2;
+void
+Ylm::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
-  TLorentzRotation resRestBoost( -resonance.BoostVector() );
-  
-  TLorentzVector beam_res   = resRestBoost * beam;
-  TLorentzVector recoil_res = resRestBoost * recoil;
-  TLorentzVector p1_res = resRestBoost * p1;
-  
-  // Helicity frame
-  TVector3 z = -1. * recoil_res.Vect().Unit();
-  // or GJ frame?
-  // TVector3 z = beam_res.Vect().Unit();
+  GDouble cosTheta, phi;
+  twoBodyAngles( kHelicityLabNormal, pKin[0], pKin[1], pKin[2], pKin[3], cosTheta, phi );
 
-// normal to the production plane
-  TVector3 y = (beam.Vect().Unit().Cross(-recoil.Vect().Unit())).Unit();
+  userVars[kCosTheta] = cosTheta;
+  userVars[kPhi] = phi;
+}
 
-  TVector3 x = y.Cross(z);
-  
-  TVector3 angles( (p1_res.Vect()).Dot(x),
-                   (p1_res.Vect()).Dot(y),
-                   (p1_res.Vect()).Dot(z) );
-  
-  GDouble cosTheta = angles.CosTheta();
-  GDouble phi = angles.Phi();
+complex< GDouble >
+Ylm::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
 
-  return complex< GDouble >( static_cast< GDouble>( m_phaseFactor ) * Y( m_j, m_m, cosTheta, phi ) );
+  return complex< GDouble >( static_cast< GDouble>( m_phaseFactor ) *
+                             Y( m_j, m_m, userVars[kCosTheta], userVars[kPhi] ) );
 }
 
+void
+Ylm::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                         int nEvents, complex< GDouble >* amps ) const {
+
+  if( nEvents <= 0 ) return;
+
+  // the first instance of a (j, |m|) to evaluate a block stores Y_{j,|m|}
+  // in the factor cache, the others with +/-m and s = +/-1 read it back
+  bool filled;
+  int jm[2] = { m_j, m_absM };
+
+  vector< complex< GDouble > > values;
+  complex< float >* compactHarmonic = NULL;
+  complex< GDouble >* harmonic;
+
+  if( FactorCache::compact() ){
+
+    compactHarmonic = FactorCache::lookupCompact( FactorCache::kYlmHarmonic, jm, 2, userVars,
+                                                  nEvents, kNumUserVars, 1, filled );
+    if( filled ){
+
+      applyHarmonic( nEvents, compactHarmonic, amps );
+      return;
+    }
+
+    values.resize( nEvents );
+    harmonic = &( values[0] );
+  }
+  else{
+
+    harmonic = FactorCache::lookup( FactorCache::kYlmHarmonic, jm, 2, userVars,
+                                    nEvents, kNumUserVars, 1, filled );
+    if( filled ){
+
+      applyHarmonic( nEvents, harmonic, amps );
+      return;
+    }
+  }
+
+  for( int i = 0; i < nEvents; ++i ){
+
+    const GDouble* uv = userVars + i * kNumUserVars;
+    harmonic[i] = Y( m_j, m_absM, uv[kCosTheta], uv[kPhi] );
+  }
+
+  if( compactHarmonic != NULL ) FactorCache::store( harmonic, nEvents, compactHarmonic );
+
+  applyHarmonic( nEvents, harmonic, amps );
+}
+
+// the harmonic in GDouble or float, the amplitude always in GDouble
+template< class T >
+void
+Ylm::applyHarmonic( int nEvents, const complex< T >* harmonic,
+                    complex< GDouble >* amps ) const {
+
+  for( int i = 0; i < nEvents; ++i ){
+
+    complex< GDouble > y( real( harmonic[i] ), imag( harmonic[i] ) );
+    amps[i] = m_sign * ( m_conjugate ? conj( y ) : y );
+  }
+}
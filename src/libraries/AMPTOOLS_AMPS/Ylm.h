@@ -31,8 +31,21 @@ public:
 	
 	string name() const { return "Ylm"; }
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
-	
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the helicity angles are the same for all instances of this amplitude
+	enum UserVars { kCosTheta = 0, kPhi, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	// evaluates a block of events in one call (see AmplitudeBatch.h)
+	void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+	                         int nEvents, complex< GDouble >* amps ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
+
 private:
         
   int m_j;
@@ -40,7 +53,16 @@ private:
   int m_s;
 
   int m_phaseFactor;
-	
+
+  // the amplitude is m_sign Y_{j,|m|} or its conjugate, so the instances
+  // with m and -m and with s = +1 and -1 share one harmonic
+  int m_absM;
+  bool m_conjugate;
+  GDouble m_sign;
+
+  template< class T >
+  void applyHarmonic( int nEvents, const complex< T >* harmonic,
+                      complex< GDouble >* amps ) const;
 };
 
 #endif
@@ -9,10 +9,64 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Zlm.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/ZlmFixed.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
 
 #include "TFile.h"
 
+namespace {
+
+   // All Zlm instances share their user variables, so when the amplitudes
+   // of one event are evaluated back to back (e.g., when computing the
+   // intensity of a single event for plotting or generation) the harmonics
+   // for every (l,m) are computed in one pass and reused until the
+   // angles change.
+   const int kMaxCachedL = 6;
+
+   struct HarmonicsCache {
+
+      HarmonicsCache() : cosTheta( 2 ), phi( 0 ) { }
+
+      GDouble cosTheta;
+      GDouble phi;
+      complex< GDouble > ylm[(kMaxCachedL+1)*(kMaxCachedL+1)];
+   };
+
+   thread_local HarmonicsCache harmonicsCache;
+
+#define ZLM_FIXED_ROW(J,M) \
+   { &zlmFixed<J,M,1,1>, &zlmFixed<J,M,1,-1>, \
+     &zlmFixed<J,M,-1,1>, &zlmFixed<J,M,-1,-1> }
+
+   const ZlmFixedFunction kZlmFixed[][4] = { ZLM_FIXED_FOR_ALL( ZLM_FIXED_ROW ) };
+
+#undef ZLM_FIXED_ROW
+
+   template< int J, int M >
+   complex< GDouble > zlmHarmonic( GDouble cosTheta, GDouble phi, GDouble bigPhi ){
+
+      GDouble re, im;
+      zlmFixedHarmonic< J, M >( cosTheta, phi, bigPhi, re, im );
+      return complex< GDouble >( re, im );
+   }
+
+#define ZLM_HARMONIC_ENTRY(J,M) &zlmHarmonic<J,M>
+
+   complex< GDouble > (* const kZlmHarmonic[])( GDouble, GDouble, GDouble ) =
+      { ZLM_FIXED_FOR_ALL( ZLM_HARMONIC_ENTRY ) };
+
+#undef ZLM_HARMONIC_ENTRY
+}
+
+void
+Zlm::loadShared( const vector< string >& args ){
+
+   if( args.size() == 8 ) PolarizationTable::get( args[6], args[7] );
+}
+
 Zlm::Zlm( const vector< string >& args ) :
    UserAmplitude< Zlm >( args )
 {
@@ -44,9 +98,7 @@ Zlm::Zlm( const vector< string >& args ) :
       m_polInTree = false;
       m_polAngle = atof( args[4].c_str() );
       m_polFraction = 0.; 
-      TFile* f = new TFile( args[6].c_str() );
-      m_polFrac_vs_E = (TH1D*)f->Get( args[7].c_str() );
-      assert( m_polFrac_vs_E != NULL );
+      m_polFrac_vs_E = PolarizationTable::get( args[6], args[7] );
    }
 
    // make sure values are reasonable
@@ -57,6 +109,11 @@ Zlm::Zlm( const vector< string >& args ) :
    // m_s = +1 for 1 + Pgamma
    // m_s = -1 for 1 - Pgamma
    assert( abs( m_s ) == 1 );
+
+   // use the unrolled version if there is one for this (j,m)
+   m_fixed = ( m_j <= ZLM_FIXED_MAX_J ?
+               kZlmFixed[m_j*(m_j+1)+m_m][zlmFixedIndex( m_r, m_s )] : NULL );
+   m_harmonic = ( m_j <= ZLM_FIXED_MAX_J ? kZlmHarmonic[m_j*(m_j+1)+m_m] : NULL );
 }
 
 
@@ -68,74 +125,141 @@ Zlm::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
    GDouble phi = userVars[kPhi];
    GDouble bigPhi = userVars[kBigPhi];
 
+   if( m_fixed != NULL )
+      return complex< GDouble >( m_fixed( pGamma, cosTheta, phi, bigPhi ) );
+
    GDouble factor = sqrt(1 + m_s * pGamma);
    GDouble zlm = 0;
    complex< GDouble > rotateY = polar(1., -1.*bigPhi);
+
+   complex< GDouble > ylm;
+   if( m_j <= kMaxCachedL ){
+
+      HarmonicsCache& cache = harmonicsCache;
+      if( cache.cosTheta != cosTheta || cache.phi != phi ){
+
+         sphericalHarmonics( kMaxCachedL, cosTheta, phi, cache.ylm );
+         cache.cosTheta = cosTheta;
+         cache.phi = phi;
+      }
+      ylm = cache.ylm[m_j*(m_j+1)+m_m];
+   }
+   else{
+
+      ylm = Y( m_j, m_m, cosTheta, phi );
+   }
+
    if (m_r == 1)
-      zlm = real(Y( m_j, m_m, cosTheta, phi ) * rotateY);
+      zlm = real(ylm * rotateY);
    if (m_r == -1)
-      zlm = imag(Y( m_j, m_m, cosTheta, phi ) * rotateY);
+      zlm = imag(ylm * rotateY);
 
    return complex< GDouble >( factor * zlm );
 }
 
 void
-Zlm::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
-   TLorentzVector beam;
-   TVector3 eps;
+Zlm::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                         int nEvents, complex< GDouble >* amps ) const {
 
-   if(m_polInTree) {
-      beam.SetPxPyPzE( 0., 0., pKin[0][0], pKin[0][0]);
-      eps.SetXYZ(pKin[0][1], pKin[0][2], 0.); // makes default output gen_amp trees readable as well (without transforming)
-   } else {
-      beam.SetPxPyPzE( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
-      eps.SetXYZ(cos(m_polAngle*TMath::DegToRad()), sin(m_polAngle*TMath::DegToRad()), 0.0); // beam polarization vector
+   if( nEvents <= 0 ) return;
+
+   // The four (r, s) of a (j, m) only differ in taking the real or the
+   // imaginary part of Y_jm exp( -i Phi ) and in sqrt( 1 + s P_gamma ), so
+   // the first of them to evaluate a block stores the complex product in
+   // the factor cache and the others read it back.  It does not depend on
+   // a parameter, so it can be stored in single precision.
+   bool filled;
+   int jm[2] = { m_j, m_m };
+
+   if( FactorCache::compact() ){
+
+      complex< float >* harmonic =
+         FactorCache::lookupCompact( FactorCache::kZlmHarmonic, jm, 2, userVars,
+                                     nEvents, kNumUserVars, 1, filled );
+
+      if( !filled ){
+
+         vector< complex< GDouble > > values( nEvents );
+         fillHarmonics( userVars, nEvents, &(values[0]) );
+         FactorCache::store( &(values[0]), nEvents, harmonic );
+      }
+
+      applyHarmonics( userVars, nEvents, harmonic, amps );
+      return;
    }
 
-   TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
-   TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] ); 
-   TLorentzVector p2     ( pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0] ); 
+   complex< GDouble >* harmonic =
+      FactorCache::lookup( FactorCache::kZlmHarmonic, jm, 2, userVars,
+                           nEvents, kNumUserVars, 1, filled );
 
-   TLorentzVector resonance = p1 + p2;
+   if( !filled ) fillHarmonics( userVars, nEvents, harmonic );
 
-   TLorentzRotation resRestBoost( -resonance.BoostVector() );
+   applyHarmonics( userVars, nEvents, harmonic, amps );
+}
 
-   TLorentzVector beam_res   = resRestBoost * beam;
-   TLorentzVector recoil_res = resRestBoost * recoil;
-   TLorentzVector p1_res = resRestBoost * p1;
+void
+Zlm::fillHarmonics( const GDouble* userVars, int nEvents, complex< GDouble >* harmonic ) const {
 
-   // Helicity frame
-   TVector3 z = -1. * recoil_res.Vect().Unit();
-   // or GJ frame?
-   // TVector3 z = beam_res.Vect().Unit();
+   for( int i = 0; i < nEvents; ++i ){
 
-   // normal to the production plane
-   TVector3 y = (beam.Vect().Unit().Cross(-recoil.Vect().Unit())).Unit();
+      const GDouble* uv = userVars + i * kNumUserVars;
 
-   TVector3 x = y.Cross(z);
+      if( m_harmonic != NULL )
+         harmonic[i] = m_harmonic( uv[kCosTheta], uv[kPhi], uv[kBigPhi] );
+      else
+         harmonic[i] = Y( m_j, m_m, uv[kCosTheta], uv[kPhi] ) *
+            polar( GDouble( 1 ), -uv[kBigPhi] );
+   }
+}
 
-   TVector3 angles( (p1_res.Vect()).Dot(x),
-         (p1_res.Vect()).Dot(y),
-         (p1_res.Vect()).Dot(z) );
+// the harmonic in GDouble or float, the amplitude always in GDouble
+template< class T >
+void
+Zlm::applyHarmonics( const GDouble* userVars, int nEvents, const complex< T >* harmonic,
+                     complex< GDouble >* amps ) const {
+
+   if( m_r == 1 ){
+
+      for( int i = 0; i < nEvents; ++i )
+         amps[i] = sqrt( 1 + m_s * userVars[i*kNumUserVars+kPgamma] ) *
+            GDouble( real( harmonic[i] ) );
+   }
+   else{
+
+      for( int i = 0; i < nEvents; ++i )
+         amps[i] = sqrt( 1 + m_s * userVars[i*kNumUserVars+kPgamma] ) *
+            GDouble( imag( harmonic[i] ) );
+   }
+}
 
-   userVars[kCosTheta] = angles.CosTheta();
-   userVars[kPhi] = angles.Phi();
+void
+Zlm::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
+
+   GDouble beam[4];
+   GDouble epsX, epsY;
+
+   if(m_polInTree) {
+      beam[0] = pKin[0][0]; beam[1] = 0.; beam[2] = 0.; beam[3] = pKin[0][0];
+      epsX = pKin[0][1]; epsY = pKin[0][2]; // makes default output gen_amp trees readable as well (without transforming)
+   } else {
+      beam[0] = pKin[0][0]; beam[1] = pKin[0][1]; beam[2] = pKin[0][2]; beam[3] = pKin[0][3];
+      epsX = cos(m_polAngle*TMath::DegToRad()); epsY = sin(m_polAngle*TMath::DegToRad()); // beam polarization vector
+   }
 
-   userVars[kBigPhi] = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
+   // helicity frame with the production plane normal taken from the lab momenta
+   twoBodyAngles( kHelicityLabNormal, beam, pKin[1], pKin[2], pKin[3],
+                  userVars[kCosTheta], userVars[kPhi] );
 
+   userVars[kBigPhi] = polarizationAngle( beam, pKin[1], epsX, epsY );
 
    GDouble pGamma;
    if(m_polInTree) {
-      pGamma = eps.Mag();
+      pGamma = sqrt( epsX * epsX + epsY * epsY );
    } else {
       if(m_polFraction > 0.) { // for fitting with constant polarization 
          pGamma = m_polFraction;
       } else{
-         int bin = m_polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-         if (bin == 0 || bin > m_polFrac_vs_E->GetXaxis()->GetNbins()){
-            pGamma = 0.;
-         } else 
-            pGamma = m_polFrac_vs_E->GetBinContent(bin);
+         pGamma = m_polFrac_vs_E->fraction(pKin[0][0]);
       }
    }
 
@@ -5,8 +5,9 @@
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/ZlmFixed.h"
 
-#include "TH1D.h"
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -36,7 +37,7 @@ class Zlm : public UserAmplitude< Zlm >
 
    public:
 
-      Zlm() : UserAmplitude< Zlm >() { };
+      Zlm() : UserAmplitude< Zlm >(), m_fixed( NULL ), m_harmonic( NULL ) { };
       Zlm( const vector< string >& args );
 
       enum UserVars { kPgamma = 0, kCosTheta, kPhi, kBigPhi, kNumUserVars };
@@ -44,9 +45,17 @@ class Zlm : public UserAmplitude< Zlm >
 
       string name() const { return "Zlm"; }
 
+      // loads the shared tables of an instance with args ahead of its
+      // construction (see AmplitudeRegistry::loadShared)
+      static void loadShared( const vector< string >& args );
+
       complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
       void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
 
+      // evaluates a block of events in one call (see AmplitudeBatch.h)
+      void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                               int nEvents, complex< GDouble >* amps ) const;
+
       // we can calcualte everything we need from userVars block so allow
       // the framework to purge the four-vectors
       bool needsUserVarsOnly() const { return true; }
@@ -73,7 +82,23 @@ class Zlm : public UserAmplitude< Zlm >
       double m_polFraction;
       bool m_polInTree;
 
-      TH1D* m_polFrac_vs_E;
+      const PolarizationTable* m_polFrac_vs_E;
+
+      // compile-time version for j <= ZLM_FIXED_MAX_J (see ZlmFixed.h)
+      ZlmFixedFunction m_fixed;
+
+      // Y_jm exp( -i Phi ) for j <= ZLM_FIXED_MAX_J, which calcAmplitudeBatch
+      // computes once per (j, m) for all (r, s) (see FactorCache)
+      typedef complex< GDouble > (*HarmonicFunction)( GDouble cosTheta, GDouble phi, GDouble bigPhi );
+      HarmonicFunction m_harmonic;
+
+      // the harmonics of a block for the factor cache, and the amplitudes
+      // from them
+      void fillHarmonics( const GDouble* userVars, int nEvents, complex< GDouble >* harmonic ) const;
+
+      template< class T >
+      void applyHarmonics( const GDouble* userVars, int nEvents, const complex< T >* harmonic,
+                           complex< GDouble >* amps ) const;
 };
 
 #endif
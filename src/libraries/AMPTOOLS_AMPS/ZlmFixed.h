@@ -0,0 +1,125 @@
+#if !defined(ZLMFIXED)
+#define ZLMFIXED
+
+#include <cmath>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+// Compile-time versions of the Zlm amplitude for fixed (j, m, r, s).
+// The associated Legendre recurrence is unrolled by the compiler for each
+// (j, m), and the choice of real or imaginary part and the sign in
+// sqrt(1 +/- P_gamma) are template arguments, so no branch is left in the
+// per-event evaluation.
+//
+// With P_lm the normalized associated Legendre function (including the
+// Condon-Shortley phase), Y_lm * exp(-i Phi) = P_lm * exp( i (m phi - Phi) )
+// so the real (r = +1) and imaginary (r = -1) parts only need one cosine
+// or sine each.
+
+// the largest j for which fixed versions are instantiated
+#define ZLM_FIXED_MAX_J 4
+
+typedef GDouble (*ZlmFixedFunction)( GDouble pGamma, GDouble cosTheta,
+                                     GDouble phi, GDouble bigPhi );
+
+// The real type T defaults to GDouble; the recurrence coefficients are
+// computed in double and then converted to T.
+
+// normalized sectoral function P_mm for m >= 0
+template< int M >
+struct ZlmSectoral {
+
+  template< class T >
+  static inline T eval( T sinTheta ){
+
+    return T( -sqrt( ( 2.0 * M + 1 ) / ( 2.0 * M ) ) ) * sinTheta *
+      ZlmSectoral< M - 1 >::eval( sinTheta );
+  }
+};
+
+template<>
+struct ZlmSectoral< 0 > {
+
+  // 1 / sqrt( 4 pi )
+  template< class T >
+  static inline T eval( T ){ return T( 0.28209479177387814 ); }
+};
+
+// normalized P_lm for l >= m >= 0; eval returns P_lm and sets prev to
+// P_{l-1,m} so the recurrence only visits each l once
+template< int L, int M >
+struct ZlmLegendre {
+
+  template< class T >
+  static inline T eval( T cosTheta, T sinTheta, T& prev ){
+
+    T prev2;
+    prev = ZlmLegendre< L - 1, M >::eval( cosTheta, sinTheta, prev2 );
+
+    const T a = T( sqrt( ( 4.0 * L * L - 1 ) / ( 1.0 * L * L - M * M ) ) );
+    const T b = T( sqrt( ( ( L - 1.0 ) * ( L - 1.0 ) - M * M ) /
+                         ( 4.0 * ( L - 1.0 ) * ( L - 1.0 ) - 1 ) ) );
+
+    return a * ( cosTheta * prev - b * prev2 );
+  }
+};
+
+template< int M >
+struct ZlmLegendre< M, M > {
+
+  template< class T >
+  static inline T eval( T, T sinTheta, T& prev ){
+
+    prev = 0;
+    return ZlmSectoral< M >::eval( sinTheta );
+  }
+};
+
+// P_lm * exp( i (m phi - Phi) ), which the four (r, s) of a (j, m) share;
+// re and im are its real and imaginary parts
+template< int J, int M, class T = GDouble >
+inline void
+zlmFixedHarmonic( T cosTheta, T phi, T bigPhi, T& re, T& im ){
+
+  const int absM = ( M < 0 ? -M : M );
+
+  T sinTheta = 1 - cosTheta * cosTheta;
+  sinTheta = ( sinTheta > 0 ? sqrt( sinTheta ) : 0 );
+
+  T prev;
+  T p = ZlmLegendre< J, absM >::eval( cosTheta, sinTheta, prev );
+
+  // Y_{l,-m} = (-1)^m conj( Y_lm )
+  if( M < 0 && absM % 2 == 1 ) p = -p;
+
+  T arg = M * phi - bigPhi;
+
+  re = p * cos( arg );
+  im = p * sin( arg );
+}
+
+template< int J, int M, int R, int S, class T = GDouble >
+inline T
+zlmFixed( T pGamma, T cosTheta, T phi, T bigPhi ){
+
+  // the part that is not taken is dropped by the compiler
+  T re, im;
+  zlmFixedHarmonic< J, M, T >( cosTheta, phi, bigPhi, re, im );
+
+  return sqrt( 1 + S * pGamma ) * ( R == 1 ? re : im );
+}
+
+// lists every (j, m) with j <= ZLM_FIXED_MAX_J, in the order j*(j+1)+m
+#define ZLM_FIXED_FOR_ALL( ENTRY ) \
+  ENTRY(0,0), \
+  ENTRY(1,-1), ENTRY(1,0), ENTRY(1,1), \
+  ENTRY(2,-2), ENTRY(2,-1), ENTRY(2,0), ENTRY(2,1), ENTRY(2,2), \
+  ENTRY(3,-3), ENTRY(3,-2), ENTRY(3,-1), ENTRY(3,0), ENTRY(3,1), ENTRY(3,2), \
+  ENTRY(3,3), \
+  ENTRY(4,-4), ENTRY(4,-3), ENTRY(4,-2), ENTRY(4,-1), ENTRY(4,0), ENTRY(4,1), \
+  ENTRY(4,2), ENTRY(4,3), ENTRY(4,4)
+
+// index of (r, s) in a row of the dispatch tables
+inline int zlmFixedIndex( int r, int s ){ return ( r == 1 ? 0 : 2 ) + ( s == 1 ? 0 : 1 ); }
+
+#endif
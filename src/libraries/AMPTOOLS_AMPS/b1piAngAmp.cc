@@ -45,14 +45,17 @@ b1piAngAmp::b1piAngAmp( const vector< string >& args ):
   int Iz_b1    = atoi( args[6].c_str() );
   int Iz_pi    = atoi( args[7].c_str() );
   
-  bool m_ORTHOCHECK = (args.size() == base_arg_num || tweakBW_omega || tweakBW_omega_b1);
+  // the extended argument set gives the couplings explicitly for the
+  // orthogonality check, which prints every evaluated amplitude
+  m_ORTHOCHECK = ( args.size() == 14 );
+  bool defaultCouplings = !m_ORTHOCHECK;
   
   // Note, the following have no effect since L_\omega & J_\rho
   // have been restricted to value 1
-  m_u_rho_1  = m_ORTHOCHECK ? sqrt(.9) : atoi( args[8].c_str());
-  m_u_rho_3  = m_ORTHOCHECK ? sqrt(.1) : atoi( args[9].c_str());
-  m_u_omega_1= m_ORTHOCHECK ? sqrt(.9) : atoi( args[10].c_str());
-  m_u_omega_3= m_ORTHOCHECK ? sqrt(.1) : atoi( args[11].c_str());
+  m_u_rho_1  = defaultCouplings ? sqrt(.9) : atoi( args[8].c_str());
+  m_u_rho_3  = defaultCouplings ? sqrt(.1) : atoi( args[9].c_str());
+  m_u_omega_1= defaultCouplings ? sqrt(.9) : atoi( args[10].c_str());
+  m_u_omega_3= defaultCouplings ? sqrt(.1) : atoi( args[11].c_str());
   
   mG0_omega = 0.0085;
   mG0_b1 = 0.143;
@@ -64,9 +67,9 @@ b1piAngAmp::b1piAngAmp( const vector< string >& args ):
   }
   
   const GDouble b1DSratio2 = 0.277*0.277; //from PDG: D/S amp ratio=0.277+/-0.027
-  m_u_b1_0   = m_ORTHOCHECK ? sqrt(1/(1 + b1DSratio2))
+  m_u_b1_0   = defaultCouplings ? sqrt(1/(1 + b1DSratio2))
   : atoi( args[12].c_str());
-  m_u_b1_2   = m_ORTHOCHECK ? sqrt(b1DSratio2/(1 + b1DSratio2))
+  m_u_b1_2   = defaultCouplings ? sqrt(b1DSratio2/(1 + b1DSratio2))
   : atoi( args[13].c_str());
 
                
@@ -97,6 +100,52 @@ b1piAngAmp::b1piAngAmp( const vector< string >& args ):
   mIz[3]=Iz_b1;
   mIz[5]=-1;
   mIz[6]=+1;
+
+  // tabulate the sum over photon and reflectivity helicities, which only
+  // depends on the quantum numbers of X and the beam polarization
+  int pol=(mpolBeam==1 ? +1 : -1); // y and x-pol. respectively
+  const int epsilon_R=mepsilon_R;
+  GDouble InvSqrt2=1/sqrt(2.0);
+
+  m_forbidden = ( mJ_X==0 && mPar_X*pol*epsilon_R == -1 );
+
+  //summing positive and negative helicity terms
+  for(int l_gamma=-1; l_gamma <= +1 ; l_gamma+=2){
+    for(int l_R=0; l_R <= mJ_X+1 ; l_R++){
+      if(l_R==0 && epsilon_R==-1) continue;
+
+      //summing positive and negative helicity terms of R's reflectivity state
+      for(int l_Rsign = +1; l_Rsign >= (l_R>0 ? -1:+1) ; l_Rsign-=2){
+	int m_X=l_gamma - l_Rsign * l_R;
+	if(m_X==0){
+	  //testing for cancelation in |J 0>+pol*P*epsilon_R*(-1)^J|J 0>
+	  if(mPar_X*pol*epsilon_R == (mJ_X % 2 ==0 ? -1:+1)) continue;
+	}else
+	  //enforcing that the selected projection <= vector magnitude 
+	  if( abs(m_X)>mJ_X) continue; 
+
+	HelicityTerm term;
+	term.m_X = m_X;
+	term.l_gamma = l_gamma;
+	term.coef =
+	  //Assemble reflectivity eigenvector with epsilon_X=pol*epslion_R
+	  (GDouble)(m_X<0 ? mPar_X*pol*epsilon_R*((mJ_X-m_X) % 2 == 0 ? +1:-1) : 1) * 
+	  (GDouble)(m_X == 0 ? 1.0 : InvSqrt2 ) *
+	  //to account for |eps_g> ~ (|1,-1>exp(-ia)-pol|1,+1>exp(ia)) 
+	  (GDouble)(l_gamma==1 ? -pol : 1) *
+	  // to apply th(l_R) reflectivity state prefactor: 
+	  // m=0: 1/2  m>0: 1/sqrt(2)  m<0: 0 (last just skipped in this sum)  
+	  (GDouble)(l_R > 0 ? InvSqrt2 : 1.0 ) *
+	  //apply coefficients to the reflectivity basis terms:
+	  (GDouble)(l_Rsign==1 ? 1 : epsilon_R);
+
+	m_terms.push_back(term);
+      }
+    }
+  }
+
+  for(int l_b1=-1; l_b1<=1; l_b1++)
+    m_cgX[l_b1+1] = CB(mL_X, 1, 0, l_b1, mJ_X, l_b1);
 }
 
 void PrintHEPvector(TLorentzVector &v){
@@ -124,15 +173,9 @@ TLorentzVector& MoveToRF(TLorentzVector &parent,
 
 inline complex <GDouble> b1piAngAmp::
 BreitWigner(GDouble m0, GDouble Gamma0, int L,
-	    TLorentzVector &P1, TLorentzVector &P2) const
+	    GDouble m, GDouble mass1, GDouble mass2) const
 {
   
-  TLorentzVector Ptot=P1+P2;
-  GDouble m  = Ptot.M();
-  GDouble mass1 = P1.M();
-  GDouble mass2 = P2.M();
-  
-  
   // assert positive breakup momenta     
   GDouble q0 = fabs( breakupMomentum(m0, mass1, mass2) );
   GDouble q  = fabs( breakupMomentum(m,  mass1, mass2) );
@@ -231,67 +274,34 @@ return epsilon_R==-1 ? m_v_m : (epsilon_R==+1 ? m_v_p);
 
 
 
-complex< GDouble >
-b1piAngAmp::calcAmplitude( GDouble** pKin ) const
+void
+b1piAngAmp::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 {
-  int m_X,IMLnum=0;
-  bool useCutoff=true;
-  complex <GDouble> i(0, 1), COne(1, 0),CZero(0,0);  
-
-  const vector< int >& perm = getCurrentPermutation();  
-  int Iz_b1 = mIz[perm[2]];
-  int Iz_pi = mIz[perm[3]];
-
-  if(abs(Iz_b1+Iz_pi) > mI_X) return CZero;
-
   TLorentzVector beam  (pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0]); 
   TLorentzVector recoil(pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0]);
-  GDouble InvSqrt2=1/sqrt(2.0);
   GDouble m0_rho=0.775,G0_rho=0.149;
-  GDouble m0_omega=0.783, m0_b1=1.223;
-
 
   //Exprected particle list: 
   // pi- b1(pi+ omega(pi0 "rho"(pi- pi+)))
   //  2      3         4         5   6
-                        
 
   TLorentzVector rhos_pip(pKin[6][1], pKin[6][2], pKin[6][3], pKin[6][0]);
   TLorentzVector rhos_pim(pKin[5][1], pKin[5][2], pKin[5][3], pKin[5][0]);
   TLorentzVector rho = rhos_pip + rhos_pim;
 
-  if( useCutoff && rho.M()+0.135 > m0_omega+3*mG0_omega){
-    //cout << "s";
-    return CZero;
-  }
-
   TLorentzVector omegas_pi(pKin[4][1], pKin[4][2], pKin[4][3], pKin[4][0]);
   TLorentzVector omega = rho + omegas_pi;
 
-  if(useCutoff && fabs(omega.M()-m0_omega) > 3*mG0_omega){
-    //cout << "s";
-    return CZero; 
-  }
-
   TLorentzVector b1s_pi(pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0]);
   TLorentzVector b1 = omega + b1s_pi;
 
-  if( useCutoff && (fabs(b1.M()-m0_b1) > 3*mG0_b1 ||
-		    b1.M() < (m0_omega - 3*mG0_omega)) ){
-    //cout << "s";
-    return CZero;
-  }
-
-  //printf("DEBUG: proceeding with b1pi amp calc. mG0_omega=%f, disbale BWomega=%d\n",mG0_omega,m_disableBW_omega);
-
   TLorentzVector Xs_pi(pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0]);
   TLorentzVector X = b1 + Xs_pi;
 
-  GDouble q = breakupMomentum( X.M(), b1.M(), Xs_pi.M() );
-
+  userVars[uv_q] = breakupMomentum( X.M(), b1.M(), Xs_pi.M() );
 
   // orientation of production plane in lab
-  GDouble alpha = recoil.Vect().Phi();
+  userVars[uv_alpha] = recoil.Vect().Phi();
   
   //Resonance RF, Godfried-Jackson frame
   TLorentzRotation XRFboost( -X.BoostVector() );
@@ -304,7 +314,6 @@ b1piAngAmp::calcAmplitude( GDouble** pKin ) const
   TVector3 yGJ = zGJ.Cross(recoil_XRF.Vect()).Unit();
   TVector3 xGJ = yGJ.Cross(zGJ);
 
-  
   TLorentzVector b1_XRF      = XRFboost * b1;
   TLorentzVector omega_XRF   = XRFboost * omega;
   TLorentzVector rho_XRF     = XRFboost * rho;
@@ -320,193 +329,137 @@ b1piAngAmp::calcAmplitude( GDouble** pKin ) const
   TVector3 ang_b1( (b1_XRF.Vect()).Dot(xGJ),
 		     (b1_XRF.Vect()).Dot(yGJ),
 		     (b1_XRF.Vect()).Dot(zGJ) );
-  
-  //printf("%f %f    %f %f \n",
-  // omega.M(), (rho+omegas_pi).M(),
-  //	 rho.M(), (rhos_pip+rhos_pim).M());
 
+  userVars[uv_cosThetaB1] = ang_b1.CosTheta();
+  userVars[uv_phiB1] = ang_b1.Phi();
 
-  // SUMMATION GUIDE:
-  // notation meant to resemble TeX symbols in derivation
-  // exception: pol = \epsilon_\gamma
-  // l -> lambda, indicating helicity
-  // u_[particle](q.n.) -> amplitude strength coefficient 
+  userVars[uv_mRho] = rho.M();
+  userVars[uv_mOmegasPi] = omegas_pi.M();
+  userVars[uv_mOmega] = omega.M();
+  userVars[uv_mB1sPi] = b1s_pi.M();
+  userVars[uv_mB1] = b1.M();
+
+  // J_rho = 1
+  complex< GDouble > bwRho = BreitWigner(m0_rho, G0_rho, 1, rho.M(), rhos_pip.M(), rhos_pim.M());
+  userVars[uv_reBWrho] = real(bwRho);
+  userVars[uv_imBWrho] = imag(bwRho);
 
-  int pol=(mpolBeam==1 ? +1 : -1); // y and x-pol. respectively
-  const int* epsilon_R=&mepsilon_R;
   GDouble rho_omegaRF_cosTheta=rho_omegaRF.CosTheta();
   GDouble rho_omegaRF_phi     =rho_omegaRF.Phi();
   GDouble rhos_pip_rhoRF_cosTheta=rhos_pip_rhoRF.CosTheta();
   GDouble rhos_pip_rhoRF_phi     =rhos_pip_rhoRF.Phi();
+  GDouble omega_b1RF_cosTheta=omega_b1RF.CosTheta();
+  GDouble omega_b1RF_phi     =omega_b1RF.Phi();
+
+  // Restricted L_omega=1, J_rho=1 combination only; the l_rho=0 term
+  // vanishes because CB(1,1,0,0;1,0)=0 ...change if introducing omega F-wave
+  complex< GDouble > A[3];
+  for(int l_omega=-1; l_omega<=1; l_omega++){
+    A[l_omega+1] = 0;
+    for(int l_rho=-1; l_rho<=1; l_rho+=2){
+      A[l_omega+1] += conj(wignerD(1, l_omega, l_rho,
+				   rho_omegaRF_cosTheta, rho_omegaRF_phi))*
+	CB(1, 1, 0, l_rho, 1, l_rho) *
+	Y(1, l_rho, rhos_pip_rhoRF_cosTheta, rhos_pip_rhoRF_phi);
+    }
+  }
 
+  for(int iL=0; iL<2; iL++){
+    int L_b1 = 2*iL;
+    for(int l_b1=-1; l_b1<=1; l_b1++){
+      complex< GDouble > B(0,0);
+      for(int l_omega=-1; l_omega<=1; l_omega++){
+	B += A[l_omega+1] *
+	  conj(wignerD(1, l_b1, l_omega, omega_b1RF_cosTheta, omega_b1RF_phi)) *
+	  CB(L_b1, 1, 0, l_omega, 1, l_omega);
+      }
+      userVars[uv_reB + 2*(3*iL + l_b1+1)] = real(B);
+      userVars[uv_reB + 2*(3*iL + l_b1+1) + 1] = imag(B);
+    }
+  }
+}
 
+complex< GDouble >
+b1piAngAmp::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
+{
+  bool useCutoff=true;
+  complex <GDouble> i(0, 1), COne(1, 0),CZero(0,0);  
 
-  // Prepare sets of quantum numbers over which to sum ----------
+  const vector< int >& perm = getCurrentPermutation();  
+  int Iz_b1 = mIz[perm[2]];
+  int Iz_pi = mIz[perm[3]];
 
-  // Full L_omega=1, J_rho=1 and L_omega=3, J_rho=3
-  /*int aList_J_rho[]={1,3}; 
-  vector<int> List_J_rho(aList_J_rho, aList_J_rho+2);
-  int aList_L_omega[]={1,3};  
-  vector<int> List_L_omega(aList_L_omega, aList_L_omega+2);
-  */
+  if(abs(Iz_b1+Iz_pi) > mI_X) return CZero;
+  if(m_forbidden) return CZero;
 
-  //Restricted  L_omega=1, J_rho=1 combination only
-  int aList_J_rho[]={1}; 
-  vector<int> List_J_rho(aList_J_rho, aList_J_rho+1);
-  int aList_L_omega[]={1};  
-  vector<int> List_L_omega(aList_L_omega, aList_L_omega+1);
+  GDouble InvSqrt2=1/sqrt(2.0);
+  GDouble m0_omega=0.783, m0_b1=1.223;
 
-  int aList_l_rho[]={-1,1}; //'0' term vanishes for L_omega=J_rho=1
-  // because CB(1,1,0,0;1,0)=0 ...change if introducing omega F-wave
-  vector<int> List_l_rho(aList_l_rho, aList_l_rho+2);
+  GDouble mRho = userVars[uv_mRho];
+  GDouble mOmega = userVars[uv_mOmega];
+  GDouble mB1 = userVars[uv_mB1];
 
-  int aList_l_omega[]={-1,0,1};   
-  vector<int> List_l_omega(aList_l_omega, aList_l_omega+3);
+  if( useCutoff && mRho+0.135 > m0_omega+3*mG0_omega){
+    return CZero;
+  }
 
-  int aList_L_b1[]={0,2};  
-  vector<int> List_L_b1(aList_L_b1,aList_L_b1+2);
+  if(useCutoff && fabs(mOmega-m0_omega) > 3*mG0_omega){
+    return CZero; 
+  }
 
-  //shortcut:  CB(L_X, J_b1, 0, l_b1 ; J_X, l_b1) vanishes when
-  //  = CB(1, 1, 0, 0 ; 1, 0),  so omit l_b1=0 when J_X=L_X=1
-  int aList_l_b1[3]={-1};
-  if(mL_X==1 && mJ_X==1)  aList_l_b1[1]=1;
-  else{
-    aList_l_b1[1]=0;
-    aList_l_b1[2]=1; }
-  vector<int> List_l_b1(aList_l_b1,aList_l_b1+
-			(mL_X==1 && mJ_X==1 ? 2 : 3));
-  // --------------------
-
-  vector<int> List_l_R;
-  for(int n=0; n <= mJ_X+1 ; n++) {
-    List_l_R.push_back(n);
-    //printf("List_l_R.push_back(%d)\n",n);
+  if( useCutoff && (fabs(mB1-m0_b1) > 3*mG0_b1 ||
+		    mB1 < (m0_omega - 3*mG0_omega)) ){
+    return CZero;
   }
-  
-  //int aList_epsilon_R[]={-1,1}; 
-  //vector<int> List_epsilon_R(aList_epsilon_R,aList_epsilon_R+2);
 
-  // End of q.n. set prep ----------------------------------------
+  GDouble q = userVars[uv_q];
 
+  // the rho and omega parts are common to all b1 terms (J_rho=L_omega=1)
+  complex< GDouble > front = u_rho(1) *
+    complex< GDouble >( userVars[uv_reBWrho], userVars[uv_imBWrho] );
+  if(!m_disableBW_omega) front *=
+    BreitWigner(m0_omega, mG0_omega, 1, mOmega, userVars[uv_mOmegasPi], mRho);
+  front *= u_omega(1) * N(1);
 
-  complex <GDouble> ThelSum(0,0);
+  complex< GDouble > L_b1DepTerm[3];
+  for(int l_b1=-1; l_b1<=1; l_b1++) L_b1DepTerm[l_b1+1] = 0;
 
-  if(mJ_X==0) if(mPar_X*pol*(*epsilon_R) ==  -1 ) return CZero;
+  for(int iL=0; iL<2; iL++){
+    int L_b1 = 2*iL;
+    complex< GDouble > b1Factor = front * u_b1(L_b1) * N(L_b1);
+    if(!m_disableBW_b1) b1Factor *=
+      BreitWigner(m0_b1, mG0_b1, L_b1, mB1, userVars[uv_mB1sPi], mOmega);
 
+    for(int l_b1=-1; l_b1<=1; l_b1++){
+      complex< GDouble > B( userVars[uv_reB + 2*(3*iL + l_b1+1)],
+			    userVars[uv_reB + 2*(3*iL + l_b1+1) + 1] );
+      L_b1DepTerm[l_b1+1] += b1Factor * B;
+    }
+  }
+
+  // l_b1DepTerm for each projection m_X = -J_X, ..., J_X
+  complex< GDouble > l_b1DepTerm[5];
+  for(int m_X=-mJ_X; m_X<=mJ_X; m_X++){
+    l_b1DepTerm[m_X+mJ_X] = 0;
+    for(int l_b1=-1; l_b1<=1; l_b1++){
+      if(m_cgX[l_b1+1] == 0) continue;
+      l_b1DepTerm[m_X+mJ_X] += L_b1DepTerm[l_b1+1] * m_cgX[l_b1+1] *
+	conj(wignerD(mJ_X, m_X, l_b1, userVars[uv_cosThetaB1], userVars[uv_phiB1]));
+    }
+  }
+
+  GDouble alpha = userVars[uv_alpha];
   complex <GDouble> expFact(cos(alpha), sin(alpha));
   complex <GDouble> expFact_conj(conj(expFact));
-  //summing positive and negative helicity terms
-  for(int l_gamma=-1; l_gamma <= +1 ; l_gamma+=2){
-    
-    //for(vector<int>::iterator epsilon_R=List_epsilon_R.begin();
-	//epsilon_R != List_epsilon_R.end() ; epsilon_R++){
-      
-      for(vector<int>::iterator l_R=List_l_R.begin(); 
-	  l_R != List_l_R.end() ; l_R++){
-	if(*l_R==0 && *epsilon_R==-1) continue;
-	
-	//summing positive and negative helicity terms of R's reflectivity state
-	for(int l_Rsign = +1; l_Rsign >= (*l_R>0 ? -1:+1) ; l_Rsign-=2){
-	  m_X=l_gamma - l_Rsign * (*l_R);
-	  if(m_X==0){
-	    //testing for cancelation in |J 0>+pol*P*epsilon_R*(-1)^J|J 0>
-	    if(mPar_X*pol*(*epsilon_R) == (mJ_X % 2 ==0 ? -1:+1)) continue;
-	  }else
-	    //enforcing that the selected projection <= vector magnitude 
-	    if( abs(m_X)>mJ_X) continue; 
-	  
-	  
-	  complex <GDouble> l_b1DepTerm(0,0);
-	  for(vector<int>::iterator l_b1=List_l_b1.begin(); 
-	      l_b1 != List_l_b1.end() ; l_b1++){
-	    
-	    complex <GDouble> L_b1DepTerm(0,0);
-	    for(vector<int>::iterator L_b1=List_L_b1.begin(); 
-		L_b1 != List_L_b1.end() ; L_b1++){
-	      
-	      complex <GDouble> l_omegaDepTerm(0,0);
-	      for(vector<int>::iterator l_omega=List_l_omega.begin(); 
-		  l_omega != List_l_omega.end() ; l_omega++){
-
-		complex <GDouble> L_omegaDepTerm(0,0);
-		//only odd L_omega allowed to given off J_rho to honor P_omega=-1
-		for(vector<int>::iterator L_omega=List_L_omega.begin(); 
-		    L_omega != List_L_omega.end() ; L_omega++){
-
-		  complex <GDouble> J_rhoDepTerm(0,0);
-		  for(vector<int>::iterator J_rho=List_J_rho.begin(); 
-		      J_rho != List_J_rho.end() ; J_rho++){
-
-		    //enforces triang. ineq. betw. J_omega=1, J_rho and L_omega
-		    if( abs(*J_rho-*L_omega) > 1) continue; 
-		    
-		    complex <GDouble> l_rhoDepTerm(0,0);
-		    for(vector<int>::iterator l_rho = List_l_rho.begin(); 
-			l_rho != List_l_rho.end() ; l_rho++){
-		      //shortcut CB(1,1,0,0;1,0)=0
-		      if(*L_omega==1 && *J_rho==1 && *l_rho==0) continue;
-		      l_rhoDepTerm+= conj(wignerD(1, *l_omega, *l_rho,
-						  rho_omegaRF_cosTheta, 
-						  rho_omegaRF_phi))*
-			CB(*L_omega, *J_rho, 0, *l_rho, 1, *l_rho) *
-			Y(*J_rho, *l_rho, rhos_pip_rhoRF_cosTheta, rhos_pip_rhoRF_phi);
-		      
-		      IMLnum++;
-		    }
-
-		    J_rhoDepTerm += u_rho(*J_rho) * l_rhoDepTerm *
-		      BreitWigner(m0_rho,G0_rho, *J_rho,rhos_pip,rhos_pim);
-		  }
-		  
-		  if(!m_disableBW_omega) J_rhoDepTerm*=
-		    BreitWigner(m0_omega,mG0_omega, *L_omega, omegas_pi,rho);
-		  
-		  L_omegaDepTerm += u_omega(*L_omega)*J_rhoDepTerm*N(*L_omega);
-		}
-		
-		l_omegaDepTerm += 
-		  L_omegaDepTerm *
-		  conj(wignerD(1, *l_b1, *l_omega, omega_b1RF.CosTheta(), 
-			       omega_b1RF.Phi())) *
-		  CB(*L_b1, 1, 0, *l_omega, 1, *l_omega);
-	      }
-	      
-	      if(!m_disableBW_b1) l_omegaDepTerm*=
-		BreitWigner(m0_b1, mG0_b1, *L_b1, b1s_pi, omega);
-	      
-	      L_b1DepTerm += u_b1(*L_b1)*l_omegaDepTerm * N(*L_b1);
-	    }
-	    
-	    l_b1DepTerm += 
-	      L_b1DepTerm * CB(mL_X, 1, 0, *l_b1, mJ_X, *l_b1)*
-	      conj(wignerD(mJ_X, m_X, *l_b1, ang_b1.CosTheta(), ang_b1.Phi()));
-	    
-	    
-	  }
-	  
-	  ThelSum += 
-	    //Assemble reflectivity eigenvector with epsilon_X=pol*epslion_R
-	    l_b1DepTerm*(GDouble)
-	    (m_X<0 ? mPar_X*pol*(*epsilon_R)*((mJ_X-m_X) % 2 == 0 ? +1:-1) : 1) * 
-	    (GDouble)(m_X == 0 ? 1.0 : InvSqrt2 ) *
-	    //to account for |eps_g> ~ (|1,-1>exp(-ia)-pol|1,+1>exp(ia)) 
-	    (l_gamma==1 ? (GDouble)(-pol)*expFact : expFact_conj)*
-	    // to apply th(l_R) reflectivity state prefactor: 
-	    // m=0: 1/2  m>0: 1/sqrt(2)  m<0: 0 (last just skipped in this sum)  
-	    (GDouble)(*l_R > 0 ? InvSqrt2 : 1.0 ) *
-	    //apply coefficients to the reflectivity basis terms:
-	    (GDouble)(l_Rsign==1 ? 1 : *epsilon_R); //v(*epsilon_R) *
-
-	}
-      }
-      //}
+
+  complex <GDouble> ThelSum(0,0);
+  for(unsigned int n=0; n<m_terms.size(); n++){
+    const HelicityTerm& term = m_terms[n];
+    ThelSum += l_b1DepTerm[term.m_X+mJ_X] * term.coef *
+      (term.l_gamma==1 ? expFact : expFact_conj);
   }
-  
 
-  /*printf("DEBUG: perm2=%d -> Iz_b1=%d\tperm3=%d -> Iz_pi=%d\t==>\t%f\t%d %d %d %d %d\n",
-	 perm[2],Iz_b1,perm[3],Iz_pi, CB(1, 1, Iz_b1, Iz_pi, mI_X, Iz_b1 + Iz_pi),
-	 mIz[2],mIz[3],mIz[4],mIz[5],mIz[6]);
-  */
+  int pol=(mpolBeam==1 ? +1 : -1); // y and x-pol. respectively
 
   ThelSum *= N(mL_X) * (GDouble)(mL_X==0 ? 1.0 : (mL_X==1 ? q : pow(q,mL_X))) *
     // to apply polarization fraction weights: 
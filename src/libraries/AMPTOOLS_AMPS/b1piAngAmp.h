@@ -43,14 +43,32 @@ public:
   
   string name() const { return "b1piAngAmp"; }
   
-  complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+  complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+  // The decay kinematics only depend on the event: the masses entering the
+  // cutoffs and Breit-Wigners, the b1 direction in the Gottfried-Jackson
+  // frame, and the omega and rho decay angular sums
+  //   B(l_b1, L_b1) = sum_{l_omega} CB(L_b1,1,0,l_omega;1,l_omega)
+  //                   D^1*_{l_b1,l_omega}(omega in b1 RF) A(l_omega)
+  //   A(l_omega)    = sum_{l_rho} CB(1,1,0,l_rho;1,l_rho)
+  //                   D^1*_{l_omega,l_rho}(rho in omega RF) Y_1^{l_rho}(pi+ in rho RF)
+  // for l_b1 = -1, 0, 1 and L_b1 = 0, 2, including the fixed rho Breit-Wigner.
+  enum UserVars { uv_alpha = 0, uv_q, uv_cosThetaB1, uv_phiB1,
+                  uv_mRho, uv_mOmegasPi, uv_mOmega, uv_mB1sPi, uv_mB1,
+                  uv_reBWrho, uv_imBWrho, uv_reB, kNumUserVars = uv_reB + 12 };
+  unsigned int numUserVars() const { return kNumUserVars; }
+
+  void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+  bool needsUserVarsOnly() const { return true; }
+  bool areUserVarsStatic() const { return true; }
 
   GDouble u_rho(int J_rho) const;
   GDouble u_omega(int L_omega) const;
   GDouble u_b1(int L_b1) const;
 
   inline complex<GDouble> BreitWigner(GDouble m0, GDouble Gamma0, int L,
-			       TLorentzVector &P1,TLorentzVector &P2) const;
+			       GDouble m, GDouble mass1, GDouble mass2) const;
   inline GDouble CB(int j1, int j2, int m1, int m2, int J, int M) const;
 
   inline GDouble N(int J) const;
@@ -71,6 +89,15 @@ private:
 
   vector< int > mIz;
 
+  // the terms of the sum over photon and reflectivity helicities: the
+  // projection m_X of J_X, the photon helicity and the constant coefficient
+  struct HelicityTerm { int m_X; int l_gamma; GDouble coef; };
+  vector< HelicityTerm > m_terms;
+  bool m_forbidden;
+
+  // CB(L_X, 1, 0, l_b1; J_X, l_b1) for l_b1 = -1, 0, 1
+  GDouble m_cgX[3];
+
 #ifdef GPU_ACCELERATION
   
   void launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const;
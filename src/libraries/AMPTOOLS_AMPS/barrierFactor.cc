@@ -1,6 +1,7 @@
 #include <cmath>
 #include "AMPTOOLS_AMPS/breakupMomentum.h"
 #include "AMPTOOLS_AMPS/barrierFactor.h"
+#include "AMPTOOLS_AMPS/barrierFormulas.h"
 
 
 // mass0 = mass of parent
@@ -24,43 +25,50 @@ double barrierFactor( double mass0, int spin, double mass1, double mass2 ){
 
 double barrierFactor ( double q, int spin ){
 
-        double barrier;
-        double z;
+        return barrierFactorT< double >( q, spin );
+	
+}
 
-        z = ( (q*q) / (0.1973*0.1973) );
 
-        switch (spin){
+namespace {
 
-          case 0:
-             barrier = 1.0;
-             break;
+template< int L >
+struct BarrierFromMasses {
 
-          case 1:
-             barrier = sqrt( (2.0*z) /
-                             (z + 1.0) );
-             break;
-        
-          case 2:
-             barrier = sqrt( (13.0*z*z) /
-                            ((z-3.0)*(z-3.0) + 9.0*z) );
-             break;
+  static void run( int n, const double* mass0, const double* mass1,
+                   const double* mass2, int stride,
+                   double* barrier, int barrierStride ){
 
-          case 3:
-             barrier = sqrt( (277.0*z*z*z) /
-                            (z*(z-15.0)*(z-15.0) + 
-                             9.0*(2.0*z-5.0)*(2.0*z-5.0)) );
-             break;
+    for( int i = 0; i < n; ++i )
+      barrier[i*barrierStride] =
+        barrierFactorL< L >( breakupMomentumT< double >( mass0[i*stride], mass1[i*stride],
+                                                         mass2[i*stride] ) );
+  }
+};
 
-          case 4:
-             barrier = sqrt( (12746.0*z*z*z*z) /
-                            ((z*z-45.0*z+105.0)*(z*z-45.0*z+105.0) +
-                             25.0*z*(2.0*z-21.0)*(2.0*z-21.0)) );
-             break;
+template< int L >
+struct BarrierFromQ {
 
-          default:
-             barrier = 0.0;
-        }
+  static void run( int n, const double* q, int stride,
+                   double* barrier, int barrierStride ){
 
-        return barrier;
-	
+    for( int i = 0; i < n; ++i )
+      barrier[i*barrierStride] = barrierFactorL< L >( q[i*stride] );
+  }
+};
+
+}
+
+void barrierFactor( int n, int spin, const double* mass0, const double* mass1,
+                    const double* mass2, int stride,
+                    double* barrier, int barrierStride ){
+
+        BARRIER_DISPATCH( spin, BarrierFromMasses,
+                          ( n, mass0, mass1, mass2, stride, barrier, barrierStride ) )
+}
+
+void barrierFactor( int n, int spin, const double* q, int stride,
+                    double* barrier, int barrierStride ){
+
+        BARRIER_DISPATCH( spin, BarrierFromQ, ( n, q, stride, barrier, barrierStride ) )
 }
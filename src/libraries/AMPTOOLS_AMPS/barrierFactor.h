@@ -13,4 +13,15 @@ double barrierFactor( double mass0, int spin, double mass1, double mass2 );
 
 double barrierFactor( double q, int spin );
 
+// batch versions for n events: the inputs of event i are x[i*stride] and
+// the barrier factor is written to barrier[i*barrierStride]; the spin is
+// resolved once for the whole batch
+
+void barrierFactor( int n, int spin, const double* mass0, const double* mass1,
+                    const double* mass2, int stride,
+                    double* barrier, int barrierStride = 1 );
+
+void barrierFactor( int n, int spin, const double* q, int stride,
+                    double* barrier, int barrierStride = 1 );
+
 #endif
@@ -0,0 +1,128 @@
+#if !defined(BARRIERFORMULAS)
+#define BARRIERFORMULAS
+
+#include <cmath>
+
+// The breakup momentum and the Blatt-Weisskopf barrier factors of the
+// host functions in breakupMomentum.h and barrierFactor.h.  T is the real
+// type.  The barrier factor for a fixed spin is a template so that loops
+// over events do not switch on the spin for every event.
+
+#define BARRIER_FUNC inline
+
+// mass0 = mass of parent
+// mass1 = mass of first daughter
+// mass2 = mass of second daughter
+//
+// the Kallen function in closed form,
+// lambda( m0^2, m1^2, m2^2 ) = ( m0^2 - (m1 + m2)^2 ) ( m0^2 - (m1 - m2)^2 )
+template< class T >
+BARRIER_FUNC T
+breakupMomentumT( T mass0, T mass1, T mass2 ){
+
+  T s = mass0 * mass0;
+  T sum = mass1 + mass2;
+  T diff = mass1 - mass2;
+
+  // fabs -- correct?  consistent w/ previous E852 code
+  return sqrt( fabs( ( s - sum * sum ) * ( s - diff * diff ) ) ) / ( T(2) * mass0 );
+}
+
+// z = q^2 / ( 0.1973 GeV )^2
+template< int L >
+struct BarrierZ {
+
+  // spins above 4 are not supported
+  template< class T >
+  static BARRIER_FUNC T eval( T ){ return T(0); }
+};
+
+template<>
+struct BarrierZ< 0 > {
+
+  template< class T >
+  static BARRIER_FUNC T eval( T ){ return T(1); }
+};
+
+template<>
+struct BarrierZ< 1 > {
+
+  template< class T >
+  static BARRIER_FUNC T eval( T z ){
+
+    return sqrt( ( T(2) * z ) / ( z + T(1) ) );
+  }
+};
+
+template<>
+struct BarrierZ< 2 > {
+
+  template< class T >
+  static BARRIER_FUNC T eval( T z ){
+
+    return sqrt( ( T(13) * z * z ) / ( ( z - T(3) ) * ( z - T(3) ) + T(9) * z ) );
+  }
+};
+
+template<>
+struct BarrierZ< 3 > {
+
+  template< class T >
+  static BARRIER_FUNC T eval( T z ){
+
+    return sqrt( ( T(277) * z * z * z ) /
+                 ( z * ( z - T(15) ) * ( z - T(15) ) +
+                   T(9) * ( T(2) * z - T(5) ) * ( T(2) * z - T(5) ) ) );
+  }
+};
+
+template<>
+struct BarrierZ< 4 > {
+
+  template< class T >
+  static BARRIER_FUNC T eval( T z ){
+
+    return sqrt( ( T(12746) * z * z * z * z ) /
+                 ( ( z * z - T(45) * z + T(105) ) * ( z * z - T(45) * z + T(105) ) +
+                   T(25) * z * ( T(2) * z - T(21) ) * ( T(2) * z - T(21) ) ) );
+  }
+};
+
+// q     = breakup momentum
+// L     = angular momentum of the decay
+template< int L, class T >
+BARRIER_FUNC T
+barrierFactorL( T q ){
+
+  return BarrierZ< L >::eval( ( q * q ) / T( 0.1973 * 0.1973 ) );
+}
+
+template< class T >
+BARRIER_FUNC T
+barrierFactorT( T q, int spin ){
+
+  switch( spin ){
+
+    case 0: return barrierFactorL< 0 >( q );
+    case 1: return barrierFactorL< 1 >( q );
+    case 2: return barrierFactorL< 2 >( q );
+    case 3: return barrierFactorL< 3 >( q );
+    case 4: return barrierFactorL< 4 >( q );
+    default: return T(0);
+  }
+}
+
+// calls F< L >::run( args ) for the spin known at run time, so a loop in
+// run is compiled once for every spin; spins above 4 use L = 5, whose
+// barrier factor is zero
+#define BARRIER_DISPATCH( spin, F, ARGS ) \
+  switch( spin ){ \
+    case 0: F< 0 >::run ARGS; break; \
+    case 1: F< 1 >::run ARGS; break; \
+    case 2: F< 2 >::run ARGS; break; \
+    case 3: F< 3 >::run ARGS; break; \
+    case 4: F< 4 >::run ARGS; break; \
+    default: F< 5 >::run ARGS; break; \
+  }
+
+#endif
@@ -1,5 +1,6 @@
 #include <cmath>
 #include "breakupMomentum.h"
+#include "barrierFormulas.h"
 
 // mass0 = mass of parent
 // mass1 = mass of first daughter
@@ -7,16 +8,24 @@
 
 double breakupMomentum( double mass0, double mass1, double mass2 ){
 	
-        double q;
+        return breakupMomentumT< double >( mass0, mass1, mass2 );
+	
+}
 
-	// fabs -- correct?  consistent w/ previous E852 code
-        q = sqrt( fabs(   mass0*mass0*mass0*mass0 + 
-						  mass1*mass1*mass1*mass1 +
-						  mass2*mass2*mass2*mass2 -
-						  2.0*mass0*mass0*mass1*mass1 -
-						  2.0*mass0*mass0*mass2*mass2 -
-						  2.0*mass1*mass1*mass2*mass2  ) ) / (2.0 * mass0);
+void breakupMomentum( int n, const double* mass0, const double* mass1,
+                      const double* mass2, int stride,
+                      double* q, int qStride ){
 
-        return q;
-	
+        // no branch in the loop, so the compiler can vectorize it
+        for( int i = 0; i < n; ++i )
+          q[i*qStride] = breakupMomentumT< double >( mass0[i*stride], mass1[i*stride],
+                                                      mass2[i*stride] );
+}
+
+void breakupMomentum( int n, double mass0, const double* mass1,
+                      const double* mass2, int stride,
+                      double* q, int qStride ){
+
+        for( int i = 0; i < n; ++i )
+          q[i*qStride] = breakupMomentumT< double >( mass0, mass1[i*stride], mass2[i*stride] );
 }
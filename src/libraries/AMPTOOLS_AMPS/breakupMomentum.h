@@ -7,4 +7,18 @@
 
 double breakupMomentum( double mass0, double mass1, double mass2 );
 
+// the breakup momentum of n events; the masses of event i are
+// massX[i*stride], e.g., stride = kNumUserVars for a block of user
+// variables, and q of event i is written to q[i*qStride]
+
+void breakupMomentum( int n, const double* mass0, const double* mass1,
+                      const double* mass2, int stride,
+                      double* q, int qStride = 1 );
+
+// the same for a fixed parent mass, e.g., the nominal mass of a resonance
+
+void breakupMomentum( int n, double mass0, const double* mass1,
+                      const double* mass2, int stride,
+                      double* q, int qStride = 1 );
+
 #endif
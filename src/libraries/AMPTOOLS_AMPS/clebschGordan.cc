@@ -2,6 +2,8 @@
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 
 #include <math.h>
+#include <stdlib.h>
+#include <vector>
 
 /* Name: s3j
 **       Evaluates 3j symbol
@@ -10,7 +12,7 @@
 **
 ** Notes: 
 **     - defining S3J_TEST enables the compilation of a very small test suite.
-**     - the maximum allowed factorial is S3J_MAX_FACT (currently 25!). 
+**     - the maximum allowed factorial is S3J_MAX_FACT (currently 170!, the largest double).
 **
 **
 ** This program is free software; you can redistribute it and/or  
@@ -28,7 +30,7 @@
 
 #define S3J_0		1e-10
 
-#define S3J_MAX_FACT	25
+#define S3J_MAX_FACT	171
 #define S3J_TEST
 
 #define S3J_EQUAL(a,b)		(fabs((a)-(b))<S3J_0)
@@ -99,15 +101,19 @@ double s3j(double j1, double j2, double j3,
 	int k, kmin, kmax;
 	int jpm1, jmm1, jpm2, jmm2, jpm3, jmm3;
 	int j1pj2mj3, j3mj2pm1, j3mj1mm2;
-	double ris, mult, f[S3J_MAX_FACT];
+	double ris, mult;
 	
-	f[0]=1.0;
-	mult=1.0;
-	for (k=1; k<S3J_MAX_FACT; ++k) {
+	/* the factorials are only computed once */
+	static const struct Factorials {
 		
-		f[k]=f[k-1]*mult;
-		mult+=1.0;
-	}
+		Factorials() {
+			
+			f[0]=1.0;
+			for (int n=1; n<S3J_MAX_FACT; ++n) f[n]=f[n-1]*n;
+		}
+		double f[S3J_MAX_FACT];
+	} factorials;
+	const double* f=factorials.f;
 	
 	jpm1=(int)(j1+m1);
 	if (!S3J_EQUAL(jpm1,j1+m1)) return 0.0;
@@ -165,7 +171,7 @@ double s3j(double j1, double j2, double j3,
 }
 
 
-double clebschGordan(int ij1, int ij2, int im1, int im2, int ij, int im) {
+static double clebschGordanS3j(int ij1, int ij2, int im1, int im2, int ij, int im) {
 	
 	int esp;
 	double cgris;
@@ -191,3 +197,76 @@ double clebschGordan(int ij1, int ij2, int im1, int im2, int ij, int im) {
 }
 
 
+
+
+namespace {
+
+const int kTableMaxJ = CLEBSCHGORDAN_TABLE_MAX_J;
+
+// the (j, m) with j <= kTableMaxJ, numbered j*j + j + m
+const int kNumJM = ( kTableMaxJ + 1 ) * ( kTableMaxJ + 1 );
+
+inline int jmIndex(int j, int m) { return j*j + j + m; }
+
+inline int tableIndex(int j1, int j2, int m1, int m2, int j) {
+	
+	return ( jmIndex(j1,m1)*kNumJM + jmIndex(j2,m2) )*( kTableMaxJ + 1 ) + j;
+}
+
+// <j1 m1; j2 m2 | j, m1 + m2> for all spins up to kTableMaxJ
+struct CGTable {
+	
+	CGTable() : values( kNumJM*kNumJM*( kTableMaxJ + 1 ), 0.0 ) {
+		
+		for (int j1=0; j1<=kTableMaxJ; ++j1)
+			for (int m1=-j1; m1<=j1; ++m1)
+				for (int j2=0; j2<=kTableMaxJ; ++j2)
+					for (int m2=-j2; m2<=j2; ++m2)
+						for (int j=abs(j1-j2); j<=kTableMaxJ && j<=j1+j2; ++j)
+							if (abs(m1+m2)<=j)
+								values[tableIndex(j1,j2,m1,m2,j)] = clebschGordanS3j(j1,j2,m1,m2,j,m1+m2);
+	}
+	
+	std::vector< double > values;
+};
+
+// initialization of a function-local static is thread-safe
+const CGTable& cgTable() {
+	
+	static const CGTable table;
+	return table;
+}
+
+// fill the table at static initialization rather than on the first call
+const CGTable& cgTableInit = cgTable();
+
+}
+
+
+double clebschGordan(int j1, int j2, int m1, int m2, int j, int m) {
+	
+	if (j1>=0 && j2>=0 && j>=0 &&
+		j1<=kTableMaxJ && j2<=kTableMaxJ && j<=kTableMaxJ) {
+		
+		if (m!=m1+m2 || abs(m1)>j1 || abs(m2)>j2) return 0;
+		return cgTable().values[tableIndex(j1,j2,m1,m2,j)];
+	}
+	
+	return clebschGordanS3j(j1,j2,m1,m2,j,m);
+}
+
+
+double threeJSymbol(int j1, int j2, int j3, int m1, int m2, int m3) {
+	
+	if (j1<0 || j2<0 || j3<0) return 0;
+	
+	if (j1<=kTableMaxJ && j2<=kTableMaxJ && j3<=kTableMaxJ) {
+		
+		/* ( j1 j2 j3; m1 m2 m3 ) = (-1)^(j1-j2-m3) <j1 m1; j2 m2 | j3 -m3> / sqrt(2 j3 + 1) */
+		double cg=clebschGordan(j1,j2,m1,m2,j3,-m3);
+		if ((j1-j2-m3)%2!=0) cg=-cg;
+		return cg/sqrt(2.0*j3+1);
+	}
+	
+	return s3j(j1,j2,j3,m1,m2,m3);
+}
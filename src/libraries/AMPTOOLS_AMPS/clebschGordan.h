@@ -1,8 +1,17 @@
 #if !defined(CLEBSCHGORDAN)
 #define CLEBSCHGORDAN
 
+// Coefficients with j1, j2, j <= CLEBSCHGORDAN_TABLE_MAX_J are read from a
+// table that is filled once at static initialization; larger spins are
+// evaluated with s3j.
+
+#define CLEBSCHGORDAN_TABLE_MAX_J 6
+
 double clebschGordan(int j1, int j2, int m1, int m2, int j, int m);
 
+// the 3j symbol for integer spins, from the same table
+double threeJSymbol(int j1, int j2, int j3, int m1, int m2, int m3);
+
 double s3j(double j1, double j2, double j3, 
 		   double m1, double m2, double m3);
 
@@ -20,8 +20,8 @@ dblRegge::dblRegge( const vector< string >& args ) :
         b = atof( args[2].c_str() );
 }
 
-complex< GDouble >
-dblRegge::calcAmplitude( GDouble** pKin ) const {
+void
+dblRegge::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
         TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] );
         TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] );
         TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] );
@@ -29,6 +29,35 @@ dblRegge::calcAmplitude( GDouble** pKin ) const {
 
         TLorentzVector resonance = p1 + p2;
 
+        double s12 = resonance.M2();
+        double t1 = (beam - p1).M2();
+        double t2 = (beam - p2).M2();
+        double s = (recoil + p1 + p2).M2();
+
+        double m1 = p1.M();
+        double m2 = p2.M();
+        double mP = recoil.M();
+
+        double breakupP = TMath::Power( (s*s + TMath::Power(m1, 4) + TMath::Power(m2,4)- 2*(m1*m1*(s + m2*m2) + m2*m2*s )), 0.5) / (2*TMath::Power(s12, 0.5));
+
+        double numericCoeff = TMath::Power(0.125 *TMath::Power((1/(4*M_PI)), 4)* (breakupP /(s*s +mP*mP*mP*mP - 2*s*mP*mP)  ), 0.5);
+
+        userVars[uv_s] = s;
+        userVars[uv_s12] = s12;
+        userVars[uv_s13] = (p1 + recoil).M2();
+        userVars[uv_s23] = (p2 + recoil).M2();
+        userVars[uv_t1] = t1;
+        userVars[uv_t2] = t2;
+        userVars[uv_u3] = t1 + t2 +s12 - (beam.M2() + p1.M2() + p2.M2());
+        userVars[uv_m1] = m1;
+        userVars[uv_m2] = m2;
+        userVars[uv_recoilM2] = recoil.M2();
+        userVars[uv_numericCoeff] = numericCoeff;
+}
+
+complex< GDouble >
+dblRegge::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
         double aPrime = 0.9;
 ///////////
         double tau1 = -1; //for Neutral case. Will be -1^J otherwise
@@ -39,17 +68,16 @@ dblRegge::calcAmplitude( GDouble** pKin ) const {
         complex<GDouble> TotalAmp;
         complex<GDouble> coeff1 = 0;
         complex<GDouble> coeff2 = 0;
-        double s12 = resonance.M2();
-        double s13 = (p1 + recoil).M2();
-        double s23 =  (p2 + recoil).M2();
-        double t1 = (beam - p1).M2();
-        double t2 = (beam - p2).M2();
-        double s = (recoil + p1 + p2).M2();
-        double u3 = t1 + t2 +s12 - (beam.M2() + p1.M2() + p2.M2());
+        double s12 = userVars[uv_s12];
+        double s13 = userVars[uv_s13];
+        double s23 = userVars[uv_s23];
+        double t1 = userVars[uv_t1];
+        double t2 = userVars[uv_t2];
+        double s = userVars[uv_s];
+        double u3 = userVars[uv_u3];
 
         complex<GDouble> ui (0,1);
 
-
 //fast eta:
         double a1 = aPrime*t1 + 0.5;
         double a2 = aPrime*u3 + 0.5;
@@ -72,7 +100,7 @@ dblRegge::calcAmplitude( GDouble** pKin ) const {
                 Amp1 = -(TMath::Power(aPrime*s,a1)*TMath::Power(aPrime*s23, a2-a1)*Xi1*Xi21*V1 +  TMath::Power(aPrime*s,a2)*TMath::Power(aPrime*s12, a1-a2)*Xi2*Xi12*V2);
 
 
-                coeff1 = (TMath::Power(-t1, 0.5) / p2.M()) * TMath::Power( (-u3/(4*recoil.M2())), 0.5*abs(lambda - lambdaP) ) ;
+                coeff1 = (TMath::Power(-t1, 0.5) / userVars[uv_m2]) * TMath::Power( (-u3/(4*userVars[uv_recoilM2])), 0.5*abs(lambda - lambdaP) ) ;
         }
 
 //fast pion:
@@ -94,21 +122,12 @@ dblRegge::calcAmplitude( GDouble** pKin ) const {
                 Amp2 = -(TMath::Power(aPrime*s,a1)*TMath::Power(aPrime*s13, a2-a1)*Xi1*Xi21*V1 +  TMath::Power(aPrime*s,a2)*TMath::Power(aPrime*s12, a1-a2)*Xi2*Xi12*V2);
 
 
-        coeff2 =  (TMath::Power(-t2, 0.5) / p1.M()) * TMath::Power( (-u3/(4*recoil.M2())), 0.5*abs(lambda - lambdaP) );
+        coeff2 =  (TMath::Power(-t2, 0.5) / userVars[uv_m1]) * TMath::Power( (-u3/(4*userVars[uv_recoilM2])), 0.5*abs(lambda - lambdaP) );
         }
 
         TotalAmp = coeff1*Amp1 + coeff2*Amp2;
-         
-        double m1 = p1.M();
-        double m2 = p2.M();
-        double mP = recoil.M();
-
-        double breakupP = TMath::Power( (s*s + TMath::Power(m1, 4) + TMath::Power(m2,4)- 2*(m1*m1*(s + m2*m2) + m2*m2*s )), 0.5) / (2*TMath::Power(s12, 0.5));
-
-        double numericCoeff = TMath::Power(0.125 *TMath::Power((1/(4*M_PI)), 4)* (breakupP /(s*s +mP*mP*mP*mP - 2*s*mP*mP)  ), 0.5);
-
 
-        TotalAmp = TotalAmp*numericCoeff;
+        TotalAmp = TotalAmp*userVars[uv_numericCoeff];
         
         return TotalAmp;
 }
@@ -25,7 +25,18 @@ public:
 
         string name() const { return "dblRegge"; }
 
-        complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+        complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+        // the invariants, the daughter masses and the phase space factor
+        // only depend on the kinematics, so all instances share them
+        enum UserVars { uv_s = 0, uv_s12, uv_s13, uv_s23, uv_t1, uv_t2, uv_u3,
+                        uv_m1, uv_m2, uv_recoilM2, uv_numericCoeff, kNumUserVars };
+        unsigned int numUserVars() const { return kNumUserVars; }
+
+        void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+        bool needsUserVarsOnly() const { return true; }
+        bool areUserVarsStatic() const { return true; }
 
 private:
 
@@ -9,6 +9,7 @@
 #include "TLorentzRotation.h"
 
 #include "IUAmpTools/Kinematics.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
 #include "dblReggeMod.h"
 
 dblReggeMod::dblReggeMod( const vector< string >& args ) :
@@ -30,8 +31,8 @@ dblReggeMod::dblReggeMod( const vector< string >& args ) :
 	registerParameter( S0 );
 }
 
-complex< GDouble >
-dblReggeMod::calcAmplitude( GDouble** pKin ) const {
+void
+dblReggeMod::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 	TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] );
 	TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] );
 	TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] );
@@ -39,36 +40,14 @@ dblReggeMod::calcAmplitude( GDouble** pKin ) const {
 
 	TLorentzVector resonance = p1 + p2;
 
-	double mass2[4] = {beam.M2(), p1.M2(), p2.M2(), recoil.M2()};
+	double ma2 = beam.M2(), m12 = p1.M2(), m22 = p2.M2(), m32 = recoil.M2();
 
 	double s12 = resonance.M2();
-	//double s13 = (p1 + recoil).M2();
 	double s23 =  (p2 + recoil).M2();
 	double t1 = (beam - p1).M2();
-	double t2 = (beam - p2).M2();
 	double s = (recoil + p1 + p2).M2();
-	double u3 = t1 + t2 +s12 - (beam.M2() + p1.M2() + p2.M2());
-
-
-	double param[4] = {a_eta,a_pi,b_eta,b_pi};
-	double inv[5] = {s, s12, s23, t1 ,u3};
-//	double varGJ[5] = {s,s12,u3, theta, phi};
-
-	int hel[3] = {1,-1,-1};
-	std::complex<double> amp = ampEtaPi0(param, hel, inv, mass2);
-
-	return amp;
-}
-
-
-std::complex<double> dblReggeMod::ampEtaPi0(double par[4], int hel[3], double inv[5], double mass2[4]) const{
-
-	std::complex<double> zero (0,0);
+	double u3 = t1 + (beam - p2).M2() + s12 - (ma2 + m12 + m22);
 
-	double s,s12,s23,t1,u3;
-	double m12, m22, m32, ma2, mb2;
-	s   = inv[0];   s12 = inv[1];   s23 = inv[2];   t1  = inv[3];   u3  = inv[4];
-	ma2 = mass2[0]; m12 = mass2[1]; m22 = mass2[2]; m32 = mass2[3];
 	double t2  = -t1+u3-s12+ma2+m12+m22;
 	double s13 = s-s12-s23+m12+m22+m32;
 
@@ -78,59 +57,120 @@ std::complex<double> dblReggeMod::ampEtaPi0(double par[4], int hel[3], double in
 	double alp0pi0 = app*t2 + 0.5;
 	double alp1    = app*u3 + 0.5;
 
+	// helicity part
+	int hel[3] = {1,-1,-1};
+	double fac1 =  sqrt(-t1/m22);
+	double fac2 = sqrt(-t2/m22);    // use the pion mass in both fac1 and fac2
+	double fac3 = pow(-u3/4./ma2,abs((hel[1]-hel[2])/4.)); // hel[1,2] are twice the nucleon helicities!
+	double parity = pow(-1,(hel[1]-hel[2])/2.);
+	if(hel[1] == -1){fac3 = fac3*parity;}
+
+	userVars[uv_s] = s;
+	userVars[uv_s12] = s12;
+	userVars[uv_t1] = t1;
+	userVars[uv_t2] = t2;
+	userVars[uv_alp1] = alp1;
+	userVars[uv_fac1] = fac3*fac1;
+	userVars[uv_fac2] = fac3*fac2;
 
+	double si1[2] = {s23, s13};
+	double alp0[2] = {alp0eta, alp0pi0};
+
+	std::complex<double> ui (0,1);
 	int tau[2] = {-1, -1};    // only vector exchange
-	double si[2] = {s12,s23};
-	double alp[2] = {alp0eta, alp1};
 
+	for( int i = 0; i < 2; i++ ){
 
-	std::complex<double> ADR1 = DoubleRegge(tau, s, si, alp); // fast eta
+		GDouble* term = userVars + ( i == 0 ? uv_eta : uv_pi0 );
 
+		term[dr_si1] = si1[i];
+		term[dr_alp0] = alp0[i];
 
-	si[1] = s13; alp[0] = alp0pi0;
+		// signature factors:
+		std::complex<double> x0  = 1/2.*((double)tau[0] + exp(-ui*M_PI*alp0[i]));
+		std::complex<double> x1  = 1/2.*((double)tau[1] + exp(-ui*M_PI*alp1));
+		std::complex<double> x01 = 1/2.*((double)tau[0]*tau[1] + exp(-ui*M_PI*(alp0[i]-alp1)));
+		std::complex<double> x10 = 1/2.*((double)tau[1]*tau[0] + exp(-ui*M_PI*(alp1-alp0[i])));
 
-	std::complex<double> ADR2 = DoubleRegge(tau, s, si, alp); // fast pi0
+		// the double Regge vertices V12(a1,a2) carry Gamma(a1-a2)/Gamma(-a2)
+		// and the amplitude an overall Gamma(-alp0)*Gamma(-alp1)
+		std::complex<double> K0 = 0, K1 = 0;
+		if( alp0[i] != alp1 ){
 
-	// helicity part
-	double fac1 =  sqrt(-t1/mass2[2]);
-	double fac2 = sqrt(-t2/mass2[2]);    // use the pion mass in both fac1 and fac2
-	double fac3 = pow(-u3/4./mass2[0],abs((hel[1]-hel[2])/4.)); // hel[1,2] are twice the nucleon helicities!
-	double parity = pow(-1,(hel[1]-hel[2])/2.);
-	if(hel[1] == -1){fac3 = fac3*parity;}
+			K0 = x0*x10*cgamma(alp0[i]-alp1,0)*cgamma(-alp0[i],0);
+			K1 = x1*x01*cgamma(alp1-alp0[i],0)*cgamma(-alp1,0);
+		}
+
+		term[dr_reK0] = real(K0);
+		term[dr_imK0] = imag(K0);
+		term[dr_reK1] = real(K1);
+		term[dr_imK1] = imag(K1);
+	}
+}
+
+complex< GDouble >
+dblReggeMod::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
 
-	double Bot1 = a_eta*exp(b_eta*t1);
-	double Bot2 = a_pi*exp(b_pi*t2);
+	std::complex<double> ADR1 = DoubleRegge(userVars, userVars + uv_eta); // fast eta
+	std::complex<double> ADR2 = DoubleRegge(userVars, userVars + uv_pi0); // fast pi0
 
-	return fac3*(Bot1*fac1*ADR1 + Bot2*fac2*ADR2 );
+	double Bot1 = a_eta*exp(b_eta*userVars[uv_t1]);
+	double Bot2 = a_pi*exp(b_pi*userVars[uv_t2]);
+
+	return Bot1*userVars[uv_fac1]*ADR1 + Bot2*userVars[uv_fac2]*ADR2;
 }
 
-std::complex<double> dblReggeMod::V12(double alp1, double alp2, double eta) const{
+void
+dblReggeMod::calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+                                 int nEvents, complex< GDouble >* amps ) const
+{
+	if( nEvents <= 0 ) return;
+
+	// the double Regge terms only depend on S0, so they are kept while
+	// only the couplings and slopes move; every instance with the same S0
+	// shares them
+	bool filled;
+	complex< GDouble >* ADR =
+		FactorCache::lookup( FactorCache::kDblReggeVertices, NULL, 0, userVars,
+		                     nEvents, kNumUserVars, 2, S0, filled );
+
+	for( int i = 0; i < nEvents; ++i ){
+
+		const GDouble* uv = userVars + i * kNumUserVars;
 
-	if(alp1==alp2 ){return 0.0;}
-	std::complex<double> res = CHGM(-alp1, 1.-alp1+alp2, -1/eta);
-	res *= cgamma(alp1-alp2,0)/cgamma(-alp2,0);
+		if( !filled ){
 
-	return res;
+			ADR[2*i] = DoubleRegge(uv, uv + uv_eta);
+			ADR[2*i+1] = DoubleRegge(uv, uv + uv_pi0);
+		}
+
+		amps[i] = (GDouble)(a_eta*exp(b_eta*uv[uv_t1])*uv[uv_fac1])*ADR[2*i] +
+			(GDouble)(a_pi*exp(b_pi*uv[uv_t2])*uv[uv_fac2])*ADR[2*i+1];
+	}
 }
 
-std::complex<double> dblReggeMod::DoubleRegge(int tau[2], double s, double si[2], double alp[2]) const{
-	std::complex<double> ui (0,1);
-	// signature factors:
-	std::complex<double> x0  = 1/2.*((double)tau[0] + exp(-ui*M_PI*alp[0]));
-	std::complex<double> x1  = 1/2.*((double)tau[1] + exp(-ui*M_PI*alp[1]));
-	std::complex<double> x01 = 1/2.*((double)tau[0]*tau[1] + exp(-ui*M_PI*(alp[0]-alp[1])));
-	std::complex<double> x10 = 1/2.*((double)tau[1]*tau[0] + exp(-ui*M_PI*(alp[1]-alp[0])));
+std::complex<double> dblReggeMod::DoubleRegge(const GDouble* userVars, const GDouble* term) const{
+
+	double s = userVars[uv_s];
+	double si[2] = {userVars[uv_s12], term[dr_si1]};
+	double alp[2] = {term[dr_alp0], userVars[uv_alp1]};
+
+	std::complex<double> K0 (term[dr_reK0], term[dr_imK0]);
+	std::complex<double> K1 (term[dr_reK1], term[dr_imK1]);
+
+	// both vertices vanish for equal trajectories
+	if(K0 == 0.0 && K1 == 0.0){return 0.0;}
+
 	// double Regge vertices:
 	double eta = S0*s/(si[0]*si[1]);
-	std::complex<double> V0 = V12(alp[0], alp[1], eta);
-	std::complex<double> V1 = V12(alp[1], alp[0], eta);
-		
-	// combine pieces:
-	std::complex<double> t1 = pow(s/S0,alp[1])*pow(si[0]/S0,alp[0]-alp[1])*x1*x01*V1;
-	std::complex<double> t0 = pow(s/S0,alp[0])*pow(si[1]/S0,alp[1]-alp[0])*x0*x10*V0;
+	std::complex<double> V0 = CHGM(-alp[0], 1.-alp[0]+alp[1], -1/eta);
+	std::complex<double> V1 = CHGM(-alp[1], 1.-alp[1]+alp[0], -1/eta);
 
+	// combine pieces:
+	std::complex<double> t1 = pow(s/S0,alp[1])*pow(si[0]/S0,alp[0]-alp[1])*K1*V1;
+	std::complex<double> t0 = pow(s/S0,alp[0])*pow(si[1]/S0,alp[1]-alp[0])*K0*V0;
 
-	return (t0+t1)*cgamma(-alp[0],0)*cgamma(-alp[1],0);;
+	return t0+t1;
 }
 
 
@@ -310,6 +350,8 @@ double dblReggeMod::CHGM(double A, double B, double X) const{
 void
 dblReggeMod::updatePar( const AmpParameter& par ){
 
-	// could do expensive calculations here on parameter updates
-	//
+	// the gamma functions are in the user variables; the confluent
+	// hypergeometric functions depend on the kinematics of each event as
+	// well as on S0, so they are cached per block of events instead (see
+	// calcAmplitudeBatch)
 }
@@ -25,13 +25,32 @@ public:
 
         string name() const { return "dblReggeMod"; }
 
-        complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+        complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// the invariants, the helicity factors and everything in the two
+	// double Regge terms that does not depend on S0 (the signature factors
+	// and all gamma functions) are computed once per event; the block of
+	// a double Regge term (fast eta or fast pi0) holds the invariant mass
+	// of the recoil and the slow meson, the trajectory of the fast meson and
+	// the complex coefficients K0 and K1 of its two terms
+	enum DoubleReggeVars { dr_si1 = 0, dr_alp0, dr_reK0, dr_imK0, dr_reK1, dr_imK1, kDRSize };
+	enum UserVars { uv_s = 0, uv_s12, uv_t1, uv_t2, uv_alp1, uv_fac1, uv_fac2,
+	                uv_eta, uv_pi0 = uv_eta + kDRSize, kNumUserVars = uv_pi0 + kDRSize };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	bool needsUserVarsOnly() const { return true; }
+	bool areUserVarsStatic() const { return true; }
+
+	// evaluates a block of events in one call (see AmplitudeBatch.h)
+	void calcAmplitudeBatch( GDouble** const* pKin, const GDouble* userVars,
+	                         int nEvents, complex< GDouble >* amps ) const;
+
 	double CHGM(double A, double B, double X) const;
 	std::complex<double> cgamma(std::complex<double> z,int OPT) const;
 	void updatePar( const AmpParameter& par );
-	std::complex<double> V12(double alp1, double alp2, double eta) const;
-	std::complex<double> DoubleRegge(int tau[2], double s, double si[2], double alp[2]) const;
-	std::complex<double> ampEtaPi0(double par[4], int hel[3],  double inv[5], double mass2[4]) const;
+	std::complex<double> DoubleRegge(const GDouble* userVars, const GDouble* term) const;
 
 
 private:
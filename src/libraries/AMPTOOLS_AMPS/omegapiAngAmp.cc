@@ -24,9 +24,7 @@
 #include <vector>
 #include "TMath.h"
 
-TLorentzVector targetopi(0,0,0,0.938);
-
- double pararray[22];
+int J_spin(int ialpha);
 
 //Create array of lmLM:
 int lmLM[25][4] = {{0,0,0,0}, {0,0,2,0}, {0,0,2,1}, {0,0,2,2}, {2,0,0,0}, {2,0,2,0}, {2,0,2,1}, {2,0,2,2}, {2,1,2,0}, {2,1,2,1}, {2,1,2,2}, {2,2,2,0}, {2,2,2,1}, {2,2,2,2}, {2,1,1,1}, {0,0,1,0}, {0,0,1,1}, {2,1,1,0}, {2,1,1,1}, {2,1,2,1}, {2,1,2,2}, {2,2,2,1}, {2,2,2,2}, {2,0,1,0}, {2,0,1,1}};
@@ -58,12 +56,13 @@ double calpha(int alpha)
   return normalization;
 }
 
-double hmoment(int alpha, vector<double> vector)
+// angles = theta, phi, thetaH, phiH
+double hmoment(int alpha, const double* angles)
 {
-  double loccostheta = TMath::Cos(vector[0]);
-  double locphi = vector[1];
-  double loccosthetaH = TMath::Cos(vector[2]);
-  double locphiH = vector[3];
+  double loccostheta = TMath::Cos(angles[0]);
+  double locphi = angles[1];
+  double loccosthetaH = TMath::Cos(angles[2]);
+  double locphiH = angles[3];
 
   int l = lmLM[alpha][0];
   int m = lmLM[alpha][1];
@@ -151,28 +150,33 @@ omegapiAngAmp::omegapiAngAmp( const vector< string >& args ):
 
   registerParameter(m_ds_ratio);
 
-    pararray[0] = m_1p;
-    pararray[1] = m_w_1p;
-    pararray[2] = m_n_1p;
-    pararray[3] = m_1m;
-    pararray[4] = m_w_1m;
-    pararray[5] = m_n_1m;
-    pararray[6] = m_0m;
-    pararray[7] = m_w_0m;
-    pararray[8] = m_n_0m;
-    pararray[9] = m_ds_ratio;
-    pararray[10] = m_phi0_1p;
-    pararray[11] = m_theta_1p;
-    pararray[12] = m_phip_1p;
-    pararray[13] = m_phim_1p;
-    pararray[14] = m_psi_1p;
-    pararray[15] = m_phi0_1m;
-    pararray[16] = m_theta_1m;
-    pararray[17] = m_phip_1m;
-    pararray[18] = m_phim_1m;
-    pararray[19] = m_psi_1m;
-    pararray[20] = m_phi0_0m;
-    pararray[21] = m_theta_0m;
+  polFrac_vs_E = NULL;
+
+  // the parameter independent factors of the moments
+  for (int alpha = 0; alpha < 25; alpha++) {
+    int l = lmLM[alpha][0];
+    int m = lmLM[alpha][1];
+    int L = lmLM[alpha][2];
+    m_cgMoment[alpha] = clebschGordan(1, l, 0, 0, 1, 0);
+    for (int ialpha = 0; ialpha < 3; ialpha++) {
+      for (int ibeta = 0; ibeta < 3; ibeta++) {
+        for (int lambda = -1; lambda < 2; lambda++) {
+          for (int lambdaprime = -1; lambdaprime < 2; lambdaprime++) {
+            m_cgLlm[alpha][ialpha][ibeta][lambda+1][lambdaprime+1] = clebschGordan(J_spin(ibeta), L, lambdaprime, m, J_spin(ialpha), lambda) * clebschGordan(1, l, lambdaprime, m, 1, lambda);
+          }
+        }
+      }
+    }
+  }
+  for (int ialpha = 0; ialpha < 3; ialpha++) {
+    for (int l = 0; l < 3; l++) {
+      for (int lambda = -1; lambda < 2; lambda++) {
+        m_cgLsum[ialpha][l][lambda+1] = TMath::Sqrt((2.0*l + 1.0)/(2.0*J_spin(ialpha) + 1.0)) * clebschGordan(l, 1, 0, lambda, J_spin(ialpha), lambda);
+      }
+    }
+  }
+
+  setParameters();
 }
 
 //Define breakup momentum (x here is the measured mass of the omegapi)
@@ -336,44 +340,135 @@ std::complex<double> t_star_LM(double phi0, double theta, double phiplus, double
   return t_star_LM_par;
 }
 
-double SingleIntensity(double x, double *pararray, int l, int m, int L, int M, int ialpha, int ibeta) {
-    double single_intensity = 0.;
-    double phiplus_alpha = 0;
-    double phiminus_alpha = 0;
-    double psi_alpha = 0;
-    double phiplus_beta = 0;
-    double phiminus_beta = 0;
-    double psi_beta = 0;
-    if (ialpha < 2) {
-      phiplus_alpha = pararray[5*ialpha + 12];
-      phiminus_alpha = pararray[5*ialpha + 13];
-      psi_alpha = pararray[5*ialpha + 14];
+////////////////////////////////////////////////// Parameters //////////////////////////////////
+
+void
+omegapiAngAmp::setParameters() {
+
+    m_pararray[0] = m_1p;
+    m_pararray[1] = m_w_1p;
+    m_pararray[2] = m_n_1p;
+    m_pararray[3] = m_1m;
+    m_pararray[4] = m_w_1m;
+    m_pararray[5] = m_n_1m;
+    m_pararray[6] = m_0m;
+    m_pararray[7] = m_w_0m;
+    m_pararray[8] = m_n_0m;
+    m_pararray[9] = m_ds_ratio;
+    m_pararray[10] = m_phi0_1p;
+    m_pararray[11] = m_theta_1p;
+    m_pararray[12] = m_phip_1p;
+    m_pararray[13] = m_phim_1p;
+    m_pararray[14] = m_psi_1p;
+    m_pararray[15] = m_phi0_1m;
+    m_pararray[16] = m_theta_1m;
+    m_pararray[17] = m_phip_1m;
+    m_pararray[18] = m_phim_1m;
+    m_pararray[19] = m_psi_1m;
+    m_pararray[20] = m_phi0_0m;
+    m_pararray[21] = m_theta_0m;
+
+  // the production density matrix part of each moment does not depend on
+  // the event, so it is only evaluated when a parameter changes
+  for (int alpha = 0; alpha < 25; alpha++) {
+    for (int ialpha = 0; ialpha < 3; ialpha++) {
+      for (int ibeta = 0; ibeta < 3; ibeta++) {
+
+        double phiplus_alpha = 0;
+        double phiminus_alpha = 0;
+        double psi_alpha = 0;
+        double phiplus_beta = 0;
+        double phiminus_beta = 0;
+        double psi_beta = 0;
+        if (ialpha < 2) {
+          phiplus_alpha = m_pararray[5*ialpha + 12];
+          phiminus_alpha = m_pararray[5*ialpha + 13];
+          psi_alpha = m_pararray[5*ialpha + 14];
+        }
+        if (ibeta < 2) {
+          phiplus_beta = m_pararray[5*ibeta + 12];
+          phiminus_beta = m_pararray[5*ibeta + 13];
+          psi_beta = m_pararray[5*ibeta + 14];
+        }
+
+        m_tStar[alpha][ialpha][ibeta] = t_star_LM(m_pararray[5*ialpha + 10], m_pararray[5*ialpha + 11], phiplus_alpha, phiminus_alpha, psi_alpha, m_pararray[5*ibeta + 10], m_pararray[5*ibeta + 11], phiplus_beta, phiminus_beta, psi_beta, ialpha, ibeta, lmLM[alpha][2], lmLM[alpha][3]);
+      }
+    }
+  }
+}
+
+// The intensity summed over the moments, sum_alpha I_alpha(x) * moment[alpha],
+// where the moments already include the normalization c_alpha.  The mass
+// dependent F_alpha_lambda are evaluated once per resonance and helicity
+// and shared by all moments.
+double
+omegapiAngAmp::momentSum(double x, const GDouble* moment) const {
+
+  // F[l/2][ialpha][lambda+1]; the moments have l = 0 or 2
+  std::complex<double> F[2][3][3];
+
+  for (int ialpha = 0; ialpha < 3; ialpha++) {
+
+    double resonancemass = m_pararray[3*ialpha + 0];
+    double resonancewidth = m_pararray[3*ialpha + 1];
+    double G_alpha = m_pararray[3*ialpha + 2];
+
+    double lsumv[3] = {0, 0, 0};
+    for (int l = 0; l < 3; l++) {
+      double c_alpha; //partial wave amplitudes
+      if (l == 1 && (ialpha == 1 || ialpha == 2))
+        c_alpha = 1;
+      else if (l == 2 && ialpha == 0)
+        c_alpha = m_pararray[9];
+      else if (l == 0 && ialpha == 0)
+        c_alpha = 1;
+      else
+        continue;
+      double br = barrierratio(x, resonancemass, l);
+      for (int lambda = -1; lambda < 2; lambda++)
+        lsumv[lambda+1] += m_cgLsum[ialpha][l][lambda+1] * c_alpha * br;
     }
-    if (ibeta < 2) {
-      phiplus_beta = pararray[5*ibeta + 12];
-      phiminus_beta = pararray[5*ibeta + 13];
-      psi_beta = pararray[5*ibeta + 14];
+
+    for (int il = 0; il < 2; il++) {
+      std::complex<double> D = D_alpha(x, resonancemass, resonancewidth, 2*il) * G_alpha;
+      for (int lambda = -1; lambda < 2; lambda++)
+        F[il][ialpha][lambda+1] = D * lsumv[lambda+1];
     }
+  }
 
-    single_intensity = std::real(t_star_LM(pararray[5*ialpha + 10], pararray[5*ialpha + 11], phiplus_alpha, phiminus_alpha, psi_alpha, pararray[5*ibeta + 10], pararray[5*ibeta + 11], phiplus_beta, phiminus_beta, psi_beta, ialpha, ibeta, L, M) * f_Llm(x, pararray[3*ialpha + 0], pararray[3*ialpha + 1], pararray[3*ialpha + 2], ialpha, pararray[3*ibeta + 0], pararray[3*ibeta + 1], pararray[3*ibeta + 2], ibeta, pararray[9], l, m, L) * clebschGordan(1, l, 0, 0, 1, 0));
-    //cout << "single intensity = " << single_intensity << endl;
+  double sum = 0;
 
-  return single_intensity;
-}
+  for (int alpha = 0; alpha < 25; alpha++) {
 
-double Intensity(double x, double *pararray, int i){
-  
+    if (moment[alpha] == 0) continue;
+
+    int il = lmLM[alpha][0] / 2;
     double IntensitySum = 0;
-  for (int ialpha = 0; ialpha < 3; ialpha++) { //double sum over combination of JP states
-    for (int ibeta = 0; ibeta < 3; ibeta++) {
-      if ( (ialpha != ibeta) & (eta_parity(ialpha) == eta_parity(ibeta)) ) //Only want interference moments with opposite parity
-	continue;
-      IntensitySum += SingleIntensity(x, pararray, lmLM[i][0], lmLM[i][1], lmLM[i][2], lmLM[i][3], ialpha, ibeta);
+
+    for (int ialpha = 0; ialpha < 3; ialpha++) { //double sum over combination of JP states
+      for (int ibeta = 0; ibeta < 3; ibeta++) {
+        if ( (ialpha != ibeta) & (eta_parity(ialpha) == eta_parity(ibeta)) ) //Only want interference moments with opposite parity
+          continue;
+
+        std::complex<double> fsum(0, 0);
+        for (int lambda = -1; lambda < 2; lambda++) {
+          for (int lambdaprime = -1; lambdaprime < 2; lambdaprime++) {
+            if (ibeta == 2 && lambdaprime != 0)
+              continue;
+            if (ialpha == 2 && lambda != 0)
+              continue;
+            fsum += F[il][ialpha][lambda+1] * std::conj(F[il][ibeta][lambdaprime+1]) * m_cgLlm[alpha][ialpha][ibeta][lambda+1][lambdaprime+1];
+          }
+        }
+
+        IntensitySum += std::real(m_tStar[alpha][ialpha][ibeta] * fsum * m_cgMoment[alpha]);
+      }
     }
+
+    sum += IntensitySum * moment[alpha];
   }
-    //cout << "IntensitySum = " << IntensitySum << endl;
 
-  return IntensitySum;
+  return sum;
 }
 
 ////////////////////////////////////////////////// User Vars //////////////////////////////////
@@ -398,97 +493,36 @@ omegapiAngAmp::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
     //////////////////////// Boost Particles and Get Angles//////////////////////////////////
 
   //Helicity coordinate system
-  TLorentzVector Gammap = beam + targetopi;
+  TLorentzVector target(0,0,0,0.938);
+  TLorentzVector Gammap = beam + target;
  
 // polarization BeamProperties
 	GDouble Pgamma=polFraction;//fixed beam polarization fraction
 	if(polAngle == -1)
 	Pgamma = 0.;//if beam is amorphous set polarization fraction to 0
-	else if(polFrac_vs_E!=NULL){
-	int bin = polFrac_vs_E->GetXaxis()->FindBin(beam.E());
-
-	if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-		Pgamma = 0.;
-	}
-	else
-	 Pgamma = polFrac_vs_E->GetBinContent(bin);
-	}
+	else if(polFrac_vs_E!=NULL)
+	 Pgamma = polFrac_vs_E->fraction(beam.E());
    double mx = X.M();
 
-  vector <double> locthetaphi = getomegapiAngles(polAngle, omega, X, beam, Gammap);
+  OmegaPiProductionAngles< double > locthetaphi =
+    omegapiProductionAngles(omegapiP4(omega), omegapiP4(X), omegapiP4(beam), omegapiP4(Gammap));
   
-  vector <double> locthetaphih = getomegapiAngles(rhos_pip, omega, X, Gammap, rhos_pim);
+  OmegaPiDecayAngles< double > locthetaphih =
+    omegapiDecayAngles(omegapiP4(rhos_pip), omegapiP4(omega), omegapiP4(X), omegapiP4(Gammap), omegapiP4(rhos_pim));
 
-  //cout << "theta =" << locthetaphi[0] << ", phi= " << locthetaphi[1] << ", thetah =" << locthetaphih[0] << ", phih= " << locthetaphih[1] << endl;
-  vector <double> angvector{locthetaphi[0], locthetaphi[1], locthetaphih[0], locthetaphih[1]};
+  //cout << "theta =" << locthetaphi.theta << ", phi= " << locthetaphi.phi << ", thetah =" << locthetaphih.theta << ", phih= " << locthetaphih.phi << endl;
+  double angvector[4] = {locthetaphi.theta, locthetaphi.phi, locthetaphih.theta, locthetaphih.phi};
   
-       double moment[25] = {0.0};
-       double calpha_array[25] = {0.0};
-
+  // the normalization c_alpha is folded into the moments
     for (int alpha = 0; alpha < 25; alpha++)//quantum states
 	  {
-	    moment[alpha] = hmoment(alpha, angvector);
-	  
-            calpha_array[alpha] = calpha(alpha);
+	    userVars[uv_moment0 + alpha] = hmoment(alpha, angvector) * calpha(alpha);
         }//alpha loop
 	  
-  userVars[uv_Phi] = locthetaphi[2];
+  userVars[uv_Phi] = locthetaphi.bigPhi;
 
   userVars[uv_Pgamma] = Pgamma;
   userVars[uv_mx] = mx;
-
-  userVars[uv_moment0] = moment[0];
-  userVars[uv_moment1] = moment[1];
-  userVars[uv_moment2] = moment[2];
-  userVars[uv_moment3] = moment[3];
-  userVars[uv_moment4] = moment[4];
-  userVars[uv_moment5] = moment[5];
-  userVars[uv_moment6] = moment[6];
-  userVars[uv_moment7] = moment[7];
-  userVars[uv_moment8] = moment[8];
-  userVars[uv_moment9] = moment[9];
-  userVars[uv_moment10] = moment[10];
-  userVars[uv_moment11] = moment[11];
-  userVars[uv_moment12] = moment[12];
-  userVars[uv_moment13] = moment[13];
-  userVars[uv_moment14] = moment[14];
-  userVars[uv_moment15] = moment[15];
-  userVars[uv_moment16] = moment[16];
-  userVars[uv_moment17] = moment[17];
-  userVars[uv_moment18] = moment[18];
-  userVars[uv_moment19] = moment[19];
-  userVars[uv_moment20] = moment[20];
-  userVars[uv_moment21] = moment[21];
-  userVars[uv_moment22] = moment[22];
-  userVars[uv_moment23] = moment[23];
-  userVars[uv_moment24] = moment[24];
-  
-  userVars[uv_calpha0] = calpha_array[0];
-  userVars[uv_calpha1] = calpha_array[1];
-  userVars[uv_calpha2] = calpha_array[2];
-  userVars[uv_calpha3] = calpha_array[3];
-  userVars[uv_calpha4] = calpha_array[4];
-  userVars[uv_calpha5] = calpha_array[5];
-  userVars[uv_calpha6] = calpha_array[6];
-  userVars[uv_calpha7] = calpha_array[7];
-  userVars[uv_calpha8] = calpha_array[8];
-  userVars[uv_calpha9] = calpha_array[9];
-  userVars[uv_calpha10] = calpha_array[10];
-  userVars[uv_calpha11] = calpha_array[11];
-  userVars[uv_calpha12] = calpha_array[12];
-  userVars[uv_calpha13] = calpha_array[13];
-  userVars[uv_calpha14] = calpha_array[14];
-  userVars[uv_calpha15] = calpha_array[15];
-  userVars[uv_calpha16] = calpha_array[16];
-  userVars[uv_calpha17] = calpha_array[17];
-  userVars[uv_calpha18] = calpha_array[18];
-  userVars[uv_calpha19] = calpha_array[19];
-  userVars[uv_calpha20] = calpha_array[20];
-  userVars[uv_calpha21] = calpha_array[21];
-  userVars[uv_calpha22] = calpha_array[22];
-  userVars[uv_calpha23] = calpha_array[23];
-  userVars[uv_calpha24] = calpha_array[24];
-  
 }
 
 ////////////////////////////////////////////////// Amplitude Calculation //////////////////////////////////
@@ -502,24 +536,11 @@ omegapiAngAmp::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
    GDouble polfrac = userVars[uv_Pgamma];
    GDouble mb1 = userVars[uv_mx];
 
-  GDouble moment[25] = {userVars[uv_moment0], userVars[uv_moment1], userVars[uv_moment2], userVars[uv_moment3], userVars[uv_moment4], userVars[uv_moment5], userVars[uv_moment6], userVars[uv_moment7], userVars[uv_moment8], userVars[uv_moment9], userVars[uv_moment10], userVars[uv_moment11], userVars[uv_moment12], userVars[uv_moment13], userVars[uv_moment14], userVars[uv_moment15], userVars[uv_moment16], userVars[uv_moment17], userVars[uv_moment18], userVars[uv_moment19], userVars[uv_moment20], userVars[uv_moment21], userVars[uv_moment22], userVars[uv_moment23], userVars[uv_moment24]};
-
-  GDouble calpha_array[25] = {userVars[uv_calpha0], userVars[uv_calpha1], userVars[uv_calpha2], userVars[uv_calpha3], userVars[uv_calpha4], userVars[uv_calpha5], userVars[uv_calpha6], userVars[uv_calpha7], userVars[uv_calpha8], userVars[uv_calpha9], userVars[uv_calpha10], userVars[uv_calpha11], userVars[uv_calpha12], userVars[uv_calpha13], userVars[uv_calpha14], userVars[uv_calpha15], userVars[uv_calpha16], userVars[uv_calpha17], userVars[uv_calpha18], userVars[uv_calpha19], userVars[uv_calpha20], userVars[uv_calpha21], userVars[uv_calpha22], userVars[uv_calpha23], userVars[uv_calpha24]};
-
- 
-    double wdist0 = 0.0;
-    double wdist1 = 0.0;
-    double wdist2 = 0.0;
-
-          for (int alpha = 0; alpha < 25; alpha++)//quantum states
-	  {
-	    wdist0 += Intensity(mb1, pararray, alpha) * moment[alpha] * calpha_array[alpha];
-
-	    wdist1 += Intensity(mb1, pararray, alpha) * moment[alpha] * calpha_array[alpha] * TMath::Sqrt(2.0) * TMath::Cos(2.0 * Phi);
-
-	    wdist2 += Intensity(mb1, pararray, alpha) * moment[alpha] * calpha_array[alpha] * TMath::Sqrt(2.0) * TMath::Sin(2.0 * Phi);
+    double wdist = momentSum(mb1, userVars + uv_moment0);
 
-	  }//alpha loop
+    double wdist0 = wdist;
+    double wdist1 = wdist * TMath::Sqrt(2.0) * TMath::Cos(2.0 * Phi);
+    double wdist2 = wdist * TMath::Sqrt(2.0) * TMath::Sin(2.0 * Phi);
 
 	double intensity = 0.0;
 	double real_sqrt_intensity = 0.0;
@@ -542,7 +563,7 @@ return amplitude;
 
 void omegapiAngAmp::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates  
+  setParameters();
 }
 
 #ifdef GPU_ACCELERATION
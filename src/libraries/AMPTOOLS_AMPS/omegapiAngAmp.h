@@ -12,8 +12,8 @@
 #include <vector>
 
 #include "TLorentzVector.h"
-#include "TH1D.h"
-#include "TFile.h"
+
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 
 #ifdef GPU_ACCELERATION
 void GPUomegapiAngAmp_exec( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO,
@@ -48,7 +48,8 @@ complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
   // user-defined data that the amplitudes depend on.
   
   // Use this for indexing a user-defined data array and notifying
-  // the framework of the number of user-defined variables.
+  // the framework of the number of user-defined variables.  The moments
+  // include their normalization c_alpha.
   
   enum UserVars { uv_Phi = 0, uv_Pgamma = 1, uv_mx = 2, uv_moment0 = 3
   , uv_moment1 = 4
@@ -74,32 +75,7 @@ complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
   , uv_moment21 = 24
   , uv_moment22 = 25
   , uv_moment23 = 26
-  , uv_moment24 = 27
-  , uv_calpha0 = 28
-  , uv_calpha1 = 29
-  , uv_calpha2 = 30
-  , uv_calpha3 = 31
-  , uv_calpha4 = 32
-  , uv_calpha5 = 33
-  , uv_calpha6 = 34
-  , uv_calpha7 = 35
-  , uv_calpha8 = 36
-  , uv_calpha9 = 37
-  , uv_calpha10 = 38
-  , uv_calpha11 = 39
-  , uv_calpha12 = 40
-  , uv_calpha13 = 41
-  , uv_calpha14 = 42
-  , uv_calpha15 = 43
-  , uv_calpha16 = 44
-  , uv_calpha17 = 45
-  , uv_calpha18 = 46
-  , uv_calpha19 = 47
-  , uv_calpha20 = 48
-  , uv_calpha21 = 49
-  , uv_calpha22 = 50
-  , uv_calpha23 = 51
-  , uv_calpha24 = 52,kNumUserVars };
+  , uv_moment24 = 27,kNumUserVars };
   unsigned int numUserVars() const { return kNumUserVars; }
   
   // This function needs to be defined -- see comments and discussion
@@ -152,10 +128,22 @@ private:
   AmpParameter m_ds_ratio;
 
   double polAngle, polFraction;
+
+  // current parameter values, in the order used by the intensity
+  double m_pararray[22];
+
+  // t*_{LM} for each moment and pair of JP states, updated with the
+  // parameters, and the constant Clebsch-Gordan products of the moments
+  complex< double > m_tStar[25][3][3];
+  double m_cgLlm[25][3][3][3][3];
+  double m_cgLsum[3][3][3];
+  double m_cgMoment[25];
+
+  void setParameters();
+  double momentSum( double x, const GDouble* moment ) const;
   
-  TH1D *totalFlux_vs_E;
-  TH1D *polFlux_vs_E;
-  TH1D *polFrac_vs_E;
+  // NULL unless the polarization fraction is read from a table
+  const PolarizationTable* polFrac_vs_E;
 
 };
 
@@ -0,0 +1,236 @@
+#if !defined(OMEGAPIANGLEFORMULAS)
+#define OMEGAPIANGLEFORMULAS
+
+#include <cmath>
+
+// The decay angles of getomegapiAngles (omegapiAngles.h) on plain
+// four-vectors, shared by the host and the device.  The boosts and axes
+// are those of TLorentzVector::Boost and TVector3, written out so that
+// nothing is allocated and no ROOT object is built; the angles are
+// returned in small structs.  T is the real type.
+//
+// OmegaPiP4 has the layout of the four-vectors of the framework, E first:
+//
+//   OmegaPiP4< GDouble > beam = omegapiP4( pKin[0] );
+
+#ifdef __CUDACC__
+#define OMEGAPI_FUNC __host__ __device__ inline
+#else
+#define OMEGAPI_FUNC inline
+#endif
+
+template< class T >
+struct OmegaPiP4 {
+
+  T e, x, y, z;
+};
+
+// the angles of the daughter in the helicity frame of the parent and the
+// angle Phi between the production plane and the polarization (along x)
+template< class T >
+struct OmegaPiProductionAngles {
+
+  T theta, phi, bigPhi;
+};
+
+// the angles of the normal to the decay plane (three-body decay) or of the
+// daughter (two-body decay) in the helicity frame of the parent
+template< class T >
+struct OmegaPiDecayAngles {
+
+  T theta, phi;
+};
+
+template< class T >
+OMEGAPI_FUNC OmegaPiP4< T >
+omegapiP4( const T* p ){
+
+  OmegaPiP4< T > v = { p[0], p[1], p[2], p[3] };
+  return v;
+}
+
+template< class T >
+OMEGAPI_FUNC OmegaPiP4< T >
+omegapiP4( T e, T x, T y, T z ){
+
+  OmegaPiP4< T > v = { e, x, y, z };
+  return v;
+}
+
+template< class T >
+OMEGAPI_FUNC OmegaPiP4< T >
+operator+( const OmegaPiP4< T >& a, const OmegaPiP4< T >& b ){
+
+  return omegapiP4( a.e + b.e, a.x + b.x, a.y + b.y, a.z + b.z );
+}
+
+namespace omegapiAngleDetail {
+
+  template< class T >
+  struct Vec3 {
+
+    T x, y, z;
+  };
+
+  template< class T >
+  OMEGAPI_FUNC Vec3< T > vec3( T x, T y, T z ){
+
+    Vec3< T > v = { x, y, z };
+    return v;
+  }
+
+  template< class T >
+  OMEGAPI_FUNC Vec3< T > vect( const OmegaPiP4< T >& p ){
+
+    return vec3( p.x, p.y, p.z );
+  }
+
+  template< class T >
+  OMEGAPI_FUNC T dot( const Vec3< T >& a, const Vec3< T >& b ){
+
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+  }
+
+  template< class T >
+  OMEGAPI_FUNC Vec3< T > cross( const Vec3< T >& a, const Vec3< T >& b ){
+
+    return vec3( a.y * b.z - b.y * a.z, a.z * b.x - b.z * a.x, a.x * b.y - b.x * a.y );
+  }
+
+  // TVector3::Unit leaves a null vector as it is
+  template< class T >
+  OMEGAPI_FUNC Vec3< T > unit( const Vec3< T >& a ){
+
+    T mag2 = dot( a, a );
+    if( mag2 <= T(0) ) return a;
+    T inv = T(1) / sqrt( mag2 );
+    return vec3( a.x * inv, a.y * inv, a.z * inv );
+  }
+
+  // p boosted into the rest frame of frame, TLorentzVector::Boost( -b )
+  // with b = frame.BoostVector()
+  template< class T >
+  OMEGAPI_FUNC OmegaPiP4< T > boostTo( const OmegaPiP4< T >& p, const OmegaPiP4< T >& frame ){
+
+    T bx = -frame.x / frame.e;
+    T by = -frame.y / frame.e;
+    T bz = -frame.z / frame.e;
+
+    T b2 = bx * bx + by * by + bz * bz;
+    T gamma = T(1) / sqrt( T(1) - b2 );
+    T bp = bx * p.x + by * p.y + bz * p.z;
+    T gamma2 = ( b2 > T(0) ? ( gamma - T(1) ) / b2 : T(0) );
+
+    return omegapiP4( gamma * ( p.e + bp ),
+                      p.x + gamma2 * bp * bx + gamma * bx * p.e,
+                      p.y + gamma2 * bp * by + gamma * by * p.e,
+                      p.z + gamma2 * bp * bz + gamma * bz * p.e );
+  }
+
+  // TVector3::Theta and TVector3::Phi of a in the frame x, y, z
+  template< class T >
+  OMEGAPI_FUNC void angles( const Vec3< T >& a, const Vec3< T >& x, const Vec3< T >& y,
+                            const Vec3< T >& z, T& theta, T& phi ){
+
+    T ax = dot( a, x ), ay = dot( a, y ), az = dot( a, z );
+    T perp = sqrt( ax * ax + ay * ay );
+
+    theta = ( ax == T(0) && ay == T(0) && az == T(0) ? T(0) : atan2( perp, az ) );
+    phi = ( ax == T(0) && ay == T(0) ? T(0) : atan2( ay, ax ) );
+  }
+}
+
+// The two overloads of getomegapiAngles, with the same arguments in the
+// same frames.  For the omega in b1 -> omega pi:  daughter = omega,
+// parent = b1, inverseOfX = beam, rf = gamma p.
+template< class T >
+OMEGAPI_FUNC OmegaPiProductionAngles< T >
+omegapiProductionAngles( const OmegaPiP4< T >& daughter, const OmegaPiP4< T >& parent,
+                         const OmegaPiP4< T >& inverseOfX, const OmegaPiP4< T >& rf ){
+
+  using namespace omegapiAngleDetail;
+
+  OmegaPiP4< T > inverseOfX_rf = boostTo( inverseOfX, rf );
+  OmegaPiP4< T > parent_rf = boostTo( parent, rf );
+  OmegaPiP4< T > daughter_parent = boostTo( boostTo( daughter, rf ), parent_rf );
+
+  Vec3< T > z = unit( vect( parent_rf ) );
+  Vec3< T > y = unit( cross( unit( vect( inverseOfX_rf ) ), z ) );
+  Vec3< T > x = unit( cross( y, z ) );
+
+  OmegaPiProductionAngles< T > result;
+  angles( unit( vect( daughter_parent ) ), x, y, z, result.theta, result.phi );
+
+  // the polarization is along x in the lab; the diamond orientation is
+  // applied by the amplitudes.  eps x y = ( 0, -y_z, y_y )
+  Vec3< T > beam = unit( vect( inverseOfX ) );
+  result.bigPhi = atan2( y.x, beam.z * y.y - beam.y * y.z );
+
+  return result;
+}
+
+// For the normal to the pi+ pi- plane of omega -> 3pi in the b1 decay:
+// daughter = pi+, parent = omega, inverseOfX = b1, rf = gamma p and
+// secondDaughter = pi-.  Without a second daughter (secondDaughter.e of
+// zero) the angles are those of the daughter.
+template< class T >
+OMEGAPI_FUNC OmegaPiDecayAngles< T >
+omegapiDecayAngles( const OmegaPiP4< T >& daughter, const OmegaPiP4< T >& parent,
+                    const OmegaPiP4< T >& inverseOfX, const OmegaPiP4< T >& rf,
+                    const OmegaPiP4< T >& secondDaughter ){
+
+  using namespace omegapiAngleDetail;
+
+  OmegaPiP4< T > inverseOfX_rf = boostTo( inverseOfX, rf );
+  OmegaPiP4< T > parent_x = boostTo( boostTo( parent, rf ), inverseOfX_rf );
+
+  Vec3< T > z = unit( vect( parent_x ) );
+  Vec3< T > y = unit( cross( unit( vect( inverseOfX_rf ) ), z ) );
+  Vec3< T > x = unit( cross( y, z ) );
+
+  OmegaPiP4< T > daughter_parent =
+    boostTo( boostTo( boostTo( daughter, rf ), inverseOfX_rf ), parent_x );
+  Vec3< T > decayVector = unit( vect( daughter_parent ) );
+
+  if( secondDaughter.e > T(0) ){
+
+    OmegaPiP4< T > secondDaughter_parent =
+      boostTo( boostTo( boostTo( secondDaughter, rf ), inverseOfX_rf ), parent_x );
+    decayVector = cross( decayVector, unit( vect( secondDaughter_parent ) ) );
+  }
+
+  OmegaPiDecayAngles< T > result;
+  angles( decayVector, x, y, z, result.theta, result.phi );
+
+  return result;
+}
+
+// Both sets of angles of the decays X -> vec + ps, vec -> daughter(s) for
+// n events, as in Vec_ps_refl:  the production angles of vec in the
+// helicity frame of X and the decay angles of the daughters in the
+// helicity frame of vec, both with respect to the frame rf (gamma p).
+// The four-vectors of event i are at beam[4*i] ... in the layout of
+// omegapiP4; secondDaughter is 0 for a two-body decay of vec.
+template< class T >
+OMEGAPI_FUNC void
+omegapiAnglesBatch( int n, const T* beam, const T* rf, const T* X, const T* vec,
+                    const T* daughter, const T* secondDaughter,
+                    OmegaPiProductionAngles< T >* productionAngles,
+                    OmegaPiDecayAngles< T >* decayAngles ){
+
+  OmegaPiP4< T > none = omegapiP4( T(0), T(0), T(0), T(0) );
+
+  for( int i = 0; i < n; ++i ){
+
+    OmegaPiP4< T > frame = omegapiP4( rf + 4 * i );
+    OmegaPiP4< T > parent = omegapiP4( X + 4 * i );
+    OmegaPiP4< T > vecP4 = omegapiP4( vec + 4 * i );
+
+    productionAngles[i] = omegapiProductionAngles( vecP4, parent, omegapiP4( beam + 4 * i ), frame );
+    decayAngles[i] = omegapiDecayAngles( omegapiP4( daughter + 4 * i ), vecP4, parent, frame,
+                                         secondDaughter == 0 ? none :
+                                         omegapiP4( secondDaughter + 4 * i ) );
+  }
+}
+
+#endif
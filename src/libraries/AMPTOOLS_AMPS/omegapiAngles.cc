@@ -29,97 +29,24 @@
 vector <double> getomegapiAngles(TLorentzVector daughter, TLorentzVector parent, TLorentzVector InverseOfX, TLorentzVector rf, TLorentzVector seconddaughter)
 {
 //in the case of normal to the piplus+piminus plane angles in the b1 decay the daughter = piplus, parent = omega, InverseOfX = b1, rf = gammap, seconddaughter = piminus
-// boost all to rf
-  TLorentzVector daughter_rf = daughter;
-  TLorentzVector seconddaughter_rf = seconddaughter;
-  TLorentzVector parent_rf = parent;
-  TLorentzVector InverseOfX_rf = InverseOfX;
-  TVector3 rfboost = rf.BoostVector();
-  InverseOfX_rf.Boost(-1.0*rfboost);
-  parent_rf.Boost(-1.0*rfboost);
-  daughter_rf.Boost(-1.0*rfboost);
-  seconddaughter_rf.Boost(-1.0*rfboost);
+  OmegaPiDecayAngles< double > angles =
+    omegapiDecayAngles( omegapiP4( daughter ), omegapiP4( parent ), omegapiP4( InverseOfX ),
+                        omegapiP4( rf ), omegapiP4( seconddaughter ) );
 
-  //Boost daughters and parent to X
-  TLorentzVector daughter_x = daughter_rf;
-  TLorentzVector seconddaughter_x = seconddaughter_rf;
-  TLorentzVector parent_x = parent_rf;
-  TVector3 xboost = InverseOfX_rf.BoostVector();
-  daughter_x.Boost(-1.0*xboost);
-  seconddaughter_x.Boost(-1.0*xboost);
-  parent_x.Boost(-1.0*xboost);
-  
-  //boost daughters to parent
-  TLorentzVector daughter_parent = daughter_x;
-  TLorentzVector seconddaughter_parent = seconddaughter_x;
-  TVector3 parentboost = parent_x.BoostVector();
-  daughter_parent.Boost(-1.0*parentboost);
-  seconddaughter_parent.Boost(-1.0*parentboost);
-  TVector3 daughter_parentv = daughter_parent.Vect();
-  TVector3 seconddaughter_parentv = seconddaughter_parent.Vect();
-  
-  //get the unit vectors in space
-  TVector3 daughter_parentunit = (daughter_parentv).Unit();
-  TVector3 seconddaughter_parentunit = (seconddaughter_parentv).Unit();
-  TVector3 normal_parentunit = daughter_parentunit.Cross(seconddaughter_parentunit);
-  TVector3 InverseOfX_rfunit = (InverseOfX_rf.Vect()).Unit();
+  vector <double> thetaphi{angles.theta, angles.phi};
 
-  TVector3 z = (parent_x.Vect()).Unit();
-  TVector3 y = ((InverseOfX_rfunit).Cross(z)).Unit();
-  TVector3 x = (y.Cross(z)).Unit();
-  
-  // decay vector is normal to decay plane for omega->3pi and one of the ps for vec->ps1+ps2
-  TVector3 decayVector;
-  if(seconddaughter.E() > 0) decayVector = normal_parentunit;
-  else decayVector = daughter_parentunit;
-  
-  TVector3 Angles(decayVector.Dot(x),decayVector.Dot(y),decayVector.Dot(z));
-
-  double theta = Angles.Theta();
-  double phi = Angles.Phi();
-
-  vector <double> thetaphi{theta, phi};
-    
   return thetaphi;
-  
 }
+
 vector <double> getomegapiAngles(double polAngle, TLorentzVector daughter, TLorentzVector parent, TLorentzVector InverseOfX, TLorentzVector rf)
 {
 //in the case of omega angles in b1 decay the daughter = omega, parent = b1, InverseOfX = beam, rf = gammap
-// boost all to rf
-  TLorentzVector daughter_rf = daughter;
-  TLorentzVector parent_rf = parent;
-  TLorentzVector InverseOfX_rf = InverseOfX;
-  TVector3 rfboost = rf.BoostVector();
-  InverseOfX_rf.Boost(-1.0*rfboost);
-  parent_rf.Boost(-1.0*rfboost);
-  daughter_rf.Boost(-1.0*rfboost);
-
-  //boost daughter to parent
-  TVector3 parentboost = parent_rf.BoostVector();
-  TLorentzVector daughter_parent = daughter_rf;
-  daughter_parent.Boost(-1.0*parentboost);
-  TVector3 daughter_parentv = daughter_parent.Vect();
-  
-  //get the unit vectors in space
-  TVector3 daughter_parentunit = (daughter_parentv).Unit();
-  TVector3 InverseOfX_rfunit = (InverseOfX_rf.Vect()).Unit();
-
-  TVector3 z = (parent_rf.Vect()).Unit();
-  TVector3 y = ((InverseOfX_rfunit).Cross(z)).Unit();
-  TVector3 x = (y.Cross(z)).Unit();
-  
-  TVector3 Angles(daughter_parentunit.Dot(x),daughter_parentunit.Dot(y),daughter_parentunit.Dot(z));
-
-  double theta = Angles.Theta();
-  double phi = Angles.Phi();
+  // beam polarization angle set to 0 degrees; apply diamond orientation in calcAmplitude
+  OmegaPiProductionAngles< double > angles =
+    omegapiProductionAngles( omegapiP4( daughter ), omegapiP4( parent ),
+                             omegapiP4( InverseOfX ), omegapiP4( rf ) );
 
-  // set beam polarization angle to 0 degrees; apply diamond orientation in calcAmplitude
-  TVector3 eps(1.0, 0.0, 0.0); 
-  double Phi = atan2(y.Dot(eps), InverseOfX.Vect().Unit().Dot(eps.Cross(y)));
+  vector <double> thetaphiPhi{angles.theta, angles.phi, angles.bigPhi};
 
-  vector <double> thetaphiPhi{theta, phi, Phi};
-    
   return thetaphiPhi;
-  
 }
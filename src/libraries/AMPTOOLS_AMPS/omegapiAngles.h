@@ -8,11 +8,23 @@
 
 #include "TLorentzVector.h"
 
+#include "AMPTOOLS_AMPS/omegapiAngleFormulas.h"
+
 //#include "GPUManager/GPUCustomTypes.h"
 
 using std::complex;
 using namespace std;
 
+// The angles on TLorentzVectors.  Loops over events should call
+// omegapiProductionAngles and omegapiDecayAngles (omegapiAngleFormulas.h)
+// instead; these copy the four-vectors and return a vector per call.
+
+inline OmegaPiP4< double >
+omegapiP4( const TLorentzVector& p ){
+
+  return omegapiP4( p.E(), p.Px(), p.Py(), p.Pz() );
+}
+
 vector <double> getomegapiAngles(TLorentzVector daughter, TLorentzVector parent, TLorentzVector InverseOfX, TLorentzVector rf, TLorentzVector seconddaughter);
 
 vector <double> getomegapiAngles(double polAngle, TLorentzVector daughter, TLorentzVector parent, TLorentzVector InverseOfX, TLorentzVector rf);
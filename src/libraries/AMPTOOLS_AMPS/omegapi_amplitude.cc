@@ -37,6 +37,8 @@ omegapi_amplitude::omegapi_amplitude( const vector< string >& args ):
 	}
 	else assert(0);
 
+	polFrac_vs_E = NULL;
+
     sign = atoi(args[0].c_str() );
     lambda_gamma = atoi(args[1].c_str() );
     spin = atoi(args[2].c_str() );
@@ -56,6 +58,8 @@ omegapi_amplitude::omegapi_amplitude( const vector< string >& args ):
    registerParameter(dalitz_gamma);
    registerParameter(dalitz_delta);
 
+   for (int lambda = -1; lambda <= 1; lambda++)
+	  m_cg[lambda+1] = clebschGordan(l, 1, 0, lambda, spin, lambda);
 }
 ////////////////////////////////////////////////// User Vars //////////////////////////////////
 void
@@ -86,32 +90,41 @@ omegapi_amplitude::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 	GDouble Pgamma=polFraction;//fixed beam polarization fraction
 	if(polAngle == -1)
 	Pgamma = 0.;//if beam is amorphous set polarization fraction to 0
-	else if(0) { //polFrac_vs_E!=NULL){
-	//This part causes seg fault with 34 amplitudes or more with gen_amp and gen_omegapi.
-	//Not needed for fixed beam pol angle and frac.
-	int bin = polFrac_vs_E->GetXaxis()->FindBin(beam.E());
-
-	if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-		Pgamma = 0.;
-	}
-	else
-	 Pgamma = polFrac_vs_E->GetBinContent(bin);
-	}
+	else if(polFrac_vs_E!=NULL)
+	 Pgamma = polFrac_vs_E->fraction(beam.E());
 
   //Calculate decay angles in helicity frame
-  vector <double> locthetaphi = getomegapiAngles(polAngle, omega, X, beam, Gammap);
+  OmegaPiProductionAngles< double > locthetaphi =
+    omegapiProductionAngles(omegapiP4(omega), omegapiP4(X), omegapiP4(beam), omegapiP4(Gammap));
+
+  OmegaPiDecayAngles< double > locthetaphih =
+    omegapiDecayAngles(omegapiP4(rhos_pip), omegapiP4(omega), omegapiP4(X), omegapiP4(Gammap), omegapiP4(rhos_pim));
+
+  GDouble cosTheta = TMath::Cos(locthetaphi.theta);
+  GDouble Phi = locthetaphi.phi;
+
+  GDouble cosThetaH = TMath::Cos(locthetaphih.theta);
+  GDouble PhiH = locthetaphih.phi;
 
-  vector <double> locthetaphih = getomegapiAngles(rhos_pip, omega, X, Gammap, rhos_pim);
+  GDouble prod_angle = locthetaphi.bigPhi;
 
-  userVars[uv_cosTheta] = TMath::Cos(locthetaphi[0]);
-  userVars[uv_Phi] = locthetaphi[1];
+  complex <GDouble> amplitude(0,0);
 
-  userVars[uv_cosThetaH] = TMath::Cos(locthetaphih[0]);
-  userVars[uv_PhiH] = locthetaphih[1];
+  for (int lambda = -1; lambda <= 1; lambda++)//omega helicity
+	      {
+		  amplitude += conj(wignerD( spin, spin_proj, lambda, cosTheta, Phi )) * m_cg[lambda+1] * conj(wignerD( 1, lambda, 0, cosThetaH, PhiH ));
+		}//loop over lambda
 
-  userVars[uv_prod_angle] = locthetaphi[2];
+  // multiply by square root of photon spin density matrix in helicity basis
+  complex <GDouble> prefactor ( cos( lambda_gamma * prod_angle ), sin( lambda_gamma * prod_angle ));
+  if (sign == -1 && lambda_gamma == -1){amplitude *= -1*sqrt( ( 1 - (sign * Pgamma) )/2 ) * prefactor;}
+  else{amplitude *= sqrt( ( 1 - (sign * Pgamma) )/2 ) * prefactor;}
 
-  userVars[uv_Pgamma] = Pgamma;
+  // multiply amplitude by a sign given by the naturality of the exchange (set to +1 if unknown naturality) 
+  amplitude *= nat_sign;
+
+  userVars[uv_amp_re] = amplitude.real();
+  userVars[uv_amp_im] = amplitude.imag();
   
 ///////////////////////////////////////////// Dalitz Parameters ///////////////////////////////
   double dalitz_s = rho.M2();//s=M2(pip pim)
@@ -125,8 +138,11 @@ omegapi_amplitude::calcUserVars( GDouble** pKin, GDouble* userVars ) const
   double dalitz_z = dalitzx*dalitzx + dalitzy*dalitzy;
   double dalitz_sin3theta = TMath::Sin(3 *  TMath::ASin( (dalitzy/sqrt(dalitz_z) )) );
   
+  double dalitz_z32 = dalitz_z * sqrt(dalitz_z);
   userVars[uv_dalitz_z] = dalitz_z;
-  userVars[uv_dalitz_sin3theta] = dalitz_sin3theta;
+  userVars[uv_dalitz_z32_sin3theta] = dalitz_z32 * dalitz_sin3theta;
+  userVars[uv_dalitz_z2] = dalitz_z * dalitz_z;
+  userVars[uv_dalitz_z52_sin3theta] = dalitz_z32 * dalitz_z * dalitz_sin3theta;
   
 }
 
@@ -135,44 +151,17 @@ omegapi_amplitude::calcUserVars( GDouble** pKin, GDouble* userVars ) const
 complex< GDouble >
 omegapi_amplitude::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
 {
-    
-  complex <GDouble> COne(1,0);  
-  complex <GDouble> CZero(0,0);  
-
-   GDouble cosTheta = userVars[uv_cosTheta];
-   GDouble Phi = userVars[uv_Phi];
-   GDouble cosThetaH = userVars[uv_cosThetaH];
-   GDouble PhiH = userVars[uv_PhiH];
-   GDouble prod_angle = userVars[uv_prod_angle];
-   GDouble polfrac = userVars[uv_Pgamma];
-   GDouble dalitz_z = userVars[uv_dalitz_z];
-   GDouble dalitz_sin3theta = userVars[uv_dalitz_sin3theta];
-
-   GDouble G = sqrt(1 + 2 * dalitz_alpha * dalitz_z + 2 * dalitz_beta * pow(dalitz_z,3/2.) * dalitz_sin3theta
-			 + 2 * dalitz_gamma * pow(dalitz_z,2) + 2 * dalitz_delta * pow(dalitz_z,5/2.) * dalitz_sin3theta );
-
-   complex <GDouble> amplitude = CZero;
- 
-   for (int lambda = -1; lambda <= 1; lambda++)//omega helicity
-	      {
-		  GDouble hel_amp = clebschGordan(l, 1, 0, lambda, spin, lambda);
-		  amplitude += conj(wignerD( spin, spin_proj, lambda, cosTheta, Phi )) * hel_amp * conj(wignerD( 1, lambda, 0, cosThetaH, PhiH )) * G;
-		}//loop over lambda
-		
-   // multiply by square root of photon spin density matrix in helicity basis
-   complex <GDouble> prefactor ( cos( lambda_gamma * prod_angle ), sin( lambda_gamma * prod_angle ));
-   if (sign == -1 && lambda_gamma == -1){amplitude *= -1*sqrt( ( 1 - (sign * polfrac) )/2 ) * prefactor;}
-   else{amplitude *= sqrt( ( 1 - (sign * polfrac) )/2 ) * prefactor;}
 
-   // multiply amplitude by a sign given by the naturality of the exchange (set to +1 if unknown naturality) 
-   amplitude *= nat_sign;
+   GDouble G = sqrt(1 + 2 * dalitz_alpha * userVars[uv_dalitz_z] + 2 * dalitz_beta * userVars[uv_dalitz_z32_sin3theta]
+			 + 2 * dalitz_gamma * userVars[uv_dalitz_z2] + 2 * dalitz_delta * userVars[uv_dalitz_z52_sin3theta] );
 
-   return amplitude;
+   return complex< GDouble >( userVars[uv_amp_re], userVars[uv_amp_im] ) * G;
 }
 
 void omegapi_amplitude::updatePar( const AmpParameter& par ){
  
-  // could do expensive calculations here on parameter updates  
+  // nothing to do:  the framework only recomputes the amplitude when one
+  // of the Dalitz parameters floats and has changed, and then only G
 }
 
 #ifdef GPU_ACCELERATION
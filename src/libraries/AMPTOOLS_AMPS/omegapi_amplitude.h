@@ -12,8 +12,8 @@
 #include <vector>
 
 #include "TLorentzVector.h"
-#include "TH1D.h"
-#include "TFile.h"
+
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
 
 #ifdef GPU_ACCELERATION
 void GPUomegapi_amplitude_exec( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO, 
@@ -41,26 +41,21 @@ public:
 complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
 //complex< GDouble > calcAmplitude( GDouble** pKin ) const;
   
-  // **********************
-  // The following lines are optional and can be used to precalcualte
-  // user-defined data that the amplitudes depend on.
-  
-  // Use this for indexing a user-defined data array and notifying
-  // the framework of the number of user-defined variables.
-  
-  enum UserVars { uv_cosTheta = 0, uv_Phi = 1, uv_cosThetaH = 2, uv_PhiH = 3, uv_prod_angle = 4, uv_Pgamma = 5, uv_dalitz_z = 6, uv_dalitz_sin3theta = 7, kNumUserVars };
+  // Everything but the Dalitz factor G is fixed by the arguments, so the
+  // decay and production part of the amplitude (with the photon spin
+  // density and the naturality sign) is computed once per event.  G is
+  // linear in the Dalitz parameters under the square root, and the powers
+  // of the Dalitz z that it needs are kept as well.
+  enum UserVars { uv_amp_re = 0, uv_amp_im = 1, uv_dalitz_z = 2, uv_dalitz_z32_sin3theta = 3,
+                  uv_dalitz_z2 = 4, uv_dalitz_z52_sin3theta = 5, kNumUserVars };
   unsigned int numUserVars() const { return kNumUserVars; }
   
-  // This function needs to be defined -- see comments and discussion
-  // in the .cc file.
   void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
   
-  // This is an optional addition if the calcAmplitude routine
-  // can run with only the user-defined data and not the original
-  // four-vectors.  It is used to optimize memory usage in GPU
-  // based fits.
+  // the amplitude only needs the user variables, which do not change
+  // during a fit
   bool needsUserVarsOnly() const { return true; }
-  // **  end of optional lines **
+  bool areUserVarsStatic() const { return true; }
   
  void updatePar( const AmpParameter& par );
 
@@ -87,10 +82,12 @@ private:
 	AmpParameter dalitz_delta;
 
 	double polAngle, polFraction;
+
+  // Clebsch-Gordan coefficients for the omega helicities -1, 0, 1
+  GDouble m_cg[3];
   
-  TH1D *totalFlux_vs_E;
-  TH1D *polFlux_vs_E;
-  TH1D *polFrac_vs_E;
+  // NULL unless the polarization fraction is read from a table
+  const PolarizationTable* polFrac_vs_E;
 
 };
 
@@ -36,6 +36,9 @@ public:
   string name() const { return "polCoef"; }
   
   complex< GDouble > calcAmplitude( GDouble** pKin=NULL) const;
+
+  // depends only on the beam polarization and the parameter polFrac
+  bool isEventIndependent() const { return true; }
     
 private: 
   int m_polBeam;
@@ -0,0 +1,34 @@
+
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
+
+void
+twoBodyAnglesBatch( TwoBodyFrame frame, int nEvents,
+                    const GDouble* const beam[4], const GDouble* const recoil[4],
+                    const GDouble* const p1[4], const GDouble* const p2[4],
+                    GDouble* cosTheta, GDouble* phi ){
+
+  for( int i = 0; i < nEvents; ++i ){
+
+    GDouble b[4] = { beam[0][i], beam[1][i], beam[2][i], beam[3][i] };
+    GDouble r[4] = { recoil[0][i], recoil[1][i], recoil[2][i], recoil[3][i] };
+    GDouble d1[4] = { p1[0][i], p1[1][i], p1[2][i], p1[3][i] };
+    GDouble d2[4] = { p2[0][i], p2[1][i], p2[2][i], p2[3][i] };
+
+    twoBodyAngles( frame, b, r, d1, d2, cosTheta[i], phi[i] );
+  }
+}
+
+void
+polarizationAngleBatch( int nEvents,
+                        const GDouble* const beam[4], const GDouble* const recoil[4],
+                        const GDouble* epsX, const GDouble* epsY,
+                        GDouble* bigPhi ){
+
+  for( int i = 0; i < nEvents; ++i ){
+
+    GDouble b[4] = { beam[0][i], beam[1][i], beam[2][i], beam[3][i] };
+    GDouble r[4] = { recoil[0][i], recoil[1][i], recoil[2][i], recoil[3][i] };
+
+    bigPhi[i] = polarizationAngle( b, r, epsX[i], epsY[i] );
+  }
+}
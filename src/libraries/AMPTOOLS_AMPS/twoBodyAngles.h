@@ -0,0 +1,175 @@
+#if !defined(TWOBODYANGLES)
+#define TWOBODYANGLES
+
+#include <cmath>
+
+#include "GPUManager/GPUCustomTypes.h"
+
+// Decay angles of a resonance X -> p1 p2 produced in beam + target ->
+// X + recoil, computed with plain arithmetic on the four-vector
+// components instead of TLorentzVector/TLorentzRotation objects.
+//
+// Four-vectors are given in the AmpTools order (E, px, py, pz).  The
+// scalar functions take one event as pointers (e.g., the rows of pKin);
+// the batch functions take structure-of-arrays inputs, where beam[k][i]
+// is component k of event i, and contain no calls that would prevent the
+// compiler from vectorizing the boosts and projections.
+//
+// The frames are those used by the amplitudes in this library:
+//
+//   kHelicityLabNormal:  z opposite the recoil in the X rest frame,
+//                        y normal to the production plane computed from
+//                        the lab momenta (Zlm, Ylm, TwoPiPlotGenerator)
+//   kHelicity:           z opposite the recoil in the X rest frame,
+//                        y = beam x z in the X rest frame (TwoPSHelicity)
+//   kGottfriedJackson:   z along the beam in the X rest frame,
+//                        y = recoil x z in the X rest frame (TwoPSAngles)
+
+enum TwoBodyFrame { kHelicityLabNormal = 0, kHelicity, kGottfriedJackson };
+
+namespace twoBodyDetail {
+
+  inline void unit( GDouble* v ){
+
+    GDouble mag = sqrt( v[0] * v[0] + v[1] * v[1] + v[2] * v[2] );
+    if( mag > 0 ){ v[0] /= mag; v[1] /= mag; v[2] /= mag; }
+  }
+
+  inline void cross( const GDouble* a, const GDouble* b, GDouble* c ){
+
+    c[0] = a[1] * b[2] - a[2] * b[1];
+    c[1] = a[2] * b[0] - a[0] * b[2];
+    c[2] = a[0] * b[1] - a[1] * b[0];
+  }
+
+  inline GDouble dot( const GDouble* a, const GDouble* b ){
+
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  }
+
+  // the three-momentum of p after a boost by -beta (same as TLorentzVector::Boost)
+  inline void boost3( const GDouble* beta, GDouble gamma, GDouble gamma2,
+                      GDouble e, GDouble px, GDouble py, GDouble pz, GDouble* out ){
+
+    GDouble bp = beta[0] * px + beta[1] * py + beta[2] * pz;
+    GDouble f = gamma2 * bp - gamma * e;
+
+    out[0] = px + f * beta[0];
+    out[1] = py + f * beta[1];
+    out[2] = pz + f * beta[2];
+  }
+
+  // the normal to the production plane, beam x (-recoil), from lab momenta
+  inline void labNormal( GDouble bx, GDouble by, GDouble bz,
+                         GDouble rx, GDouble ry, GDouble rz, GDouble* y ){
+
+    GDouble b[3] = { bx, by, bz };
+    GDouble r[3] = { -rx, -ry, -rz };
+    unit( b );
+    unit( r );
+    cross( b, r, y );
+    unit( y );
+  }
+}
+
+/**
+ * The polar and azimuthal angle of p1 in the given frame for one event,
+ * with the four-vectors indexed as (E, px, py, pz).
+ */
+inline void
+twoBodyAngles( TwoBodyFrame frame, const GDouble* beam, const GDouble* recoil,
+               const GDouble* p1, const GDouble* p2,
+               GDouble& cosTheta, GDouble& phi ){
+
+  using namespace twoBodyDetail;
+
+  GDouble eX = p1[0] + p2[0];
+  GDouble beta[3] = { ( p1[1] + p2[1] ) / eX,
+                      ( p1[2] + p2[2] ) / eX,
+                      ( p1[3] + p2[3] ) / eX };
+
+  GDouble b2 = dot( beta, beta );
+  GDouble gamma = 1 / sqrt( 1 - b2 );
+  GDouble gamma2 = ( b2 > 0 ? ( gamma - 1 ) / b2 : 0 );
+
+  GDouble recoilRes[3], p1Res[3];
+  boost3( beta, gamma, gamma2, recoil[0], recoil[1], recoil[2], recoil[3], recoilRes );
+  boost3( beta, gamma, gamma2, p1[0], p1[1], p1[2], p1[3], p1Res );
+
+  GDouble x[3], y[3], z[3];
+
+  if( frame == kGottfriedJackson ){
+
+    boost3( beta, gamma, gamma2, beam[0], beam[1], beam[2], beam[3], z );
+    unit( z );
+    cross( recoilRes, z, y );
+    unit( y );
+  }
+  else{
+
+    z[0] = -recoilRes[0]; z[1] = -recoilRes[1]; z[2] = -recoilRes[2];
+    unit( z );
+
+    if( frame == kHelicity ){
+
+      GDouble beamRes[3];
+      boost3( beta, gamma, gamma2, beam[0], beam[1], beam[2], beam[3], beamRes );
+      cross( beamRes, z, y );
+      unit( y );
+    }
+    else{
+
+      labNormal( beam[1], beam[2], beam[3], recoil[1], recoil[2], recoil[3], y );
+    }
+  }
+
+  cross( y, z, x );
+
+  GDouble ax = dot( p1Res, x );
+  GDouble ay = dot( p1Res, y );
+  GDouble az = dot( p1Res, z );
+
+  GDouble mag = sqrt( ax * ax + ay * ay + az * az );
+  cosTheta = ( mag > 0 ? az / mag : 1 );
+  phi = ( ax == 0 && ay == 0 ? 0 : atan2( ay, ax ) );
+}
+
+/**
+ * The angle between the beam polarization vector (epsX, epsY, 0) and the
+ * production plane, with the plane normal computed from lab momenta.
+ */
+inline GDouble
+polarizationAngle( const GDouble* beam, const GDouble* recoil,
+                   GDouble epsX, GDouble epsY ){
+
+  using namespace twoBodyDetail;
+
+  GDouble y[3];
+  labNormal( beam[1], beam[2], beam[3], recoil[1], recoil[2], recoil[3], y );
+
+  GDouble b[3] = { beam[1], beam[2], beam[3] };
+  unit( b );
+
+  GDouble eps[3] = { epsX, epsY, 0 };
+  GDouble epsCrossY[3];
+  cross( eps, y, epsCrossY );
+
+  return atan2( dot( y, eps ), dot( b, epsCrossY ) );
+}
+
+/**
+ * Batch versions of the functions above over nEvents events in
+ * structure-of-arrays layout.  The polarization vector in the batch
+ * version is given per event.
+ */
+void twoBodyAnglesBatch( TwoBodyFrame frame, int nEvents,
+                         const GDouble* const beam[4], const GDouble* const recoil[4],
+                         const GDouble* const p1[4], const GDouble* const p2[4],
+                         GDouble* cosTheta, GDouble* phi );
+
+void polarizationAngleBatch( int nEvents,
+                             const GDouble* const beam[4], const GDouble* const recoil[4],
+                             const GDouble* epsX, const GDouble* epsY,
+                             GDouble* bigPhi );
+
+#endif
@@ -1,6 +1,9 @@
 
 #include "AMPTOOLS_AMPS/wignerD.h"
 #include <complex>
+#include <vector>
+#include <cmath>
+#include <cassert>
 
 using namespace std;
 
@@ -18,7 +21,7 @@ wignerDSmall( GDouble aj, GDouble am, GDouble an, GDouble beta ){
   
 	double f = 8.72664625997164788e-3;    
   
-  double fcl[51] = { 0 , 0 ,
+  static const double fcl[51] = { 0 , 0 ,
 		6.93147180559945309e-1 ,1.79175946922805500e00,
 		3.17805383034794562e00 ,4.78749174278204599e00,
 		6.57925121201010100e00 ,8.52516136106541430e00,
@@ -100,20 +103,246 @@ wignerDSmall( GDouble aj, GDouble am, GDouble an, GDouble beta ){
 }
 
 
+namespace {
+
+  // the coefficients for all j up to kMaxWignerTableJ, built once
+  struct WignerDTables {
+
+    WignerDTables();
+
+    vector< int > first[kMaxWignerTableJ+1];
+    vector< int > cosPow[kMaxWignerTableJ+1];
+    vector< GDouble > coef[kMaxWignerTableJ+1];
+    WignerDCoefficients coefficients[kMaxWignerTableJ+1];
+  };
+
+  WignerDTables::WignerDTables(){
+
+    // log-factorials up to 2 * kMaxWignerTableJ
+    double lf[2*kMaxWignerTableJ+2];
+    lf[0] = 0;
+    for( int i = 1; i < 2*kMaxWignerTableJ+2; ++i ) lf[i] = lf[i-1] + log( (double)i );
+
+    for( int j = 0; j <= kMaxWignerTableJ; ++j ){
+
+      for( int m = -j; m <= j; ++m ){
+        for( int n = -j; n <= j; ++n ){
+
+          first[j].push_back( coef[j].size() );
+
+          // d^j_{mn}(beta) = sum_s (-1)^(m-n+s)
+          //   sqrt( (j+m)! (j-m)! (j+n)! (j-n)! ) /
+          //   ( (j+n-s)! s! (m-n+s)! (j-m-s)! )
+          //   cos(beta/2)^(2j+n-m-2s) sin(beta/2)^(m-n+2s)
+          int sMin = ( n - m > 0 ? n - m : 0 );
+          int sMax = ( j + n < j - m ? j + n : j - m );
+
+          for( int s = sMin; s <= sMax; ++s ){
+
+            double lc = 0.5 * ( lf[j+m] + lf[j-m] + lf[j+n] + lf[j-n] ) -
+              lf[j+n-s] - lf[s] - lf[m-n+s] - lf[j-m-s];
+
+            double sign = ( ( m - n + s ) % 2 == 0 ? 1 : -1 );
+
+            coef[j].push_back( sign * exp( lc ) );
+            cosPow[j].push_back( 2*j + n - m - 2*s );
+          }
+        }
+      }
+
+      first[j].push_back( coef[j].size() );
+
+      coefficients[j].j = j;
+      coefficients[j].first = &first[j][0];
+      coefficients[j].cosPow = &cosPow[j][0];
+      coefficients[j].coef = &coef[j][0];
+    }
+  }
+
+  const WignerDTables& wignerDTables(){
+
+    static const WignerDTables tables;
+    return tables;
+  }
+
+  template< int J >
+  void batchFixed( const GDouble* cosTheta, unsigned int nEvents, GDouble* out ){
+
+    const int nMN = ( 2*J + 1 ) * ( 2*J + 1 );
+    GDouble d[nMN];
+
+    for( unsigned int i = 0; i < nEvents; ++i ){
+
+      wignerDSmallAll< J >( cosTheta[i], d );
+      for( int k = 0; k < nMN; ++k ) out[k*nEvents+i] = d[k];
+    }
+  }
+}
+
+const WignerDCoefficients&
+wignerDCoefficients( int j ){
+
+  assert( j >= 0 && j <= kMaxWignerTableJ );
+  return wignerDTables().coefficients[j];
+}
+
+GDouble
+wignerDSmallCos( int j, int m, int n, GDouble cosTheta ){
+
+  if( m < -j || m > j || n < -j || n > j ) return 0;
+
+  if( j > kMaxWignerTableJ ){
+
+    return wignerDSmall( j, m, n, acos( cosTheta ) * 180.0 / PI );
+  }
+
+  const WignerDCoefficients& c = wignerDCoefficients( j );
+
+  GDouble c2 = 0.5 * ( 1 + cosTheta );
+  if( c2 < 0 ) c2 = 0;
+  if( c2 > 1 ) c2 = 1;
+  GDouble ch = sqrt( c2 ), sh = sqrt( 1 - c2 );
+
+  int i = ( m + j ) * ( 2*j + 1 ) + ( n + j );
+
+  GDouble sum = 0;
+  for( int t = c.first[i]; t < c.first[i+1]; ++t ){
+
+    sum += c.coef[t] * pow( ch, c.cosPow[t] ) * pow( sh, 2*j - c.cosPow[t] );
+  }
+
+  return sum;
+}
+
+void
+wignerDSmallBatch( int j, const GDouble* cosTheta, unsigned int nEvents,
+                   GDouble* out ){
+
+  switch( j ){
+
+    case 0: batchFixed< 0 >( cosTheta, nEvents, out ); return;
+    case 1: batchFixed< 1 >( cosTheta, nEvents, out ); return;
+    case 2: batchFixed< 2 >( cosTheta, nEvents, out ); return;
+    case 3: batchFixed< 3 >( cosTheta, nEvents, out ); return;
+    case 4: batchFixed< 4 >( cosTheta, nEvents, out ); return;
+  }
+
+  int nM = 2*j + 1;
+  for( int m = -j; m <= j; ++m ){
+    for( int n = -j; n <= j; ++n ){
+
+      GDouble* col = out + ( ( m + j ) * nM + ( n + j ) ) * nEvents;
+      for( unsigned int i = 0; i < nEvents; ++i ){
+
+        col[i] = wignerDSmallCos( j, m, n, cosTheta[i] );
+      }
+    }
+  }
+}
+
 complex< GDouble > wignerD( int l, int m, int n, 
                            GDouble cosTheta, GDouble phi ){
 	
-    double dtheta = acos( cosTheta ) * 180.0 / PI;
-	
-    GDouble dpart = wignerDSmall( l, m, n, dtheta );
+    GDouble dpart = wignerDSmallCos( l, m, n, cosTheta );
 	
     return complex< GDouble >( cos( -1.0 * m * phi ) * dpart, 
 							sin( -1.0 * m * phi ) * dpart );
 	
 }
 
+// the normalized associated Legendre function
+//   sqrt( (2l+1)/(4 pi) (l-m)!/(l+m)! ) P_l^m( cosTheta )
+// including the Condon-Shortley phase, for m >= 0
+static GDouble
+normLegendre( int l, int m, GDouble cosTheta ){
+
+  GDouble sinTheta = sqrt( max( (GDouble)0, 1 - cosTheta * cosTheta ) );
+
+  GDouble pmm = sqrt( 1 / ( 4 * PI ) );
+  for( int k = 1; k <= m; ++k ) pmm *= -sqrt( ( 2.0 * k + 1 ) / ( 2.0 * k ) ) * sinTheta;
+
+  if( l == m ) return pmm;
+
+  GDouble pl2 = pmm;
+  GDouble pl1 = sqrt( 2.0 * m + 3 ) * cosTheta * pmm;
+
+  for( int k = m + 2; k <= l; ++k ){
+
+    GDouble a = sqrt( ( 4.0 * k * k - 1 ) / ( 1.0 * k * k - m * m ) );
+    GDouble b = sqrt( ( ( k - 1.0 ) * ( k - 1.0 ) - m * m ) /
+                      ( 4.0 * ( k - 1.0 ) * ( k - 1.0 ) - 1 ) );
+    GDouble pl = a * ( cosTheta * pl1 - b * pl2 );
+    pl2 = pl1;
+    pl1 = pl;
+  }
+
+  return pl1;
+}
+
 complex< GDouble > Y( int l, int m, GDouble cosTheta, GDouble phi ){
   
-  return ( (GDouble)sqrt( (2*l+1) / (4*PI) ) ) * 
-          conj( wignerD( l, m, 0, cosTheta, phi ) );
+  if( abs( m ) > l ) return 0;
+
+  GDouble p = normLegendre( l, abs( m ), cosTheta );
+
+  // Y_{l,-m} = (-1)^m conj( Y_lm )
+  if( m < 0 && ( -m ) % 2 == 1 ) p = -p;
+
+  return complex< GDouble >( p * cos( m * phi ), p * sin( m * phi ) );
+}
+
+void
+sphericalHarmonics( int lMax, GDouble cosTheta, GDouble phi,
+                    complex< GDouble >* ylm ){
+
+  GDouble sinTheta = sqrt( max( (GDouble)0, 1 - cosTheta * cosTheta ) );
+  GDouble cosPhi = cos( phi ), sinPhi = sin( phi );
+
+  // cos(m phi) and sin(m phi) from the Chebyshev recurrence
+  GDouble cm = 1, sm = 0;
+  GDouble cmPrev = cosPhi, smPrev = -sinPhi;
+
+  GDouble pmm = sqrt( 1 / ( 4 * PI ) );
+
+  for( int m = 0; m <= lMax; ++m ){
+
+    if( m > 0 ){
+
+      pmm *= -sqrt( ( 2.0 * m + 1 ) / ( 2.0 * m ) ) * sinTheta;
+
+      GDouble cNext = 2 * cosPhi * cm - cmPrev;
+      GDouble sNext = 2 * cosPhi * sm - smPrev;
+      cmPrev = cm; smPrev = sm;
+      cm = cNext; sm = sNext;
+    }
+
+    GDouble sign = ( m % 2 == 0 ? 1 : -1 );
+
+    // walk up in l at fixed m
+    GDouble pl2 = 0, pl1 = pmm;
+    for( int l = m; l <= lMax; ++l ){
+
+      GDouble pl;
+      if( l == m ){
+
+        pl = pmm;
+      }
+      else if( l == m + 1 ){
+
+        pl = sqrt( 2.0 * m + 3 ) * cosTheta * pmm;
+      }
+      else{
+
+        GDouble a = sqrt( ( 4.0 * l * l - 1 ) / ( 1.0 * l * l - m * m ) );
+        GDouble b = sqrt( ( ( l - 1.0 ) * ( l - 1.0 ) - m * m ) /
+                          ( 4.0 * ( l - 1.0 ) * ( l - 1.0 ) - 1 ) );
+        pl = a * ( cosTheta * pl1 - b * pl2 );
+      }
+
+      if( l > m ){ pl2 = pl1; pl1 = pl; }
+
+      ylm[l*(l+1)+m] = complex< GDouble >( pl * cm, pl * sm );
+      if( m > 0 ) ylm[l*(l+1)-m] = complex< GDouble >( sign * pl * cm, -sign * pl * sm );
+    }
+  }
 }
@@ -11,4 +11,89 @@ GDouble wignerDSmall( GDouble aj, GDouble am, GDouble an, GDouble beta );
 complex< GDouble > wignerD( int l, int m, int n, GDouble cosTheta, GDouble phi );
 complex< GDouble > Y( int l, int m, GDouble cosTheta, GDouble phi );
 
+/**
+ * Fills ylm[l*(l+1)+m] with Y(l, m, cosTheta, phi) for all l <= lMax and
+ * -l <= m <= l, using the recurrences for the associated Legendre
+ * functions in cosTheta and the Chebyshev recurrence for cos(m phi) and
+ * sin(m phi), so that only one sin/cos pair is evaluated per call.
+ * The array must hold (lMax+1)^2 values.
+ */
+void sphericalHarmonics( int lMax, GDouble cosTheta, GDouble phi,
+                         complex< GDouble >* ylm );
+
+/**
+ * The Wigner small-d function d^j_{mn} for integer j, evaluated directly
+ * from cos(beta) as a polynomial in cos(beta/2) and sin(beta/2) with
+ * precomputed coefficients.  Unlike wignerDSmall, which takes beta in
+ * degrees, this needs no trigonometric functions, exponentials, or
+ * logarithms.
+ */
+GDouble wignerDSmallCos( int j, int m, int n, GDouble cosTheta );
+
+/**
+ * Fills d^j_{mn} for all m and n of integer j for an array of events:
+ *
+ *   out[ ( ( m + j ) * ( 2 * j + 1 ) + ( n + j ) ) * nEvents + iEvent ]
+ *
+ * so that each (m,n) is a contiguous column over events.  The loops for
+ * j <= 4 are specialized at compile time.
+ */
+void wignerDSmallBatch( int j, const GDouble* cosTheta, unsigned int nEvents,
+                        GDouble* out );
+
+// the largest j for which the coefficients are tabulated; larger j
+// fall back to wignerDSmall
+enum { kMaxWignerTableJ = 12 };
+
+/**
+ * The polynomial for each d^j_{mn} is a sum of terms
+ *
+ *   coef[t] * cos(beta/2)^cosPow[t] * sin(beta/2)^(2j-cosPow[t])
+ *
+ * for t in [first[(m+j)*(2j+1)+(n+j)], first[(m+j)*(2j+1)+(n+j)+1]).
+ */
+struct WignerDCoefficients {
+
+  int j;
+  const int* first;
+  const int* cosPow;
+  const GDouble* coef;
+};
+
+const WignerDCoefficients& wignerDCoefficients( int j );
+
+/**
+ * Fills d[(m+J)*(2J+1)+(n+J)] with d^J_{mn}(beta) for all m and n at one
+ * cos(beta).  With J known at compile time the loops have constant bounds.
+ */
+template< int J >
+inline void wignerDSmallAll( GDouble cosTheta, GDouble* d ){
+
+  const WignerDCoefficients& c = wignerDCoefficients( J );
+
+  GDouble c2 = 0.5 * ( 1 + cosTheta );
+  if( c2 < 0 ) c2 = 0;
+  if( c2 > 1 ) c2 = 1;
+
+  // the powers of cos(beta/2) and sin(beta/2) by recurrence
+  GDouble cp[2*J+1], sp[2*J+1];
+  cp[0] = 1; sp[0] = 1;
+  GDouble ch = sqrt( c2 ), sh = sqrt( 1 - c2 );
+  for( int p = 1; p <= 2*J; ++p ){
+
+    cp[p] = cp[p-1] * ch;
+    sp[p] = sp[p-1] * sh;
+  }
+
+  for( int i = 0; i < ( 2*J + 1 ) * ( 2*J + 1 ); ++i ){
+
+    GDouble sum = 0;
+    for( int t = c.first[i]; t < c.first[i+1]; ++t ){
+
+      sum += c.coef[t] * cp[c.cosPow[t]] * sp[2*J - c.cosPow[t]];
+    }
+    d[i] = sum;
+  }
+}
+
 #endif
@@ -1,26 +1,106 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cmath>
+#include <stdint.h>
 
 #include "TLorentzVector.h"
 
 #include "ASCIIDataWriter.h"
+#include "StreamDataWriter.h"
 
+namespace {
 
-ASCIIDataWriter::ASCIIDataWriter( const string& outFile )
+  // the size of the text buffers and the most an event can add to one
+  const size_t kBufferSize = 1 << 22;
+  const size_t kMaxEventSize = 2048 * ( Kinematics::kMaxParticles + 1 );
+
+  char* appendInt( char* p, int value ){
+
+    if( value < 0 ){
+      *p++ = '-';
+      value = -value;
+    }
+
+    char digits[12];
+    int n = 0;
+    do { digits[n++] = '0' + value % 10; value /= 10; } while( value > 0 );
+    while( n > 0 ) *p++ = digits[--n];
+
+    return p;
+  }
+
+  // value as printf's "%f", six decimals
+  char* appendFixed( char* p, double value ){
+
+    if( !( fabs( value ) < 1e12 ) ) return p + sprintf( p, "%f", value );
+
+    if( signbit( value ) ) *p++ = '-';
+
+    uint64_t scaled = static_cast< uint64_t >( fabs( value ) * 1e6 + 0.5 );
+    uint64_t whole = scaled / 1000000;
+    uint64_t fraction = scaled % 1000000;
+
+    char digits[24];
+    int n = 0;
+    do { digits[n++] = '0' + whole % 10; whole /= 10; } while( whole > 0 );
+    while( n > 0 ) *p++ = digits[--n];
+
+    *p++ = '.';
+    for( int i = 5; i >= 0; --i, fraction /= 10 ) p[i] = '0' + fraction % 10;
+
+    return p + 6;
+  }
+}
+
+ASCIIDataWriter::ASCIIDataWriter( const string& outFile, bool binary ) :
+  fid( NULL ),
+  m_used( 0 ),
+  m_binary( NULL )
 {
-  
+  m_eventCounter = 0;
+
+  if( binary ){
+
+    m_binary = new StreamDataWriter( outFile );
+    return;
+  }
+
   // Open output file
   fid=fopen((char *)(outFile.c_str()),"w");
 
-  m_eventCounter = 0;
+  m_buffer.resize( kBufferSize );
 }
 
 ASCIIDataWriter::~ASCIIDataWriter()
 {
+  if( m_binary != NULL ){
+
+    delete m_binary;
+    return;
+  }
+
+  flush();
+  if( m_writer.joinable() ) m_writer.join();
+
   fclose(fid);
 }
 
+void
+ASCIIDataWriter::flush()
+{
+  if( m_writer.joinable() ) m_writer.join();
+  if( m_used == 0 ) return;
+
+  m_writing.swap( m_buffer );
+  if( m_buffer.size() < kBufferSize ) m_buffer.resize( kBufferSize );
+
+  size_t used = m_used;
+  m_used = 0;
+
+  m_writer = thread( [this, used](){ fwrite( &m_writing[0], 1, used, fid ); } );
+}
+
 
 /**
  * This function writes one event. It is presumed that the first 
@@ -33,26 +113,35 @@ ASCIIDataWriter::~ASCIIDataWriter()
 void
 ASCIIDataWriter::writeEvent( const Kinematics& kin, vector<int> &types)
 {
-  vector< TLorentzVector > particleList = kin.particleList();
+  if( m_binary != NULL ){
+
+    m_binary->writeEvent( kin );
+    m_eventCounter++;
+    return;
+  }
+
+  const vector< TLorentzVector >& particleList = kin.particleList();
 	
   m_nPart = particleList.size() - 2;
   
   assert( particleList.size() <= Kinematics::kMaxParticles );
   
+  if( m_used + kMaxEventSize > m_buffer.size() ) flush();
+  char* p = &m_buffer[m_used];
+
+  // Start a new event:  "9000 <event> <particles>"
+  p = appendInt( p, 9000 ); *p++ = ' ';
+  p = appendInt( p, m_eventCounter + 1 ); *p++ = ' ';
+  p = appendInt( p, m_nPart + 1 ); *p++ = '\n';
   
-  // Start a new event
-  fprintf(fid,"9000 %d %d\n",m_eventCounter+1,m_nPart+1);
-  
-  
-  fprintf(fid,"1 %d %f\n",types[1],particleList[1].M());
-  fprintf(fid,"   1 %f %f %f %f\n",
-          particleList[1].Px(), particleList[1].Py(),
-          particleList[1].Pz(), particleList[1].E());
-  
-  for( int i = 0; i < m_nPart; i++ ){
+  for( int i = -1; i < m_nPart; i++ ){
+
+    // the recoil first, with a charge of 1
+    const TLorentzVector& particle = particleList[i+2];
 
     int charge=0;
-    switch (types[i+2]){
+    if( i < 0 ) charge=1;
+    else switch (types[i+2]){
     case 8: //pi plus
       charge=1; break;
     case 9: //pi minus
@@ -64,17 +153,21 @@ ASCIIDataWriter::writeEvent( const Kinematics& kin, vector<int> &types)
     default:
       charge=0;
     }
-    
-
-    fprintf(fid,"%d %d %f\n",i+2,types[i+2],particleList[i+2].M());
-
-    fprintf(fid,"   %d %f %f %f %f\n",charge,
-	    particleList[i+2].Px(),particleList[i+2].Py(),
-	    particleList[i+2].Pz(),particleList[i+2].E());
 
+    // "<index> <type> <mass>" and "   <charge> <px> <py> <pz> <E>"
+    p = appendInt( p, i+2 ); *p++ = ' ';
+    p = appendInt( p, types[i+2] ); *p++ = ' ';
+    p = appendFixed( p, particle.M() ); *p++ = '\n';
+
+    *p++ = ' '; *p++ = ' '; *p++ = ' ';
+    p = appendInt( p, charge ); *p++ = ' ';
+    p = appendFixed( p, particle.Px() ); *p++ = ' ';
+    p = appendFixed( p, particle.Py() ); *p++ = ' ';
+    p = appendFixed( p, particle.Pz() ); *p++ = ' ';
+    p = appendFixed( p, particle.E() ); *p++ = '\n';
   }
+
+  m_used = p - &m_buffer[0];
   
   m_eventCounter++;
 }
-
-
@@ -1,9 +1,12 @@
 #if !defined(ASCIIDATAWRITER)
 #define ASCIIDATAWRITER
 
+#include <cstdio>
 #include <vector>
+#include <thread>
 #include "IUAmpTools/Kinematics.h"
 
+class StreamDataWriter;
 
 /**                                                                                                                                 
  * This class writes events passed in the Kinematics data type (see AmpTools)
@@ -11,6 +14,16 @@
  * for preparing events generated by AmpTools-based event generators
  * for simulation with HDGeant. This should be replaced at some 
  * point by an "HDDMDataWriter"
+ *
+ * The text is formatted into a buffer of a few MB without printf and
+ * the full buffer is written by a background thread while the next one
+ * is filled, so the output keeps up with the generators.  The numbers are
+ * those of printf's "%f" except, rarely, in the last digit of a value
+ * that lies exactly halfway between two of them.
+ *
+ * With binary, the events are written instead in the stream format of
+ * BinaryDataFormat.h (see StreamDataWriter), the beam first, for the
+ * consumers that read it; the particle types are then not written.
  */
 
 class ASCIIDataWriter
@@ -18,7 +31,7 @@ class ASCIIDataWriter
 
 public:
   
-  ASCIIDataWriter( const string& outFile );
+  ASCIIDataWriter( const string& outFile, bool binary = false );
   ~ASCIIDataWriter();
   
   void writeEvent( const Kinematics& kin, vector<int> &types);
@@ -27,11 +40,23 @@ public:
   
 private:
   
+  ASCIIDataWriter( const ASCIIDataWriter& );
+  ASCIIDataWriter& operator=( const ASCIIDataWriter& );
+
+  // hands the filled buffer to the background thread
+  void flush();
+
   FILE* fid;
   int m_eventCounter;
   
   int m_nPart;
 
+  // the buffer being filled and the one being written
+  vector< char > m_buffer, m_writing;
+  size_t m_used;
+  thread m_writer;
+
+  StreamDataWriter* m_binary;
 };
 
 #endif
@@ -0,0 +1,61 @@
+#if !defined(BINARYDATAFORMAT)
+#define BINARYDATAFORMAT
+
+#include <stdint.h>
+
+/**
+ * The layout of the files written by BinaryDataWriter and read by
+ * BinaryDataReader.  A file is a fixed-size header followed by the
+ * event data as columns:
+ *
+ *   E of every particle, then Px, then Py, then Pz, then the weight
+ *
+ * where "E of every particle" is the E column of particle 0 (the beam),
+ * followed by the E column of particle 1, etc.  Each column holds the
+ * value for all events, is stored as float or double (see precision),
+ * and starts on a kBinaryDataAlign byte boundary so that it can be used
+ * in place after the file is memory-mapped.  The weight column is only
+ * present if hasWeight is nonzero.  All values are in the byte order of
+ * the machine that wrote the file.
+ */
+
+static const char kBinaryDataMagic[8] = "HDAMP4V";
+static const uint32_t kBinaryDataVersion = 1;
+static const uint32_t kBinaryDataAlign = 64;
+
+struct BinaryDataHeader {
+
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t numEvents;
+  uint32_t numParticles;  // including the beam
+  uint32_t hasWeight;
+  uint32_t precision;     // bytes per value:  4 or 8
+  uint32_t pad[7];
+};
+
+/**
+ * The number of values between the starts of two consecutive columns.
+ */
+inline uint64_t binaryDataColumnStride( uint64_t numEvents, uint32_t precision ){
+
+  uint64_t bytes = numEvents * precision;
+  bytes = ( ( bytes + kBinaryDataAlign - 1 ) / kBinaryDataAlign ) * kBinaryDataAlign;
+  return bytes / precision;
+}
+
+/**
+ * The stream format of StreamDataWriter and StreamDataReader, for pipes
+ * where the number of events is not known in advance and nothing can be
+ * seeked:  the same header with the stream magic and numEvents of zero,
+ * followed by one record per event
+ *
+ *   E, Px, Py, Pz of particle 0 (the beam), of particle 1, ..., the weight
+ *
+ * in the precision of the header, until the end of the stream.
+ */
+
+static const char kBinaryStreamMagic[8] = "HDAMPST";
+
+#endif
@@ -0,0 +1,171 @@
+
+#include <vector>
+#include <map>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TLorentzVector.h"
+
+#include "AMPTOOLS_DATAIO/BinaryDataReader.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "IUAmpTools/Kinematics.h"
+
+using namespace std;
+
+BinaryDataReader::BinaryDataReader( const vector< string >& args ):
+  UserDataReader< BinaryDataReader >( args ),
+  m_eventCounter( 0 ),
+  m_map( NULL ),
+  m_mapSize( 0 ),
+  m_header( NULL ),
+  m_first( 0 ),
+  m_numEvents( 0 )
+{
+  vector< string > posArgs;
+  map< string, string > options;
+  splitReaderArgs( args, posArgs, options );
+
+  assert( posArgs.size() == 1 );
+
+  string slice;
+  for( map< string, string >::const_iterator opt = options.begin();
+       opt != options.end(); ++opt ){
+
+    if( opt->first == "slice" ){
+
+      slice = opt->second;
+    }
+    else{
+
+      cout << "BinaryDataReader ERROR:  unknown option " << opt->first << endl;
+      assert( false );
+    }
+  }
+
+  int fd = open( args[0].c_str(), O_RDONLY );
+  if( fd < 0 ){
+
+    cout << "BinaryDataReader ERROR:  unable to open " << args[0] << endl;
+    assert( false );
+  }
+
+  struct stat st;
+  fstat( fd, &st );
+  m_mapSize = st.st_size;
+
+  if( m_mapSize < sizeof( BinaryDataHeader ) ){
+
+    cout << "BinaryDataReader ERROR:  " << args[0] << " is too short" << endl;
+    assert( false );
+  }
+
+  m_map = mmap( NULL, m_mapSize, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+
+  assert( m_map != MAP_FAILED );
+
+  m_header = static_cast< const BinaryDataHeader* >( m_map );
+
+  if( memcmp( m_header->magic, kBinaryDataMagic, sizeof( kBinaryDataMagic ) ) != 0 ||
+      m_header->version != kBinaryDataVersion ){
+
+    cout << "BinaryDataReader ERROR:  " << args[0]
+         << " is not a version " << kBinaryDataVersion << " binary data file" << endl;
+    assert( false );
+  }
+
+  assert( m_header->precision == sizeof( float ) ||
+          m_header->precision == sizeof( double ) );
+  assert( static_cast< int >( m_header->numParticles ) <= Kinematics::kMaxParticles );
+
+  m_data = static_cast< const char* >( m_map ) + m_header->headerSize;
+  m_stride = binaryDataColumnStride( m_header->numEvents, m_header->precision );
+
+  uint64_t nColumns = 4 * m_header->numParticles + ( m_header->hasWeight ? 1 : 0 );
+  assert( m_mapSize >= m_header->headerSize + nColumns * m_stride * m_header->precision );
+
+  unsigned int first = 0;
+  unsigned int last = static_cast< unsigned int >( m_header->numEvents );
+  if( slice != "" && !readerSliceRange( slice, last, first, last ) ){
+
+    cout << "BinaryDataReader ERROR:  slice=" << slice << " is not of the form i/n" << endl;
+    assert( false );
+  }
+  m_first = first;
+  m_numEvents = last - first;
+
+  // tell the kernel the file will be read front to back
+  madvise( m_map, m_mapSize, MADV_SEQUENTIAL );
+
+  cout << "BinaryDataReader:  mapped " << m_numEvents << " events with "
+       << m_header->numParticles << " particles from " << args[0];
+  if( slice != "" ) cout << " (slice " << slice << ")";
+  cout << endl;
+}
+
+BinaryDataReader::~BinaryDataReader()
+{
+  if( m_map != NULL ) munmap( m_map, m_mapSize );
+}
+
+void
+BinaryDataReader::resetSource()
+{
+  // this will cause the read to start back at event 0
+  m_eventCounter = 0;
+}
+
+Kinematics*
+BinaryDataReader::getEvent()
+{
+  if( m_eventCounter < numEvents() ){
+
+    float weight = 1.0;
+
+    if( isDouble() ){
+
+      fillList< double >( m_eventCounter++, weight );
+    }
+    else{
+
+      fillList< float >( m_eventCounter++, weight );
+    }
+
+    return new PooledKinematics( m_particleList, weight );
+  }
+  else{
+
+    return NULL;
+  }
+}
+
+unsigned int
+BinaryDataReader::numEvents() const
+{
+  return m_numEvents;
+}
+
+template< class T >
+void
+BinaryDataReader::fillList( unsigned int iEvent, float& weight )
+{
+  int nPart = numParticles();
+  m_particleList.resize( nPart );
+
+  for( int i = 0; i < nPart; ++i ){
+
+    m_particleList[i].SetPxPyPzE( column< T >( kPx, i )[iEvent],
+                                  column< T >( kPy, i )[iEvent],
+                                  column< T >( kPz, i )[iEvent],
+                                  column< T >( kE, i )[iEvent] );
+  }
+
+  if( m_header->hasWeight ) weight = weightColumn< T >()[iEvent];
+}
@@ -0,0 +1,115 @@
+#if !defined(BINARYDATAREADER)
+#define BINARYDATAREADER
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+#include "AMPTOOLS_DATAIO/BinaryDataFormat.h"
+
+#include "TLorentzVector.h"
+
+#include <string>
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+/**
+ * This class reads the flat binary format written by BinaryDataWriter
+ * (see BinaryDataFormat.h).  The file is memory-mapped when the reader
+ * is constructed, so there is no decoding step and the columns can be
+ * used in place through column().
+ */
+
+class BinaryDataReader : public UserDataReader< BinaryDataReader >
+{
+
+public:
+
+  enum Component { kE = 0, kPx, kPy, kPz };
+
+  /**
+   * Default constructor for BinaryDataReader
+   */
+  BinaryDataReader() : UserDataReader< BinaryDataReader >(),
+    m_map( NULL ), m_mapSize( 0 ), m_header( NULL ), m_first( 0 ), m_numEvents( 0 ) { }
+
+  ~BinaryDataReader();
+
+  /**
+   * Constructor for BinaryDataReader
+   * \param[in] args vector of string arguments
+   * arguments:
+   *   0:  file name
+   * options (optional, after the file name):
+   *   slice=<i>/<n>  the reader only returns the slice i of n equal
+   *           slices of the events, e.g., for rank i of n in a parallel
+   *           fit; only the pages of the slice are read from the file
+   */
+  BinaryDataReader( const vector< string >& args );
+
+  string name() const { return "BinaryDataReader"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight(){ return m_header->hasWeight != 0; };
+  virtual unsigned int numEvents() const;
+
+  /**
+   * The number of particles per event, including the beam.
+   */
+  int numParticles() const { return m_header->numParticles; }
+
+  /**
+   * True if the values in the file are stored as double.
+   */
+  bool isDouble() const { return m_header->precision == sizeof( double ); }
+
+  /**
+   * Returns a pointer into the mapped file to the column of the given
+   * component and particle (0 = beam), starting at the first event of
+   * the reader; the column has numEvents() entries.  T must match the precision of
+   * the file, e.g., column< float >( BinaryDataReader::kE, 1 ).
+   */
+  template< class T >
+  const T* column( Component comp, int particle ) const {
+
+    assert( sizeof( T ) == m_header->precision );
+    return reinterpret_cast< const T* >( m_data ) +
+      ( comp * m_header->numParticles + particle ) * m_stride + m_first;
+  }
+
+  /**
+   * Returns a pointer into the mapped file to the weight column, or NULL
+   * if the file has no weights.
+   */
+  template< class T >
+  const T* weightColumn() const {
+
+    assert( sizeof( T ) == m_header->precision );
+    if( m_header->hasWeight == 0 ) return NULL;
+    return reinterpret_cast< const T* >( m_data ) +
+      4 * m_header->numParticles * m_stride + m_first;
+  }
+
+private:
+
+  template< class T > void fillList( unsigned int iEvent, float& weight );
+
+  unsigned int m_eventCounter;
+
+  void* m_map;
+  size_t m_mapSize;
+  const BinaryDataHeader* m_header;
+  const char* m_data;
+  uint64_t m_stride;
+
+  // the events of the file that the reader returns
+  uint64_t m_first;
+  unsigned int m_numEvents;
+
+  vector< TLorentzVector > m_particleList;
+};
+
+#endif
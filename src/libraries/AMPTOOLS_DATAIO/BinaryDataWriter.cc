@@ -0,0 +1,108 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "AMPTOOLS_DATAIO/BinaryDataWriter.h"
+#include "AMPTOOLS_DATAIO/BinaryDataFormat.h"
+
+static_assert( sizeof( BinaryDataHeader ) % kBinaryDataAlign == 0,
+               "the header must preserve the column alignment" );
+
+BinaryDataWriter::BinaryDataWriter( const string& outFile, bool writeWeight,
+                                    bool doublePrecision ) :
+  m_outFile( outFile ),
+  m_writeWeight( writeWeight ),
+  m_doublePrecision( doublePrecision ),
+  m_eventCounter( 0 ),
+  m_nPart( 0 )
+{ }
+
+BinaryDataWriter::~BinaryDataWriter()
+{
+  FILE* fid = fopen( m_outFile.c_str(), "wb" );
+
+  if( fid == NULL ){
+
+    cout << "BinaryDataWriter ERROR:  unable to open " << m_outFile << endl;
+    assert( false );
+  }
+
+  BinaryDataHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, kBinaryDataMagic, sizeof( kBinaryDataMagic ) );
+  header.version = kBinaryDataVersion;
+  header.headerSize = sizeof( BinaryDataHeader );
+  header.numEvents = m_eventCounter;
+  header.numParticles = m_nPart;
+  header.hasWeight = ( m_writeWeight ? 1 : 0 );
+  header.precision = ( m_doublePrecision ? sizeof( double ) : sizeof( float ) );
+
+  fwrite( &header, sizeof( header ), 1, fid );
+
+  if( m_doublePrecision ){
+
+    writeColumns< double >( fid );
+  }
+  else{
+
+    writeColumns< float >( fid );
+  }
+
+  fclose( fid );
+}
+
+void
+BinaryDataWriter::writeEvent( const Kinematics& kin )
+{
+  const vector< TLorentzVector >& particleList = kin.particleList();
+
+  assert( particleList.size() <= Kinematics::kMaxParticles );
+
+  // the column layout needs the same number of particles in every event
+  if( m_eventCounter == 0 ) m_nPart = particleList.size();
+  assert( static_cast< int >( particleList.size() ) == m_nPart );
+
+  for( int i = 0; i < m_nPart; ++i ){
+
+    m_values.push_back( particleList[i].E() );
+    m_values.push_back( particleList[i].Px() );
+    m_values.push_back( particleList[i].Py() );
+    m_values.push_back( particleList[i].Pz() );
+  }
+
+  if( m_writeWeight ) m_weight.push_back( kin.weight() );
+
+  m_eventCounter++;
+}
+
+template< class T >
+void
+BinaryDataWriter::writeColumns( FILE* fid ) const
+{
+  uint64_t stride = binaryDataColumnStride( m_eventCounter, sizeof( T ) );
+
+  // the header size is a multiple of the alignment, so padding each
+  // column to the stride keeps every column aligned
+  vector< T > column( stride, 0 );
+  if( stride == 0 ) return;
+
+  for( int comp = 0; comp < 4; ++comp ){
+    for( int part = 0; part < m_nPart; ++part ){
+
+      for( int i = 0; i < m_eventCounter; ++i ){
+
+        column[i] = m_values[( i * m_nPart + part ) * 4 + comp];
+      }
+
+      fwrite( &column[0], sizeof( T ), stride, fid );
+    }
+  }
+
+  if( m_writeWeight ){
+
+    for( int i = 0; i < m_eventCounter; ++i ) column[i] = m_weight[i];
+    fwrite( &column[0], sizeof( T ), stride, fid );
+  }
+}
@@ -0,0 +1,58 @@
+#if !defined(BINARYDATAWRITER)
+#define BINARYDATAWRITER
+
+#include "IUAmpTools/Kinematics.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * This class writes events to the flat binary format described in
+ * BinaryDataFormat.h.  It is meant for intermediate files, e.g., the
+ * output of split_mass, that are read back by BinaryDataReader and
+ * need none of the features of ROOT I/O.
+ *
+ * Since the file is stored as columns, the events are kept in memory
+ * and the file is written when the writer is destroyed.
+ */
+
+class BinaryDataWriter
+{
+
+public:
+
+  /**
+   * Constructor for BinaryDataWriter.
+   *
+   * \param[in] outFile name of output file
+   * \param[in] writeWeight (optional) enables writing of the event weight
+   * \param[in] doublePrecision (optional) store values as double instead of float
+   */
+  BinaryDataWriter( const string& outFile, bool writeWeight = false,
+                    bool doublePrecision = false );
+
+  ~BinaryDataWriter();
+
+  void writeEvent( const Kinematics& kin );
+
+  int eventCounter() const { return m_eventCounter; }
+
+private:
+
+  template< class T > void writeColumns( FILE* fid ) const;
+
+  string m_outFile;
+  bool m_writeWeight;
+  bool m_doublePrecision;
+
+  int m_eventCounter;
+  int m_nPart;
+
+  // event-major while writing: E, Px, Py, Pz of every particle
+  vector< double > m_values;
+  vector< double > m_weight;
+};
+
+#endif
@@ -0,0 +1,370 @@
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+#include <cmath>
+#include <cstdio>
+#include <cassert>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/NormIntInterface.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_DATAIO/ChunkedNormInt.h"
+
+map< string, DataReader* >&
+ChunkedNormInt::prototypes(){
+
+  static map< string, DataReader* > registered;
+  return registered;
+}
+
+void
+ChunkedNormInt::registerDataReader( const DataReader& prototype ){
+
+  prototypes()[prototype.name()] = prototype.clone();
+}
+
+static bool
+isFile( const string& name ){
+
+  struct stat info;
+  return stat( name.c_str(), &info ) == 0 && S_ISREG( info.st_mode );
+}
+
+ChunkedNormInt::ChunkedNormInt( unsigned int chunkSize, bool deferGenerated ) :
+  m_chunkSize( chunkSize ),
+  m_deferGenerated( deferGenerated ),
+  m_cfgInfo( NULL )
+{
+  if( m_chunkSize == 0 ) m_chunkSize = 1;
+}
+
+int
+ChunkedNormInt::compute( ConfigurationInfo* cfgInfo, const NormIntCache& cache ){
+
+  m_cfgInfo = cfgInfo;
+  m_pending.clear();
+  m_complete.clear();
+
+  const vector< pair< string, string > >& missing = cache.missing();
+  if( missing.empty() ) return 0;
+
+  // the amplitudes of the chunks, without the data and MC of the fit
+  AmpToolsInterface ati( cfgInfo, AmpToolsInterface::kMCGeneration );
+
+  int nStored = 0;
+  for( unsigned int i = 0; i < missing.size(); ++i ){
+
+    const string& reaction = missing[i].first;
+    ReactionInfo* reactionInfo = cfgInfo->reaction( reaction );
+
+    vector< string > amps;
+    vector< AmplitudeInfo* > ampList = cfgInfo->amplitudeList( reaction );
+    for( unsigned int j = 0; j < ampList.size(); ++j ) amps.push_back( ampList[j]->fullName() );
+
+    cout << "ChunkedNormInt:  computing the normalization integrals of reaction " << reaction
+         << " in chunks of " << m_chunkSize << " events" << endl;
+
+    if( m_deferGenerated ){
+
+      Pending pending;
+      pending.reaction = reaction;
+      pending.amps = amps;
+      pending.cacheFile = missing[i].second;
+      pending.provisionalFile = missing[i].second + ".accepted";
+      pending.outFile = reactionInfo->normIntFile();
+      pending.genWeight = sumWeights( reactionInfo->genMC() );
+      pending.accWeight = integrate( ati, reaction, amps, reactionInfo->accMC(), pending.accSums );
+
+      if( !( pending.genWeight > 0 ) ){
+
+        cout << "ChunkedNormInt ERROR:  no generated MC for reaction " << reaction << endl;
+        continue;
+      }
+
+      // the fit reads the accepted MC integrals; its reaction is no
+      // longer one that the cache looks for
+      vector< complex< double > > noSums( pending.accSums.size(), complex< double >( 0, 0 ) );
+      if( !write( pending.provisionalFile, amps, pending.genWeight, pending.accWeight,
+                  noSums, pending.accSums ) ) continue;
+
+      cout << "ChunkedNormInt:  the generated MC of reaction " << reaction
+           << " is read when the fit is finalized" << endl;
+
+      reactionInfo->setNormIntFile( pending.provisionalFile, true );
+      m_pending.push_back( pending );
+      ++nStored;
+      continue;
+    }
+
+    vector< complex< double > > genSums, accSums;
+    double genWeight = integrate( ati, reaction, amps, reactionInfo->genMC(), genSums );
+    double accWeight = integrate( ati, reaction, amps, reactionInfo->accMC(), accSums );
+
+    if( !( genWeight > 0 ) ){
+
+      cout << "ChunkedNormInt ERROR:  no generated MC for reaction " << reaction << endl;
+      continue;
+    }
+
+    if( write( missing[i].second, amps, genWeight, accWeight, genSums, accSums ) ) ++nStored;
+  }
+
+  return nStored;
+}
+
+void
+ChunkedNormInt::finish( AmpToolsInterface& ati ){
+
+  if( !m_pending.empty() ){
+
+    AmpToolsInterface mcATI( m_cfgInfo, AmpToolsInterface::kMCGeneration );
+
+    for( unsigned int i = 0; i < m_pending.size(); ++i ){
+
+      const Pending& pending = m_pending[i];
+      ReactionInfo* reactionInfo = m_cfgInfo->reaction( pending.reaction );
+
+      // another fit on the same cache may have completed it already
+      if( !isFile( pending.cacheFile ) ){
+
+        cout << "ChunkedNormInt:  computing the generated MC integrals of reaction "
+             << pending.reaction << " in chunks of " << m_chunkSize << " events" << endl;
+
+        vector< complex< double > > genSums;
+        integrate( mcATI, pending.reaction, pending.amps, reactionInfo->genMC(), genSums );
+
+        if( !write( pending.cacheFile, pending.amps, pending.genWeight, pending.accWeight,
+                    genSums, pending.accSums ) ) continue;
+      }
+
+      remove( pending.provisionalFile.c_str() );
+
+      if( !pending.outFile.empty() ){
+
+        ifstream in( pending.cacheFile.c_str(), ios::binary );
+        ofstream out( pending.outFile.c_str(), ios::binary );
+        out << in.rdbuf();
+      }
+
+      // fits built from here on read the complete integrals
+      reactionInfo->setNormIntFile( pending.cacheFile, true );
+      m_complete.push_back( make_pair( pending.reaction, pending.cacheFile ) );
+    }
+
+    m_pending.clear();
+  }
+
+  for( unsigned int i = 0; i < m_complete.size(); ++i ){
+
+    NormIntInterface* normInt = ati.normIntInterface( m_complete[i].first );
+    if( normInt == NULL ) continue;
+
+    ifstream in( m_complete[i].second.c_str() );
+    normInt->loadNormIntCache( in );
+  }
+}
+
+double
+ChunkedNormInt::sumWeights( const pair< string, vector< string > >& source ) const {
+
+  map< string, DataReader* >::const_iterator prototype = prototypes().find( source.first );
+  if( prototype == prototypes().end() ){
+
+    cout << "ChunkedNormInt ERROR:  the data reader " << source.first << " is not registered" << endl;
+    assert( false );
+  }
+
+  DataReader* reader = prototype->second->newDataReader( source.second );
+
+  double sum = 0;
+  if( !reader->hasWeight() ){
+
+    sum = reader->numEvents();
+  }
+  else{
+
+    Kinematics* event;
+    while( ( event = reader->getEvent() ) != NULL ){
+
+      sum += event->weight();
+      delete event;
+    }
+  }
+
+  delete reader;
+  return sum;
+}
+
+double
+ChunkedNormInt::integrate( AmpToolsInterface& ati, const string& reaction, const vector< string >& amps,
+                           const pair< string, vector< string > >& source,
+                           vector< complex< double > >& sums ) const {
+
+  map< string, DataReader* >::const_iterator prototype = prototypes().find( source.first );
+  if( prototype == prototypes().end() ){
+
+    cout << "ChunkedNormInt ERROR:  the data reader " << source.first << " is not registered" << endl;
+    assert( false );
+  }
+
+  DataReader* reader = prototype->second->newDataReader( source.second );
+
+  // a chunk is the next m_chunkSize events of the reader, served to the
+  // framework through a source of StreamDataReader
+  string sourceName = "chunkednormint_" + reaction;
+  unsigned int nRead = 0;
+  StreamDataReader::registerSource( sourceName,
+    [this, reader, &nRead]( vector< TLorentzVector >& particles, float& weight ){
+
+      if( nRead == m_chunkSize ) return false;
+
+      Kinematics* event = reader->getEvent();
+      if( event == NULL ) return false;
+
+      particles = event->particleList();
+      weight = event->weight();
+      delete event;
+
+      ++nRead;
+      return true;
+    } );
+
+  vector< string > args( 1, "callback:" + sourceName );
+  auto readChunk = [&](){ nRead = 0; return new StreamDataReader( args ); };
+
+  int nAmps = amps.size();
+  sums.assign( nAmps * ( nAmps + 1 ) / 2, complex< double >( 0, 0 ) );
+  double sumWeights = 0;
+  vector< complex< double > > a( nAmps );
+
+  StreamDataReader* chunk = readChunk();
+  while( chunk->numEvents() > 0 ){
+
+    // reads the next chunk while the amplitudes of this one are computed
+    StreamDataReader* next = NULL;
+    thread prefetch( [&](){ next = readChunk(); } );
+
+    ati.loadEvents( chunk );
+    ati.processEvents( reaction );
+
+    int nEvents = ati.numEvents();
+    for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      Kinematics* event = ati.kinematics( iEvent );
+      double w = event->weight();
+      sumWeights += w;
+      delete event;
+
+      for( int iamp = 0; iamp < nAmps; ++iamp ) a[iamp] = ati.decayAmplitude( iEvent, amps[iamp] );
+
+      int k = 0;
+      for( int iamp = 0; iamp < nAmps; ++iamp )
+        for( int jamp = iamp; jamp < nAmps; ++jamp ) sums[k++] += w * a[iamp] * conj( a[jamp] );
+    }
+
+    ati.clearEvents();
+
+    prefetch.join();
+    delete chunk;
+    chunk = next;
+  }
+
+  delete chunk;
+  delete reader;
+
+  // the source refers to the reader and the counter of this call
+  StreamDataReader::registerSource( sourceName,
+    []( vector< TLorentzVector >&, float& ){ return false; } );
+
+  return sumWeights;
+}
+
+bool
+ChunkedNormInt::write( const string& fileName, const vector< string >& amps,
+                       double genWeight, double accWeight,
+                       const vector< complex< double > >& genSums,
+                       const vector< complex< double > >& accSums ) const {
+
+  int nAmps = amps.size();
+
+  // both integrals are normalized to the generated events, as the
+  // framework does, and are Hermitian
+  vector< vector< complex< double > > > ampInt( nAmps, vector< complex< double > >( nAmps ) );
+  vector< vector< complex< double > > > normInt( nAmps, vector< complex< double > >( nAmps ) );
+
+  int k = 0;
+  for( int i = 0; i < nAmps; ++i )
+    for( int j = i; j < nAmps; ++j, ++k ){
+
+      ampInt[i][j] = genSums[k] / genWeight;
+      ampInt[j][i] = conj( ampInt[i][j] );
+      normInt[i][j] = accSums[k] / genWeight;
+      normInt[j][i] = conj( normInt[i][j] );
+    }
+
+  // written under a temporary name, as NormIntCache::store does
+  size_t slash = fileName.rfind( '/' );
+  if( slash != string::npos ) mkdir( fileName.substr( 0, slash ).c_str(), 0755 );
+
+  ostringstream tmpFile;
+  tmpFile << fileName << "." << getpid() << ".tmp";
+
+  ofstream out( tmpFile.str().c_str() );
+  out.precision( 17 );
+  out << genWeight << "\t" << accWeight << endl;
+  out << nAmps << endl;
+  for( int i = 0; i < nAmps; ++i ) out << amps[i] << endl;
+  for( int i = 0; i < nAmps; ++i ){
+
+    for( int j = 0; j < nAmps; ++j ) out << ampInt[i][j] << "\t";
+    out << endl;
+  }
+  for( int i = 0; i < nAmps; ++i ){
+
+    for( int j = 0; j < nAmps; ++j ) out << normInt[i][j] << "\t";
+    out << endl;
+  }
+  out.close();
+
+  // the framework has to read back what was summed here, to the
+  // precision of a build with single-precision amplitudes
+  NormIntInterface check( tmpFile.str() );
+  for( int i = 0; i < nAmps; ++i ){
+
+    double scale = abs( normInt[i][i] ) + abs( ampInt[i][i] );
+    if( abs( check.normInt( amps[i], amps[i] ) - normInt[i][i] ) +
+        abs( check.ampInt( amps[i], amps[i] ) - ampInt[i][i] ) > 1e-6 * scale ){
+
+      cout << "ChunkedNormInt ERROR:  the integrals of " << amps[i]
+           << " do not read back from " << tmpFile.str() << endl;
+      remove( tmpFile.str().c_str() );
+      return false;
+    }
+  }
+
+  if( rename( tmpFile.str().c_str(), fileName.c_str() ) != 0 ){
+
+    cout << "ChunkedNormInt ERROR:  cannot write " << fileName << endl;
+    remove( tmpFile.str().c_str() );
+    return false;
+  }
+
+  cout << "ChunkedNormInt:  stored the normalization integrals in " << fileName << endl;
+  return true;
+}
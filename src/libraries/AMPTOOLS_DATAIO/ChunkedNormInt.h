@@ -0,0 +1,117 @@
+#if !defined(CHUNKEDNORMINT)
+#define CHUNKEDNORMINT
+
+#include <complex>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+class DataReader;
+class NormIntCache;
+
+/**
+ * The normalization integrals of MC samples that do not fit in memory.
+ * AmpToolsInterface holds all accepted and generated MC events of a
+ * reaction (on the host and, on GPU builds, on the device) to compute its
+ * integrals.  Here the events are read through the reader of the
+ * configuration a chunk at a time, the amplitudes of a chunk are computed
+ * by an AmpToolsInterface without data (kMCGeneration) and their products
+ * are summed, so only one chunk and the integral matrices are held.  The
+ * next chunk is read on a second thread while the amplitudes of the
+ * current one are computed.
+ *
+ * Integrals that depend on free parameters change with every iteration
+ * and are left to the framework; the others are the ones NormIntCache
+ * keeps.  They are computed once, written to the cache and checked by
+ * reading them back, and the fit then reads them from the cache without
+ * loading the MC.
+ *
+ * The integrals over the generated MC (ampInt) are only used by the
+ * results of a fit, not while it minimizes.  With deferGenerated, compute
+ * only sums the accepted MC and the weights of the generated MC, and the
+ * fit reads a provisional file without ampInt; finish sums the generated
+ * MC in chunks, stores the complete integrals in the cache and loads them
+ * into the fit before its results are written.
+ *
+ * Usage:  register every data reader (next to its registration with
+ * AmpToolsInterface) and the amplitudes, call compute after
+ * NormIntCache::prepare and then prepare again; with deferGenerated call
+ * finish before AmpToolsInterface::finalizeFit.
+ */
+
+class ChunkedNormInt
+{
+
+public:
+
+  static void registerDataReader( const DataReader& prototype );
+
+  ChunkedNormInt( unsigned int chunkSize, bool deferGenerated = false );
+
+  /**
+   * Computes and stores the integrals of the reactions that cache did not
+   * find in prepare; returns the number of reactions stored, or pointed at
+   * a provisional file with deferGenerated.
+   */
+  int compute( ConfigurationInfo* cfgInfo, const NormIntCache& cache );
+
+  /**
+   * Completes the deferred integrals, the first time it is called, and
+   * loads them into the integrals of ati.
+   */
+  void finish( AmpToolsInterface& ati );
+
+private:
+
+  /**
+   * Sums w a_i conj( a_j ), i <= j, row by row, over the events of source
+   * and returns the sum of the weights.
+   */
+  double integrate( AmpToolsInterface& ati, const string& reaction, const vector< string >& amps,
+                    const pair< string, vector< string > >& source,
+                    vector< complex< double > >& sums ) const;
+
+  /**
+   * Writes the integrals in the format of the normintfile keyword and
+   * reads them back; returns false if they do not agree.
+   */
+  bool write( const string& fileName, const vector< string >& amps,
+              double genWeight, double accWeight,
+              const vector< complex< double > >& genSums,
+              const vector< complex< double > >& accSums ) const;
+
+  // the sum of the weights of the events of source
+  double sumWeights( const pair< string, vector< string > >& source ) const;
+
+  static map< string, DataReader* >& prototypes();
+
+  // a reaction whose generated MC is deferred
+  struct Pending {
+
+    string reaction;
+    vector< string > amps;
+    string cacheFile;
+    string provisionalFile;
+    string outFile;   // of the normintfile keyword
+
+    double genWeight;
+    double accWeight;
+    vector< complex< double > > accSums;
+  };
+
+  unsigned int m_chunkSize;
+  bool m_deferGenerated;
+
+  ConfigurationInfo* m_cfgInfo;
+  vector< Pending > m_pending;
+
+  // reaction name and file of the completed integrals
+  vector< pair< string, string > > m_complete;
+};
+
+#endif
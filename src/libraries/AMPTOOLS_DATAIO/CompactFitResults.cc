@@ -0,0 +1,403 @@
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+#include <cassert>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/NormIntInterface.h"
+
+#include "AMPTOOLS_DATAIO/CompactFitResults.h"
+
+static uint64_t
+aligned( uint64_t offset ){
+
+  return ( ( offset + kCompactFitAlign - 1 ) / kCompactFitAlign ) * kCompactFitAlign;
+}
+
+// appends value to the string section and returns its offset
+static uint64_t
+addString( vector< char >& strings, const string& value ){
+
+  uint64_t offset = strings.size();
+  strings.insert( strings.end(), value.begin(), value.end() );
+  strings.push_back( '\0' );
+  return offset;
+}
+
+string
+CompactFitResults::companionName( const string& fitFile ){
+
+  if( fitFile.size() > 5 && fitFile.compare( fitFile.size() - 5, 5, ".fitb" ) == 0 )
+    return fitFile;
+  if( fitFile.size() > 4 && fitFile.compare( fitFile.size() - 4, 4, ".fit" ) == 0 )
+    return fitFile + "b";
+  return fitFile + ".fitb";
+}
+
+bool
+CompactFitResults::exists( const string& fitFile ){
+
+  string companion = companionName( fitFile );
+
+  struct stat info;
+  if( stat( companion.c_str(), &info ) != 0 || !S_ISREG( info.st_mode ) ) return false;
+
+  // a .fit file written after its companion, e.g., by a later fit without
+  // --binary-results, is newer than the companion
+  struct stat fitInfo;
+  return companion == fitFile || stat( fitFile.c_str(), &fitInfo ) != 0 ||
+         fitInfo.st_mtime <= info.st_mtime;
+}
+
+bool
+CompactFitResults::write( const FitResults& results, const string& fileName ){
+
+  CompactFitHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, kCompactFitMagic, sizeof( kCompactFitMagic ) );
+  header.version = kCompactFitVersion;
+  header.headerSize = sizeof( CompactFitHeader );
+  header.valid = results.valid() ? 1 : 0;
+  header.eMatrixStatus = results.eMatrixStatus();
+  header.likelihood = results.likelihood();
+
+  vector< char > strings;
+
+  // the parameter names are the first strings
+  vector< string > parNames = results.parNameList();
+  vector< double > parValues = results.parValueList();
+  vector< vector< double > > errorMatrix = results.errorMatrix();
+  header.numPars = parNames.size();
+
+  map< string, int > parIndex;
+  for( unsigned int i = 0; i < parNames.size(); ++i ){
+
+    addString( strings, parNames[i] );
+    parIndex[parNames[i]] = i;
+  }
+
+  vector< double > parameters( parValues );
+  for( unsigned int i = 0; i < header.numPars; ++i )
+    for( unsigned int j = 0; j < header.numPars; ++j )
+      parameters.push_back( i < errorMatrix.size() && j < errorMatrix[i].size() ?
+                            errorMatrix[i][j] : 0. );
+
+  vector< CompactFitAmplitude > amps;
+  vector< CompactFitReaction > reactions;
+  vector< complex< double > > integrals;
+
+  vector< string > reactionNames = results.reactionList();
+  for( unsigned int r = 0; r < reactionNames.size(); ++r ){
+
+    vector< AmplitudeInfo* > ampInfo = results.configInfo()->amplitudeList( reactionNames[r] );
+    const NormIntInterface* normInt = results.normInt( reactionNames[r] );
+
+    CompactFitReaction reaction;
+    memset( &reaction, 0, sizeof( reaction ) );
+    reaction.name = addString( strings, reactionNames[r] );
+    reaction.firstAmp = amps.size();
+    reaction.numAmps = ampInfo.size();
+    reaction.integrals = integrals.size() * sizeof( complex< double > );
+    reaction.genEvents = normInt->numGenEvents();
+    reaction.accEvents = normInt->numAccEvents();
+    reactions.push_back( reaction );
+
+    vector< string > ampNames;
+    for( unsigned int a = 0; a < ampInfo.size(); ++a ){
+
+      string name = ampInfo[a]->fullName();
+      ampNames.push_back( name );
+
+      CompactFitAmplitude amp;
+      memset( &amp, 0, sizeof( amp ) );
+      amp.name = addString( strings, name );
+      amp.sum = addString( strings, ampInfo[a]->sumName() );
+      amp.reaction = r;
+
+      map< string, int >::const_iterator par = parIndex.find( results.realProdParName( name ) );
+      amp.reParIndex = ( par == parIndex.end() ? -1 : par->second );
+      par = parIndex.find( results.imagProdParName( name ) );
+      amp.imParIndex = ( par == parIndex.end() ? -1 : par->second );
+
+      complex< double > value = results.productionParameter( name );
+      amp.production[0] = real( value );
+      amp.production[1] = imag( value );
+      value = results.scaledProductionParameter( name );
+      amp.scaledProduction[0] = real( value );
+      amp.scaledProduction[1] = imag( value );
+      amp.scale = results.ampScale( name );
+
+      amps.push_back( amp );
+    }
+
+    for( int accepted = 0; accepted < 2; ++accepted )
+      for( unsigned int a = 0; a < ampNames.size(); ++a )
+        for( unsigned int b = 0; b < ampNames.size(); ++b )
+          integrals.push_back( accepted ? normInt->normInt( ampNames[a], ampNames[b] ) :
+                                          normInt->ampInt( ampNames[a], ampNames[b] ) );
+  }
+
+  header.numAmps = amps.size();
+  header.numReactions = reactions.size();
+
+  header.parOffset = aligned( sizeof( CompactFitHeader ) );
+  header.ampOffset = aligned( header.parOffset + parameters.size() * sizeof( double ) );
+  header.reactionOffset = aligned( header.ampOffset + amps.size() * sizeof( CompactFitAmplitude ) );
+  header.integralOffset = aligned( header.reactionOffset +
+                                   reactions.size() * sizeof( CompactFitReaction ) );
+  header.stringOffset = aligned( header.integralOffset +
+                                 integrals.size() * sizeof( complex< double > ) );
+  header.stringSize = strings.size();
+
+  // the whole file in memory:  it is small next to the text it replaces
+  vector< char > buffer( header.stringOffset + header.stringSize, 0 );
+  memcpy( &buffer[0], &header, sizeof( header ) );
+  if( !parameters.empty() )
+    memcpy( &buffer[header.parOffset], &parameters[0], parameters.size() * sizeof( double ) );
+  if( !amps.empty() )
+    memcpy( &buffer[header.ampOffset], &amps[0], amps.size() * sizeof( CompactFitAmplitude ) );
+  if( !reactions.empty() )
+    memcpy( &buffer[header.reactionOffset], &reactions[0],
+            reactions.size() * sizeof( CompactFitReaction ) );
+  if( !integrals.empty() )
+    memcpy( &buffer[header.integralOffset], &integrals[0],
+            integrals.size() * sizeof( complex< double > ) );
+  if( !strings.empty() )
+    memcpy( &buffer[header.stringOffset], &strings[0], strings.size() );
+
+  ofstream out( fileName.c_str(), ios::binary );
+  out.write( &buffer[0], buffer.size() );
+  if( !out ){
+
+    cout << "CompactFitResults ERROR:  cannot write " << fileName << endl;
+    return false;
+  }
+  return true;
+}
+
+CompactFitResults::CompactFitResults( const string& fileName ) :
+  m_map( NULL ),
+  m_mapSize( 0 ),
+  m_header( NULL )
+{
+  string name = companionName( fileName );
+
+  int fd = open( name.c_str(), O_RDONLY );
+  if( fd < 0 ){
+
+    cout << "CompactFitResults ERROR:  unable to open " << name << endl;
+    return;
+  }
+
+  struct stat st;
+  fstat( fd, &st );
+  m_mapSize = st.st_size;
+
+  if( m_mapSize < sizeof( CompactFitHeader ) ){
+
+    cout << "CompactFitResults ERROR:  " << name << " is too short" << endl;
+    close( fd );
+    return;
+  }
+
+  m_map = mmap( NULL, m_mapSize, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+
+  if( m_map == MAP_FAILED ){
+
+    cout << "CompactFitResults ERROR:  unable to map " << name << endl;
+    m_map = NULL;
+    return;
+  }
+
+  const CompactFitHeader* header = static_cast< const CompactFitHeader* >( m_map );
+  if( memcmp( header->magic, kCompactFitMagic, sizeof( kCompactFitMagic ) ) != 0 ||
+      header->version != kCompactFitVersion ||
+      header->stringOffset + header->stringSize > m_mapSize ){
+
+    cout << "CompactFitResults ERROR:  " << name
+         << " is not a version " << kCompactFitVersion << " compact fit file" << endl;
+    return;
+  }
+  m_header = header;
+
+  const char* base = static_cast< const char* >( m_map );
+  m_parValues = reinterpret_cast< const double* >( base + m_header->parOffset );
+  m_errorMatrix = m_parValues + m_header->numPars;
+  m_amps = reinterpret_cast< const CompactFitAmplitude* >( base + m_header->ampOffset );
+  m_reactions = reinterpret_cast< const CompactFitReaction* >( base + m_header->reactionOffset );
+  m_integrals = reinterpret_cast< const complex< double >* >( base + m_header->integralOffset );
+  m_strings = base + m_header->stringOffset;
+
+  const char* parName = m_strings;
+  for( unsigned int i = 0; i < m_header->numPars; ++i ){
+
+    m_parNames.push_back( parName );
+    parName += m_parNames.back().size() + 1;
+  }
+
+  for( unsigned int i = 0; i < m_header->numAmps; ++i )
+    m_ampIndex[text( m_amps[i].name )] = i;
+  for( unsigned int i = 0; i < m_header->numReactions; ++i )
+    m_reactionIndex[text( m_reactions[i].name )] = i;
+}
+
+CompactFitResults::~CompactFitResults()
+{
+  if( m_map != NULL ) munmap( m_map, m_mapSize );
+}
+
+vector< double >
+CompactFitResults::parValueList() const {
+
+  return vector< double >( m_parValues, m_parValues + m_header->numPars );
+}
+
+vector< vector< double > >
+CompactFitResults::errorMatrix() const {
+
+  unsigned int n = m_header->numPars;
+  vector< vector< double > > matrix( n );
+  for( unsigned int i = 0; i < n; ++i )
+    matrix[i].assign( m_errorMatrix + i * n, m_errorMatrix + ( i + 1 ) * n );
+  return matrix;
+}
+
+vector< string >
+CompactFitResults::reactionList() const {
+
+  vector< string > names;
+  for( unsigned int i = 0; i < m_header->numReactions; ++i )
+    names.push_back( text( m_reactions[i].name ) );
+  return names;
+}
+
+vector< string >
+CompactFitResults::ampList( const string& name ) const {
+
+  const CompactFitReaction& r = reaction( name );
+
+  vector< string > names;
+  for( unsigned int i = 0; i < r.numAmps; ++i )
+    names.push_back( text( m_amps[r.firstAmp + i].name ) );
+  return names;
+}
+
+const CompactFitAmplitude&
+CompactFitResults::amplitude( const string& amp ) const {
+
+  map< string, unsigned int >::const_iterator i = m_ampIndex.find( amp );
+  if( i == m_ampIndex.end() ){
+
+    cout << "CompactFitResults ERROR:  unknown amplitude " << amp << endl;
+    assert( false );
+  }
+  return m_amps[i->second];
+}
+
+const CompactFitReaction&
+CompactFitResults::reaction( const string& name ) const {
+
+  map< string, unsigned int >::const_iterator i = m_reactionIndex.find( name );
+  if( i == m_reactionIndex.end() ){
+
+    cout << "CompactFitResults ERROR:  unknown reaction " << name << endl;
+    assert( false );
+  }
+  return m_reactions[i->second];
+}
+
+complex< double >
+CompactFitResults::productionParameter( const string& amp ) const {
+
+  const CompactFitAmplitude& a = amplitude( amp );
+  return complex< double >( a.production[0], a.production[1] );
+}
+
+complex< double >
+CompactFitResults::scaledProductionParameter( const string& amp ) const {
+
+  const CompactFitAmplitude& a = amplitude( amp );
+  return complex< double >( a.scaledProduction[0], a.scaledProduction[1] );
+}
+
+double
+CompactFitResults::ampScale( const string& amp ) const {
+
+  return amplitude( amp ).scale;
+}
+
+string
+CompactFitResults::sumName( const string& amp ) const {
+
+  return text( amplitude( amp ).sum );
+}
+
+// the names of the parameters of the fit, or, for a part that is not one
+// (e.g., the imaginary part of a real amplitude), the name FitResults uses
+string
+CompactFitResults::realProdParName( const string& amp ) const {
+
+  int i = amplitude( amp ).reParIndex;
+  return i < 0 ? amp + "_re" : m_parNames[i];
+}
+
+string
+CompactFitResults::imagProdParName( const string& amp ) const {
+
+  int i = amplitude( amp ).imParIndex;
+  return i < 0 ? amp + "_im" : m_parNames[i];
+}
+
+complex< double >
+CompactFitResults::integral( const string& amp, const string& conjAmp, bool accepted ) const {
+
+  const CompactFitAmplitude& a = amplitude( amp );
+  const CompactFitAmplitude& b = amplitude( conjAmp );
+
+  // amplitudes of different reactions do not interfere
+  if( a.reaction != b.reaction ) return 0;
+
+  const CompactFitReaction& r = m_reactions[a.reaction];
+  const complex< double >* ints = m_integrals + r.integrals / sizeof( complex< double > );
+  if( accepted ) ints += r.numAmps * r.numAmps;
+
+  unsigned int i = ( &a - m_amps ) - r.firstAmp;
+  unsigned int j = ( &b - m_amps ) - r.firstAmp;
+  return ints[i * r.numAmps + j];
+}
+
+complex< double >
+CompactFitResults::ampInt( const string& amp, const string& conjAmp ) const {
+
+  return integral( amp, conjAmp, false );
+}
+
+complex< double >
+CompactFitResults::normInt( const string& amp, const string& conjAmp ) const {
+
+  return integral( amp, conjAmp, true );
+}
+
+double
+CompactFitResults::numGenEvents( const string& name ) const {
+
+  return reaction( name ).genEvents;
+}
+
+double
+CompactFitResults::numAccEvents( const string& name ) const {
+
+  return reaction( name ).accEvents;
+}
@@ -0,0 +1,183 @@
+#if !defined(COMPACTFITRESULTS)
+#define COMPACTFITRESULTS
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+
+using namespace std;
+
+class FitResults;
+
+/**
+ * The layout of the .fitb files written by CompactFitResults::write.  A
+ * file is a fixed-size header followed by sections at the offsets of the
+ * header, each on a kCompactFitAlign byte boundary so that the file can
+ * be used in place after it is memory-mapped:
+ *
+ *   parameters:  the values of the parameters (numPars doubles), then
+ *                the error matrix (numPars x numPars doubles, by rows)
+ *   amplitudes:  a CompactFitAmplitude per amplitude of every reaction
+ *   reactions:   a CompactFitReaction per reaction
+ *   integrals:   for each reaction with n amplitudes, the n x n ampInt
+ *                then the n x n normInt, as complex doubles
+ *   strings:     the names, each terminated by a zero byte; the other
+ *                sections refer to them by their offset in this section
+ *
+ * The parameter names are the first numPars strings.  All values are in
+ * the byte order of the machine that wrote the file.
+ */
+
+static const char kCompactFitMagic[8] = "HDFITB1";
+static const uint32_t kCompactFitVersion = 1;
+static const uint32_t kCompactFitAlign = 64;
+
+struct CompactFitHeader {
+
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint32_t valid;
+  int32_t eMatrixStatus;
+  double likelihood;
+  uint32_t numPars;
+  uint32_t numAmps;
+  uint32_t numReactions;
+  uint32_t pad;
+  uint64_t parOffset;
+  uint64_t ampOffset;
+  uint64_t reactionOffset;
+  uint64_t integralOffset;
+  uint64_t stringOffset;
+  uint64_t stringSize;
+};
+
+struct CompactFitAmplitude {
+
+  uint64_t name;       // the full name, reaction::sum::amp
+  uint64_t sum;        // the name of its sum
+  uint32_t reaction;
+  int32_t reParIndex;  // -1 if the part is not a parameter of the fit
+  int32_t imParIndex;
+  uint32_t pad;
+  double production[2];
+  double scaledProduction[2];
+  double scale;
+};
+
+struct CompactFitReaction {
+
+  uint64_t name;
+  uint32_t firstAmp;    // in the amplitudes section
+  uint32_t numAmps;
+  uint64_t integrals;   // the offset of its ampInt in the integrals section
+  double genEvents;
+  double accEvents;
+};
+
+/**
+ * A binary companion of a .fit file that holds what the moment and wave
+ * tools read from a FitResults:  the parameters with their error matrix,
+ * the production parameters and scales of the amplitudes with their sums,
+ * and the normalization integrals of each reaction.  Constructing a
+ * FitResults parses the whole text file and sets up the configuration;
+ * this maps the file and reads the values in place, so that loading the
+ * results of thousands of bins is bound by I/O rather than parsing.
+ *
+ * The accessors follow those of FitResults, so that a tool can read either
+ * with the same code.  The plotters still need a FitResults for their
+ * PlotGenerator.
+ *
+ * Usage:
+ *
+ *   CompactFitResults::write( *ati.fitResults(), "myfit.fitb" );
+ *
+ *   if( CompactFitResults::exists( "myfit.fit" ) ){
+ *     CompactFitResults results( "myfit.fit" );
+ *     ...
+ */
+
+class CompactFitResults
+{
+
+public:
+
+  /**
+   * Maps fileName, which is either the .fitb file or the .fit file whose
+   * companion it is.
+   */
+  CompactFitResults( const string& fileName );
+  ~CompactFitResults();
+
+  // the companion of a .fit file:  the same name with .fitb
+  static string companionName( const string& fitFile );
+
+  // true if the companion exists and is not older than the .fit file
+  static bool exists( const string& fitFile );
+
+  static bool write( const FitResults& results, const string& fileName );
+
+  // false if the file could not be read
+  bool ok() const { return m_header != NULL; }
+
+  bool valid() const { return m_header->valid != 0; }
+  double likelihood() const { return m_header->likelihood; }
+  int eMatrixStatus() const { return m_header->eMatrixStatus; }
+
+  const vector< string >& parNameList() const { return m_parNames; }
+  vector< double > parValueList() const;
+  vector< vector< double > > errorMatrix() const;
+
+  // in place:  numPars values and numPars x numPars by rows
+  const double* parValues() const { return m_parValues; }
+  const double* errorMatrixData() const { return m_errorMatrix; }
+
+  vector< string > reactionList() const;
+  vector< string > ampList( const string& reaction ) const;
+
+  complex< double > productionParameter( const string& amp ) const;
+  complex< double > scaledProductionParameter( const string& amp ) const;
+  double ampScale( const string& amp ) const;
+  string sumName( const string& amp ) const;
+  string realProdParName( const string& amp ) const;
+  string imagProdParName( const string& amp ) const;
+
+  complex< double > ampInt( const string& amp, const string& conjAmp ) const;
+  complex< double > normInt( const string& amp, const string& conjAmp ) const;
+  double numGenEvents( const string& reaction ) const;
+  double numAccEvents( const string& reaction ) const;
+
+private:
+
+  CompactFitResults( const CompactFitResults& );
+  CompactFitResults& operator=( const CompactFitResults& );
+
+  const char* text( uint64_t offset ) const { return m_strings + offset; }
+
+  // the amplitude or reaction, with an error if it is not in the file
+  const CompactFitAmplitude& amplitude( const string& amp ) const;
+  const CompactFitReaction& reaction( const string& name ) const;
+
+  complex< double > integral( const string& amp, const string& conjAmp,
+                              bool accepted ) const;
+
+  void* m_map;
+  size_t m_mapSize;
+  const CompactFitHeader* m_header;
+
+  const double* m_parValues;
+  const double* m_errorMatrix;
+  const CompactFitAmplitude* m_amps;
+  const CompactFitReaction* m_reactions;
+  const complex< double >* m_integrals;
+  const char* m_strings;
+
+  vector< string > m_parNames;
+  map< string, unsigned int > m_ampIndex;
+  map< string, unsigned int > m_reactionIndex;
+};
+
+#endif
@@ -9,14 +9,16 @@
 
 /* Constructor to display FitResults */
 EtaPbPlotGenerator::EtaPbPlotGenerator( const FitResults& results ) :
-PlotGenerator( results )
+PlotGenerator( results ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
 
 /* Constructor for event generator (no FitResult) */
 EtaPbPlotGenerator::EtaPbPlotGenerator( ) :
-PlotGenerator( )
+PlotGenerator( ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
@@ -33,6 +35,21 @@ EtaPbPlotGenerator::createHistograms( ) {
 
 void
 EtaPbPlotGenerator::projectEvent( Kinematics* kin ){
+
+  bool cached;
+  double* values = m_projections.slot( kin, cached );
+  if( !cached ) computeProjections( kin, values );
+
+  // calls to fillHistogram go here
+  fillHistogram( kTheta, values[kTheta] );
+  fillHistogram( kPhi, values[kPhi] );
+  fillHistogram( kt, values[kt] );
+  fillHistogram( kTheta_phi, values[kPhi], values[kTheta] ); 
+  fillHistogram( kt_phi, values[kPhi], values[kt] ); 
+}
+
+void
+EtaPbPlotGenerator::computeProjections( Kinematics* kin, double* values ){
   
   TLorentzVector beam   = kin->particle( 0 );
   TLorentzVector p1 = kin->particle( 1 );
@@ -52,14 +69,8 @@ EtaPbPlotGenerator::projectEvent( Kinematics* kin ){
   if(phi < -1*PI) phi += 2*PI;
   if(phi > PI) phi -= 2*PI;
 
-  cout  << " Plot Generator M=" << beam.M() << " beam="; beam.Print();
-  cout << "M=" << p1.M() << " Eta="; p1.Print();
-  cout << "M=" << recoil.M() << " -t=" << -t << " recoil="; recoil.Print();
-
-  // calls to fillHistogram go here
-  fillHistogram( kTheta, Theta );
-  fillHistogram( kPhi, phi );
-  fillHistogram( kt, -t );      // fill with -t to make positive
-  fillHistogram( kTheta_phi, phi, Theta ); 
-  fillHistogram( kt_phi, phi, -t ); 
+  // the 2D histograms are filled from the values of the 1D ones
+  values[kTheta] = Theta;
+  values[kPhi] = phi;
+  values[kt] = -t;      // fill with -t to make positive
 }
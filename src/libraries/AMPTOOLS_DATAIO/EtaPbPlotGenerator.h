@@ -6,6 +6,8 @@
 
 #include "IUAmpTools/PlotGenerator.h"
 
+#include "AMPTOOLS_DATAIO/ProjectionCache.h"
+
 using namespace std;
 
 class FitResults;
@@ -27,6 +29,10 @@ public:
 private:
   
   void createHistograms( );
+
+  void computeProjections( Kinematics* kin, double* values );
+
+  ProjectionCache m_projections;
   
 };
 
@@ -7,22 +7,68 @@
 #include "IUAmpTools/Histogram1D.h"
 #include "IUAmpTools/Kinematics.h"
 
+// the histograms, by index
+static const struct { int nBins; double low, high; const char* name; const char* title; }
+kHists[EtaPiDeltaPlotGenerator::kNumHists] = {
+
+    { 80, 0.4, 3.0, "EtaPiMass", "Invariant Mass of #eta #pi^{-}" },
+    { 60, 0.8, 2.0, "DeltaPPMass", "Invariant Mass of p#pi^{+}" },
+    { 50, -1., 1., "cosTheta", "cos( #theta ) of Resonance Production" },
+    { 50, -180, 180, "Phi", "#Phi" },
+    { 100, 0, 2.00, "t", "-t" }
+};
+
 EtaPiDeltaPlotGenerator::EtaPiDeltaPlotGenerator( const FitResults& results ) :
-PlotGenerator( results )
+PlotGenerator( results ),
+m_projections( kNumHists )
 {
+    createHistograms();
+}
+
+EtaPiDeltaPlotGenerator::EtaPiDeltaPlotGenerator( ) :
+PlotGenerator( ),
+m_projections( kNumHists )
+{
+    createHistograms();
+}
+
+void EtaPiDeltaPlotGenerator::createHistograms() {
     // calls to bookHistogram go here
     
-    // bookHistogram( k2PiMass, new Histogram1D( 200, 0., 2.0, "M2pi", "Invariant Mass of #pi^{+} #pi^{-}") );
-    bookHistogram( kEtaPiMass, new Histogram1D( 80, 0.4, 3.0, "EtaPiMass", "Invariant Mass of #eta #pi^{-}") );
-    bookHistogram( kDeltaPPMass, new Histogram1D( 60, 0.8, 2.0, "DeltaPPMass", "Invariant Mass of p#pi^{+}") );
-    
-    bookHistogram( kEtaCosTheta, new Histogram1D( 50, -1., 1., "cosTheta", "cos( #theta ) of Resonance Production") );
-    bookHistogram( kPhi, new Histogram1D( 50, -180, 180, "Phi", "#Phi" ) );
-    bookHistogram( kt, new Histogram1D( 100, 0, 2.00, "t", "-t" ) );
+    for( int hist = 0; hist < kNumHists; ++hist )
+        bookHistogram( hist, new Histogram1D( kHists[hist].nBins, kHists[hist].low, kHists[hist].high,
+                                              kHists[hist].name, kHists[hist].title ) );
+}
+
+string
+EtaPiDeltaPlotGenerator::histogramName( int hist ){
+
+    return kHists[hist].name;
+}
+
+void
+EtaPiDeltaPlotGenerator::histogramBinning( int hist, int& nBins, double& low, double& high ){
+
+    nBins = kHists[hist].nBins;
+    low = kHists[hist].low;
+    high = kHists[hist].high;
 }
 
 void
 EtaPiDeltaPlotGenerator::projectEvent( Kinematics* kin ){
+
+    bool cached;
+    double* values = m_projections.slot( kin, cached );
+    if( !cached ) computeProjections( kin, values );
+
+    // calls to fillHistogram go here
+    
+    for( int hist = 0; hist < kNumHists; ++hist )
+        fillHistogram( hist, values[hist] );
+}
+
+void
+EtaPiDeltaPlotGenerator::computeProjections( Kinematics* kin, double* values ) const {
     
     TLorentzVector beam   = kin->particle( 0 );
     TLorentzVector protonP4 = kin->particle( 1 );//proton
@@ -90,12 +136,9 @@ EtaPiDeltaPlotGenerator::projectEvent( Kinematics* kin ){
     TLorentzVector TargetP4;
     TargetP4.SetPxPyPzE(0,0,0,0.938272);
     GDouble t=(recoil-TargetP4).Mag2();
-    // calls to fillHistogram go here
-    
-    fillHistogram( kEtaPiMass, ( resonance ).M() );
-    
-    fillHistogram( kDeltaPPMass, ( recoil ).M() );
-    fillHistogram( kEtaCosTheta, cosTheta );
-    fillHistogram( kPhi, phi );
-    fillHistogram( kt, -t );      // fill with -t to make positive
+    values[kEtaPiMass] = resonance.M();
+    values[kDeltaPPMass] = recoil.M();
+    values[kEtaCosTheta] = cosTheta;
+    values[kPhi] = phi;
+    values[kt] = -t;      // fill with -t to make positive
 }
@@ -6,6 +6,8 @@
 
 #include "IUAmpTools/PlotGenerator.h"
 
+#include "AMPTOOLS_DATAIO/ProjectionCache.h"
+
 using namespace std;
 
 class FitResults;
@@ -18,12 +20,27 @@ public:
   
   // create an index for different histograms
   //enum { kEtaPiMass = 0, kDeltaPPMass=0, kEtaCosTheta, kPhi, kt, kNumHists};
-    enum{kEtaPiMass = 0, kDeltaPPMass, kEtaCosTheta, kPhi, kt, kEtaCosTheta_vs_Mass, kNumHists};
+    enum{kEtaPiMass = 0, kDeltaPPMass, kEtaCosTheta, kPhi, kt, kNumHists};
   EtaPiDeltaPlotGenerator( const FitResults& results );
+  EtaPiDeltaPlotGenerator( );
+
+  /**
+   * The quantities of the histograms for kin, indexed like the histograms;
+   * what projectEvent fills.
+   */
+  void computeProjections( Kinematics* kin, double* values ) const;
+
+  // the name and binning of a histogram as it is booked
+  static string histogramName( int hist );
+  static void histogramBinning( int hist, int& nBins, double& low, double& high );
     
 private:
         
   void projectEvent( Kinematics* kin );
+
+  void createHistograms();
+
+  ProjectionCache m_projections;
   
 };
 
@@ -0,0 +1,187 @@
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+
+#include "AMPTOOLS_DATAIO/FitCheckpoint.h"
+
+FitCheckpoint::FitCheckpoint( AmpToolsInterface& ati, const string& file, double interval ) :
+  MIFunctionContribution( ati.minuitMinimizationManager() ),
+  m_manager( ati.minuitMinimizationManager() ),
+  m_file( file ),
+  m_interval( interval ),
+  m_valid( true ),
+  m_calls( 0 ),
+  m_fit( -1 ),
+  m_savedFit( -1 )
+{
+  m_lastWrite = chrono::steady_clock::now();
+}
+
+double
+FitCheckpoint::operator()(){
+
+  ++m_calls;
+
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  if( chrono::duration< double >( now - m_lastWrite ).count() >= m_interval ) write();
+
+  return 0;
+}
+
+bool
+FitCheckpoint::resume(){
+
+  ifstream in( m_file.c_str() );
+  if( !in ) return false;
+
+  m_done.clear();
+  m_saved.clear();
+  m_savedFit = -1;
+
+  string line;
+  while( getline( in, line ) ){
+
+    istringstream fields( line );
+    string key;
+    if( !( fields >> key ) || key[0] == '#' ) continue;
+
+    if( key == "calls" ) fields >> m_calls;
+    else if( key == "fit" ) fields >> m_savedFit;
+    else if( key == "done" ){
+
+      int fit, failed;
+      double likelihood;
+      if( fields >> fit >> failed >> likelihood )
+        m_done[fit] = make_pair( failed != 0, likelihood );
+    }
+    else if( key == "par" ){
+
+      string name;
+      double value;
+      if( fields >> name >> value ) m_saved[name] = value;
+    }
+  }
+
+  // the parameters of a fit that is done are in its results
+  if( finished( m_savedFit ) ) m_saved.clear();
+
+  cout << "FitCheckpoint:  resuming from " << m_file << " after " << m_calls
+       << " function calls, " << m_done.size() << " fits done";
+  if( !m_saved.empty() ) cout << ", fit " << m_savedFit << " in progress";
+  cout << endl;
+
+  return true;
+}
+
+void
+FitCheckpoint::startFit( int fit ){
+
+  m_fit = fit;
+}
+
+bool
+FitCheckpoint::restore( int fit ){
+
+  if( fit != m_savedFit || m_saved.empty() ) return false;
+
+  MinuitParameterManager& pars = m_manager->parameterManager();
+  int nSet = 0;
+  for( unsigned int i = 0; i < pars.size(); ++i ){
+
+    if( !pars[i]->floating() ) continue;
+
+    map< string, double >::const_iterator saved = m_saved.find( pars[i]->name() );
+    if( saved == m_saved.end() ) continue;
+
+    pars[i]->setValue( saved->second );
+    ++nSet;
+  }
+
+  cout << "FitCheckpoint:  fit " << fit << " starts from the " << nSet
+       << " parameters of the checkpoint" << endl;
+
+  // only the first fit of this index continues from the checkpoint
+  m_saved.clear();
+  return true;
+}
+
+void
+FitCheckpoint::finishFit( int fit, bool failed, double likelihood ){
+
+  m_done[fit] = make_pair( failed, likelihood );
+  write();
+}
+
+int
+FitCheckpoint::bestFit() const {
+
+  int best = -1;
+  for( map< int, pair< bool, double > >::const_iterator it = m_done.begin();
+       it != m_done.end(); ++it ){
+
+    if( it->second.first ) continue;
+    if( best < 0 || it->second.second < m_done.find( best )->second.second ) best = it->first;
+  }
+  return best;
+}
+
+double
+FitCheckpoint::bestLikelihood() const {
+
+  int best = bestFit();
+  return best < 0 ? 0 : m_done.find( best )->second.second;
+}
+
+void
+FitCheckpoint::write(){
+
+  m_lastWrite = chrono::steady_clock::now();
+
+  string tmpFile = m_file + ".tmp";
+  ofstream out( tmpFile.c_str() );
+  out.precision( 17 );
+
+  out << "# calls, the fit running and its parameters, the fits done" << endl
+      << "calls " << m_calls << endl
+      << "minimum " << m_manager->bestMinimum() << endl
+      << "edm " << m_manager->estDistToMinimum() << endl
+      << "fit " << m_fit << endl;
+
+  for( map< int, pair< bool, double > >::const_iterator it = m_done.begin();
+       it != m_done.end(); ++it )
+    out << "done " << it->first << " " << it->second.first << " " << it->second.second << endl;
+
+  int best = bestFit();
+  if( best >= 0 ) out << "best " << best << " " << bestLikelihood() << endl;
+
+  MinuitParameterManager& pars = m_manager->parameterManager();
+  for( unsigned int i = 0; i < pars.size(); ++i )
+    out << "par " << pars[i]->name() << " " << pars[i]->value() << " " << pars[i]->error() << endl;
+
+  // the estimate of MIGRAD so far, in the order of the floating parameters
+  vector< vector< double > > cov = pars.covarianceMatrix();
+  for( unsigned int i = 0; i < cov.size(); ++i ){
+
+    out << "cov";
+    for( unsigned int j = 0; j < cov[i].size(); ++j ) out << " " << cov[i][j];
+    out << endl;
+  }
+  out.close();
+
+  if( !out || rename( tmpFile.c_str(), m_file.c_str() ) != 0 ){
+
+    if( m_valid ) cout << "FitCheckpoint ERROR:  cannot write " << m_file << endl;
+    m_valid = false;
+    return;
+  }
+  m_valid = true;
+}
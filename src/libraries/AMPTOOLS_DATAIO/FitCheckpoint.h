@@ -0,0 +1,104 @@
+#if !defined(FITCHECKPOINT)
+#define FITCHECKPOINT
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MinuitInterface/MIFunctionContribution.h"
+
+using namespace std;
+
+class MinuitMinimizationManager;
+class AmpToolsInterface;
+
+/**
+ * A checkpoint of a fit, written now and then while Minuit minimizes, so
+ * that a job that is preempted or runs out of wall time can continue where
+ * it stopped.  Like FitTelemetry it is attached to the
+ * MinuitMinimizationManager as a function contribution that adds zero.
+ *
+ * The file holds the function calls so far, the best minimum and the EDM,
+ * the fit that is running (the index of a random restart, or -1 for a
+ * single fit), the values and errors of all Minuit parameters and the
+ * covariance matrix of the floating ones, and the outcome of every fit
+ * that is done together with the best so far.  It is written at most once
+ * per interval and after every fit, to a temporary file that replaces the
+ * checkpoint in one step, so a job killed while writing leaves the last
+ * complete one.
+ *
+ * Usage:  call resume before the first fit to read the checkpoint of an
+ * earlier job, skip the fits that are finished, call restore( fit ) after
+ * the starting point of a fit is set and before MIGRAD, and record every
+ * fit with startFit and finishFit.
+ *
+ * MIGRAD cannot be given its state back through the interface, so a
+ * resumed fit starts MIGRAD again from the parameters of the checkpoint:
+ * the hours of minimization are kept, the iterations of MIGRAD to rebuild
+ * its estimate of the covariance are not.
+ */
+
+class FitCheckpoint : public MIFunctionContribution
+{
+
+public:
+
+  FitCheckpoint( AmpToolsInterface& ati, const string& file, double interval = 60 );
+
+  // writes the checkpoint if the interval has passed and contributes
+  // nothing to the function
+  double operator()();
+
+  /**
+   * Reads the checkpoint of an earlier job, if there is one; returns
+   * false if there is none.  The fits that are done and the best so far
+   * are kept, and the parameters are kept for restore.
+   */
+  bool resume();
+
+  // the fit that runs from now on
+  void startFit( int fit );
+
+  /**
+   * Sets the parameters saved in the middle of fit, if the checkpoint
+   * that was resumed has any, and returns true if it had.
+   */
+  bool restore( int fit );
+
+  // records the outcome of fit and writes the checkpoint
+  void finishFit( int fit, bool failed, double likelihood );
+
+  bool finished( int fit ) const { return m_done.find( fit ) != m_done.end(); }
+
+  // the fits that are done:  whether each failed and its likelihood
+  const map< int, pair< bool, double > >& finishedFits() const { return m_done; }
+
+  // the converged fit with the smallest likelihood, -1 if there is none
+  int bestFit() const;
+  double bestLikelihood() const;
+
+  void write();
+
+  bool valid() const { return m_valid; }
+
+private:
+
+  MinuitMinimizationManager* m_manager;
+  string m_file;
+  double m_interval;
+  bool m_valid;
+
+  long long m_calls;
+  int m_fit;
+  map< int, pair< bool, double > > m_done;
+
+  // the parameters of the resumed checkpoint for fit m_savedFit
+  int m_savedFit;
+  map< string, double > m_saved;
+
+  chrono::steady_clock::time_point m_lastWrite;
+};
+
+#endif
@@ -0,0 +1,402 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TDirectory.h"
+#include "TH1D.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/FitProjections.h"
+#include "AMPTOOLS_DATAIO/TwoPiPlotGenerator.h"
+#include "AMPTOOLS_DATAIO/VecPsPlotGenerator.h"
+#include "AMPTOOLS_DATAIO/ThreePiPlotGeneratorSchilling.h"
+#include "AMPTOOLS_DATAIO/EtaPiDeltaPlotGenerator.h"
+
+// the projections and the histograms of a plot generator
+class FitProjections::Projector
+{
+
+public:
+
+  virtual ~Projector(){}
+
+  virtual int numHistograms() const = 0;
+  virtual string histogramName( int hist ) const = 0;
+  virtual void histogramBinning( int hist, int& nBins, double& low, double& high ) const = 0;
+  virtual void computeProjections( Kinematics* kin, double* values ) const = 0;
+};
+
+namespace {
+
+  template< class G >
+  class GeneratorProjector : public FitProjections::Projector
+  {
+
+  public:
+
+    int numHistograms() const { return G::kNumHists; }
+
+    string histogramName( int hist ) const { return G::histogramName( hist ); }
+
+    void histogramBinning( int hist, int& nBins, double& low, double& high ) const {
+
+      G::histogramBinning( hist, nBins, low, high );
+    }
+
+    void computeProjections( Kinematics* kin, double* values ) const {
+
+      m_generator.computeProjections( kin, values );
+    }
+
+  private:
+
+    G m_generator;
+  };
+
+  // the generators that give their projections, by the name of the class
+  FitProjections::Projector* makeProjector( const string& generator ){
+
+    if( generator == "TwoPiPlotGenerator" ) return new GeneratorProjector< TwoPiPlotGenerator >();
+    if( generator == "VecPsPlotGenerator" ) return new GeneratorProjector< VecPsPlotGenerator >();
+    if( generator == "ThreePiPlotGeneratorSchilling" ) return new GeneratorProjector< ThreePiPlotGeneratorSchilling >();
+    if( generator == "EtaPiDeltaPlotGenerator" ) return new GeneratorProjector< EtaPiDeltaPlotGenerator >();
+
+    return NULL;
+  }
+
+  const char* kTypeName[] = { "dat", "acc", "gen" };
+
+  int bin( double value, int nBins, double low, double high ){
+
+    if( !( value >= low ) ) return 0;
+    if( value >= high ) return nBins + 1;
+    return 1 + min( nBins - 1, (int)( ( value - low ) / ( high - low ) * nBins ) );
+  }
+}
+
+bool
+FitProjections::known( const string& generator ){
+
+  Projector* projector = makeProjector( generator );
+  delete projector;
+  return projector != NULL;
+}
+
+bool
+FitProjections::write( AmpToolsInterface& ati, const string& generator, const string& fileName ){
+
+  const FitResults* results = ati.fitResults();
+  if( results == NULL ){
+
+    cout << "FitProjections ERROR:  the fit has not been finalized" << endl;
+    return false;
+  }
+
+  FitProjections projections( generator, ati.configurationInfo() );
+  if( !projections.valid() ) return false;
+
+  projections.fill( ati, productionParameters( *results, ati.configurationInfo() ) );
+  return projections.write( fileName );
+}
+
+vector< complex< double > >
+FitProjections::productionParameters( const FitResults& results, const ConfigurationInfo* cfgInfo ){
+
+  vector< complex< double > > prodPars;
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( reactions[i]->reactionName() );
+    for( unsigned int iamp = 0; iamp < amps.size(); ++iamp )
+      prodPars.push_back( results.scaledProductionParameter( amps[iamp]->fullName() ) );
+  }
+
+  return prodPars;
+}
+
+unsigned int
+FitProjections::numAmplitudes( const ConfigurationInfo* cfgInfo ){
+
+  unsigned int nAmps = 0;
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i )
+    nAmps += cfgInfo->amplitudeList( reactions[i]->reactionName() ).size();
+
+  return nAmps;
+}
+
+FitProjections::FitProjections( const string& generator, const ConfigurationInfo* cfgInfo ) :
+  m_cfgInfo( cfgInfo ),
+  m_projector( makeProjector( generator ) ),
+  m_generated( 0 )
+{
+  if( m_projector == NULL ){
+
+    cout << "FitProjections ERROR:  " << generator << " does not give its projections;"
+         << " use TwoPiPlotGenerator, VecPsPlotGenerator, ThreePiPlotGeneratorSchilling"
+         << " or EtaPiDeltaPlotGenerator" << endl;
+    return;
+  }
+
+  m_histOffset.push_back( 0 );
+  for( int hist = 0; hist < m_projector->numHistograms(); ++hist ){
+
+    int nBins;
+    double low, high;
+    m_projector->histogramBinning( hist, nBins, low, high );
+    m_histOffset.push_back( m_histOffset.back() + 2 * ( nBins + 2 ) );
+  }
+  size_t block = m_histOffset.back();
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( reactions[i]->reactionName() );
+
+    vector< string > sums;
+    vector< int > ampSum( amps.size() );
+    for( unsigned int iamp = 0; iamp < amps.size(); ++iamp ){
+
+      string sumName = amps[iamp]->sumName();
+      unsigned int isum = 0;
+      while( isum < sums.size() && sums[isum] != sumName ) ++isum;
+      if( isum == sums.size() ) sums.push_back( sumName );
+
+      ampSum[iamp] = isum;
+    }
+
+    m_first.push_back( m_generated );
+    m_generated += block * ( 1 + 2 * ( 1 + sums.size() ) );
+
+    m_sumNames.push_back( sums );
+    m_ampSum.push_back( ampSum );
+  }
+
+  m_sums.assign( m_generated + reactions.size(), 0. );
+}
+
+FitProjections::~FitProjections(){
+
+  delete m_projector;
+}
+
+size_t
+FitProjections::offset( int reaction, int type, int config, int hist ) const {
+
+  size_t block = m_histOffset.back();
+  size_t nConfigs = 1 + m_sumNames[reaction].size();
+
+  size_t first = m_first[reaction];
+  if( type != kData ) first += block + ( type - kAccMC ) * nConfigs * block;
+
+  return first + config * block + m_histOffset[hist];
+}
+
+void
+FitProjections::fill( AmpToolsInterface& ati, const vector< complex< double > >& prodPars,
+                      const string& onlyReaction ){
+
+  if( !valid() ) return;
+
+  int nHists = m_projector->numHistograms();
+  vector< double > values( nHists );
+
+  const complex< double >* reactionPars = prodPars.data();
+
+  vector< ReactionInfo* > reactions = m_cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    string reaction = reactions[i]->reactionName();
+    if( !onlyReaction.empty() && reaction != onlyReaction ){
+
+      reactionPars += m_ampSum[i].size();
+      continue;
+    }
+
+    // the data only need their weights, so they are read without the
+    // amplitudes
+    DataReader* reader = ati.dataReader( reaction );
+    if( reader != NULL ){
+
+      reader->resetSource();
+
+      Kinematics* kin;
+      while( ( kin = reader->getEvent() ) != NULL ){
+
+        m_projector->computeProjections( kin, &( values[0] ) );
+        double w = kin->weight();
+        delete kin;
+
+        for( int hist = 0; hist < nHists; ++hist ){
+
+          int nBins;
+          double low, high;
+          m_projector->histogramBinning( hist, nBins, low, high );
+
+          size_t index = offset( i, kData, 0, hist ) + bin( values[hist], nBins, low, high );
+          m_sums[index] += w;
+          m_sums[index + nBins + 2] += w * w;
+        }
+      }
+    }
+
+    fillMC( ati, i, kAccMC, reactionPars );
+    fillMC( ati, i, kGenMC, reactionPars );
+
+    reactionPars += m_ampSum[i].size();
+  }
+}
+
+void
+FitProjections::fillMC( AmpToolsInterface& ati, int reaction, int type,
+                        const complex< double >* prodPars ){
+
+  string reactionName = m_cfgInfo->reactionList()[reaction]->reactionName();
+
+  DataReader* reader = ( type == kAccMC ? ati.accMCReader( reactionName ) :
+                         ati.genMCReader( reactionName ) );
+
+  // e.g., the integrals are read from a normintfile
+  if( reader == NULL ) return;
+
+  reader->resetSource();
+  ati.loadEvents( reader );
+
+  // the leader of fitMPI holds no events
+  if( ati.numEvents() == 0 ){
+
+    ati.clearEvents();
+    return;
+  }
+
+  ati.processEvents( reactionName );
+
+  vector< AmplitudeInfo* > amps = m_cfgInfo->amplitudeList( reactionName );
+  int nAmps = amps.size();
+  int nSums = m_sumNames[reaction].size();
+  int nHists = m_projector->numHistograms();
+
+  vector< double > values( nHists );
+  vector< complex< double > > sumAmp( nSums );
+  vector< double > w( 1 + nSums );
+
+  for( unsigned int iEvent = 0; iEvent < ati.numEvents(); ++iEvent ){
+
+    Kinematics* kin = ati.kinematics( iEvent );
+    m_projector->computeProjections( kin, &( values[0] ) );
+    double weight = kin->weight();
+    delete kin;
+
+    if( type == kGenMC ) m_sums[m_generated + reaction] += weight;
+
+    sumAmp.assign( nSums, 0. );
+    for( int iamp = 0; iamp < nAmps; ++iamp )
+      sumAmp[m_ampSum[reaction][iamp]] += prodPars[iamp] * ati.decayAmplitude( iEvent, amps[iamp]->fullName() );
+
+    w[0] = 0;
+    for( int isum = 0; isum < nSums; ++isum ){
+
+      w[1 + isum] = weight * norm( sumAmp[isum] );
+      w[0] += w[1 + isum];
+    }
+
+    for( int hist = 0; hist < nHists; ++hist ){
+
+      int nBins;
+      double low, high;
+      m_projector->histogramBinning( hist, nBins, low, high );
+      int b = bin( values[hist], nBins, low, high );
+
+      for( int c = 0; c <= nSums; ++c ){
+
+        size_t index = offset( reaction, type, c, hist ) + b;
+        m_sums[index] += w[c];
+        m_sums[index + nBins + 2] += w[c] * w[c];
+      }
+    }
+  }
+
+  ati.clearEvents();
+}
+
+bool
+FitProjections::write( const string& fileName ) const {
+
+  if( !valid() ) return false;
+
+  TFile file( fileName.c_str(), "RECREATE" );
+  if( file.IsZombie() ){
+
+    cout << "FitProjections ERROR:  cannot write " << fileName << endl;
+    return false;
+  }
+
+  vector< ReactionInfo* > reactions = m_cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    TDirectory* dir = file.mkdir( reactions[i]->reactionName().c_str() );
+    dir->cd();
+
+    if( m_sums[m_generated + i] <= 0 )
+      cout << "FitProjections WARNING:  no generated MC for " << reactions[i]->reactionName()
+           << ", the MC histograms are not normalized" << endl;
+
+    for( int type = kData; type < kNumTypes; ++type ){
+
+      int nConfigs = ( type == kData ? 1 : 1 + m_sumNames[i].size() );
+
+      for( int c = 0; c < nConfigs; ++c ){
+        for( int hist = 0; hist < m_projector->numHistograms(); ++hist ){
+
+          TH1D* thist = histogram( i, type, c, hist );
+          thist->Write();
+          delete thist;
+        }
+      }
+    }
+  }
+
+  file.Close();
+
+  cout << "FitProjections:  wrote the histograms of the fit to " << fileName << endl;
+  return true;
+}
+
+TH1D*
+FitProjections::histogram( int reaction, int type, int config, int hist ) const {
+
+  // the MC are normalized to the generated events, as in the batch
+  // plotter; without them they are left as they are
+  double generated = m_sums[m_generated + reaction];
+  double scale = ( type == kData || generated <= 0 ? 1 : 1 / generated );
+
+  int nBins;
+  double low, high;
+  m_projector->histogramBinning( hist, nBins, low, high );
+
+  string name = m_projector->histogramName( hist ) + kTypeName[type] +
+    ( config == 0 ? "" : "_" + m_sumNames[reaction][config - 1] );
+  TH1D* thist = new TH1D( name.c_str(), name.c_str(), nBins, low, high );
+  thist->SetDirectory( NULL );
+
+  size_t first = offset( reaction, type, config, hist );
+  for( int b = 0; b < nBins + 2; ++b ){
+
+    thist->SetBinContent( b, scale * m_sums[first + b] );
+    thist->SetBinError( b, scale * sqrt( m_sums[first + nBins + 2 + b] ) );
+  }
+
+  return thist;
+}
@@ -0,0 +1,124 @@
+#if !defined(FITPROJECTIONS)
+#define FITPROJECTIONS
+
+#include <complex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+class FitResults;
+class Kinematics;
+class TH1D;
+
+/**
+ * The histograms of a plot generator filled by the fit itself, from the
+ * amplitudes it has loaded, instead of by a plotter that reads the fit
+ * results, builds its own AmpToolsInterface and loads and processes the
+ * samples again.  The generator is named as its class, and only gives the
+ * projections of the events and the binning of its histograms (see
+ * TwoPiPlotGenerator::computeProjections); the weights are those of the
+ * batch plotter:  the data by their weight, the accepted and generated MC
+ * by their weight times the intensity of the fit, or of one sum of
+ * amplitudes, divided by the weighted number of generated events.
+ *
+ * The file has a directory per reaction with, for every histogram <hist>
+ * of the generator, <hist>dat, <hist>acc and <hist>gen, and <hist>acc_<sum>
+ * and <hist>gen_<sum> for every sum, as the histograms of
+ * twopi_plotter_batch.
+ *
+ * The histograms are kept as sums over the events, so processes that
+ * each fill them from their own events can add sums() before one of them
+ * writes the file (see fitMPI).
+ */
+
+class FitProjections
+{
+
+public:
+
+  enum { kData = 0, kAccMC, kGenMC, kNumTypes };
+
+  /**
+   * Fills and writes the histograms of generator for the fit of ati,
+   * which has been finalized, to fileName.  Returns false if the
+   * generator is not known or the file cannot be written.
+   */
+  static bool write( AmpToolsInterface& ati, const string& generator, const string& fileName );
+
+  // true if generator can be used
+  static bool known( const string& generator );
+
+  /**
+   * The scaled production parameters of results for the amplitudes of
+   * every reaction of cfgInfo, one after the other in the order of the
+   * configuration.
+   */
+  static vector< complex< double > > productionParameters( const FitResults& results,
+                                                           const ConfigurationInfo* cfgInfo );
+
+  static unsigned int numAmplitudes( const ConfigurationInfo* cfgInfo );
+
+  FitProjections( const string& generator, const ConfigurationInfo* cfgInfo );
+  ~FitProjections();
+
+  bool valid() const { return m_projector != NULL; }
+
+  /**
+   * Adds the events of the readers of ati, with the production parameters
+   * of productionParameters; only those of reaction if it is given.
+   */
+  void fill( AmpToolsInterface& ati, const vector< complex< double > >& prodPars,
+             const string& reaction = "" );
+
+  // the sums of the weights in the bins, and of the generated events
+  vector< double >& sums() { return m_sums; }
+
+  bool write( const string& fileName ) const;
+
+  // the names of the sums of a reaction, by index in the configuration
+  const vector< string >& sumNames( int reaction ) const { return m_sumNames[reaction]; }
+
+  /**
+   * A new histogram of the sums of a reaction, type and configuration (0
+   * for all sums, 1 + isum for a sum; the data only have 0), normalized
+   * as in the file of write and named as its histograms.
+   */
+  TH1D* histogram( int reaction, int type, int config, int hist ) const;
+
+  class Projector;
+
+private:
+
+  // the offset of the bins of a histogram in m_sums, before the squares
+  size_t offset( int reaction, int type, int config, int hist ) const;
+
+  void fillMC( AmpToolsInterface& ati, int reaction, int type,
+               const complex< double >* prodPars );
+
+  const ConfigurationInfo* m_cfgInfo;
+  Projector* m_projector;
+
+  // by reaction:  the names of the sums, the sum of each amplitude and the
+  // first index of the reaction in m_sums
+  vector< vector< string > > m_sumNames;
+  vector< vector< int > > m_ampSum;
+  vector< size_t > m_first;
+
+  // the offset of each histogram in the block of a configuration, and the
+  // size of the block:  the bins with under- and overflow, then their
+  // squares
+  vector< size_t > m_histOffset;
+
+  // the blocks by reaction, type and configuration (0 for all sums, 1 +
+  // isum for a sum; the data only have 0), and at the end the weighted
+  // number of generated events of every reaction
+  vector< double > m_sums;
+
+  // the index of the generated events in m_sums
+  size_t m_generated;
+};
+
+#endif
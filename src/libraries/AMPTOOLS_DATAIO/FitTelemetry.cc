@@ -0,0 +1,310 @@
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/DataReader.h"
+
+#include "AMPTOOLS_DATAIO/FitTelemetry.h"
+
+static bool
+endsWith( const string& value, const string& suffix ){
+
+  return value.size() >= suffix.size() &&
+         value.compare( value.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+static string
+jsonString( const string& value ){
+
+  string out( "\"" );
+  for( unsigned int i = 0; i < value.size(); ++i ){
+
+    if( value[i] == '"' || value[i] == '\\' ) out += '\\';
+    out += value[i];
+  }
+  return out + "\"";
+}
+
+// the start of the program, as close as a library can get to it
+static const chrono::steady_clock::time_point programStart = chrono::steady_clock::now();
+
+static double
+secondsBetween( chrono::steady_clock::time_point from, chrono::steady_clock::time_point to ){
+
+  return chrono::duration< double >( to - from ).count();
+}
+
+FitTelemetry::FitTelemetry( AmpToolsInterface& ati, const string& destination ) :
+  MIFunctionContribution( ati.minuitMinimizationManager() ),
+  m_manager( ati.minuitMinimizationManager() ),
+  m_destination( destination ),
+  m_eventsPerCall( 0 ),
+  m_valid( false ),
+  m_prometheus( false ),
+  m_socket( -1 ),
+  m_endpoint( NULL ),
+  m_calls( 0 ),
+  m_callsAtWrite( 0 )
+{
+  m_start = m_lastCall = m_lastWrite = chrono::steady_clock::now();
+
+  vector< ReactionInfo* > reactions = ati.configurationInfo()->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    DataReader* reader = ati.dataReader( reactions[i]->reactionName() );
+    if( reader != NULL ) m_eventsPerCall += reader->numEvents();
+  }
+
+  if( destination.compare( 0, 6, "udp://" ) == 0 ){
+
+    string address = destination.substr( 6 );
+    size_t colon = address.rfind( ':' );
+    if( colon == string::npos ){
+
+      cout << "FitTelemetry ERROR:  " << destination << " has no port" << endl;
+      return;
+    }
+
+    struct addrinfo hints;
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* result = NULL;
+    if( getaddrinfo( address.substr( 0, colon ).c_str(), address.substr( colon + 1 ).c_str(),
+                     &hints, &result ) != 0 || result == NULL ){
+
+      cout << "FitTelemetry ERROR:  cannot resolve " << destination << endl;
+      return;
+    }
+
+    m_socket = socket( result->ai_family, result->ai_socktype, result->ai_protocol );
+    if( m_socket >= 0 && connect( m_socket, result->ai_addr, result->ai_addrlen ) != 0 ){
+
+      close( m_socket );
+      m_socket = -1;
+    }
+    freeaddrinfo( result );
+
+    if( m_socket < 0 ){
+
+      cout << "FitTelemetry ERROR:  cannot open a socket to " << destination << endl;
+      return;
+    }
+  }
+  else if( destination.compare( 0, 7, "http://" ) == 0 ){
+
+    string host;
+    int port;
+    if( !parseHttpDestination( destination, host, port ) ){
+
+      cout << "FitTelemetry ERROR:  " << destination << " has no port" << endl;
+      return;
+    }
+
+    m_endpoint = new MetricsEndpoint( host, port );
+    if( !m_endpoint->valid() ) return;
+  }
+  else if( endsWith( destination, ".prom" ) ){
+
+    m_prometheus = true;
+  }
+  else{
+
+    m_out.open( destination.c_str(), ios::app );
+    if( !m_out ){
+
+      cout << "FitTelemetry ERROR:  cannot write " << destination << endl;
+      return;
+    }
+  }
+
+  m_valid = true;
+}
+
+FitTelemetry::~FitTelemetry(){
+
+  recordSummary();
+  if( m_socket >= 0 ) close( m_socket );
+  delete m_endpoint;
+}
+
+string
+FitTelemetry::workerDestination( const string& destination, const string& suffix ){
+
+  if( destination.compare( 0, 6, "udp://" ) == 0 ) return destination;
+
+  string host;
+  int port;
+  if( parseHttpDestination( destination, host, port ) ){
+
+    size_t digits = suffix.find_last_not_of( "0123456789" ) + 1;
+    return "http://" + host + ":" + to_string( port + 1 + atoi( suffix.c_str() + digits ) );
+  }
+
+  size_t dot = destination.rfind( '.' );
+  if( dot == string::npos || destination.find( '/', dot ) != string::npos )
+    return destination + "." + suffix;
+
+  return destination.substr( 0, dot ) + "." + suffix + destination.substr( dot );
+}
+
+double
+FitTelemetry::operator()(){
+
+  if( !m_valid ) return 0;
+
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  double secondsPerCall = secondsBetween( m_lastCall, now );
+  double eventsPerSecond = ( secondsPerCall > 0 ? m_eventsPerCall / secondsPerCall : 0 );
+  m_lastCall = now;
+  if( m_calls == 0 ) m_firstCall = now;
+  ++m_calls;
+
+  if( m_prometheus || m_endpoint != NULL ){
+
+    // the latest values only, so the file need not follow every call
+    if( secondsBetween( m_lastWrite, now ) >= 1 ){
+
+      writePrometheus( secondsPerCall, eventsPerSecond );
+      m_lastWrite = now;
+    }
+    return 0;
+  }
+
+  ostringstream line;
+  line.precision( 12 );
+  line << "\"type\": \"call\", \"time\": " << secondsBetween( m_start, now )
+       << ", \"call\": " << m_calls
+       << ", \"likelihood\": " << m_manager->bestMinimum()
+       << ", \"edm\": " << m_manager->estDistToMinimum()
+       << ", \"secondsPerCall\": " << secondsPerCall
+       << ", \"eventsPerSecond\": " << eventsPerSecond;
+
+  record( line.str() );
+
+  return 0;
+}
+
+void
+FitTelemetry::record( const string& json ){
+
+  if( !m_valid || m_prometheus || m_endpoint != NULL ) return;
+
+  string line = "{ ";
+  if( !m_label.empty() ) line += "\"label\": " + jsonString( m_label ) + ", ";
+  line += json + " }";
+
+  send( line );
+}
+
+void
+FitTelemetry::recordSummary(){
+
+  if( !m_valid || m_prometheus || m_endpoint != NULL ) return;
+
+  struct rusage usage;
+  getrusage( RUSAGE_SELF, &usage );
+
+  ostringstream line;
+  line.precision( 12 );
+  line << "\"type\": \"summary\", \"calls\": " << m_calls
+       << ", \"setupSeconds\": " << secondsBetween( programStart, m_start )
+       << ", \"firstCallSeconds\": "
+       << ( m_calls > 0 ? secondsBetween( programStart, m_firstCall ) : 0 )
+       << ", \"secondsPerCall\": "
+       << ( m_calls > 1 ? secondsBetween( m_firstCall, m_lastCall ) / ( m_calls - 1 ) : 0 )
+       // kB on Linux
+       << ", \"maxRSSMB\": " << usage.ru_maxrss / 1024.;
+
+  record( line.str() );
+
+  if( m_out.is_open() ) m_out.flush();
+}
+
+void
+FitTelemetry::send( const string& line ){
+
+  if( m_socket >= 0 ){
+
+    // a lost datagram is a lost record, the fit does not wait for it
+    if( ::send( m_socket, line.data(), line.size(), 0 ) < 0 ) return;
+  }
+  else{
+
+    m_out << line << '\n';
+
+    // flushed now and then, so the file can be followed while the fit runs
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if( secondsBetween( m_lastWrite, now ) >= 1 ){
+
+      m_out.flush();
+      m_lastWrite = now;
+    }
+  }
+}
+
+void
+FitTelemetry::writePrometheus( double secondsPerCall, double eventsPerSecond ){
+
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  double interval = secondsBetween( m_lastWrite, now );
+  double callsPerSecond = ( interval > 0 ? ( m_calls - m_callsAtWrite ) / interval : 0 );
+  m_callsAtWrite = m_calls;
+
+  string text = prometheusText( secondsPerCall, eventsPerSecond, callsPerSecond );
+
+  if( m_endpoint != NULL ){
+
+    m_endpoint->setFitMetrics( text );
+    return;
+  }
+
+  string tmpFile = m_destination + ".tmp";
+  ofstream out( tmpFile.c_str() );
+  out << text;
+  out.close();
+
+  // replaced in one step so the collector never reads a partial file
+  rename( tmpFile.c_str(), m_destination.c_str() );
+}
+
+string
+FitTelemetry::prometheusText( double secondsPerCall, double eventsPerSecond, double callsPerSecond ){
+
+  string labels = m_label.empty() ? "" : "{fit=" + jsonString( m_label ) + "}";
+
+  ostringstream out;
+  out.precision( 12 );
+
+  out << "# TYPE fit_function_calls_total counter" << endl
+      << "fit_function_calls_total" << labels << " " << m_calls << endl
+      << "# TYPE fit_likelihood gauge" << endl
+      << "fit_likelihood" << labels << " " << m_manager->bestMinimum() << endl
+      << "# TYPE fit_edm gauge" << endl
+      << "fit_edm" << labels << " " << m_manager->estDistToMinimum() << endl
+      << "# TYPE fit_seconds_per_call gauge" << endl
+      << "fit_seconds_per_call" << labels << " " << secondsPerCall << endl
+      << "# TYPE fit_calls_per_second gauge" << endl
+      << "fit_calls_per_second" << labels << " " << callsPerSecond << endl
+      << "# TYPE fit_events_per_second gauge" << endl
+      << "fit_events_per_second" << labels << " " << eventsPerSecond << endl
+      << "# TYPE fit_resident_bytes gauge" << endl
+      << "fit_resident_bytes" << labels << " " << MetricsEndpoint::residentBytes() << endl;
+
+  return out.str();
+}
@@ -0,0 +1,104 @@
+#if !defined(FITTELEMETRY)
+#define FITTELEMETRY
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "MinuitInterface/MIFunctionContribution.h"
+
+#include "AMPTOOLS_DATAIO/MetricsEndpoint.h"
+
+using namespace std;
+
+class MinuitMinimizationManager;
+class AmpToolsInterface;
+
+/**
+ * A record of the progress of a fit for every evaluation of the function
+ * that Minuit minimizes:  the call count, the best likelihood and the EDM
+ * so far, the wall time since the last call and the data events processed
+ * per second.  It is attached to the MinuitMinimizationManager as a
+ * function contribution that adds zero, so Minuit calls it once per
+ * evaluation next to the likelihood.
+ *
+ * The destination is a file of newline-delimited JSON records; a file
+ * ending in .prom, which holds the latest values in the Prometheus text
+ * format for the textfile collector of a node exporter and is replaced at
+ * most once a second; udp://host:port, which gets every JSON record as
+ * a datagram; or http://host:port (http://:port for all interfaces), where
+ * a MetricsEndpoint serves the same values, the calls per second and the
+ * resident memory to a Prometheus scrape, next to the metrics the ranks of
+ * an MPI fit report to it.
+ *
+ * At the end a summary record holds the seconds from the start of the
+ * program to the telemetry (the setup) and to the first call, the mean
+ * seconds per call after the first and the memory high-water mark of the
+ * process in MB.
+ */
+
+class FitTelemetry : public MIFunctionContribution
+{
+
+public:
+
+  /**
+   * Attaches to the MinuitMinimizationManager of ati.  The events per
+   * call are those of the data readers of all reactions.
+   */
+  FitTelemetry( AmpToolsInterface& ati, const string& destination );
+
+  ~FitTelemetry();
+
+  // records the call and contributes nothing to the function
+  double operator()();
+
+  /**
+   * The label of the records that follow, e.g., the random fit that is
+   * running.
+   */
+  void setLabel( const string& label ) { m_label = label; }
+
+  /**
+   * Writes a record in the JSON formats, e.g., a summary at the end;
+   * json is the list of fields without braces.
+   */
+  void record( const string& json );
+
+  bool valid() const { return m_valid; }
+
+  // the endpoint of an http:// destination, NULL for the others
+  MetricsEndpoint* endpoint() const { return m_endpoint; }
+
+  // destination with suffix before its extension, for the records of a
+  // worker process; datagrams of all workers go to the same address, an
+  // endpoint of worker or group n is served on the port + 1 + n
+  static string workerDestination( const string& destination, const string& suffix );
+
+private:
+
+  void send( const string& line );
+  void recordSummary();
+  void writePrometheus( double secondsPerCall, double eventsPerSecond );
+  string prometheusText( double secondsPerCall, double eventsPerSecond, double callsPerSecond );
+
+  MinuitMinimizationManager* m_manager;
+  string m_destination;
+  string m_label;
+  long long m_eventsPerCall;
+
+  bool m_valid;
+  bool m_prometheus;
+  int m_socket;
+  ofstream m_out;
+  MetricsEndpoint* m_endpoint;
+
+  long long m_calls;
+  long long m_callsAtWrite;
+  chrono::steady_clock::time_point m_start;
+  chrono::steady_clock::time_point m_firstCall;
+  chrono::steady_clock::time_point m_lastCall;
+  chrono::steady_clock::time_point m_lastWrite;
+};
+
+#endif
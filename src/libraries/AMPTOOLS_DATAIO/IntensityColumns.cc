@@ -0,0 +1,201 @@
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstring>
+#include <cmath>
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/IntensityColumns.h"
+
+string
+IntensityColumns::fileName( const string& fitBase, const string& reaction, const string& sample ){
+
+  return fitBase + "_" + reaction + "_" + sample + ".icol";
+}
+
+int
+IntensityColumns::write( AmpToolsInterface& ati, const string& fitBase ){
+
+  const FitResults* results = ati.fitResults();
+  if( results == NULL ){
+
+    cout << "IntensityColumns ERROR:  the fit has not been finalized" << endl;
+    return 0;
+  }
+
+  int nWritten = 0;
+
+  vector< ReactionInfo* > reactions = ati.configurationInfo()->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    string reaction = reactions[i]->reactionName();
+
+    for( int isample = 0; isample < 2; ++isample ){
+
+      DataReader* reader = ( isample == 0 ? ati.accMCReader( reaction ) : ati.genMCReader( reaction ) );
+      string sample = ( isample == 0 ? "acc" : "gen" );
+
+      // e.g., the integrals are read from a normintfile
+      if( reader == NULL ) continue;
+
+      reader->resetSource();
+      ati.loadEvents( reader );
+      ati.processEvents( reaction );
+
+      if( writeSample( ati, *results, reaction, fileName( fitBase, reaction, sample ) ) ) ++nWritten;
+
+      ati.clearEvents();
+    }
+  }
+
+  return nWritten;
+}
+
+bool
+IntensityColumns::writeSample( AmpToolsInterface& ati, const FitResults& results,
+                               const string& reaction, const string& fileName ){
+
+  vector< AmplitudeInfo* > amps = ati.configurationInfo()->amplitudeList( reaction );
+  int nAmps = amps.size();
+
+  vector< string > names;
+  names.push_back( "weight" );
+  names.push_back( "intensity" );
+
+  // the sum of each amplitude and the columns of the sums
+  vector< string > sums;
+  vector< int > ampSum( nAmps );
+  vector< complex< double > > prodPars( nAmps );
+  for( int iamp = 0; iamp < nAmps; ++iamp ){
+
+    string sumName = amps[iamp]->sumName();
+    unsigned int isum = 0;
+    while( isum < sums.size() && sums[isum] != sumName ) ++isum;
+    if( isum == sums.size() ) sums.push_back( sumName );
+
+    ampSum[iamp] = isum;
+    prodPars[iamp] = results.scaledProductionParameter( amps[iamp]->fullName() );
+  }
+  for( unsigned int isum = 0; isum < sums.size(); ++isum ) names.push_back( "sum:" + sums[isum] );
+  for( int iamp = 0; iamp < nAmps; ++iamp ) names.push_back( "amp:" + amps[iamp]->fullName() );
+
+  uint64_t nEvents = ati.numEvents();
+  int nSums = sums.size();
+  vector< float > values( names.size() * nEvents );
+
+  for( uint64_t iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+    Kinematics* kin = ati.kinematics( iEvent );
+    values[iEvent] = kin->weight();
+    delete kin;
+
+    values[nEvents + iEvent] = ati.intensity( iEvent );
+
+    vector< complex< double > > sumAmp( nSums );
+    for( int iamp = 0; iamp < nAmps; ++iamp ){
+
+      complex< double > amp = prodPars[iamp] * ati.decayAmplitude( iEvent, amps[iamp]->fullName() );
+      sumAmp[ampSum[iamp]] += amp;
+      values[( 2 + nSums + iamp ) * nEvents + iEvent] = norm( amp );
+    }
+    for( int isum = 0; isum < nSums; ++isum )
+      values[( 2 + isum ) * nEvents + iEvent] = norm( sumAmp[isum] );
+  }
+
+  string nameBlock;
+  for( unsigned int i = 0; i < names.size(); ++i ) nameBlock += names[i] + '\0';
+
+  IntensityColumnsHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, kIntensityColumnsMagic, sizeof( header.magic ) );
+  header.version = kIntensityColumnsVersion;
+  header.headerSize = sizeof( header );
+  header.numEvents = nEvents;
+  header.numColumns = names.size();
+  header.namesSize = nameBlock.size();
+
+  ofstream out( fileName.c_str(), ios::binary );
+  out.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+  out.write( nameBlock.data(), nameBlock.size() );
+  out.write( reinterpret_cast< const char* >( &( values[0] ) ), values.size() * sizeof( float ) );
+
+  if( !out ){
+
+    cout << "IntensityColumns ERROR:  cannot write " << fileName << endl;
+    return false;
+  }
+
+  cout << "IntensityColumns:  wrote the intensities of " << nEvents << " events to "
+       << fileName << endl;
+  return true;
+}
+
+IntensityColumns::IntensityColumns( const string& fileName ) :
+  m_valid( false ),
+  m_numEvents( 0 )
+{
+  ifstream in( fileName.c_str(), ios::binary );
+
+  IntensityColumnsHeader header;
+  if( !in.read( reinterpret_cast< char* >( &header ), sizeof( header ) ) ||
+      memcmp( header.magic, kIntensityColumnsMagic, sizeof( header.magic ) ) != 0 ||
+      header.version != kIntensityColumnsVersion ){
+
+    cout << "IntensityColumns ERROR:  " << fileName << " is not an intensity column file" << endl;
+    return;
+  }
+
+  in.seekg( header.headerSize );
+  string nameBlock( header.namesSize, '\0' );
+  in.read( &( nameBlock[0] ), header.namesSize );
+
+  for( size_t begin = 0; begin < nameBlock.size(); ){
+
+    size_t end = nameBlock.find( '\0', begin );
+    if( end == string::npos ) break;
+    m_names.push_back( nameBlock.substr( begin, end - begin ) );
+    begin = end + 1;
+  }
+
+  m_numEvents = header.numEvents;
+  m_values.resize( (size_t)header.numColumns * m_numEvents );
+  if( !m_values.empty() )
+    in.read( reinterpret_cast< char* >( &( m_values[0] ) ), m_values.size() * sizeof( float ) );
+
+  if( !in || m_names.size() != header.numColumns || column( "weight" ) < 0 ){
+
+    cout << "IntensityColumns ERROR:  " << fileName << " is incomplete" << endl;
+    return;
+  }
+
+  m_valid = true;
+}
+
+int
+IntensityColumns::column( const string& name ) const {
+
+  for( unsigned int i = 0; i < m_names.size(); ++i )
+    if( m_names[i] == name ) return i;
+
+  return -1;
+}
+
+bool
+IntensityColumns::aligned( const vector< double >& weights ) const {
+
+  if( weights.size() != m_numEvents ) return false;
+
+  const float* stored = values( column( "weight" ) );
+  for( unsigned int i = 0; i < m_numEvents; ++i )
+    if( fabs( stored[i] - weights[i] ) > 1e-6 * ( fabs( weights[i] ) + 1 ) ) return false;
+
+  return true;
+}
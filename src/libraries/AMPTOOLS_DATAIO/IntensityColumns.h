@@ -0,0 +1,98 @@
+#if !defined(INTENSITYCOLUMNS)
+#define INTENSITYCOLUMNS
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class FitResults;
+
+/**
+ * The intensities of a fit for every event of its accepted and generated
+ * MC, written next to the fit results so that a plotter only has to
+ * project the events and weight them, instead of loading the amplitudes
+ * and evaluating the model again.  There is one file per reaction and
+ * sample, <fit>_<reaction>_acc.icol and <fit>_<reaction>_gen.icol, where
+ * <fit> is the fit results file without ".fit".  Its rows are the events
+ * in the order the reader of the sample returns them, so a plotter that
+ * reads the same source gets the intensity of each event by its index.
+ *
+ * The columns, all float, are
+ *
+ *   weight          the weight of the event in the sample
+ *   intensity       the intensity of the fit
+ *   sum:<name>      the intensity of the amplitudes of one sum
+ *   amp:<name>      the intensity of one amplitude alone
+ *
+ * with the scaled production parameters of the fit; the intensities do
+ * not include the weight.  A file is the header below, the column names
+ * (each terminated by a zero byte), and the columns one after the other.
+ */
+
+static const char kIntensityColumnsMagic[8] = "HDAMPIC";
+static const uint32_t kIntensityColumnsVersion = 1;
+
+struct IntensityColumnsHeader {
+
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t numEvents;
+  uint32_t numColumns;
+  uint32_t namesSize;     // bytes of the column names after the header
+  uint32_t pad[8];
+};
+
+class IntensityColumns
+{
+
+public:
+
+  /**
+   * Writes the files of every reaction of ati, whose fit has been
+   * finalized, for the fit results file <fitBase>.fit.  Returns the
+   * number of files written.
+   */
+  static int write( AmpToolsInterface& ati, const string& fitBase );
+
+  static string fileName( const string& fitBase, const string& reaction, const string& sample );
+
+  /**
+   * Reads a file; check valid() before using it.
+   */
+  IntensityColumns( const string& fileName );
+
+  bool valid() const { return m_valid; }
+
+  unsigned int numEvents() const { return m_numEvents; }
+  const vector< string >& columnNames() const { return m_names; }
+
+  // the index of a column, or -1 if the file does not have it
+  int column( const string& name ) const;
+
+  const float* values( int column ) const { return &( m_values[(size_t)column * m_numEvents] ); }
+
+  /**
+   * True if the weight column agrees with these weights of the events of
+   * the sample that the file is used with, i.e., the rows are the same
+   * events.
+   */
+  bool aligned( const vector< double >& weights ) const;
+
+private:
+
+  // the columns of the events that ati has loaded and processed
+  static bool writeSample( AmpToolsInterface& ati, const FitResults& results,
+                           const string& reaction, const string& fileName );
+
+  bool m_valid;
+  unsigned int m_numEvents;
+  vector< string > m_names;
+  vector< float > m_values;
+};
+
+#endif
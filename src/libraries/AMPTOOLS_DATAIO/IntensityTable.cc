@@ -0,0 +1,261 @@
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/NormIntInterface.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+
+#include "AMPTOOLS_DATAIO/IntensityTable.h"
+
+IntensityTable::IntensityTable( const FitResults& results, bool accCorrected ){
+
+  vector< string > parNames = results.parNameList();
+
+  vector< string > reactions = results.reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i )
+    addReaction( results, reactions[i], parNames, accCorrected );
+}
+
+void
+IntensityTable::addReaction( const FitResults& results, const string& reaction,
+                             const vector< string >& parNames, bool accCorrected ){
+
+  vector< AmplitudeInfo* > ampInfo = results.configInfo()->amplitudeList( reaction );
+  int nAmps = ampInfo.size();
+  if( nAmps == 0 ) return;
+
+  const NormIntInterface* normInt = results.normInt( reaction );
+
+  // the amplitudes, their sums and the columns of their production
+  // parameters in the error matrix
+  vector< string > amps( nAmps );
+  vector< string > sums;
+  vector< int > ampSum( nAmps );
+  vector< complex< double > > V( nAmps );
+  vector< double > scale( nAmps );
+  vector< int > reColumn( nAmps ), imColumn( nAmps );
+
+  map< string, int > parIndex;
+  for( unsigned int i = 0; i < parNames.size(); ++i ) parIndex[parNames[i]] = i;
+
+  // the parameters of the reaction:  the columns of J
+  vector< int > parameters;
+  map< int, int > column;
+
+  for( int a = 0; a < nAmps; ++a ){
+
+    amps[a] = ampInfo[a]->fullName();
+
+    string sumName = ampInfo[a]->sumName();
+    unsigned int s = find( sums.begin(), sums.end(), sumName ) - sums.begin();
+    if( s == sums.size() ) sums.push_back( sumName );
+    ampSum[a] = s;
+
+    V[a] = results.scaledProductionParameter( amps[a] );
+    scale[a] = results.ampScale( amps[a] );
+
+    string parName[2] = { results.realProdParName( amps[a] ), results.imagProdParName( amps[a] ) };
+    int* ampColumn[2] = { &( reColumn[a] ), &( imColumn[a] ) };
+    for( int k = 0; k < 2; ++k ){
+
+      *ampColumn[k] = -1;
+
+      map< string, int >::const_iterator par = parIndex.find( parName[k] );
+      if( par == parIndex.end() ) continue;
+
+      if( column.find( par->second ) == column.end() ){
+
+        column[par->second] = parameters.size();
+        parameters.push_back( par->second );
+      }
+      *ampColumn[k] = column[par->second];
+    }
+  }
+
+  // N_ab of the amplitudes of the same sum; the others do not interfere
+  vector< complex< double > > N( nAmps * nAmps );
+  for( int a = 0; a < nAmps; ++a ){
+    for( int b = 0; b < nAmps; ++b ){
+
+      if( ampSum[a] != ampSum[b] ) continue;
+      N[a * nAmps + b] = ( accCorrected ? normInt->ampInt( amps[a], amps[b] ) :
+                                          normInt->normInt( amps[a], amps[b] ) );
+    }
+  }
+
+  // the rows of the reaction, the reaction first:  their intensities and
+  // their derivatives with respect to the parameters
+  int nPar = parameters.size();
+  vector< Row > rows;
+  vector< double > jacobian;
+
+  vector< int > all( nAmps );
+  for( int a = 0; a < nAmps; ++a ) all[a] = a;
+
+  // the reaction is the sum of its sums, N vanishes between them
+  addRow( kReaction, reaction, all, V, N, scale, reColumn, imColumn, nPar, rows, jacobian );
+
+  for( unsigned int s = 0; s < sums.size(); ++s ){
+
+    vector< int > members;
+    for( int a = 0; a < nAmps; ++a ) if( ampSum[a] == (int)s ) members.push_back( a );
+    addRow( kSum, reaction + "::" + sums[s], members,
+            V, N, scale, reColumn, imColumn, nPar, rows, jacobian );
+  }
+
+  for( int a = 0; a < nAmps; ++a )
+    addRow( kAmplitude, amps[a], vector< int >( 1, a ),
+            V, N, scale, reColumn, imColumn, nPar, rows, jacobian );
+
+  // I_ab = I( a, b ) - I_a - I_b, with the rows of I_a and I_b above
+  size_t firstAmp = 1 + sums.size();
+  for( int a = 0; a < nAmps; ++a ){
+    for( int b = a + 1; b < nAmps; ++b ){
+
+      if( ampSum[a] != ampSum[b] ) continue;
+
+      vector< int > members( 1, a );
+      members.push_back( b );
+      addRow( kInterference, amps[a] + " x " + amps[b], members,
+              V, N, scale, reColumn, imColumn, nPar, rows, jacobian );
+
+      Row& row = rows.back();
+      double* J = jacobian.data() + ( rows.size() - 1 ) * nPar;
+      row.intensity -= rows[firstAmp + a].intensity + rows[firstAmp + b].intensity;
+      for( int p = 0; p < nPar; ++p )
+        J[p] -= jacobian[( firstAmp + a ) * nPar + p] + jacobian[( firstAmp + b ) * nPar + p];
+    }
+  }
+
+  // the block of the error matrix of the parameters
+  vector< vector< double > > errorMatrix = results.errorMatrix();
+  vector< double > cov( nPar * nPar );
+  for( int p = 0; p < nPar; ++p )
+    for( int q = 0; q < nPar; ++q )
+      cov[p * nPar + q] = errorMatrix[parameters[p]][parameters[q]];
+
+  // the errors from the rows of J V, against their own row of J and the
+  // row of the reaction
+  const double* Jr = jacobian.data();
+  double total = rows[0].intensity;
+
+  double varTotal = 0;
+  for( int p = 0; p < nPar; ++p )
+    for( int q = 0; q < nPar; ++q ) varTotal += Jr[p] * cov[p * nPar + q] * Jr[q];
+
+  int nRows = rows.size();
+  AmplitudeThreads::run( nRows, [&]( int begin, int end ){
+
+    vector< double > jv( nPar );
+    for( int k = begin; k < end; ++k ){
+
+      const double* J = jacobian.data() + k * nPar;
+
+      fill( jv.begin(), jv.end(), 0. );
+      for( int p = 0; p < nPar; ++p ){
+
+        if( J[p] == 0 ) continue;
+        const double* covRow = &( cov[p * nPar] );
+        for( int q = 0; q < nPar; ++q ) jv[q] += J[p] * covRow[q];
+      }
+
+      double var = 0, covTotal = 0;
+      for( int q = 0; q < nPar; ++q ){
+
+        var += jv[q] * J[q];
+        covTotal += jv[q] * Jr[q];
+      }
+
+      Row& row = rows[k];
+      row.error = sqrt( max( var, 0. ) );
+
+      if( total != 0 ){
+
+        double F = row.intensity / total;
+        double varF = ( var - 2 * F * covTotal + F * F * varTotal ) / ( total * total );
+        row.fraction = F;
+        row.fractionError = sqrt( max( varF, 0. ) );
+      }
+    }
+  } );
+
+  m_rows.insert( m_rows.end(), rows.begin(), rows.end() );
+}
+
+// appends a row with I = sum_ab in members V_a V_b* N_ab and its
+// derivatives dI/dRe V_a = 2 Re z_a and dI/dIm V_a = -2 Im z_a, where
+// z_a = sum_b N_ab V_b*, times the scale of the amplitude
+void
+IntensityTable::addRow( Type type, const string& name, const vector< int >& members,
+                        const vector< complex< double > >& V, const vector< complex< double > >& N,
+                        const vector< double >& scale, const vector< int >& reColumn,
+                        const vector< int >& imColumn, int nPar,
+                        vector< Row >& rows, vector< double >& jacobian ){
+
+  int nAmps = V.size();
+
+  Row row = { type, name, 0, 0, 0, 0 };
+  size_t offset = jacobian.size();
+  jacobian.resize( offset + nPar, 0. );
+
+  for( unsigned int i = 0; i < members.size(); ++i ){
+
+    int a = members[i];
+    complex< double > z = 0;
+    for( unsigned int j = 0; j < members.size(); ++j )
+      z += N[a * nAmps + members[j]] * conj( V[members[j]] );
+
+    row.intensity += real( V[a] * z );
+    if( reColumn[a] >= 0 ) jacobian[offset + reColumn[a]] += 2 * scale[a] * real( z );
+    if( imColumn[a] >= 0 ) jacobian[offset + imColumn[a]] -= 2 * scale[a] * imag( z );
+  }
+  rows.push_back( row );
+}
+
+const char*
+IntensityTable::typeName( Type type ){
+
+  switch( type ){
+
+    case kReaction:     return "reaction";
+    case kSum:          return "sum";
+    case kAmplitude:    return "amp";
+    case kInterference: return "interference";
+  }
+  return "";
+}
+
+bool
+IntensityTable::write( const string& fileName ) const {
+
+  ofstream out( fileName.c_str() );
+
+  out << "# type\tname\tintensity\terror\tfraction\tfraction_error" << endl;
+  out << setprecision( 10 );
+  for( unsigned int i = 0; i < m_rows.size(); ++i ){
+
+    const Row& row = m_rows[i];
+    out << typeName( row.type ) << "\t" << row.name << "\t"
+        << row.intensity << "\t" << row.error << "\t"
+        << row.fraction << "\t" << row.fractionError << endl;
+  }
+
+  if( !out ){
+
+    cout << "IntensityTable ERROR:  cannot write " << fileName << endl;
+    return false;
+  }
+
+  cout << "IntensityTable:  wrote " << m_rows.size() << " intensities to " << fileName << endl;
+  return true;
+}
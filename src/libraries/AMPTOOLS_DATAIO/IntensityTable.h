@@ -0,0 +1,82 @@
+#if !defined(INTENSITYTABLE)
+#define INTENSITYTABLE
+
+#include <string>
+#include <vector>
+#include <complex>
+
+using namespace std;
+
+class FitResults;
+
+/**
+ * The intensities of a fit for every amplitude, every pair of amplitudes
+ * of a coherent sum (their interference term), every sum and every
+ * reaction, with their fractions of the reaction and the errors of both.
+ * FitResults::intensity computes one combination per call, each with its
+ * own loop over the normalization integrals and its own product with the
+ * error matrix; the table computes all of them in one pass:
+ *
+ *   I_a   = |V_a|^2 N_aa
+ *   I_ab  = 2 Re( V_a V_b* N_ab )        a < b in the same sum
+ *   I_s   = sum_ab in s  V_a V_b* N_ab
+ *
+ * with V the scaled production parameters and N the integrals over the
+ * generated (acceptance corrected) or accepted MC.  The variances are the
+ * diagonal of J V J^T, with J the derivatives with respect to the
+ * production parameters and V their block of the error matrix; a
+ * fraction F = I / I_r has the variance
+ *
+ *   ( var I - 2 F cov( I, I_r ) + F^2 var I_r ) / I_r^2
+ *
+ * from the same row of J V.  The rows are shared over the threads of
+ * AmplitudeThreads.  The errors of scale parameters of the amplitudes
+ * are not included, as in FitResults::intensity.
+ *
+ * Usage after a fit:
+ *
+ *   IntensityTable table( *ati.fitResults() );
+ *   table.write( "myfit.intensities" );
+ */
+
+class IntensityTable
+{
+
+public:
+
+  enum Type { kReaction, kSum, kAmplitude, kInterference };
+
+  struct Row {
+
+    Type type;
+    string name;
+    double intensity;
+    double error;
+    double fraction;
+    double fractionError;
+  };
+
+  IntensityTable( const FitResults& results, bool accCorrected = true );
+
+  const vector< Row >& rows() const { return m_rows; }
+
+  // a line per row:  type, name, intensity, error, fraction, fraction error
+  bool write( const string& fileName ) const;
+
+  static const char* typeName( Type type );
+
+private:
+
+  void addReaction( const FitResults& results, const string& reaction,
+                    const vector< string >& parNames, bool accCorrected );
+
+  static void addRow( Type type, const string& name, const vector< int >& members,
+                      const vector< complex< double > >& V, const vector< complex< double > >& N,
+                      const vector< double >& scale, const vector< int >& reColumn,
+                      const vector< int >& imColumn, int nPar,
+                      vector< Row >& rows, vector< double >& jacobian );
+
+  vector< Row > m_rows;
+};
+
+#endif
@@ -0,0 +1,80 @@
+
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+
+// the delete of the framework only reaches the operator delete of
+// PooledKinematics through a virtual destructor
+static_assert( has_virtual_destructor< Kinematics >::value,
+               "PooledKinematics needs the virtual destructor of Kinematics" );
+
+namespace {
+
+  // set when the free list of the thread is gone, for events that are
+  // deleted while the thread ends
+  thread_local bool listDestroyed = false;
+
+  // the blocks of deleted events of a thread, freed when the thread ends
+  struct FreeList {
+
+    enum { kMaxBlocks = 4096 };
+
+    ~FreeList(){
+      for( unsigned int i = 0; i < blocks.size(); ++i ) ::operator delete( blocks[i] );
+      listDestroyed = true;
+    }
+
+    vector< void* > blocks;
+  };
+
+  FreeList* freeList(){
+
+    if( listDestroyed ) return NULL;
+
+    static thread_local FreeList list;
+    return &list;
+  }
+}
+
+void*
+PooledKinematics::operator new( size_t size ){
+
+  FreeList* list = freeList();
+  if( size != sizeof( PooledKinematics ) || list == NULL || list->blocks.empty() )
+    return ::operator new( size );
+
+  void* p = list->blocks.back();
+  list->blocks.pop_back();
+  return p;
+}
+
+void
+PooledKinematics::operator delete( void* p, size_t size ){
+
+  if( p == NULL ) return;
+
+  FreeList* list = freeList();
+  if( size != sizeof( PooledKinematics ) || list == NULL ||
+      list->blocks.size() >= FreeList::kMaxBlocks ){
+
+    ::operator delete( p );
+    return;
+  }
+
+  list->blocks.push_back( p );
+}
+
+void
+fillParticleList( vector< TLorentzVector >& particles, int nPart,
+                  const float* e, const float* px, const float* py, const float* pz,
+                  float eBeam, float pxBeam, float pyBeam, float pzBeam ){
+
+  assert( nPart < Kinematics::kMaxParticles );
+
+  particles.resize( nPart + 1 );
+  particles[0].SetPxPyPzE( pxBeam, pyBeam, pzBeam, eBeam );
+  for( int i = 0; i < nPart; ++i ) particles[i + 1].SetPxPyPzE( px[i], py[i], pz[i], e[i] );
+}
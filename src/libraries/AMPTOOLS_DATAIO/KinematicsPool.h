@@ -0,0 +1,48 @@
+#if !defined(KINEMATICSPOOL)
+#define KINEMATICSPOOL
+
+#include <cstddef>
+#include <vector>
+
+#include "IUAmpTools/Kinematics.h"
+
+#include "TLorentzVector.h"
+
+using namespace std;
+
+/**
+ * The Kinematics that the data readers return from getEvent.  The
+ * framework deletes every event right after it has copied it, so the
+ * memory of an event is taken from and returned to a free list of the
+ * thread instead of the heap:  the delete of the framework goes through
+ * the virtual destructor of Kinematics to the operator delete here.  A
+ * reader returns
+ *
+ *   return new PooledKinematics( m_particleList, weight );
+ *
+ * with a particle list that it keeps between events (see
+ * fillParticleList), so the only allocation left per event is the copy
+ * of the list inside Kinematics.
+ */
+
+class PooledKinematics : public Kinematics
+{
+
+public:
+
+  PooledKinematics( const vector< TLorentzVector >& particleList, float weight = 1.0 ) :
+    Kinematics( particleList, weight ) {}
+
+  static void* operator new( size_t size );
+  static void operator delete( void* p, size_t size );
+};
+
+/**
+ * Sets particles to the beam followed by the nPart final state particles
+ * of arrays in the layout of the tree branches, keeping its capacity.
+ */
+void fillParticleList( vector< TLorentzVector >& particles, int nPart,
+                       const float* e, const float* px, const float* py, const float* pz,
+                       float eBeam, float pxBeam, float pyBeam, float pzBeam );
+
+#endif
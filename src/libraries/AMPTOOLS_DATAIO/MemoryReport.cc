@@ -0,0 +1,263 @@
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "IUAmpTools/Amplitude.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/DataReader.h"
+#include "GPUManager/GPUCustomTypes.h"
+
+#include "AMPTOOLS_DATAIO/MemoryReport.h"
+
+static const double kMB = 1024. * 1024.;
+
+// the permutations of an amplitude, the identity included once
+static unsigned int
+numPermutations( AmplitudeInfo* amp, unsigned int numParticles ){
+
+  vector< vector< int > > permutations = amp->permutations();
+
+  unsigned int n = 1;
+  for( unsigned int i = 0; i < permutations.size(); ++i ){
+
+    bool identity = ( permutations[i].size() == numParticles );
+    for( unsigned int j = 0; identity && j < permutations[i].size(); ++j )
+      identity = ( permutations[i][j] == (int)j );
+    if( !identity ) ++n;
+  }
+
+  return n;
+}
+
+map< string, Amplitude* >&
+MemoryReport::prototypes(){
+
+  static map< string, Amplitude* > registered;
+  return registered;
+}
+
+void
+MemoryReport::registerAmplitude( const Amplitude& prototype ){
+
+  Amplitude*& entry = prototypes()[prototype.name()];
+  if( entry == NULL ) entry = prototype.clone();
+}
+
+MemoryReport::MemoryReport( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) :
+  m_totalBytes( 0 ),
+  m_totalGPUBytes( 0 )
+{
+  const double value = sizeof( GDouble );
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int r = 0; r < reactions.size(); ++r ){
+
+    ReactionInfo* reaction = reactions[r];
+    string reactionName = reaction->reactionName();
+    unsigned int numParticles = reaction->particleList().size();
+
+    vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( reactionName );
+
+    // the instances of this reaction, index into m_instances
+    map< string, unsigned int > instanceIndex;
+    double factorValues = 0, userVarValues = 0;
+    bool allUserVarsOnly = !amps.empty();
+
+    for( unsigned int a = 0; a < amps.size(); ++a ){
+
+      unsigned int nPerm = numPermutations( amps[a], numParticles );
+      vector< vector< string > > factors = amps[a]->factors();
+
+      for( unsigned int f = 0; f < factors.size(); ++f ){
+
+        if( factors[f].empty() ) continue;
+
+        string arguments;
+        for( unsigned int i = 1; i < factors[f].size(); ++i )
+          arguments += ( i > 1 ? " " : "" ) + factors[f][i];
+
+        string key = reactionName + "\n" + factors[f][0] + "\n" + arguments;
+
+        map< string, unsigned int >::iterator found = instanceIndex.find( key );
+        if( found == instanceIndex.end() ){
+
+          Instance instance;
+          instance.className = factors[f][0];
+          instance.arguments = arguments;
+          instance.numUserVars = 0;
+          instance.isStatic = false;
+          instance.userVarsOnly = false;
+          instance.numCopies = 0;
+          instance.numPermutations = 0;
+          instance.userVarBytes = 0;
+
+          map< string, Amplitude* >::const_iterator proto = prototypes().find( factors[f][0] );
+          if( proto != prototypes().end() ){
+
+            Amplitude* amp = proto->second->newAmplitude(
+              vector< string >( factors[f].begin() + 1, factors[f].end() ) );
+            instance.numUserVars = amp->numUserVars();
+            instance.isStatic = amp->areUserVarsStatic();
+            instance.userVarsOnly = amp->needsUserVarsOnly();
+            delete amp;
+          }
+          else{
+
+            cout << "MemoryReport WARNING:  " << factors[f][0]
+                 << " is not registered, its user variables are not counted" << endl;
+          }
+
+          found = instanceIndex.insert( make_pair( key, (unsigned int)m_instances.size() ) ).first;
+          m_instances.push_back( instance );
+        }
+
+        Instance& instance = m_instances[found->second];
+
+        // static user variables are kept once per instance and
+        // permutation, the others for every factor
+        if( instance.isStatic ){
+
+          if( nPerm > instance.numPermutations ){
+
+            userVarValues += double( instance.numUserVars ) * ( nPerm - instance.numPermutations );
+            instance.numPermutations = nPerm;
+          }
+        }
+        else{
+
+          userVarValues += double( instance.numUserVars ) * nPerm;
+          if( nPerm > instance.numPermutations ) instance.numPermutations = nPerm;
+        }
+
+        instance.numCopies += nPerm;
+        factorValues += 2 * nPerm;
+        allUserVarsOnly = allUserVarsOnly && instance.userVarsOnly;
+      }
+    }
+
+    // the sources of the reaction; the MC only if the integrals are computed
+    vector< pair< string, DataReader* > > readers;
+    readers.push_back( make_pair( reactionName + " data", ati.dataReader( reactionName ) ) );
+    if( !reaction->normIntFileInput() ){
+
+      readers.push_back( make_pair( reactionName + " accMC", ati.accMCReader( reactionName ) ) );
+      readers.push_back( make_pair( reactionName + " genMC", ati.genMCReader( reactionName ) ) );
+    }
+
+    unsigned int firstSource = m_sources.size();
+
+    for( unsigned int s = 0; s < readers.size(); ++s ){
+
+      if( readers[s].second == NULL ) continue;
+
+      Source source;
+      source.name = readers[s].first;
+      source.numEvents = readers[s].second->numEvents();
+      source.fourVectorsReleased = allUserVarsOnly;
+      source.fourVectorBytes = 4 * numParticles * value;
+      // weight and intensity
+      source.weightBytes = 2 * value;
+      source.amplitudeBytes = ( factorValues + 2 * amps.size() ) * value;
+      source.userVarBytes = userVarValues * value;
+
+#ifdef GPU_ACCELERATION
+      source.gpuBytes = source.fourVectorBytes + source.weightBytes +
+                        source.amplitudeBytes + source.userVarBytes;
+#else
+      source.gpuBytes = 0;
+#endif
+
+      double perEvent = ( source.fourVectorsReleased ? 0 : source.fourVectorBytes ) +
+                        source.weightBytes + source.amplitudeBytes + source.userVarBytes;
+
+      m_totalBytes += perEvent * source.numEvents;
+      m_totalGPUBytes += source.gpuBytes * source.numEvents;
+      m_sources.push_back( source );
+    }
+
+    // the user variables of each instance over the sources of the reaction
+    long long reactionEvents = 0;
+    for( unsigned int s = firstSource; s < m_sources.size(); ++s )
+      reactionEvents += m_sources[s].numEvents;
+
+    for( map< string, unsigned int >::const_iterator it = instanceIndex.begin();
+         it != instanceIndex.end(); ++it ){
+
+      Instance& instance = m_instances[it->second];
+      double copies = ( instance.isStatic ? instance.numPermutations : instance.numCopies );
+      instance.userVarBytes = copies * instance.numUserVars * value * reactionEvents;
+    }
+  }
+}
+
+void
+MemoryReport::print( ostream& out ) const {
+
+  ios::fmtflags flags = out.flags();
+  streamsize precision = out.precision();
+  out << fixed << setprecision( 1 );
+
+  out << endl << "MEMORY REPORT" << endl << endl;
+  out << "   host:  " << m_totalBytes / kMB << " MB";
+#ifdef GPU_ACCELERATION
+  out << "   GPU:  " << m_totalGPUBytes / kMB << " MB";
+#endif
+  out << "   (" << sizeof( GDouble ) << " bytes per value)" << endl << endl;
+
+  out << setw( 28 ) << left << "   source" << right
+      << setw( 12 ) << "events" << setw( 10 ) << "p4 [B]" << setw( 11 ) << "amps [B]"
+      << setw( 14 ) << "userVars [B]" << setw( 12 ) << "total [B]" << setw( 12 ) << "total [MB]";
+#ifdef GPU_ACCELERATION
+  out << setw( 11 ) << "GPU [MB]";
+#endif
+  out << endl;
+
+  for( unsigned int s = 0; s < m_sources.size(); ++s ){
+
+    const Source& source = m_sources[s];
+    double p4 = ( source.fourVectorsReleased ? 0 : source.fourVectorBytes );
+    double perEvent = p4 + source.weightBytes + source.amplitudeBytes + source.userVarBytes;
+
+    out << "   " << setw( 25 ) << left << source.name << right
+        << setw( 12 ) << source.numEvents
+        << setw( 10 ) << p4 << setw( 11 ) << source.amplitudeBytes
+        << setw( 14 ) << source.userVarBytes << setw( 12 ) << perEvent
+        << setw( 12 ) << perEvent * source.numEvents / kMB;
+#ifdef GPU_ACCELERATION
+    out << setw( 11 ) << source.gpuBytes * source.numEvents / kMB;
+#endif
+    out << ( source.fourVectorsReleased ? "   (p4 released)" : "" ) << endl;
+  }
+
+  out << endl << "   user variables per amplitude instance, over the sources of its reaction" << endl << endl;
+  out << setw( 28 ) << left << "   class" << right
+      << setw( 6 ) << "vars" << setw( 8 ) << "copies" << setw( 8 ) << "static"
+      << setw( 10 ) << "varsOnly" << setw( 12 ) << "[B/event]" << setw( 12 ) << "total [MB]"
+      << "   arguments" << endl;
+
+  for( unsigned int i = 0; i < m_instances.size(); ++i ){
+
+    const Instance& instance = m_instances[i];
+    unsigned int copies = ( instance.isStatic ? instance.numPermutations : instance.numCopies );
+
+    out << "   " << setw( 25 ) << left << instance.className << right
+        << setw( 6 ) << instance.numUserVars << setw( 8 ) << copies
+        << setw( 8 ) << ( instance.isStatic ? "yes" : "no" )
+        << setw( 10 ) << ( instance.userVarsOnly ? "yes" : "no" )
+        << setw( 12 ) << double( copies ) * instance.numUserVars * sizeof( GDouble )
+        << setw( 12 ) << instance.userVarBytes / kMB
+        << "   " << instance.arguments << endl;
+  }
+
+  out << endl;
+  out << "   An instance with copies > 1 that is not static keeps its user variables" << endl;
+  out << "   for every amplitude it is a factor of; with areUserVarsStatic they are kept once." << endl;
+  out << endl;
+
+  out.flags( flags );
+  out.precision( precision );
+}
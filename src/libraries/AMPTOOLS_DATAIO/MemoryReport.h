@@ -0,0 +1,90 @@
+#if !defined(MEMORYREPORT)
+#define MEMORYREPORT
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Amplitude;
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * The memory that the framework holds for the events of a fit, per data
+ * source (data, accepted and generated MC of each reaction) and per
+ * amplitude instance (an amplitude class with a distinct list of
+ * arguments), in bytes per event and in total.
+ *
+ * The sizes follow the per-event arrays of the framework for each source:
+ * the four-vectors (4 values per particle), the weight, the intensity, the
+ * amplitude of every factor and permutation (2 values) and of every
+ * amplitude (2 values), and the user variables of every factor and
+ * permutation.  The user variables of an amplitude with areUserVarsStatic
+ * are kept once for all amplitudes of the same instance, and the
+ * four-vectors are released once the user variables are computed if every
+ * amplitude of the reaction has needsUserVarsOnly.  The MC is not counted
+ * for reactions that read their integrals from a file.  On GPU builds the
+ * four-vectors, weights, user variables and amplitudes are also on the
+ * device, which is shown separately.  Buffers of ROOT and of the data
+ * readers (e.g., bulk=1) are not counted.
+ *
+ * Usage:  register every amplitude class (next to its registration with
+ * AmpToolsInterface) so that the instances of the configuration can be
+ * made, then build the report from the AmpToolsInterface of the fit,
+ * which knows the number of events of each source.
+ */
+
+class MemoryReport
+{
+
+public:
+
+  static void registerAmplitude( const Amplitude& prototype );
+
+  MemoryReport( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+
+  void print( ostream& out = cout ) const;
+
+  // the bytes of all sources on the host and on the device
+  double totalBytes() const { return m_totalBytes; }
+  double totalGPUBytes() const { return m_totalGPUBytes; }
+
+private:
+
+  struct Instance {
+
+    string className;
+    string arguments;
+    unsigned int numUserVars;
+    bool isStatic;
+    bool userVarsOnly;
+    // the sum over the factors of this instance of their permutations
+    unsigned int numCopies;
+    unsigned int numPermutations;
+    double userVarBytes;
+  };
+
+  struct Source {
+
+    string name;
+    long long numEvents;
+    double fourVectorBytes;   // per event
+    double weightBytes;
+    double amplitudeBytes;
+    double userVarBytes;
+    double gpuBytes;          // per event
+    bool fourVectorsReleased;
+  };
+
+  static map< string, Amplitude* >& prototypes();
+
+  vector< Instance > m_instances;
+  vector< Source > m_sources;
+  double m_totalBytes;
+  double m_totalGPUBytes;
+};
+
+#endif
@@ -0,0 +1,371 @@
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include "AMPTOOLS_DATAIO/MetricsEndpoint.h"
+
+// the upper edges of the buckets of the busy fractions
+static const double kBusyBuckets[] = { 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0 };
+static const int kNumBusyBuckets = sizeof( kBusyBuckets ) / sizeof( kBusyBuckets[0] );
+
+static double
+secondsBetween( chrono::steady_clock::time_point from, chrono::steady_clock::time_point to ){
+
+  return chrono::duration< double >( to - from ).count();
+}
+
+// a socket of type bound to host:port, -1 if it cannot be
+static int
+boundSocket( const string& host, int port, int type ){
+
+  struct addrinfo hints;
+  memset( &hints, 0, sizeof( hints ) );
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = type;
+  hints.ai_flags = AI_PASSIVE;
+
+  struct addrinfo* result = NULL;
+  if( getaddrinfo( host.empty() ? NULL : host.c_str(), to_string( port ).c_str(),
+                   &hints, &result ) != 0 || result == NULL ) return -1;
+
+  int fd = socket( result->ai_family, result->ai_socktype, result->ai_protocol );
+  if( fd >= 0 ){
+
+    int on = 1;
+    setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof( on ) );
+
+    if( bind( fd, result->ai_addr, result->ai_addrlen ) != 0 ||
+        ( type == SOCK_STREAM && listen( fd, 8 ) != 0 ) ){
+
+      close( fd );
+      fd = -1;
+    }
+  }
+  freeaddrinfo( result );
+
+  return fd;
+}
+
+bool
+parseHttpDestination( const string& destination, string& host, int& port ){
+
+  if( destination.compare( 0, 7, "http://" ) != 0 ) return false;
+
+  string address = destination.substr( 7 );
+  if( !address.empty() && address[address.size() - 1] == '/' ) address.erase( address.size() - 1 );
+
+  size_t colon = address.rfind( ':' );
+  if( colon == string::npos ) return false;
+
+  host = address.substr( 0, colon );
+  port = atoi( address.c_str() + colon + 1 );
+  return port > 0;
+}
+
+MetricsEndpoint::MetricsEndpoint( const string& host, int port ) :
+  m_listener( -1 ),
+  m_datagrams( -1 ),
+  m_valid( false ),
+  m_stop( false )
+{
+  m_listener = boundSocket( host, port, SOCK_STREAM );
+  m_datagrams = boundSocket( host, port, SOCK_DGRAM );
+
+  if( m_listener < 0 || m_datagrams < 0 ){
+
+    cout << "MetricsEndpoint ERROR:  cannot listen on " << host << ":" << port << endl;
+    if( m_listener >= 0 ) close( m_listener );
+    if( m_datagrams >= 0 ) close( m_datagrams );
+    m_listener = m_datagrams = -1;
+    return;
+  }
+
+  cout << "MetricsEndpoint:  serving the metrics of the fit at http://"
+       << ( host.empty() ? "localhost" : host ) << ":" << port << "/metrics" << endl;
+
+  m_valid = true;
+  m_thread = thread( &MetricsEndpoint::serve, this );
+}
+
+MetricsEndpoint::~MetricsEndpoint(){
+
+  m_stop = true;
+  if( m_thread.joinable() ) m_thread.join();
+
+  if( m_listener >= 0 ) close( m_listener );
+  if( m_datagrams >= 0 ) close( m_datagrams );
+}
+
+void
+MetricsEndpoint::setFitMetrics( const string& text ){
+
+  lock_guard< mutex > lock( m_mutex );
+  m_fitMetrics = text;
+}
+
+double
+MetricsEndpoint::residentBytes(){
+
+  // the second field of statm is the resident size in pages
+  ifstream statm( "/proc/self/statm" );
+  double pages = 0, resident = 0;
+  if( !( statm >> pages >> resident ) ) return 0;
+
+  return resident * sysconf( _SC_PAGESIZE );
+}
+
+void
+MetricsEndpoint::serve(){
+
+  struct pollfd fds[2];
+  fds[0].fd = m_listener;
+  fds[1].fd = m_datagrams;
+
+  while( !m_stop ){
+
+    fds[0].events = fds[1].events = POLLIN;
+    fds[0].revents = fds[1].revents = 0;
+
+    // wakes up now and then to see if it should stop
+    if( poll( fds, 2, 250 ) <= 0 ) continue;
+
+    if( fds[1].revents & POLLIN ) receive();
+
+    if( fds[0].revents & POLLIN ){
+
+      int connection = accept( m_listener, NULL, NULL );
+      if( connection < 0 ) continue;
+      answer( connection );
+      close( connection );
+    }
+  }
+}
+
+void
+MetricsEndpoint::answer( int connection ){
+
+  // a scraper that does not send its request does not hold up the ranks
+  struct timeval timeout = { 2, 0 };
+  setsockopt( connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+  setsockopt( connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( timeout ) );
+
+  // only the request line matters
+  char request[1024];
+  ssize_t length = recv( connection, request, sizeof( request ) - 1, 0 );
+  if( length <= 0 ) return;
+  request[length] = 0;
+
+  string line( request, strcspn( request, "\r\n" ) );
+  bool found = ( line.compare( 0, 13, "GET /metrics " ) == 0 || line.compare( 0, 6, "GET / " ) == 0 );
+
+  string body = found ? text() : "not found\n";
+
+  ostringstream response;
+  response << "HTTP/1.0 " << ( found ? "200 OK" : "404 Not Found" ) << "\r\n"
+           << "Content-Type: text/plain; version=0.0.4\r\n"
+           << "Content-Length: " << body.size() << "\r\n"
+           << "Connection: close\r\n\r\n"
+           << body;
+
+  string out = response.str();
+  size_t sent = 0;
+  while( sent < out.size() ){
+
+    ssize_t n = ::send( connection, out.data() + sent, out.size() - sent, MSG_NOSIGNAL );
+    if( n <= 0 ) return;
+    sent += n;
+  }
+}
+
+void
+MetricsEndpoint::receive(){
+
+  char datagram[512];
+  ssize_t length = recv( m_datagrams, datagram, sizeof( datagram ) - 1, MSG_DONTWAIT );
+  if( length <= 0 ) return;
+  datagram[length] = 0;
+
+  RankMetrics metrics;
+  if( sscanf( datagram, "rank %d %lf %lf %lf %lf %lf", &metrics.rank, &metrics.wallSeconds,
+              &metrics.computeSeconds, &metrics.waitSeconds, &metrics.residentBytes,
+              &metrics.gpuBytes ) != 6 || metrics.rank < 0 ) return;
+
+  lock_guard< mutex > lock( m_mutex );
+
+  RankState& state = m_ranks[metrics.rank];
+  bool first = ( state.received == chrono::steady_clock::time_point() );
+
+  double wall = metrics.wallSeconds - ( first ? 0 : state.last.wallSeconds );
+  double compute = metrics.computeSeconds - ( first ? 0 : state.last.computeSeconds );
+
+  // a fit that starts again starts the measurement again
+  if( wall <= 0 || compute < 0 ){
+
+    wall = metrics.wallSeconds;
+    compute = metrics.computeSeconds;
+  }
+
+  state.busyFraction = ( wall > 0 ? min( 1., max( 0., compute / wall ) ) : 0 );
+  state.last = metrics;
+  state.received = chrono::steady_clock::now();
+}
+
+string
+MetricsEndpoint::text(){
+
+  lock_guard< mutex > lock( m_mutex );
+  return m_fitMetrics + rankText();
+}
+
+// has to be called with the lock held
+string
+MetricsEndpoint::rankText(){
+
+  if( m_ranks.empty() ) return "";
+
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+  ostringstream out;
+  out.precision( 12 );
+
+  const char* names[] = { "fit_rank_compute_seconds_total", "fit_rank_mpi_wait_seconds_total",
+                          "fit_rank_resident_bytes", "fit_rank_gpu_bytes",
+                          "fit_rank_seconds_since_report" };
+  const char* types[] = { "counter", "counter", "gauge", "gauge", "gauge" };
+
+  for( int k = 0; k < 5; ++k ){
+
+    out << "# TYPE " << names[k] << " " << types[k] << endl;
+    for( map< int, RankState >::const_iterator r = m_ranks.begin(); r != m_ranks.end(); ++r ){
+
+      const RankMetrics& last = r->second.last;
+      double values[] = { last.computeSeconds, last.waitSeconds, last.residentBytes,
+                          last.gpuBytes, secondsBetween( r->second.received, now ) };
+      out << names[k] << "{rank=\"" << r->first << "\"} " << values[k] << endl;
+    }
+  }
+
+  // rank 0 leads the fit, the others share the events
+  bool skipLeader = ( m_ranks.size() > 1 && m_ranks.begin()->first == 0 );
+
+  vector< long long > counts( kNumBusyBuckets, 0 );
+  double sum = 0, largest = 0;
+  long long count = 0;
+  for( map< int, RankState >::const_iterator r = m_ranks.begin(); r != m_ranks.end(); ++r ){
+
+    if( skipLeader && r->first == 0 ) continue;
+
+    double busy = r->second.busyFraction;
+    for( int b = 0; b < kNumBusyBuckets; ++b ) if( busy <= kBusyBuckets[b] ) ++counts[b];
+    sum += busy;
+    largest = max( largest, busy );
+    ++count;
+  }
+
+  out << "# TYPE fit_rank_busy_fraction histogram" << endl;
+  for( int b = 0; b < kNumBusyBuckets; ++b )
+    out << "fit_rank_busy_fraction_bucket{le=\"" << kBusyBuckets[b] << "\"} " << counts[b] << endl;
+  out << "fit_rank_busy_fraction_bucket{le=\"+Inf\"} " << count << endl
+      << "fit_rank_busy_fraction_sum " << sum << endl
+      << "fit_rank_busy_fraction_count " << count << endl;
+
+  // the slowest over the mean, as in the table of fitMPI at the end
+  out << "# TYPE fit_rank_imbalance gauge" << endl
+      << "fit_rank_imbalance " << ( sum > 0 ? largest * count / sum : 1 ) << endl
+      << "# TYPE fit_ranks_reporting gauge" << endl
+      << "fit_ranks_reporting " << m_ranks.size() << endl;
+
+  return out.str();
+}
+
+MetricsReporter::MetricsReporter( const string& host, int port, function< RankMetrics() > sample,
+                                  double interval ) :
+  m_socket( -1 ),
+  m_sample( sample ),
+  m_interval( interval ),
+  m_stop( false )
+{
+  struct addrinfo hints;
+  memset( &hints, 0, sizeof( hints ) );
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  struct addrinfo* result = NULL;
+  if( getaddrinfo( host.empty() ? "localhost" : host.c_str(), to_string( port ).c_str(),
+                   &hints, &result ) != 0 || result == NULL ){
+
+    cout << "MetricsReporter ERROR:  cannot resolve " << host << ":" << port << endl;
+    return;
+  }
+
+  m_socket = socket( result->ai_family, result->ai_socktype, result->ai_protocol );
+  if( m_socket >= 0 && connect( m_socket, result->ai_addr, result->ai_addrlen ) != 0 ){
+
+    close( m_socket );
+    m_socket = -1;
+  }
+  freeaddrinfo( result );
+
+  if( m_socket < 0 ){
+
+    cout << "MetricsReporter ERROR:  cannot open a socket to " << host << ":" << port << endl;
+    return;
+  }
+
+  m_thread = thread( &MetricsReporter::run, this );
+}
+
+MetricsReporter::~MetricsReporter(){
+
+  if( m_socket < 0 ) return;
+
+  {
+    lock_guard< mutex > lock( m_mutex );
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  m_thread.join();
+
+  send();
+  close( m_socket );
+}
+
+void
+MetricsReporter::run(){
+
+  unique_lock< mutex > lock( m_mutex );
+  while( !m_stop ){
+
+    if( m_wake.wait_for( lock, chrono::duration< double >( m_interval ),
+                         [this]{ return m_stop; } ) ) break;
+    send();
+  }
+}
+
+void
+MetricsReporter::send(){
+
+  RankMetrics metrics = m_sample();
+
+  char datagram[512];
+  int length = snprintf( datagram, sizeof( datagram ), "rank %d %.6f %.6f %.6f %.0f %.0f",
+                         metrics.rank, metrics.wallSeconds, metrics.computeSeconds,
+                         metrics.waitSeconds, metrics.residentBytes, metrics.gpuBytes );
+
+  // a lost datagram is a late value, the fit does not wait for it
+  if( length > 0 ) ::send( m_socket, datagram, length, 0 );
+}
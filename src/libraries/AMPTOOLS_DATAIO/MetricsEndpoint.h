@@ -0,0 +1,139 @@
+#if !defined(METRICSENDPOINT)
+#define METRICSENDPOINT
+
+#include <string>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+using namespace std;
+
+/**
+ * What a rank of a parallel fit reports about itself to the
+ * MetricsEndpoint:  the wall time since the fit started, the part of it
+ * spent on its events and the part spent waiting in MPI calls, its
+ * resident memory and the memory it holds on its GPU.
+ */
+
+struct RankMetrics {
+
+  int rank;
+  double wallSeconds;
+  double computeSeconds;
+  double waitSeconds;
+  double residentBytes;
+  double gpuBytes;
+};
+
+/**
+ * A minimal HTTP server on a background thread that answers GET /metrics
+ * with the metrics of a fit in the Prometheus text format, so that a
+ * long fit can be scraped and alerted on while it runs.  The owner sets
+ * the metrics of the fit itself, e.g., the likelihood and the calls per
+ * second (see FitTelemetry); the ranks of an MPI fit send theirs as UDP
+ * datagrams to the same port (see MetricsReporter), from which the
+ * endpoint adds for every rank its compute and MPI wait seconds, its
+ * memory and the seconds since its last report, and a histogram over the
+ * ranks of the fraction of the last interval each was busy with its
+ * events.  A rank that stops reporting has stalled; a rank that is busy
+ * much longer than the others is the straggler the others wait for.
+ *
+ * The server handles one request at a time and never blocks the fit:  the
+ * text it serves is copied under a lock the fit holds only to replace it.
+ */
+
+class MetricsEndpoint
+{
+
+public:
+
+  /**
+   * Listens on port (TCP for the scrapes, UDP for the ranks) of host, all
+   * interfaces if host is empty.
+   */
+  MetricsEndpoint( const string& host, int port );
+  ~MetricsEndpoint();
+
+  bool valid() const { return m_valid; }
+
+  // the metrics of the fit, complete lines in the Prometheus text format
+  void setFitMetrics( const string& text );
+
+  // the page served to a scrape:  the fit metrics, then those of the ranks
+  string text();
+
+  // the resident memory of this process in bytes
+  static double residentBytes();
+
+private:
+
+  MetricsEndpoint( const MetricsEndpoint& );
+  MetricsEndpoint& operator=( const MetricsEndpoint& );
+
+  struct RankState {
+
+    RankMetrics last;
+    double busyFraction;   // over the interval between the last two reports
+    chrono::steady_clock::time_point received;
+  };
+
+  void serve();
+  void answer( int connection );
+  void receive();
+  string rankText();
+
+  int m_listener;
+  int m_datagrams;
+  bool m_valid;
+
+  mutex m_mutex;
+  string m_fitMetrics;
+  map< int, RankState > m_ranks;
+
+  atomic< bool > m_stop;
+  thread m_thread;
+};
+
+/**
+ * Sends a RankMetrics from sample() to a MetricsEndpoint at host:port
+ * every interval seconds from a background thread, and a last one when
+ * it goes away.  A lost datagram only delays the next value.
+ */
+
+class MetricsReporter
+{
+
+public:
+
+  MetricsReporter( const string& host, int port, function< RankMetrics() > sample,
+                   double interval = 5 );
+  ~MetricsReporter();
+
+  bool valid() const { return m_socket >= 0; }
+
+private:
+
+  MetricsReporter( const MetricsReporter& );
+  MetricsReporter& operator=( const MetricsReporter& );
+
+  void run();
+  void send();
+
+  int m_socket;
+  function< RankMetrics() > m_sample;
+  double m_interval;
+
+  mutex m_mutex;
+  condition_variable m_wake;
+  bool m_stop;
+  thread m_thread;
+};
+
+// host and port of http://host:port or http://:port; false if it is not one
+bool parseHttpDestination( const string& destination, string& host, int& port );
+
+#endif
@@ -0,0 +1,217 @@
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdint.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "TFile.h"
+#include "TUUID.h"
+
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/NormIntInterface.h"
+
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+
+// 64-bit FNV-1a
+static const uint64_t kHashOffset = 14695981039346656037ULL;
+static const uint64_t kHashPrime = 1099511628211ULL;
+
+static void
+hashBytes( uint64_t& hash, const char* data, size_t size ){
+
+  for( size_t i = 0; i < size; ++i ){
+
+    hash ^= (unsigned char)data[i];
+    hash *= kHashPrime;
+  }
+}
+
+// strings are terminated so that ("ab", "c") and ("a", "bc") differ
+static void
+hashString( uint64_t& hash, const string& value ){
+
+  hashBytes( hash, value.data(), value.size() );
+  hashBytes( hash, "", 1 );
+}
+
+static bool
+isFile( const string& name ){
+
+  struct stat info;
+  return stat( name.c_str(), &info ) == 0 && S_ISREG( info.st_mode );
+}
+
+// a ROOT file is identified by its UUID, which is written when it is
+// created, so that large MC files need not be read; other files by their
+// contents
+static void
+hashFile( uint64_t& hash, const string& name ){
+
+  if( name.size() > 5 && name.compare( name.size() - 5, 5, ".root" ) == 0 ){
+
+    TFile* file = TFile::Open( name.c_str() );
+    if( file != NULL && !file->IsZombie() ){
+
+      hashString( hash, file->GetUUID().AsString() );
+      file->Close();
+      delete file;
+      return;
+    }
+    delete file;
+  }
+
+  ifstream in( name.c_str(), ios::binary );
+  vector< char > buffer( 1 << 20 );
+  while( in.read( &(buffer[0]), buffer.size() ) || in.gcount() > 0 )
+    hashBytes( hash, &(buffer[0]), in.gcount() );
+}
+
+static void
+hashReader( uint64_t& hash, const pair< string, vector< string > >& reader ){
+
+  // files count by their contents only, so that a sample that is moved
+  // or linked elsewhere keeps its integrals
+  hashString( hash, reader.first );
+  for( unsigned int i = 0; i < reader.second.size(); ++i ){
+
+    if( isFile( reader.second[i] ) ) hashFile( hash, reader.second[i] );
+    else hashString( hash, reader.second[i] );
+  }
+}
+
+NormIntCache::NormIntCache( const string& directory ) :
+  m_directory( directory )
+{
+  if( m_directory.empty() ) m_directory = ".";
+}
+
+string
+NormIntCache::fileName( const string& key ) const {
+
+  return m_directory + "/" + key + ".ni";
+}
+
+string
+NormIntCache::key( ConfigurationInfo* cfgInfo, ReactionInfo* reaction ){
+
+  if( reaction->normIntFileInput() ) return "";
+  if( reaction->genMC().first.empty() || reaction->accMC().first.empty() ) return "";
+
+  uint64_t hash = kHashOffset;
+  hashString( hash, "NormIntCache 1" );
+
+  vector< string > particles = reaction->particleList();
+  for( unsigned int i = 0; i < particles.size(); ++i ) hashString( hash, particles[i] );
+
+  hashReader( hash, reaction->genMC() );
+  hashReader( hash, reaction->accMC() );
+
+  vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( reaction->reactionName() );
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+
+    hashString( hash, amps[i]->fullName() );
+
+    vector< vector< string > > factors = amps[i]->factors();
+    for( unsigned int j = 0; j < factors.size(); ++j )
+      for( unsigned int k = 0; k < factors[j].size(); ++k )
+        hashString( hash, factors[j][k] );
+
+    // integrals that change during the fit cannot be cached
+    vector< ParameterInfo* > pars = amps[i]->parameters();
+    for( unsigned int j = 0; j < pars.size(); ++j ){
+
+      if( !pars[j]->fixed() ) return "";
+
+      ostringstream value;
+      value.precision( 17 );
+      value << pars[j]->parName() << "=" << pars[j]->value();
+      hashString( hash, value.str() );
+    }
+  }
+
+  ostringstream key;
+  key << hex;
+  key.width( 16 );
+  key.fill( '0' );
+  key << hash;
+  return key.str();
+}
+
+int
+NormIntCache::prepare( ConfigurationInfo* cfgInfo ){
+
+  m_missing.clear();
+  int nFound = 0;
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    string reactionKey = key( cfgInfo, reactions[i] );
+    if( reactionKey.empty() ) continue;
+
+    string cacheFile = fileName( reactionKey );
+    if( !isFile( cacheFile ) ){
+
+      m_missing.push_back( make_pair( reactions[i]->reactionName(), cacheFile ) );
+      continue;
+    }
+
+    // the normintfile that the configuration asks for is still written
+    string outFile = reactions[i]->normIntFile();
+    if( !outFile.empty() ){
+
+      ifstream in( cacheFile.c_str(), ios::binary );
+      ofstream out( outFile.c_str(), ios::binary );
+      out << in.rdbuf();
+    }
+
+    cout << "NormIntCache:  reading the normalization integrals of reaction "
+         << reactions[i]->reactionName() << " from " << cacheFile << endl;
+
+    reactions[i]->setNormIntFile( cacheFile, true );
+    ++nFound;
+  }
+
+  return nFound;
+}
+
+void
+NormIntCache::store( AmpToolsInterface& ati ){
+
+  if( m_missing.empty() ) return;
+
+  mkdir( m_directory.c_str(), 0755 );
+
+  for( unsigned int i = 0; i < m_missing.size(); ++i ){
+
+    NormIntInterface* normInt = ati.normIntInterface( m_missing[i].first );
+    if( normInt == NULL ) continue;
+
+    // written under a temporary name so that fits running at the same
+    // time never read a partial file
+    ostringstream tmpFile;
+    tmpFile << m_missing[i].second << "." << getpid() << ".tmp";
+
+    normInt->exportNormIntCache( tmpFile.str() );
+
+    if( rename( tmpFile.str().c_str(), m_missing[i].second.c_str() ) != 0 ){
+
+      cout << "NormIntCache ERROR:  cannot write " << m_missing[i].second << endl;
+      remove( tmpFile.str().c_str() );
+    }
+    else{
+
+      cout << "NormIntCache:  stored the normalization integrals of reaction "
+           << m_missing[i].first << " in " << m_missing[i].second << endl;
+    }
+  }
+
+  m_missing.clear();
+}
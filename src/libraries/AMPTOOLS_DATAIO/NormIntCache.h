@@ -0,0 +1,72 @@
+#if !defined(NORMINTCACHE)
+#define NORMINTCACHE
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+class ConfigurationInfo;
+class ReactionInfo;
+class AmpToolsInterface;
+
+/**
+ * An on-disk cache of the normalization integrals of the reactions of a
+ * fit.  The integrals only change when the MC samples, the amplitudes or
+ * their parameters change, so a reaction whose amplitudes have no free
+ * parameters can read them from an earlier fit instead of computing them
+ * from the accepted and generated MC again.
+ *
+ * Each reaction is keyed by a hash of everything its integrals depend on:
+ * the particle list, the genMC and accMC readers with their arguments and
+ * the contents of the files among them (the UUID for ROOT files, as in
+ * ROOTDataColumns), and the name, factors and fixed parameter values of
+ * every amplitude.  The integrals are kept in <directory>/<key>.ni in the
+ * format of the normintfile keyword.
+ *
+ * Usage:  call prepare before the AmpToolsInterface is constructed, which
+ * makes the reactions found in the cache read their integrals from it, and
+ * store once the integrals have been computed (after the first likelihood)
+ * to add the others.
+ */
+
+class NormIntCache
+{
+
+public:
+
+  NormIntCache( const string& directory );
+
+  /**
+   * Points the reactions of cfgInfo that are in the cache at their
+   * integrals and remembers the cacheable reactions that are not.  Returns
+   * the number of reactions read from the cache.
+   */
+  int prepare( ConfigurationInfo* cfgInfo );
+
+  /**
+   * Writes the integrals of the reactions that were missing in prepare.
+   */
+  void store( AmpToolsInterface& ati );
+
+  // the reactions that prepare did not find, with their cache files
+  const vector< pair< string, string > >& missing() const { return m_missing; }
+
+  /**
+   * The cache key of a reaction, or an empty string if its integrals
+   * depend on free parameters or it already reads them from a file.
+   */
+  static string key( ConfigurationInfo* cfgInfo, ReactionInfo* reaction );
+
+private:
+
+  string fileName( const string& key ) const;
+
+  string m_directory;
+
+  // reaction name and cache file of the integrals to store
+  vector< pair< string, string > > m_missing;
+};
+
+#endif
@@ -91,15 +91,17 @@ OmegaPiPlotGenerator::projectEvent( Kinematics* kin ){
   TLorentzVector Gammap = beam + target;
  
   //Calculate decay angles in helicity frame
-  vector <double> locthetaphi = getomegapiAngles(polAngle, omega, X, beam, Gammap);
+  OmegaPiProductionAngles< double > locthetaphi =
+    omegapiProductionAngles(omegapiP4(omega), omegapiP4(X), omegapiP4(beam), omegapiP4(Gammap));
 
-  vector <double> locthetaphih = getomegapiAngles(rhos_pip, omega, X, Gammap, rhos_pim);
+  OmegaPiDecayAngles< double > locthetaphih =
+    omegapiDecayAngles(omegapiP4(rhos_pip), omegapiP4(omega), omegapiP4(X), omegapiP4(Gammap), omegapiP4(rhos_pim));
 
-   GDouble cosTheta = TMath::Cos(locthetaphi[0]);
-   GDouble Phi = locthetaphi[1];
-   GDouble cosThetaH = TMath::Cos(locthetaphih[0]);
-   GDouble PhiH = locthetaphih[1];
-   GDouble prod_angle = locthetaphi[2];
+   GDouble cosTheta = TMath::Cos(locthetaphi.theta);
+   GDouble Phi = locthetaphi.phi;
+   GDouble cosThetaH = TMath::Cos(locthetaphih.theta);
+   GDouble PhiH = locthetaphih.phi;
+   GDouble prod_angle = locthetaphi.bigPhi;
 
    //cout << "calls to fillHistogram go here" << endl;
    fillHistogram( kOmegaPiMass, b1_mass );
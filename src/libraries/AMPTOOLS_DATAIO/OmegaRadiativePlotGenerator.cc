@@ -9,14 +9,16 @@
 
 /* Constructor to display FitResults */
 OmegaRadiativePlotGenerator::OmegaRadiativePlotGenerator( const FitResults& results ) :
-PlotGenerator( results )
+PlotGenerator( results ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
 
 /* Constructor for event generator (no FitResult) */
 OmegaRadiativePlotGenerator::OmegaRadiativePlotGenerator( ) :
-PlotGenerator( )
+PlotGenerator( ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
@@ -45,6 +47,32 @@ void OmegaRadiativePlotGenerator::createHistograms( ) {
 void
 OmegaRadiativePlotGenerator::projectEvent( Kinematics* kin ){
 
+   bool cached;
+   double* values = m_projections.slot( kin, cached );
+   if( !cached ) computeProjections( kin, values );
+
+   // calls to fillHistogram go here
+
+   fillHistogram( kOmegaMass, values[kOmegaMass] );
+   fillHistogram( kCosThetaPi0, values[kCosThetaPi0] );
+   fillHistogram( kCosThetaGamma, values[kCosThetaGamma] );
+   fillHistogram( kPhiPi0,  values[kPhiPi0] );
+   fillHistogram( kPhiGamma, values[kPhiGamma] );
+   fillHistogram( kCosTheta,   values[kCosTheta] );
+   fillHistogram( kPhi, values[kPhi] );
+   fillHistogram( kphi, values[kphi] );
+   fillHistogram( kPsi, values[kPsi] );
+   fillHistogram( kt, values[kt] );
+
+   fillHistogram( kThetaLabPi0, values[kThetaLabPi0] );
+   fillHistogram( kThetaLabGamma, values[kThetaLabGamma] );
+   fillHistogram( kPThetaLabPi0, values[kThetaLabPi0], values[kPThetaLabPi0] );
+   fillHistogram( kPThetaLabGamma, values[kThetaLabGamma], values[kPThetaLabGamma] );
+}
+
+void
+OmegaRadiativePlotGenerator::computeProjections( Kinematics* kin, double* values ){
+
    TLorentzVector beam   = kin->particle( 0 );
    TLorentzVector recoil = kin->particle( 1 );
    TLorentzVector p1 = kin->particle( 2 );
@@ -84,21 +112,20 @@ OmegaRadiativePlotGenerator::projectEvent( Kinematics* kin ){
    // compute invariant t
    GDouble t = - 2* recoil.M() * (recoil.E()-recoil.M());
 
-   // calls to fillHistogram go here
-
-   fillHistogram( kOmegaMass, ( resonance ).M() );
-   fillHistogram( kCosThetaPi0, p2_res.CosTheta());
-   fillHistogram( kCosThetaGamma, p1_res.CosTheta() );
-   fillHistogram( kPhiPi0,  p2.Phi() );
-   fillHistogram( kPhiGamma, p1.Phi() );
-   fillHistogram( kCosTheta,   cosTheta);
-   fillHistogram( kPhi, Phi );
-   fillHistogram( kphi, phi );
-   fillHistogram( kPsi, psi );
-   fillHistogram( kt, -t );      // fill with -t to make positive
-
-   fillHistogram( kThetaLabPi0, p2.Theta()*180./PI );
-   fillHistogram( kThetaLabGamma, p1.Theta()*180./PI );
-   fillHistogram( kPThetaLabPi0, p2.Theta()*180./PI, p2.P() );
-   fillHistogram( kPThetaLabGamma, p1.Theta()*180./PI, p1.P() );
+   values[kOmegaMass] = resonance.M();
+   values[kCosThetaPi0] = p2_res.CosTheta();
+   values[kCosThetaGamma] = p1_res.CosTheta();
+   values[kPhiPi0] = p2.Phi();
+   values[kPhiGamma] = p1.Phi();
+   values[kCosTheta] = cosTheta;
+   values[kPhi] = Phi;
+   values[kphi] = phi;
+   values[kPsi] = psi;
+   values[kt] = -t;      // fill with -t to make positive
+
+   values[kThetaLabPi0] = p2.Theta()*180./PI;
+   values[kThetaLabGamma] = p1.Theta()*180./PI;
+   // the momenta; the angles of the 2D histograms are those of the 1D ones
+   values[kPThetaLabPi0] = p2.P();
+   values[kPThetaLabGamma] = p1.P();
 }
@@ -0,0 +1,381 @@
+
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <stdint.h>
+
+#include "TLorentzVector.h"
+#include "TVector3.h"
+#include "TRandom3.h"
+
+#include "AMPTOOLS_DATAIO/PhaseSpaceDataReader.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "IUAmpTools/Kinematics.h"
+
+using namespace std;
+
+// the polynomials and initial direction numbers of the Sobol dimensions
+// after the first (Joe and Kuo), s, a, m_1 ... m_s
+static const unsigned int kSobolDims = 5;
+static const unsigned int kSobolDegree[kSobolDims] = { 0, 1, 2, 3, 3 };
+static const unsigned int kSobolPoly[kSobolDims] = { 0, 0, 1, 1, 2 };
+static const unsigned int kSobolInit[kSobolDims][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 3, 0 },
+                                                        { 1, 3, 1 }, { 1, 1, 1 } };
+
+static const unsigned int kHaltonBase[kSobolDims] = { 2, 3, 5, 7, 11 };
+
+static const unsigned int kGridSize = 1024;
+
+// the momentum of a two-body decay of mass m
+static double
+breakupMomentum( double m, double m1, double m2 ){
+
+  double arg = ( m * m - ( m1 + m2 ) * ( m1 + m2 ) ) * ( m * m - ( m1 - m2 ) * ( m1 - m2 ) );
+  return ( arg > 0 ? sqrt( arg ) / ( 2 * m ) : 0 );
+}
+
+static double
+radicalInverse( unsigned int n, unsigned int base ){
+
+  double inverse = 0, digit = 1. / base;
+  for( ; n > 0; n /= base, digit /= base ) inverse += ( n % base ) * digit;
+  return inverse;
+}
+
+// a uniform number in [0,1) from a hash of its arguments (splitmix64)
+static double
+hashUniform( unsigned int seed, unsigned int point, unsigned int dim ){
+
+  uint64_t z = ( ( (uint64_t)seed << 32 ) | point ) * 0x9E3779B97F4A7C15ULL ^
+               ( (uint64_t)dim + 1 ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  z = z ^ ( z >> 31 );
+  return ( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+map< string, PhaseSpaceDataReader::Acceptance >&
+PhaseSpaceDataReader::acceptances()
+{
+  static map< string, Acceptance > registered;
+  return registered;
+}
+
+void
+PhaseSpaceDataReader::registerAcceptance( const string& name, const Acceptance& acceptance )
+{
+  acceptances()[name] = acceptance;
+}
+
+PhaseSpaceDataReader::PhaseSpaceDataReader( const vector< string >& args ):
+  UserDataReader< PhaseSpaceDataReader >( args ),
+  m_numEvents( 0 ),
+  m_eventCounter( 0 ),
+  m_sequence( "sobol" ),
+  m_seed( 0 ),
+  m_acceptance( NULL ),
+  m_pointCounter( 0 )
+{
+  vector< string > posArgs;
+  map< string, string > options;
+  splitReaderArgs( args, posArgs, options );
+
+  if( posArgs.size() != 5 && posArgs.size() != 6 ){
+
+    cout << "PhaseSpaceDataReader ERROR:  the arguments are the number of points, the beam energy, "
+         << "the target mass and two or three masses" << endl;
+    assert( false );
+  }
+
+  m_numPoints = atoi( posArgs[0].c_str() );
+  m_beamEnergy = atof( posArgs[1].c_str() );
+  m_targetMass = atof( posArgs[2].c_str() );
+  for( unsigned int i = 3; i < posArgs.size(); ++i ) m_masses.push_back( atof( posArgs[i].c_str() ) );
+
+  for( map< string, string >::const_iterator opt = options.begin();
+       opt != options.end(); ++opt ){
+
+    if( opt->first == "sequence" ){
+
+      m_sequence = opt->second;
+      if( m_sequence != "sobol" && m_sequence != "halton" && m_sequence != "random" ){
+
+        cout << "PhaseSpaceDataReader ERROR:  unknown sequence " << m_sequence << endl;
+        assert( false );
+      }
+    }
+    else if( opt->first == "seed" ){
+
+      m_seed = atoi( opt->second.c_str() );
+    }
+    else if( opt->first == "acceptance" ){
+
+      map< string, Acceptance >::const_iterator acceptance = acceptances().find( opt->second );
+      if( acceptance == acceptances().end() ){
+
+        cout << "PhaseSpaceDataReader ERROR:  no acceptance registered as " << opt->second << endl;
+        assert( false );
+      }
+      m_acceptance = &( acceptance->second );
+    }
+    else{
+
+      cout << "PhaseSpaceDataReader ERROR:  unknown option " << opt->first << endl;
+      assert( false );
+    }
+  }
+
+  double sqrtS = sqrt( m_targetMass * m_targetMass + 2 * m_beamEnergy * m_targetMass );
+  double sumMasses = 0;
+  for( unsigned int i = 0; i < m_masses.size(); ++i ) sumMasses += m_masses[i];
+
+  if( !( sqrtS > sumMasses ) ){
+
+    cout << "PhaseSpaceDataReader ERROR:  the final-state masses exceed the center-of-mass energy "
+         << sqrtS << endl;
+    assert( false );
+  }
+
+  m_nDim = ( m_masses.size() == 2 ? 2 : 5 );
+
+  // direction numbers v_k = m_k 2^( 32 - k ), k = 1 ... 32
+  m_direction.assign( m_nDim, vector< unsigned int >( 32 ) );
+  for( unsigned int d = 0; d < m_nDim; ++d ){
+
+    unsigned int s = kSobolDegree[d];
+    for( unsigned int k = 0; k < 32; ++k ){
+
+      if( d == 0 ){
+
+        m_direction[d][k] = 1U << ( 31 - k );
+      }
+      else if( k < s ){
+
+        m_direction[d][k] = kSobolInit[d][k] << ( 31 - k );
+      }
+      else{
+
+        unsigned int v = m_direction[d][k - s] ^ ( m_direction[d][k - s] >> s );
+        for( unsigned int j = 1; j < s; ++j )
+          if( ( kSobolPoly[d] >> ( s - 1 - j ) ) & 1 ) v ^= m_direction[d][k - j];
+        m_direction[d][k] = v;
+      }
+    }
+  }
+
+  // the shifts of the point set
+  TRandom3 random( m_seed );
+  m_shift.assign( m_nDim, 0 );
+  m_rotation.assign( m_nDim, 0 );
+  if( m_seed != 0 ){
+
+    for( unsigned int d = 0; d < m_nDim; ++d ){
+
+      m_shift[d] = static_cast< unsigned int >( random.Rndm() * 4294967296. );
+      m_rotation[d] = random.Rndm();
+    }
+  }
+
+  // the marginal distribution of m12^2 in the Dalitz plot is the length
+  // of the range of m23^2
+  if( m_masses.size() == 3 ){
+
+    double m1 = m_masses[0], m2 = m_masses[1], m3 = m_masses[2];
+    double low = ( m1 + m2 ) * ( m1 + m2 );
+    double high = ( sqrtS - m3 ) * ( sqrtS - m3 );
+
+    m_massGrid.resize( kGridSize + 1 );
+    m_massCDF.resize( kGridSize + 1 );
+    m_massCDF[0] = 0;
+
+    double previous = 0;
+    for( unsigned int i = 0; i <= kGridSize; ++i ){
+
+      double m12Sq = low + ( high - low ) * i / kGridSize;
+      double m12 = sqrt( m12Sq );
+      m_massGrid[i] = m12Sq;
+
+      // the range of m23^2 is proportional to the two breakup momenta
+      // over m12
+      double length = breakupMomentum( m12, m1, m2 ) * breakupMomentum( sqrtS, m12, m3 ) / m12;
+      if( i > 0 ) m_massCDF[i] = m_massCDF[i - 1] + 0.5 * ( length + previous );
+      previous = length;
+    }
+
+    for( unsigned int i = 1; i <= kGridSize; ++i ) m_massCDF[i] /= m_massCDF[kGridSize];
+  }
+
+  // the number of events is known before they are read
+  resetSource();
+  if( m_acceptance != NULL ){
+
+    vector< double > u;
+    for( unsigned int i = 0; i < m_numPoints; ++i ){
+
+      nextPoint( u );
+      if( makeEvent( u ) > 0 ) ++m_numEvents;
+    }
+  }
+  else{
+
+    m_numEvents = m_numPoints;
+  }
+
+  resetSource();
+
+  cout << "PhaseSpaceDataReader:  " << m_numEvents << " events of " << m_numPoints << " "
+       << m_sequence << " points at sqrt(s) = " << sqrtS << " GeV" << endl;
+}
+
+void
+PhaseSpaceDataReader::resetSource()
+{
+  m_eventCounter = 0;
+  m_pointCounter = 0;
+  m_sobol.assign( m_nDim, 0 );
+}
+
+void
+PhaseSpaceDataReader::nextPoint( vector< double >& u )
+{
+  u.resize( m_nDim );
+
+  // the first point of the Sobol set, all zero, is left out
+  unsigned int n = ++m_pointCounter;
+
+  if( m_sequence == "sobol" ){
+
+    // Gray code order:  the point n differs from n - 1 in the direction
+    // of the lowest zero bit of n - 1
+    unsigned int c = 0;
+    for( unsigned int value = n - 1; value & 1; value >>= 1 ) ++c;
+
+    for( unsigned int d = 0; d < m_nDim; ++d ){
+
+      m_sobol[d] ^= m_direction[d][c];
+      u[d] = ( ( m_sobol[d] ^ m_shift[d] ) + 0.5 ) / 4294967296.;
+    }
+  }
+  else if( m_sequence == "halton" ){
+
+    for( unsigned int d = 0; d < m_nDim; ++d ){
+
+      u[d] = radicalInverse( n, kHaltonBase[d] ) + m_rotation[d];
+      if( u[d] >= 1 ) u[d] -= 1;
+    }
+  }
+  else{
+
+    for( unsigned int d = 0; d < m_nDim; ++d ) u[d] = hashUniform( m_seed, n, d );
+  }
+}
+
+double
+PhaseSpaceDataReader::makeEvent( const vector< double >& u )
+{
+  TLorentzVector beam( 0, 0, m_beamEnergy, m_beamEnergy );
+  TLorentzVector target( 0, 0, 0, m_targetMass );
+  TLorentzVector total = beam + target;
+  double sqrtS = total.M();
+
+  unsigned int nFinal = m_masses.size();
+  vector< TLorentzVector > final( nFinal );
+
+  if( nFinal == 2 ){
+
+    double p = breakupMomentum( sqrtS, m_masses[0], m_masses[1] );
+    double cosTheta = 2 * u[0] - 1;
+    double sinTheta = sqrt( 1 - cosTheta * cosTheta );
+    double phi = 2 * M_PI * u[1];
+
+    TVector3 momentum( p * sinTheta * cos( phi ), p * sinTheta * sin( phi ), p * cosTheta );
+    final[0].SetVectM( momentum, m_masses[0] );
+    final[1].SetVectM( -momentum, m_masses[1] );
+  }
+  else{
+
+    double m1 = m_masses[0], m2 = m_masses[1], m3 = m_masses[2];
+
+    // m12^2 by inversion of its cumulative distribution
+    unsigned int bin = upper_bound( m_massCDF.begin(), m_massCDF.end(), u[0] ) - m_massCDF.begin();
+    if( bin < 1 ) bin = 1;
+    if( bin > kGridSize ) bin = kGridSize;
+    double fraction = ( u[0] - m_massCDF[bin - 1] ) / ( m_massCDF[bin] - m_massCDF[bin - 1] );
+    double m12Sq = m_massGrid[bin - 1] + fraction * ( m_massGrid[bin] - m_massGrid[bin - 1] );
+    double m12 = sqrt( m12Sq );
+
+    // m23^2 uniform within its limits at m12 (PDG kinematics)
+    double e2 = ( m12Sq - m1 * m1 + m2 * m2 ) / ( 2 * m12 );
+    double e3 = ( sqrtS * sqrtS - m12Sq - m3 * m3 ) / ( 2 * m12 );
+    double p2 = sqrt( max( e2 * e2 - m2 * m2, 0. ) );
+    double p3 = sqrt( max( e3 * e3 - m3 * m3, 0. ) );
+    double m23SqLow = ( e2 + e3 ) * ( e2 + e3 ) - ( p2 + p3 ) * ( p2 + p3 );
+    double m23SqHigh = ( e2 + e3 ) * ( e2 + e3 ) - ( p2 - p3 ) * ( p2 - p3 );
+    double m23Sq = m23SqLow + u[1] * ( m23SqHigh - m23SqLow );
+
+    // the energies in the center-of-mass frame and the angle between the
+    // first and the last particle
+    double E1 = ( sqrtS * sqrtS + m1 * m1 - m23Sq ) / ( 2 * sqrtS );
+    double E3 = ( sqrtS * sqrtS + m3 * m3 - m12Sq ) / ( 2 * sqrtS );
+    double q1 = sqrt( max( E1 * E1 - m1 * m1, 0. ) );
+    double q3 = sqrt( max( E3 * E3 - m3 * m3, 0. ) );
+    double E2 = sqrtS - E1 - E3;
+    double q2Sq = E2 * E2 - m2 * m2;
+
+    double cos13 = ( q1 > 0 && q3 > 0 ? ( q2Sq - q1 * q1 - q3 * q3 ) / ( 2 * q1 * q3 ) : 1 );
+    if( cos13 > 1 ) cos13 = 1;
+    if( cos13 < -1 ) cos13 = -1;
+
+    TVector3 k3( 0, 0, q3 );
+    TVector3 k1( q1 * sqrt( 1 - cos13 * cos13 ), 0, q1 * cos13 );
+    final[0].SetVectM( k1, m1 );
+    final[2].SetVectM( k3, m3 );
+    final[1].SetVectM( -k1 - k3, m2 );
+
+    // a uniform orientation of the decay plane
+    double alpha = 2 * M_PI * u[2];
+    double beta = acos( 2 * u[3] - 1 );
+    double gamma = 2 * M_PI * u[4];
+    for( unsigned int i = 0; i < nFinal; ++i ){
+
+      final[i].RotateZ( gamma );
+      final[i].RotateY( beta );
+      final[i].RotateZ( alpha );
+    }
+  }
+
+  TVector3 boost = total.BoostVector();
+
+  m_particleList.resize( nFinal + 1 );
+  m_particleList[0] = beam;
+  for( unsigned int i = 0; i < nFinal; ++i ){
+
+    final[i].Boost( boost );
+    m_particleList[i + 1] = final[i];
+  }
+
+  return ( m_acceptance != NULL ? (*m_acceptance)( m_particleList ) : 1 );
+}
+
+Kinematics*
+PhaseSpaceDataReader::getEvent()
+{
+  vector< double > u;
+
+  while( m_eventCounter < m_numEvents && m_pointCounter < m_numPoints ){
+
+    nextPoint( u );
+    double weight = makeEvent( u );
+    if( weight <= 0 ) continue;
+
+    ++m_eventCounter;
+    return new PooledKinematics( m_particleList, weight );
+  }
+
+  return NULL;
+}
@@ -0,0 +1,121 @@
+#if !defined(PHASESPACEDATAREADER)
+#define PHASESPACEDATAREADER
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+#include "TLorentzVector.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+using namespace std;
+
+/**
+ * This class generates phase-space events of a beam on a target at rest
+ * decaying to two or three particles, from a low-discrepancy (Sobol or
+ * Halton) point set instead of pseudo-random numbers.  Integrals over
+ * such point sets converge close to 1/N instead of 1/sqrt(N) for smooth
+ * integrands, so the normalization integrals reach the precision of a
+ * much larger pseudo-random sample.
+ *
+ * A two-body event is uniform in the direction of the first particle in
+ * the center-of-mass frame.  A three-body event is uniform in the Dalitz
+ * plot (the invariant mass squared of the first two particles by
+ * inversion of its marginal distribution, that of the last two uniform
+ * within its limits) and in the orientation of the decay plane.  All
+ * events have the same phase-space weight.
+ *
+ * An acceptance (e.g., a toy detector) registered with registerAcceptance
+ * becomes the weight of the events instead of rejecting them, which keeps
+ * the point set intact; events of zero acceptance are left out.
+ */
+
+class PhaseSpaceDataReader : public UserDataReader< PhaseSpaceDataReader >
+{
+
+public:
+
+  /**
+   * The probability to accept an event (beam first, then the final
+   * state in the order of the masses).
+   */
+  typedef function< double( const vector< TLorentzVector >& ) > Acceptance;
+
+  /**
+   * Default constructor for PhaseSpaceDataReader
+   */
+  PhaseSpaceDataReader() : UserDataReader< PhaseSpaceDataReader >() { }
+
+  /**
+   * Constructor for PhaseSpaceDataReader
+   * \param[in] args vector of string arguments
+   * arguments:
+   *   0:  number of points
+   *   1:  beam energy (GeV), massless beam along z
+   *   2:  target mass (GeV)
+   *   3 ...:  masses of the two or three final-state particles (GeV)
+   * options (optional, in any order after the masses):
+   *   sequence=sobol|halton|random  the point set (default: sobol)
+   *   seed=<n>  a random digital shift of a Sobol set, a random rotation
+   *             of a Halton set, or the seed of a random set (default: 0,
+   *             no shift); independent shifts estimate the error
+   *   acceptance=<name>  weight the events with this registered acceptance
+   */
+  PhaseSpaceDataReader( const vector< string >& args );
+
+  string name() const { return "PhaseSpaceDataReader"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight(){ return m_acceptance != NULL; }
+  virtual unsigned int numEvents() const { return m_numEvents; }
+
+  /**
+   * Makes an acceptance available as acceptance=<name>; this must be
+   * called before the reader is constructed.
+   */
+  static void registerAcceptance( const string& name, const Acceptance& acceptance );
+
+private:
+
+  // the next point of the set, in [0,1)^m_nDim
+  void nextPoint( vector< double >& u );
+
+  // the event of the point u; returns the acceptance as the weight
+  double makeEvent( const vector< double >& u );
+
+  static map< string, Acceptance >& acceptances();
+
+  unsigned int m_numPoints;
+  unsigned int m_numEvents;
+  unsigned int m_eventCounter;
+
+  double m_beamEnergy;
+  double m_targetMass;
+  vector< double > m_masses;
+
+  string m_sequence;
+  unsigned int m_seed;
+  const Acceptance* m_acceptance;
+
+  // the state of the point set
+  unsigned int m_nDim;
+  unsigned int m_pointCounter;
+  vector< vector< unsigned int > > m_direction;
+  vector< unsigned int > m_sobol;
+  vector< unsigned int > m_shift;
+  vector< double > m_rotation;
+
+  // the cumulative distribution of the first invariant mass squared of a
+  // three-body decay on an equidistant grid
+  vector< double > m_massGrid;
+  vector< double > m_massCDF;
+
+  vector< TLorentzVector > m_particleList;
+};
+
+#endif
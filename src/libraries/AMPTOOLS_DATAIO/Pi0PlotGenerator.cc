@@ -9,14 +9,16 @@
 
 /* Constructor to display FitResults */
 Pi0PlotGenerator::Pi0PlotGenerator( const FitResults& results ) :
-PlotGenerator( results )
+PlotGenerator( results ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
 
 /* Constructor for event generator (no FitResult) */
 Pi0PlotGenerator::Pi0PlotGenerator( ) :
-PlotGenerator( )
+PlotGenerator( ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
@@ -33,6 +35,21 @@ Pi0PlotGenerator::createHistograms( ) {
 
 void
 Pi0PlotGenerator::projectEvent( Kinematics* kin ){
+
+  bool cached;
+  double* values = m_projections.slot( kin, cached );
+  if( !cached ) computeProjections( kin, values );
+
+  // calls to fillHistogram go here
+  fillHistogram( kCosTheta, values[kCosTheta] );
+  fillHistogram( kPhi, values[kPhi] );
+  fillHistogram( kt, values[kt] );
+  fillHistogram( kCosTheta_phi, values[kPhi], values[kCosTheta] ); 
+  fillHistogram( kt_phi, values[kPhi], values[kt] ); 
+}
+
+void
+Pi0PlotGenerator::computeProjections( Kinematics* kin, double* values ){
   
   TLorentzVector beam   = kin->particle( 0 );
   TLorentzVector recoil = kin->particle( 1 );
@@ -50,10 +67,8 @@ Pi0PlotGenerator::projectEvent( Kinematics* kin ){
   if(phi < -1*PI) phi += 2*PI;
   if(phi > PI) phi -= 2*PI;
 
-  // calls to fillHistogram go here
-  fillHistogram( kCosTheta, cosTheta );
-  fillHistogram( kPhi, phi );
-  fillHistogram( kt, -t );      // fill with -t to make positive
-  fillHistogram( kCosTheta_phi, phi, cosTheta ); 
-  fillHistogram( kt_phi, phi, -t ); 
+  // the 2D histograms are filled from the values of the 1D ones
+  values[kCosTheta] = cosTheta;
+  values[kPhi] = phi;
+  values[kt] = -t;      // fill with -t to make positive
 }
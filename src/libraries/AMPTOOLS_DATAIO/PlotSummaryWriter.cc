@@ -0,0 +1,74 @@
+
+#include <iostream>
+#include <cstring>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TAxis.h"
+
+#include "AMPTOOLS_DATAIO/PlotSummaryWriter.h"
+
+PlotSummaryWriter::PlotSummaryWriter( const string& outFile ) :
+  m_bin( 0 ),
+  m_low( 0 ),
+  m_high( 0 ),
+  m_content( 0 ),
+  m_error( 0 )
+{
+  TH1::AddDirectory( kFALSE );
+
+  m_outFile = new TFile( outFile.c_str(), "recreate" );
+  m_outTree = new TTree( "plots", "Plot Summary" );
+
+  m_outTree->Branch( "fit", m_fit, "fit/C" );
+  m_outTree->Branch( "sum", m_sum, "sum/C" );
+  m_outTree->Branch( "histogram", m_histogram, "histogram/C" );
+  m_outTree->Branch( "type", m_type, "type/C" );
+  m_outTree->Branch( "bin", &m_bin, "bin/I" );
+  m_outTree->Branch( "low", &m_low, "low/D" );
+  m_outTree->Branch( "high", &m_high, "high/D" );
+  m_outTree->Branch( "content", &m_content, "content/D" );
+  m_outTree->Branch( "error", &m_error, "error/D" );
+}
+
+PlotSummaryWriter::~PlotSummaryWriter(){
+
+  m_outFile->cd();
+  m_outTree->Write();
+  m_outFile->Close();
+
+  delete m_outFile;
+}
+
+void
+PlotSummaryWriter::write( const string& fit, const string& sum, const string& histogram,
+                          const string& type, const TH1& hist ){
+
+  copy( m_fit, sizeof( m_fit ), fit );
+  copy( m_sum, sizeof( m_sum ), sum );
+  copy( m_histogram, sizeof( m_histogram ), histogram );
+  copy( m_type, sizeof( m_type ), type );
+
+  const TAxis* axis = hist.GetXaxis();
+  for( m_bin = 0; m_bin <= hist.GetNbinsX() + 1; ++m_bin ){
+
+    m_low = axis->GetBinLowEdge( m_bin );
+    m_high = axis->GetBinUpEdge( m_bin );
+    m_content = hist.GetBinContent( m_bin );
+    m_error = hist.GetBinError( m_bin );
+
+    m_outTree->Fill();
+  }
+}
+
+void
+PlotSummaryWriter::copy( char* branch, unsigned int size, const string& value ){
+
+  if( value.size() >= size )
+    cout << "PlotSummaryWriter WARNING:  " << value << " is cut to " << size - 1
+         << " characters" << endl;
+
+  strncpy( branch, value.c_str(), size - 1 );
+  branch[size - 1] = '\0';
+}
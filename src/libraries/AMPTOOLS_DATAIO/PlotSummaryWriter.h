@@ -0,0 +1,61 @@
+#if !defined(PLOTSUMMARYWRITER)
+#define PLOTSUMMARYWRITER
+
+#include <string>
+
+using namespace std;
+
+class TFile;
+class TTree;
+class TH1;
+
+/**
+ * A columnar copy of the histograms a plotter writes:  one entry of the
+ * tree "plots" per histogram bin, with the branches
+ *
+ *   fit        the fit results file
+ *   sum        the coherent sum, or empty for the sum of all
+ *   histogram  the name of the quantity, e.g., M2pi
+ *   type       dat, acc or gen
+ *   bin        the bin index (0 and nBins + 1 are under- and overflow)
+ *   low, high  the edges of the bin
+ *   content, error
+ *
+ * Scripts that assemble the results of many fits, e.g., mass-dependent
+ * plots over the bins of an analysis, can then read one tree (or a TChain
+ * of the trees of many jobs) sequentially instead of opening a file of
+ * histograms per fit.
+ */
+
+class PlotSummaryWriter
+{
+
+public:
+
+  PlotSummaryWriter( const string& outFile );
+
+  // writes the tree and closes the file
+  ~PlotSummaryWriter();
+
+  void write( const string& fit, const string& sum, const string& histogram,
+              const string& type, const TH1& hist );
+
+private:
+
+  static void copy( char* branch, unsigned int size, const string& value );
+
+  TFile* m_outFile;
+  TTree* m_outTree;
+
+  char m_fit[1024];
+  char m_sum[256];
+  char m_histogram[64];
+  char m_type[8];
+  int m_bin;
+  double m_low;
+  double m_high;
+  double m_content;
+  double m_error;
+};
+
+#endif
@@ -0,0 +1,82 @@
+
+#include <cstring>
+
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/ProjectionCache.h"
+
+namespace {
+
+  // the finalizer of splitmix64
+  unsigned long long mix( unsigned long long x ){
+
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  unsigned long long bits( double x ){
+
+    unsigned long long b;
+    memcpy( &b, &x, sizeof( b ) );
+    return b;
+  }
+}
+
+ProjectionCache::ProjectionCache( unsigned int nValues, double maxBytes ) :
+  m_nValues( nValues ),
+  m_scratch( nValues )
+{
+  // the values and roughly the node of the hash table per event
+  double bytesPerEvent = nValues * sizeof( double ) + 48;
+  m_maxEvents = ( maxBytes > 0 ? (size_t)( maxBytes / bytesPerEvent ) : 0 );
+}
+
+double*
+ProjectionCache::slot( const Kinematics* kin, bool& cached ){
+
+  unsigned long long key = hash( kin );
+
+  unordered_map< unsigned long long, size_t >::const_iterator entry = m_index.find( key );
+  if( entry != m_index.end() ){
+
+    cached = true;
+    return &( m_values[entry->second * m_nValues] );
+  }
+
+  cached = false;
+  if( m_index.size() >= m_maxEvents ) return &( m_scratch[0] );
+
+  size_t index = m_index.size();
+  m_index[key] = index;
+  m_values.resize( ( index + 1 ) * m_nValues );
+  return &( m_values[index * m_nValues] );
+}
+
+void
+ProjectionCache::clear(){
+
+  m_index.clear();
+  vector< double >().swap( m_values );
+}
+
+unsigned long long
+ProjectionCache::hash( const Kinematics* kin ){
+
+  const vector< TLorentzVector >& particles = kin->particleList();
+
+  unsigned long long h = mix( particles.size() );
+  for( unsigned int i = 0; i < particles.size(); ++i ){
+
+    h = mix( h ^ bits( particles[i].E() ) );
+    h = mix( h ^ bits( particles[i].Px() ) );
+    h = mix( h ^ bits( particles[i].Py() ) );
+    h = mix( h ^ bits( particles[i].Pz() ) );
+  }
+  return h;
+}
@@ -0,0 +1,58 @@
+#if !defined(PROJECTIONCACHE)
+#define PROJECTIONCACHE
+
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+class Kinematics;
+
+/**
+ * The kinematic quantities that a plot generator projects, kept per event.
+ * PlotGenerator projects every MC event again for each sum configuration
+ * a plotter asks for, and the boosts and angles of an event are the same
+ * each time, so a generator computes them the first time it sees an event
+ * and only fills the histograms afterwards.  The quantities are indexed
+ * like the histograms of the generator.
+ *
+ * Events are identified by a 64-bit hash of their four-vectors, which
+ * come from the same arrays of AmpTools in every pass.  Once the cache
+ * holds maxBytes the remaining events are computed each time.
+ *
+ * Usage in projectEvent:
+ *
+ *   bool cached;
+ *   double* values = m_projections.slot( kin, cached );
+ *   if( !cached ) computeProjections( kin, values );
+ *   fillHistogram( kMass, values[kMass] );
+ *
+ * The pointer is valid until the next call to slot.
+ */
+
+class ProjectionCache
+{
+
+public:
+
+  ProjectionCache( unsigned int nValues, double maxBytes = 1e9 );
+
+  double* slot( const Kinematics* kin, bool& cached );
+
+  void clear();
+
+private:
+
+  static unsigned long long hash( const Kinematics* kin );
+
+  unsigned int m_nValues;
+  size_t m_maxEvents;
+
+  unordered_map< unsigned long long, size_t > m_index;
+  vector< double > m_values;
+
+  // for the events that no longer fit
+  vector< double > m_scratch;
+};
+
+#endif
@@ -0,0 +1,632 @@
+
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TUUID.h"
+#include "TROOT.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+#include "IUAmpTools/Kinematics.h"
+
+using namespace std;
+
+namespace {
+
+  // the layout at the start of a shared column file; the columns
+  // e, px, py, pz, and (optionally) weight follow in that order
+  struct SharedHeader {
+
+    char magic[8];
+    unsigned int version;
+    volatile unsigned int ready;
+    unsigned int numEvents;
+    int numParticles;
+    unsigned int hasWeight;
+    unsigned int pad;
+  };
+
+  const char kSharedMagic[8] = "HDAMPCL";
+  const unsigned int kSharedVersion = 1;
+
+  // the attempts to attach to or create the shared columns before a
+  // process reads its own copy, e.g., while a file of an older version is
+  // in use by other processes
+  const int kSharedAttempts = 10;
+
+  // true if fd is still the file at path, i.e., it was not removed by the
+  // last process that used it between our open and our lock
+  bool isLinked( int fd, const string& path ){
+
+    struct stat fdInfo, pathInfo;
+    return fstat( fd, &fdInfo ) == 0 && stat( path.c_str(), &pathInfo ) == 0 &&
+           fdInfo.st_dev == pathInfo.st_dev && fdInfo.st_ino == pathInfo.st_ino;
+  }
+
+  // The mapping of a shared file in this process.  Every ROOTDataColumns
+  // of the file in this process uses the one mapping and the one lock of
+  // the file, since a second lock on the file by this process would be
+  // taken through another open file and could wait for the first one.
+  struct SharedMapping {
+
+    void* map;
+    size_t size;
+    int fd;
+    unsigned int users;
+
+    // a process forked from this one shares the lock of the file, so only
+    // the process that took it may change it
+    pid_t owner;
+  };
+
+  map< string, SharedMapping >& sharedMappings(){
+
+    static map< string, SharedMapping > mappings;
+    return mappings;
+  }
+
+  // held while the columns of a shared file are attached or released
+  mutex& sharedMutex(){
+
+    static mutex sharedLock;
+    return sharedLock;
+  }
+}
+
+ROOTDataColumns::ROOTDataColumns() :
+  m_numEvents( 0 ),
+  m_numParticles( 0 ),
+  m_hasWeight( false ),
+  m_pE( NULL ),
+  m_pPx( NULL ),
+  m_pPy( NULL ),
+  m_pPz( NULL ),
+  m_pWeight( NULL ),
+  m_map( NULL ),
+  m_mapSize( 0 )
+{ }
+
+ROOTDataColumns::~ROOTDataColumns()
+{
+  release();
+}
+
+void
+ROOTDataColumns::fill( TTree* tree, bool readWeight, const string& weightExpression,
+                       unsigned int first, unsigned int last )
+{
+  int nPart;
+  float e[Kinematics::kMaxParticles];
+  float px[Kinematics::kMaxParticles];
+  float py[Kinematics::kMaxParticles];
+  float pz[Kinematics::kMaxParticles];
+  float eBeam, pxBeam, pyBeam, pzBeam;
+  ROOTDataWeight weight;
+
+  m_hasWeight = readWeight && weight.attach( tree, weightExpression );
+  if( last == 0 ) last = static_cast< unsigned int >( tree->GetEntries() );
+  assert( first <= last );
+  m_numEvents = last - first;
+
+  // only decompress the branches we need and read them through a
+  // cache that is large enough to hold many baskets at once
+  tree->SetBranchStatus( "*", 0 );
+  tree->SetBranchStatus( "NumFinalState", 1 );
+  tree->SetBranchStatus( "E_FinalState", 1 );
+  tree->SetBranchStatus( "Px_FinalState", 1 );
+  tree->SetBranchStatus( "Py_FinalState", 1 );
+  tree->SetBranchStatus( "Pz_FinalState", 1 );
+  tree->SetBranchStatus( "E_Beam", 1 );
+  tree->SetBranchStatus( "Px_Beam", 1 );
+  tree->SetBranchStatus( "Py_Beam", 1 );
+  tree->SetBranchStatus( "Pz_Beam", 1 );
+  if( m_hasWeight ) weight.enableBranches( tree );
+
+  tree->SetCacheSize( 100000000 );
+  tree->AddBranchToCache( "*", kTRUE );
+  tree->StopCacheLearningPhase();
+  tree->SetCacheEntryRange( first, last );
+
+  tree->SetBranchAddress( "NumFinalState", &nPart );
+  tree->SetBranchAddress( "E_FinalState", e );
+  tree->SetBranchAddress( "Px_FinalState", px );
+  tree->SetBranchAddress( "Py_FinalState", py );
+  tree->SetBranchAddress( "Pz_FinalState", pz );
+  tree->SetBranchAddress( "E_Beam", &eBeam );
+  tree->SetBranchAddress( "Px_Beam", &pxBeam );
+  tree->SetBranchAddress( "Py_Beam", &pyBeam );
+  tree->SetBranchAddress( "Pz_Beam", &pzBeam );
+
+  m_numParticles = 0;
+
+  for( unsigned int iEvent = 0; iEvent < m_numEvents; ++iEvent ){
+
+    tree->GetEntry( first + iEvent );
+    assert( nPart < Kinematics::kMaxParticles );
+
+    if( iEvent == 0 ){
+
+      // AmpTools requires a fixed number of particles for all events
+      // in a data source, so size the columns from the first event
+      m_numParticles = nPart + 1;
+
+      m_e.resize( m_numParticles * m_numEvents );
+      m_px.resize( m_numParticles * m_numEvents );
+      m_py.resize( m_numParticles * m_numEvents );
+      m_pz.resize( m_numParticles * m_numEvents );
+      if( m_hasWeight ) m_weight.resize( m_numEvents );
+    }
+
+    assert( nPart + 1 == m_numParticles );
+
+    m_e[iEvent] = eBeam;
+    m_px[iEvent] = pxBeam;
+    m_py[iEvent] = pyBeam;
+    m_pz[iEvent] = pzBeam;
+
+    for( int i = 0; i < nPart; ++i ){
+
+      unsigned int index = ( i + 1 ) * m_numEvents + iEvent;
+
+      m_e[index] = e[i];
+      m_px[index] = px[i];
+      m_py[index] = py[i];
+      m_pz[index] = pz[i];
+    }
+
+    if( m_hasWeight ) m_weight[iEvent] = weight.value();
+  }
+
+  // the local buffers go out of scope here
+  tree->ResetBranchAddresses();
+  tree->SetBranchStatus( "*", 1 );
+
+  pointToVectors();
+}
+
+void
+ROOTDataColumns::fillFiles( const vector< string >& files, const string& treeName,
+                            bool readWeight, const string& weightExpression,
+                            unsigned int numThreads )
+{
+  // the files are opened and read on several threads at once
+  ROOT::EnableThreadSafety();
+
+  if( numThreads == 0 ) numThreads = thread::hardware_concurrency();
+  if( numThreads > files.size() ) numThreads = files.size();
+  if( numThreads == 0 ) numThreads = 1;
+
+  vector< ROOTDataColumns* > parts( files.size(), NULL );
+  atomic< unsigned int > nextFile( 0 );
+
+  vector< thread > workers;
+  for( unsigned int t = 0; t < numThreads; ++t ){
+
+    workers.push_back( thread( [&](){
+
+      for( unsigned int i = nextFile++; i < files.size(); i = nextFile++ ){
+
+        TFile* file = TFile::Open( files[i].c_str() );
+        TTree* tree = ( file != NULL && !file->IsZombie() ?
+                        dynamic_cast< TTree* >( file->Get( treeName.c_str() ) ) : NULL );
+        if( tree == NULL ){
+
+          cout << "ROOTDataColumns ERROR:  cannot read the tree " << treeName
+               << " of " << files[i] << endl;
+          assert( false );
+        }
+
+        parts[i] = new ROOTDataColumns();
+        parts[i]->fill( tree, readWeight, weightExpression );
+
+        file->Close();
+        delete file;
+      }
+    } ) );
+  }
+
+  for( unsigned int t = 0; t < workers.size(); ++t ) workers[t].join();
+
+  merge( parts );
+
+  for( unsigned int i = 0; i < parts.size(); ++i ) delete parts[i];
+}
+
+void
+ROOTDataColumns::merge( const vector< ROOTDataColumns* >& parts )
+{
+  release();
+
+  m_numEvents = 0;
+  m_numParticles = 0;
+  m_hasWeight = false;
+
+  for( unsigned int i = 0; i < parts.size(); ++i ){
+
+    if( parts[i]->numEvents() == 0 ) continue;
+
+    if( m_numParticles == 0 ) m_numParticles = parts[i]->numParticles();
+
+    // AmpTools requires a fixed number of particles for all events
+    // in a data source
+    assert( parts[i]->numParticles() == m_numParticles );
+
+    m_numEvents += parts[i]->numEvents();
+    m_hasWeight = m_hasWeight || parts[i]->hasWeight();
+  }
+
+  m_e.resize( m_numParticles * m_numEvents );
+  m_px.resize( m_numParticles * m_numEvents );
+  m_py.resize( m_numParticles * m_numEvents );
+  m_pz.resize( m_numParticles * m_numEvents );
+  m_weight.assign( m_hasWeight ? m_numEvents : 0, 1.0 );
+
+  unsigned int offset = 0;
+  for( unsigned int i = 0; i < parts.size(); ++i ){
+
+    const ROOTDataColumns& part = *parts[i];
+    unsigned int n = part.numEvents();
+    if( n == 0 ) continue;
+
+    for( int j = 0; j < m_numParticles; ++j ){
+
+      unsigned int index = j * m_numEvents + offset;
+
+      copy( part.e( j ), part.e( j ) + n, &m_e[index] );
+      copy( part.px( j ), part.px( j ) + n, &m_px[index] );
+      copy( part.py( j ), part.py( j ) + n, &m_py[index] );
+      copy( part.pz( j ), part.pz( j ) + n, &m_pz[index] );
+    }
+
+    // files without weights have weight 1
+    if( part.hasWeight() ) copy( part.m_pWeight, part.m_pWeight + n, &m_weight[offset] );
+
+    offset += n;
+  }
+
+  pointToVectors();
+}
+
+void
+ROOTDataColumns::fillShared( TFile* file, TTree* tree, bool readWeight,
+                             const string& shmDir, const string& weightExpression )
+{
+  release();
+
+  ostringstream key;
+  key << file->GetUUID().AsString() << " " << tree->GetName() << " "
+      << tree->GetEntries() << " " << readWeight;
+  if( weightExpression != "" ) key << " " << weightExpression;
+
+  ostringstream path;
+  path << shmDir << "/halld_amp_" << hex << std::hash< string >()( key.str() )
+       << ".cols";
+
+  // The lock of the file tells who uses it:  the process that writes the
+  // columns holds it exclusively and every process that has them mapped
+  // holds it shared.  A process that dies gives its lock back, so the
+  // columns of a writer that died before they were ready are written again
+  // by the next process, and the last process to release the columns
+  // removes the file.  The processes that find the columns ready share
+  // them at once; only a process that finds none takes the exclusive lock,
+  // never while it holds the shared one, and the others wait for its
+  // columns with their shared lock.
+  lock_guard< mutex > lock( sharedMutex() );
+
+  map< string, SharedMapping >::iterator mapped = sharedMappings().find( path.str() );
+  if( mapped != sharedMappings().end() ){
+
+    ++mapped->second.users;
+    pointToMap( path.str(), mapped->second.map, mapped->second.size );
+
+    cout << "ROOTDataColumns:  sharing the mapped columns " << path.str() << endl;
+    return;
+  }
+
+  for( int attempt = 0; attempt < kSharedAttempts; ++attempt ){
+
+    if( attempt > 0 ) usleep( 10000 * attempt );
+
+    // the columns that are ready:  a shared lock waits only for a writer
+    int fd = open( path.str().c_str(), O_RDONLY );
+    if( fd >= 0 ){
+
+      if( flock( fd, LOCK_SH ) == 0 && isLinked( fd, path.str() ) && attach( path.str(), fd ) ){
+
+        cout << "ROOTDataColumns:  attached to shared columns " << path.str() << endl;
+        return;
+      }
+      close( fd );
+    }
+
+    // none are ready:  write them unless another process uses the file
+    fd = open( path.str().c_str(), O_RDWR | O_CREAT, 0644 );
+    if( fd < 0 ) break;
+
+    if( flock( fd, LOCK_EX | LOCK_NB ) != 0 || !isLinked( fd, path.str() ) ){
+
+      close( fd );
+      continue;
+    }
+
+    // written by another process between our locks
+    if( attach( path.str(), fd ) ){
+
+      flock( fd, LOCK_SH );
+      cout << "ROOTDataColumns:  attached to shared columns " << path.str() << endl;
+      return;
+    }
+
+    if( !create( path.str(), fd, tree, readWeight, weightExpression ) ){
+
+      unlink( path.str().c_str() );
+      close( fd );
+      break;
+    }
+
+    // the other processes may attach from now on
+    flock( fd, LOCK_SH );
+
+    cout << "ROOTDataColumns:  created shared columns " << path.str() << endl;
+    return;
+  }
+
+  cout << "ROOTDataColumns WARNING:  unable to use shared columns in "
+       << path.str() << "; using private memory" << endl;
+  if( m_e.empty() ) fill( tree, readWeight, weightExpression );
+}
+
+bool
+ROOTDataColumns::create( const string& path, int fd, TTree* tree, bool readWeight,
+                         const string& weightExpression )
+{
+  fill( tree, readWeight, weightExpression );
+
+  size_t nCol = static_cast< size_t >( m_numParticles ) * m_numEvents;
+  size_t size = sizeof( SharedHeader ) +
+    ( 4 * nCol + ( m_hasWeight ? m_numEvents : 0 ) ) * sizeof( float );
+
+  // the columns of a writer that died are discarded
+  void* map = MAP_FAILED;
+  if( ftruncate( fd, 0 ) == 0 && ftruncate( fd, size ) == 0 ){
+
+    map = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  }
+
+  if( map == MAP_FAILED ) return false;
+
+  SharedHeader* header = static_cast< SharedHeader* >( map );
+  memcpy( header->magic, kSharedMagic, sizeof( kSharedMagic ) );
+  header->version = kSharedVersion;
+  header->ready = 0;
+  header->numEvents = m_numEvents;
+  header->numParticles = m_numParticles;
+  header->hasWeight = ( m_hasWeight ? 1 : 0 );
+  header->pad = 0;
+
+  float* data = reinterpret_cast< float* >( header + 1 );
+  memcpy( data, &m_e[0], nCol * sizeof( float ) );
+  memcpy( data + nCol, &m_px[0], nCol * sizeof( float ) );
+  memcpy( data + 2 * nCol, &m_py[0], nCol * sizeof( float ) );
+  memcpy( data + 3 * nCol, &m_pz[0], nCol * sizeof( float ) );
+  if( m_hasWeight ){
+
+    memcpy( data + 4 * nCol, &m_weight[0], m_numEvents * sizeof( float ) );
+  }
+
+  // all data must be visible before other processes see the flag
+  __sync_synchronize();
+  header->ready = 1;
+
+  SharedMapping mapping = { map, size, fd, 1, getpid() };
+  sharedMappings()[path] = mapping;
+  pointToMap( path, map, size );
+
+  // drop the private copy
+  vector< float >().swap( m_e );
+  vector< float >().swap( m_px );
+  vector< float >().swap( m_py );
+  vector< float >().swap( m_pz );
+  vector< float >().swap( m_weight );
+
+  return true;
+}
+
+bool
+ROOTDataColumns::attach( const string& path, int fd )
+{
+  struct stat st;
+  if( fstat( fd, &st ) != 0 ||
+      static_cast< size_t >( st.st_size ) < sizeof( SharedHeader ) ) return false;
+
+  size_t size = st.st_size;
+  void* map = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+  if( map == MAP_FAILED ) return false;
+
+  const SharedHeader* header = static_cast< const SharedHeader* >( map );
+
+  if( header->ready != 1 ||
+      memcmp( header->magic, kSharedMagic, sizeof( kSharedMagic ) ) != 0 ||
+      header->version != kSharedVersion ){
+
+    munmap( map, size );
+    return false;
+  }
+
+  __sync_synchronize();
+
+  SharedMapping mapping = { map, size, fd, 1, getpid() };
+  sharedMappings()[path] = mapping;
+  pointToMap( path, map, size );
+
+  return true;
+}
+
+void
+ROOTDataColumns::pointToMap( const string& path, void* map, size_t size )
+{
+  const SharedHeader* header = static_cast< const SharedHeader* >( map );
+
+  m_numEvents = header->numEvents;
+  m_numParticles = header->numParticles;
+  m_hasWeight = ( header->hasWeight != 0 );
+
+  size_t nCol = static_cast< size_t >( m_numParticles ) * m_numEvents;
+  assert( size >= sizeof( SharedHeader ) +
+          ( 4 * nCol + ( m_hasWeight ? m_numEvents : 0 ) ) * sizeof( float ) );
+
+  const float* data = reinterpret_cast< const float* >( header + 1 );
+  m_pE = data;
+  m_pPx = data + nCol;
+  m_pPy = data + 2 * nCol;
+  m_pPz = data + 3 * nCol;
+  m_pWeight = ( m_hasWeight ? data + 4 * nCol : NULL );
+
+  m_map = map;
+  m_mapSize = size;
+  m_mapPath = path;
+}
+
+void
+ROOTDataColumns::release()
+{
+  if( m_map != NULL ){
+
+    lock_guard< mutex > lock( sharedMutex() );
+
+    map< string, SharedMapping >::iterator mapped = sharedMappings().find( m_mapPath );
+    assert( mapped != sharedMappings().end() );
+
+    if( --mapped->second.users == 0 ){
+
+      munmap( mapped->second.map, mapped->second.size );
+
+      // the last process that has the columns mapped removes them
+      int fd = mapped->second.fd;
+      if( mapped->second.owner == getpid() &&
+          flock( fd, LOCK_EX | LOCK_NB ) == 0 && isLinked( fd, m_mapPath ) )
+        unlink( m_mapPath.c_str() );
+      close( fd );
+
+      sharedMappings().erase( mapped );
+    }
+  }
+
+  m_map = NULL;
+  m_mapSize = 0;
+  m_mapPath = "";
+
+  m_pE = m_pPx = m_pPy = m_pPz = m_pWeight = NULL;
+}
+
+namespace {
+
+  // keeps the entries of the listed events of each of the numParticles
+  // parts of a column of numEvents events, in place
+  void selectColumn( vector< float >& column, int numParticles, unsigned int numEvents,
+                     const vector< unsigned int >& events )
+  {
+    if( column.empty() ) return;
+
+    // an entry is never written before it is read:  the entries are
+    // moved toward the front in increasing order
+    unsigned int n = events.size();
+    for( int j = 0; j < numParticles; ++j )
+      for( unsigned int k = 0; k < n; ++k )
+        column[j * n + k] = column[j * numEvents + events[k]];
+
+    vector< float >( column.begin(), column.begin() + numParticles * n ).swap( column );
+  }
+}
+
+void
+ROOTDataColumns::select( const vector< unsigned int >& events )
+{
+  assert( !isShared() );
+
+  selectColumn( m_e, m_numParticles, m_numEvents, events );
+  selectColumn( m_px, m_numParticles, m_numEvents, events );
+  selectColumn( m_py, m_numParticles, m_numEvents, events );
+  selectColumn( m_pz, m_numParticles, m_numEvents, events );
+  selectColumn( m_weight, 1, m_numEvents, events );
+
+  vector< unsigned int > selected( events );
+  for( unsigned int k = 0; k < selected.size() && !m_selected.empty(); ++k )
+    selected[k] = m_selected[selected[k]];
+  m_selected.swap( selected );
+
+  m_numEvents = events.size();
+  pointToVectors();
+}
+
+void
+ROOTDataColumns::pointToVectors()
+{
+  m_pE = m_e.empty() ? NULL : &m_e[0];
+  m_pPx = m_px.empty() ? NULL : &m_px[0];
+  m_pPy = m_py.empty() ? NULL : &m_py[0];
+  m_pPz = m_pz.empty() ? NULL : &m_pz[0];
+  m_pWeight = m_weight.empty() ? NULL : &m_weight[0];
+}
+
+void
+ROOTDataColumns::particleList( unsigned int iEvent,
+                               vector< TLorentzVector >& list ) const
+{
+  assert( iEvent < m_numEvents );
+
+  list.resize( m_numParticles );
+
+  for( int i = 0; i < m_numParticles; ++i ){
+
+    unsigned int index = i * m_numEvents + iEvent;
+    list[i].SetPxPyPzE( m_pPx[index], m_pPy[index], m_pPz[index], m_pE[index] );
+  }
+}
+
+void
+ROOTDataColumns::copyEvent( unsigned int iEvent, int& nPart,
+                            float* e, float* px, float* py, float* pz,
+                            float& eBeam, float& pxBeam, float& pyBeam, float& pzBeam,
+                            float& weight ) const
+{
+  assert( iEvent < m_numEvents );
+
+  eBeam = m_pE[iEvent];
+  pxBeam = m_pPx[iEvent];
+  pyBeam = m_pPy[iEvent];
+  pzBeam = m_pPz[iEvent];
+
+  nPart = m_numParticles - 1;
+
+  for( int i = 0; i < nPart; ++i ){
+
+    unsigned int index = ( i + 1 ) * m_numEvents + iEvent;
+
+    e[i] = m_pE[index];
+    px[i] = m_pPx[index];
+    py[i] = m_pPy[index];
+    pz[i] = m_pPz[index];
+  }
+
+  if( m_hasWeight ) weight = m_pWeight[iEvent];
+}
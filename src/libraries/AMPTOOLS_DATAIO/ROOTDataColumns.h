@@ -0,0 +1,193 @@
+#if !defined(ROOTDATACOLUMNS)
+#define ROOTDATACOLUMNS
+
+#include "IUAmpTools/Kinematics.h"
+
+#include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * This class holds the four-vectors (and optional weights) of all events
+ * in a tree with the standard "kin" layout in contiguous float columns.
+ * Each column is stored particle-major, i.e., all events of particle 0
+ * (the beam) followed by all events of particle 1, etc., which matches the
+ * per-particle arrays that are eventually built by the AmpTools data loader.
+ *
+ * The columns are filled in one sequential pass over the tree with only
+ * the needed branches enabled and a large TTreeCache, so that the cost of
+ * loading scales with I/O bandwidth rather than with per-event allocation.
+ *
+ * The columns can also be placed in a file that is memory-mapped by every
+ * process on a node (see fillShared).  The first process to ask for a
+ * given tree decodes it and the processes that ask while it is in use map
+ * the same pages read-only, so many fits of the same sample share one
+ * copy in memory.
+ */
+
+class ROOTDataColumns
+{
+
+public:
+
+  ROOTDataColumns();
+  ~ROOTDataColumns();
+
+  /**
+   * Read every entry of the tree into memory.  Any branch addresses that
+   * have been set on the tree are reset when loading is complete.
+   *
+   * \param[in] tree the input tree with the standard "kin" branches
+   * \param[in] readWeight if true and the tree has a "Weight" branch, read it
+   * \param[in] weightExpression if not empty, the weight is this expression
+   *   of the branches instead (see ROOTDataWeight)
+   * \param[in] first, last if last is not zero, only the entries
+   *   [first, last) are read, e.g., the slice of one rank of a parallel fit
+   */
+  void fill( TTree* tree, bool readWeight = true, const string& weightExpression = "",
+             unsigned int first = 0, unsigned int last = 0 );
+
+  /**
+   * Read the trees of several files, e.g., the run files of a sample,
+   * into one set of columns with the events in the order of the files.
+   * Each file is opened and decoded on one of numThreads threads (by
+   * default one per core, at most one per file), so the sample does not
+   * have to be merged with hadd first.
+   *
+   * \param[in] files the file names or URLs
+   * \param[in] treeName the name of the tree in every file
+   * \param[in] readWeight, weightExpression as for fill
+   * \param[in] numThreads the number of files decoded at once
+   */
+  void fillFiles( const vector< string >& files, const string& treeName,
+                  bool readWeight = true, const string& weightExpression = "",
+                  unsigned int numThreads = 0 );
+
+  /**
+   * Attach to a shared copy of the columns for this tree, creating it
+   * if no other process has done so yet.  The shared copy lives in a
+   * file in the directory shmDir (by default /dev/shm) whose name is
+   * derived from the UUID of the ROOT file and the tree name.  Each
+   * process that uses the file holds a shared lock on it, which the
+   * system gives back if the process dies, and the process that writes
+   * the columns holds it exclusively until they are ready.  A process
+   * that finds the columns ready maps them at once, the columns of a
+   * writer that died are written again by the next process instead of
+   * being waited for, and the last process to release the columns
+   * removes the file.  Only the file of a last user that was killed stays
+   * behind, until the next job of the same tree uses and removes it.
+   * The columns of the same file in one process share one mapping.
+   *
+   * \param[in] file the file that holds the tree
+   * \param[in] tree the input tree with the standard "kin" branches
+   * \param[in] readWeight if true and the tree has a "Weight" branch, read it
+   * \param[in] shmDir the directory for the shared copy
+   * \param[in] weightExpression as for fill; the weights of different
+   *   expressions are different shared copies
+   */
+  void fillShared( TFile* file, TTree* tree, bool readWeight = true,
+                   const string& shmDir = "/dev/shm",
+                   const string& weightExpression = "" );
+
+  bool isShared() const { return m_map != NULL; }
+
+  /**
+   * Keep only the listed events, in increasing order, and release the
+   * memory of the others, e.g., the events with zero weight of a
+   * sideband-subtracted sample.  Only private columns can be selected;
+   * the shared copy holds the whole tree for every process.
+   */
+  void select( const vector< unsigned int >& events );
+
+  /**
+   * The index of every kept event among the events that were filled, or
+   * an empty list if no selection was made.
+   */
+  const vector< unsigned int >& selected() const { return m_selected; }
+
+  unsigned int numEvents() const { return m_numEvents; }
+
+  /**
+   * The number of particles per event, including the beam.
+   */
+  int numParticles() const { return m_numParticles; }
+
+  bool hasWeight() const { return m_hasWeight; }
+
+  /**
+   * These return a pointer to the column of a component for the given
+   * particle (0 = beam); the column has numEvents() entries.
+   */
+  const float* e( int particle ) const { return &m_pE[particle*m_numEvents]; }
+  const float* px( int particle ) const { return &m_pPx[particle*m_numEvents]; }
+  const float* py( int particle ) const { return &m_pPy[particle*m_numEvents]; }
+  const float* pz( int particle ) const { return &m_pPz[particle*m_numEvents]; }
+
+  float weight( unsigned int iEvent ) const {
+    return m_hasWeight ? m_pWeight[iEvent] : 1.0;
+  }
+
+  /**
+   * Fill an existing particle list with the four-vectors of one event.
+   * The list is resized if needed, so a list that is reused between
+   * calls does not allocate.
+   */
+  void particleList( unsigned int iEvent, vector< TLorentzVector >& list ) const;
+
+  /**
+   * Copy one event into buffers with the layout of the tree branches,
+   * for readers that work on the branch buffers directly.  The weight
+   * is only written if the columns have a weight.
+   */
+  void copyEvent( unsigned int iEvent, int& nPart,
+                  float* e, float* px, float* py, float* pz,
+                  float& eBeam, float& pxBeam, float& pyBeam, float& pzBeam,
+                  float& weight ) const;
+
+private:
+
+  // the columns own memory or a mapping, so they cannot be copied
+  ROOTDataColumns( const ROOTDataColumns& );
+  ROOTDataColumns& operator=( const ROOTDataColumns& );
+
+  void pointToVectors();
+  void merge( const vector< ROOTDataColumns* >& parts );
+
+  // the shared file at path, open on fd with the lock that it needs
+  bool attach( const string& path, int fd );
+  bool create( const string& path, int fd, TTree* tree, bool readWeight,
+               const string& weightExpression );
+  void pointToMap( const string& path, void* map, size_t size );
+  void release();
+
+  unsigned int m_numEvents;
+  int m_numParticles;
+  bool m_hasWeight;
+
+  vector< float > m_e;
+  vector< float > m_px;
+  vector< float > m_py;
+  vector< float > m_pz;
+  vector< float > m_weight;
+  vector< unsigned int > m_selected;
+
+  // these point either into the vectors above or into the shared mapping
+  const float* m_pE;
+  const float* m_pPx;
+  const float* m_pPy;
+  const float* m_pPz;
+  const float* m_pWeight;
+
+  // the shared mapping, which the columns of the file in this process use
+  // together, and the path of its file
+  void* m_map;
+  size_t m_mapSize;
+  string m_mapPath;
+};
+
+#endif
@@ -0,0 +1,113 @@
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TUUID.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataEntryIndex.h"
+
+using namespace std;
+
+static const string kIndexMagic = "ROOTDataEntryIndex 1";
+
+string
+ROOTDataEntryIndex::makeKey( TFile* file, TTree* tree, const string& readerName,
+                             const vector< double >& cuts )
+{
+  ostringstream key;
+
+  key << file->GetUUID().AsString() << " "
+      << tree->GetName() << " "
+      << tree->GetEntries() << " "
+      << readerName;
+
+  key << setprecision( 17 );
+  for( unsigned int i = 0; i < cuts.size(); ++i ) key << " " << cuts[i];
+
+  return key.str();
+}
+
+bool
+ROOTDataEntryIndex::read( const string& fileName, const string& key )
+{
+  m_entries.clear();
+
+  ifstream in( fileName.c_str(), ios::in | ios::binary );
+  if( !in.good() ) return false;
+
+  string magic, fileKey;
+  getline( in, magic );
+  getline( in, fileKey );
+
+  if( magic != kIndexMagic || fileKey != key ){
+
+    cout << "ROOTDataEntryIndex:  ignoring index in " << fileName
+         << " since it was built for a different input or selection" << endl;
+    return false;
+  }
+
+  unsigned int nEntries = 0;
+  in.read( reinterpret_cast< char* >( &nEntries ), sizeof( nEntries ) );
+
+  m_entries.resize( nEntries );
+  if( nEntries > 0 ){
+
+    in.read( reinterpret_cast< char* >( &m_entries[0] ),
+             nEntries * sizeof( unsigned int ) );
+  }
+
+  if( !in.good() ){
+
+    cout << "ROOTDataEntryIndex:  index in " << fileName
+         << " is truncated and will be rebuilt" << endl;
+    m_entries.clear();
+    return false;
+  }
+
+  return true;
+}
+
+void
+ROOTDataEntryIndex::write( const string& fileName, const string& key ) const
+{
+  // jobs that share a sidecar may write it at the same time, so the
+  // index is written to a file of its own and renamed into place
+  ostringstream tmpName;
+  tmpName << fileName << ".tmp" << getpid();
+
+  ofstream out( tmpName.str().c_str(), ios::out | ios::binary | ios::trunc );
+  if( !out.good() ){
+
+    cout << "ROOTDataEntryIndex WARNING:  unable to write index to "
+         << fileName << endl;
+    return;
+  }
+
+  out << kIndexMagic << endl << key << endl;
+
+  unsigned int nEntries = m_entries.size();
+  out.write( reinterpret_cast< const char* >( &nEntries ), sizeof( nEntries ) );
+
+  if( nEntries > 0 ){
+
+    out.write( reinterpret_cast< const char* >( &m_entries[0] ),
+               nEntries * sizeof( unsigned int ) );
+  }
+
+  out.close();
+  if( !out.good() || rename( tmpName.str().c_str(), fileName.c_str() ) != 0 ){
+
+    cout << "ROOTDataEntryIndex WARNING:  unable to write index to "
+         << fileName << endl;
+    remove( tmpName.str().c_str() );
+  }
+}
@@ -0,0 +1,65 @@
+#if !defined(ROOTDATAENTRYINDEX)
+#define ROOTDATAENTRYINDEX
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A compact, sorted list of the tree entries that pass the event
+ * selection of a reader.  Readers fill it in one pass over the tree
+ * and then read only the listed entries on every later pass.
+ *
+ * The index can be saved to a sidecar file so that later jobs with
+ * the same input and the same cuts can skip the selection pass.  The
+ * sidecar is tagged with a key built from the UUID of the ROOT file,
+ * the tree name and size, the reader name, and the cut values; an
+ * index with a different key is never used.
+ */
+
+class ROOTDataEntryIndex
+{
+
+public:
+
+  ROOTDataEntryIndex() { }
+
+  void clear() { m_entries.clear(); }
+  void add( unsigned int entry ) { m_entries.push_back( entry ); }
+
+  unsigned int size() const { return m_entries.size(); }
+  unsigned int operator[]( unsigned int i ) const { return m_entries[i]; }
+  const vector< unsigned int >& entries() const { return m_entries; }
+
+  /**
+   * Build a key that identifies the input and the selection.
+   *
+   * \param[in] file the input file
+   * \param[in] tree the input tree
+   * \param[in] readerName the name of the reader doing the selection
+   * \param[in] cuts the numerical values of the cuts
+   */
+  static string makeKey( TFile* file, TTree* tree, const string& readerName,
+                         const vector< double >& cuts );
+
+  /**
+   * Read the index from a sidecar file.  Returns false, leaving the
+   * index empty, if the file does not exist or has a different key.
+   */
+  bool read( const string& fileName, const string& key );
+
+  /**
+   * Write the index to a sidecar file.
+   */
+  void write( const string& fileName, const string& key ) const;
+
+private:
+
+  vector< unsigned int > m_entries;
+};
+
+#endif
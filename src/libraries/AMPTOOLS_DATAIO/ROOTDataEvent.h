@@ -0,0 +1,41 @@
+#if !defined(ROOTDATAEVENT)
+#define ROOTDATAEVENT
+
+#include "IUAmpTools/Kinematics.h"
+
+#include "TLorentzVector.h"
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * One event with the layout of the branches of the standard "kin" tree.
+ * This is the unit that is passed between threads by ROOTDataPrefetcher
+ * and ROOTDataWriterPool; it has a fixed size, so buffers of these can
+ * be reused without allocating.
+ */
+
+struct ROOTDataEvent {
+
+  unsigned int entry;
+  int nPart;
+  float e[Kinematics::kMaxParticles];
+  float px[Kinematics::kMaxParticles];
+  float py[Kinematics::kMaxParticles];
+  float pz[Kinematics::kMaxParticles];
+  float eBeam, pxBeam, pyBeam, pzBeam;
+  float weight;
+
+  /**
+   * The beam followed by the final state particles, as in Kinematics.
+   */
+  TLorentzVector beam() const {
+    return TLorentzVector( pxBeam, pyBeam, pzBeam, eBeam );
+  }
+  TLorentzVector finalState( int i ) const {
+    return TLorentzVector( px[i], py[i], pz[i], e[i] );
+  }
+};
+
+#endif
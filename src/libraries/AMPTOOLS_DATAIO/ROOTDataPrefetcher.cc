@@ -0,0 +1,170 @@
+
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+#include "TTree.h"
+#include "TROOT.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+
+using namespace std;
+
+ROOTDataPrefetcher::ROOTDataPrefetcher( TTree* tree, unsigned int capacity ) :
+  ROOTDataPrefetcher( tree, "", capacity )
+{ }
+
+ROOTDataPrefetcher::ROOTDataPrefetcher( TTree* tree, const string& weightExpression,
+                                        unsigned int capacity ) :
+  m_tree( tree ),
+  m_hasWeight( weightExpression != "" || tree->GetBranch( "Weight" ) != NULL ),
+  m_weightExpression( weightExpression ),
+  m_buffer( capacity ),
+  m_head( 0 ),
+  m_count( 0 ),
+  m_done( false ),
+  m_stop( false )
+{
+  assert( capacity > 0 );
+
+  // other readers may be doing ROOT I/O on their own threads
+  ROOT::EnableThreadSafety();
+
+  m_staging.weight = 1.0;
+}
+
+ROOTDataPrefetcher::~ROOTDataPrefetcher()
+{
+  stop();
+}
+
+void
+ROOTDataPrefetcher::startAll()
+{
+  vector< unsigned int > entries( static_cast< unsigned int >( m_tree->GetEntries() ) );
+  for( unsigned int i = 0; i < entries.size(); ++i ) entries[i] = i;
+
+  start( entries );
+}
+
+void
+ROOTDataPrefetcher::start( const vector< unsigned int >& entries )
+{
+  stop();
+
+  m_entries = entries;
+  m_head = 0;
+  m_count = 0;
+  m_done = false;
+  m_stop = false;
+
+  m_tree->SetBranchAddress( "NumFinalState", &m_staging.nPart );
+  m_tree->SetBranchAddress( "E_FinalState", m_staging.e );
+  m_tree->SetBranchAddress( "Px_FinalState", m_staging.px );
+  m_tree->SetBranchAddress( "Py_FinalState", m_staging.py );
+  m_tree->SetBranchAddress( "Pz_FinalState", m_staging.pz );
+  m_tree->SetBranchAddress( "E_Beam", &m_staging.eBeam );
+  m_tree->SetBranchAddress( "Px_Beam", &m_staging.pxBeam );
+  m_tree->SetBranchAddress( "Py_Beam", &m_staging.pyBeam );
+  m_tree->SetBranchAddress( "Pz_Beam", &m_staging.pzBeam );
+  m_eventWeight.attach( m_tree, m_weightExpression );
+
+  // let the cache fetch whole clusters of baskets in one request
+  m_tree->SetCacheSize( 100000000 );
+  m_tree->AddBranchToCache( "*", kTRUE );
+  m_tree->StopCacheLearningPhase();
+
+  m_thread = thread( &ROOTDataPrefetcher::run, this );
+}
+
+void
+ROOTDataPrefetcher::stop()
+{
+  if( !m_thread.joinable() ) return;
+
+  {
+    lock_guard< mutex > lock( m_mutex );
+    m_stop = true;
+  }
+  m_notFull.notify_all();
+
+  m_thread.join();
+}
+
+void
+ROOTDataPrefetcher::run()
+{
+  unsigned int capacity = m_buffer.size();
+
+  for( unsigned int i = 0; i < m_entries.size(); ++i ){
+
+    m_tree->GetEntry( m_entries[i] );
+    assert( m_staging.nPart < Kinematics::kMaxParticles );
+    if( m_hasWeight ) m_staging.weight = m_eventWeight.value();
+    m_staging.entry = m_entries[i];
+
+    unique_lock< mutex > lock( m_mutex );
+    while( m_count == capacity && !m_stop ) m_notFull.wait( lock );
+    if( m_stop ) return;
+
+    m_buffer[( m_head + m_count ) % capacity] = m_staging;
+    ++m_count;
+
+    lock.unlock();
+    m_notEmpty.notify_one();
+  }
+
+  {
+    lock_guard< mutex > lock( m_mutex );
+    m_done = true;
+  }
+  m_notEmpty.notify_one();
+}
+
+unsigned int
+ROOTDataPrefetcher::next( int& nPart, float* e, float* px, float* py, float* pz,
+                          float& eBeam, float& pxBeam, float& pyBeam, float& pzBeam,
+                          float& weight )
+{
+  unique_lock< mutex > lock( m_mutex );
+  while( m_count == 0 && !m_done ) m_notEmpty.wait( lock );
+
+  // the consumer asked for more events than were in the entry list
+  assert( m_count > 0 );
+
+  const ROOTDataEvent& event = m_buffer[m_head];
+
+  nPart = event.nPart;
+  for( int i = 0; i < nPart; ++i ){
+
+    e[i] = event.e[i];
+    px[i] = event.px[i];
+    py[i] = event.py[i];
+    pz[i] = event.pz[i];
+  }
+
+  eBeam = event.eBeam;
+  pxBeam = event.pxBeam;
+  pyBeam = event.pyBeam;
+  pzBeam = event.pzBeam;
+  if( m_hasWeight ) weight = event.weight;
+
+  unsigned int entry = event.entry;
+
+  m_head = ( m_head + 1 ) % m_buffer.size();
+  --m_count;
+
+  lock.unlock();
+  m_notFull.notify_one();
+
+  return entry;
+}
+
+unsigned int
+ROOTDataPrefetcher::next( ROOTDataEvent& event )
+{
+  event.entry = next( event.nPart, event.e, event.px, event.py, event.pz,
+                      event.eBeam, event.pxBeam, event.pyBeam, event.pzBeam,
+                      event.weight );
+  return event.entry;
+}
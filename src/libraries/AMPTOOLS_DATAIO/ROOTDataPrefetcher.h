@@ -0,0 +1,112 @@
+#if !defined(ROOTDATAPREFETCHER)
+#define ROOTDATAPREFETCHER
+
+#include "IUAmpTools/Kinematics.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+
+#include "TTree.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * This class reads entries of a tree with the standard "kin" layout on
+ * a background thread and holds them in a bounded ring buffer, so that
+ * reading and decompressing baskets (and, for root:// URLs, waiting on
+ * the network) overlaps with the processing of earlier events.
+ *
+ * The prefetcher sets its own branch addresses on the tree when it is
+ * started.  While it is running, the owner must not read from the tree
+ * itself; the owner takes events with next() in the same order as the
+ * entry list passed to start().
+ */
+
+class ROOTDataPrefetcher
+{
+
+public:
+
+  /**
+   * \param[in] tree the input tree
+   * \param[in] capacity the number of events to hold ahead of the consumer
+   */
+  ROOTDataPrefetcher( TTree* tree, unsigned int capacity = 4096 );
+
+  /**
+   * As above, with the weight given by an expression of the branches
+   * (see ROOTDataWeight); an empty expression is the Weight branch.
+   */
+  ROOTDataPrefetcher( TTree* tree, const string& weightExpression,
+                      unsigned int capacity = 4096 );
+  ~ROOTDataPrefetcher();
+
+  /**
+   * Start reading the given entries, in order, on the background thread.
+   * Any pass that is still running is stopped first.
+   */
+  void start( const vector< unsigned int >& entries );
+
+  /**
+   * Start reading all entries of the tree.
+   */
+  void startAll();
+
+  /**
+   * Stop the background thread; events not yet taken are discarded.
+   */
+  void stop();
+
+  bool isRunning() const { return m_thread.joinable(); }
+
+  /**
+   * Copy the next event into buffers with the layout of the tree
+   * branches.  The weight is only written if the tree has a weight.
+   * Returns the tree entry of the event.
+   */
+  unsigned int next( int& nPart, float* e, float* px, float* py, float* pz,
+                     float& eBeam, float& pxBeam, float& pyBeam, float& pzBeam,
+                     float& weight );
+
+  /**
+   * Copy the next event, as above.  Returns the tree entry of the event.
+   */
+  unsigned int next( ROOTDataEvent& event );
+
+private:
+
+  ROOTDataPrefetcher( const ROOTDataPrefetcher& );
+  ROOTDataPrefetcher& operator=( const ROOTDataPrefetcher& );
+
+  void run();
+
+  TTree* m_tree;
+  bool m_hasWeight;
+  string m_weightExpression;
+  ROOTDataWeight m_eventWeight;
+
+  vector< unsigned int > m_entries;
+
+  // the ring buffer; m_head is the next event to be taken and m_count
+  // the number of events that are ready
+  vector< ROOTDataEvent > m_buffer;
+  unsigned int m_head;
+  unsigned int m_count;
+  bool m_done;
+  bool m_stop;
+
+  // the background thread reads into this and then copies into the buffer
+  ROOTDataEvent m_staging;
+
+  thread m_thread;
+  mutex m_mutex;
+  condition_variable m_notEmpty;
+  condition_variable m_notFull;
+};
+
+#endif
@@ -2,40 +2,281 @@
 #include <vector>
 #include <cassert>
 #include <iostream>
+#include <map>
+#include <cstdlib>
+#include <sstream>
+
+#include <sys/stat.h>
 
 #include "TLorentzVector.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "AMPTOOLS_DATAIO/RunPolarization.h"
 #include "IUAmpTools/Kinematics.h"
 
 #include "TH1.h"
 #include "TFile.h"
 #include "TTree.h"
+#include "TChain.h"
+#include "TTreeFormula.h"
+#include "TLeaf.h"
+#include "TBranch.h"
 
 using namespace std;
 
+namespace {
+
+  // the sizes and times of the files of a source, which change when one
+  // of them is written again
+  string sourceSignature( const string& source ){
+
+    ostringstream signature;
+    vector< string > files = readerSourceFiles( source );
+    for( unsigned int i = 0; i < files.size(); ++i ){
+
+      struct stat info;
+      if( stat( files[i].c_str(), &info ) != 0 ) continue;
+      signature << files[i] << " " << info.st_size << " " << info.st_mtime << "\n";
+    }
+    return signature.str();
+  }
+}
+
 ROOTDataReader::ROOTDataReader( const vector< string >& args ):
   UserDataReader< ROOTDataReader >( args ),
   m_eventCounter( 0 ),
-  m_useWeight( false )
+  m_useWeight( false ),
+  m_firstEntry( 0 ),
+  m_numEntries( 0 ),
+  m_columnFirst( 0 ),
+  m_bulk( false ),
+  m_columns( new ROOTDataColumns ),
+  m_prefetcher( NULL )
 {
-  assert( args.size() == 2 || args.size() == 1 );
-  
   TH1::AddDirectory( kFALSE );
+
+  vector< string > posArgs;
+  map< string, string > options;
+  splitReaderArgs( args, posArgs, options );
+
+  assert( posArgs.size() == 2 || posArgs.size() == 1 );
+
+  m_bulk = bulkByDefault();
+  bool shared = false;
+  bool async = false;
+  unsigned int eagerCapacity = 0;
+  string shmDir = "/dev/shm";
+  string weightExpression;
+  string slice;
+  unsigned int numThreads = 0;
+  string polarizationFile;
+  string runExpression = "RunNumber";
+  string cut;
+  bool dropZero = false;
+
+  for( map< string, string >::const_iterator opt = options.begin();
+       opt != options.end(); ++opt ){
+
+    if( opt->first == "bulk" ){
+
+      m_bulk = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "shm" ){
+
+      shared = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "shmdir" ){
+
+      shmDir = opt->second;
+    }
+    else if( opt->first == "async" ){
+
+      async = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "prefetch" ){
+
+      eagerCapacity = atoi( opt->second.c_str() );
+      async = ( eagerCapacity > 0 );
+    }
+    else if( opt->first == "weight" ){
+
+      weightExpression = opt->second;
+    }
+    else if( opt->first == "slice" ){
+
+      slice = opt->second;
+    }
+    else if( opt->first == "threads" ){
+
+      numThreads = atoi( opt->second.c_str() );
+    }
+    else if( opt->first == "polarization" ){
+
+      polarizationFile = opt->second;
+    }
+    else if( opt->first == "run" ){
+
+      runExpression = opt->second;
+    }
+    else if( opt->first == "cut" ){
+
+      cut = opt->second;
+    }
+    else if( opt->first == "dropzero" ){
+
+      dropZero = readerOptionIsTrue( opt->second );
+    }
+    else{
+
+      cout << "ROOTDataReader ERROR:  unknown option " << opt->first << endl;
+      assert( false );
+    }
+  }
+
+  // default to tree name of "kin" if none is provided
+  string treeName = ( posArgs.size() == 2 ? posArgs[1] : "kin" );
+
+  // the events are selected in private columns
+  if( cut != "" || dropZero ){
+
+    if( shared ){
+
+      cout << "ROOTDataReader WARNING:  shm=1 is not available with cut or dropzero;"
+           << " reading " << posArgs[0] << " into private memory" << endl;
+      shared = false;
+    }
+
+    m_bulk = true;
+  }
+
+  // the polarization of the events of the reader, in the order in which
+  // it returns them
+  if( polarizationFile != "" ){
+
+    RunPolarization::get( polarizationFile )->
+      fill( readerSourceFiles( posArgs[0] ), treeName, runExpression, slice, m_polX, m_polY );
+  }
+
+  // the columns of a reader with the same arguments are shared, also those
+  // of shm=1, which are of the whole tree
+  string columnsKey;
+  for( unsigned int i = 0; i < args.size(); ++i ) columnsKey += args[i] + '\n';
+
+  if( !shared ){
+
+    // the kept columns of a source that has changed are read again
+    map< string, pair< string, shared_ptr< ROOTDataColumns > > >::iterator kept =
+      keptColumns().find( columnsKey );
+    if( kept != keptColumns().end() && kept->second.first != sourceSignature( posArgs[0] ) ){
+
+      cout << "ROOTDataReader:  the files of " << posArgs[0] << " have changed, reading them again" << endl;
+      keptColumns().erase( kept );
+      loadedColumns().erase( columnsKey );
+    }
+  }
+
+  shared_ptr< ROOTDataColumns > columns = loadedColumns()[columnsKey].lock();
+  if( columns ){
+
+    m_columns = columns;
+    m_bulk = true;
+    m_inFile = NULL;
+    m_inTree = NULL;
+    m_numEntries = m_columns->numEvents();
+    m_useWeight = m_columns->hasWeight();
+    m_sourceName = treeName + " in " + posArgs[0];
+
+    if( shared && slice != "" ){
+
+      // checked by the reader that filled the columns
+      unsigned int lastEntry;
+      readerSliceRange( slice, m_numEntries, m_firstEntry, lastEntry );
+      m_numEntries = lastEntry - m_firstEntry;
+      m_columnFirst = m_firstEntry;
+      m_sourceName += " (slice " + slice + ")";
+    }
+
+    selectPolarization();
+
+    cout << "ROOTDataReader:  sharing the " << m_numEntries << " events of "
+         << m_sourceName << " with another reader" << endl;
+    return;
+  }
+
+  vector< string > files = readerSourceFiles( posArgs[0] );
+  if( files.empty() ){
+
+    cout << "ROOTDataReader ERROR:  no files found for " << posArgs[0] << endl;
+    assert( false );
+  }
+
+  if( files.size() > 1 ){
+
+    if( shared ){
+
+      cout << "ROOTDataReader WARNING:  shm=1 is not available for a source of several"
+           << " files; reading " << posArgs[0] << " into private memory" << endl;
+    }
+
+    readFiles( files, treeName, weightExpression, slice, numThreads, cut, dropZero );
+    storeColumns( columnsKey, posArgs[0] );
+    return;
+  }
   
   //this way of opening files works with URLs of the form
   // root://xrootdserver/path/to/myfile.root
-  m_inFile = TFile::Open( args[0].c_str() );
+  m_inFile = TFile::Open( files[0].c_str() );
 
-  
-  // default to tree name of "kin" if none is provided
-  if( args.size() == 1 ){
-    
-    m_inTree = dynamic_cast<TTree*>( m_inFile->Get( "kin" ) );
+  m_inTree = dynamic_cast<TTree*>( m_inFile->Get( treeName.c_str() ) );
+
+  m_sourceName = string( m_inTree->GetName() ) + " in " + m_inFile->GetName();
+
+  unsigned int lastEntry = static_cast< unsigned int >( m_inTree->GetEntries() );
+  if( slice != "" ){
+
+    if( !readerSliceRange( slice, lastEntry, m_firstEntry, lastEntry ) ){
+
+      cout << "ROOTDataReader ERROR:  slice=" << slice << " is not of the form i/n" << endl;
+      assert( false );
+    }
+
+    m_sourceName += " (slice " + slice + ")";
   }
-  else{
-    
-    m_inTree = dynamic_cast<TTree*>( m_inFile->Get( args[1].c_str() ) );
+  m_numEntries = lastEntry - m_firstEntry;
+
+  if( shared ) m_bulk = true;
+
+  if( m_bulk ){
+
+    if( shared ){
+
+      // the shared copy is of the whole tree, so that the ranks on a
+      // node that read different slices still share it
+      m_columns->fillShared( m_inFile, m_inTree, true, shmDir, weightExpression );
+      m_columnFirst = m_firstEntry;
+      loadedColumns()[columnsKey] = m_columns;
+    }
+    else{
+
+      m_columns->fill( m_inTree, true, weightExpression, m_firstEntry, lastEntry );
+      storeColumns( columnsKey, posArgs[0] );
+    }
+
+    m_useWeight = m_columns->hasWeight();
+
+    cout << "ROOTDataReader:  loaded " << m_numEntries
+         << " events from " << m_sourceName << endl;
+
+    if( cut != "" || dropZero ) selectEvents( m_inTree, m_firstEntry, cut, dropZero );
+
+    // everything we need is in memory now
+    m_inFile->Close();
+    m_inFile = NULL;
+    m_inTree = NULL;
+
+    return;
   }
   
   m_inTree->SetBranchAddress( "NumFinalState", &m_nPart );
@@ -48,19 +289,189 @@ ROOTDataReader::ROOTDataReader( const vector< string >& args ):
   m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
   m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
 
-  if(m_inTree->GetBranch("Weight") != NULL) {
+  m_useWeight = m_eventWeight.attach( m_inTree, weightExpression );
+
+  if( eagerCapacity > 0 ){
 
-    m_useWeight = true;
-    m_inTree->SetBranchAddress( "Weight", &m_weight );
+    // the framework constructs the readers of a reaction before it loads
+    // any of them, so this one decodes while the sources before it are
+    // loaded (and, on GPU builds, copied to the device)
+    m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression, eagerCapacity );
+    startPrefetcher();
+  }
+  else if( async ) m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression );
+}
+
+void
+ROOTDataReader::readFiles( const vector< string >& files, const string& treeName,
+                           const string& weightExpression, const string& slice,
+                           unsigned int numThreads, const string& cut, bool dropZero )
+{
+  // a source of several files is always read into columns
+  m_bulk = true;
+  m_inFile = NULL;
+  m_inTree = NULL;
+
+  ostringstream sourceName;
+  sourceName << treeName << " in " << files.size() << " files (" << files[0] << ", ...)";
+  m_sourceName = sourceName.str();
+
+  // the entries of the files in their order, for a slice or a cut
+  TChain chain( treeName.c_str() );
+  if( slice != "" || cut != "" )
+    for( unsigned int i = 0; i < files.size(); ++i ) chain.Add( files[i].c_str() );
+
+  if( slice == "" ){
+
+    m_columns->fillFiles( files, treeName, true, weightExpression, numThreads );
+    m_numEntries = m_columns->numEvents();
   }
   else{
 
-    m_useWeight = false;
+    // only the entries of the slice are read, through the chain
+    unsigned int lastEntry = static_cast< unsigned int >( chain.GetEntries() );
+    if( !readerSliceRange( slice, lastEntry, m_firstEntry, lastEntry ) ){
+
+      cout << "ROOTDataReader ERROR:  slice=" << slice << " is not of the form i/n" << endl;
+      assert( false );
+    }
+
+    m_sourceName += " (slice " + slice + ")";
+    m_numEntries = lastEntry - m_firstEntry;
+
+    m_columns->fill( &chain, true, weightExpression, m_firstEntry, lastEntry );
   }
+
+  m_useWeight = m_columns->hasWeight();
+
+  cout << "ROOTDataReader:  loaded " << m_numEntries
+       << " events from " << m_sourceName << endl;
+
+  if( cut != "" || dropZero ) selectEvents( &chain, m_firstEntry, cut, dropZero );
+}
+
+void
+ROOTDataReader::selectEvents( TTree* tree, unsigned int first, const string& cut,
+                              bool dropZero )
+{
+  unsigned int numLoaded = m_columns->numEvents();
+  vector< char > pass( numLoaded, 1 );
+
+  if( cut != "" ){
+
+    TTreeFormula formula( "cut", cut.c_str(), tree );
+    if( formula.GetNdim() == 0 ){
+
+      cout << "ROOTDataReader ERROR:  cannot evaluate the cut " << cut
+           << " on " << m_sourceName << endl;
+      assert( false );
+    }
+
+    // a chain moves the formula to the tree of each file it opens
+    bool chain = tree->InheritsFrom( TChain::Class() );
+    if( chain ) tree->SetNotify( &formula );
+
+    // only the leaves of the cut are decompressed
+    tree->SetBranchStatus( "*", 0 );
+    for( int i = 0; i < formula.GetNcodes(); ++i ){
+
+      TLeaf* leaf = formula.GetLeaf( i );
+      if( leaf != NULL ) tree->SetBranchStatus( leaf->GetBranch()->GetName(), 1 );
+    }
+
+    for( unsigned int i = 0; i < numLoaded; ++i ){
+
+      tree->LoadTree( first + i );
+      formula.GetNdata();
+      pass[i] = ( formula.EvalInstance() != 0 );
+    }
+
+    if( chain ) tree->SetNotify( NULL );
+    tree->SetBranchStatus( "*", 1 );
+  }
+
+  vector< unsigned int > events;
+  events.reserve( numLoaded );
+  for( unsigned int i = 0; i < numLoaded; ++i )
+    if( pass[i] && !( dropZero && m_columns->weight( i ) == 0 ) ) events.push_back( i );
+
+  m_columns->select( events );
+  m_numEntries = m_columns->numEvents();
+  selectPolarization();
+
+  cout << "ROOTDataReader:  kept " << m_numEntries << " of " << numLoaded
+       << " events of " << m_sourceName << " ("
+       << ( numLoaded > 0 ? 100. * m_numEntries / numLoaded : 100. ) << "%)" << endl;
+}
+
+void
+ROOTDataReader::selectPolarization()
+{
+  const vector< unsigned int >& selected = m_columns->selected();
+  if( m_polX.empty() || selected.empty() ) return;
+
+  // the kept events are in increasing order, so the values move forward
+  for( unsigned int k = 0; k < selected.size(); ++k ){
+
+    m_polX[k] = m_polX[selected[k]];
+    m_polY[k] = m_polY[selected[k]];
+  }
+
+  m_polX.resize( selected.size() );
+  m_polY.resize( selected.size() );
+}
+
+void
+ROOTDataReader::setBulkByDefault( bool bulk )
+{
+  bulkByDefault() = bulk;
+}
+
+void
+ROOTDataReader::setKeepColumns( bool keep )
+{
+  keepColumns() = keep;
+}
+
+void
+ROOTDataReader::storeColumns( const string& key, const string& source )
+{
+  loadedColumns()[key] = m_columns;
+  if( keepColumns() ) keptColumns()[key] = make_pair( sourceSignature( source ), m_columns );
+}
+
+map< string, pair< string, shared_ptr< ROOTDataColumns > > >&
+ROOTDataReader::keptColumns()
+{
+  static map< string, pair< string, shared_ptr< ROOTDataColumns > > > columns;
+  return columns;
+}
+
+bool&
+ROOTDataReader::keepColumns()
+{
+  static bool keep = false;
+  return keep;
+}
+
+map< string, weak_ptr< ROOTDataColumns > >&
+ROOTDataReader::loadedColumns()
+{
+  static map< string, weak_ptr< ROOTDataColumns > > columns;
+  return columns;
+}
+
+bool&
+ROOTDataReader::bulkByDefault()
+{
+  static bool bulk = false;
+  return bulk;
 }
 
 ROOTDataReader::~ROOTDataReader()
 {
+  // the background thread must be done with the tree before it goes away
+  if( m_prefetcher != NULL ) delete m_prefetcher;
   if( m_inFile != NULL ) m_inFile->Close();
 }
 
@@ -68,33 +479,57 @@ void
 ROOTDataReader::resetSource()
 {
 	
-  cout << "Resetting source " << m_inTree->GetName() 
-       << " in " << m_inFile->GetName() << endl;
+  cout << "Resetting source " << m_sourceName << endl;
   
   // this will cause the read to start back at event 0
+  // a pass from which nothing has been taken yet, e.g., the one started
+  // by prefetch=<n>, already is at event 0
+  if( m_prefetcher != NULL && m_eventCounter > 0 ) m_prefetcher->stop();
   m_eventCounter = 0;
 }
 
 Kinematics*
 ROOTDataReader::getEvent()
 {
-  if( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
+  if( m_bulk ){
+
+    if( m_eventCounter < m_numEntries ){
+
+      // m_particleList keeps its capacity between calls
+      unsigned int iEvent = m_columnFirst + m_eventCounter++;
+      m_columns->particleList( iEvent, m_particleList );
+      setPolarization( m_eventCounter - 1, m_particleList[0] );
+      return new PooledKinematics( m_particleList, m_columns->weight( iEvent ) );
+    }
+    else{
+
+      return NULL;
+    }
+  }
+
+  if( m_eventCounter < m_numEntries ){
     //  if( m_eventCounter < 10 ){
     
-    m_inTree->GetEntry( m_eventCounter++ );
+    if( m_prefetcher != NULL ){
+
+      if( !m_prefetcher->isRunning() ) startPrefetcher();
+      m_prefetcher->next( m_nPart, m_e, m_px, m_py, m_pz,
+                          m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam, m_weight );
+      m_eventCounter++;
+    }
+    else{
+
+      m_inTree->GetEntry( m_firstEntry + m_eventCounter++ );
+      m_weight = m_eventWeight.value();
+    }
     assert( m_nPart < Kinematics::kMaxParticles );
     
-    vector< TLorentzVector > particleList;
-    
-    particleList.
-      push_back( TLorentzVector( m_pxBeam, m_pyBeam, m_pzBeam, m_eBeam ) );
-    
-    for( int i = 0; i < m_nPart; ++i ){
-      
-      particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
-    }
+    fillParticleList( m_particleList, m_nPart, m_e, m_px, m_py, m_pz,
+                      m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam );
+
+    setPolarization( m_eventCounter - 1, m_particleList[0] );
     
-    return new Kinematics( particleList, m_useWeight ? m_weight : 1.0 );
+    return new PooledKinematics( m_particleList, m_useWeight ? m_weight : 1.0 );
   }
   else{
     
@@ -102,8 +537,31 @@ ROOTDataReader::getEvent()
   }
 }
 
+void
+ROOTDataReader::setPolarization( unsigned int iEvent, TLorentzVector& beam ) const
+{
+  if( m_polX.empty() ) return;
+
+  beam.SetPx( m_polX[iEvent] );
+  beam.SetPy( m_polY[iEvent] );
+}
+
 unsigned int
 ROOTDataReader::numEvents() const
 {	
-  return static_cast< unsigned int >( m_inTree->GetEntries() );
+  return m_numEntries;
+}
+
+void
+ROOTDataReader::startPrefetcher()
+{
+  if( m_firstEntry == 0 && m_numEntries == m_inTree->GetEntries() ){
+
+    m_prefetcher->startAll();
+    return;
+  }
+
+  vector< unsigned int > entries( m_numEntries );
+  for( unsigned int i = 0; i < m_numEntries; ++i ) entries[i] = m_firstEntry + i;
+  m_prefetcher->start( entries );
 }
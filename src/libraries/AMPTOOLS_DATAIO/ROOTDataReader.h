@@ -4,11 +4,19 @@
 #include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/UserDataReader.h"
 
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+
 #include "TString.h"
 #include "TFile.h"
 #include "TTree.h"
 
 #include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <memory>
 
 using namespace std;
 
@@ -20,13 +28,62 @@ public:
   /**
    * Default constructor for ROOTDataReader
    */
-  ROOTDataReader() : UserDataReader< ROOTDataReader >(), m_inFile( NULL ) { }
+  ROOTDataReader() : UserDataReader< ROOTDataReader >(), m_inFile( NULL ), m_bulk( false ),
+    m_columns( new ROOTDataColumns ), m_prefetcher( NULL ) { }
   
   ~ROOTDataReader();
   
   /**
    * Constructor for ROOTDataReader
    * \param[in] args vector of string arguments
+   * arguments:
+   *   0:  file name, or several files:  a comma-separated list, a pattern
+   *       such as runs/tree_*.root, or @<list> for the files listed in a
+   *       text file (see readerSourceFiles); the events of all files are
+   *       read into columns as with bulk=1, with the files decoded in
+   *       parallel
+   *   1:  tree name (optional; default: "kin")
+   * options (optional, in any order after the file name):
+   *   bulk=1  read all events into contiguous columns when the reader is
+   *           constructed and close the file; getEvent() then only copies
+   *           from memory
+   *   shm=1   like bulk=1, but the columns are shared by all processes on
+   *           the node that read the same tree; the last of them to finish
+   *           removes the shared copy (see ROOTDataColumns)
+   *   shmdir=<dir>  directory for the shared columns (default: /dev/shm)
+   *   async=1 read and decompress entries on a background thread ahead of
+   *           getEvent(); useful for files read over root:// URLs
+   *   prefetch=<n>  like async=1 with up to n events read ahead, starting
+   *           when the reader is constructed, so that the source is
+   *           decoded while the sources before it are loaded
+   *   weight=<expression>  the weight of the events is this expression of
+   *           the branches instead of the Weight branch (see ROOTDataWeight)
+   *   slice=<i>/<n>  only the slice i of n equal slices of the entries is
+   *           read, e.g., by rank i of n in a parallel fit; with shm=1 the
+   *           whole tree is shared and the reader returns its slice
+   *   threads=<n>  the number of files of a source of several files that
+   *           are decoded at once (default: one per core)
+   *   polarization=<file>  the beam polarization of every event is looked
+   *           up by its run in the table in file when the reader is
+   *           constructed and returned in the beam px and py (see
+   *           RunPolarization)
+   *   run=<expression>  the run of the events for polarization=<file>
+   *           (default: RunNumber)
+   *   cut=<expression>  only the events for which this expression of the
+   *           branches is not zero are kept, e.g., a range of the
+   *           invariant mass or of t stored in the tree
+   *   dropzero=1  the events with zero weight are not kept, e.g., the
+   *           events outside the windows of a sideband subtraction
+   *
+   * With cut or dropzero the events are read into columns as with bulk=1
+   * and the others are dropped when the reader is constructed, so the
+   * framework stores and evaluates only the kept events; the fraction
+   * kept is printed.  shm=1 is not available with them.
+   *
+   * The readers of a process that read into columns with the same
+   * arguments share one copy of the columns, which is decoded once:  e.g.,
+   * the accepted and generated MC of the reactions of the polarization
+   * orientations or t bins of one configuration.
    */
   ROOTDataReader( const vector< string >& args );
   
@@ -42,13 +99,89 @@ public:
    */
   virtual bool hasWeight(){ return m_useWeight; };
   virtual unsigned int numEvents() const;
+
+  /**
+   * This function returns true if the reader was constructed with the
+   * bulk=1 or shm=1 option.  In that case the events are available directly
+   * through columns(), which avoids building a Kinematics object for
+   * every event.
+   */
+  bool isBulk() const { return m_bulk; }
+  const ROOTDataColumns& columns() const { return *m_columns; }
+
+  /**
+   * With bulk true every reader constructed afterwards reads into columns
+   * as with bulk=1, so that the readers of the same source share them.
+   */
+  static void setBulkByDefault( bool bulk );
+
+  /**
+   * With keep true the columns of every source read from now on stay in
+   * memory after its readers are deleted, so the readers of the next
+   * AmpToolsInterface of the process with the same arguments share them
+   * (see fit --serve); a source whose files have changed size or time
+   * since is read again.
+   */
+  static void setKeepColumns( bool keep );
+
+  /**
+   * The first event of the reader in columns(); not zero only for a
+   * slice of shared columns.
+   */
+  unsigned int firstColumnEvent() const { return m_columnFirst; }
   
 private:
+
+  // the prefetcher reads the entries of the reader from the first
+  void startPrefetcher();
+
+  void readFiles( const vector< string >& files, const string& treeName,
+                  const string& weightExpression, const string& slice,
+                  unsigned int numThreads, const string& cut, bool dropZero );
+
+  // the polarization of event iEvent of the reader into the beam
+  void setPolarization( unsigned int iEvent, TLorentzVector& beam ) const;
+
+  // keeps the events of the columns that pass cut and, with dropZero,
+  // have a weight; the columns hold the entries [first, first + number
+  // of events) of tree, which is only read for a cut
+  void selectEvents( TTree* tree, unsigned int first, const string& cut, bool dropZero );
+
+  // the polarization of the events that the columns kept
+  void selectPolarization();
+
+  // the columns of the readers that are alive, by their arguments
+  static map< string, weak_ptr< ROOTDataColumns > >& loadedColumns();
+  static bool& bulkByDefault();
+
+  // with setKeepColumns, the columns of every source by the arguments of
+  // its readers, with the sizes and times of its files
+  static map< string, pair< string, shared_ptr< ROOTDataColumns > > >& keptColumns();
+  static bool& keepColumns();
+
+  // adds the columns of the reader to loadedColumns and keptColumns
+  void storeColumns( const string& key, const string& source );
 	
   TFile* m_inFile;
   TTree* m_inTree;
   unsigned int m_eventCounter;
   bool m_useWeight;
+
+  // the entries of the tree that the reader returns
+  unsigned int m_firstEntry;
+  unsigned int m_numEntries;
+  unsigned int m_columnFirst;
+
+  bool m_bulk;
+  shared_ptr< ROOTDataColumns > m_columns;
+  vector< TLorentzVector > m_particleList;
+  string m_sourceName;
+  ROOTDataPrefetcher* m_prefetcher;
+  ROOTDataWeight m_eventWeight;
+
+  // the beam px and py of every event with polarization=<file>
+  vector< float > m_polX;
+  vector< float > m_polY;
   
   int m_nPart;
   float m_e[Kinematics::kMaxParticles];
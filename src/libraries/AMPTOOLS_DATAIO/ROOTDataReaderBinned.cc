@@ -0,0 +1,268 @@
+#include <vector>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+
+#include "TLorentzVector.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBinned.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "TH1.h"
+#include "TFile.h"
+#include "TTree.h"
+
+using namespace std;
+
+ROOTDataReaderBinned::ROOTDataReaderBinned( const vector< string >& args ):
+   UserDataReader< ROOTDataReaderBinned >( args ),
+   m_eventCounter( 0 ),
+   m_useWeight( false ),
+   m_useColumns( false ),
+   m_prefetcher( NULL )
+{
+   vector< string > posArgs;
+   map< string, string > options;
+   splitReaderArgs( args, posArgs, options );
+
+   assert( posArgs.size() == 6 || posArgs.size() == 5 );
+
+   string indexBase;
+   string shmDir = "/dev/shm";
+   bool async = false;
+   string weightExpression;
+   unsigned int maxEvents = 0;
+   for( map< string, string >::const_iterator opt = options.begin();
+        opt != options.end(); ++opt ){
+
+      if( opt->first == "index" ){
+
+         indexBase = opt->second;
+      }
+      else if( opt->first == "maxevents" ){
+
+         maxEvents = static_cast< unsigned int >( atof( opt->second.c_str() ) );
+      }
+      else if( opt->first == "shm" ){
+
+         m_useColumns = readerOptionIsTrue( opt->second );
+      }
+      else if( opt->first == "shmdir" ){
+
+         shmDir = opt->second;
+      }
+      else if( opt->first == "async" ){
+
+         async = readerOptionIsTrue( opt->second );
+      }
+      else if( opt->first == "weight" ){
+
+         weightExpression = opt->second;
+      }
+      else{
+
+         cout << "ROOTDataReaderBinned ERROR:  unknown option " << opt->first << endl;
+         assert( false );
+      }
+   }
+
+   m_lowMass = atof( posArgs[1].c_str() );
+   m_highMass = atof( posArgs[2].c_str() );
+   m_numBins = atoi( posArgs[3].c_str() );
+   m_bin = atoi( posArgs[4].c_str() );
+
+   if( m_numBins <= 0 || m_bin < 0 || m_bin >= m_numBins || !( m_highMass > m_lowMass ) ){
+
+      cout << "ROOTDataReaderBinned ERROR:  invalid bin " << m_bin << " of " << m_numBins
+           << " in [" << m_lowMass << "," << m_highMass << ")" << endl;
+      assert( false );
+   }
+
+   TH1::AddDirectory( kFALSE );
+
+   //this way of opening files works with URLs of the form
+   // root://xrootdserver/path/to/myfile.root
+   m_inFile = TFile::Open( posArgs[0].c_str() );
+
+   // default to tree name of "kin" if none is provided
+   string treeName = ( posArgs.size() == 6 ? posArgs[5] : "kin" );
+   m_inTree = dynamic_cast<TTree*>( m_inFile->Get( treeName.c_str() ) );
+
+   m_inTree->SetBranchAddress( "NumFinalState", &m_nPart );
+   m_inTree->SetBranchAddress( "E_FinalState", m_e );
+   m_inTree->SetBranchAddress( "Px_FinalState", m_px );
+   m_inTree->SetBranchAddress( "Py_FinalState", m_py );
+   m_inTree->SetBranchAddress( "Pz_FinalState", m_pz );
+   m_inTree->SetBranchAddress( "E_Beam", &m_eBeam );
+   m_inTree->SetBranchAddress( "Px_Beam", &m_pxBeam );
+   m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
+   m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
+
+   if( m_useColumns ) m_columns.fillShared( m_inFile, m_inTree, true, shmDir, weightExpression );
+
+   m_useWeight = m_eventWeight.attach( m_inTree, weightExpression );
+
+   cout << "*********************************************" << endl;
+   cout << "ROOT Data reader  mass bin " << m_bin << " of " << m_numBins
+        << " in [" << m_lowMass << "," << m_highMass << ")" << endl;
+   cout << "Total events: " <<  m_inTree->GetEntries() << endl;
+
+   selectEntries( indexBase, maxEvents );
+
+   cout << "Number of events kept    = " << m_entryIndex.size() << endl;
+   cout << "*********************************************" << endl;
+
+   if( async && !m_useColumns ) m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression );
+}
+
+ROOTDataReaderBinned::~ROOTDataReaderBinned()
+{
+   // the background thread must be done with the tree before it goes away
+   if( m_prefetcher != NULL ) delete m_prefetcher;
+   if( m_inFile != NULL ) m_inFile->Close();
+}
+
+void
+ROOTDataReaderBinned::selectEntries( const string& indexBase, unsigned int maxEvents )
+{
+   vector< string > indexFiles;
+   if( indexBase != "" ){
+
+      for( int bin = 0; bin < m_numBins; ++bin ){
+
+         ostringstream indexFile;
+         indexFile << indexBase << "_" << bin << ".idx";
+         indexFiles.push_back( indexFile.str() );
+      }
+
+      if( m_entryIndex.read( indexFiles[m_bin], indexKey( m_bin, maxEvents ) ) ){
+
+         cout << "Read selected entries from " << indexFiles[m_bin] << endl;
+         return;
+      }
+   }
+
+   // with a sidecar the pass keeps the entries of every bin,
+   // otherwise only those of this one
+   vector< ROOTDataEntryIndex > binIndex( indexBase != "" ? m_numBins : 0 );
+
+   // the mass only depends on the final state, so only read
+   // the final state branches while selecting
+   m_inTree->SetBranchStatus( "*", 0 );
+   m_inTree->SetBranchStatus( "NumFinalState", 1 );
+   m_inTree->SetBranchStatus( "E_FinalState", 1 );
+   m_inTree->SetBranchStatus( "Px_FinalState", 1 );
+   m_inTree->SetBranchStatus( "Py_FinalState", 1 );
+   m_inTree->SetBranchStatus( "Pz_FinalState", 1 );
+
+   double step = ( m_highMass - m_lowMass ) / m_numBins;
+
+   unsigned int nEntries = static_cast< unsigned int >( m_inTree->GetEntries() );
+   if( maxEvents > 0 && nEntries > maxEvents ) nEntries = maxEvents;
+
+   for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
+
+      readEntry( iEntry );
+      assert( m_nPart < Kinematics::kMaxParticles );
+
+      // the first entry in the final state list is the recoil
+      // skip it in computing the mass
+      TLorentzVector x;
+      for( int i = 1; i < m_nPart; ++i ){
+
+         x += TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] );
+      }
+
+      int bin = static_cast< int >( floor( ( x.M() - m_lowMass ) / step ) );
+      if( bin < 0 || bin >= m_numBins ) continue;
+
+      if( !binIndex.empty() ) binIndex[bin].add( iEntry );
+      else if( bin == m_bin ) m_entryIndex.add( iEntry );
+   }
+
+   m_inTree->SetBranchStatus( "*", 1 );
+
+   if( binIndex.empty() ) return;
+
+   for( int bin = 0; bin < m_numBins; ++bin ){
+
+      binIndex[bin].write( indexFiles[bin], indexKey( bin, maxEvents ) );
+   }
+   cout << "Wrote selected entries of " << m_numBins << " bins to "
+        << indexBase << "_*.idx" << endl;
+
+   m_entryIndex = binIndex[m_bin];
+}
+
+string
+ROOTDataReaderBinned::indexKey( int bin, unsigned int maxEvents ) const
+{
+   vector< double > cuts;
+   cuts.push_back( m_lowMass );
+   cuts.push_back( m_highMass );
+   cuts.push_back( m_numBins );
+   cuts.push_back( bin );
+   cuts.push_back( maxEvents );
+
+   return ROOTDataEntryIndex::makeKey( m_inFile, m_inTree, name(), cuts );
+}
+
+void ROOTDataReaderBinned::resetSource()
+{
+
+   cout << "Resetting source " << m_inTree->GetName()
+      << " in " << m_inFile->GetName() << endl;
+
+   // this will cause the read to start back at event 0
+   m_eventCounter = 0;
+   if( m_prefetcher != NULL ) m_prefetcher->stop();
+}
+
+Kinematics*
+ROOTDataReaderBinned::getEvent()
+{
+   if( m_eventCounter < m_entryIndex.size() ){
+
+      readEntry( m_entryIndex[m_eventCounter++] );
+      fillParticleList( m_particleList, m_nPart, m_e, m_px, m_py, m_pz,
+                        m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam );
+      return new PooledKinematics( m_particleList, m_useWeight ? m_weight : 1.0 );
+   }
+
+   return NULL;
+}
+
+void
+ROOTDataReaderBinned::readEntry( unsigned int entry )
+{
+   if( m_useColumns ){
+
+      m_columns.copyEvent( entry, m_nPart, m_e, m_px, m_py, m_pz,
+                           m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam, m_weight );
+   }
+   else if( m_prefetcher != NULL ){
+
+      // the prefetcher reads the entries of the bin in order
+      if( !m_prefetcher->isRunning() ) m_prefetcher->start( m_entryIndex.entries() );
+
+      unsigned int read = m_prefetcher->next( m_nPart, m_e, m_px, m_py, m_pz,
+                                              m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam,
+                                              m_weight );
+      assert( read == entry );
+   }
+   else{
+
+      m_inTree->GetEntry( entry );
+      m_weight = m_eventWeight.value();
+   }
+}
+
+unsigned int ROOTDataReaderBinned::numEvents() const
+{
+   return m_entryIndex.size();
+}
@@ -0,0 +1,108 @@
+#if !defined(ROOTDATAREADERBINNED)
+#define ROOTDATAREADERBINNED
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEntryIndex.h"
+
+#include "TString.h"
+#include "TFile.h"
+#include "TTree.h"
+
+#include <string>
+
+using namespace std;
+
+class ROOTDataReaderBinned : public UserDataReader< ROOTDataReaderBinned >
+{
+
+public:
+
+  /**
+   * Default constructor for ROOTDataReaderBinned
+   */
+  ROOTDataReaderBinned() : UserDataReader< ROOTDataReaderBinned >(), m_inFile( NULL ), m_prefetcher( NULL ) { }
+
+  ~ROOTDataReaderBinned();
+
+  /**
+   * Constructor for ROOTDataReaderBinned
+   *
+   * Reads one bin of the mass of the final state (without the recoil,
+   * which is the first particle) directly from the full file, with the
+   * same bins as split_mass:
+   *
+   *   file lowMass highMass nBins bin [tree]
+   *
+   * Without split_mass, bin-by-bin fits no longer need a copy of every
+   * file per bin.  The entries of each bin are found in a single pass
+   * over the tree.  With index=<base> the entries of bin i are kept in
+   * <base>_<i>.idx:  the first reader to need an index writes it for all
+   * bins, and the fits of the other bins read theirs without a pass over
+   * the file.  maxevents=<n> only considers the first n entries (like
+   * maxEvents of split_mass).  shm=1 (with shmdir=<dir>), async=1 and
+   * weight=<expression> are as for ROOTDataReaderWithTCut.
+   *
+   * \param[in] args vector of string arguments
+   */
+  ROOTDataReaderBinned( const vector< string >& args );
+
+  string name() const { return "ROOTDataReaderBinned"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  /**
+   * This function returns a true if the file was open
+   * with weight-reading enabled and had this tree branch,
+   * false, if these criteria are not met.
+   */
+  virtual bool hasWeight(){ return m_useWeight; };
+  virtual unsigned int numEvents() const;
+
+private:
+
+  // the entries of all bins in one pass; the index of this bin is kept
+  void selectEntries( const string& indexBase, unsigned int maxEvents );
+
+  // read an entry into the branch buffers, from the shared columns
+  // if the reader was constructed with shm=1 or from the background
+  // thread if it was constructed with async=1
+  void readEntry( unsigned int entry );
+
+  // the key of the index of a bin
+  string indexKey( int bin, unsigned int maxEvents ) const;
+
+  TFile* m_inFile;
+  TTree* m_inTree;
+  unsigned int m_eventCounter;
+  bool m_useWeight;
+  ROOTDataEntryIndex m_entryIndex;
+
+  double m_lowMass, m_highMass;
+  int m_numBins, m_bin;
+
+  int m_nPart;
+  float m_e[Kinematics::kMaxParticles];
+  float m_px[Kinematics::kMaxParticles];
+  float m_py[Kinematics::kMaxParticles];
+  float m_pz[Kinematics::kMaxParticles];
+  float m_eBeam;
+  float m_pxBeam;
+  float m_pyBeam;
+  float m_pzBeam;
+  float m_weight;
+
+  // the particles of the last event, kept between events
+  vector< TLorentzVector > m_particleList;
+
+  bool m_useColumns;
+  ROOTDataColumns m_columns;
+  ROOTDataPrefetcher* m_prefetcher;
+  ROOTDataWeight m_eventWeight;
+};
+
+#endif
@@ -4,10 +4,14 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <map>
+#include <algorithm>
 
 #include "TLorentzVector.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
 #include "IUAmpTools/Kinematics.h"
 
 #include "TH1.h"
@@ -19,7 +23,10 @@ using namespace std;
 ROOTDataReaderBootstrap::ROOTDataReaderBootstrap( const vector< string >& args ):
 UserDataReader< ROOTDataReaderBootstrap >( args ),
 m_eventCounter( 0 ),
-m_useWeight( false )
+m_useWeight( false ),
+m_weighted( false ),
+m_useColumns( false ),
+m_prefetcher( NULL )
 {
   
   // arguments:
@@ -27,15 +34,53 @@ m_useWeight( false )
   // 1:  random seed
   // 2:  tree name (optional; deafult: "kin")
   
-  assert( args.size() == 3 || args.size() == 2 );
+  vector< string > posArgs;
+  map< string, string > options;
+  splitReaderArgs( args, posArgs, options );
+
+  assert( posArgs.size() == 3 || posArgs.size() == 2 );
+
+  string shmDir = "/dev/shm";
+  bool async = false;
+  string weightExpression;
+
+  for( map< string, string >::const_iterator opt = options.begin();
+       opt != options.end(); ++opt ){
+
+    if( opt->first == "weighted" ){
+
+      m_weighted = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "shm" ){
+
+      m_useColumns = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "shmdir" ){
+
+      shmDir = opt->second;
+    }
+    else if( opt->first == "async" ){
+
+      async = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "weight" ){
+
+      weightExpression = opt->second;
+    }
+    else{
+
+      cout << "ROOTDataReaderBootstrap ERROR:  unknown option " << opt->first << endl;
+      assert( false );
+    }
+  }
   
   TH1::AddDirectory( kFALSE );
   
   //this way of opening files works with URLs of the form
   // root://xrootdserver/path/to/myfile.root
-  m_inFile = TFile::Open( args[0].c_str() );
+  m_inFile = TFile::Open( posArgs[0].c_str() );
   
-  int seed = stoi( args[1] );
+  int seed = stoi( posArgs[1] );
   m_randGenerator = new TRandom2( seed );
   
   cout << "******************** WARNING ***********************" << endl;
@@ -48,13 +93,13 @@ m_useWeight( false )
   cout << "   Random Seed:  " << seed << endl << endl;
   
   // default to tree name of "kin" if none is provided
-  if( args.size() == 2 ){
+  if( posArgs.size() == 2 ){
     
     m_inTree = dynamic_cast<TTree*>( m_inFile->Get( "kin" ) );
   }
   else{
     
-    m_inTree = dynamic_cast<TTree*>( m_inFile->Get( args[2].c_str() ) );
+    m_inTree = dynamic_cast<TTree*>( m_inFile->Get( posArgs[2].c_str() ) );
   }
   
   m_inTree->SetBranchAddress( "NumFinalState", &m_nPart );
@@ -67,28 +112,49 @@ m_useWeight( false )
   m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
   m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
   
-  if(m_inTree->GetBranch("Weight") != NULL) {
-    
-    m_useWeight = true;
-    m_inTree->SetBranchAddress( "Weight", &m_weight );
-  }
-  else{
-    
-    m_useWeight = false;
+  if( m_useColumns ) m_columns.fillShared( m_inFile, m_inTree, true, shmDir, weightExpression );
+
+  m_useWeight = m_eventWeight.attach( m_inTree, weightExpression );
+
+  unsigned int nEvents = static_cast< unsigned int >( m_inTree->GetEntries() );
+
+  // the draws are the same as they have always been for a given seed,
+  // they are just sorted and counted afterwards
+  vector< unsigned int > draws( nEvents );
+  for( unsigned int i = 0; i < nEvents; ++i ){
+
+    draws[i] = (unsigned int)floor( m_randGenerator->Rndm()*nEvents );
   }
 
-  unsigned int nEvents = numEvents();
-  
+  sort( draws.begin(), draws.end() );
+
   for( unsigned int i = 0; i < nEvents; ++i ){
 
-    m_entryOrder.insert( (unsigned int)floor( m_randGenerator->Rndm()*nEvents ) );
+    if( m_entryOrder.empty() || m_entryOrder.back().first != draws[i] ){
+
+      m_entryOrder.push_back( pair< unsigned int, unsigned int >( draws[i], 1 ) );
+    }
+    else{
+
+      ++m_entryOrder.back().second;
+    }
   }
 
-  m_nextEntry = m_entryOrder.begin();
+  m_numEvents = ( m_weighted ? m_entryOrder.size() : nEvents );
+
+  cout << "   Distinct entries sampled:  " << m_entryOrder.size()
+       << " of " << nEvents << endl << endl;
+
+  m_nextEntry = 0;
+  m_repeatCount = 0;
+
+  if( async && !m_useColumns ) m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression );
 }
 
 ROOTDataReaderBootstrap::~ROOTDataReaderBootstrap()
 {
+  // the background thread must be done with the tree before it goes away
+  if( m_prefetcher != NULL ) delete m_prefetcher;
   if( m_inFile != NULL ) m_inFile->Close();
   if( m_randGenerator ) delete m_randGenerator;
 }
@@ -102,7 +168,9 @@ ROOTDataReaderBootstrap::resetSource()
   
   // this will cause the read to start back at event 0
   m_eventCounter = 0;
-  m_nextEntry = m_entryOrder.begin();
+  m_nextEntry = 0;
+  m_repeatCount = 0;
+  if( m_prefetcher != NULL ) m_prefetcher->stop();
 }
 
 Kinematics*
@@ -110,22 +178,31 @@ ROOTDataReaderBootstrap::getEvent()
 {
   if( m_eventCounter++ < numEvents() ){
 
-    assert( m_nextEntry != m_entryOrder.end() );
-    
-    m_inTree->GetEntry( *m_nextEntry++ );
-    assert( m_nPart < Kinematics::kMaxParticles );
-    
-    vector< TLorentzVector > particleList;
-    
-    particleList.
-    push_back( TLorentzVector( m_pxBeam, m_pyBeam, m_pzBeam, m_eBeam ) );
-    
-    for( int i = 0; i < m_nPart; ++i ){
-      
-      particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
+    assert( m_nextEntry < m_entryOrder.size() );
+
+    // the tree buffers still hold the current entry if it was drawn
+    // more than once, so only read when moving on to the next entry
+    if( m_repeatCount == 0 ){
+
+      readEntry( m_entryOrder[m_nextEntry].first );
+      assert( m_nPart < Kinematics::kMaxParticles );
     }
+
+    unsigned int multiplicity = m_entryOrder[m_nextEntry].second;
+
+    if( m_weighted || ++m_repeatCount == multiplicity ){
+
+      ++m_nextEntry;
+      m_repeatCount = 0;
+    }
+    
+    fillParticleList( m_particleList, m_nPart, m_e, m_px, m_py, m_pz,
+                      m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam );
+
+    float weight = ( m_useWeight ? m_weight : 1.0 );
+    if( m_weighted ) weight *= multiplicity;
     
-    return new Kinematics( particleList, m_useWeight ? m_weight : 1.0 );
+    return new PooledKinematics( m_particleList, weight );
   }
   else{
     
@@ -133,8 +210,38 @@ ROOTDataReaderBootstrap::getEvent()
   }
 }
 
+void
+ROOTDataReaderBootstrap::readEntry( unsigned int entry )
+{
+  if( m_useColumns ){
+
+    m_columns.copyEvent( entry, m_nPart, m_e, m_px, m_py, m_pz,
+                         m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam, m_weight );
+  }
+  else if( m_prefetcher != NULL ){
+
+    // the prefetcher reads each distinct sampled entry once, in order
+    if( !m_prefetcher->isRunning() ){
+
+    vector< unsigned int > entries( m_entryOrder.size() );
+    for( unsigned int i = 0; i < entries.size(); ++i ) entries[i] = m_entryOrder[i].first;
+    m_prefetcher->start( entries );
+    }
+
+    unsigned int read = m_prefetcher->next( m_nPart, m_e, m_px, m_py, m_pz,
+                                            m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam,
+                                            m_weight );
+    assert( read == entry );
+  }
+  else{
+
+    m_inTree->GetEntry( entry );
+    m_weight = m_eventWeight.value();
+  }
+}
+
 unsigned int
 ROOTDataReaderBootstrap::numEvents() const
 {
-  return static_cast< unsigned int >( m_inTree->GetEntries() );
+  return m_numEvents;
 }
@@ -3,6 +3,9 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
 
 #include "TString.h"
 #include "TRandom2.h"
@@ -10,7 +13,8 @@
 #include "TTree.h"
 
 #include <string>
-#include <set>
+#include <vector>
+#include <utility>
 
 using namespace std;
 
@@ -22,7 +26,7 @@ public:
   /**
    * Default constructor for ROOTDataReaderBootstrap
    */
-  ROOTDataReaderBootstrap() : UserDataReader< ROOTDataReaderBootstrap >(), m_inFile( NULL ) { }
+  ROOTDataReaderBootstrap() : UserDataReader< ROOTDataReaderBootstrap >(), m_inFile( NULL ), m_prefetcher( NULL ) { }
   
   ~ROOTDataReaderBootstrap();
   
@@ -33,6 +37,20 @@ public:
    *   0:  file name
    *   1:  random seeD
    *   2:  tree name (optional; deafult: "kin")
+   *
+   * options (key=value, after the arguments above):
+   *   weighted=1:  emit each sampled entry once with its weight scaled
+   *                by the number of times it was drawn instead of
+   *                repeating it; this gives the same likelihood with
+   *                fewer events
+   *   shm=1:       read the events from columns shared by all processes
+   *                on the node, see ROOTDataColumns; this is useful when
+   *                many bootstrap fits of the same file run at once
+   *   shmdir=<dir>:  directory for the shared columns (default: /dev/shm)
+   *   async=1:     read the sampled entries on a background thread ahead
+   *                of getEvent, see ROOTDataPrefetcher
+   *   weight=<expression>:  the weight of the events is this expression
+   *                of the branches, see ROOTDataWeight
    */
   ROOTDataReaderBootstrap( const vector< string >& args );
   
@@ -46,15 +64,21 @@ public:
    * with weight-reading enabled and had this tree branch,
    * false, if these criteria are not met.
    */
-  virtual bool hasWeight(){ return m_useWeight; };
+  virtual bool hasWeight(){ return m_useWeight || m_weighted; };
   virtual unsigned int numEvents() const;
   
 private:
+
+  // read an entry into the branch buffers, from the shared columns
+  // if the reader was constructed with shm=1 or from the background
+  // thread if it was constructed with async=1
+  void readEntry( unsigned int entry );
   
   TFile* m_inFile;
   TTree* m_inTree;
   unsigned int m_eventCounter;
   bool m_useWeight;
+  bool m_weighted;
   
   TRandom2* m_randGenerator;
   
@@ -69,8 +93,20 @@ private:
   float m_pzBeam;
   float m_weight;
 
-  multiset< unsigned int > m_entryOrder;
-  mutable multiset< unsigned int >::const_iterator m_nextEntry;
+  // the particles of the last event, kept between events
+  vector< TLorentzVector > m_particleList;
+
+  bool m_useColumns;
+  ROOTDataColumns m_columns;
+  ROOTDataPrefetcher* m_prefetcher;
+  ROOTDataWeight m_eventWeight;
+
+  // the sampled entries in increasing order, each with the number of
+  // times it was drawn, so that every entry is read from the tree once
+  vector< pair< unsigned int, unsigned int > > m_entryOrder;
+  unsigned int m_nextEntry;
+  unsigned int m_repeatCount;
+  unsigned int m_numEvents;
 };
 
 #endif
@@ -0,0 +1,199 @@
+
+#include <vector>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <map>
+
+#include "TLorentzVector.h"
+#include "TH1.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+#include "TLeaf.h"
+#include "TBranch.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReaderFlat.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+#include "IUAmpTools/Kinematics.h"
+
+using namespace std;
+
+ROOTDataReaderFlat::ROOTDataReaderFlat( const vector< string >& args ):
+  UserDataReader< ROOTDataReaderFlat >( args ),
+  m_eventCounter( 0 ),
+  m_numParticles( 0 ),
+  m_useWeight( false )
+{
+  TH1::AddDirectory( kFALSE );
+
+  vector< string > posArgs;
+  map< string, string > options;
+  splitReaderArgs( args, posArgs, options );
+
+  assert( posArgs.size() == 3 );
+
+  string suffix = "_p4_kin";
+  string cutExpression;
+  string weightExpression;
+
+  for( map< string, string >::const_iterator opt = options.begin();
+       opt != options.end(); ++opt ){
+
+    if( opt->first == "p4" ){
+
+      suffix = opt->second;
+    }
+    else if( opt->first == "cut" ){
+
+      cutExpression = opt->second;
+    }
+    else if( opt->first == "weight" ){
+
+      weightExpression = opt->second;
+    }
+    else{
+
+      cout << "ROOTDataReaderFlat ERROR:  unknown option " << opt->first << endl;
+      assert( false );
+    }
+  }
+
+  vector< string > branches;
+  istringstream particleMap( posArgs[2] );
+  string particle;
+  while( getline( particleMap, particle, ',' ) )
+    if( particle != "" ) branches.push_back( particle + suffix );
+
+  m_numParticles = branches.size();
+  assert( m_numParticles >= 2 && m_numParticles <= Kinematics::kMaxParticles );
+
+  //this way of opening files works with URLs of the form
+  // root://xrootdserver/path/to/myfile.root
+  TFile* inFile = TFile::Open( posArgs[0].c_str() );
+  TTree* inTree = ( inFile != NULL && !inFile->IsZombie() ?
+                    dynamic_cast< TTree* >( inFile->Get( posArgs[1].c_str() ) ) : NULL );
+  if( inTree == NULL ){
+
+    cout << "ROOTDataReaderFlat ERROR:  cannot read the tree " << posArgs[1]
+         << " of " << posArgs[0] << endl;
+    assert( false );
+  }
+
+  for( int i = 0; i < m_numParticles; ++i ){
+
+    if( inTree->GetBranch( branches[i].c_str() ) == NULL ){
+
+      cout << "ROOTDataReaderFlat ERROR:  " << posArgs[1] << " has no branch "
+           << branches[i] << endl;
+      assert( false );
+    }
+  }
+
+  // the formulas must go before the tree does
+  ROOTDataWeight* weight = new ROOTDataWeight();
+  m_useWeight = weight->attach( inTree, weightExpression );
+
+  TTreeFormula* cut = NULL;
+  if( cutExpression != "" ){
+
+    cut = new TTreeFormula( "cut", cutExpression.c_str(), inTree );
+    if( cut->GetNdim() == 0 ){
+
+      cout << "ROOTDataReaderFlat ERROR:  cannot evaluate the cut " << cutExpression
+           << " on " << posArgs[1] << endl;
+      assert( false );
+    }
+  }
+
+  // only decompress the particles, the weight and the leaves of the cut
+  inTree->SetBranchStatus( "*", 0 );
+  for( int i = 0; i < m_numParticles; ++i )
+    inTree->SetBranchStatus( ( branches[i] + "*" ).c_str(), 1 );
+  if( m_useWeight ) weight->enableBranches( inTree );
+  for( int i = 0; cut != NULL && i < cut->GetNcodes(); ++i ){
+
+    TLeaf* leaf = cut->GetLeaf( i );
+    if( leaf != NULL ) inTree->SetBranchStatus( leaf->GetBranch()->GetName(), 1 );
+  }
+
+  inTree->SetCacheSize( 100000000 );
+  inTree->AddBranchToCache( "*", kTRUE );
+  inTree->StopCacheLearningPhase();
+
+  vector< TLorentzVector* > p4( m_numParticles, (TLorentzVector*)NULL );
+  for( int i = 0; i < m_numParticles; ++i )
+    inTree->SetBranchAddress( branches[i].c_str(), &( p4[i] ) );
+
+  Long64_t nEntries = inTree->GetEntries();
+  for( Long64_t entry = 0; entry < nEntries; ++entry ){
+
+    // the cut reads its own leaves, so the particles of entries that
+    // fail it are not read
+    inTree->LoadTree( entry );
+    if( cut != NULL && cut->EvalInstance() == 0 ) continue;
+
+    inTree->GetEntry( entry );
+
+    for( int i = 0; i < m_numParticles; ++i ){
+
+      m_p4.push_back( p4[i]->E() );
+      m_p4.push_back( p4[i]->Px() );
+      m_p4.push_back( p4[i]->Py() );
+      m_p4.push_back( p4[i]->Pz() );
+    }
+
+    if( m_useWeight ) m_weight.push_back( weight->value() );
+  }
+
+  if( cut != NULL ) delete cut;
+  delete weight;
+
+  // the objects of the branches are owned by the reader
+  inTree->ResetBranchAddresses();
+  for( int i = 0; i < m_numParticles; ++i ) delete p4[i];
+
+  cout << "ROOTDataReaderFlat:  loaded " << numEvents() << " of " << nEntries
+       << " events from " << posArgs[1] << " in " << posArgs[0] << endl;
+
+  inFile->Close();
+  delete inFile;
+}
+
+void
+ROOTDataReaderFlat::resetSource()
+{
+  // this will cause the read to start back at event 0
+  m_eventCounter = 0;
+}
+
+Kinematics*
+ROOTDataReaderFlat::getEvent()
+{
+  if( m_eventCounter < numEvents() ){
+
+    // m_particleList keeps its capacity between calls
+    m_particleList.resize( m_numParticles );
+
+    const float* values = &( m_p4[4 * m_numParticles * m_eventCounter] );
+    for( int i = 0; i < m_numParticles; ++i, values += 4 )
+      m_particleList[i].SetPxPyPzE( values[1], values[2], values[3], values[0] );
+
+    float weight = ( m_useWeight ? m_weight[m_eventCounter] : 1.0 );
+    ++m_eventCounter;
+
+    return new PooledKinematics( m_particleList, weight );
+  }
+  else{
+
+    return NULL;
+  }
+}
+
+unsigned int
+ROOTDataReaderFlat::numEvents() const
+{
+  return ( m_numParticles > 0 ? m_p4.size() / ( 4 * m_numParticles ) : 0 );
+}
@@ -0,0 +1,79 @@
+#if !defined(ROOTDATAREADERFLAT)
+#define ROOTDATAREADERFLAT
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+#include "TLorentzVector.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * This class reads the flat trees of the GlueX analysis (e.g., written by
+ * a DSelector), which hold one TLorentzVector branch per particle, such
+ * as beam_p4_kin, p_p4_kin, pip_p4_kin, instead of the "kin" layout of
+ * ROOTDataReader.  The particles of the Kinematics are the branches
+ * named in a particle map, so the trees can be fit without converting
+ * them first.  Only the branches of the particles, the cut and the
+ * weight are enabled, so the other branches of the tree are never
+ * decompressed.
+ *
+ * The events that pass the cut are read when the reader is constructed.
+ */
+
+class ROOTDataReaderFlat : public UserDataReader< ROOTDataReaderFlat >
+{
+
+public:
+
+  /**
+   * Default constructor for ROOTDataReaderFlat
+   */
+  ROOTDataReaderFlat() : UserDataReader< ROOTDataReaderFlat >(),
+    m_eventCounter( 0 ), m_numParticles( 0 ), m_useWeight( false ) { }
+
+  /**
+   * Constructor for ROOTDataReaderFlat
+   * \param[in] args vector of string arguments
+   * arguments:
+   *   0:  file name
+   *   1:  tree name
+   *   2:  particle map, the particles in the order of the Kinematics
+   *       with the beam first, e.g., beam,p,pip,pim for the branches
+   *       beam_p4_kin, p_p4_kin, pip_p4_kin, pim_p4_kin
+   * options (optional, in any order after the particle map):
+   *   p4=<suffix>  the suffix of the particle branches (default: _p4_kin;
+   *           e.g., _p4_meas for the measured four-vectors)
+   *   cut=<expression>  only the entries for which this expression of the
+   *           branches is not zero are read, e.g., cut=accidweight>0
+   *   weight=<expression>  the weight of the events, e.g., accidweight
+   *           (default: the Weight branch if the tree has one, see
+   *           ROOTDataWeight)
+   */
+  ROOTDataReaderFlat( const vector< string >& args );
+
+  string name() const { return "ROOTDataReaderFlat"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight(){ return m_useWeight; };
+  virtual unsigned int numEvents() const;
+
+private:
+
+  unsigned int m_eventCounter;
+  int m_numParticles;
+  bool m_useWeight;
+
+  // ( E, px, py, pz ) of each particle of each event, event by event
+  vector< float > m_p4;
+  vector< float > m_weight;
+
+  vector< TLorentzVector > m_particleList;
+};
+
+#endif
@@ -0,0 +1,324 @@
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <cmath>
+#include <algorithm>
+
+#include "TLorentzVector.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReaderGrid.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
+#include "IUAmpTools/Kinematics.h"
+
+using namespace std;
+
+namespace {
+
+  const char* kVariableName[] = { "mass", "costheta", "phi", "Phi" };
+
+  // the sources of setUnbinned are known by their arguments
+  string sourceKey( const vector< string >& args ){
+
+    string key;
+    for( unsigned int i = 0; i < args.size(); ++i ) key += args[i] + " ";
+    return key;
+  }
+
+  void fourVector( const TLorentzVector& p, GDouble* v ){
+
+    v[0] = p.E(); v[1] = p.Px(); v[2] = p.Py(); v[3] = p.Pz();
+  }
+
+  // the sums of a bin over its events, then the event nearest their mean
+  struct GridBin {
+
+    GridBin() : weight( 0 ), count( 0 ), distance( 0 ), event( NULL ) {
+      for( int i = 0; i < 4; ++i ) sum[i] = 0;
+    }
+
+    double weight;
+    double count;
+    double sum[4];
+    double distance;
+    Kinematics* event;
+  };
+}
+
+vector< ROOTDataReaderGrid::Axis >&
+ROOTDataReaderGrid::grid(){
+
+  static vector< Axis > axes;
+  return axes;
+}
+
+set< string >&
+ROOTDataReaderGrid::unbinned(){
+
+  static set< string > sources;
+  return sources;
+}
+
+bool
+ROOTDataReaderGrid::setGrid( const string& spec ){
+
+  vector< Axis > axes;
+
+  stringstream list( spec );
+  string item;
+  while( getline( list, item, ',' ) ){
+
+    if( item.size() == 0 ) continue;
+
+    vector< string > fields;
+    stringstream fieldList( item );
+    string field;
+    while( getline( fieldList, field, ':' ) ) fields.push_back( field );
+
+    Axis axis;
+    axis.variable = kNumVariables;
+    for( int v = 0; v < kNumVariables; ++v )
+      if( fields[0] == kVariableName[v] ) axis.variable = v;
+
+    if( axis.variable == kNumVariables || ( fields.size() != 2 && fields.size() != 4 ) ||
+        ( fields.size() == 4 && axis.variable != kMass ) ){
+
+      cout << "ROOTDataReaderGrid ERROR:  cannot read " << item << " of the grid " << spec
+           << ", use <variable>:<bins> with mass, costheta, phi or Phi" << endl;
+      return false;
+    }
+
+    for( unsigned int i = 0; i < axes.size(); ++i ){
+
+      if( axes[i].variable == axis.variable ){
+
+        cout << "ROOTDataReaderGrid ERROR:  " << fields[0] << " is in the grid twice" << endl;
+        return false;
+      }
+    }
+
+    axis.nBins = atoi( fields[1].c_str() );
+    if( axis.nBins < 1 ){
+
+      cout << "ROOTDataReaderGrid ERROR:  " << fields[0] << " needs at least one bin" << endl;
+      return false;
+    }
+
+    // the mass without a range takes that of the source
+    axis.low = 0;
+    axis.high = 0;
+    if( axis.variable == kCosTheta ){ axis.low = -1; axis.high = 1; }
+    if( axis.variable == kPhi || axis.variable == kPolPhi ){ axis.low = -M_PI; axis.high = M_PI; }
+    if( fields.size() == 4 ){
+
+      axis.low = atof( fields[2].c_str() );
+      axis.high = atof( fields[3].c_str() );
+      if( !( axis.high > axis.low ) ){
+
+        cout << "ROOTDataReaderGrid ERROR:  the mass range of " << item << " is empty" << endl;
+        return false;
+      }
+    }
+
+    axes.push_back( axis );
+  }
+
+  grid() = axes;
+  return true;
+}
+
+void
+ROOTDataReaderGrid::setUnbinned( const vector< string >& args ){
+
+  unbinned().insert( sourceKey( args ) );
+}
+
+void
+ROOTDataReaderGrid::variables( const Kinematics* kin, double* values ){
+
+  const vector< TLorentzVector >& particles = kin->particleList();
+
+  GDouble beam[4], recoil[4], p1[4], p2[4];
+  fourVector( particles[0], beam );
+  fourVector( particles[1], recoil );
+
+  TLorentzVector rest;
+  for( unsigned int i = 3; i < particles.size(); ++i ) rest += particles[i];
+
+  values[kMass] = ( particles.size() > 2 ? ( particles[2] + rest ).M() : 0 );
+  values[kCosTheta] = 0;
+  values[kPhi] = 0;
+  values[kPolPhi] = polarizationAngle( beam, recoil, 1.0, 0.0 );
+
+  if( particles.size() > 3 ){
+
+    fourVector( particles[2], p1 );
+    fourVector( rest, p2 );
+
+    GDouble cosTheta, phi;
+    twoBodyAngles( kHelicityLabNormal, beam, recoil, p1, p2, cosTheta, phi );
+    values[kCosTheta] = cosTheta;
+    values[kPhi] = phi;
+  }
+}
+
+ROOTDataReaderGrid::ROOTDataReaderGrid( const vector< string >& args ):
+  UserDataReader< ROOTDataReaderGrid >( args ),
+  m_reader( new ROOTDataReader( args ) ),
+  m_next( 0 ),
+  m_hasWeight( false )
+{
+  vector< Axis > axes = grid();
+  if( axes.size() == 0 || unbinned().count( sourceKey( args ) ) != 0 ) return;
+
+  double values[kNumVariables];
+  Kinematics* kin;
+
+  // the range of the mass from the events if it has none
+  for( unsigned int a = 0; a < axes.size(); ++a ){
+
+    if( axes[a].high > axes[a].low ) continue;
+
+    double low = 0, high = 0;
+    bool first = true;
+
+    m_reader->resetSource();
+    while( ( kin = m_reader->getEvent() ) != NULL ){
+
+      variables( kin, values );
+      delete kin;
+
+      double x = values[axes[a].variable];
+      low = ( first ? x : min( low, x ) );
+      high = ( first ? x : max( high, x ) );
+      first = false;
+    }
+
+    // the largest mass falls in the last bin
+    axes[a].low = low;
+    axes[a].high = ( high > low ? high + 1e-9 * ( high - low ) : low + 1 );
+  }
+
+  // the bin of an event and its place in the bin in units of the bin widths
+  struct Locator {
+
+    const vector< Axis >& axes;
+
+    Locator( const vector< Axis >& a ) : axes( a ) {}
+
+    unsigned long bin( const double* values, double* position ) const {
+
+      unsigned long index = 0;
+      for( unsigned int a = 0; a < axes.size(); ++a ){
+
+        const Axis& axis = axes[a];
+        position[a] = ( values[axis.variable] - axis.low ) / ( axis.high - axis.low ) * axis.nBins;
+        int b = min( axis.nBins - 1, max( 0, (int)floor( position[a] ) ) );
+        index = index * axis.nBins + b;
+      }
+      return index;
+    }
+  };
+
+  Locator locator( axes );
+  map< unsigned long, GridBin > bins;
+  double position[4];
+  unsigned long numRead = 0;
+
+  // the weights of the bins and the sums of the places of their events
+  m_reader->resetSource();
+  while( ( kin = m_reader->getEvent() ) != NULL ){
+
+    variables( kin, values );
+    double w = kin->weight();
+    delete kin;
+
+    GridBin& bin = bins[locator.bin( values, position )];
+    bin.weight += w;
+    bin.count += 1;
+    for( unsigned int a = 0; a < axes.size(); ++a ) bin.sum[a] += position[a];
+    ++numRead;
+  }
+
+  // the mean of the positions, so that weights of both signs (e.g., of a
+  // sideband subtraction) do not move it out of the bin
+  for( map< unsigned long, GridBin >::iterator bin = bins.begin(); bin != bins.end(); ++bin )
+    for( unsigned int a = 0; a < axes.size(); ++a ) bin->second.sum[a] /= bin->second.count;
+
+  // the event nearest the mean of every bin
+  m_reader->resetSource();
+  while( ( kin = m_reader->getEvent() ) != NULL ){
+
+    variables( kin, values );
+    GridBin& bin = bins[locator.bin( values, position )];
+
+    double distance = 0;
+    for( unsigned int a = 0; a < axes.size(); ++a )
+      distance += ( position[a] - bin.sum[a] ) * ( position[a] - bin.sum[a] );
+
+    if( bin.event == NULL || distance < bin.distance ){
+
+      delete bin.event;
+      bin.event = new Kinematics( kin->particleList(), bin.weight );
+      bin.distance = distance;
+    }
+    delete kin;
+  }
+
+  // bins whose weights cancel add nothing to the likelihood
+  for( map< unsigned long, GridBin >::iterator bin = bins.begin(); bin != bins.end(); ++bin ){
+
+    if( bin->second.weight != 0 ) m_events.push_back( bin->second.event );
+    else delete bin->second.event;
+  }
+
+  m_hasWeight = true;
+
+  delete m_reader;
+  m_reader = NULL;
+
+  cout << "ROOTDataReaderGrid:  " << numRead << " events of " << args[0] << " in "
+       << m_events.size() << " bins (" << ( numRead > 0 ? 100. * m_events.size() / numRead : 0 )
+       << "%)" << endl;
+}
+
+ROOTDataReaderGrid::~ROOTDataReaderGrid(){
+
+  delete m_reader;
+  for( unsigned int i = 0; i < m_events.size(); ++i ) delete m_events[i];
+}
+
+Kinematics*
+ROOTDataReaderGrid::getEvent(){
+
+  if( m_reader != NULL ) return m_reader->getEvent();
+
+  if( m_next >= m_events.size() ) return NULL;
+
+  const Kinematics* event = m_events[m_next++];
+  return new Kinematics( event->particleList(), event->weight() );
+}
+
+void
+ROOTDataReaderGrid::resetSource(){
+
+  if( m_reader != NULL ) m_reader->resetSource();
+  m_next = 0;
+}
+
+bool
+ROOTDataReaderGrid::hasWeight(){
+
+  return ( m_reader != NULL ? m_reader->hasWeight() : m_hasWeight );
+}
+
+unsigned int
+ROOTDataReaderGrid::numEvents() const {
+
+  return ( m_reader != NULL ? m_reader->numEvents() : m_events.size() );
+}
@@ -0,0 +1,102 @@
+#if !defined(ROOTDATAREADERGRID)
+#define ROOTDATAREADERGRID
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+#include <string>
+#include <vector>
+#include <set>
+
+using namespace std;
+
+class ROOTDataReader;
+
+/**
+ * A ROOTDataReader that returns one weighted event per bin of a grid in
+ * the mass of the final state (without the recoil, which is the first
+ * particle) and its decay angles, instead of every event:  cosTheta and
+ * phi of the second particle in the helicity frame (see twoBodyAngles,
+ * the rest of the final state is the other daughter) and the angle Phi
+ * of the beam polarization to the production plane.  The event of a bin
+ * is the one nearest the mean of the grid variables of its events, with
+ * the sum of the weights of the bin as its weight, so the likelihood
+ * sum over the data and the integral over the accepted MC become sums
+ * over the bins that are not empty, with the amplitudes of the mean of
+ * each bin in place of their mean over it.  For very large samples this
+ * is the binned extended likelihood of a fit with fewer events by orders
+ * of magnitude; the bias from the variation of the amplitudes within the
+ * bins shrinks with their size (see fit --binned-check).
+ *
+ * The reader has the name ROOTDataReader and takes its arguments, so it
+ * replaces ROOTDataReader without changes to the configuration file when
+ * it is registered after it.  The grid is set for all readers with
+ * setGrid; without one, or for a source passed to setUnbinned (e.g., the
+ * generated MC, which only normalizes the fit fractions), the events are
+ * returned as they are read.
+ */
+
+class ROOTDataReaderGrid : public UserDataReader< ROOTDataReaderGrid >
+{
+
+public:
+
+  ROOTDataReaderGrid() : UserDataReader< ROOTDataReaderGrid >(), m_reader( NULL ), m_next( 0 ),
+    m_hasWeight( false ) { }
+
+  ~ROOTDataReaderGrid();
+
+  /**
+   * The arguments of ROOTDataReader.
+   */
+  ROOTDataReaderGrid( const vector< string >& args );
+
+  string name() const { return "ROOTDataReader"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight();
+  virtual unsigned int numEvents() const;
+
+  /**
+   * The grid of the readers constructed from now on, a comma-separated
+   * list of variable:bins, e.g., mass:40,costheta:20,phi:20,Phi:10.  The
+   * variables are mass, costheta, phi and Phi, in any order and each at
+   * most once; the mass may be given a range as mass:bins:low:high, else
+   * the range of the events of the source is used.  An empty spec turns
+   * the binning off.  Returns false if spec cannot be read.
+   */
+  static bool setGrid( const string& spec );
+
+  // the readers of this source (the arguments of the reader) read all events
+  static void setUnbinned( const vector< string >& args );
+
+private:
+
+  enum { kMass = 0, kCosTheta, kPhi, kPolPhi, kNumVariables };
+
+  struct Axis {
+
+    int variable;
+    int nBins;
+    double low;
+    double high;
+  };
+
+  static vector< Axis >& grid();
+  static set< string >& unbinned();
+
+  // the grid variables of an event, by variable
+  static void variables( const Kinematics* kin, double* values );
+
+  // the reader of a source that is not binned
+  ROOTDataReader* m_reader;
+
+  // the event of every bin that is not empty
+  vector< Kinematics* > m_events;
+  unsigned int m_next;
+  bool m_hasWeight;
+};
+
+#endif
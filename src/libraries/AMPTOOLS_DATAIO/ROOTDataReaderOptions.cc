@@ -0,0 +1,111 @@
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include <glob.h>
+
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+
+using namespace std;
+
+void
+splitReaderArgs( const vector< string >& args,
+                 vector< string >& positional,
+                 map< string, string >& options )
+{
+  positional.clear();
+  options.clear();
+
+  for( unsigned int i = 0; i < args.size(); ++i ){
+
+    // the file name is always positional, even if it contains '='
+    size_t eqPos = args[i].find( '=' );
+    if( i == 0 || eqPos == string::npos ){
+
+      positional.push_back( args[i] );
+    }
+    else{
+
+      options[args[i].substr( 0, eqPos )] = args[i].substr( eqPos + 1 );
+    }
+  }
+}
+
+bool
+readerOptionIsTrue( const string& value )
+{
+  return ( value == "1" || value == "true" || value == "yes" );
+}
+
+namespace {
+
+  // a name with glob characters, other than in a URL, is a pattern
+  void addSourceFiles( const string& name, vector< string >& files )
+  {
+    if( name.find( "://" ) != string::npos ||
+        name.find_first_of( "*?[" ) == string::npos ){
+
+      files.push_back( name );
+      return;
+    }
+
+    glob_t matches;
+    if( glob( name.c_str(), 0, NULL, &matches ) == 0 ){
+
+      vector< string > found( matches.gl_pathv, matches.gl_pathv + matches.gl_pathc );
+      sort( found.begin(), found.end() );
+      files.insert( files.end(), found.begin(), found.end() );
+    }
+    globfree( &matches );
+  }
+}
+
+vector< string >
+readerSourceFiles( const string& source )
+{
+  vector< string > files;
+
+  if( source.size() > 1 && source[0] == '@' ){
+
+    ifstream list( source.substr( 1 ).c_str() );
+    string line;
+    while( getline( list, line ) ){
+
+      size_t begin = line.find_first_not_of( " \t" );
+      if( begin == string::npos || line[begin] == '#' ) continue;
+      size_t end = line.find_last_not_of( " \t\r" );
+      addSourceFiles( line.substr( begin, end - begin + 1 ), files );
+    }
+
+    return files;
+  }
+
+  size_t begin = 0;
+  while( begin <= source.size() ){
+
+    size_t end = source.find( ',', begin );
+    if( end == string::npos ) end = source.size();
+    if( end > begin ) addSourceFiles( source.substr( begin, end - begin ), files );
+    begin = end + 1;
+  }
+
+  return files;
+}
+
+bool
+readerSliceRange( const string& value, unsigned int numEntries,
+                  unsigned int& first, unsigned int& last )
+{
+  unsigned int slice, numSlices;
+  char end;
+  if( sscanf( value.c_str(), "%u/%u%c", &slice, &numSlices, &end ) != 2 ||
+      numSlices == 0 || slice >= numSlices ) return false;
+
+  first = (unsigned long long)numEntries * slice / numSlices;
+  last = (unsigned long long)numEntries * ( slice + 1 ) / numSlices;
+  return true;
+}
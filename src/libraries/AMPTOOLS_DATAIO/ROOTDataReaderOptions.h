@@ -0,0 +1,59 @@
+#if !defined(ROOTDATAREADEROPTIONS)
+#define ROOTDATAREADEROPTIONS
+
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+/**
+ * The ROOT data readers take their positional arguments (file name,
+ * cut values, tree name, ...) first, optionally followed by options
+ * of the form key=value in any order.  This function separates the two
+ * so that each reader can keep checking the number of positional
+ * arguments as before.
+ *
+ * \param[in] args the full argument list passed to the reader
+ * \param[out] positional the arguments that do not contain '='
+ * \param[out] options map of key to value for all key=value arguments
+ */
+
+void splitReaderArgs( const vector< string >& args,
+                      vector< string >& positional,
+                      map< string, string >& options );
+
+/**
+ * Returns true if a option value is "1", "true", or "yes".
+ */
+
+bool readerOptionIsTrue( const string& value );
+
+/**
+ * The files of the source named by the first argument of a reader:
+ *
+ *   a single file name or URL
+ *   file1.root,file2.root,...  the files in this order
+ *   runs/tree_*.root           the files that match the pattern, sorted
+ *   @samples.list              the files listed one per line in a text
+ *                              file (blank lines and lines starting with
+ *                              '#' are skipped); each line may itself be
+ *                              a pattern
+ *
+ * Patterns are expanded for local files only.  Returns no files if a
+ * pattern has no match or a list cannot be read.
+ */
+
+vector< string > readerSourceFiles( const string& source );
+
+/**
+ * The entries [first, last) of the slice i of n of numEntries entries,
+ * given by a option value "i/n" (e.g., slice=2/8); the slices of a
+ * source cover it once and differ in size by at most one entry.
+ * Returns false if the value is not of this form or i is not below n.
+ */
+
+bool readerSliceRange( const string& value, unsigned int numEntries,
+                       unsigned int& first, unsigned int& last );
+
+#endif
@@ -0,0 +1,439 @@
+
+#include <vector>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+
+#include "TLorentzVector.h"
+#include "TRandom2.h"
+#include "TTreeFormula.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReaderPipeline.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "TH1.h"
+#include "TFile.h"
+#include "TTree.h"
+
+using namespace std;
+
+ROOTDataReaderPipeline::ROOTDataReaderPipeline( const vector< string >& args ):
+  UserDataReader< ROOTDataReaderPipeline >( args ),
+  m_eventCounter( 0 ),
+  m_useWeight( false ),
+  m_weighted( false ),
+  m_scale( 1 ),
+  m_recoil( 1, 0 ),
+  m_useColumns( false ),
+  m_prefetcher( NULL ),
+  m_nextEntry( 0 ),
+  m_repeatCount( 0 ),
+  m_numEvents( 0 )
+{
+  vector< string > posArgs;
+  map< string, string > options;
+  splitReaderArgs( args, posArgs, options );
+
+  assert( posArgs.size() == 2 || posArgs.size() == 1 );
+
+  string indexFile;
+  string shmDir = "/dev/shm";
+  bool async = false;
+  string weightExpression;
+  bool bootstrap = false;
+  int seed = 0;
+
+  for( map< string, string >::const_iterator opt = options.begin();
+       opt != options.end(); ++opt ){
+
+    Range range;
+    bool isRange = true;
+
+    if( opt->first == "t" ) range.quantity = Range::kT;
+    else if( opt->first == "E" ) range.quantity = Range::kBeamEnergy;
+    else if( opt->first == "mass" ) range.quantity = Range::kMass;
+    else isRange = false;
+
+    if( isRange ){
+
+      if( !parseRange( opt->second, range.min, range.max ) ){
+
+        cout << "ROOTDataReaderPipeline ERROR:  " << opt->first << "=" << opt->second
+             << " is not of the form <min>:<max>" << endl;
+        assert( false );
+      }
+
+      m_ranges.push_back( range );
+    }
+    else if( opt->first == "recoil" ){
+
+      m_recoil = parseIndices( opt->second );
+    }
+    else if( opt->first == "system" ){
+
+      m_system = parseIndices( opt->second );
+    }
+    else if( opt->first == "cut" ){
+
+      m_cutExpression = opt->second;
+    }
+    else if( opt->first == "index" ){
+
+      indexFile = opt->second;
+    }
+    else if( opt->first == "bootstrap" ){
+
+      bootstrap = true;
+      seed = atoi( opt->second.c_str() );
+    }
+    else if( opt->first == "weighted" ){
+
+      m_weighted = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "weight" ){
+
+      weightExpression = opt->second;
+    }
+    else if( opt->first == "scale" ){
+
+      m_scale = atof( opt->second.c_str() );
+    }
+    else if( opt->first == "shm" ){
+
+      m_useColumns = readerOptionIsTrue( opt->second );
+    }
+    else if( opt->first == "shmdir" ){
+
+      shmDir = opt->second;
+    }
+    else if( opt->first == "async" ){
+
+      async = readerOptionIsTrue( opt->second );
+    }
+    else{
+
+      cout << "ROOTDataReaderPipeline ERROR:  unknown option " << opt->first << endl;
+      assert( false );
+    }
+  }
+
+  // the ranges are checked in order, so the cheapest go first
+  sort( m_ranges.begin(), m_ranges.end(),
+        []( const Range& a, const Range& b ){ return a.quantity < b.quantity; } );
+  m_weighted = m_weighted && bootstrap;
+
+  TH1::AddDirectory( kFALSE );
+
+  //this way of opening files works with URLs of the form
+  // root://xrootdserver/path/to/myfile.root
+  m_inFile = TFile::Open( posArgs[0].c_str() );
+
+  // default to tree name of "kin" if none is provided
+  string treeName = ( posArgs.size() == 2 ? posArgs[1] : "kin" );
+  m_inTree = dynamic_cast<TTree*>( m_inFile->Get( treeName.c_str() ) );
+
+  m_inTree->SetBranchAddress( "NumFinalState", &m_nPart );
+  m_inTree->SetBranchAddress( "E_FinalState", m_e );
+  m_inTree->SetBranchAddress( "Px_FinalState", m_px );
+  m_inTree->SetBranchAddress( "Py_FinalState", m_py );
+  m_inTree->SetBranchAddress( "Pz_FinalState", m_pz );
+  m_inTree->SetBranchAddress( "E_Beam", &m_eBeam );
+  m_inTree->SetBranchAddress( "Px_Beam", &m_pxBeam );
+  m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
+  m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
+
+  if( m_useColumns ) m_columns.fillShared( m_inFile, m_inTree, true, shmDir, weightExpression );
+
+  m_useWeight = m_eventWeight.attach( m_inTree, weightExpression );
+
+  select( indexFile );
+  resample( bootstrap ? seed : -1 );
+
+  if( async && !m_useColumns ) m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression );
+}
+
+ROOTDataReaderPipeline::~ROOTDataReaderPipeline()
+{
+  // the background thread must be done with the tree before it goes away
+  if( m_prefetcher != NULL ) delete m_prefetcher;
+  if( m_inFile != NULL ) m_inFile->Close();
+}
+
+bool
+ROOTDataReaderPipeline::parseRange( const string& value, double& min, double& max )
+{
+  char end;
+  return sscanf( value.c_str(), "%lf:%lf%c", &min, &max, &end ) == 2;
+}
+
+vector< int >
+ROOTDataReaderPipeline::parseIndices( const string& value )
+{
+  vector< int > indices;
+
+  istringstream list( value );
+  string index;
+  while( getline( list, index, ',' ) )
+    if( index != "" ) indices.push_back( atoi( index.c_str() ) );
+
+  return indices;
+}
+
+void
+ROOTDataReaderPipeline::select( const string& indexFile )
+{
+  unsigned int nEntries = static_cast< unsigned int >( m_inTree->GetEntries() );
+
+  if( m_ranges.empty() && m_cutExpression == "" ){
+
+    for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ) m_entryIndex.add( iEntry );
+    return;
+  }
+
+  // the key holds every setting of the filters
+  ostringstream stages;
+  vector< double > cuts;
+  for( unsigned int i = 0; i < m_ranges.size(); ++i ){
+
+    stages << " range" << m_ranges[i].quantity;
+    cuts.push_back( m_ranges[i].min );
+    cuts.push_back( m_ranges[i].max );
+  }
+  stages << " recoil";
+  for( unsigned int i = 0; i < m_recoil.size(); ++i ) stages << " " << m_recoil[i];
+  stages << " system";
+  for( unsigned int i = 0; i < m_system.size(); ++i ) stages << " " << m_system[i];
+  stages << " cut " << m_cutExpression;
+
+  string key = ROOTDataEntryIndex::makeKey( m_inFile, m_inTree, name() + stages.str(), cuts );
+
+  if( indexFile != "" && m_entryIndex.read( indexFile, key ) ){
+
+    cout << "ROOTDataReaderPipeline:  read " << m_entryIndex.size()
+         << " selected entries from " << indexFile << endl;
+    return;
+  }
+
+  TTreeFormula* cut = NULL;
+  if( m_cutExpression != "" ){
+
+    cut = new TTreeFormula( "cut", m_cutExpression.c_str(), m_inTree );
+    if( cut->GetNdim() == 0 ){
+
+      cout << "ROOTDataReaderPipeline ERROR:  cannot evaluate the cut "
+           << m_cutExpression << " on " << m_inTree->GetName() << endl;
+      assert( false );
+    }
+  }
+
+  for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
+
+    // the cut reads its own leaves, so the events that fail it are not
+    // read at all
+    if( cut != NULL ){
+
+      m_inTree->LoadTree( iEntry );
+      if( cut->EvalInstance() == 0 ) continue;
+    }
+
+    if( !m_ranges.empty() ){
+
+      readEntry( iEntry );
+      if( !passRanges() ) continue;
+    }
+
+    m_entryIndex.add( iEntry );
+  }
+
+  if( cut != NULL ) delete cut;
+
+  cout << "ROOTDataReaderPipeline:  selected " << m_entryIndex.size() << " of "
+       << nEntries << " events of " << m_inTree->GetName() << " in "
+       << m_inFile->GetName() << endl;
+
+  if( indexFile != "" ) m_entryIndex.write( indexFile, key );
+}
+
+void
+ROOTDataReaderPipeline::resample( int seed )
+{
+  unsigned int nSelected = m_entryIndex.size();
+  m_entryOrder.clear();
+
+  if( seed < 0 ){
+
+    for( unsigned int i = 0; i < nSelected; ++i )
+      m_entryOrder.push_back( pair< unsigned int, unsigned int >( m_entryIndex[i], 1 ) );
+
+    m_numEvents = nSelected;
+    return;
+  }
+
+  cout << "ROOTDataReaderPipeline:  bootstrap sample of the selected events"
+       << " with seed " << seed << endl;
+
+  // the same draws as ROOTDataReaderBootstrap, over the selected entries
+  TRandom2 randGenerator( seed );
+  vector< unsigned int > draws( nSelected );
+  for( unsigned int i = 0; i < nSelected; ++i )
+    draws[i] = (unsigned int)floor( randGenerator.Rndm()*nSelected );
+
+  sort( draws.begin(), draws.end() );
+
+  for( unsigned int i = 0; i < nSelected; ++i ){
+
+    unsigned int entry = m_entryIndex[draws[i]];
+    if( m_entryOrder.empty() || m_entryOrder.back().first != entry ){
+
+      m_entryOrder.push_back( pair< unsigned int, unsigned int >( entry, 1 ) );
+    }
+    else{
+
+      ++m_entryOrder.back().second;
+    }
+  }
+
+  m_numEvents = ( m_weighted ? m_entryOrder.size() : nSelected );
+
+  cout << "   Distinct entries sampled:  " << m_entryOrder.size()
+       << " of " << nSelected << endl;
+}
+
+bool
+ROOTDataReaderPipeline::passRanges() const
+{
+  assert( m_nPart < Kinematics::kMaxParticles );
+
+  TLorentzVector recoil;
+  for( unsigned int i = 0; i < m_recoil.size(); ++i ){
+
+    int j = m_recoil[i];
+    if( j < m_nPart ) recoil += TLorentzVector( m_px[j], m_py[j], m_pz[j], m_e[j] );
+  }
+
+  for( unsigned int iRange = 0; iRange < m_ranges.size(); ++iRange ){
+
+    const Range& range = m_ranges[iRange];
+    double value = 0;
+
+    if( range.quantity == Range::kBeamEnergy ){
+
+      value = m_eBeam;
+    }
+    else if( range.quantity == Range::kT ){
+
+      TLorentzVector target( 0.0, 0.0, 0.0, 0.938272 );
+      value = fabs( ( target - recoil ).M2() );
+    }
+    else{
+
+      TLorentzVector system;
+      for( int j = 0; j < m_nPart; ++j ){
+
+        bool inSystem = ( m_system.empty() ?
+                          find( m_recoil.begin(), m_recoil.end(), j ) == m_recoil.end() :
+                          find( m_system.begin(), m_system.end(), j ) != m_system.end() );
+        if( inSystem ) system += TLorentzVector( m_px[j], m_py[j], m_pz[j], m_e[j] );
+      }
+      value = system.M();
+    }
+
+    if( value < range.min || value >= range.max ) return false;
+  }
+
+  return true;
+}
+
+void
+ROOTDataReaderPipeline::resetSource()
+{
+  cout << "Resetting source " << m_inTree->GetName()
+       << " in " << m_inFile->GetName() << endl;
+
+  // this will cause the read to start back at event 0
+  m_eventCounter = 0;
+  m_nextEntry = 0;
+  m_repeatCount = 0;
+  if( m_prefetcher != NULL ) m_prefetcher->stop();
+}
+
+Kinematics*
+ROOTDataReaderPipeline::getEvent()
+{
+  if( m_eventCounter++ < numEvents() ){
+
+    assert( m_nextEntry < m_entryOrder.size() );
+
+    // the tree buffers still hold the current entry if it was drawn
+    // more than once, so only read when moving on to the next entry
+    if( m_repeatCount == 0 ){
+
+      readEntry( m_entryOrder[m_nextEntry].first );
+      assert( m_nPart < Kinematics::kMaxParticles );
+    }
+
+    unsigned int multiplicity = m_entryOrder[m_nextEntry].second;
+
+    if( m_weighted || ++m_repeatCount == multiplicity ){
+
+      ++m_nextEntry;
+      m_repeatCount = 0;
+    }
+
+    fillParticleList( m_particleList, m_nPart, m_e, m_px, m_py, m_pz,
+                      m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam );
+
+    float weight = ( m_useWeight ? m_weight : 1.0 ) * m_scale;
+    if( m_weighted ) weight *= multiplicity;
+
+    return new PooledKinematics( m_particleList, weight );
+  }
+  else{
+
+    return NULL;
+  }
+}
+
+void
+ROOTDataReaderPipeline::readEntry( unsigned int entry )
+{
+  if( m_useColumns ){
+
+    m_columns.copyEvent( entry, m_nPart, m_e, m_px, m_py, m_pz,
+                         m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam, m_weight );
+  }
+  else if( m_prefetcher != NULL ){
+
+    // the prefetcher reads each distinct entry once, in order
+    if( !m_prefetcher->isRunning() ){
+
+      vector< unsigned int > entries( m_entryOrder.size() );
+      for( unsigned int i = 0; i < entries.size(); ++i ) entries[i] = m_entryOrder[i].first;
+      m_prefetcher->start( entries );
+    }
+
+    unsigned int read = m_prefetcher->next( m_nPart, m_e, m_px, m_py, m_pz,
+                                            m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam,
+                                            m_weight );
+    assert( read == entry );
+  }
+  else{
+
+    m_inTree->GetEntry( entry );
+    m_weight = m_eventWeight.value();
+  }
+}
+
+unsigned int
+ROOTDataReaderPipeline::numEvents() const
+{
+  return m_numEvents;
+}
@@ -0,0 +1,158 @@
+#if !defined(ROOTDATAREADERPIPELINE)
+#define ROOTDATAREADERPIPELINE
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEntryIndex.h"
+
+#include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/**
+ * A reader of the "kin" layout that combines the selections of
+ * ROOTDataReaderWithTCut and ROOTDataReaderTEM, a selection by an
+ * expression, the resampling of ROOTDataReaderBootstrap and a scale of
+ * the weights, given as options, so that, e.g., bootstrap fits in narrow
+ * t bins do not need a file per bin.  The stages run in the order
+ *
+ *   source -> filters -> resampler -> weights
+ *
+ * The filters are applied in one pass over the tree when the reader is
+ * constructed; the entries that pass are kept in a ROOTDataEntryIndex,
+ * which can be saved with index=<path> so that later jobs (e.g., the
+ * other seeds of a bootstrap) skip the pass.  The resampler draws from
+ * the selected entries only, and every distinct entry is read once on
+ * each pass over the source.
+ */
+
+class ROOTDataReaderPipeline : public UserDataReader< ROOTDataReaderPipeline >
+{
+
+public:
+
+  /**
+   * Default constructor for ROOTDataReaderPipeline
+   */
+  ROOTDataReaderPipeline() : UserDataReader< ROOTDataReaderPipeline >(),
+    m_inFile( NULL ), m_prefetcher( NULL ) { }
+
+  ~ROOTDataReaderPipeline();
+
+  /**
+   * Constructor for ROOTDataReaderPipeline
+   * \param[in] args vector of string arguments
+   * arguments:
+   *   0:  file name
+   *   1:  tree name (optional; default: "kin")
+   * options (key=value, after the arguments above):
+   *   filters, all of which an event must pass:
+   *   t=<min>:<max>     -t from the target proton and the recoil
+   *   recoil=<i,...>    the final state particles of the recoil (default: 0)
+   *   E=<min>:<max>     the beam energy
+   *   mass=<min>:<max>  the mass of the system
+   *   system=<i,...>    the final state particles of the system (default:
+   *                     all but the recoil)
+   *   cut=<expression>  an expression of the branches that is not zero
+   *   index=<path>      the sidecar of the selected entries (see
+   *                     ROOTDataEntryIndex)
+   *   resampler:
+   *   bootstrap=<seed>  draw as many events as were selected, with
+   *                     replacement, as ROOTDataReaderBootstrap
+   *   weighted=1        emit each drawn entry once with its weight scaled
+   *                     by the number of draws
+   *   weights:
+   *   weight=<expression>  the weight of the events (see ROOTDataWeight)
+   *   scale=<factor>    multiply the weights by factor, e.g., -1 for a
+   *                     background sample
+   *   and shm=1, shmdir=<dir> and async=1 as for the other readers.
+   */
+  ROOTDataReaderPipeline( const vector< string >& args );
+
+  string name() const { return "ROOTDataReaderPipeline"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight(){ return m_useWeight || m_weighted || m_scale != 1; };
+  virtual unsigned int numEvents() const;
+
+private:
+
+  // a range [min, max) of one quantity of the event
+  struct Range {
+
+    // in the order of their cost
+    enum Quantity { kBeamEnergy, kT, kMass };
+
+    Quantity quantity;
+    double min;
+    double max;
+  };
+
+  static bool parseRange( const string& value, double& min, double& max );
+  static vector< int > parseIndices( const string& value );
+
+  // true if the event in the branch buffers passes the ranges
+  bool passRanges() const;
+
+  // the filters, applied in one pass over the tree
+  void select( const string& indexFile );
+  void resample( int seed );
+
+  // read an entry into the branch buffers, from the shared columns
+  // if the reader was constructed with shm=1 or from the background
+  // thread if it was constructed with async=1
+  void readEntry( unsigned int entry );
+
+  TFile* m_inFile;
+  TTree* m_inTree;
+  unsigned int m_eventCounter;
+  bool m_useWeight;
+  bool m_weighted;
+  float m_scale;
+
+  vector< Range > m_ranges;
+  vector< int > m_recoil;
+  vector< int > m_system;
+  string m_cutExpression;
+
+  int m_nPart;
+  float m_e[Kinematics::kMaxParticles];
+  float m_px[Kinematics::kMaxParticles];
+  float m_py[Kinematics::kMaxParticles];
+  float m_pz[Kinematics::kMaxParticles];
+  float m_eBeam;
+  float m_pxBeam;
+  float m_pyBeam;
+  float m_pzBeam;
+  float m_weight;
+
+  // the particles of the last event, kept between events
+  vector< TLorentzVector > m_particleList;
+
+  bool m_useColumns;
+  ROOTDataColumns m_columns;
+  ROOTDataPrefetcher* m_prefetcher;
+  ROOTDataWeight m_eventWeight;
+
+  ROOTDataEntryIndex m_entryIndex;
+
+  // the entries to read in increasing order, each with the number of
+  // times it was drawn (1 without a resampler)
+  vector< pair< unsigned int, unsigned int > > m_entryOrder;
+  unsigned int m_nextEntry;
+  unsigned int m_repeatCount;
+  unsigned int m_numEvents;
+};
+
+#endif
@@ -2,10 +2,13 @@
 #include <vector>
 #include <cassert>
 #include <iostream>
+#include <map>
 
 #include "TLorentzVector.h"
 
-#include "ROOTDataReaderTEM.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
 #include "IUAmpTools/Kinematics.h"
 
 #include "TH1.h"
@@ -17,20 +20,60 @@ using namespace std;
 ROOTDataReaderTEM::ROOTDataReaderTEM( const vector< string >& args ):
    UserDataReader< ROOTDataReaderTEM >( args ),
    m_eventCounter( 0 ),
-   m_useWeight( false )
+   m_useWeight( false ),
+   m_useColumns( false ),
+   m_prefetcher( NULL )
 {
-   assert( args.size() == 8 || args.size() == 7 ); //TEM cuts with and without special tree name
+   vector< string > posArgs;
+   map< string, string > options;
+   splitReaderArgs( args, posArgs, options );
+
+   assert( posArgs.size() == 8 || posArgs.size() == 7 ); //TEM cuts with and without special tree name
+
+   string indexFile;
+   string shmDir = "/dev/shm";
+   bool async = false;
+   string weightExpression;
+   for( map< string, string >::const_iterator opt = options.begin();
+        opt != options.end(); ++opt ){
+
+      if( opt->first == "index" ){
+
+         indexFile = opt->second;
+      }
+      else if( opt->first == "shm" ){
+
+         m_useColumns = readerOptionIsTrue( opt->second );
+      }
+      else if( opt->first == "shmdir" ){
+
+         shmDir = opt->second;
+      }
+      else if( opt->first == "async" ){
+
+         async = readerOptionIsTrue( opt->second );
+      }
+      else if( opt->first == "weight" ){
+
+         weightExpression = opt->second;
+      }
+      else{
+
+         cout << "ROOTDataReaderTEM ERROR:  unknown option " << opt->first << endl;
+         assert( false );
+      }
+   }
 
    TH1::AddDirectory( kFALSE );
 
    //this way of opening files works with URLs of the form
    // root://xrootdserver/path/to/myfile.root
-   m_inFile = TFile::Open( args[0].c_str() );
+   m_inFile = TFile::Open( posArgs[0].c_str() );
 
    // default to tree name of "kin" if none is provided
-   if( args.size() == 8 ){
+   if( posArgs.size() == 8 ){
 
-      m_inTree = dynamic_cast<TTree*>( m_inFile->Get( args[7].c_str() ) );
+      m_inTree = dynamic_cast<TTree*>( m_inFile->Get( posArgs[7].c_str() ) );
    }
    else{
 
@@ -49,47 +92,63 @@ ROOTDataReaderTEM::ROOTDataReaderTEM( const vector< string >& args ):
    m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
    m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
 
-   if(m_inTree->GetBranch("Weight") != NULL){
+   if( m_useColumns ) m_columns.fillShared( m_inFile, m_inTree, true, shmDir, weightExpression );
 
-     m_useWeight = true;
-     m_inTree->SetBranchAddress( "Weight", &m_weight );
-   }
-   else{
-     
-     m_useWeight=false;
-   }
+   m_useWeight = m_eventWeight.attach( m_inTree, weightExpression );
 
    m_RangeSpecified = false;
-   if( args.size() == 8 || args.size() == 7){
+   if( posArgs.size() == 8 || posArgs.size() == 7){
       // Set t range
-      m_tMin = atof(args[1].c_str());
-      m_tMax = atof(args[2].c_str());
-      m_EMin = atof(args[3].c_str());
-      m_EMax = atof(args[4].c_str());
-      m_MMin = atof(args[5].c_str());
-      m_MMax = atof(args[6].c_str());
+      m_tMin = atof(posArgs[1].c_str());
+      m_tMax = atof(posArgs[2].c_str());
+      m_EMin = atof(posArgs[3].c_str());
+      m_EMax = atof(posArgs[4].c_str());
+      m_MMin = atof(posArgs[5].c_str());
+      m_MMax = atof(posArgs[6].c_str());
       m_RangeSpecified = true;
 
-      m_numEvents = 0;
       cout << "*********************************************" << endl;
       cout << "ROOT Data reader  -t range specified [" << m_tMin << "," << m_tMax << ")" << endl;
       cout << "ROOT Data reader Beam E range specified [" << m_EMin << "," << m_EMax << ")" << endl;
       cout << "ROOT Data reader  Inv. Mass range specified [" << m_MMin << "," << m_MMax << ")" << endl;
       cout << "Total events: " <<  m_inTree->GetEntries() << endl;
 
-      while( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
+      vector< double > cuts;
+      cuts.push_back( m_tMin ); cuts.push_back( m_tMax );
+      cuts.push_back( m_EMin ); cuts.push_back( m_EMax );
+      cuts.push_back( m_MMin ); cuts.push_back( m_MMax );
+      string key = ROOTDataEntryIndex::makeKey( m_inFile, m_inTree, name(), cuts );
+
+      if( indexFile != "" && m_entryIndex.read( indexFile, key ) ){
 
-	 m_inTree->GetEntry( m_eventCounter++ );
-         if(checkEvent()) m_numEvents++;
+         cout << "Read selected entries from " << indexFile << endl;
+      }
+      else{
+
+         // record the entries that pass so that later passes over
+         // the source only need to read those entries
+         unsigned int nEntries = static_cast< unsigned int >( m_inTree->GetEntries() );
+         for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
 
+            readEntry( iEntry );
+            if( checkEvent() ) m_entryIndex.add( iEntry );
+         }
+
+         if( indexFile != "" ) m_entryIndex.write( indexFile, key );
       }
+
+      m_numEvents = m_entryIndex.size();
       cout << "Number of events kept    = " << m_numEvents << endl;
       cout << "*********************************************" << endl;
-   }   
+   }
+
+   if( async && !m_useColumns ) m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression );   
 }
 
 ROOTDataReaderTEM::~ROOTDataReaderTEM()
 {
+   // the background thread must be done with the tree before it goes away
+   if( m_prefetcher != NULL ) delete m_prefetcher;
    if( m_inFile != NULL ) m_inFile->Close();
 }
 
@@ -101,6 +160,7 @@ void ROOTDataReaderTEM::resetSource()
 
    // this will cause the read to start back at event 0
    m_eventCounter = 0;
+   if( m_prefetcher != NULL ) m_prefetcher->stop();
 }
 
    Kinematics*
@@ -111,24 +171,22 @@ ROOTDataReaderTEM::getEvent()
 
       if( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
          //  if( m_eventCounter < 10 ){ 
-         m_inTree->GetEntry( m_eventCounter++ );
+         readEntry( m_eventCounter++ );
          assert( m_nPart < Kinematics::kMaxParticles );
 
-         return new Kinematics( particleList(), m_useWeight ? m_weight : 1.0 );
+         return new PooledKinematics( particleList(), m_useWeight ? m_weight : 1.0 );
       }
       else return NULL;
 
    } 
    else{
 
-      while( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
+      if( m_eventCounter < m_entryIndex.size() ){
 
-	  m_inTree->GetEntry( m_eventCounter++ );
+	  readEntry( m_entryIndex[m_eventCounter++] );
 	  assert( m_nPart < Kinematics::kMaxParticles );
-	  
-	  if(checkEvent())
-		  return new Kinematics( particleList(), m_useWeight ? m_weight : 1.0 ); 
 
+	  return new PooledKinematics( particleList(), m_useWeight ? m_weight : 1.0 );
       }
       return NULL;
    }
@@ -176,6 +234,35 @@ bool ROOTDataReaderTEM::checkEvent()
 	 return false;
 }
 
+void
+ROOTDataReaderTEM::readEntry( unsigned int entry )
+{
+   if( m_useColumns ){
+
+      m_columns.copyEvent( entry, m_nPart, m_e, m_px, m_py, m_pz,
+                           m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam, m_weight );
+   }
+   else if( m_prefetcher != NULL ){
+
+      // the prefetcher reads the selected entries (or all of them) in order
+      if( !m_prefetcher->isRunning() ){
+
+         if( m_RangeSpecified ) m_prefetcher->start( m_entryIndex.entries() );
+         else m_prefetcher->startAll();
+      }
+
+      unsigned int read = m_prefetcher->next( m_nPart, m_e, m_px, m_py, m_pz,
+                                              m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam,
+                                              m_weight );
+      assert( read == entry );
+   }
+   else{
+
+      m_inTree->GetEntry( entry );
+      m_weight = m_eventWeight.value();
+   }
+}
+
 unsigned int ROOTDataReaderTEM::numEvents() const
 {	
 	return m_numEvents;
@@ -3,6 +3,10 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEntryIndex.h"
 
 #include "TString.h"
 #include "TFile.h"
@@ -20,12 +24,24 @@ public:
   /**
    * Default constructor for ROOTDataReaderTEM
    */
-  ROOTDataReaderTEM() : UserDataReader< ROOTDataReaderTEM >(), m_inFile( NULL ) { }
+  ROOTDataReaderTEM() : UserDataReader< ROOTDataReaderTEM >(), m_inFile( NULL ), m_prefetcher( NULL ) { }
   
   ~ROOTDataReaderTEM();
   
   /**
    * Constructor for ROOTDataReaderTEM
+   *
+   * The arguments are:  file tMin tMax EMin EMax MMin MMax [tree]
+   * followed by the option index=<path>.  If an index path is given,
+   * the list of entries passing the cuts is read from that file if it
+   * was built for the same input and cuts, or written to it otherwise.
+   * With shm=1 (and optionally shmdir=<dir>) the events are read from
+   * columns shared by all processes on the node, see ROOTDataColumns.
+   * With async=1 the selected entries are read on a background thread
+   * ahead of getEvent, see ROOTDataPrefetcher.  With weight=<expression>
+   * the weight of the events is an expression of the branches, see
+   * ROOTDataWeight.
+   *
    * \param[in] args vector of string arguments
    */
   ROOTDataReaderTEM( const vector< string >& args );
@@ -46,11 +62,17 @@ public:
   virtual unsigned int numEvents() const;
   
 private:
+
+  // read an entry into the branch buffers, from the shared columns
+  // if the reader was constructed with shm=1 or from the background
+  // thread if it was constructed with async=1
+  void readEntry( unsigned int entry );
 	
   TFile* m_inFile;
   TTree* m_inTree;
   unsigned int m_eventCounter,m_numEvents;
   bool m_useWeight, m_RangeSpecified;
+  ROOTDataEntryIndex m_entryIndex;
   double m_tMin,m_tMax, m_EMin,m_EMax, m_MMin,m_MMax;
   
   int m_nPart;
@@ -63,6 +85,11 @@ private:
   float m_pyBeam;
   float m_pzBeam;
   float m_weight;
+
+  bool m_useColumns;
+  ROOTDataColumns m_columns;
+  ROOTDataPrefetcher* m_prefetcher;
+  ROOTDataWeight m_eventWeight;
 };
 
 #endif
@@ -2,10 +2,14 @@
 #include <vector>
 #include <cassert>
 #include <iostream>
+#include <map>
+#include <cmath>
 
 #include "TLorentzVector.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
 #include "IUAmpTools/Kinematics.h"
 
 #include "TH1.h"
@@ -17,20 +21,60 @@ using namespace std;
 ROOTDataReaderWithTCut::ROOTDataReaderWithTCut( const vector< string >& args ):
    UserDataReader< ROOTDataReaderWithTCut >( args ),
    m_eventCounter( 0 ),
-   m_useWeight( false )
+   m_useWeight( false ),
+   m_useColumns( false ),
+   m_prefetcher( NULL )
 {
-   assert( args.size() == 4 || args.size() == 3 || args.size() == 1 );
+   vector< string > posArgs;
+   map< string, string > options;
+   splitReaderArgs( args, posArgs, options );
+
+   assert( posArgs.size() == 4 || posArgs.size() == 3 || posArgs.size() == 1 );
+
+   string indexFile;
+   string shmDir = "/dev/shm";
+   bool async = false;
+   string weightExpression;
+   for( map< string, string >::const_iterator opt = options.begin();
+        opt != options.end(); ++opt ){
+
+      if( opt->first == "index" ){
+
+         indexFile = opt->second;
+      }
+      else if( opt->first == "shm" ){
+
+         m_useColumns = readerOptionIsTrue( opt->second );
+      }
+      else if( opt->first == "shmdir" ){
+
+         shmDir = opt->second;
+      }
+      else if( opt->first == "async" ){
+
+         async = readerOptionIsTrue( opt->second );
+      }
+      else if( opt->first == "weight" ){
+
+         weightExpression = opt->second;
+      }
+      else{
+
+         cout << "ROOTDataReaderWithTCut ERROR:  unknown option " << opt->first << endl;
+         assert( false );
+      }
+   }
 
    TH1::AddDirectory( kFALSE );
 
    //this way of opening files works with URLs of the form
    // root://xrootdserver/path/to/myfile.root
-   m_inFile = TFile::Open( args[0].c_str() );
+   m_inFile = TFile::Open( posArgs[0].c_str() );
 
    // default to tree name of "kin" if none is provided
-   if( args.size() == 4 ){
+   if( posArgs.size() == 4 ){
 
-      m_inTree = dynamic_cast<TTree*>( m_inFile->Get( args[3].c_str() ) );
+      m_inTree = dynamic_cast<TTree*>( m_inFile->Get( posArgs[3].c_str() ) );
    }
    else{
 
@@ -49,59 +93,75 @@ ROOTDataReaderWithTCut::ROOTDataReaderWithTCut( const vector< string >& args ):
    m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
    m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
 
-   if(m_inTree->GetBranch("Weight") != NULL){
+   if( m_useColumns ) m_columns.fillShared( m_inFile, m_inTree, true, shmDir, weightExpression );
 
-     m_useWeight = true;
-     m_inTree->SetBranchAddress( "Weight", &m_weight );
-   }
-   else{
-     
-     m_useWeight=false;
-   }
+   m_useWeight = m_eventWeight.attach( m_inTree, weightExpression );
 
    m_RangeSpecified = false;
-   if( args.size() == 4 || args.size() == 3){
+   if( posArgs.size() == 4 || posArgs.size() == 3){
       // Set t range
-      m_tMin = atof(args[1].c_str());
-      m_tMax = atof(args[2].c_str());
+      m_tMin = atof(posArgs[1].c_str());
+      m_tMax = atof(posArgs[2].c_str());
       m_RangeSpecified = true;
 
-      m_numEvents = 0;
       cout << "*********************************************" << endl;
       cout << "ROOT Data reader  -t range specified [" << m_tMin << "," << m_tMax << ")" << endl;
       cout << "Total events: " <<  m_inTree->GetEntries() << endl;
 
-      while( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
+      vector< double > cuts;
+      cuts.push_back( m_tMin );
+      cuts.push_back( m_tMax );
+      string key = ROOTDataEntryIndex::makeKey( m_inFile, m_inTree, name(), cuts );
 
-         m_inTree->GetEntry( m_eventCounter++ );
-         assert( m_nPart < Kinematics::kMaxParticles );
+      if( indexFile != "" && m_entryIndex.read( indexFile, key ) ){
 
-         vector< TLorentzVector > particleList;
+         cout << "Read selected entries from " << indexFile << endl;
+      }
+      else{
 
-         particleList.
-            push_back( TLorentzVector( m_pxBeam, m_pyBeam, m_pzBeam, m_eBeam ) );
+         // the cut only depends on the recoil, so only read the
+         // final state branches while selecting
+         m_inTree->SetBranchStatus( "*", 0 );
+         m_inTree->SetBranchStatus( "NumFinalState", 1 );
+         m_inTree->SetBranchStatus( "E_FinalState", 1 );
+         m_inTree->SetBranchStatus( "Px_FinalState", 1 );
+         m_inTree->SetBranchStatus( "Py_FinalState", 1 );
+         m_inTree->SetBranchStatus( "Pz_FinalState", 1 );
 
-         for( int i = 0; i < m_nPart; ++i ){
+         unsigned int nEntries = static_cast< unsigned int >( m_inTree->GetEntries() );
+         for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
 
-            particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
-         }
+            readEntry( iEntry );
+            assert( m_nPart < Kinematics::kMaxParticles );
 
-         // Calculate -t and check if it is in range
-         // Use the reconstructed proton
-         TLorentzVector target = TLorentzVector(0.0,0.0,0.0,0.938272);
-         double tMag = fabs((target-particleList[1]).M2());
+            // Calculate -t and check if it is in range
+            // Use the reconstructed proton
+            TLorentzVector target = TLorentzVector(0.0,0.0,0.0,0.938272);
+            TLorentzVector recoil = TLorentzVector( m_px[0], m_py[0], m_pz[0], m_e[0] );
+            double tMag = fabs((target-recoil).M2());
 
-         if (m_tMin <= tMag && tMag < m_tMax){
-            m_numEvents++;
+            if (m_tMin <= tMag && tMag < m_tMax){
+               m_entryIndex.add( iEntry );
+            }
          }
+
+         m_inTree->SetBranchStatus( "*", 1 );
+
+         if( indexFile != "" ) m_entryIndex.write( indexFile, key );
       }
+
+      m_numEvents = m_entryIndex.size();
       cout << "Number of events kept    = " << m_numEvents << endl;
       cout << "*********************************************" << endl;
    }
+
+   if( async && !m_useColumns ) m_prefetcher = new ROOTDataPrefetcher( m_inTree, weightExpression );
 }
 
 ROOTDataReaderWithTCut::~ROOTDataReaderWithTCut()
 {
+   // the background thread must be done with the tree before it goes away
+   if( m_prefetcher != NULL ) delete m_prefetcher;
    if( m_inFile != NULL ) m_inFile->Close();
 }
 
@@ -113,69 +173,70 @@ void ROOTDataReaderWithTCut::resetSource()
 
    // this will cause the read to start back at event 0
    m_eventCounter = 0;
+   if( m_prefetcher != NULL ) m_prefetcher->stop();
 }
 
    Kinematics*
 ROOTDataReaderWithTCut::getEvent()
 {
-
-
+   // without a range every entry is used, otherwise only
+   // those entries that were selected in the constructor
    if (m_RangeSpecified == false){
 
       if( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
-         //  if( m_eventCounter < 10 ){ 
-         m_inTree->GetEntry( m_eventCounter++ );
-         assert( m_nPart < Kinematics::kMaxParticles );
-
-         vector< TLorentzVector > particleList;
-
-         particleList.
-            push_back( TLorentzVector( m_pxBeam, m_pyBeam, m_pzBeam, m_eBeam ) );
-
-         for( int i = 0; i < m_nPart; ++i ){
-
-            particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
-         }
 
-         return new Kinematics( particleList, m_useWeight ? m_weight : 1.0 );
+         readEntry( m_eventCounter++ );
+         fillParticleList( m_particleList, m_nPart, m_e, m_px, m_py, m_pz,
+                           m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam );
+         return new PooledKinematics( m_particleList, m_useWeight ? m_weight : 1.0 );
       }
       else return NULL;
+   }
+   else{
 
-      } 
-      else{
-
-         while( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
-
-            m_inTree->GetEntry( m_eventCounter++ );
-            assert( m_nPart < Kinematics::kMaxParticles );
-
-            vector< TLorentzVector > particleList;
+      if( m_eventCounter < m_entryIndex.size() ){
 
-            particleList.
-               push_back( TLorentzVector( m_pxBeam, m_pyBeam, m_pzBeam, m_eBeam ) );
+         readEntry( m_entryIndex[m_eventCounter++] );
+         fillParticleList( m_particleList, m_nPart, m_e, m_px, m_py, m_pz,
+                           m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam );
+         return new PooledKinematics( m_particleList, m_useWeight ? m_weight : 1.0 );
+      }
+      else return NULL;
+   }
 
-            for( int i = 0; i < m_nPart; ++i ){
+   return NULL;
+}
 
-               particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
-            }
+void
+ROOTDataReaderWithTCut::readEntry( unsigned int entry )
+{
+   if( m_useColumns ){
 
-            // Calculate -t and check if it is in range
-            // Use the reconstructed proton
-            TLorentzVector target = TLorentzVector(0.0,0.0,0.0,0.938272);
-            double tMag = fabs((target-particleList[1]).M2());
+      m_columns.copyEvent( entry, m_nPart, m_e, m_px, m_py, m_pz,
+                           m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam, m_weight );
+   }
+   else if( m_prefetcher != NULL ){
 
-            if (m_tMin <= tMag && tMag < m_tMax){
-               return new Kinematics( particleList, m_useWeight ? m_weight : 1.0 ); 
-            }
+      // the prefetcher reads the selected entries (or all of them) in order
+      if( !m_prefetcher->isRunning() ){
 
-         }
-         return NULL;
+         if( m_RangeSpecified ) m_prefetcher->start( m_entryIndex.entries() );
+         else m_prefetcher->startAll();
       }
 
-      return NULL;
+      unsigned int read = m_prefetcher->next( m_nPart, m_e, m_px, m_py, m_pz,
+                                              m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam,
+                                              m_weight );
+      assert( read == entry );
    }
+   else{
 
-   unsigned int ROOTDataReaderWithTCut::numEvents() const
-   {	
-      return m_numEvents;
+      m_inTree->GetEntry( entry );
+      m_weight = m_eventWeight.value();
    }
+}
+
+unsigned int ROOTDataReaderWithTCut::numEvents() const
+{	
+   return m_numEvents;
+}
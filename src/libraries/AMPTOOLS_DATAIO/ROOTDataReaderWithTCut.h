@@ -3,6 +3,10 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEntryIndex.h"
 
 #include "TString.h"
 #include "TFile.h"
@@ -20,12 +24,23 @@ public:
   /**
    * Default constructor for ROOTDataReaderWithTCut
    */
-  ROOTDataReaderWithTCut() : UserDataReader< ROOTDataReaderWithTCut >(), m_inFile( NULL ) { }
+  ROOTDataReaderWithTCut() : UserDataReader< ROOTDataReaderWithTCut >(), m_inFile( NULL ), m_prefetcher( NULL ) { }
   
   ~ROOTDataReaderWithTCut();
   
   /**
    * Constructor for ROOTDataReaderWithTCut
+   *
+   * The arguments are:  file [tMin tMax [tree]] optionally followed
+   * by index=<path>.  If an index path is given, the list of entries
+   * passing the -t cut is read from that file if it was built for the
+   * same input and cut, or written to it otherwise.  With shm=1 (and
+   * optionally shmdir=<dir>) the events are read from columns shared by
+   * all processes on the node, see ROOTDataColumns.  With async=1 the
+   * events are read on a background thread ahead of getEvent, see
+   * ROOTDataPrefetcher.  With weight=<expression> the weight of the
+   * events is an expression of the branches, see ROOTDataWeight.
+   *
    * \param[in] args vector of string arguments
    */
   ROOTDataReaderWithTCut( const vector< string >& args );
@@ -44,11 +59,18 @@ public:
   virtual unsigned int numEvents() const;
   
 private:
+
+  // read an entry into the branch buffers, from the shared columns
+  // if the reader was constructed with shm=1 or from the background
+  // thread if it was constructed with async=1
+  void readEntry( unsigned int entry );
+
 	
   TFile* m_inFile;
   TTree* m_inTree;
   unsigned int m_eventCounter,m_numEvents;
   bool m_useWeight, m_RangeSpecified;
+  ROOTDataEntryIndex m_entryIndex;
   double m_tMin,m_tMax;
   
   int m_nPart;
@@ -61,6 +83,14 @@ private:
   float m_pyBeam;
   float m_pzBeam;
   float m_weight;
+
+  // the particles of the last event, kept between events
+  vector< TLorentzVector > m_particleList;
+
+  bool m_useColumns;
+  ROOTDataColumns m_columns;
+  ROOTDataPrefetcher* m_prefetcher;
+  ROOTDataWeight m_eventWeight;
 };
 
 #endif
@@ -0,0 +1,92 @@
+
+#include <cassert>
+#include <iostream>
+
+#include "TTree.h"
+#include "TChain.h"
+#include "TTreeFormula.h"
+#include "TLeaf.h"
+#include "TBranch.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataWeight.h"
+
+using namespace std;
+
+ROOTDataWeight::ROOTDataWeight() :
+  m_formula( NULL ),
+  m_chain( NULL ),
+  m_branch( false ),
+  m_weight( 1.0 )
+{ }
+
+ROOTDataWeight::~ROOTDataWeight()
+{
+  release();
+}
+
+bool
+ROOTDataWeight::attach( TTree* tree, const string& expression )
+{
+  release();
+  m_branch = false;
+  m_weight = 1.0;
+
+  if( expression == "" ){
+
+    if( tree->GetBranch( "Weight" ) != NULL ){
+
+      m_branch = true;
+      tree->SetBranchAddress( "Weight", &m_weight );
+    }
+
+    return m_branch;
+  }
+
+  m_formula = new TTreeFormula( "weight", expression.c_str(), tree );
+  if( m_formula->GetNdim() == 0 ){
+
+    cout << "ROOTDataWeight ERROR:  cannot evaluate the weight " << expression
+         << " on " << tree->GetName() << endl;
+    assert( false );
+  }
+
+  // a chain moves the formula to the tree of each file it opens
+  if( tree->InheritsFrom( TChain::Class() ) ){
+
+    m_chain = tree;
+    m_chain->SetNotify( m_formula );
+  }
+
+  return true;
+}
+
+void
+ROOTDataWeight::release()
+{
+  if( m_chain != NULL ) m_chain->SetNotify( NULL );
+  if( m_formula != NULL ) delete m_formula;
+
+  m_chain = NULL;
+  m_formula = NULL;
+}
+
+void
+ROOTDataWeight::enableBranches( TTree* tree ) const
+{
+  if( m_branch ) tree->SetBranchStatus( "Weight", 1 );
+  if( m_formula == NULL ) return;
+
+  for( int i = 0; i < m_formula->GetNcodes(); ++i ){
+
+    TLeaf* leaf = m_formula->GetLeaf( i );
+    if( leaf != NULL ) tree->SetBranchStatus( leaf->GetBranch()->GetName(), 1 );
+  }
+}
+
+float
+ROOTDataWeight::value() const
+{
+  if( m_formula != NULL ) return m_formula->EvalInstance();
+
+  return m_weight;
+}
@@ -0,0 +1,72 @@
+#if !defined(ROOTDATAWEIGHT)
+#define ROOTDATAWEIGHT
+
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+#include <string>
+
+using namespace std;
+
+/**
+ * The weight of the events of a tree with the standard "kin" layout.
+ * By default this is the Weight branch, if the tree has one.  With the
+ * weight=<expression> option of the ROOT data readers it is instead any
+ * TTreeFormula expression of the branches of the tree, for example
+ *
+ *   weight=AccWeight*sWeight     several named weights of one event
+ *   weight=-AccWeight            the sideband of an accidental subtraction
+ *
+ * so that the signal and background samples of a fit can come from the
+ * same tree instead of separate copies.
+ *
+ * The weight is evaluated for the entry most recently read with
+ * GetEntry.  The object refers to the tree it is attached to and sets
+ * the address of the Weight branch, so it cannot be copied.
+ */
+
+class ROOTDataWeight
+{
+
+public:
+
+  ROOTDataWeight();
+  ~ROOTDataWeight();
+
+  /**
+   * Attach to a tree; returns true if the events have a weight, that is
+   * if the expression is not empty or the tree has a Weight branch.  An
+   * expression that cannot be evaluated on the tree is an error.
+   *
+   * \param[in] tree the input tree
+   * \param[in] expression the weight expression, or "" for the Weight branch
+   */
+  bool attach( TTree* tree, const string& expression = "" );
+
+  bool hasWeight() const { return m_formula != NULL || m_branch; }
+
+  /**
+   * Turn on the branches the weight is computed from, for code that
+   * only reads some branches of the tree.
+   */
+  void enableBranches( TTree* tree ) const;
+
+  /**
+   * The weight of the current entry, 1 if the events have no weight.
+   */
+  float value() const;
+
+private:
+
+  ROOTDataWeight( const ROOTDataWeight& );
+  ROOTDataWeight& operator=( const ROOTDataWeight& );
+
+  void release();
+
+  TTreeFormula* m_formula;
+  TTree* m_chain;       // the chain that notifies the formula, if any
+  bool m_branch;
+  float m_weight;
+};
+
+#endif
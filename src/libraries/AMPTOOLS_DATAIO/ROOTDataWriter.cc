@@ -1,6 +1,9 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <cstdlib>
+#include <string>
+#include <cstring>
 
 #include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
 
@@ -9,9 +12,39 @@
 #include "TH1.h"
 
 
+int
+ROOTDataWriterOptions::compressionSettings( const string& spec )
+{
+  string codec = spec;
+  int level = -1;
+
+  size_t colon = spec.find( ':' );
+  if( colon != string::npos ){
+
+    codec = spec.substr( 0, colon );
+    level = atoi( spec.substr( colon + 1 ).c_str() );
+  }
+
+  if( codec == "none" ) return 0;
+
+  int algorithm;
+  if( codec == "zlib" ) algorithm = 1;
+  else if( codec == "lzma" ) algorithm = 2;
+  else if( codec == "lz4" ) algorithm = 4;
+  else if( codec == "zstd" ) algorithm = 5;
+  else return -1;
+
+  // the ROOT recommended levels
+  if( level < 0 ) level = ( algorithm == 4 ? 4 : ( algorithm == 5 ? 5 : 1 ) );
+  if( level > 9 ) return -1;
+
+  return 100 * algorithm + level;
+}
+
 void ROOTDataWriter::IOinit( const string& outFile,
                              const string& outTreeName,
-                             bool overwrite, bool writeWeight)
+                             bool overwrite, bool writeWeight,
+                             const ROOTDataWriterOptions& options )
 {
 
   TH1::AddDirectory( kFALSE );
@@ -19,6 +52,19 @@ void ROOTDataWriter::IOinit( const string& outFile,
   if(!overwrite) writeMode="update";
 
   m_outFile = new TFile( outFile.c_str(), writeMode.c_str() );
+
+  if( options.compression != "" ){
+
+    int settings = ROOTDataWriterOptions::compressionSettings( options.compression );
+    if( settings < 0 ){
+
+      cout << "ROOTDataWriter ERROR:  unknown compression " << options.compression << endl;
+      assert( false );
+    }
+
+    m_outFile->SetCompressionSettings( settings );
+  }
+
   m_outTree = new TTree( outTreeName.c_str(), "Kinematics" );
 
   m_outTree->Branch( "NumFinalState", &m_nPart, "NumFinalState/I" );
@@ -32,6 +78,9 @@ void ROOTDataWriter::IOinit( const string& outFile,
   m_outTree->Branch( "Pz_Beam", &m_pzBeam, "Pz_Beam/F" );
   if(writeWeight)
     m_outTree->Branch( "Weight", &m_weight, "Weight/F" );  
+
+  if( options.basketSize > 0 ) m_outTree->SetBasketSize( "*", options.basketSize );
+  if( options.autoFlush != 0 ) m_outTree->SetAutoFlush( options.autoFlush );
   
   m_eventCounter = 0;
 }
@@ -46,7 +95,7 @@ ROOTDataWriter::~ROOTDataWriter()
 void
 ROOTDataWriter::writeEvent( const Kinematics& kin )
 {
-  vector< TLorentzVector > particleList = kin.particleList();
+  const vector< TLorentzVector >& particleList = kin.particleList();
   
   m_nPart = particleList.size() - 1;
   
@@ -72,3 +121,41 @@ ROOTDataWriter::writeEvent( const Kinematics& kin )
   m_eventCounter++;
   
 }
+
+void
+ROOTDataWriter::writeEvent( int nPart, const float* e, const float* px, const float* py, const float* pz,
+                            float eBeam, float pxBeam, float pyBeam, float pzBeam, float weight )
+{
+  assert( nPart < Kinematics::kMaxParticles );
+
+  m_nPart = nPart;
+
+  m_eBeam = eBeam;
+  m_pxBeam = pxBeam;
+  m_pyBeam = pyBeam;
+  m_pzBeam = pzBeam;
+
+  memcpy( m_e, e, nPart * sizeof( float ) );
+  memcpy( m_px, px, nPart * sizeof( float ) );
+  memcpy( m_py, py, nPart * sizeof( float ) );
+  memcpy( m_pz, pz, nPart * sizeof( float ) );
+
+  m_weight = weight;
+
+  m_outTree->Fill();
+
+  m_eventCounter++;
+}
+
+void
+ROOTDataWriter::writeEvent( const ROOTDataEvent& event )
+{
+  writeEvent( event.nPart, event.e, event.px, event.py, event.pz,
+              event.eBeam, event.pxBeam, event.pyBeam, event.pzBeam, event.weight );
+}
+
+void
+ROOTDataWriter::writeEvents( const ROOTDataEvent* events, int n )
+{
+  for( int i = 0; i < n; ++i ) writeEvent( events[i] );
+}
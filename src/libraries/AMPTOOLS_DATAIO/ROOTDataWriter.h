@@ -2,10 +2,49 @@
 #define ROOTDATAWRITER
 
 #include "IUAmpTools/Kinematics.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
 
 #include "TTree.h"
 #include "TFile.h"
 
+#include <string>
+
+using namespace std;
+
+/**
+ * Settings for the output file and tree of ROOTDataWriter.  The defaults
+ * leave everything at the ROOT defaults.  Files that are written once and
+ * read many times (e.g. accepted and generated MC) read fastest with a
+ * fast codec such as LZ4 and large baskets.
+ */
+struct ROOTDataWriterOptions {
+
+  ROOTDataWriterOptions() : basketSize( 0 ), autoFlush( 0 ) { }
+
+  /**
+   * The codec and level as codec[:level], where codec is zlib, lzma, lz4,
+   * zstd, or none, e.g., "lz4:4"; empty means the ROOT default.
+   */
+  string compression;
+
+  /**
+   * The basket size in bytes for all branches; 0 means the ROOT default.
+   */
+  int basketSize;
+
+  /**
+   * Passed to TTree::SetAutoFlush:  entries if positive, bytes if
+   * negative; 0 means the ROOT default.
+   */
+  Long64_t autoFlush;
+
+  /**
+   * Returns the value for TFile::SetCompressionSettings for a codec[:level]
+   * string (100 * algorithm + level), or -1 if it cannot be parsed.
+   */
+  static int compressionSettings( const string& spec );
+};
+
 class ROOTDataWriter
 {
 
@@ -19,17 +58,38 @@ public:
    * \param[in] overwrite (optional) boolean parameter specifying whether to
    *               overwrite (default) or update the ROOT file.
    * \param[in] writeWeight (optional) enables writing of the event weight in the ROOT file
+   * \param[in] options (optional) compression and basket settings
    */
   ROOTDataWriter( const string& outFile,
                   const string& outTreeName="kin",
-                  bool overwrite=true, bool writeWeight=false )
+                  bool overwrite=true, bool writeWeight=false,
+                  const ROOTDataWriterOptions& options=ROOTDataWriterOptions() )
   {
-    IOinit(outFile, outTreeName, overwrite, writeWeight);
+    IOinit(outFile, outTreeName, overwrite, writeWeight, options);
   };
  
   ~ROOTDataWriter();
   
   void writeEvent( const Kinematics& kin );
+
+  /**
+   * Write an event that is already in the branch layout; this avoids
+   * building a Kinematics object for tools that only move events around.
+   */
+  void writeEvent( const ROOTDataEvent& event );
+
+  /**
+   * Write an event from the arrays of the final state particles and the
+   * beam, in the layout of the branches and of ROOTDataPrefetcher::next;
+   * the values are copied straight into the branch buffers.
+   */
+  void writeEvent( int nPart, const float* e, const float* px, const float* py, const float* pz,
+                   float eBeam, float pxBeam, float pyBeam, float pzBeam, float weight = 1 );
+
+  /**
+   * Write the n contiguous events of a block.
+   */
+  void writeEvents( const ROOTDataEvent* events, int n );
   
   int eventCounter() const { return m_eventCounter; }
   
@@ -38,7 +98,8 @@ private:
   
   void IOinit( const string& outFile,
 	       const string& outTreeName,
-	       bool overwrite, bool writeWeight);  
+	       bool overwrite, bool writeWeight,
+	       const ROOTDataWriterOptions& options );
   
   TFile* m_outFile;
   TTree* m_outTree;
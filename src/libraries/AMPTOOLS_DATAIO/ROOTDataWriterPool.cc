@@ -0,0 +1,238 @@
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include "TROOT.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataWriterPool.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+
+using namespace std;
+
+// events per batch that is passed to a writer thread, and the number of
+// batches that may wait for one thread before the caller is blocked
+static const unsigned int kBatchSize = 256;
+static const unsigned int kMaxQueuedBatches = 64;
+
+ROOTDataWriterPool::ROOTDataWriterPool( const vector< string >& outFiles,
+                                        const string& outTreeName,
+                                        bool overwrite, bool writeWeight,
+                                        unsigned int nThreads,
+                                        const ROOTDataWriterOptions& options ) :
+  m_outFiles( outFiles ),
+  m_outTreeName( outTreeName ),
+  m_overwrite( overwrite ),
+  m_writeWeight( writeWeight ),
+  m_options( options ),
+  m_closed( false ),
+  m_numOutputs( outFiles.size() ),
+  m_counts( outFiles.size(), 0 )
+{
+  if( nThreads > m_numOutputs ) nThreads = m_numOutputs;
+
+  if( nThreads == 0 ){
+
+    for( unsigned int i = 0; i < m_numOutputs; ++i ){
+
+      m_writers.push_back( new ROOTDataWriter( m_outFiles[i], m_outTreeName,
+                                               m_overwrite, m_writeWeight,
+                                               m_options ) );
+    }
+
+    return;
+  }
+
+  // each thread creates and fills its own files
+  ROOT::EnableThreadSafety();
+
+  m_pending.resize( m_numOutputs, NULL );
+
+  for( unsigned int i = 0; i < nThreads; ++i ){
+
+    Worker* worker = new Worker;
+    worker->done = false;
+    m_workers.push_back( worker );
+  }
+
+  for( unsigned int i = 0; i < nThreads; ++i ){
+
+    m_workers[i]->thr = thread( &ROOTDataWriterPool::run, this, i );
+  }
+}
+
+ROOTDataWriterPool::~ROOTDataWriterPool()
+{
+  close();
+}
+
+void
+ROOTDataWriterPool::writeEvent( unsigned int output, const ROOTDataEvent& event )
+{
+  assert( output < m_numOutputs );
+  assert( !m_closed );
+
+  ++m_counts[output];
+
+  if( m_workers.empty() ){
+
+    m_writers[output]->writeEvent( event );
+    return;
+  }
+
+  if( m_pending[output] == NULL ){
+
+    m_pending[output] = freeBatch();
+    m_pending[output]->output = output;
+  }
+
+  m_pending[output]->events.push_back( event );
+
+  if( m_pending[output]->events.size() == kBatchSize ) flush( output );
+}
+
+void
+ROOTDataWriterPool::writeEvents( unsigned int output, const ROOTDataEvent* events, int n )
+{
+  assert( output < m_numOutputs );
+  assert( !m_closed );
+
+  m_counts[output] += n;
+
+  if( m_workers.empty() ){
+
+    m_writers[output]->writeEvents( events, n );
+    return;
+  }
+
+  while( n > 0 ){
+
+    if( m_pending[output] == NULL ){
+
+      m_pending[output] = freeBatch();
+      m_pending[output]->output = output;
+    }
+
+    vector< ROOTDataEvent >& pending = m_pending[output]->events;
+    int nCopy = min( n, static_cast< int >( kBatchSize - pending.size() ) );
+    pending.insert( pending.end(), events, events + nCopy );
+    events += nCopy;
+    n -= nCopy;
+
+    if( pending.size() == kBatchSize ) flush( output );
+  }
+}
+
+void
+ROOTDataWriterPool::close()
+{
+  if( m_closed ) return;
+  m_closed = true;
+
+  for( unsigned int i = 0; i < m_writers.size(); ++i ) delete m_writers[i];
+  m_writers.clear();
+
+  for( unsigned int i = 0; i < m_pending.size(); ++i ){
+
+    if( m_pending[i] != NULL ) flush( i );
+  }
+
+  for( unsigned int i = 0; i < m_workers.size(); ++i ){
+
+    {
+      lock_guard< mutex > lock( m_workers[i]->queueMutex );
+      m_workers[i]->done = true;
+    }
+    m_workers[i]->notEmpty.notify_one();
+  }
+
+  for( unsigned int i = 0; i < m_workers.size(); ++i ){
+
+    m_workers[i]->thr.join();
+    delete m_workers[i];
+  }
+  m_workers.clear();
+
+  for( unsigned int i = 0; i < m_freeBatches.size(); ++i ) delete m_freeBatches[i];
+  m_freeBatches.clear();
+}
+
+void
+ROOTDataWriterPool::flush( unsigned int output )
+{
+  Worker* worker = m_workers[output % m_workers.size()];
+
+  {
+    unique_lock< mutex > lock( worker->queueMutex );
+    while( worker->queue.size() >= kMaxQueuedBatches ) worker->notFull.wait( lock );
+
+    worker->queue.push_back( m_pending[output] );
+  }
+  worker->notEmpty.notify_one();
+
+  m_pending[output] = NULL;
+}
+
+ROOTDataWriterPool::Batch*
+ROOTDataWriterPool::freeBatch()
+{
+  {
+    lock_guard< mutex > lock( m_freeMutex );
+
+    if( !m_freeBatches.empty() ){
+
+      Batch* batch = m_freeBatches.back();
+      m_freeBatches.pop_back();
+      return batch;
+    }
+  }
+
+  Batch* batch = new Batch;
+  batch->events.reserve( kBatchSize );
+  return batch;
+}
+
+void
+ROOTDataWriterPool::run( unsigned int iWorker )
+{
+  Worker* worker = m_workers[iWorker];
+  unsigned int nWorkers = m_workers.size();
+
+  // this thread owns every output i with i % nWorkers == iWorker
+  vector< ROOTDataWriter* > writers( m_numOutputs, NULL );
+  for( unsigned int i = iWorker; i < m_numOutputs; i += nWorkers ){
+
+    writers[i] = new ROOTDataWriter( m_outFiles[i], m_outTreeName,
+                                     m_overwrite, m_writeWeight, m_options );
+  }
+
+  while( true ){
+
+    Batch* batch = NULL;
+
+    {
+      unique_lock< mutex > lock( worker->queueMutex );
+      while( worker->queue.empty() && !worker->done ) worker->notEmpty.wait( lock );
+
+      if( worker->queue.empty() ) break;
+
+      batch = worker->queue.front();
+      worker->queue.pop_front();
+    }
+    worker->notFull.notify_one();
+
+    ROOTDataWriter* writer = writers[batch->output];
+    assert( writer != NULL );
+
+    writer->writeEvents( &batch->events[0], batch->events.size() );
+
+    batch->events.clear();
+
+    lock_guard< mutex > lock( m_freeMutex );
+    m_freeBatches.push_back( batch );
+  }
+
+  for( unsigned int i = iWorker; i < m_numOutputs; i += nWorkers ) delete writers[i];
+}
@@ -0,0 +1,123 @@
+#if !defined(ROOTDATAWRITERPOOL)
+#define ROOTDATAWRITERPOOL
+
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * This class writes events to many ROOT files at once, e.g., one file
+ * per kinematic bin.  With one or more threads, each output file is
+ * owned by one writer thread (output i belongs to thread i % nThreads),
+ * which creates, fills, and closes its ROOTDataWriter objects, so the
+ * compression done in TTree::Fill is spread over the threads while the
+ * caller keeps reading.  With zero threads the events are written
+ * directly by the calling thread.
+ *
+ * Events are handed over in batches whose buffers are reused, so the
+ * steady state does not allocate.
+ */
+
+class ROOTDataWriterPool
+{
+
+public:
+
+  /**
+   * \param[in] outFiles the names of the output files
+   * \param[in] outTreeName the name of the tree in every output file
+   * \param[in] overwrite overwrite (true) or update the files
+   * \param[in] writeWeight write the event weight in the files
+   * \param[in] nThreads the number of writer threads (0: write directly)
+   * \param[in] options the compression and basket settings of every file
+   */
+  ROOTDataWriterPool( const vector< string >& outFiles,
+                      const string& outTreeName = "kin",
+                      bool overwrite = true, bool writeWeight = false,
+                      unsigned int nThreads = 0,
+                      const ROOTDataWriterOptions& options = ROOTDataWriterOptions() );
+
+  /**
+   * Calls close() if it has not been called yet.
+   */
+  ~ROOTDataWriterPool();
+
+  /**
+   * Queue an event for the given output.
+   */
+  void writeEvent( unsigned int output, const ROOTDataEvent& event );
+
+  /**
+   * Queue the n contiguous events of a block for the given output.
+   */
+  void writeEvents( unsigned int output, const ROOTDataEvent* events, int n );
+
+  /**
+   * Write out everything that is queued and close all files.
+   */
+  void close();
+
+  unsigned int numOutputs() const { return m_numOutputs; }
+
+  /**
+   * The number of events passed to writeEvent for the given output.
+   */
+  unsigned int eventCounter( unsigned int output ) const { return m_counts[output]; }
+
+private:
+
+  ROOTDataWriterPool( const ROOTDataWriterPool& );
+  ROOTDataWriterPool& operator=( const ROOTDataWriterPool& );
+
+  struct Batch {
+
+    unsigned int output;
+    vector< ROOTDataEvent > events;
+  };
+
+  struct Worker {
+
+    deque< Batch* > queue;
+    mutex queueMutex;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    bool done;
+    thread thr;
+  };
+
+  void flush( unsigned int output );
+  Batch* freeBatch();
+  void run( unsigned int iWorker );
+
+  vector< string > m_outFiles;
+  string m_outTreeName;
+  bool m_overwrite;
+  bool m_writeWeight;
+  ROOTDataWriterOptions m_options;
+  bool m_closed;
+
+  unsigned int m_numOutputs;
+  vector< unsigned int > m_counts;
+
+  // used when there are no threads
+  vector< ROOTDataWriter* > m_writers;
+
+  // the batch that is being filled for each output
+  vector< Batch* > m_pending;
+
+  vector< Worker* > m_workers;
+
+  // batches that have been written and can be filled again
+  vector< Batch* > m_freeBatches;
+  mutex m_freeMutex;
+};
+
+#endif
@@ -0,0 +1,164 @@
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include "TChain.h"
+#include "TTreeFormula.h"
+#include "TLeaf.h"
+#include "TBranch.h"
+#include "TMath.h"
+
+#include "AMPTOOLS_AMPS/PolarizationTable.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "AMPTOOLS_DATAIO/RunPolarization.h"
+
+using namespace std;
+
+const RunPolarization*
+RunPolarization::get( const string& fileName ){
+
+  static map< string, const RunPolarization* > tables;
+  static mutex tablesMutex;
+
+  lock_guard< mutex > lock( tablesMutex );
+
+  map< string, const RunPolarization* >::const_iterator table = tables.find( fileName );
+  if( table != tables.end() ) return table->second;
+
+  const RunPolarization* newTable = new RunPolarization( fileName );
+  tables[fileName] = newTable;
+
+  return newTable;
+}
+
+RunPolarization::RunPolarization( const string& fileName ) :
+  m_name( fileName )
+{
+  ifstream in( fileName.c_str() );
+  if( !in ){
+
+    cout << "RunPolarization ERROR:  cannot open " << fileName << endl;
+    assert( false );
+  }
+
+  string line;
+  while( getline( in, line ) ){
+
+    istringstream fields( line );
+    vector< string > values;
+    string value;
+    while( fields >> value ) values.push_back( value );
+
+    if( values.empty() || values[0][0] == '#' ) continue;
+
+    if( values.size() != 4 && values.size() != 5 ){
+
+      cout << "RunPolarization ERROR:  line \"" << line << "\" of " << fileName
+           << " is not <first run> <last run> <angle> <fraction> or"
+           << " <first run> <last run> <angle> <file> <histogram>" << endl;
+      assert( false );
+    }
+
+    Range range;
+    range.first = strtoul( values[0].c_str(), NULL, 10 );
+    range.last = strtoul( values[1].c_str(), NULL, 10 );
+    range.angle = atof( values[2].c_str() );
+    range.fraction = ( values.size() == 4 ? atof( values[3].c_str() ) : 0 );
+    range.vsEnergy = ( values.size() == 5 ? PolarizationTable::get( values[3], values[4] ) : NULL );
+    m_ranges.push_back( range );
+  }
+
+  sort( m_ranges.begin(), m_ranges.end() );
+
+  for( unsigned int i = 1; i < m_ranges.size(); ++i ){
+
+    if( m_ranges[i].first <= m_ranges[i-1].last ){
+
+      cout << "RunPolarization ERROR:  the runs " << m_ranges[i].first << " to "
+           << m_ranges[i].last << " of " << fileName << " overlap those before" << endl;
+      assert( false );
+    }
+  }
+}
+
+bool
+RunPolarization::lookup( unsigned int run, double energy, double& angle, double& fraction ) const {
+
+  Range key;
+  key.first = run;
+
+  // the last range that starts at or before the run
+  vector< Range >::const_iterator range = upper_bound( m_ranges.begin(), m_ranges.end(), key );
+  if( range == m_ranges.begin() ) return false;
+  --range;
+  if( run > range->last ) return false;
+
+  angle = range->angle;
+  fraction = ( range->vsEnergy != NULL ? range->vsEnergy->fraction( energy ) : range->fraction );
+  return true;
+}
+
+void
+RunPolarization::fill( const vector< string >& files, const string& treeName,
+                       const string& runExpression, const string& slice,
+                       vector< float >& polX, vector< float >& polY ) const {
+
+  TChain chain( treeName.c_str() );
+  for( unsigned int i = 0; i < files.size(); ++i ) chain.Add( files[i].c_str() );
+
+  unsigned int first = 0;
+  unsigned int last = static_cast< unsigned int >( chain.GetEntries() );
+  if( slice != "" ) readerSliceRange( slice, last, first, last );
+
+  TTreeFormula run( "run", runExpression.c_str(), &chain );
+  if( run.GetNdim() == 0 ){
+
+    cout << "RunPolarization ERROR:  cannot evaluate the run " << runExpression
+         << " on " << treeName << endl;
+    assert( false );
+  }
+  chain.SetNotify( &run );
+
+  // only the run and the beam energy are read
+  float eBeam;
+  chain.SetBranchStatus( "*", 0 );
+  chain.SetBranchStatus( "E_Beam", 1 );
+  for( int i = 0; i < run.GetNcodes(); ++i ){
+
+    TLeaf* leaf = run.GetLeaf( i );
+    if( leaf != NULL ) chain.SetBranchStatus( leaf->GetBranch()->GetName(), 1 );
+  }
+  chain.SetBranchAddress( "E_Beam", &eBeam );
+
+  polX.resize( last - first );
+  polY.resize( last - first );
+
+  for( unsigned int i = first; i < last; ++i ){
+
+    chain.GetEntry( i );
+    unsigned int thisRun = static_cast< unsigned int >( run.EvalInstance() );
+
+    double angle, fraction;
+    if( !lookup( thisRun, eBeam, angle, fraction ) ){
+
+      cout << "RunPolarization ERROR:  run " << thisRun << " is not in " << m_name << endl;
+      assert( false );
+    }
+
+    polX[i - first] = fraction * cos( angle * TMath::DegToRad() );
+    polY[i - first] = fraction * sin( angle * TMath::DegToRad() );
+  }
+
+  chain.SetNotify( NULL );
+  chain.ResetBranchAddresses();
+
+  cout << "RunPolarization:  resolved the polarization of " << last - first
+       << " events of " << treeName << " from " << m_name << endl;
+}
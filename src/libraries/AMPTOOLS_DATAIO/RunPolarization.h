@@ -0,0 +1,90 @@
+#if !defined(RUNPOLARIZATION)
+#define RUNPOLARIZATION
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class PolarizationTable;
+
+/**
+ * The beam polarization of every run of a data set, read from a text file
+ * with one range of runs per line:
+ *
+ *   # first  last   angle  fraction
+ *   30274    30300  0      0.35
+ *   30301    30350  45     0.34
+ *   # or the fraction vs. beam energy from a histogram (see PolarizationTable)
+ *   30351    30400  90     pol.root  hPol90
+ *
+ * with the angle of the polarization plane in degrees.  Blank lines and
+ * lines that start with '#' are skipped.
+ *
+ * With the polarization=<file> option the ROOT data readers resolve the
+ * table once when they are constructed into a column of the polarization
+ * of every event, from its run (the branch RunNumber, or the expression of
+ * run=<expression>) and its beam energy, and return the events with the
+ * polarization in the beam px and py:
+ *
+ *   px = fraction cos( angle ),  py = fraction sin( angle )
+ *
+ * which the amplitudes read when they are given no polarization arguments
+ * (e.g., Zlm with four arguments).  A period with several orientations
+ * then fits from one file and one reaction.
+ */
+
+class RunPolarization
+{
+
+public:
+
+  /**
+   * Return the shared table of fileName, reading it on the first call.
+   * The returned table lives until the end of the job.
+   */
+  static const RunPolarization* get( const string& fileName );
+
+  /**
+   * Sets the angle (in degrees) and the fraction of run at the beam
+   * energy and returns true, or returns false if the run is not in the
+   * table.
+   */
+  bool lookup( unsigned int run, double energy, double& angle, double& fraction ) const;
+
+  /**
+   * Fills the beam px and py of the polarization of the entries of a
+   * tree in files, or of the slice of them (see readerSliceRange), in the
+   * order of the files.  A run that is not in the table is an error.
+   */
+  void fill( const vector< string >& files, const string& treeName,
+             const string& runExpression, const string& slice,
+             vector< float >& polX, vector< float >& polY ) const;
+
+  const string& name() const { return m_name; }
+
+private:
+
+  RunPolarization( const string& fileName );
+
+  // tables are shared and never copied
+  RunPolarization( const RunPolarization& );
+  RunPolarization& operator=( const RunPolarization& );
+
+  struct Range {
+
+    unsigned int first, last;
+    double angle;
+    double fraction;
+    const PolarizationTable* vsEnergy;
+
+    bool operator<( const Range& other ) const { return first < other.first; }
+  };
+
+  string m_name;
+
+  // sorted by the first run
+  vector< Range > m_ranges;
+};
+
+#endif
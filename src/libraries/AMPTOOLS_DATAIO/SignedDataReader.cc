@@ -0,0 +1,153 @@
+
+#include <vector>
+#include <string>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/SignedDataReader.h"
+
+using namespace std;
+
+map< string, DataReader* >&
+SignedDataReader::prototypes(){
+
+  static map< string, DataReader* > registered;
+  return registered;
+}
+
+void
+SignedDataReader::registerDataReader( const DataReader& prototype ){
+
+  prototypes()[prototype.name()] = prototype.clone();
+}
+
+DataReader*
+SignedDataReader::newReader( const pair< string, vector< string > >& source ){
+
+  map< string, DataReader* >::const_iterator prototype = prototypes().find( source.first );
+  if( prototype == prototypes().end() ){
+
+    cout << "SignedDataReader ERROR:  the data reader " << source.first << " is not registered" << endl;
+    assert( false );
+  }
+
+  return prototype->second->newDataReader( source.second );
+}
+
+pair< string, vector< string > >
+SignedDataReader::dataSource( const vector< string >& args ){
+
+  assert( args.size() >= 2 );
+  unsigned int n = atoi( args[1].c_str() );
+  assert( args.size() >= n + 3 );
+
+  return make_pair( args[0], vector< string >( args.begin() + 2, args.begin() + 2 + n ) );
+}
+
+pair< string, vector< string > >
+SignedDataReader::bkgndSource( const vector< string >& args ){
+
+  assert( args.size() >= 2 );
+  unsigned int n = atoi( args[1].c_str() );
+  assert( args.size() >= n + 3 );
+
+  return make_pair( args[n + 2], vector< string >( args.begin() + n + 3, args.end() ) );
+}
+
+int
+SignedDataReader::fuse( ConfigurationInfo* cfgInfo ){
+
+  int nFused = 0;
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    pair< string, vector< string > > data = reactions[i]->data();
+    pair< string, vector< string > > bkgnd = reactions[i]->bkgnd();
+    if( bkgnd.first.empty() || data.first.empty() ) continue;
+
+    vector< string > args;
+    args.push_back( data.first );
+    args.push_back( to_string( data.second.size() ) );
+    args.insert( args.end(), data.second.begin(), data.second.end() );
+    args.push_back( bkgnd.first );
+    args.insert( args.end(), bkgnd.second.begin(), bkgnd.second.end() );
+
+    reactions[i]->setData( "SignedDataReader", args );
+    reactions[i]->setBkgnd( "", vector< string >() );
+    ++nFused;
+  }
+
+  return nFused;
+}
+
+void
+SignedDataReader::split( ConfigurationInfo* cfgInfo ){
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    if( reactions[i]->data().first != "SignedDataReader" ) continue;
+
+    vector< string > args = reactions[i]->data().second;
+    pair< string, vector< string > > data = dataSource( args );
+    pair< string, vector< string > > bkgnd = bkgndSource( args );
+
+    reactions[i]->setData( data.first, data.second );
+    reactions[i]->setBkgnd( bkgnd.first, bkgnd.second );
+  }
+}
+
+SignedDataReader::SignedDataReader( const vector< string >& args ):
+  UserDataReader< SignedDataReader >( args ),
+  m_data( newReader( dataSource( args ) ) ),
+  m_bkgnd( newReader( bkgndSource( args ) ) ),
+  m_inBkgnd( false )
+{
+  cout << "SignedDataReader:  " << m_data->numEvents() << " data and " << m_bkgnd->numEvents()
+       << " background events of " << args[0] << " and " << args[atoi( args[1].c_str() ) + 2]
+       << " in one sample" << endl;
+}
+
+SignedDataReader::~SignedDataReader(){
+
+  delete m_data;
+  delete m_bkgnd;
+}
+
+Kinematics*
+SignedDataReader::getEvent(){
+
+  if( !m_inBkgnd ){
+
+    Kinematics* kin = m_data->getEvent();
+    if( kin != NULL ) return kin;
+    m_inBkgnd = true;
+  }
+
+  Kinematics* kin = m_bkgnd->getEvent();
+  if( kin == NULL ) return NULL;
+
+  Kinematics* signedKin = new Kinematics( kin->particleList(), -kin->weight() );
+  delete kin;
+  return signedKin;
+}
+
+void
+SignedDataReader::resetSource(){
+
+  m_data->resetSource();
+  m_bkgnd->resetSource();
+  m_inBkgnd = false;
+}
+
+unsigned int
+SignedDataReader::numEvents() const {
+
+  if( m_data == NULL ) return 0;
+  return m_data->numEvents() + m_bkgnd->numEvents();
+}
@@ -0,0 +1,91 @@
+#if !defined(SIGNEDDATAREADER)
+#define SIGNEDDATAREADER
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+using namespace std;
+
+class ConfigurationInfo;
+
+/**
+ * The data and the background of a reaction as one sample:  the events
+ * of the data with their weights, then those of the background with
+ * their weights negated.  The likelihood of a fit with a background is
+ * the sum over the data of w ln I minus the same sum over the background,
+ * with the normalization scaled by the difference of their summed
+ * weights; both are the sum over this sample with signed weights.  The
+ * framework then keeps one set of events and amplitudes per reaction
+ * instead of two and evaluates the data term in one pass over them (one
+ * set of kernels on the GPU), where a background sample has a pass, and a
+ * cache of amplitudes, of its own.
+ *
+ * The readers of the data and the background are made from prototypes
+ * registered with registerDataReader, by name, so a reader that replaces
+ * another one (e.g., ROOTDataReaderGrid) is used here as well.  fuse
+ * rewrites the reactions of a configuration to read their samples through
+ * this reader, and split restores them, e.g., before the configuration is
+ * written with the results of the fit, so that the plotters read the
+ * data and the background as they are given in the configuration file.
+ */
+
+class SignedDataReader : public UserDataReader< SignedDataReader >
+{
+
+public:
+
+  SignedDataReader() : UserDataReader< SignedDataReader >(), m_data( NULL ), m_bkgnd( NULL ),
+    m_inBkgnd( false ) { }
+
+  ~SignedDataReader();
+
+  /**
+   * arguments:
+   *   0:  the name of the reader of the data
+   *   1:  the number n of its arguments
+   *   2 to n + 1:  its arguments
+   *   n + 2:  the name of the reader of the background
+   *   the rest:  its arguments
+   */
+  SignedDataReader( const vector< string >& args );
+
+  string name() const { return "SignedDataReader"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight(){ return true; }
+  virtual unsigned int numEvents() const;
+
+  static void registerDataReader( const DataReader& prototype );
+
+  /**
+   * Makes every reaction of cfgInfo with a background read its data and
+   * background through this reader; returns the number of reactions.
+   */
+  static int fuse( ConfigurationInfo* cfgInfo );
+
+  // the data and background of the reactions of fuse as they were
+  static void split( ConfigurationInfo* cfgInfo );
+
+  // the readers and arguments of the data and the background in args
+  static pair< string, vector< string > > dataSource( const vector< string >& args );
+  static pair< string, vector< string > > bkgndSource( const vector< string >& args );
+
+private:
+
+  static map< string, DataReader* >& prototypes();
+
+  static DataReader* newReader( const pair< string, vector< string > >& source );
+
+  DataReader* m_data;
+  DataReader* m_bkgnd;
+  bool m_inBkgnd;
+};
+
+#endif
@@ -0,0 +1,183 @@
+
+#include <vector>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "TLorentzVector.h"
+
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+#include "AMPTOOLS_DATAIO/KinematicsPool.h"
+#include "AMPTOOLS_DATAIO/BinaryDataFormat.h"
+#include "IUAmpTools/Kinematics.h"
+
+using namespace std;
+
+StreamDataReader::StreamDataReader( const vector< string >& args ):
+  UserDataReader< StreamDataReader >( args ),
+  m_eventCounter( 0 ),
+  m_numEvents( 0 ),
+  m_nPart( 0 ),
+  m_hasWeight( false )
+{
+  assert( args.size() == 1 );
+
+  const string prefix( "callback:" );
+
+  if( args[0].compare( 0, prefix.size(), prefix ) == 0 ){
+
+    readSource( args[0].substr( prefix.size() ) );
+  }
+  else{
+
+    readStream( args[0] );
+  }
+
+  cout << "StreamDataReader:  read " << m_numEvents << " events with "
+       << m_nPart << " particles from " << args[0] << endl;
+}
+
+map< string, StreamDataReader::Source >&
+StreamDataReader::sources()
+{
+  static map< string, Source > registered;
+  return registered;
+}
+
+void
+StreamDataReader::registerSource( const string& name, const Source& source )
+{
+  sources()[name] = source;
+}
+
+void
+StreamDataReader::readSource( const string& sourceName )
+{
+  map< string, Source >::iterator source = sources().find( sourceName );
+
+  if( source == sources().end() ){
+
+    cout << "StreamDataReader ERROR:  no source registered as " << sourceName << endl;
+    assert( false );
+  }
+
+  float weight = 1.0;
+  vector< TLorentzVector > particleList;
+
+  while( source->second( particleList, weight ) ){
+
+    assert( particleList.size() <= Kinematics::kMaxParticles );
+
+    if( m_numEvents == 0 ) m_nPart = particleList.size();
+    assert( static_cast< int >( particleList.size() ) == m_nPart );
+
+    for( int i = 0; i < m_nPart; ++i ){
+
+      m_values.push_back( particleList[i].E() );
+      m_values.push_back( particleList[i].Px() );
+      m_values.push_back( particleList[i].Py() );
+      m_values.push_back( particleList[i].Pz() );
+    }
+
+    // a weight other than one makes the source weighted
+    if( weight != 1.0 ) m_hasWeight = true;
+    m_weight.push_back( weight );
+
+    m_numEvents++;
+    weight = 1.0;
+  }
+}
+
+void
+StreamDataReader::readStream( const string& fileName )
+{
+  FILE* fid = ( fileName == "-" ? stdin : fopen( fileName.c_str(), "rb" ) );
+
+  if( fid == NULL ){
+
+    cout << "StreamDataReader ERROR:  unable to open " << fileName << endl;
+    assert( false );
+  }
+
+  BinaryDataHeader header;
+
+  if( fread( &header, sizeof( header ), 1, fid ) != 1 ||
+      memcmp( header.magic, kBinaryStreamMagic, sizeof( kBinaryStreamMagic ) ) != 0 ||
+      header.version != kBinaryDataVersion ){
+
+    cout << "StreamDataReader ERROR:  " << fileName
+         << " is not a version " << kBinaryDataVersion << " event stream" << endl;
+    assert( false );
+  }
+
+  assert( header.headerSize == sizeof( BinaryDataHeader ) );
+  assert( header.precision == sizeof( float ) ||
+          header.precision == sizeof( double ) );
+  assert( static_cast< int >( header.numParticles ) <= Kinematics::kMaxParticles );
+
+  m_nPart = header.numParticles;
+  m_hasWeight = ( header.hasWeight != 0 );
+
+  unsigned int nValues = 4 * m_nPart + ( m_hasWeight ? 1 : 0 );
+
+  if( header.precision == sizeof( double ) ){
+
+    while( readRecord< double >( fid, nValues ) ) m_numEvents++;
+  }
+  else{
+
+    while( readRecord< float >( fid, nValues ) ) m_numEvents++;
+  }
+
+  if( fid != stdin ) fclose( fid );
+}
+
+template< class T >
+bool
+StreamDataReader::readRecord( FILE* fid, unsigned int nValues )
+{
+  T values[4 * Kinematics::kMaxParticles + 1];
+
+  size_t nRead = fread( values, sizeof( T ), nValues, fid );
+  if( nRead == 0 ) return false;
+
+  if( nRead != nValues ){
+
+    cout << "StreamDataReader ERROR:  the stream ended within an event" << endl;
+    assert( false );
+  }
+
+  for( int i = 0; i < 4 * m_nPart; ++i ) m_values.push_back( values[i] );
+  m_weight.push_back( m_hasWeight ? values[4 * m_nPart] : 1.0 );
+
+  return true;
+}
+
+void
+StreamDataReader::resetSource()
+{
+  // this will cause the read to start back at event 0
+  m_eventCounter = 0;
+}
+
+Kinematics*
+StreamDataReader::getEvent()
+{
+  if( m_eventCounter < m_numEvents ){
+
+    const double* p = &m_values[m_eventCounter * 4 * m_nPart];
+
+    m_particleList.resize( m_nPart );
+    for( int i = 0; i < m_nPart; ++i, p += 4 ){
+
+      m_particleList[i].SetPxPyPzE( p[1], p[2], p[3], p[0] );
+    }
+
+    return new PooledKinematics( m_particleList, m_weight[m_eventCounter++] );
+  }
+  else{
+
+    return NULL;
+  }
+}
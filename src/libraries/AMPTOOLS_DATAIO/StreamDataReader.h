@@ -0,0 +1,86 @@
+#if !defined(STREAMDATAREADER)
+#define STREAMDATAREADER
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+#include "TLorentzVector.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+using namespace std;
+
+/**
+ * This class reads events that are produced while the fit runs, without
+ * an intermediate file:  either the stream of a StreamDataWriter in
+ * another process (see BinaryDataFormat.h), or an in-process generator
+ * that is registered with registerSource.
+ *
+ * The framework asks for the number of events before it loads them, so
+ * the whole source is read into memory when the reader is constructed.
+ * A stream can only be consumed once, by one reader.
+ */
+
+class StreamDataReader : public UserDataReader< StreamDataReader >
+{
+
+public:
+
+  /**
+   * Fills the particle list (beam first) and the weight of the next
+   * event and returns true, or returns false after the last event.
+   */
+  typedef function< bool( vector< TLorentzVector >&, float& ) > Source;
+
+  /**
+   * Default constructor for StreamDataReader
+   */
+  StreamDataReader() : UserDataReader< StreamDataReader >() { }
+
+  /**
+   * Constructor for StreamDataReader
+   * \param[in] args vector of string arguments
+   * arguments:
+   *   0:  "-" for standard input, the name of a pipe or file, or
+   *       "callback:<name>" for a source registered as name
+   */
+  StreamDataReader( const vector< string >& args );
+
+  string name() const { return "StreamDataReader"; }
+
+  virtual Kinematics* getEvent();
+  virtual void resetSource();
+
+  virtual bool hasWeight(){ return m_hasWeight; };
+  virtual unsigned int numEvents() const { return m_numEvents; }
+
+  /**
+   * Makes an in-process generator available as "callback:<name>"; this
+   * must be called before the configuration is parsed.
+   */
+  static void registerSource( const string& name, const Source& source );
+
+private:
+
+  void readStream( const string& fileName );
+  void readSource( const string& sourceName );
+  template< class T > bool readRecord( FILE* fid, unsigned int nValues );
+
+  static map< string, Source >& sources();
+
+  unsigned int m_eventCounter;
+  unsigned int m_numEvents;
+  int m_nPart;
+  bool m_hasWeight;
+
+  // E, Px, Py, Pz of every particle of every event, and the weights
+  vector< double > m_values;
+  vector< float > m_weight;
+
+  vector< TLorentzVector > m_particleList;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "AMPTOOLS_DATAIO/StreamDataWriter.h"
+#include "AMPTOOLS_DATAIO/BinaryDataFormat.h"
+
+StreamDataWriter::StreamDataWriter( const string& outFile, bool writeWeight,
+                                    bool doublePrecision ) :
+  m_fid( NULL ),
+  m_writeWeight( writeWeight ),
+  m_doublePrecision( doublePrecision ),
+  m_eventCounter( 0 ),
+  m_nPart( 0 )
+{
+  m_fid = ( outFile == "-" ? stdout : fopen( outFile.c_str(), "wb" ) );
+
+  if( m_fid == NULL ){
+
+    cout << "StreamDataWriter ERROR:  unable to open " << outFile << endl;
+    assert( false );
+  }
+}
+
+StreamDataWriter::~StreamDataWriter()
+{
+  // an empty stream still needs a header to be read
+  if( m_eventCounter == 0 ) writeHeader();
+
+  if( m_fid == stdout ) fflush( m_fid );
+  else fclose( m_fid );
+}
+
+void
+StreamDataWriter::writeHeader()
+{
+  BinaryDataHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, kBinaryStreamMagic, sizeof( kBinaryStreamMagic ) );
+  header.version = kBinaryDataVersion;
+  header.headerSize = sizeof( BinaryDataHeader );
+  header.numEvents = 0;
+  header.numParticles = m_nPart;
+  header.hasWeight = ( m_writeWeight ? 1 : 0 );
+  header.precision = ( m_doublePrecision ? sizeof( double ) : sizeof( float ) );
+
+  fwrite( &header, sizeof( header ), 1, m_fid );
+}
+
+void
+StreamDataWriter::writeEvent( const Kinematics& kin )
+{
+  const vector< TLorentzVector >& particleList = kin.particleList();
+
+  assert( particleList.size() <= Kinematics::kMaxParticles );
+
+  // the header fixes the number of particles of every event
+  if( m_eventCounter == 0 ){
+
+    m_nPart = particleList.size();
+    writeHeader();
+  }
+  assert( static_cast< int >( particleList.size() ) == m_nPart );
+
+  m_record.clear();
+  for( int i = 0; i < m_nPart; ++i ){
+
+    m_record.push_back( particleList[i].E() );
+    m_record.push_back( particleList[i].Px() );
+    m_record.push_back( particleList[i].Py() );
+    m_record.push_back( particleList[i].Pz() );
+  }
+
+  if( m_writeWeight ) m_record.push_back( kin.weight() );
+
+  if( m_doublePrecision ){
+
+    writeRecord< double >();
+  }
+  else{
+
+    writeRecord< float >();
+  }
+
+  m_eventCounter++;
+}
+
+template< class T >
+void
+StreamDataWriter::writeRecord()
+{
+  T values[4 * Kinematics::kMaxParticles + 1];
+  for( unsigned int i = 0; i < m_record.size(); ++i ) values[i] = m_record[i];
+
+  if( fwrite( values, sizeof( T ), m_record.size(), m_fid ) != m_record.size() ){
+
+    cout << "StreamDataWriter ERROR:  the stream was closed by the reader" << endl;
+    assert( false );
+  }
+}
@@ -0,0 +1,67 @@
+#if !defined(STREAMDATAWRITER)
+#define STREAMDATAWRITER
+
+#include "IUAmpTools/Kinematics.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * This class streams events in the format described in
+ * BinaryDataFormat.h to a pipe, a FIFO, or standard output ("-"), for
+ * a StreamDataReader in another process, e.g.,
+ *
+ *   generator -o - | fit -c toys.cfg
+ *
+ * with "data genData StreamDataReader -" in the configuration file.  Each
+ * event is written when it is passed to writeEvent, so nothing is kept
+ * in memory and no file is created.
+ */
+
+class StreamDataWriter
+{
+
+public:
+
+  /**
+   * Constructor for StreamDataWriter.
+   *
+   * \param[in] outFile name of output pipe or file, "-" for standard output
+   * \param[in] writeWeight (optional) enables writing of the event weight
+   * \param[in] doublePrecision (optional) send values as double instead of float
+   */
+  StreamDataWriter( const string& outFile, bool writeWeight = false,
+                    bool doublePrecision = false );
+
+  /**
+   * Flushes the stream and closes it (except standard output).
+   */
+  ~StreamDataWriter();
+
+  void writeEvent( const Kinematics& kin );
+
+  int eventCounter() const { return m_eventCounter; }
+
+private:
+
+  StreamDataWriter( const StreamDataWriter& );
+  StreamDataWriter& operator=( const StreamDataWriter& );
+
+  void writeHeader();
+  template< class T > void writeRecord();
+
+  FILE* m_fid;
+  bool m_writeWeight;
+  bool m_doublePrecision;
+
+  int m_eventCounter;
+  int m_nPart;
+
+  // the record of the current event
+  vector< double > m_record;
+};
+
+#endif
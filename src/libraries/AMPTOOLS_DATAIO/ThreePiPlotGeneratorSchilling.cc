@@ -7,8 +7,27 @@
 #include "IUAmpTools/Histogram1D.h"
 #include "IUAmpTools/Kinematics.h"
 
+// the histograms, by index
+static const struct { int nBins; double low, high; const char* name; const char* title; }
+kHists[ThreePiPlotGeneratorSchilling::kNumHists] = {
+
+  { 75, 0.6, 0.9, "M3pi", "Invariant Mass of #pi^{+} #pi^{-} #pi^{0}" },
+  { 50, -1., 1., "cosTheta", "cos( #theta ) of #pi^{-}" },
+  { 50, -1., 1., "cosTheta", "cos( #theta ) of #pi^{+}" },
+  { 50, -1., 1., "cosTheta", "cos( #theta ) of #pi^{0}" },
+  { 50, -1*PI, PI, "PhiPiPlus",  "#Phi_{#pi_{+}}" },
+  { 50, -1*PI, PI, "PhiPiMinus", "#Phi_{#pi_{-}}" },
+  { 50, -1*PI, PI, "PhiPi0", "#Phi_{#pi_{0}}" },
+  { 50, -1., 1., "CosTheta", "cos#theta;cos#theta" },
+  { 50, -1*PI, PI, "Phi", "#Phi; #Phi[rad.]" },
+  { 50, -1*PI, PI, "phi", "#phi; #phi[rad.]" },
+  { 50, -1*PI, PI, "psi", "#psi; #psi [rad.]" },
+  { 100, 0, 1.0 , "t", "-t" }
+};
+
 ThreePiPlotGeneratorSchilling::ThreePiPlotGeneratorSchilling( const FitResults& results ) :
-PlotGenerator( results )
+PlotGenerator( results ),
+m_projections( kNumHists )
 {
 
   createHistograms();
@@ -16,7 +35,8 @@ PlotGenerator( results )
 }
 
 ThreePiPlotGeneratorSchilling::ThreePiPlotGeneratorSchilling( ) :
-PlotGenerator( )
+PlotGenerator( ),
+m_projections( kNumHists )
 {
 
   createHistograms();
@@ -25,22 +45,41 @@ PlotGenerator( )
 
 void ThreePiPlotGeneratorSchilling::createHistograms( ) {
   // calls to bookHistogram go here
-  bookHistogram( k3PiMass, new Histogram1D( 75, 0.6, 0.9, "M3pi", "Invariant Mass of #pi^{+} #pi^{-} #pi^{0}") );
-  bookHistogram( kCosThetaPiPlus, new Histogram1D( 50, -1., 1., "cosTheta", "cos( #theta ) of #pi^{+}") );
-  bookHistogram( kCosThetaPiMinus, new Histogram1D( 50, -1., 1., "cosTheta", "cos( #theta ) of #pi^{-}") );
-  bookHistogram( kCosThetaPi0, new Histogram1D( 50, -1., 1., "cosTheta", "cos( #theta ) of #pi^{0}") );
-  bookHistogram( kPhiPiPlus,  new Histogram1D( 50, -1*PI, PI, "PhiPiPlus",  "#Phi_{#pi_{+}}" ) );
-  bookHistogram( kPhiPiMinus, new Histogram1D( 50, -1*PI, PI, "PhiPiMinus", "#Phi_{#pi_{-}}" ) );
-  bookHistogram( kPhiPi0, new Histogram1D( 50, -1*PI, PI, "PhiPi0", "#Phi_{#pi_{0}}" ) );
-  bookHistogram( kCosTheta, new Histogram1D( 50, -1., 1., "CosTheta", "cos#theta;cos#theta" ) );
-  bookHistogram( kPhi, new Histogram1D( 50, -1*PI, PI, "Phi", "#Phi; #Phi[rad.]" ) );
-  bookHistogram( kphi, new Histogram1D( 50, -1*PI, PI, "phi", "#phi; #phi[rad.]" ) );
-  bookHistogram( kPsi, new Histogram1D( 50, -1*PI, PI, "psi", "#psi; #psi [rad.]" ) );
-  bookHistogram( kt, new Histogram1D( 100, 0, 1.0 , "t", "-t" ) );
+
+  for( int hist = 0; hist < kNumHists; ++hist )
+    bookHistogram( hist, new Histogram1D( kHists[hist].nBins, kHists[hist].low, kHists[hist].high,
+                                          kHists[hist].name, kHists[hist].title ) );
+}
+
+string
+ThreePiPlotGeneratorSchilling::histogramName( int hist ){
+
+  return kHists[hist].name;
+}
+
+void
+ThreePiPlotGeneratorSchilling::histogramBinning( int hist, int& nBins, double& low, double& high ){
+
+  nBins = kHists[hist].nBins;
+  low = kHists[hist].low;
+  high = kHists[hist].high;
 }
 
 void
 ThreePiPlotGeneratorSchilling::projectEvent( Kinematics* kin ){
+
+  bool cached;
+  double* values = m_projections.slot( kin, cached );
+  if( !cached ) computeProjections( kin, values );
+
+  // calls to fillHistogram go here
+
+  for( int hist = 0; hist < kNumHists; ++hist )
+    fillHistogram( hist, values[hist] );
+}
+
+void
+ThreePiPlotGeneratorSchilling::computeProjections( Kinematics* kin, double* values ) const {
   
   TLorentzVector beam   = kin->particle( 0 );
   TLorentzVector recoil = kin->particle( 1 );
@@ -87,18 +126,16 @@ ThreePiPlotGeneratorSchilling::projectEvent( Kinematics* kin ){
   // compute invariant t
   GDouble t = - 2* recoil.M() * (recoil.E()-recoil.M());
 
-  // calls to fillHistogram go here
-  
-  fillHistogram( k3PiMass, ( resonance ).M() );
-  fillHistogram( kCosThetaPiPlus, p1_res.CosTheta());
-  fillHistogram( kCosThetaPiMinus, p2_res.CosTheta() );
-  fillHistogram( kCosThetaPi0, p3_res.CosTheta() );
-  fillHistogram( kPhiPiPlus,  p1.Phi() );
-  fillHistogram( kPhiPiMinus, p2.Phi() );
-  fillHistogram( kPhiPi0,     p3.Phi() );
-  fillHistogram( kCosTheta,   cosTheta);
-  fillHistogram( kPhi, Phi );
-  fillHistogram( kphi, phi );
-  fillHistogram( kPsi, psi );
-  fillHistogram( kt, -t );      // fill with -t to make positive
+  values[k3PiMass] = resonance.M();
+  values[kCosThetaPiPlus] = p1_res.CosTheta();
+  values[kCosThetaPiMinus] = p2_res.CosTheta();
+  values[kCosThetaPi0] = p3_res.CosTheta();
+  values[kPhiPiPlus] = p1.Phi();
+  values[kPhiPiMinus] = p2.Phi();
+  values[kPhiPi0] = p3.Phi();
+  values[kCosTheta] = cosTheta;
+  values[kPhi] = Phi;
+  values[kphi] = phi;
+  values[kPsi] = psi;
+  values[kt] = -t;      // fill with -t to make positive
 }
@@ -6,6 +6,8 @@
 
 #include "IUAmpTools/PlotGenerator.h"
 
+#include "AMPTOOLS_DATAIO/ProjectionCache.h"
+
 using namespace std;
 
 class FitResults;
@@ -24,9 +26,21 @@ public:
     
   void projectEvent( Kinematics* kin );
 
+  /**
+   * The quantities of the histograms for kin, indexed like the histograms;
+   * what projectEvent fills.
+   */
+  void computeProjections( Kinematics* kin, double* values ) const;
+
+  // the name and binning of a histogram as it is booked
+  static string histogramName( int hist );
+  static void histogramBinning( int hist, int& nBins, double& low, double& high );
+
 private:
         
   void createHistograms( );
+
+  ProjectionCache m_projections;
   
 };
 
@@ -4,37 +4,102 @@
 #include "TLorentzRotation.h"
 
 #include "AMPTOOLS_DATAIO/TwoPiPlotGenerator.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
 #include "IUAmpTools/Histogram1D.h"
 #include "IUAmpTools/Kinematics.h"
 
+// the histograms, by index
+static const struct { int nBins; double low, high; const char* name; const char* title; }
+kHists[TwoPiPlotGenerator::kNumHists] = {
+
+  { 86, 0.28, 2.0, "M2pi", "Invariant Mass of #pi^{+} #pi^{-}" },
+  { 50, -1., 1., "cosTheta", "cos( #theta ) of Resonance Production" },
+
+  { 50, -1*PI, PI, "PhiPiPlus",  "#Phi_{#pi_{+}}" },
+  { 50, -1*PI, PI, "PhiPiMinus", "#Phi_{#pi_{-}}" },
+  { 50, -1*PI, PI, "Phi", "#Phi" },
+  { 50, -1*PI, PI, "phi", "#phi" },
+  { 50, -1*PI, PI, "psi", "#psi" },
+  { 100, 0, 2.00, "t", "-t" }
+};
+
 TwoPiPlotGenerator::TwoPiPlotGenerator( const FitResults& results ) :
-PlotGenerator( results )
+PlotGenerator( results ),
+m_projections( kNumHists ),
+m_requested( kNumHists, true )
 {
 	createHistograms();
 }
 
 TwoPiPlotGenerator::TwoPiPlotGenerator( ) :
-PlotGenerator( )
+PlotGenerator( ),
+m_projections( kNumHists ),
+m_requested( kNumHists, true )
 {
 	createHistograms();
 }
 
 void TwoPiPlotGenerator::createHistograms() {
   // calls to bookHistogram go here
-  
-  bookHistogram( k2PiMass, new Histogram1D( 86, 0.28, 2.0, "M2pi", "Invariant Mass of #pi^{+} #pi^{-}") );
-  bookHistogram( kPiPCosTheta, new Histogram1D( 50, -1., 1., "cosTheta", "cos( #theta ) of Resonance Production") );
-
-  bookHistogram( kPhiPiPlus,  new Histogram1D( 50, -1*PI, PI, "PhiPiPlus",  "#Phi_{#pi_{+}}" ) );
-  bookHistogram( kPhiPiMinus, new Histogram1D( 50, -1*PI, PI, "PhiPiMinus", "#Phi_{#pi_{-}}" ) );
-  bookHistogram( kPhi, new Histogram1D( 50, -1*PI, PI, "Phi", "#Phi" ) );
-  bookHistogram( kphi, new Histogram1D( 50, -1*PI, PI, "phi", "#phi" ) );
-  bookHistogram( kPsi, new Histogram1D( 50, -1*PI, PI, "psi", "#psi" ) );
-  bookHistogram( kt, new Histogram1D( 100, 0, 2.00, "t", "-t" ) );
+
+  for( int hist = 0; hist < kNumHists; ++hist )
+    bookHistogram( hist, new Histogram1D( kHists[hist].nBins, kHists[hist].low, kHists[hist].high,
+                                          kHists[hist].name, kHists[hist].title ) );
+}
+
+string
+TwoPiPlotGenerator::histogramName( int hist ){
+
+  return kHists[hist].name;
+}
+
+void
+TwoPiPlotGenerator::histogramBinning( int hist, int& nBins, double& low, double& high ){
+
+  nBins = kHists[hist].nBins;
+  low = kHists[hist].low;
+  high = kHists[hist].high;
 }
 
 void
 TwoPiPlotGenerator::projectEvent( Kinematics* kin ){
+
+  bool cached;
+  double* values = m_projections.slot( kin, cached );
+  if( !cached ) computeProjections( kin, values );
+
+  // calls to fillHistogram go here
+
+  for( int hist = 0; hist < kNumHists; ++hist )
+    if( m_requested[hist] ) fillHistogram( hist, values[hist] );
+}
+
+bool
+TwoPiPlotGenerator::requestHistograms( const vector< string >& names ){
+
+  vector< bool > requested( kNumHists, false );
+
+  for( unsigned int i = 0; i < names.size(); ++i ){
+
+    int hist = 0;
+    while( hist < kNumHists && names[i] != kHists[hist].name ) ++hist;
+
+    if( hist == kNumHists ){
+
+      cout << "TwoPiPlotGenerator ERROR:  unknown histogram " << names[i] << endl;
+      return false;
+    }
+    requested[hist] = true;
+  }
+
+  // the cached values of the histograms requested before may be incomplete
+  m_requested = requested;
+  m_projections.clear();
+  return true;
+}
+
+void
+TwoPiPlotGenerator::computeProjections( Kinematics* kin, double* values ) const {
   
   TLorentzVector beam   = kin->particle( 0 );
   TLorentzVector recoil = kin->particle( 1 );
@@ -42,46 +107,37 @@ TwoPiPlotGenerator::projectEvent( Kinematics* kin ){
   TLorentzVector p2 = kin->particle( 3 );
 
   TLorentzVector resonance = p1 + p2; 
-  TLorentzRotation resonanceBoost( -resonance.BoostVector() );
 
-  TLorentzVector recoil_res = resonanceBoost * recoil;
-  TLorentzVector p1_res = resonanceBoost * p1;
+  GDouble kBeam[4] = { beam.E(), beam.Px(), beam.Py(), beam.Pz() };
+  GDouble kRecoil[4] = { recoil.E(), recoil.Px(), recoil.Py(), recoil.Pz() };
+  GDouble kP1[4] = { p1.E(), p1.Px(), p1.Py(), p1.Pz() };
+  GDouble kP2[4] = { p2.E(), p2.Px(), p2.Py(), p2.Pz() };
+
+  // the quantities that each histogram depends on
+  bool needAngles = m_requested[kPiPCosTheta] || m_requested[kphi] || m_requested[kPsi];
+  bool needPolarization = m_requested[kPhi] || m_requested[kPsi];
 
-  // normal to the production plane
-  TVector3 y = (beam.Vect().Unit().Cross(-recoil.Vect().Unit())).Unit();
-  
   // choose helicity frame: z-axis opposite recoil proton in rho rest frame
-  TVector3 z = -1. * recoil_res.Vect().Unit();
-  TVector3 x = y.Cross(z).Unit();
-  TVector3 angles(   (p1_res.Vect()).Dot(x),
-                     (p1_res.Vect()).Dot(y),
-                     (p1_res.Vect()).Dot(z) );
+  GDouble cosTheta = 0, phi = 0;
+  if( needAngles )
+    twoBodyAngles( kHelicityLabNormal, kBeam, kRecoil, kP1, kP2, cosTheta, phi );
 
-  GDouble cosTheta = angles.CosTheta();
-  
-  GDouble phi = angles.Phi();
-  
-  TVector3 eps(1.0, 0.0, 0.0); // beam polarization vector
-  GDouble Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
+  // beam polarization vector along x
+  GDouble Phi = ( needPolarization ? polarizationAngle( kBeam, kRecoil, 1.0, 0.0 ) : 0 );
 
   GDouble psi = phi - Phi;
   if(psi < -1*PI) psi += 2*PI;
   if(psi > PI) psi -= 2*PI;
 
   // compute invariant t
-  GDouble t = - 2* recoil.M() * (recoil.E()-recoil.M());
-
-  // calls to fillHistogram go here
-  
-  fillHistogram( k2PiMass, ( resonance ).M() );
-  
-  fillHistogram( kPiPCosTheta, cosTheta );
-
-  fillHistogram( kPhiPiPlus,  p1.Phi() );
-  fillHistogram( kPhiPiMinus, p2.Phi() );
-  fillHistogram( kPhi, Phi );
-  fillHistogram( kphi, phi );
+  GDouble t = ( m_requested[kt] ? - 2* recoil.M() * (recoil.E()-recoil.M()) : 0 );
 
-  fillHistogram( kPsi, psi );
-  fillHistogram( kt, -t );      // fill with -t to make positive
+  values[k2PiMass] = resonance.M();
+  values[kPiPCosTheta] = cosTheta;
+  values[kPhiPiPlus] = p1.Phi();
+  values[kPhiPiMinus] = p2.Phi();
+  values[kPhi] = Phi;
+  values[kphi] = phi;
+  values[kPsi] = psi;
+  values[kt] = -t;      // fill with -t to make positive
 }
@@ -6,6 +6,8 @@
 
 #include "IUAmpTools/PlotGenerator.h"
 
+#include "AMPTOOLS_DATAIO/ProjectionCache.h"
+
 using namespace std;
 
 class FitResults;
@@ -23,10 +25,34 @@ public:
   TwoPiPlotGenerator( );
 
   void projectEvent( Kinematics* kin );
+
+  /**
+   * Fills only the histograms of the given names (those of
+   * createHistograms); the others stay booked but empty, and the
+   * quantities that only they need are not computed.  Returns false if a
+   * name is unknown.  All histograms are filled by default.
+   */
+  bool requestHistograms( const vector< string >& names );
+
+  bool requested( int hist ) const { return m_requested[hist]; }
+
+  /**
+   * The quantities of the requested histograms for kin, indexed like the
+   * histograms; what projectEvent fills.
+   */
+  void computeProjections( Kinematics* kin, double* values ) const;
+
+  // the name and binning of a histogram as it is booked
+  static string histogramName( int hist );
+  static void histogramBinning( int hist, int& nBins, double& low, double& high );
   
 private:
         
   void createHistograms();
+
+  ProjectionCache m_projections;
+
+  vector< bool > m_requested;
   
 };
 
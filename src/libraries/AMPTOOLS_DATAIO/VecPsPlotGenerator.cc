@@ -7,16 +7,34 @@
 #include "IUAmpTools/Histogram1D.h"
 #include "IUAmpTools/Kinematics.h"
 
+// the histograms, by index
+static const struct { int nBins; double low, high; const char* name; const char* title; }
+kHists[VecPsPlotGenerator::kNumHists] = {
+
+  { 200, 0.6, 2., "MVecPs", "Invariant Mass of Vec+Ps [GeV]" },
+  { 50, -1., 1., "CosTheta", "cos#theta" },
+  { 50, -1*PI, PI, "Phi", "#phi [rad.]" },
+  { 50, -1., 1., "CosTheta_H", "cos#theta_H" },
+  { 50, -1*PI, PI, "Phi_H", "#phi_H [rad.]" },
+  { 50, -1*PI, PI, "Prod_Ang", "Prod_Ang [rad.]" },
+  { 100, 0, 2.0, "t", "-t" },
+  { 100, 0.9, 1.9, "MRecoil", "Invariant Mass of Recoil [GeV]" },
+  { 100, 0.9, 2.9, "MProtonPs", "Invariant Mass of proton and bachelor Ps [GeV]" },
+  { 100, 0.9, 2.9, "MRecoilPs", "Invariant Mass of recoil and bachelor Ps [GeV]" }
+};
+
 /* Constructor to display FitResults */
 VecPsPlotGenerator::VecPsPlotGenerator( const FitResults& results, Option opt ) :
-PlotGenerator( results, opt )
+PlotGenerator( results, opt ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
 
 /* Constructor for event generator (no FitResult) */
 VecPsPlotGenerator::VecPsPlotGenerator( ) :
-PlotGenerator( )
+PlotGenerator( ),
+m_projections( kNumHists )
 {
 	createHistograms();
 }
@@ -24,22 +42,49 @@ PlotGenerator( )
 void VecPsPlotGenerator::createHistograms( ) {
   cout << " calls to bookHistogram go here" << endl;
   
-   bookHistogram( kVecPsMass, new Histogram1D( 200, 0.6, 2., "MVecPs", "Invariant Mass of Vec+Ps [GeV]") );
-   bookHistogram( kCosTheta, new Histogram1D( 50, -1., 1., "CosTheta", "cos#theta" ) );
-   bookHistogram( kPhi, new Histogram1D( 50, -1*PI, PI, "Phi", "#phi [rad.]" ) );
-   bookHistogram( kCosThetaH, new Histogram1D( 50, -1., 1., "CosTheta_H", "cos#theta_H" ) );
-   bookHistogram( kPhiH, new Histogram1D( 50, -1*PI, PI, "Phi_H", "#phi_H [rad.]" ) );
-   bookHistogram( kProd_Ang, new Histogram1D( 50, -1*PI, PI, "Prod_Ang", "Prod_Ang [rad.]" ) );
-   bookHistogram( kt, new Histogram1D( 100, 0, 2.0 , "t", "-t" ) );
-   bookHistogram( kRecoilMass, new Histogram1D( 100, 0.9, 1.9 , "MRecoil", "Invariant Mass of Recoil [GeV]" ) );
-   bookHistogram( kProtonPsMass, new Histogram1D( 100, 0.9, 2.9, "MProtonPs", "Invariant Mass of proton and bachelor Ps [GeV]" ) );
-   bookHistogram( kRecoilPsMass, new Histogram1D( 100, 0.9, 2.9, "MRecoilPs", "Invariant Mass of recoil and bachelor Ps [GeV]" ) );
+   for( int hist = 0; hist < kNumHists; ++hist )
+     bookHistogram( hist, new Histogram1D( kHists[hist].nBins, kHists[hist].low, kHists[hist].high,
+                                           kHists[hist].name, kHists[hist].title ) );
   
 }
 
+string
+VecPsPlotGenerator::histogramName( int hist ){
+
+  return kHists[hist].name;
+}
+
+void
+VecPsPlotGenerator::histogramBinning( int hist, int& nBins, double& low, double& high ){
+
+  nBins = kHists[hist].nBins;
+  low = kHists[hist].low;
+  high = kHists[hist].high;
+}
+
 void
 VecPsPlotGenerator::projectEvent( Kinematics* kin ){
 
+   bool cached;
+   double* values = m_projections.slot( kin, cached );
+   if( !cached ) computeProjections( kin, values );
+
+   //cout << "calls to fillHistogram go here" << endl;
+   fillHistogram( kVecPsMass, values[kVecPsMass] );
+   fillHistogram( kCosTheta, values[kCosTheta] );
+   fillHistogram( kPhi, values[kPhi] );
+   fillHistogram( kCosThetaH, values[kCosThetaH] );
+   fillHistogram( kPhiH, values[kPhiH] );
+   fillHistogram( kProd_Ang, values[kProd_Ang] );
+   fillHistogram( kt, values[kt] );
+   fillHistogram( kRecoilMass, values[kRecoilMass] );
+   fillHistogram( kProtonPsMass, values[kProtonPsMass] );
+   fillHistogram( kRecoilPsMass, values[kRecoilPsMass] );
+}
+
+void
+VecPsPlotGenerator::computeProjections( Kinematics* kin, double* values ) const {
+
    //cout << "project event" << endl;
    TLorentzVector beam   = kin->particle( 0 );
    TLorentzVector recoil = kin->particle( 1 );
@@ -82,33 +127,33 @@ VecPsPlotGenerator::projectEvent( Kinematics* kin ){
    TLorentzVector Gammap = beam + target;
 
    // Calculate decay angles in helicity frame (same for all vectors)
-   vector <double> locthetaphi = getomegapiAngles(polAngle, vec, X, beam, Gammap);
+   OmegaPiProductionAngles< double > locthetaphi =
+      omegapiProductionAngles(omegapiP4(vec), omegapiP4(X), omegapiP4(beam), omegapiP4(Gammap));
 
    // Calculate vector decay angles (unique for each vector)
-   vector <double> locthetaphih;
-   if(m_3pi) locthetaphih = getomegapiAngles(vec_daught1, vec, X, Gammap, vec_daught2);
-   else locthetaphih = getomegapiAngles(vec_daught1, vec, X, Gammap, TLorentzVector(0,0,0,0));
+   OmegaPiDecayAngles< double > locthetaphih =
+      omegapiDecayAngles(omegapiP4(vec_daught1), omegapiP4(vec), omegapiP4(X), omegapiP4(Gammap),
+                         m_3pi ? omegapiP4(vec_daught2) : omegapiP4(0., 0., 0., 0.));
 
    double Mandt = fabs((target-recoil).M2());
    double recoil_mass = recoil.M();  
 
-   GDouble cosTheta = TMath::Cos(locthetaphi[0]);
-   GDouble Phi = locthetaphi[1];
-   GDouble cosThetaH = TMath::Cos(locthetaphih[0]);
-   GDouble PhiH = locthetaphih[1];
-   GDouble prod_angle = locthetaphi[2];
-
-   //cout << "calls to fillHistogram go here" << endl;
-   fillHistogram( kVecPsMass, X.M() );
-   fillHistogram( kCosTheta, cosTheta );
-   fillHistogram( kPhi, Phi );
-   fillHistogram( kCosThetaH, cosThetaH );
-   fillHistogram( kPhiH, PhiH );
-   fillHistogram( kProd_Ang, prod_angle );
-   fillHistogram( kt, Mandt );
-   fillHistogram( kRecoilMass, recoil_mass );
-   fillHistogram( kProtonPsMass, proton_ps.M() );
-   fillHistogram( kRecoilPsMass, recoil_ps.M() );
+   GDouble cosTheta = TMath::Cos(locthetaphi.theta);
+   GDouble Phi = locthetaphi.phi;
+   GDouble cosThetaH = TMath::Cos(locthetaphih.theta);
+   GDouble PhiH = locthetaphih.phi;
+   GDouble prod_angle = locthetaphi.bigPhi;
+
+   values[kVecPsMass] = X.M();
+   values[kCosTheta] = cosTheta;
+   values[kPhi] = Phi;
+   values[kCosThetaH] = cosThetaH;
+   values[kPhiH] = PhiH;
+   values[kProd_Ang] = prod_angle;
+   values[kt] = Mandt;
+   values[kRecoilMass] = recoil_mass;
+   values[kProtonPsMass] = proton_ps.M();
+   values[kRecoilPsMass] = recoil_ps.M();
 
 }
 
@@ -0,0 +1,108 @@
+
+#include <complex>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "AMPTOOLS_DATAIO/WavePruner.h"
+
+WavePruner::WavePruner( ConfigurationInfo* cfgInfo ) :
+  m_cfgInfo( cfgInfo ),
+  m_numAmps( 0 )
+{}
+
+int
+WavePruner::prune(){
+
+  m_droppedAmps.clear();
+  m_droppedPars.clear();
+
+  vector< AmplitudeInfo* > amps = m_cfgInfo->amplitudeList();
+  m_numAmps = amps.size();
+
+  // a fixed zero is shared by the amplitudes constrained to it
+  set< AmplitudeInfo* > zero;
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+
+    if( !amps[i]->fixed() || amps[i]->value() != complex< double >( 0, 0 ) ) continue;
+
+    zero.insert( amps[i] );
+    vector< AmplitudeInfo* > partners = amps[i]->constraints();
+    zero.insert( partners.begin(), partners.end() );
+  }
+
+  if( zero.empty() ) return 0;
+
+  vector< ReactionInfo* > reactions = m_cfgInfo->reactionList();
+  for( unsigned int r = 0; r < reactions.size(); ++r ){
+
+    string reactionName = reactions[r]->reactionName();
+    vector< AmplitudeInfo* > reactionAmps = m_cfgInfo->amplitudeList( reactionName );
+
+    unsigned int numZero = 0;
+    for( unsigned int i = 0; i < reactionAmps.size(); ++i )
+      if( zero.count( reactionAmps[i] ) ) ++numZero;
+
+    if( numZero == reactionAmps.size() ){
+
+      cout << "WavePruner WARNING:  every amplitude of reaction " << reactionName
+           << " is fixed to zero, none of them is dropped" << endl;
+      for( unsigned int i = 0; i < reactionAmps.size(); ++i ) zero.erase( reactionAmps[i] );
+    }
+  }
+
+  // the parameters that the amplitudes that stay still use
+  set< string > usedPars;
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+
+    if( zero.count( amps[i] ) ) continue;
+
+    vector< ParameterInfo* > pars = amps[i]->parameters();
+    for( unsigned int j = 0; j < pars.size(); ++j ) usedPars.insert( pars[j]->parName() );
+
+    string scale = amps[i]->scale();
+    if( scale.size() > 2 && scale[0] == '[' )
+      usedPars.insert( scale.substr( 1, scale.size() - 2 ) );
+  }
+
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+
+    if( !zero.count( amps[i] ) ) continue;
+
+    m_droppedAmps.push_back( amps[i]->fullName() );
+    m_cfgInfo->removeAmplitude( amps[i]->reactionName(), amps[i]->sumName(),
+                                amps[i]->ampName() );
+  }
+
+  vector< ParameterInfo* > pars = m_cfgInfo->parameterList();
+  for( unsigned int i = 0; i < pars.size(); ++i ){
+
+    string parName = pars[i]->parName();
+    if( usedPars.count( parName ) ) continue;
+
+    m_droppedPars.push_back( parName );
+    m_cfgInfo->removeParameter( parName );
+  }
+
+  return m_droppedAmps.size();
+}
+
+void
+WavePruner::print( ostream& out ) const {
+
+  out << "WAVE PRUNING:  " << m_droppedAmps.size() << " of " << m_numAmps
+      << " amplitudes are fixed to zero and are not computed" << endl;
+
+  for( unsigned int i = 0; i < m_droppedAmps.size(); ++i )
+    out << "   " << m_droppedAmps[i] << endl;
+
+  if( m_droppedPars.size() != 0 ){
+
+    out << "   parameters only used by them:";
+    for( unsigned int i = 0; i < m_droppedPars.size(); ++i ) out << " " << m_droppedPars[i];
+    out << endl;
+  }
+}
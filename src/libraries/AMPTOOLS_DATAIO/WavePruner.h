@@ -0,0 +1,56 @@
+#if !defined(WAVEPRUNER)
+#define WAVEPRUNER
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class ConfigurationInfo;
+
+/**
+ * Drops the amplitudes of a configuration that cannot contribute to the
+ * intensity:  those whose production coefficient is fixed to zero, with
+ * the amplitudes constrained to them.  Wave-set scans and random-restart
+ * studies often switch waves off this way, and the framework would still
+ * compute their user variables and amplitudes for every event (on the GPU
+ * with a kernel launch per amplitude) and their normalization integrals.
+ * Parameters that were only used by the dropped amplitudes are removed as
+ * well, so that they do not become flat directions of the fit.
+ *
+ * A reaction keeps all of its amplitudes if every one of them would be
+ * dropped.  The dropped amplitudes are not in the fit results.
+ *
+ * Usage:  call prune after the configuration is parsed and before the
+ * amplitudes are registered and the AmpToolsInterface is built.
+ */
+
+class WavePruner
+{
+
+public:
+
+  WavePruner( ConfigurationInfo* cfgInfo );
+
+  /**
+   * Removes the amplitudes and parameters from the configuration and
+   * returns the number of amplitudes removed.
+   */
+  int prune();
+
+  void print( ostream& out = cout ) const;
+
+  const vector< string >& droppedAmplitudes() const { return m_droppedAmps; }
+  const vector< string >& droppedParameters() const { return m_droppedPars; }
+
+private:
+
+  ConfigurationInfo* m_cfgInfo;
+
+  unsigned int m_numAmps;
+  vector< string > m_droppedAmps;
+  vector< string > m_droppedPars;
+};
+
+#endif
@@ -0,0 +1,199 @@
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "AMPTOOLS_AMPS/clebschGordan.h"
+
+#include "AMPTOOLS_MOMENTS/MomentCoefficients.h"
+
+namespace {
+
+  double sign( int m ){
+
+    return ( m % 2 == 0 ? 1. : -1. );
+  }
+
+  // <l2 m2; L M | l1 m1>, zero for unphysical projections
+  double cg( int l2, int L, int m2, int M, int l1, int m1 ){
+
+    if( abs( m2 ) > l2 || abs( m1 ) > l1 ) return 0;
+    return clebschGordan( l2, L, m2, M, l1, m1 );
+  }
+
+  // the coefficient of w1 w2* in H_alpha(L,M)
+  complex< double > coefficient( int alpha, int L, int M,
+                                 const MomentCoefficients::Wave& w1,
+                                 const MomentCoefficients::Wave& w2 ){
+
+    const complex< double > ui( 0, 1 );
+    double eps = w1.reflectivity;
+    int l1 = w1.l, m1 = w1.m;
+    int l2 = w2.l, m2 = w2.m;
+
+    double common = sqrt( ( 2. * l2 + 1. ) / ( 2. * l1 + 1. ) ) * cg( l2, L, 0, 0, l1, 0 );
+    if( common == 0 ) return 0;
+
+    switch( alpha ){
+
+      case 0:
+        return common * ( cg( l2, L, m2, M, l1, m1 ) +
+                          sign( m2 - m1 ) * cg( l2, L, -m2, M, l1, -m1 ) );
+      case 1:
+        return common * eps * ( sign( m1 ) * cg( l2, L, m2, M, l1, -m1 ) +
+                                sign( m2 ) * cg( l2, L, -m2, M, l1, m1 ) );
+      case 2:
+        return -common * ui * eps * ( -sign( m1 ) * cg( l2, L, m2, M, l1, -m1 ) +
+                                       sign( m2 ) * cg( l2, L, -m2, M, l1, m1 ) );
+      default:
+        return -common * ( cg( l2, L, m2, M, l1, m1 ) -
+                           sign( m2 - m1 ) * cg( l2, L, -m2, M, l1, -m1 ) );
+    }
+  }
+}
+
+MomentCoefficients::MomentCoefficients( const vector< Wave >& waves, int maxL ) :
+  m_maxL( maxL ),
+  m_numLM( ( maxL + 1 ) * ( maxL + 2 ) / 2 )
+{
+  // the coefficients of every moment, per wave pair
+  vector< vector< Term > > terms( numMoments() );
+
+  for( size_t i1 = 0; i1 < waves.size(); ++i1 ){
+    for( size_t i2 = 0; i2 < waves.size(); ++i2 ){
+
+      if( waves[i1].sum != waves[i2].sum ) continue;
+
+      size_t pair = m_first.size();
+      bool used = false;
+
+      for( int alpha = 0; alpha < kNumAlpha; ++alpha ){
+        for( int L = 0; L <= maxL; ++L ){
+          for( int M = 0; M <= L; ++M ){
+
+            complex< double > c = coefficient( alpha, L, M, waves[i1], waves[i2] );
+            if( c == 0. ) continue;
+
+            Term term = { pair, c };
+            terms[index( alpha, L, M )].push_back( term );
+            used = true;
+          }
+        }
+      }
+
+      if( !used ) continue;
+
+      m_first.push_back( waves[i1].index );
+      m_second.push_back( waves[i2].index );
+      m_parameters.push_back( waves[i1].index );
+      m_parameters.push_back( waves[i1].index + 1 );
+    }
+  }
+
+  m_begin.push_back( 0 );
+  for( size_t k = 0; k < terms.size(); ++k ){
+
+    m_terms.insert( m_terms.end(), terms[k].begin(), terms[k].end() );
+    m_begin.push_back( m_terms.size() );
+  }
+
+  sort( m_parameters.begin(), m_parameters.end() );
+  m_parameters.erase( unique( m_parameters.begin(), m_parameters.end() ), m_parameters.end() );
+}
+
+void
+MomentCoefficients::moments( const double* x, complex< double >* H ) const {
+
+  vector< complex< double > > bilinears( m_first.size() );
+  for( size_t p = 0; p < m_first.size(); ++p ){
+
+    complex< double > z1( x[m_first[p]], x[m_first[p] + 1] );
+    complex< double > z2( x[m_second[p]], x[m_second[p] + 1] );
+    bilinears[p] = z1 * conj( z2 );
+  }
+
+  for( size_t k = 0; k < numMoments(); ++k ){
+
+    complex< double > sum = 0;
+    for( size_t t = m_begin[k]; t < m_begin[k + 1]; ++t )
+      sum += m_terms[t].coefficient * bilinears[m_terms[t].pair];
+    H[k] = sum;
+  }
+}
+
+void
+MomentCoefficients::realJacobian( const double* x, vector< vector< double > >& jacobian ) const {
+
+  // the column of each parameter
+  vector< size_t > column( m_parameters.empty() ? 0 : m_parameters.back() + 1 );
+  for( size_t i = 0; i < m_parameters.size(); ++i ) column[m_parameters[i]] = i;
+
+  jacobian.assign( numMoments(), vector< double >( m_parameters.size(), 0. ) );
+
+  for( size_t k = 0; k < numMoments(); ++k ){
+    for( size_t t = m_begin[k]; t < m_begin[k + 1]; ++t ){
+
+      size_t i1 = m_first[m_terms[t].pair];
+      size_t i2 = m_second[m_terms[t].pair];
+      complex< double > z1( x[i1], x[i1 + 1] );
+      complex< double > z2( x[i2], x[i2 + 1] );
+
+      // Re( c z1 z2* ) with respect to Re z1, Im z1, Re z2 and Im z2
+      complex< double > d1 = m_terms[t].coefficient * conj( z2 );
+      complex< double > d2 = m_terms[t].coefficient * z1;
+
+      jacobian[k][column[i1]] += d1.real();
+      jacobian[k][column[i1 + 1]] -= d1.imag();
+      jacobian[k][column[i2]] += d2.real();
+      jacobian[k][column[i2 + 1]] += d2.imag();
+    }
+  }
+}
+
+void
+MomentCoefficients::realCovariance( const double* x, const vector< vector< double > >& errorMatrix,
+                                    vector< vector< double > >& covariance ) const {
+
+  assert( m_parameters.empty() || m_parameters.back() < errorMatrix.size() );
+
+  vector< vector< double > > jacobian;
+  realJacobian( x, jacobian );
+
+  size_t nPar = m_parameters.size();
+  size_t nMom = numMoments();
+
+  // J V
+  vector< vector< double > > jv( nMom, vector< double >( nPar, 0. ) );
+  for( size_t k = 0; k < nMom; ++k ){
+    for( size_t a = 0; a < nPar; ++a ){
+
+      double j = jacobian[k][a];
+      if( j == 0 ) continue;
+
+      const vector< double >& row = errorMatrix[m_parameters[a]];
+      for( size_t b = 0; b < nPar; ++b ) jv[k][b] += j * row[m_parameters[b]];
+    }
+  }
+
+  // ( J V ) J^T
+  covariance.assign( nMom, vector< double >( nMom, 0. ) );
+  for( size_t k = 0; k < nMom; ++k ){
+    for( size_t l = 0; l <= k; ++l ){
+
+      double sum = 0;
+      for( size_t b = 0; b < nPar; ++b ) sum += jv[k][b] * jacobian[l][b];
+      covariance[k][l] = covariance[l][k] = sum;
+    }
+  }
+}
+
+void
+MomentCoefficients::realErrors( const double* x, const vector< vector< double > >& errorMatrix,
+                                double* errors ) const {
+
+  vector< vector< double > > covariance;
+  realCovariance( x, errorMatrix, covariance );
+
+  for( size_t k = 0; k < numMoments(); ++k )
+    errors[k] = sqrt( max( covariance[k][k], 0. ) );
+}
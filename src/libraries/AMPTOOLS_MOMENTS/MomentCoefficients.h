@@ -0,0 +1,100 @@
+#if !defined(MOMENTCOEFFICIENTS)
+#define MOMENTCOEFFICIENTS
+
+#include <complex>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The moments H_alpha(L,M) of a set of partial waves as linear combinations
+ * of the bilinears z1 z2* of the production amplitudes.  The Clebsch-Gordan
+ * products of a combination depend only on the waves, so they are computed
+ * once for all alpha = 0 (unpolarized) and 1, 2, 3 (polarized), L <= maxL
+ * and 0 <= M <= L, and only the non-zero ones are kept.  A fit result then
+ * costs one pass over its bilinears and one pass over the coefficients:
+ *
+ *   H = C b,   b_p = z1(p) z2(p)*
+ *
+ * and the covariance of the real parts of H is J V J^T, with J the
+ * derivatives of Re H with respect to the fit parameters and V their error
+ * matrix.  Waves interfere only with waves of the same coherent sum.
+ *
+ * Usage with the parameters of a FitResults:
+ *
+ *   MomentCoefficients coeffs( waves, maxL );
+ *   vector< complex< double > > H( coeffs.numMoments() );
+ *   vector< double > errors( coeffs.numMoments() );
+ *   coeffs.moments( &( x[0] ), &( H[0] ) );
+ *   coeffs.realErrors( &( x[0] ), results.errorMatrix(), &( errors[0] ) );
+ *   H[coeffs.index( alpha, L, M )];
+ */
+
+class MomentCoefficients
+{
+
+public:
+
+  // the real part of the production amplitude is x[index] and the
+  // imaginary part x[index + 1]
+  struct Wave {
+
+    Wave( int sum_, int reflectivity_, int l_, int m_, size_t index_ ) :
+      sum( sum_ ), reflectivity( reflectivity_ ), l( l_ ), m( m_ ), index( index_ ) {}
+
+    int sum;
+    int reflectivity;
+    int l, m;
+    size_t index;
+  };
+
+  enum { kNumAlpha = 4 };
+
+  MomentCoefficients( const vector< Wave >& waves, int maxL );
+
+  int maxL() const { return m_maxL; }
+  size_t numMoments() const { return kNumAlpha * m_numLM; }
+  size_t index( int alpha, int L, int M ) const {
+
+    return alpha * m_numLM + L * ( L + 1 ) / 2 + M;
+  }
+
+  // all moments of the parameters x
+  void moments( const double* x, complex< double >* H ) const;
+
+  // the covariance matrix of the real parts of all moments, from the error
+  // matrix of the parameters x
+  void realCovariance( const double* x, const vector< vector< double > >& errorMatrix,
+                       vector< vector< double > >& covariance ) const;
+
+  // the square roots of its diagonal
+  void realErrors( const double* x, const vector< vector< double > >& errorMatrix,
+                   double* errors ) const;
+
+private:
+
+  struct Term {
+
+    size_t pair;
+    complex< double > coefficient;
+  };
+
+  // the derivatives of Re H with respect to the parameters m_parameters
+  void realJacobian( const double* x, vector< vector< double > >& jacobian ) const;
+
+  int m_maxL;
+  size_t m_numLM;
+
+  // the bilinears:  the amplitudes of both waves of each pair
+  vector< size_t > m_first;
+  vector< size_t > m_second;
+
+  // the terms of moment k are m_terms[m_begin[k]] to m_terms[m_begin[k+1]]
+  vector< Term > m_terms;
+  vector< size_t > m_begin;
+
+  // the indices of the parameters that enter any moment
+  vector< size_t > m_parameters;
+};
+
+#endif
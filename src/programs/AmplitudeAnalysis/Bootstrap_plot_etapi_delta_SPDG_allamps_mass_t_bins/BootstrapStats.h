@@ -0,0 +1,154 @@
+#if !defined(BOOTSTRAPSTATS)
+#define BOOTSTRAPSTATS
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Single-pass summaries of the values of a quantity over the bootstrap
+// replicas of a bin, so that the memory per bin does not grow with the
+// number of replicas.
+
+// the mean and variance by Welford's update
+class RunningStats
+{
+
+public:
+
+  RunningStats() : m_count( 0 ), m_mean( 0 ), m_m2( 0 ) {}
+
+  void add( double x ){
+
+    ++m_count;
+    double delta = x - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * ( x - m_mean );
+  }
+
+  double count() const { return m_count; }
+  double mean() const { return m_mean; }
+  double variance() const { return ( m_count > 1 ? m_m2 / ( m_count - 1 ) : 0 ); }
+  double stddev() const { return sqrt( variance() ); }
+
+private:
+
+  double m_count;
+  double m_mean;
+  double m_m2;
+};
+
+// Approximate quantiles from a sketch of levels of at most k values:  a
+// full level is sorted and every other value moves up to the next level,
+// where each stands for twice as many replicas.  The memory is about
+// k log2( n / k ) values for n replicas and the rank error of a quantile
+// is of order log2( n / k ) / k.  Below k replicas the quantiles are
+// exact.
+class QuantileSketch
+{
+
+public:
+
+  explicit QuantileSketch( size_t k = 128 ) : m_k( k ), m_odd( false ) {}
+
+  void add( double x ){
+
+    if( m_levels.empty() ) m_levels.resize( 1 );
+    m_levels[0].push_back( x );
+    if( m_levels[0].size() >= m_k ) compact( 0 );
+  }
+
+  // the value below which a fraction q of the replicas lie
+  double quantile( double q ) const {
+
+    vector< pair< double, double > > weighted;
+    double total = 0;
+    for( size_t h = 0; h < m_levels.size(); ++h ){
+
+      double weight = ldexp( 1.0, h );
+      for( size_t i = 0; i < m_levels[h].size(); ++i )
+        weighted.push_back( make_pair( m_levels[h][i], weight ) );
+      total += weight * m_levels[h].size();
+    }
+    if( weighted.empty() ) return 0;
+
+    sort( weighted.begin(), weighted.end() );
+
+    double below = 0;
+    for( size_t i = 0; i < weighted.size(); ++i ){
+
+      below += weighted[i].second;
+      if( below >= q * total ) return weighted[i].first;
+    }
+    return weighted.back().first;
+  }
+
+private:
+
+  // the offset of the values kept alternates, so the compactions do not
+  // all drop the larger or all the smaller value of each pair
+  void compact( size_t h ){
+
+    if( m_levels.size() == h + 1 ) m_levels.resize( h + 2 );
+
+    vector< double >& level = m_levels[h];
+    sort( level.begin(), level.end() );
+
+    // an odd value out stays at this level
+    double rest = 0;
+    bool hasRest = ( level.size() % 2 == 1 );
+    if( hasRest ){
+
+      rest = level.back();
+      level.pop_back();
+    }
+
+    for( size_t i = ( m_odd ? 1 : 0 ); i < level.size(); i += 2 )
+      m_levels[h + 1].push_back( level[i] );
+    m_odd = !m_odd;
+
+    level.clear();
+    if( hasRest ) level.push_back( rest );
+
+    if( m_levels[h + 1].size() >= m_k ) compact( h + 1 );
+  }
+
+  size_t m_k;
+  bool m_odd;
+  vector< vector< double > > m_levels;
+};
+
+// the summary of one quantity; a phase is taken within pi of the running
+// mean, so a phase near +-pi does not split into two
+class BootstrapQuantity
+{
+
+public:
+
+  BootstrapQuantity( bool isPhase = false ) : m_isPhase( isPhase ) {}
+
+  void add( double x, bool withQuantiles ){
+
+    if( m_isPhase && m_stats.count() > 0 ){
+
+      while( x - m_stats.mean() > M_PI ) x -= 2 * M_PI;
+      while( x - m_stats.mean() < -M_PI ) x += 2 * M_PI;
+    }
+
+    m_stats.add( x );
+    if( withQuantiles ) m_sketch.add( x );
+  }
+
+  const RunningStats& stats() const { return m_stats; }
+  const QuantileSketch& sketch() const { return m_sketch; }
+
+private:
+
+  bool m_isPhase;
+  RunningStats m_stats;
+  QuantileSketch m_sketch;
+};
+
+#endif
@@ -6,6 +6,10 @@
 #include <vector>
 #include <cassert>
 #include <cstdlib>
+#include <complex>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <unistd.h>
 
 #include "IUAmpTools/FitResults.h"
@@ -14,10 +18,140 @@
 
 #include "wave.h"
 #include "moment.h"
+#include "BootstrapStats.h"
 
 #include "TFile.h"
 
 
+// the names of the quantities of the summary:  the intensity of every wave
+// in both sums, the phase of every wave but the first to the first in the
+// first sum, and the real parts of the moments H0 and H1
+vector< string > quantityNames( const waveset& ws, size_t LMAX ){
+
+  vector< string > names;
+  for (size_t i = 0; i < ws.size(); i++)
+    for (size_t j = 0; j < ws[i].waves.size(); j++)
+      names.push_back( "I_" + ws[i].waves[j].getName() );
+  for (size_t i = 0; i < ws.size(); i++)
+    for (size_t j = 0; j < ws[i].waves.size(); j++)
+      if( i != 0 || j != 0 ) names.push_back( "phi_" + ws[i].waves[j].getName() );
+  for (size_t L = 0; L <= LMAX; L++)
+    for (size_t M = 0; M <= L; M++){
+      ostringstream lm;
+      lm << L << M;
+      names.push_back( "H0_" + lm.str() );
+      names.push_back( "H1_" + lm.str() );
+    }
+  return names;
+}
+
+// a replica of a bin:  its row of the table and, if its fit is valid, the
+// quantities of quantityNames
+struct Replica {
+  bool valid;
+  string row;
+  vector< double > values;
+};
+
+Replica readReplica( int i, const waveset& ws, const MomentCoefficients& coeffs, size_t LMAX,
+                     double mass, double t, vector< complex<double> >& H ){
+
+  Replica replica;
+
+  ostringstream resultsFile;
+  resultsFile << "bin_bs_" << i << ".fit";
+  FitResults results( resultsFile.str().c_str() );
+  replica.valid = results.valid();
+
+  ostringstream row;
+  row << mass << "\t" << t << "\t";
+
+  if( !replica.valid ){
+    for (size_t L = 0; L <= LMAX; L++)
+      for (size_t M = 0; M <= L; M++){
+        row << 0 << "\t" << 0 << "\t";
+        row << 0 << "\t" << 0 << "\t";
+      }
+    row << endl;
+    replica.row = row.str();
+    return replica;
+  }
+
+  vector< double > x = results.parValueList();
+  coeffs.moments( &x[0], &H[0] );
+
+  // each wave has the real and imaginary parts of its amplitude in both
+  // sums, one after the other
+  for (size_t i = 0; i < ws.size(); i++)
+    for (size_t j = 0; j < ws[i].waves.size(); j++){
+      size_t idx = ws[i].waves[j].getIndex();
+      replica.values.push_back( x[idx] * x[idx] + x[idx+1] * x[idx+1] + x[idx+2] * x[idx+2] + x[idx+3] * x[idx+3] );
+    }
+  size_t first = ws[0].waves[0].getIndex();
+  complex<double> reference( x[first], x[first+1] );
+  for (size_t i = 0; i < ws.size(); i++)
+    for (size_t j = 0; j < ws[i].waves.size(); j++){
+      if( i == 0 && j == 0 ) continue;
+      size_t idx = ws[i].waves[j].getIndex();
+      replica.values.push_back( arg( complex<double>( x[idx], x[idx+1] ) * conj( reference ) ) );
+    }
+
+  for (size_t L = 0; L <= LMAX; L++)
+    for (size_t M = 0; M <= L; M++){
+      row << real(H[coeffs.index(0, L, M)]) << "\t" << 0 << "\t";
+      row << real(H[coeffs.index(1, L, M)]) << "\t" << 0 << "\t";
+      replica.values.push_back( real(H[coeffs.index(0, L, M)]) );
+      replica.values.push_back( real(H[coeffs.index(1, L, M)]) );
+    }
+  row << endl;
+  replica.row = row.str();
+
+  return replica;
+}
+
+// Reads the replicas of the bin in the current directory on numThreads
+// threads, which each read the next replica that no thread has taken.  The
+// rows go to the table and the quantities to the summary in the order of
+// the replicas, so both are the same for any number of threads, and only
+// the replicas being read are held.
+void readBin( int numReplicas, int numThreads, const waveset& ws, const MomentCoefficients& coeffs,
+              size_t LMAX, double mass, double t, ofstream& table,
+              vector< BootstrapQuantity >& summary, bool withQuantiles, int& numFailed ){
+
+  int next = 0, done = 0;
+  mutex lock;
+  condition_variable turn;
+
+  auto work = [&](){
+    vector< complex<double> > H( coeffs.numMoments() );
+    while( true ){
+      int i;
+      {
+        lock_guard< mutex > guard( lock );
+        i = next++;
+      }
+      if( i >= numReplicas ) return;
+
+      Replica replica = readReplica( i, ws, coeffs, LMAX, mass, t, H );
+
+      unique_lock< mutex > guard( lock );
+      turn.wait( guard, [&](){ return done == i; } );
+      cout << "Results from bootstrap " << i << endl;
+      table << replica.row;
+      if( replica.valid )
+        for (size_t q = 0; q < summary.size(); q++) summary[q].add( replica.values[q], withQuantiles );
+      else
+        ++numFailed;
+      ++done;
+      turn.notify_all();
+    }
+  };
+
+  vector< thread > threads;
+  for (int w = 1; w < numThreads; w++) threads.push_back( thread( work ) );
+  work();
+  for (size_t w = 0; w < threads.size(); w++) threads[w].join();
+}
 
 
 int main( int argc, char* argv[] ){
@@ -29,13 +163,16 @@ int main( int argc, char* argv[] ){
     double lowt = 0;
     double hight = 1.2;
     enum{ kNumBinst = 4 };
-    enum{ kNumBins_Bootstrap = 100};
+    int numBootstrap = 100;
 
     string fitDir( "EtaPi_fit/" );
                    
     // set default parameters
     
     string outfileName("");
+    string summaryName("bootstrap_summary.txt");
+    int numThreads = 1;
+    bool withQuantiles = false;
     
     // parse command line
     
@@ -46,10 +183,24 @@ int main( int argc, char* argv[] ){
         if (arg == "-o"){
             if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
             else  outfileName = argv[++i]; }
+        if (arg == "-s"){
+            if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+            else  summaryName = argv[++i]; }
+        if (arg == "-b"){
+            if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+            else  numBootstrap = atoi(argv[++i]); }
+        if (arg == "-w"){
+            if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+            else  numThreads = max(1, atoi(argv[++i])); }
+        if (arg == "-q") withQuantiles = true;
         
         if (arg == "-h"){
             cout << endl << " Usage for: " << argv[0] << endl << endl;
             cout << "\t -o <file>\t Ouput text file" << endl;
+            cout << "\t -s <file>\t Summary of the replicas of every bin (default: bootstrap_summary.txt)" << endl;
+            cout << "\t -b <int>\t Number of bootstrap replicas per bin (default: 100)" << endl;
+            cout << "\t -w <int>\t Read the replicas of a bin on <int> threads" << endl;
+            cout << "\t -q \t\t Also write the 16%, 50% and 84% quantiles of every quantity to the summary" << endl;
             exit(1);}
         
         
@@ -103,6 +254,20 @@ int main( int argc, char* argv[] ){
   size_t LMAX,MMAX;    //highest wave
   Biggest_lm(ws, &LMAX, &MMAX);
 
+  // the coefficients of the moments are the same in every bin
+  MomentCoefficients coeffs(momentWaves(ws), LMAX);
+
+  // the mean and spread of every quantity over the replicas, one row per
+  // bin, written as each bin is done
+  vector< string > names = quantityNames(ws, LMAX);
+  ofstream summaryFile( summaryName.c_str() );
+  summaryFile << "M\tt\treplicas\tfailed";
+  for (size_t q = 0; q < names.size(); q++){
+    summaryFile << "\t" << names[q] << "\t" << names[q] << "_err";
+    if (withQuantiles) summaryFile << "\t" << names[q] << "_q16\t" << names[q] << "_q50\t" << names[q] << "_q84";
+  }
+  summaryFile << endl;
+
 
 
 
@@ -140,50 +305,23 @@ int main( int argc, char* argv[] ){
 
 
 
-        //cout<<"Opened file"<<endl;
-        for( int i = 0; i < kNumBins_Bootstrap; i++ ){
-            cout<<"Results from bootstrap "<<i<<endl;
-            
-            ostringstream resultsFile;
-	    resultsFile.str("");
-            //cout<<"Created resultsFile"<<endl;
-	    resultsFile << "bin_bs_" << i << ".fit";
-            //cout<<"Naming results file"<<endl;
-	                                                                                                                                                                                                  
-	    FitResults results( resultsFile.str().c_str() );
-            //cout<<"Named results file"<<endl;
-
-	    // print out the bin center                                                                                                                                                                                       
-	    outfile[j][k] << lowMass + step * j + step / 2. << "\t";
-	    outfile[j][k] << lowt + stept * k + stept / 2. << "\t";
+        double mass = lowMass + step * j + step / 2.;
+        double t = lowt + stept * k + stept / 2.;
 
-	    if( !results.valid() ){
+        vector< BootstrapQuantity > summary;
+        for (size_t q = 0; q < names.size(); q++) summary.push_back( BootstrapQuantity( names[q].compare(0, 4, "phi_") == 0 ) );
+        int numFailed = 0;
 
-	      for (int L = 0; L<= pow(LMAX,1); L++) {// calculating moments and writing to a file
-		for (int M = 0; M<= L; M++) {
-     
-		  outfile[j][k] << 0<< "\t"<< 0 <<"\t";
-		  outfile[j][k] << 0<< "\t"<< 0 <<"\t";
-		}}
-	      outfile[j][k] << endl;
-     
-	      continue;
-	    }
-
-
-
- for (int L = 0; L<= pow(LMAX,1); L++) {// calculating moments and writing to a file
-    for (int M = 0; M<= L; M++) {
-     
-      outfile[j][k] << real(decomposeMoment(0, L, M, ws, results.parValueList()))<< "\t"<< 0 <<"\t";
-      outfile[j][k] << real(decomposeMoment(1, L, M, ws, results.parValueList()))<< "\t"<< 0 <<"\t";
-      // if(L==0 && M==0 && i==44 && j==3)cout <<" H0_00=  "<< real(decomposeMoment(0, L, M, ws, results.parValueList()))<<" H1_00=  "<< real(decomposeMoment(1, L, M, ws, results.parValueList()))<<" H2_00=  "<< decomposeMoment(2, L, M, ws, results.parValueList())<<endl;
-
-        }}
-
-	outfile[j][k]<<endl;
-	}
+        readBin( numBootstrap, numThreads, ws, coeffs, LMAX, mass, t, outfile[j][k], summary, withQuantiles, numFailed );
 
+        summaryFile << mass << "\t" << t << "\t" << numBootstrap - numFailed << "\t" << numFailed;
+        for (size_t q = 0; q < summary.size(); q++){
+          summaryFile << "\t" << summary[q].stats().mean() << "\t" << summary[q].stats().stddev();
+          if (withQuantiles)
+            summaryFile << "\t" << summary[q].sketch().quantile(0.16) << "\t" << summary[q].sketch().quantile(0.5)
+                        << "\t" << summary[q].sketch().quantile(0.84);
+        }
+        summaryFile << endl;
 
 	outfile[j][k].close();
         //cout<<"end fit bin "<<j<<endl;
@@ -20,6 +20,7 @@
 #include "IUAmpTools/FitResults.h"
 #include "TFile.h"
 #include "Math/SpecFunc.h"
+#include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "wave.h"
 #include "moment.h"
 
@@ -53,63 +54,31 @@ int isfrac(double x){
 }
 
 
-long int factorial(int n)
-{
-  if(n > 1)
-    return n * factorial(n - 1);
-  else
-    return 1;
-}
+// Clebsch-Gordan coefficient <j1 m1; j2 m2 | j3 m3>.  Integer spins come
+// from the table of AMPTOOLS_AMPS, which is filled once, so the moments of
+// all bins and bootstrap samples share the same coefficients.
+double clebsch(double j1, double j2, double j3, double m1, double m2, double m3){
 
+  if((m1+m2)!=m3) {return 0.;}
+
+  if (isfrac(j1) || isfrac(j2) || isfrac(j3) || isfrac(m1) || isfrac(m2)) {
+    // half-integer spins
+    if (isfrac(j1+j2+j3) || isfrac(j1+m1) || isfrac(j2+m2) || isfrac(j3+m3)) return 0.0;
+    double sign = (int(round(j1-j2+m3)) % 2 == 0) ? 1. : -1.;
+    return sign*sqrt(2*j3+1)*s3j(j1,j2,j3,m1,m2,-m3);
+  }
+
+  if (fabs(m1) > j1 || fabs(m2) > j2 || fabs(m3) > j3) return 0.0;
+
+  return clebschGordan(int(round(j1)), int(round(j2)), int(round(m1)), int(round(m2)),
+		       int(round(j3)), int(round(m3)));
+}
 
 
 
 
-double clebsch(double j1, double j2, double j3, double m1, double m2, double m3){
-  double cg = 0.0;
-  // double m3 = m1+m2;
-  
 
-  if((m1+m2)!=m3) {return 0.;}
 
-  // check input
-  if (isfrac(j1+j2+j3) || isfrac(j1+m1) || isfrac(j2+m2) || isfrac(j3+m3) ||
-      isfrac(j3-j1-m2) || isfrac(j3-j2+m1)) {
-    return 0.0;
-  }
-  
-  
-  // Check for conditions that give CG = 0.
-  if ( j3 < fabs(j1-j2) || j3 < fabs(j1-j2)||
-      fabs(m1) > j1 || fabs(m2) > j2 || fabs(m3) > j3 ) {
-    return 0.0;
-  }
-  
-  // Compute the Clebsch-Gordan coefficient
-  cg = sqrt( (2*j3+1)/ factorial( round(j1+j2+j3+1) ) );
-  cg = cg * sqrt( factorial(round(j1+j2-j3))*factorial(round(j2+j3-j1))*factorial(round(j3+j1-j2))   );
-  cg = cg * sqrt( factorial(round(j1+m1))*factorial(round(j1-m1)) );
-  cg = cg * sqrt( factorial(round(j2+m2))*factorial(round(j2-m2)) );
-  cg = cg * sqrt( factorial(round(j3+m3))*factorial(round(j3-m3)) );
-  
-  double sum = 0.0, term;
-  for (int k = 0; k < 99; k++) {
-    if (j1+j2-j3-k < 0) continue;
-    if (j3-j1-m2+k < 0) continue;
-    if (j3-j2+m1+k < 0) continue;
-    if (j1-m1-k    < 0) continue;
-    if (j2+m2-k    < 0) continue;
-    term = factorial(round(j1+j2-j3-k)) * factorial(round(j3-j1-m2+k)) ;
-    term = term * factorial(round(j3-j2+m1+k)) * factorial(round(j1-m1-k));
-    term = term * factorial(round(j2+m2-k)) * factorial(k);
-    term = term * pow(-1, k);
-    sum = sum + 1./term;
-  }
-  
-  cg = cg * sum;
-  
-  return cg;
-}
 
 
 
@@ -121,8 +90,19 @@ double clebsch(double j1, double j2, double j3, double m1, double m2, double m3)
 
 
 
+std::vector<MomentCoefficients::Wave> momentWaves(const waveset& ws)
+{
+  std::vector<MomentCoefficients::Wave> waves;
 
+  for (size_t iWs = 0; iWs < ws.size(); iWs++)
+    {
+      const vector<wave>& w = ws[iWs].waves;
+      for (size_t iW = 0; iW < w.size(); iW++)
+	waves.push_back(MomentCoefficients::Wave(iWs, ws[iWs].reflectivity, int(w[iW].l), int(w[iW].m), w[iW].getIndex()));
+    }
 
+  return waves;
+}
 
 
 
@@ -18,6 +18,8 @@
 #include <map>
 #include <complex>
 
+#include "AMPTOOLS_MOMENTS/MomentCoefficients.h"
+
 #include "wave.h"
 
 
@@ -28,6 +30,9 @@ double clebsch(double j1, double j2, double j3, double m1, double m2, double m3)
 std::complex<double> decomposeMoment(int alpha,double L, double M, const waveset& ws, const double* x);
 std::complex<double> decomposeMoment(int alpha ,double L, double M, const waveset& ws, const vector<double>& x);
 
+// the waves of ws for a MomentCoefficients, with the sums in the order of ws
+std::vector<MomentCoefficients::Wave> momentWaves(const waveset& ws);
+
 
 #endif /* MOMENT_H */
 
@@ -0,0 +1,140 @@
+#!/usr/bin/perl
+
+use Getopt::Long;
+use Time::HiRes qw( time );
+
+# Generates fixed-seed samples for the reference fits and times fit and
+# fitMPI on them.  Every fit stops after the same number of iterations
+# (-m), so the same work is timed every run.  The timings come from the
+# --telemetry summary of each fit (see FitTelemetry) and are appended to
+# the results file, one line per run.
+
+# number of data events per reaction; the generated MC has genFactor times more
+$nData = 50000;
+$genFactor = 5;
+
+# maximum number of fit iterations
+$maxIter = 200;
+
+# the thread counts of fit, the rank counts of fitMPI and the GPU counts
+# (one rank per GPU on one node); an empty list skips the runs
+$threads = "1 2 4 8";
+$ranks = "";
+$gpus = "";
+
+$mpirun = "mpirun";
+$resultFile = "benchmark_results.txt";
+
+GetOptions( "n=i" => \$nData, "m=i" => \$maxIter, "threads=s" => \$threads,
+            "ranks=s" => \$ranks, "gpus=s" => \$gpus, "mpirun=s" => \$mpirun,
+            "o=s" => \$resultFile, "regenerate" => \$regenerate )
+  or die "usage: runBenchmark.pl [-n events] [-m iterations] [--threads \"1 2 4\"]\n" .
+         "                       [--ranks \"2 4\"] [--gpus \"1 2\"] [--mpirun cmd]\n" .
+         "                       [-o results] [--regenerate] [reaction ...]\n";
+
+# reaction => [ config file, topology of amp_benchmark -g, sample prefix ]
+%reactions = ( "zlm"     => [ "bench_zlm.cfg",     "etapi",   "bench_etapi" ],
+               "omegapi" => [ "bench_omegapi.cfg", "omegapi", "bench_omegapi" ],
+               "threepi" => [ "bench_3pi.cfg",     "omega",   "bench_omega" ] );
+
+@names = @ARGV ? @ARGV : sort keys %reactions;
+
+### things below here probably don't need to be modified
+
+sub run {
+
+  my ( $command ) = @_;
+  print "$command\n";
+  system( $command ) == 0 or die "FAILED:  $command\n";
+}
+
+# the data, generated and accepted samples of a reaction with fixed seeds
+sub generate {
+
+  my ( $topology, $prefix ) = @_;
+  my $nGen = $nData * $genFactor;
+
+  return if( !$regenerate && -e "${prefix}_data.root" && -e "${prefix}_acc.root" );
+
+  run( "amp_benchmark -s 1 -g $topology ${prefix}_data.root $nData" );
+  run( "amp_benchmark -s 2 -g $topology ${prefix}_gen.root $nGen" );
+  run( "toy_detector ${prefix}_gen.root ${prefix}_acc.root -s 3" );
+}
+
+# the fields of the summary record of a telemetry file
+sub summary {
+
+  my ( $file ) = @_;
+  my %fields;
+
+  open( TELEMETRY, $file ) or return %fields;
+  while( <TELEMETRY> ){
+
+    next unless /"type": "summary"/;
+    while( /"(\w+)": ([-+.\deE]+)/g ){ $fields{$1} = $2; }
+  }
+  close( TELEMETRY );
+
+  return %fields;
+}
+
+# runs a fit and appends a line to the results
+sub timeFit {
+
+  my ( $name, $program, $threadCount, $rankCount, $gpuCount, $command ) = @_;
+
+  my $telemetry = "telemetry_${name}_${program}_j${threadCount}_r${rankCount}_g${gpuCount}.json";
+  unlink( $telemetry );
+
+  my $start = time();
+  run( "$command --telemetry $telemetry > $telemetry.log 2>&1" );
+  my $wall = time() - $start;
+
+  my %s = summary( $telemetry );
+  if( !%s ){
+
+    print "WARNING:  no telemetry summary in $telemetry\n";
+    return;
+  }
+
+  my $line = sprintf( "%-10s %-7s %7d %5d %4d %6d %10.3f %10.3f %12.6f %10.1f %10.3f\n",
+                      $name, $program, $threadCount, $rankCount, $gpuCount, $s{calls},
+                      $s{setupSeconds}, $s{firstCallSeconds}, $s{secondsPerCall},
+                      $s{maxRSSMB}, $wall );
+
+  open( RESULTS, ">>$resultFile" ) or die "cannot write $resultFile\n";
+  print RESULTS $line;
+  close( RESULTS );
+  print $line;
+}
+
+if( ! -e $resultFile ){
+
+  open( RESULTS, ">$resultFile" ) or die "cannot write $resultFile\n";
+  print RESULTS "# reaction program threads ranks gpus calls setup[s] firstCall[s] perCall[s] maxRSS[MB] wall[s]\n";
+  print RESULTS "# (memory of rank 0 for fitMPI)\n";
+  close( RESULTS );
+}
+
+foreach $name ( @names ){
+
+  die "unknown reaction $name\n" unless exists $reactions{$name};
+  my ( $config, $topology, $prefix ) = @{ $reactions{$name} };
+
+  generate( $topology, $prefix );
+
+  foreach $j ( split( ' ', $threads ) ){
+
+    timeFit( $name, "fit", $j, 1, 0, "fit -c $config -m $maxIter -j $j" );
+  }
+
+  foreach $r ( split( ' ', $ranks ) ){
+
+    timeFit( $name, "fitMPI", 1, $r, 0, "$mpirun -np $r fitMPI -c $config -m $maxIter" );
+  }
+
+  foreach $g ( split( ' ', $gpus ) ){
+
+    timeFit( $name, "fitMPI", 1, $g, $g, "$mpirun -np $g fitMPI -c $config -m $maxIter -g $g" );
+  }
+}
@@ -17,15 +17,13 @@
 
 #include "AMPTOOLS_DATAIO/ThreePiPlotGenerator.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
-#include "AMPTOOLS_AMPS/ThreePiAngles.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
 
 typedef ThreePiPlotGenerator PlotGen;
 
-void atiSetup(){
+void atiSetup( const ConfigurationInfo* cfgInfo ){
   
-  AmpToolsInterface::registerAmplitude( BreitWigner() );
-  AmpToolsInterface::registerAmplitude( ThreePiAngles() );
+  AmplitudeRegistry::registerUsed( cfgInfo );
   AmpToolsInterface::registerDataReader( ROOTDataReader() );
 }
 
@@ -67,7 +65,7 @@ int main( int argc, char* argv[] ){
     // set up the plot generator
     // ************************
 
-  atiSetup();
+  atiSetup( results.configInfo() );
   PlotGen plotGen( results );
 
     // ************************
@@ -29,6 +29,12 @@ $genMCFile = "$workingDir/threepi_gen.root";
 # this file should be used when there is 100% beam polarization
 $cfgTempl = "$workingDir/threepi_pol_TEMPLATE.cfg";
 
+# set to 1 to have each fit read its bin directly from the files above
+# with ROOTDataReaderBinned instead of writing a copy of the files per
+# bin with split_mass; the entries of the bins are indexed on the first
+# fit and kept in the fit directory as *_bins_<i>.idx
+$virtualBins = 0;
+
 
 ### things below here probably don't need to be modified
 
@@ -44,24 +50,24 @@ chdir $fitDir;
 @dataParts = split /\//, $dataFile;
 $dataTag = pop @dataParts;
 $dataTag =~ s/\.root//;
-system( "split_mass $dataFile $dataTag $lowMass $highMass $nBins $maxEvts" );
+system( "split_mass $dataFile $dataTag $lowMass $highMass $nBins $maxEvts" ) unless $virtualBins;
 
 @accMCParts = split /\//, $accMCFile;
 $accMCTag = pop @accMCParts;
 $accMCTag =~ s/\.root//;
-system( "split_mass $accMCFile $accMCTag $lowMass $highMass $nBins" );
+system( "split_mass $accMCFile $accMCTag $lowMass $highMass $nBins" ) unless $virtualBins;
 
 @genMCParts = split /\//, $genMCFile;
 $genMCTag = pop @genMCParts;
 $genMCTag =~ s/\.root//;
-system( "split_mass $genMCFile $genMCTag $lowMass $highMass $nBins" );
+system( "split_mass $genMCFile $genMCTag $lowMass $highMass $nBins" ) unless $virtualBins;
 
 # make directories to perform the fits in
 for( $i = 0; $i < $nBins; ++$i ){
 
   mkdir "bin_$i" unless -d "bin_$i";
 
-  system( "mv *\_$i.root bin_$i" );
+  system( "mv *\_$i.root bin_$i" ) unless $virtualBins;
 
   chdir "bin_$i";
 
@@ -70,6 +76,14 @@ for( $i = 0; $i < $nBins; ++$i ){
 
   while( <CFGIN> ){
 
+    if( $virtualBins ){
+
+      $binArgs = "$lowMass $highMass $nBins $i";
+      s/ROOTDataReader DATAFILE/ROOTDataReaderBinned $dataFile $binArgs index=$fitDir$dataTag\_bins maxevents=$maxEvts/;
+      s/ROOTDataReader ACCMCFILE/ROOTDataReaderBinned $accMCFile $binArgs index=$fitDir$accMCTag\_bins/;
+      s/ROOTDataReader GENMCFILE/ROOTDataReaderBinned $genMCFile $binArgs index=$fitDir$genMCTag\_bins/;
+    }
+
     s/DATAFILE/$dataTag\_$i.root/;
     s/ACCMCFILE/$accMCTag\_$i.root/;
     s/GENMCFILE/$genMCTag\_$i.root/;
@@ -14,22 +14,20 @@ $workingDir = getcwd();
 # to see the parameters inthe fit
 $seedFile = "param_init.cfg";
 
+# the seeds are chained outward from this bin, which should be the one
+# used to make the seed file in the fit directory
+$startBin = 10;
+
+# number of bins that are fit at the same time, 0 uses all cores
+$nJobs = 0;
+
 ### things below here probably don't need to be modified
 
 $fitDir = "$workingDir/$fitName";
-$lastParams = "$fitDir/$seedFile";
-
-for( $i = 0; $i < $nBins; ++$i ){
-  
-  chdir $fitDir;
-  chdir "bin_$i";
-  
-  print "Fitting in bin $i...\n";
-  
-  system( "fit -c bin_$i.cfg -s $seedFile > bin_$i.log" );
-  
-  if( -e "$seedFile" ){ system( "cp -f $seedFile .." ); }
-  
-  chdir $fitDir;
-}
 
+$jobs = $nJobs > 0 ? "-j $nJobs" : "";
+
+# fit_bins runs the bins in parallel; the fit of each bin starts from the
+# result of its converged neighbor toward the start bin and the output
+# is logged to bin_$i/bin_$i.log.  Add -R to resume an interrupted run.
+system( "fit_bins $fitDir $nBins -S $startBin -s $seedFile $jobs" );
@@ -12,8 +12,12 @@
 #include <time.h>
 
 #include "IUAmpTools/FitResults.h"
+#include "AMPTOOLS_DATAIO/CompactFitResults.h"
 #include "TFile.h"
 
+#include "AMPTOOLS_AMPS/clebschGordan.h"
+#include "AMPTOOLS_MOMENTS/MomentCoefficients.h"
+
 //#include "wave.h"
 //#include "3j.h"
 
@@ -38,9 +42,37 @@ using namespace std;
 
 
 
-std::complex<double> pw_refl(string fitresFile, int L, int hel[3]);
-std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string fitFile);
-std::complex<double> Moments_refl(int alp, int L, int M, string file_fit);
+// the partial waves of the fit; only positive reflectivity, nucleon
+// non-flip and m >= 0 are fit
+struct FitWave {
+  int L, m;
+  const char* name;
+  bool scaled;   // read with scaledProductionParameter
+};
+
+const int kNumWaves = 6;
+const FitWave kWaves[kNumWaves] = {
+  { 0, 0, "EtaPrimePi0::PositiveRe::S0+", true },    // a0(980)
+  { 1, 0, "EtaPrimePi0::PositiveRe::P0+", false },   // pi1(1600)
+  { 1, 1, "EtaPrimePi0::PositiveRe::P1+", false },
+  { 2, 0, "EtaPrimePi0::PositiveRe::D0+", false },   // a2(1320) + a2(1700)
+  { 2, 1, "EtaPrimePi0::PositiveRe::D1+", false },
+  { 2, 2, "EtaPrimePi0::PositiveRe::D2+", false }
+};
+
+// the partial waves of the fit of one bin, read once from its results file
+struct BinWaves {
+  bool valid;
+  std::complex<double> pw[LMAX+1][LMAX+1];   // [L][m]
+  // Re and Im of the waves of kWaves and their covariance from the fit
+  std::vector<double> x;
+  std::vector< std::vector<double> > cov;
+};
+
+BinWaves readWaves(string fitresFile);
+std::complex<double> pw_refl(const BinWaves& waves, int L, int hel[3]);
+std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, const BinWaves& waves);
+std::complex<double> Moments_refl(int alp, int L, int M, const BinWaves& waves);
 double clebsch(double j1, double j2, double j3, double m1, double m2);
 
 
@@ -106,6 +138,14 @@ int main( int argc, char* argv[] ){
       }}
     outfile<<endl;
 
+    // the same moments as linear combinations of the bilinears of kWaves,
+    // for the uncertainties J C J^T from the covariance C of the waves
+    vector<MomentCoefficients::Wave> momentWaves;
+    for (int iW = 0; iW < kNumWaves; iW++)
+      momentWaves.push_back(MomentCoefficients::Wave(0, +1, kWaves[iW].L, kWaves[iW].m, 2*iW));
+    MomentCoefficients coeffs(momentWaves, pow(LMAX,2));
+    vector<double> Herr(coeffs.numMoments());
+
 
 
     // descend into the directory that contains the bins
@@ -126,6 +166,10 @@ int main( int argc, char* argv[] ){
         resultsFile ="bin_" + std::to_string(i)+"_"+ std::to_string(j)+".fit";
 
         
+        BinWaves waves = readWaves(resultsFile);
+        if (waves.valid) coeffs.realErrors(&waves.x[0], waves.cov, &Herr[0]);
+        else Herr.assign(Herr.size(), 0.);
+
         // print out the bin center
         outfile << lowMass + step * i + step / 2. << "\t";
 	outfile << lowt + stept * j + stept / 2. << "\t";
@@ -134,8 +178,8 @@ int main( int argc, char* argv[] ){
     for (int L = 0; L<= pow(LMAX,2); L++) {// calculating moments and writing to a file
     for (int M = 0; M<= L; M++) {
      
-      outfile << real(Moments_refl(0, L, M, resultsFile))<< "\t"<< 0 <<"\t";
-      outfile << real(Moments_refl(1, L, M, resultsFile))<< "\t"<< 0 <<"\t";
+      outfile << real(Moments_refl(0, L, M, waves))<< "\t"<< Herr[coeffs.index(0, L, M)] <<"\t";
+      outfile << real(Moments_refl(1, L, M, waves))<< "\t"<< Herr[coeffs.index(1, L, M)] <<"\t";
       // if(L==0 && M==0 && i==44 && j==3)cout <<" H0_00=  "<< real(Moments_refl(0, L, M, resultsFile))<<" H1_00=  "<< real(Moments_refl(1, L, M, resultsFile))<<endl;
         }}
         outfile << endl;
@@ -160,24 +204,93 @@ int main( int argc, char* argv[] ){
 
 
 
-std::complex<double> pw_refl(string fitresFile, int L, int hel[3]){
+template< class Results >
+BinWaves readWaves(const Results& fitres){
+  /* reads the partial waves for g p --> (eta pi)_L p from the fit results
+  * for given m_eta_pi and t bin, in the reflectivity basis; Results is
+  * FitResults or CompactFitResults
+  */
+
+  BinWaves waves;
+  for (int L = 0; L <= LMAX; L++)
+    for (int m = 0; m <= LMAX; m++) waves.pw[L][m] = 0.0;
+
+  waves.valid = fitres.valid();
+  if (!waves.valid) return waves;
+
+  // the rows of the error matrix for the Re and Im of each wave
+  vector<string> parNames = fitres.parNameList();
+  vector< vector<double> > errorMatrix = fitres.errorMatrix();
+  vector<int> row(2*kNumWaves, -1);
+  vector<double> scale(2*kNumWaves, 1.);
+
+  for (int iW = 0; iW < kNumWaves; iW++){
+    const FitWave& w = kWaves[iW];
+
+    std::complex<double> value = fitres.productionParameter(w.name);
+    if (w.scaled){
+      std::complex<double> scaled = fitres.scaledProductionParameter(w.name);
+      // the scale is a constant for the error propagation
+      if (abs(value) > 0) scale[2*iW] = scale[2*iW+1] = abs(scaled) / abs(value);
+      value = scaled;
+    }
+    waves.pw[w.L][w.m] = value;
+    waves.x.push_back(real(value));
+    waves.x.push_back(imag(value));
+
+    // waves fixed in the fit, e.g. the imaginary part of a real one,
+    // have no parameter and no error
+    for (size_t iPar = 0; iPar < parNames.size(); iPar++){
+      if (parNames[iPar] == string(w.name) + "_re") row[2*iW] = iPar;
+      if (parNames[iPar] == string(w.name) + "_im") row[2*iW+1] = iPar;
+    }
+  }
+
+  waves.cov.assign(2*kNumWaves, vector<double>(2*kNumWaves, 0.));
+  for (int a = 0; a < 2*kNumWaves; a++)
+    for (int b = 0; b < 2*kNumWaves; b++)
+      if (row[a] >= 0 && row[b] >= 0)
+        waves.cov[a][b] = scale[a] * scale[b] * errorMatrix[row[a]][row[b]];
+
+  return waves;
+}
+
+
+BinWaves readWaves(string fitresFile){
+  /* reads the fit output file, or its binary companion if fit wrote one
+  * with --binary-results
+  */
+
+  if (CompactFitResults::exists(fitresFile)){
+    CompactFitResults fitres(fitresFile);
+    if (fitres.ok()) return readWaves(fitres);
+  }
+
+  FitResults fitres(fitresFile);
+  return readWaves(fitres);
+}
+
+
+
+
+
+
+std::complex<double> pw_refl(const BinWaves& waves, int L, int hel[3]){
   /* returns partial waves for g p --> (eta pi)_L p
   * partial waves are in the reflectivity basis
-  * fitresFile is the name of the fit output file for given m_eta_pi and t bin
+  * waves are the fit results for given m_eta_pi and t bin
   * hel = {epsilon, m, k}
   * epsilon is the relfectivity
   * k = 0,1 is the nucleon non-flip (0) or flip (1)
   */
 
 
- std::complex<double> pw (0.0,0.0), ui (0.,1.), zero(0.0, 0.0);
+ std::complex<double> zero(0.0, 0.0);
   
   int eps = hel[0], m = hel[1], k = hel[2];
 
 
-FitResults fitres(fitresFile);
-
- if( !fitres.valid() )return zero;
+ if( !waves.valid )return zero;
  // eps = +/- 1 ; k = 0,1 ; |m|<= L
   if( abs(eps)!=1 || abs(2*k-1)!=1 || abs(m)>L) {
     return zero;
@@ -196,33 +309,11 @@ FitResults fitres(fitresFile);
   if (m < 0){
     return zero;
   }
- 
-  if (eps == 1){
-    switch (L) {
-      case 0:
-        // a0(980)
-	pw=fitres.scaledProductionParameter("EtaPrimePi0::PositiveRe::S0+");
-        break;
-      case 1:
-        // pi1(1600)
-	if(m==0)pw=fitres.productionParameter("EtaPrimePi0::PositiveRe::P0+");
-	else pw=fitres.productionParameter("EtaPrimePi0::PositiveRe::P1+");
-	break;
-      case 2:
-        // a2(1320) + a2(1700)
-        if(m==0)pw=fitres.productionParameter("EtaPrimePi0::PositiveRe::D0+");
-	else if(m==1)pw=fitres.productionParameter("EtaPrimePi0::PositiveRe::D1+");
-	else pw=fitres.productionParameter("EtaPrimePi0::PositiveRe::D2+");
-	break;
-        
-      default:
-        pw = zero;
-        break;
-    }
-  
-  
+  if (L > LMAX){
+    return zero;
   }
-  return pw;
+
+  return waves.pw[L][m];
 }
 
 
@@ -230,8 +321,8 @@ FitResults fitres(fitresFile);
 
 
 
-std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string fitFile){ // code formula (D8) from 10.1103/PhysRevD.100.054017 //alp corresponds to H0 or H1
-  // fitresFile contains fit results in given {t,m_etapi} bin
+std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, const BinWaves& waves){ // code formula (D8) from 10.1103/PhysRevD.100.054017 //alp corresponds to H0 or H1
+  // waves contains fit results in given {t,m_etapi} bin
   std::complex<double> rho (0.0,0.0), ui (0.0, 1.0);
   std::complex<double> pw1 (0.0,0.0), pw2 (0.0,0.0);
   int hel1[3], hel2[3]; // hel = [eps, m , k]
@@ -247,14 +338,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
       case 0:
         fac = 1.0;
         hel1[1] = M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1); //  fitresFile contains fitresults for given bin in { t_{pp}, m_{eta pi}}, L , hel = {epsilon, m proj. of L, k}
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1); //  waves contains fitresults for given bin in { t_{pp}, m_{eta pi}}, L , hel = {epsilon, m proj. of L, k}
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = pow(-1.,M1-M2);
         hel1[1] = -M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
        
         break;
@@ -263,14 +354,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
         fac = -(double)e*pow(-1.,M1);
         
         hel1[1] = -M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = -(double)e*pow(-1.,M2);
         hel1[1] = M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         break;
         
@@ -278,14 +369,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
         fac = -ui*(double)e*pow(-1.,M1);
         
         hel1[1] = -M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = +ui*(double)e*pow(-1.,M2);
         hel1[1] = M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         break;
         
@@ -293,14 +384,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
         fac = 1.0;
         
         hel1[1] = M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = -pow(-1.,M1-M2);
         hel1[1] = -M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = pw_refl(waves, L1, hel1);
+        pw2 = pw_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         break;
         
@@ -316,7 +407,7 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
 
 
 
-std::complex<double> Moments_refl(int alp, int L, int M, string file_fit){ //H0 or H1 , L, M, fitresults file for given t and  invariant mass bin 
+std::complex<double> Moments_refl(int alp, int L, int M, const BinWaves& waves){ //H0 or H1 , L, M, fitresults for given t and  invariant mass bin 
   // WARNING: the sum extends to max(l1,l2) = LMAX 
   std::complex<double> mom = 0.0;
   std::complex<double> rho = 0.0;
@@ -330,7 +421,7 @@ std::complex<double> Moments_refl(int alp, int L, int M, string file_fit){ //H0
       for (int m2 = -l2; m2 <= l2; m2 +=1 ) {
         cg1 = clebsch(l2,L,l1,0,0);   // m1,m2 and M are =0
         cg2 = clebsch(l2,L,l1,m2,M);  // 6th argument m1=M+m2
-        rho = sdme_refl(alp, l1, l2, m2+M,m2, file_fit);
+        rho = sdme_refl(alp, l1, l2, m2+M,m2, waves);
         mom += fac*sqrt( (2.0*l2+1)/(2.0*l1+1) )*cg1*cg2*rho;
 	
       }}}
@@ -351,58 +442,20 @@ int isfrac(double x){
 }
 
 
-long int factorial(int n)
-{
-  if(n > 1)
-    return n * factorial(n - 1);
-  else
-    return 1;
-}
-
-
-
-
+// Clebsch-Gordan coefficient <j1 m1; j2 m2 | j3 m1+m2> from the table of
+// AMPTOOLS_AMPS; the spins of the waves are integers
 double clebsch(double j1, double j2, double j3, double m1, double m2){
-  double cg = 0.0;
   double m3 = m1+m2;
-  
-  // check input
-  if (isfrac(j1+j2+j3) || isfrac(j1+m1) || isfrac(j2+m2) || isfrac(j3+m3) ||
-      isfrac(j3-j1-m2) || isfrac(j3-j2+m1)) {
+
+  if (isfrac(j1) || isfrac(j2) || isfrac(j3) || isfrac(m1) || isfrac(m2)) {
     return 0.0;
   }
-  
-  
-  // Check for conditions that give CG = 0.
-  if ( j3 < fabs(j1-j2) || j3 < fabs(j1-j2)||
-      fabs(m1) > j1 || fabs(m2) > j2 || fabs(m3) > j3 ) {
+  if (fabs(m1) > j1 || fabs(m2) > j2 || fabs(m3) > j3) {
     return 0.0;
   }
-  
-  // Compute the Clebsch-Gordan coefficient
-  cg = sqrt( (2*j3+1)/ factorial( round(j1+j2+j3+1) ) );
-  cg = cg * sqrt( factorial(round(j1+j2-j3))*factorial(round(j2+j3-j1))*factorial(round(j3+j1-j2))   );
-  cg = cg * sqrt( factorial(round(j1+m1))*factorial(round(j1-m1)) );
-  cg = cg * sqrt( factorial(round(j2+m2))*factorial(round(j2-m2)) );
-  cg = cg * sqrt( factorial(round(j3+m3))*factorial(round(j3-m3)) );
-  
-  double sum = 0.0, term;
-  for (int k = 0; k < 99; k++) {
-    if (j1+j2-j3-k < 0) continue;
-    if (j3-j1-m2+k < 0) continue;
-    if (j3-j2+m1+k < 0) continue;
-    if (j1-m1-k    < 0) continue;
-    if (j2+m2-k    < 0) continue;
-    term = factorial(round(j1+j2-j3-k)) * factorial(round(j3-j1-m2+k)) ;
-    term = term * factorial(round(j3-j2+m1+k)) * factorial(round(j1-m1-k));
-    term = term * factorial(round(j2+m2-k)) * factorial(k);
-    term = term * pow(-1, k);
-    sum = sum + 1./term;
-  }
-  
-  cg = cg * sum;
-  
-  return cg;
+
+  return clebschGordan(int(round(j1)), int(round(j2)), int(round(m1)), int(round(m2)),
+		       int(round(j3)), int(round(m3)));
 }
 
 
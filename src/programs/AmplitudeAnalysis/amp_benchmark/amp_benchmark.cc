@@ -0,0 +1,535 @@
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include "IUAmpTools/Amplitude.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+
+#include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_AMPS/Flatte.h"
+#include "AMPTOOLS_AMPS/Zlm.h"
+#include "AMPTOOLS_AMPS/Ylm.h"
+#include "AMPTOOLS_AMPS/TwoPSHelicity.h"
+#include "AMPTOOLS_AMPS/TwoPSAngles.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles.h"
+#include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.h"
+#include "AMPTOOLS_AMPS/Lambda1520Angles.h"
+#include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
+#include "AMPTOOLS_AMPS/Vec_ps_refl.h"
+#include "AMPTOOLS_AMPS/omegapi_amplitude.h"
+#include "AMPTOOLS_AMPS/Uniform.h"
+
+#include "TLorentzVector.h"
+#include "TRandom3.h"
+#include "TMath.h"
+
+using namespace std;
+
+// Times calcUserVarsAll and calcAmplitudeAll of the amplitudes on
+// synthetic events of the topologies below, the same entry points the
+// framework calls on the data in a fit.  The results are in events per
+// second; a baseline written with -o is compared with -b.  The kernels of
+// a GPU build are timed by fit --profile.  With -g the events of a
+// topology are written to a file in the format of ROOTDataReader, for the
+// fits of Examples/benchmark.
+
+namespace {
+
+  const double kProtonMass = 0.938272;
+  const double kPiPlusMass = 0.139570;
+  const double kPiZeroMass = 0.134977;
+  const double kEtaMass = 0.547862;
+  const double kOmegaMass = 0.78265;
+  const double kBeamEnergy = 8.5;
+
+  // the four-vectors of one event in the order of the topology, the beam
+  // first and the recoil proton second
+  typedef vector< TLorentzVector > Event;
+
+  // parent -> d1 d2, isotropic in the rest frame of the parent
+  void twoBodyDecay( const TLorentzVector& parent, double m1, double m2,
+                     TRandom3& random, TLorentzVector& d1, TLorentzVector& d2 ){
+
+    double m = parent.M();
+    double p = sqrt( ( m * m - ( m1 + m2 ) * ( m1 + m2 ) ) *
+                     ( m * m - ( m1 - m2 ) * ( m1 - m2 ) ) ) / ( 2 * m );
+
+    double cosTheta = random.Uniform( -1, 1 );
+    double sinTheta = sqrt( 1 - cosTheta * cosTheta );
+    double phi = random.Uniform( 0, TMath::TwoPi() );
+
+    TVector3 direction( sinTheta * cos( phi ), sinTheta * sin( phi ), cosTheta );
+
+    d1.SetVectM( p * direction, m1 );
+    d2.SetVectM( -p * direction, m2 );
+
+    d1.Boost( parent.BoostVector() );
+    d2.Boost( parent.BoostVector() );
+  }
+
+  // gamma p -> X p with the mass of X uniform in [mLow,mHigh]; fills the
+  // beam, the recoil and X
+  void production( double mLow, double mHigh, TRandom3& random, Event& event,
+                   TLorentzVector& X ){
+
+    TLorentzVector beam( 0, 0, kBeamEnergy, kBeamEnergy );
+    TLorentzVector target( 0, 0, 0, kProtonMass );
+    TLorentzVector cm = beam + target;
+
+    TLorentzVector recoil;
+    double mX = random.Uniform( mLow, mHigh );
+    twoBodyDecay( cm, mX, kProtonMass, random, X, recoil );
+
+    event.push_back( beam );
+    event.push_back( recoil );
+  }
+
+  // beam, p, pi+, pi-
+  Event twoPi( TRandom3& random ){
+
+    Event event;
+    TLorentzVector X, pip, pim;
+    production( 0.4, 1.2, random, event, X );
+    twoBodyDecay( X, kPiPlusMass, kPiPlusMass, random, pip, pim );
+    event.push_back( pip );
+    event.push_back( pim );
+    return event;
+  }
+
+  // beam, p, eta, pi0
+  Event etaPi( TRandom3& random ){
+
+    Event event;
+    TLorentzVector X, eta, pi0;
+    production( 0.8, 1.8, random, event, X );
+    twoBodyDecay( X, kEtaMass, kPiZeroMass, random, eta, pi0 );
+    event.push_back( eta );
+    event.push_back( pi0 );
+    return event;
+  }
+
+  // omega -> pi+ pi- pi0 as two two-body decays with the mass of the pi+
+  // pi- pair uniform in the allowed range (not flat in the Dalitz plot,
+  // which does not matter for the timing)
+  void omegaDecay( const TLorentzVector& omega, TRandom3& random,
+                   TLorentzVector& pip, TLorentzVector& pim, TLorentzVector& pi0 ){
+
+    TLorentzVector pipi;
+    double mPiPi = random.Uniform( 2 * kPiPlusMass, omega.M() - kPiZeroMass );
+    twoBodyDecay( omega, mPiPi, kPiZeroMass, random, pipi, pi0 );
+    twoBodyDecay( pipi, kPiPlusMass, kPiPlusMass, random, pip, pim );
+  }
+
+  // beam, p, pi+, pi-, pi0
+  Event omega3Pi( TRandom3& random ){
+
+    Event event;
+    TLorentzVector omega, pip, pim, pi0;
+    production( kOmegaMass, kOmegaMass, random, event, omega );
+    omegaDecay( omega, random, pip, pim, pi0 );
+    event.push_back( pip );
+    event.push_back( pim );
+    event.push_back( pi0 );
+    return event;
+  }
+
+  // beam, p, bachelor pi0, pi0, pi+, pi- with omega -> pi0 pi+ pi-
+  Event omegaPi( TRandom3& random ){
+
+    Event event;
+    TLorentzVector X, omega, bachelor, pip, pim, pi0;
+    production( 1.0, 1.8, random, event, X );
+    twoBodyDecay( X, kOmegaMass, kPiZeroMass, random, omega, bachelor );
+    omegaDecay( omega, random, pip, pim, pi0 );
+    event.push_back( bachelor );
+    event.push_back( pi0 );
+    event.push_back( pip );
+    event.push_back( pim );
+    return event;
+  }
+
+  typedef Event (*Generator)( TRandom3& );
+
+  struct Topology {
+
+    string name;
+    Generator generate;
+    int nParticles;
+  };
+
+  const Topology kTopologies[] = {
+
+    { "2pi",    twoPi,    4 },
+    { "etapi",  etaPi,    4 },
+    { "omega",  omega3Pi, 5 },
+    { "omegapi", omegaPi, 6 }
+  };
+
+  template< class A >
+  Amplitude* makeAmplitude( const vector< string >& args ){ return new A( args ); }
+
+  // one amplitude with the arguments of an amplitude line of a
+  // configuration file on the events of a topology
+  struct Benchmark {
+
+    string topology;
+    string amplitude;
+    Amplitude* (*make)( const vector< string >& );
+    string args;
+  };
+
+  // the rho of the Schilling amplitudes, the polarization angle and fraction
+  #define SCHILLING_ARGS "0.5 0.05 0.02 0.1 -0.05 0.01 0.02 0.03 -0.01 0 0.4"
+
+  const Benchmark kBenchmarks[] = {
+
+    { "2pi", "BreitWigner",            makeAmplitude< BreitWigner >,            "0.775 0.149 1 2 3" },
+    { "2pi", "Flatte",                 makeAmplitude< Flatte >,
+      "0.98 0.2 0.8 2 3 0.13957 0.13957 0.493677 0.493677 1" },
+    { "2pi", "Ylm",                    makeAmplitude< Ylm >,                    "1 1 1" },
+    { "2pi", "TwoPSHelicity",          makeAmplitude< TwoPSHelicity >,          "1 1 1" },
+    { "2pi", "TwoPSAngles",            makeAmplitude< TwoPSAngles >,            "1 1 1" },
+    { "2pi", "TwoPiAngles",            makeAmplitude< TwoPiAngles >,            SCHILLING_ARGS },
+    { "2pi", "TwoPiAnglesRadiative",   makeAmplitude< TwoPiAnglesRadiative >,   SCHILLING_ARGS },
+    { "2pi", "Lambda1520Angles",       makeAmplitude< Lambda1520Angles >,       SCHILLING_ARGS },
+    { "2pi", "Uniform",                makeAmplitude< Uniform >,                "" },
+    { "etapi", "Zlm",                  makeAmplitude< Zlm >,                    "2 1 1 1 0 0.4" },
+    { "etapi", "BreitWigner",          makeAmplitude< BreitWigner >,            "1.318 0.105 2 2 3" },
+    { "omega", "ThreePiAnglesSchilling", makeAmplitude< ThreePiAnglesSchilling >, SCHILLING_ARGS },
+    { "omegapi", "Vec_ps_refl",        makeAmplitude< Vec_ps_refl >,
+      "1 1 0 1 1 0 0.4 0.1212 0.0257 0 0" },
+    { "omegapi", "omegapi_amplitude",  makeAmplitude< omegapi_amplitude >,
+      "1 1 1 1 1 0 1 0.1212 0.0257 0 0 0 0.4" },
+    { "omegapi", "BreitWigner",        makeAmplitude< BreitWigner >,            "1.235 0.142 1 2 345" }
+  };
+
+  vector< string > splitArgs( const string& args ){
+
+    vector< string > result;
+    istringstream in( args );
+    string arg;
+    while( in >> arg ) result.push_back( arg );
+    return result;
+  }
+
+  // the events of a topology in the layout of the framework:  particle j
+  // of event i at data[4*(nEvents*j+i)], E first
+  vector< GDouble > makeData( const Topology& topology, int nEvents, unsigned int seed ){
+
+    TRandom3 random( seed );
+    vector< GDouble > data( 4 * (size_t)nEvents * topology.nParticles );
+
+    for( int i = 0; i < nEvents; ++i ){
+
+      Event event = topology.generate( random );
+      assert( (int)event.size() == topology.nParticles );
+
+      for( int j = 0; j < topology.nParticles; ++j ){
+
+        GDouble* p = &data[4 * ( (size_t)nEvents * j + i )];
+        p[0] = event[j].E();
+        p[1] = event[j].Px();
+        p[2] = event[j].Py();
+        p[3] = event[j].Pz();
+      }
+    }
+
+    return data;
+  }
+
+  const Topology* findTopology( const string& name ){
+
+    for( unsigned int t = 0; t < sizeof( kTopologies ) / sizeof( kTopologies[0] ); ++t ){
+
+      if( kTopologies[t].name == name ) return &kTopologies[t];
+    }
+
+    cout << "amp_benchmark ERROR:  unknown topology " << name << endl;
+    assert( false );
+    return NULL;
+  }
+
+  void writeEvents( const Topology& topology, const string& fileName,
+                    int nEvents, unsigned int seed ){
+
+    TRandom3 random( seed );
+    ROOTDataWriter out( fileName );
+
+    for( int i = 0; i < nEvents; ++i ){
+
+      Event event = topology.generate( random );
+      out.writeEvent( Kinematics( event ) );
+    }
+
+    cout << "Wrote " << nEvents << " " << topology.name << " events to "
+         << fileName << endl;
+  }
+
+  // repeats work until at least minTime seconds have passed and returns
+  // the best time of one call in seconds
+  template< class Work >
+  double bestTime( double minTime, Work work ){
+
+    typedef chrono::steady_clock Clock;
+
+    double best = 0, total = 0;
+    int calls = 0;
+
+    while( total < minTime || calls < 3 ){
+
+      Clock::time_point start = Clock::now();
+      work();
+      double t = chrono::duration< double >( Clock::now() - start ).count();
+
+      if( calls == 0 || t < best ) best = t;
+      total += t;
+      ++calls;
+    }
+
+    return best;
+  }
+
+  struct Result {
+
+    double userVarsRate;  // events per second, 0 without user variables
+    double amplitudeRate;
+  };
+
+  string resultKey( const Benchmark& benchmark ){
+
+    return benchmark.topology + "/" + benchmark.amplitude;
+  }
+
+  map< string, Result > readBaseline( const string& fileName ){
+
+    map< string, Result > baseline;
+
+    ifstream in( fileName.c_str() );
+    if( !in.is_open() ){
+
+      cout << "amp_benchmark ERROR:  cannot read the baseline " << fileName << endl;
+      assert( false );
+    }
+
+    string line;
+    while( getline( in, line ) ){
+
+      if( line.empty() || line[0] == '#' ) continue;
+
+      istringstream fields( line );
+      string key;
+      Result result;
+      if( fields >> key >> result.userVarsRate >> result.amplitudeRate ){
+
+        baseline[key] = result;
+      }
+    }
+
+    return baseline;
+  }
+
+  string compare( double rate, const map< string, Result >& baseline,
+                  const string& key, bool userVars, double tolerance, bool& slower ){
+
+    map< string, Result >::const_iterator found = baseline.find( key );
+    if( found == baseline.end() ) return "";
+
+    double reference = ( userVars ? found->second.userVarsRate : found->second.amplitudeRate );
+    if( reference <= 0 || rate <= 0 ) return "";
+
+    double ratio = rate / reference;
+    if( ratio < 1 - tolerance ) slower = true;
+
+    ostringstream text;
+    text << fixed << setprecision( 2 ) << ratio << "x";
+    if( ratio < 1 - tolerance ) text << " SLOWER";
+    return text.str();
+  }
+}
+
+void Usage()
+{
+  cout << "Usage:\n  amp_benchmark [options]\n\n";
+  cout << "   Times the user variables and the amplitudes of every amplitude\n";
+  cout << "   on synthetic events and reports events per second.\n";
+  cout << "   Use -n [events] to set the number of events (default 100000).\n";
+  cout << "   Use -t [seconds] to set the minimum time per measurement (default 0.5).\n";
+  cout << "   Use -a [name] to only run the amplitudes or topologies matching name.\n";
+  cout << "   Use -s [seed] to set the seed of the events (default 1).\n";
+  cout << "   Use -o [file] to write the results as a baseline.\n";
+  cout << "   Use -b [file] to compare with a baseline; the exit code is 1 if\n";
+  cout << "     a rate is below the baseline by more than the tolerance.\n";
+  cout << "   Use -r [tolerance] to set the tolerance (default 0.1).\n";
+  cout << "   Use -l to list the benchmarks.\n";
+  cout << "   Use -g [topology] [file] [events] to only write the events of a\n";
+  cout << "     topology (2pi, etapi, omega, omegapi) to file with the seed of -s.\n";
+  exit(1);
+}
+
+int main( int argc, char* argv[] ){
+
+  int nEvents = 100000;
+  double minTime = 0.5;
+  double tolerance = 0.1;
+  unsigned int seed = 1;
+  string filter, outName, baselineName;
+  bool listOnly = false;
+  string genTopology, genFile;
+  int genEvents = 0;
+
+  for( int i = 1; i < argc; ++i ){
+
+    string arg = argv[i];
+
+    if( arg == "-l" ){ listOnly = true; continue; }
+    if( arg == "-g" ){
+      if( i + 3 >= argc ) Usage();
+      genTopology = argv[++i];
+      genFile = argv[++i];
+      genEvents = atoi( argv[++i] );
+      continue;
+    }
+    if( i + 1 == argc ) Usage();
+
+    if( arg == "-n" ) nEvents = atoi( argv[++i] );
+    else if( arg == "-t" ) minTime = atof( argv[++i] );
+    else if( arg == "-a" ) filter = argv[++i];
+    else if( arg == "-s" ) seed = atoi( argv[++i] );
+    else if( arg == "-o" ) outName = argv[++i];
+    else if( arg == "-b" ) baselineName = argv[++i];
+    else if( arg == "-r" ) tolerance = atof( argv[++i] );
+    else Usage();
+  }
+
+  if( nEvents <= 0 ) Usage();
+
+  if( !genTopology.empty() ){
+
+    if( genEvents <= 0 ) Usage();
+    writeEvents( *findTopology( genTopology ), genFile, genEvents, seed );
+    return 0;
+  }
+
+  const int nTopologies = sizeof( kTopologies ) / sizeof( kTopologies[0] );
+  const int nBenchmarks = sizeof( kBenchmarks ) / sizeof( kBenchmarks[0] );
+
+  if( listOnly ){
+
+    for( int b = 0; b < nBenchmarks; ++b ){
+
+      cout << setw( 32 ) << left << resultKey( kBenchmarks[b] )
+           << kBenchmarks[b].args << endl;
+    }
+    return 0;
+  }
+
+  map< string, Result > baseline;
+  if( !baselineName.empty() ) baseline = readBaseline( baselineName );
+
+  ofstream out;
+  if( !outName.empty() ){
+
+    out.open( outName.c_str() );
+    if( !out.is_open() ){
+
+      cout << "amp_benchmark ERROR:  cannot write " << outName << endl;
+      assert( false );
+    }
+    out << "# amp_benchmark -n " << nEvents << " -s " << seed << endl;
+    out << "# benchmark  userVars/s  amplitude/s" << endl;
+  }
+
+  cout << nEvents << " events per topology" << endl << endl;
+  cout << setw( 32 ) << left << "benchmark"
+       << setw( 14 ) << right << "userVars/s"
+       << setw( 14 ) << "amp/s"
+       << setw( 10 ) << "ns/event" << endl;
+
+  bool slower = false;
+
+  // the identity permutation:  the amplitudes are timed once per event
+  for( int t = 0; t < nTopologies; ++t ){
+
+    const Topology& topology = kTopologies[t];
+
+    vector< vector< int > > permutations( 1 );
+    for( int j = 0; j < topology.nParticles; ++j ) permutations[0].push_back( j );
+
+    vector< GDouble > data;
+
+    for( int b = 0; b < nBenchmarks; ++b ){
+
+      const Benchmark& benchmark = kBenchmarks[b];
+      if( benchmark.topology != topology.name ) continue;
+
+      string key = resultKey( benchmark );
+      if( !filter.empty() && key.find( filter ) == string::npos ) continue;
+
+      if( data.empty() ) data = makeData( topology, nEvents, seed );
+
+      Amplitude* amp = benchmark.make( splitArgs( benchmark.args ) );
+      amp->init();
+
+      vector< GDouble > userVars( (size_t)nEvents * ( amp->numUserVars() > 0 ? amp->numUserVars() : 1 ) );
+      vector< GDouble > amps( 2 * (size_t)nEvents );
+
+      Result result = { 0, 0 };
+
+      // the user variables are filled once in any case since the
+      // amplitudes read them
+      amp->calcUserVarsAll( &data[0], &userVars[0], nEvents, &permutations );
+
+      if( amp->numUserVars() > 0 ){
+
+        result.userVarsRate = nEvents / bestTime( minTime, [&](){
+            amp->calcUserVarsAll( &data[0], &userVars[0], nEvents, &permutations ); } );
+      }
+
+      result.amplitudeRate = nEvents / bestTime( minTime, [&](){
+          amp->calcAmplitudeAll( &data[0], &amps[0], nEvents, &permutations, &userVars[0] ); } );
+
+      // the time of an event in a fit in which the user variables are
+      // static is that of the amplitude alone
+      double nsPerEvent = 1e9 / result.amplitudeRate;
+      if( result.userVarsRate > 0 && !amp->areUserVarsStatic() ){
+
+        nsPerEvent += 1e9 / result.userVarsRate;
+      }
+
+      cout << setw( 32 ) << left << key << right << scientific << setprecision( 3 )
+           << setw( 14 ) << result.userVarsRate
+           << setw( 14 ) << result.amplitudeRate
+           << fixed << setprecision( 1 ) << setw( 10 ) << nsPerEvent;
+
+      if( !baseline.empty() ){
+
+        cout << "  " << compare( result.userVarsRate, baseline, key, true, tolerance, slower )
+             << "  " << compare( result.amplitudeRate, baseline, key, false, tolerance, slower );
+      }
+      cout << endl;
+
+      if( out.is_open() ){
+
+        out << key << " " << scientific << setprecision( 6 )
+            << result.userVarsRate << " " << result.amplitudeRate << endl;
+      }
+
+      delete amp;
+    }
+  }
+
+  if( out.is_open() ) out.close();
+
+  return ( slower ? 1 : 0 );
+}
@@ -0,0 +1,479 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <ctime>
+
+#include <unistd.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "IUAmpTools/FitResults.h"
+
+using namespace std;
+
+// Collects the intensities and phase differences of a binned fit, as run
+// by fit_bins, into one table with a row per bin.  The fit directory is
+// scanned for the bins bin_<i>[_<j>...], and the bin_*.fit of every bin
+// is read once by a pool of worker processes.  The waves are given on the
+// command line, so no program has to be written per analysis and there
+// is no limit on the number of bins.
+//
+// A wave is a name and a list of amplitude patterns (as for the shell,
+// matched against the full names of the amplitudes of all reactions):
+//
+//   -w S='Pi+Pi-Pi+::*::J1_rhopi_S'  -w all='*'
+//
+// and a phase difference is a name and two patterns that each match one
+// amplitude:
+//
+//   -p DP='Pi+Pi-Pi+::xpol::J2_rhopi_D,Pi+Pi-Pi+::xpol::J1_rhopi_P'
+//
+// The table has the columns i0, i1, ... (the index of the bin along each
+// axis), x0, x1, ... (the bin centers, for the axes given with -x),
+// valid, likelihood, eMatrixStatus and, for every wave and phase, <name>
+// and <name>_err.  It is written to the tree "waves" if the output file
+// ends in .root and as text with a header line otherwise.
+
+struct Wave {
+
+  string name;
+  vector< string > patterns;
+  bool phase;
+};
+
+struct Axis {
+
+  double low;
+  double high;
+  int numBins;
+};
+
+void Usage()
+{
+  cout << "Usage:\n  collect_waves <fitDir> -o <file> [OPTIONS]\n\n";
+  cout << "  Reads bin_<i>[_<j>...]/bin_<i>[_<j>...].fit for every bin of the fit directory\n";
+  cout << "  and writes a row per bin to <file> (a ROOT tree if it ends in .root, text otherwise).\n\n";
+  cout << "  Options: \n";
+  cout << "   -w [name=pattern[,pattern...]] : Intensity of the amplitudes that match the patterns (may be repeated)\n";
+  cout << "   -p [name=pattern,pattern]      : Phase difference of two amplitudes (may be repeated)\n";
+  cout << "   -x [low:high:nBins]            : Binning of the next axis, for the bin centers (may be repeated)\n";
+  cout << "   -u                             : Intensities not corrected for the acceptance\n";
+  cout << "   -j [nJobs]                     : Number of worker processes (default: number of cores)\n";
+  exit(1);
+}
+
+// the index of a bin from its name, or an empty vector if it is not a bin
+vector< int > BinIndex( const string& name )
+{
+  vector< int > index;
+  if( name.compare( 0, 4, "bin_" ) != 0 ) return index;
+
+  istringstream fields( name.substr( 4 ) );
+  string field;
+  while( getline( fields, field, '_' ) ){
+
+    if( field.empty() || field.find_first_not_of( "0123456789" ) != string::npos )
+      return vector< int >();
+    index.push_back( atoi( field.c_str() ) );
+  }
+  return index;
+}
+
+bool ParseWave( const string& arg, bool phase, Wave& wave )
+{
+  size_t eq = arg.find( '=' );
+  if( eq == string::npos || eq == 0 ) return false;
+
+  wave.name = arg.substr( 0, eq );
+  wave.phase = phase;
+
+  istringstream fields( arg.substr( eq + 1 ) );
+  string field;
+  while( getline( fields, field, ',' ) )
+    if( !field.empty() ) wave.patterns.push_back( field );
+
+  return phase ? wave.patterns.size() == 2 : !wave.patterns.empty();
+}
+
+vector< string > MatchAmplitudes( const vector< string >& amps, const string& pattern )
+{
+  vector< string > matched;
+  for( unsigned int i = 0; i < amps.size(); ++i )
+    if( fnmatch( pattern.c_str(), amps[i].c_str(), 0 ) == 0 ) matched.push_back( amps[i] );
+  return matched;
+}
+
+// the values of a bin: valid, likelihood, eMatrixStatus, then the value
+// and the error of every wave; a wave that matches no amplitudes is NaN
+vector< double > ReadBin( const string& fitDir, const string& name,
+                         const vector< Wave >& waves, bool accCorrected )
+{
+  vector< double > values( 3 + 2 * waves.size(), NAN );
+  values[0] = 0;
+
+  string fitFile = fitDir + "/" + name + "/" + name + ".fit";
+  if( access( fitFile.c_str(), R_OK ) != 0 ) return values;
+
+  FitResults results( fitFile );
+  if( !results.valid() ) return values;
+
+  values[0] = 1;
+  values[1] = results.likelihood();
+  values[2] = results.eMatrixStatus();
+
+  vector< string > amps;
+  vector< string > reactions = results.reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    vector< string > reactionAmps = results.ampList( reactions[i] );
+    amps.insert( amps.end(), reactionAmps.begin(), reactionAmps.end() );
+  }
+
+  for( unsigned int i = 0; i < waves.size(); ++i ){
+
+    const Wave& wave = waves[i];
+    pair< double, double > value( NAN, NAN );
+
+    if( wave.phase ){
+
+      vector< string > amp1 = MatchAmplitudes( amps, wave.patterns[0] );
+      vector< string > amp2 = MatchAmplitudes( amps, wave.patterns[1] );
+      if( amp1.size() == 1 && amp2.size() == 1 )
+        value = results.phaseDiff( amp1[0], amp2[0] );
+      else
+        cerr << "collect_waves ERROR:  the phase " << wave.name << " does not match one amplitude each in "
+             << name << endl;
+    }
+    else{
+
+      vector< string > waveAmps;
+      for( unsigned int j = 0; j < wave.patterns.size(); ++j ){
+
+        vector< string > matched = MatchAmplitudes( amps, wave.patterns[j] );
+        for( unsigned int k = 0; k < matched.size(); ++k )
+          if( find( waveAmps.begin(), waveAmps.end(), matched[k] ) == waveAmps.end() )
+            waveAmps.push_back( matched[k] );
+      }
+      if( !waveAmps.empty() )
+        value = results.intensity( waveAmps, accCorrected );
+      else
+        cerr << "collect_waves ERROR:  the wave " << wave.name << " matches no amplitude in "
+             << name << endl;
+    }
+
+    values[3 + 2 * i] = value.first;
+    values[4 + 2 * i] = value.second;
+  }
+
+  return values;
+}
+
+int main( int argc, char* argv[] ){
+
+  if( argc < 2 ) Usage();
+
+  string fitDir( argv[1] );
+  string outName;
+  vector< Wave > waves;
+  vector< Axis > axes;
+  bool accCorrected = true;
+  int nJobs = sysconf( _SC_NPROCESSORS_ONLN );
+
+  for( int i = 2; i < argc; ++i ){
+
+    string arg = argv[i];
+
+    if( arg == "-o" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else outName = argv[++i];
+    } else if( arg == "-w" || arg == "-p" ){
+      if (i+1 == argc) Usage();
+      Wave wave;
+      if( !ParseWave( argv[++i], arg == "-p", wave ) ) Usage();
+      waves.push_back( wave );
+    } else if( arg == "-x" ){
+      if (i+1 == argc) Usage();
+      Axis axis;
+      if( sscanf( argv[++i], "%lf:%lf:%d", &axis.low, &axis.high, &axis.numBins ) != 3 ||
+          axis.numBins <= 0 ) Usage();
+      axes.push_back( axis );
+    } else if( arg == "-u" ){
+      accCorrected = false;
+    } else if( arg == "-j" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else nJobs = atoi( argv[++i] );
+    } else {
+      Usage();
+    }
+  }
+
+  if( outName.empty() || nJobs <= 0 ) Usage();
+
+  // the bins of the fit directory, in the order of their index
+  DIR* dir = opendir( fitDir.c_str() );
+  if( dir == NULL ){
+
+    cout << "collect_waves ERROR:  cannot read the fit directory " << fitDir << endl;
+    exit(1);
+  }
+
+  map< vector< int >, string > binNames;
+  unsigned int numAxes = 0;
+  for( struct dirent* entry = readdir( dir ); entry != NULL; entry = readdir( dir ) ){
+
+    string name( entry->d_name );
+    vector< int > index = BinIndex( name );
+    if( index.empty() ) continue;
+
+    struct stat info;
+    if( stat( ( fitDir + "/" + name ).c_str(), &info ) != 0 || !S_ISDIR( info.st_mode ) ) continue;
+
+    if( numAxes == 0 ) numAxes = index.size();
+    if( index.size() != numAxes ){
+
+      cout << "collect_waves ERROR:  " << name << " does not have " << numAxes << " indices" << endl;
+      exit(1);
+    }
+    binNames[index] = name;
+  }
+  closedir( dir );
+
+  if( binNames.empty() ){
+
+    cout << "collect_waves ERROR:  no bins in " << fitDir << endl;
+    exit(1);
+  }
+  if( axes.size() > numAxes ){
+
+    cout << "collect_waves ERROR:  -x is given for " << axes.size() << " axes, the bins have "
+         << numAxes << endl;
+    exit(1);
+  }
+
+  vector< vector< int > > indices;
+  vector< string > names;
+  for( map< vector< int >, string >::const_iterator bin = binNames.begin();
+       bin != binNames.end(); ++bin ){
+
+    indices.push_back( bin->first );
+    names.push_back( bin->second );
+  }
+
+  unsigned int nBins = names.size();
+  unsigned int nValues = 3 + 2 * waves.size();
+  if( nJobs > (int)nBins ) nJobs = nBins;
+
+  cout << "collect_waves:  reading " << nBins << " bins with " << nJobs << " processes" << endl;
+  time_t begin = time( NULL );
+
+  // every worker reads the bins iBin % nJobs == job and sends a line per
+  // bin back through a pipe: the bin, then its values
+  vector< int > pipes( nJobs );
+  vector< pid_t > pids( nJobs );
+  for( int job = 0; job < nJobs; ++job ){
+
+    int fds[2];
+    if( pipe( fds ) != 0 ){
+
+      cout << "collect_waves ERROR:  cannot create a pipe" << endl;
+      exit(1);
+    }
+
+    cout << flush;
+    pids[job] = fork();
+    if( pids[job] < 0 ){
+
+      cout << "collect_waves ERROR:  cannot start a worker" << endl;
+      exit(1);
+    }
+    if( pids[job] == 0 ){
+
+      close( fds[0] );
+      FILE* out = fdopen( fds[1], "w" );
+      for( unsigned int iBin = job; iBin < nBins; iBin += nJobs ){
+
+        vector< double > values = ReadBin( fitDir, names[iBin], waves, accCorrected );
+        fprintf( out, "%u", iBin );
+        for( unsigned int k = 0; k < nValues; ++k ) fprintf( out, " %.17g", values[k] );
+        fprintf( out, "\n" );
+      }
+      fclose( out );
+      _exit(0);
+    }
+
+    close( fds[1] );
+    pipes[job] = fds[0];
+  }
+
+  // read all pipes as the lines come, so no worker waits on a full pipe
+  vector< vector< double > > rows( nBins );
+  vector< string > pending( nJobs );
+  int nOpen = nJobs;
+  unsigned int nRead = 0;
+
+  while( nOpen > 0 ){
+
+    vector< struct pollfd > fds;
+    vector< int > jobs;
+    for( int job = 0; job < nJobs; ++job ){
+
+      if( pipes[job] < 0 ) continue;
+      struct pollfd fd = { pipes[job], POLLIN, 0 };
+      fds.push_back( fd );
+      jobs.push_back( job );
+    }
+
+    if( poll( &( fds[0] ), fds.size(), -1 ) < 0 ) continue;
+
+    for( unsigned int k = 0; k < fds.size(); ++k ){
+
+      if( fds[k].revents == 0 ) continue;
+      int job = jobs[k];
+
+      char buffer[65536];
+      ssize_t n = read( pipes[job], buffer, sizeof( buffer ) );
+      if( n <= 0 ){
+
+        close( pipes[job] );
+        pipes[job] = -1;
+        --nOpen;
+        continue;
+      }
+      pending[job].append( buffer, n );
+
+      size_t end;
+      while( ( end = pending[job].find( '\n' ) ) != string::npos ){
+
+        istringstream line( pending[job].substr( 0, end ) );
+        pending[job].erase( 0, end + 1 );
+
+        unsigned int iBin;
+        line >> iBin;
+        if( !line || iBin >= nBins ) continue;
+
+        // the values are read as strings, so that nan survives the stream
+        rows[iBin].resize( nValues );
+        for( unsigned int v = 0; v < nValues; ++v ){
+
+          string value;
+          line >> value;
+          rows[iBin][v] = strtod( value.c_str(), NULL );
+        }
+        ++nRead;
+      }
+    }
+  }
+
+  int nFailed = 0;
+  for( int job = 0; job < nJobs; ++job ){
+
+    int status;
+    waitpid( pids[job], &status, 0 );
+    if( !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) ++nFailed;
+  }
+  if( nFailed > 0 || nRead != nBins ){
+
+    cout << "collect_waves ERROR:  " << nFailed << " workers failed, "
+         << nBins - nRead << " bins were not read" << endl;
+    exit(1);
+  }
+
+  // the columns
+  vector< string > columns;
+  for( unsigned int a = 0; a < numAxes; ++a ){
+
+    ostringstream column;
+    column << "i" << a;
+    columns.push_back( column.str() );
+  }
+  for( unsigned int a = 0; a < axes.size(); ++a ){
+
+    ostringstream column;
+    column << "x" << a;
+    columns.push_back( column.str() );
+  }
+  columns.push_back( "valid" );
+  columns.push_back( "likelihood" );
+  columns.push_back( "eMatrixStatus" );
+  for( unsigned int w = 0; w < waves.size(); ++w ){
+
+    columns.push_back( waves[w].name );
+    columns.push_back( waves[w].name + "_err" );
+  }
+
+  vector< double > row( columns.size() );
+  int nValid = 0;
+
+  bool rootOutput = outName.size() > 5 && outName.compare( outName.size() - 5, 5, ".root" ) == 0;
+
+  TFile* outFile = NULL;
+  TTree* outTree = NULL;
+  ofstream outText;
+
+  if( rootOutput ){
+
+    outFile = new TFile( outName.c_str(), "RECREATE" );
+    outTree = new TTree( "waves", "Waves of a binned fit" );
+    for( unsigned int c = 0; c < columns.size(); ++c )
+      outTree->Branch( columns[c].c_str(), &( row[c] ), ( columns[c] + "/D" ).c_str() );
+  }
+  else{
+
+    outText.open( outName.c_str() );
+    for( unsigned int c = 0; c < columns.size(); ++c )
+      outText << ( c > 0 ? "\t" : "" ) << columns[c];
+    outText << endl << setprecision( 10 );
+  }
+
+  for( unsigned int iBin = 0; iBin < nBins; ++iBin ){
+
+    unsigned int c = 0;
+    for( unsigned int a = 0; a < numAxes; ++a ) row[c++] = indices[iBin][a];
+    for( unsigned int a = 0; a < axes.size(); ++a ){
+
+      double step = ( axes[a].high - axes[a].low ) / axes[a].numBins;
+      row[c++] = axes[a].low + step * ( indices[iBin][a] + 0.5 );
+    }
+    for( unsigned int v = 0; v < nValues; ++v ) row[c++] = rows[iBin][v];
+
+    if( rows[iBin][0] != 0 ) ++nValid;
+
+    if( rootOutput ){
+
+      outTree->Fill();
+    }
+    else{
+
+      for( unsigned int k = 0; k < row.size(); ++k )
+        outText << ( k > 0 ? "\t" : "" ) << row[k];
+      outText << endl;
+    }
+  }
+
+  if( rootOutput ){
+
+    outFile->cd();
+    outTree->Write();
+    outFile->Close();
+    delete outFile;
+  }
+
+  cout << "collect_waves:  " << nValid << " of " << nBins << " bins have fit results, written to "
+       << outName << " in " << time( NULL ) - begin << " s" << endl;
+
+  return 0;
+}
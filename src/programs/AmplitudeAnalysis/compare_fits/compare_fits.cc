@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include "IUAmpTools/FitResults.h"
+
+using namespace std;
+
+// This compares the results of two fits of the same configuration, e.g.,
+// one from a build with mixed-precision GPU kernels (MIXED_PRECISION=1)
+// and one from the full double-precision build.  For every fit parameter
+// the difference is reported in units of the error of the first fit; the
+// exit code is nonzero if the largest difference exceeds the tolerance.
+
+void Usage()
+{
+  cout << "Usage:\n  compare_fits <fit file 1> <fit file 2> [tolerance]\n\n";
+  cout << "   the default tolerance on a parameter difference is 0.1 of its error\n";
+  exit(1);
+}
+
+int main( int argc, char* argv[] ){
+
+  if( argc < 3 || argc > 4 ) Usage();
+
+  double tolerance = ( argc == 4 ? atof( argv[3] ) : 0.1 );
+
+  FitResults results1( argv[1] );
+  FitResults results2( argv[2] );
+
+  if( !results1.valid() || !results2.valid() ){
+
+    cout << "compare_fits ERROR:  cannot read fit results" << endl;
+    exit(1);
+  }
+
+  vector< string > pars = results1.parNameList();
+
+  double maxDiff = 0;
+  string maxPar;
+
+  cout << setprecision( 4 );
+  cout << setw( 40 ) << left << "parameter" << right
+       << setw( 14 ) << "value 1" << setw( 14 ) << "value 2"
+       << setw( 14 ) << "error 1" << setw( 14 ) << "diff/error" << endl;
+
+  for( unsigned int i = 0; i < pars.size(); ++i ){
+
+    double value1 = results1.parValue( pars[i] );
+    double value2 = results2.parValue( pars[i] );
+    double error = results1.parError( pars[i] );
+
+    // fixed parameters have no error, compare them on their own scale
+    double scale = ( error > 0 ? error : max( fabs( value1 ), 1.0 ) );
+    double diff = fabs( value1 - value2 ) / scale;
+
+    cout << setw( 40 ) << left << pars[i] << right
+         << setw( 14 ) << value1 << setw( 14 ) << value2
+         << setw( 14 ) << error << setw( 14 ) << diff << endl;
+
+    if( diff > maxDiff ){
+
+      maxDiff = diff;
+      maxPar = pars[i];
+    }
+  }
+
+  cout << endl << setprecision( 10 );
+  cout << "  likelihood 1:  " << results1.likelihood() << endl;
+  cout << "  likelihood 2:  " << results2.likelihood() << endl;
+  cout << setprecision( 4 );
+  cout << "  largest parameter difference:  " << maxDiff
+       << " of the error  (" << maxPar << ")" << endl;
+
+  if( maxDiff > tolerance ){
+
+    cout << "The fits differ by more than the tolerance " << tolerance << endl;
+    return 1;
+  }
+
+  cout << "The fits agree within the tolerance " << tolerance << endl;
+  return 0;
+}
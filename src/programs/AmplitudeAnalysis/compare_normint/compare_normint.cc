@@ -0,0 +1,110 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstdlib>
+#include <cmath>
+
+#include "IUAmpTools/ConfigFileParser.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/NormIntInterface.h"
+
+using namespace std;
+
+// This compares two normalization integral files for the same reaction,
+// e.g., one written (with the normintfile keyword) by a fit that stores
+// events in single precision and one by a fit that uses double precision.
+// The largest relative difference of any amplitude and normalization
+// integral is reported; the exit code is nonzero if it exceeds the
+// tolerance.
+
+void Usage()
+{
+  cout << "Usage:\n  compare_normint <config file> <reaction> <normint file 1> <normint file 2> [tolerance]\n\n";
+  cout << "   the default tolerance on the relative difference is 1e-5\n";
+  exit(1);
+}
+
+double relDiff( const complex< double >& a, const complex< double >& b, double scale ){
+
+  // off-diagonal elements can be close to zero, so compare them on the
+  // scale of the diagonal elements
+  return abs( a - b ) / scale;
+}
+
+int main( int argc, char* argv[] ){
+
+  if( argc < 5 || argc > 6 ) Usage();
+
+  string configFile( argv[1] );
+  string reaction( argv[2] );
+  double tolerance = ( argc == 6 ? atof( argv[5] ) : 1E-5 );
+
+  ConfigFileParser parser( configFile );
+  ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
+
+  vector< string > amps;
+  vector< AmplitudeInfo* > ampList = cfgInfo->amplitudeList( reaction );
+  for( unsigned int i = 0; i < ampList.size(); ++i ) amps.push_back( ampList[i]->fullName() );
+
+  if( amps.empty() ){
+
+    cout << "compare_normint ERROR:  no amplitudes for reaction " << reaction << endl;
+    exit(1);
+  }
+
+  NormIntInterface ni1( argv[3] );
+  NormIntInterface ni2( argv[4] );
+
+  double maxAmpDiff = 0, maxNormDiff = 0;
+  string maxAmpPair, maxNormPair;
+
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+    for( unsigned int j = 0; j < amps.size(); ++j ){
+
+      double ampScale = sqrt( abs( ni1.ampInt( amps[i], amps[i] ) ) *
+                              abs( ni1.ampInt( amps[j], amps[j] ) ) );
+      double normScale = sqrt( abs( ni1.normInt( amps[i], amps[i] ) ) *
+                               abs( ni1.normInt( amps[j], amps[j] ) ) );
+
+      if( ampScale > 0 ){
+
+        double diff = relDiff( ni1.ampInt( amps[i], amps[j] ),
+                               ni2.ampInt( amps[i], amps[j] ), ampScale );
+        if( diff > maxAmpDiff ){
+
+          maxAmpDiff = diff;
+          maxAmpPair = amps[i] + " x " + amps[j];
+        }
+      }
+
+      if( normScale > 0 ){
+
+        double diff = relDiff( ni1.normInt( amps[i], amps[j] ),
+                               ni2.normInt( amps[i], amps[j] ), normScale );
+        if( diff > maxNormDiff ){
+
+          maxNormDiff = diff;
+          maxNormPair = amps[i] + " x " + amps[j];
+        }
+      }
+    }
+  }
+
+  cout << setprecision( 4 );
+  cout << "Compared " << amps.size() << " amplitudes of reaction " << reaction << endl;
+  cout << "  largest relative difference of amplitude integrals:      "
+       << maxAmpDiff << "  (" << maxAmpPair << ")" << endl;
+  cout << "  largest relative difference of normalization integrals:  "
+       << maxNormDiff << "  (" << maxNormPair << ")" << endl;
+
+  if( maxAmpDiff > tolerance || maxNormDiff > tolerance ){
+
+    cout << "The integrals differ by more than the tolerance " << tolerance << endl;
+    return 1;
+  }
+
+  cout << "The integrals agree within the tolerance " << tolerance << endl;
+  return 0;
+}
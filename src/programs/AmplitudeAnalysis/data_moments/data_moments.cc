@@ -0,0 +1,485 @@
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <complex>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/DataReader.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderPipeline.h"
+#include "AMPTOOLS_DATAIO/BinaryDataReader.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+#include "AMPTOOLS_AMPS/twoBodyAngles.h"
+#include "AMPTOOLS_AMPS/wignerD.h"
+
+#include "TLorentzVector.h"
+#include "TMatrixDSym.h"
+#include "TDecompChol.h"
+#include "TFile.h"
+#include "TH1.h"
+
+using namespace std;
+
+// Computes the moments of the angular distribution of a two-body system
+// directly from the events, without a fit.  In each mass bin the moment
+// of the real spherical harmonic f_k is
+//
+//   h_k = sum over data of w f_k( Omega )
+//
+// with f_LM = Y_L0 for M = 0, sqrt(2) Re Y_LM for M > 0 and
+// sqrt(2) Im Y_L|M| for M < 0.  With accepted and generated MC the
+// acceptance is corrected by solving h = A t for the moments t of the
+// produced events, where
+//
+//   A_kk' = 4 pi / N_gen sum over accMC of w f_k f_k'
+//
+// and N_gen is the (weighted) number of generated events of the bin; the
+// generated MC is assumed to be isotropic in the decay angles.  The errors
+// are the diagonal of A^-1 V A^-1, with V_kk' = sum over data of
+// w^2 f_k f_k' (the statistical errors of the MC are not included).
+//
+// The events are read in blocks; the angles and the sums of a block are
+// computed on all threads, each on its own part of the block with its own
+// sums, which are added at the end.
+
+namespace {
+
+  template< class R >
+  DataReader* makeReader( const vector< string >& args ){ return new R( args ); }
+
+  struct ReaderType {
+
+    string name;
+    DataReader* (*make)( const vector< string >& );
+  };
+
+  const ReaderType kReaderTypes[] = {
+
+    { "ROOTDataReader",          makeReader< ROOTDataReader > },
+    { "ROOTDataReaderBootstrap", makeReader< ROOTDataReaderBootstrap > },
+    { "ROOTDataReaderWithTCut",  makeReader< ROOTDataReaderWithTCut > },
+    { "ROOTDataReaderTEM",       makeReader< ROOTDataReaderTEM > },
+    { "ROOTDataReaderPipeline",  makeReader< ROOTDataReaderPipeline > },
+    { "BinaryDataReader",        makeReader< BinaryDataReader > }
+  };
+
+  const unsigned int kBlockSize = 1 << 16;
+
+  // what is summed for each event of a sample
+  enum Sums { kCounts, kMoments, kAcceptance };
+
+  struct Setup {
+
+    int recoil, p1, p2;
+    TwoBodyFrame frame;
+    int maxL;
+    vector< double > edges;
+    int nChunks;
+  };
+
+  int numFunctions( int maxL ){ return ( maxL + 1 ) * ( maxL + 1 ); }
+
+  // the values per bin:  the weight for kCounts, h and V for kMoments,
+  // A (without the factor 4 pi / N_gen) for kAcceptance
+  int stride( Sums sums, int maxL ){
+
+    int n = numFunctions( maxL );
+    if( sums == kCounts ) return 1;
+    if( sums == kMoments ) return n + n * n;
+    return n * n;
+  }
+
+  // the real spherical harmonics f[l*(l+1)+m] of one event
+  void realHarmonics( int maxL, double cosTheta, double phi,
+                      vector< complex< GDouble > >& ylm, double* f ){
+
+    sphericalHarmonics( maxL, cosTheta, phi, &( ylm[0] ) );
+
+    for( int l = 0; l <= maxL; ++l ){
+
+      f[l*(l+1)] = real( ylm[l*(l+1)] );
+      for( int m = 1; m <= l; ++m ){
+
+        f[l*(l+1)+m] = sqrt( 2. ) * real( ylm[l*(l+1)+m] );
+        f[l*(l+1)-m] = sqrt( 2. ) * imag( ylm[l*(l+1)+m] );
+      }
+    }
+  }
+
+  // a block of events in structure-of-arrays layout
+  struct Block {
+
+    Block() : size( 0 ){
+
+      for( int k = 0; k < 4; ++k ){
+
+        beam[k].resize( kBlockSize );
+        recoil[k].resize( kBlockSize );
+        p1[k].resize( kBlockSize );
+        p2[k].resize( kBlockSize );
+      }
+      weight.resize( kBlockSize );
+      cosTheta.resize( kBlockSize );
+      phi.resize( kBlockSize );
+    }
+
+    vector< GDouble > beam[4], recoil[4], p1[4], p2[4];
+    vector< double > weight;
+    vector< GDouble > cosTheta, phi;
+    unsigned int size;
+  };
+
+  void fill( vector< GDouble >* v, unsigned int i, const TLorentzVector& p ){
+
+    v[0][i] = p.E();
+    v[1][i] = p.Px();
+    v[2][i] = p.Py();
+    v[3][i] = p.Pz();
+  }
+
+  // the sums of the events of part of the block into sums
+  void sumBlock( const Setup& setup, Sums what, const Block& block,
+                 unsigned int begin, unsigned int end, double* sums ){
+
+    int n = numFunctions( setup.maxL );
+    int width = stride( what, setup.maxL );
+    int nBins = setup.edges.size() - 1;
+
+    vector< complex< GDouble > > ylm( n );
+    vector< double > f( n );
+
+    for( unsigned int i = begin; i < end; ++i ){
+
+      GDouble e = block.p1[0][i] + block.p2[0][i];
+      GDouble px = block.p1[1][i] + block.p2[1][i];
+      GDouble py = block.p1[2][i] + block.p2[2][i];
+      GDouble pz = block.p1[3][i] + block.p2[3][i];
+      double mass = sqrt( max( (GDouble)0, e * e - px * px - py * py - pz * pz ) );
+
+      int bin = static_cast< int >( upper_bound( setup.edges.begin(), setup.edges.end(), mass ) -
+                                    setup.edges.begin() ) - 1;
+      if( bin < 0 || bin >= nBins ) continue;
+
+      double* s = sums + bin * width;
+      double w = block.weight[i];
+
+      if( what == kCounts ){
+
+        s[0] += w;
+        continue;
+      }
+
+      realHarmonics( setup.maxL, block.cosTheta[i], block.phi[i], ylm, &( f[0] ) );
+
+      if( what == kMoments ){
+
+        for( int k = 0; k < n; ++k ) s[k] += w * f[k];
+        s += n;
+        w *= w;
+      }
+
+      for( int k = 0; k < n; ++k ){
+
+        double wf = w * f[k];
+        for( int k2 = 0; k2 < n; ++k2 ) s[k * n + k2] += wf * f[k2];
+      }
+    }
+  }
+
+  // the sums of all events of the reader given as "<type> <args ...>"
+  vector< double > sumEvents( const Setup& setup, Sums what, const string& readerSpec ){
+
+    istringstream fields( readerSpec );
+    string typeName, arg;
+    vector< string > args;
+    fields >> typeName;
+    while( fields >> arg ) args.push_back( arg );
+
+    const ReaderType* type = NULL;
+    for( unsigned int t = 0; t < sizeof( kReaderTypes ) / sizeof( kReaderTypes[0] ); ++t ){
+
+      if( kReaderTypes[t].name == typeName ) type = &kReaderTypes[t];
+    }
+
+    if( type == NULL || args.empty() ){
+
+      cout << "data_moments ERROR:  unknown reader " << readerSpec << endl;
+      exit( 1 );
+    }
+
+    DataReader* reader = type->make( args );
+
+    int width = stride( what, setup.maxL );
+    int nBins = setup.edges.size() - 1;
+
+    // the sums of each chunk of the blocks, added at the end
+    vector< vector< double > > chunkSums( setup.nChunks, vector< double >( nBins * width, 0. ) );
+
+    Block block;
+    unsigned long long nEvents = 0;
+    bool more = true;
+    while( more ){
+
+      block.size = 0;
+      Kinematics* kin;
+      while( block.size < kBlockSize && ( kin = reader->getEvent() ) != NULL ){
+
+        unsigned int i = block.size++;
+        fill( block.beam, i, kin->particle( 0 ) );
+        fill( block.recoil, i, kin->particle( setup.recoil ) );
+        fill( block.p1, i, kin->particle( setup.p1 ) );
+        fill( block.p2, i, kin->particle( setup.p2 ) );
+        block.weight[i] = kin->weight();
+        delete kin;
+      }
+      more = ( block.size == kBlockSize );
+      nEvents += block.size;
+
+      unsigned int chunkSize = ( block.size + setup.nChunks - 1 ) / setup.nChunks;
+      // one chunk per call, so that the chunks are shared over the threads
+      // however few they are
+      AmplitudeThreads::runChunks( setup.nChunks, 1, [&]( int first, int last ){
+
+        for( int c = first; c < last; ++c ){
+
+          unsigned int begin = min( block.size, c * chunkSize );
+          unsigned int end = min( block.size, begin + chunkSize );
+          if( begin == end ) continue;
+
+          if( what != kCounts ){
+
+            const GDouble* beam[4], * recoil[4], * p1[4], * p2[4];
+            for( int k = 0; k < 4; ++k ){
+
+              beam[k] = &( block.beam[k][begin] );
+              recoil[k] = &( block.recoil[k][begin] );
+              p1[k] = &( block.p1[k][begin] );
+              p2[k] = &( block.p2[k][begin] );
+            }
+            twoBodyAnglesBatch( setup.frame, end - begin, beam, recoil, p1, p2,
+                                &( block.cosTheta[begin] ), &( block.phi[begin] ) );
+          }
+
+          sumBlock( setup, what, block, begin, end, &( chunkSums[c][0] ) );
+        }
+      } );
+    }
+
+    delete reader;
+
+    cout << "data_moments:  read " << nEvents << " events from " << readerSpec << endl;
+
+    vector< double > sums( nBins * width, 0. );
+    for( int c = 0; c < setup.nChunks; ++c )
+      for( unsigned int i = 0; i < sums.size(); ++i ) sums[i] += chunkSums[c][i];
+
+    return sums;
+  }
+
+  // the bin edges in edgeFile, increasing and separated by white space, as
+  // for split_mass -b
+  vector< double > readEdges( const string& edgeFile ){
+
+    vector< double > edges;
+    ifstream in( edgeFile.c_str() );
+    double edge;
+    while( in >> edge ) edges.push_back( edge );
+
+    for( size_t i = 1; i < edges.size(); ++i ){
+      if( edges[i] <= edges[i-1] ) edges.clear();
+    }
+    if( edges.size() < 2 ){
+      cout << "data_moments ERROR:  " << edgeFile << " does not hold two or more increasing bin edges" << endl;
+      exit( 1 );
+    }
+    return edges;
+  }
+
+  void Usage(){
+
+    cout << "Usage:  data_moments -d <reader> [-a <reader> -g <reader>] -m <low>:<high>:<n> -o <file.root>\n\n";
+    cout << "   Computes the moments of the decay angles of particles p1 and p2 in bins of\n";
+    cout << "   their mass from the events, corrected for the acceptance if the accepted\n";
+    cout << "   and generated MC are given.  A reader is its type and arguments in one\n";
+    cout << "   argument, e.g. -d \"ROOTDataReader data.root kin\".\n\n";
+    cout << "   -d <reader>      the data\n";
+    cout << "   -a <reader>      the accepted MC\n";
+    cout << "   -g <reader>      the generated MC\n";
+    cout << "   -m <low>:<high>:<n>  n mass bins from low to high\n";
+    cout << "   -b <edgeFile>    the mass bin edges, as for split_mass -b\n";
+    cout << "   -p <r>,<p1>,<p2> the indices of the recoil and the two particles (default: 1,2,3)\n";
+    cout << "   -F <frame>       hel (default), heln (lab production plane) or gj\n";
+    cout << "   -L <maxL>        the highest L (default: 4)\n";
+    cout << "   -j <n>           the number of threads (default: 1)\n";
+    cout << "   -o <file>        the histograms hMoment<L><M> (M >= 0, from Re Y_LM) and\n";
+    cout << "                    hMoment<L>m<M> (from Im Y_LM) of the moments (default: data_moments.root)\n";
+    cout << endl;
+    exit( 1 );
+  }
+}
+
+int main( int argc, char* argv[] ){
+
+  string dataReader, accReader, genReader;
+  string outName( "data_moments.root" );
+  string edgeFile;
+  double lowMass = 0, highMass = 0;
+  int nMassBins = 0;
+  int nThreads = 1;
+
+  Setup setup;
+  setup.recoil = 1;
+  setup.p1 = 2;
+  setup.p2 = 3;
+  setup.frame = kHelicity;
+  setup.maxL = 4;
+
+  for( int i = 1; i < argc; ++i ){
+
+    string arg( argv[i] );
+
+    if( arg == "-d" || arg == "-a" || arg == "-g" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      ( arg == "-d" ? dataReader : arg == "-a" ? accReader : genReader ) = argv[++i];
+    } else if( arg == "-m" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      if( sscanf( argv[++i], "%lf:%lf:%d", &lowMass, &highMass, &nMassBins ) != 3 ||
+          nMassBins <= 0 || highMass <= lowMass ) Usage();
+    } else if( arg == "-b" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else edgeFile = argv[++i];
+    } else if( arg == "-p" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      if( sscanf( argv[++i], "%d,%d,%d", &setup.recoil, &setup.p1, &setup.p2 ) != 3 ) Usage();
+    } else if( arg == "-F" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      string frame( argv[++i] );
+      if( frame == "hel" ) setup.frame = kHelicity;
+      else if( frame == "heln" ) setup.frame = kHelicityLabNormal;
+      else if( frame == "gj" ) setup.frame = kGottfriedJackson;
+      else Usage();
+    } else if( arg == "-L" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else setup.maxL = atoi( argv[++i] );
+    } else if( arg == "-j" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else nThreads = atoi( argv[++i] );
+    } else if( arg == "-o" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else outName = argv[++i];
+    } else {
+      Usage();
+    }
+  }
+
+  if( dataReader.empty() || setup.maxL < 0 || nThreads <= 0 ) Usage();
+  if( accReader.empty() != genReader.empty() ){
+    cout << "data_moments ERROR:  the acceptance needs both -a and -g" << endl;
+    exit( 1 );
+  }
+
+  if( !edgeFile.empty() ) setup.edges = readEdges( edgeFile );
+  else if( nMassBins > 0 ){
+    for( int i = 0; i <= nMassBins; ++i )
+      setup.edges.push_back( lowMass + i * ( highMass - lowMass ) / nMassBins );
+  }
+  else Usage();
+
+  AmplitudeThreads::setNumThreads( nThreads );
+  setup.nChunks = 4 * nThreads;
+
+  int nBins = setup.edges.size() - 1;
+  int n = numFunctions( setup.maxL );
+
+  vector< double > data = sumEvents( setup, kMoments, dataReader );
+  vector< double > acc, gen;
+  if( !accReader.empty() ){
+
+    acc = sumEvents( setup, kAcceptance, accReader );
+    gen = sumEvents( setup, kCounts, genReader );
+  }
+
+  TFile out( outName.c_str(), "recreate" );
+  if( !out.IsOpen() ) exit( 1 );
+
+  vector< TH1D* > hMoments( n );
+  for( int l = 0; l <= setup.maxL; ++l ){
+    for( int m = -l; m <= l; ++m ){
+
+      char name[64], title[64];
+      if( m >= 0 ){
+        snprintf( name, sizeof( name ), "hMoment%d%d", l, m );
+        snprintf( title, sizeof( title ), "Moment H(%d,%d)", l, m );
+      }
+      else{
+        snprintf( name, sizeof( name ), "hMoment%dm%d", l, -m );
+        snprintf( title, sizeof( title ), "Moment H(%d,%d) from Im Y", l, -m );
+      }
+      hMoments[l*(l+1)+m] = new TH1D( name, title, nBins, &( setup.edges[0] ) );
+    }
+  }
+
+  for( int bin = 0; bin < nBins; ++bin ){
+
+    const double* h = &( data[bin * ( n + n * n )] );
+    const double* V = h + n;
+
+    // without the acceptance, t = h and its covariance is V
+    TMatrixDSym inverse( n );
+    inverse.UnitMatrix();
+
+    if( !acc.empty() ){
+
+      if( gen[bin] <= 0 ){
+
+        cout << "data_moments WARNING:  no generated events in bin " << bin << ", skipping it" << endl;
+        continue;
+      }
+
+      TMatrixDSym A( n );
+      for( int k = 0; k < n; ++k )
+        for( int k2 = 0; k2 < n; ++k2 )
+          A( k, k2 ) = 4 * M_PI / gen[bin] * acc[( bin * n + k ) * n + k2];
+
+      TDecompChol chol( A );
+      if( !chol.Decompose() || !chol.Invert( inverse ) ){
+
+        cout << "data_moments WARNING:  the acceptance of bin " << bin
+             << " cannot be inverted (too few accepted MC events for L <= "
+             << setup.maxL << "), skipping it" << endl;
+        continue;
+      }
+    }
+
+    for( int k = 0; k < n; ++k ){
+
+      double t = 0, var = 0;
+      for( int a = 0; a < n; ++a ){
+
+        t += inverse( k, a ) * h[a];
+        for( int b = 0; b < n; ++b ) var += inverse( k, a ) * V[a * n + b] * inverse( b, k );
+      }
+
+      hMoments[k]->SetBinContent( bin + 1, t );
+      hMoments[k]->SetBinError( bin + 1, sqrt( max( var, 0. ) ) );
+    }
+  }
+
+  for( int k = 0; k < n; ++k ) hMoments[k]->Write();
+  out.Close();
+
+  cout << "Moment histograms written to " << outName << endl;
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <stdint.h>
+
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+
+#include "BootstrapSampler.h"
+
+BootstrapSampler::BootstrapSampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo )
+{
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    Sample* sample = new Sample;
+    sample->reaction = reactions[i]->reactionName();
+    sample->index = i;
+    sample->nPart = 0;
+    sample->seed = 0;
+    sample->next = 0;
+
+    if( !reactions[i]->bkgnd().first.empty() )
+      cout << "BootstrapSampler:  the background of reaction " << sample->reaction
+           << " is not resampled" << endl;
+
+    DataReader* data = ati.dataReader( sample->reaction );
+    assert( data != NULL );
+    data->resetSource();
+
+    Kinematics* event;
+    while( ( event = data->getEvent() ) != NULL ){
+
+      const vector< TLorentzVector >& particles = event->particleList();
+      if( sample->weight.empty() ) sample->nPart = particles.size();
+      assert( static_cast< int >( particles.size() ) == sample->nPart );
+
+      for( int j = 0; j < sample->nPart; ++j ){
+
+        sample->p4.push_back( particles[j].E() );
+        sample->p4.push_back( particles[j].Px() );
+        sample->p4.push_back( particles[j].Py() );
+        sample->p4.push_back( particles[j].Pz() );
+      }
+      sample->weight.push_back( event->weight() );
+
+      delete event;
+    }
+    data->resetSource();
+
+    cout << "BootstrapSampler:  " << sample->weight.size() << " data events for the replicas of reaction "
+         << sample->reaction << endl;
+
+    // the readers of the replica fits read the current replica, and
+    // again from its start if the framework reads the data more than once
+    StreamDataReader::registerSource( "bootstrap_" + sample->reaction,
+      [sample]( vector< TLorentzVector >& particles, float& weight ){
+
+        unsigned int nEvents = sample->weight.size();
+        unsigned int n = 0;
+        while( sample->next < nEvents &&
+               ( n = count( sample->seed, sample->index, sample->next ) ) == 0 ) ++sample->next;
+
+        if( sample->next == nEvents ){
+
+          sample->next = 0;
+          return false;
+        }
+
+        const float* p = &sample->p4[sample->next * 4 * sample->nPart];
+
+        particles.resize( sample->nPart );
+        for( int j = 0; j < sample->nPart; ++j, p += 4 )
+          particles[j].SetPxPyPzE( p[1], p[2], p[3], p[0] );
+
+        weight = sample->weight[sample->next++] * n;
+        return true;
+      } );
+
+    m_samples.push_back( sample );
+  }
+}
+
+void
+BootstrapSampler::draw( unsigned int seed )
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    m_samples[i]->seed = seed;
+    m_samples[i]->next = 0;
+  }
+}
+
+void
+BootstrapSampler::useReplicas( ConfigurationInfo* cfgInfo ) const
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    ReactionInfo* reaction = cfgInfo->reaction( m_samples[i]->reaction );
+    reaction->setData( "StreamDataReader",
+                       vector< string >( 1, "callback:bootstrap_" + m_samples[i]->reaction ) );
+  }
+}
+
+unsigned int
+BootstrapSampler::count( unsigned int seed, unsigned int reaction, unsigned int event )
+{
+  // the finalizer of splitmix64 on the seed, the reaction and the event
+  uint64_t z = ( ( (uint64_t)seed << 32 ) | reaction ) * 0x9E3779B97F4A7C15ULL ^
+               ( (uint64_t)event + 1 ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  z = z ^ ( z >> 31 );
+  double u = ( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+
+  // inversion of the cumulative Poisson distribution of mean one
+  unsigned int n = 0;
+  double p = exp( -1. );
+  double cumulative = p;
+  while( u >= cumulative && n < 20 ){
+
+    ++n;
+    p /= n;
+    cumulative += p;
+  }
+  return n;
+}
@@ -0,0 +1,68 @@
+#if !defined(BOOTSTRAPSAMPLER)
+#define BOOTSTRAPSAMPLER
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * The data replicas of a Poisson bootstrap.  The data events of every
+ * reaction are read once and kept in memory; in each replica every event
+ * appears with a weight times a count drawn from a Poisson distribution of
+ * mean one, and events with a count of zero are left out.  This is the
+ * weighted=1 mode of ROOTDataReaderBootstrap, with the Poisson counts of
+ * the large-sample limit, without a fit process that reads the file again
+ * for every replica.
+ *
+ * The counts come from a counter-based generator, a hash of the seed of
+ * the replica, the reaction and the index of the event, so they are not
+ * stored and a replica does not depend on the order in which the replicas
+ * are drawn or on the process that fits it.  The replicas are read by the
+ * fits through StreamDataReader as "callback:bootstrap_<reaction>".  The
+ * accepted and generated MC do not change between replicas, so their
+ * normalization integrals can be kept in a NormIntCache.
+ */
+
+class BootstrapSampler
+{
+
+public:
+
+  BootstrapSampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+
+  // the replica with this seed
+  void draw( unsigned int seed );
+
+  /**
+   * Makes the reactions of cfgInfo read the data of the last replica.
+   */
+  void useReplicas( ConfigurationInfo* cfgInfo ) const;
+
+  // the Poisson count of event of reaction in the replica of seed
+  static unsigned int count( unsigned int seed, unsigned int reaction, unsigned int event );
+
+private:
+
+  struct Sample {
+
+    string reaction;
+    unsigned int index;
+    int nPart;
+
+    // E, Px, Py, Pz of every particle of every data event and its weight
+    vector< float > p4;
+    vector< float > weight;
+
+    // the seed of the current replica and the next event to read
+    unsigned int seed;
+    unsigned int next;
+  };
+
+  vector< Sample* > m_samples;
+};
+
+#endif
@@ -0,0 +1,140 @@
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "AMPTOOLS_DATAIO/ROOTDataReaderOptions.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderGrid.h"
+#include "AMPTOOLS_DATAIO/SignedDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_AMPS/UserVarsCache.h"
+
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigFileParser.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "FitSession.h"
+#include "ChainedFits.h"
+
+namespace {
+
+// the files of the data of every reaction with their sizes and times,
+// which change when a file is added or written
+string dataSignature(ConfigurationInfo* cfgInfo) {
+   ostringstream signature;
+   vector<ReactionInfo*> reactions = cfgInfo->reactionList();
+   for( unsigned int i = 0; i < reactions.size(); ++i ){
+      vector<string> args = reactions[i]->data().second;
+      if( reactions[i]->data().first == "SignedDataReader" ) args = SignedDataReader::dataSource( args ).second;
+      if( args.size() == 0 ) continue;
+      vector<string> files = readerSourceFiles( args[0] );
+      for( unsigned int f = 0; f < files.size(); ++f ){
+         struct stat info;
+         if( stat( files[f].c_str(), &info ) != 0 ) continue;
+         signature << files[f] << " " << info.st_size << " " << info.st_mtime << endl;
+      }
+   }
+   return signature.str();
+}
+
+}
+
+void followData(FitSession& session, const string& cfgName, ConfigurationInfo* cfgInfo, const string& seedfile) {
+   double followSeconds = session.options().followSeconds;
+
+   // every fit starts from the minimum of the one before, but those of
+   // --binned start from the config file
+   ScanStart start;
+   ScanStart* from = ( session.options().binnedGrid.size() == 0 ? &start : NULL );
+   string fitted = dataSignature( cfgInfo );
+   session.runSingleFit( cfgInfo, seedfile, from );
+
+   string previous = fitted;
+   cout << "WAITING FOR NEW DATA, CHECKED EVERY " << followSeconds << " S" << endl;
+   while( true ){
+      usleep( (useconds_t)( followSeconds * 1e6 ) );
+      string current = dataSignature( cfgInfo );
+      bool stable = ( current == previous );
+      previous = current;
+      if( current == fitted || !stable ) continue;
+      fitted = current;
+
+      cout << endl << "DATA CHANGED, FITTING " << cfgName << " AGAIN FROM THE LAST MINIMUM" << endl;
+      ConfigFileParser parser(cfgName);
+      ConfigurationInfo* newInfo = parser.getConfigurationInfo();
+      session.pruneWaves(newInfo);
+      session.fuseBackground(newInfo);
+      session.registerAmplitudes(newInfo);
+      if (session.normIntCache() != NULL) session.normIntCache()->prepare(newInfo);
+      session.runSingleFit(newInfo, seedfile, from);
+
+      if (session.options().cacheUserVars)
+         cout << "STATIC USER VARIABLES OF " << UserVarsCache::numHits() << " BLOCKS REUSED, "
+              << UserVarsCache::numStored() << " KEPT" << endl;
+      cout << "WAITING FOR NEW DATA" << endl;
+   }
+}
+
+void runBinnedCheck(FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile) {
+   string fitName = cfgInfo->fitName();
+   const string& binnedGrid = session.options().binnedGrid;
+
+   // the unbinned fit starts from the minimum of the binned one
+   ScanStart start;
+
+   chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+   double binnedLL = session.runSingleFit(cfgInfo, "", &start, "binned");
+   double binnedSeconds = chrono::duration< double >( chrono::steady_clock::now() - begin ).count();
+   if( binnedLL == 1e6 ){
+      cout << "ERROR:  the binned fit failed, the unbinned fit is not done" << endl;
+      return;
+   }
+
+   // the unbinned fit reads all events
+   ROOTDataReaderGrid::setGrid("");
+   begin = chrono::steady_clock::now();
+   double unbinnedLL = session.runSingleFit(cfgInfo, seedfile, &start);
+   double unbinnedSeconds = chrono::duration< double >( chrono::steady_clock::now() - begin ).count();
+   ROOTDataReaderGrid::setGrid(binnedGrid);
+   if( unbinnedLL == 1e6 ){
+      cout << "ERROR:  the unbinned fit failed, no bias is reported" << endl;
+      return;
+   }
+
+   FitResults binned( fitName + "_binned.fit" );
+   FitResults unbinned( fitName + ".fit" );
+
+   ostringstream report;
+   report << "# grid " << binnedGrid << endl;
+   report << "# binned fit " << binnedSeconds << " s, likelihood " << setprecision(12) << binnedLL << endl;
+   report << "# unbinned fit " << setprecision(6) << unbinnedSeconds << " s, likelihood " << setprecision(12) << unbinnedLL << endl;
+   report << "# parameter\tbinned\tunbinned\terror\tbias/error" << endl;
+   report << setprecision(6);
+   double maxPull = 0;
+   vector<string> parNames = unbinned.parNameList();
+   for(size_t ipar=0; ipar<parNames.size(); ipar++) {
+      double error = unbinned.parError( parNames[ipar] );
+      if( error <= 0 ) continue;
+      double pull = ( binned.parValue( parNames[ipar] ) - unbinned.parValue( parNames[ipar] ) ) / error;
+      maxPull = max( maxPull, fabs( pull ) );
+      report << parNames[ipar] << "\t" << binned.parValue( parNames[ipar] ) << "\t" << unbinned.parValue( parNames[ipar] )
+             << "\t" << error << "\t" << pull << endl;
+   }
+
+   cout << endl << "BIAS OF THE BINNED FIT" << endl << report.str();
+   cout << "LARGEST BIAS:  " << maxPull << " ERRORS, BINNED FIT " << binnedSeconds << " S, UNBINNED FIT " << unbinnedSeconds << " S" << endl;
+
+   string fileName = fitName + "_binned_bias.txt";
+   ofstream out( fileName.c_str() );
+   out << report.str();
+   if( !out ) cout << "ERROR:  cannot write " << fileName << endl;
+}
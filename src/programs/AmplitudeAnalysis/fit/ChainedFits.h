@@ -0,0 +1,43 @@
+#if !defined(CHAINEDFITS)
+#define CHAINEDFITS
+
+#include <string>
+
+using namespace std;
+
+class ConfigurationInfo;
+class FitSession;
+
+/**
+ * The single fits that start from the minimum of the fit before them,
+ * which is handed from one fit to the next by FitSession::runSingleFit.
+ */
+
+/**
+ * With --follow <seconds> the fit of cfgName is done, and done again
+ * whenever the files of its data change, e.g., when the file of a new run
+ * matches the pattern of a reader (see readerSourceFiles), checked every
+ * so many seconds until the program is stopped.  A change is only fit once
+ * the files have stayed the same for one check, so that a file that is
+ * still being written is not read.  The static user variables are kept by
+ * blocks of events (as with --keep-uservars, see UserVarsCache), so those
+ * of the events read before are copied and only those of the new events
+ * are computed, and with -N the integrals of the MC, which does not
+ * change, are read from the cache.
+ */
+void followData( FitSession& session, const string& cfgName, ConfigurationInfo* cfgInfo, const string& seedfile );
+
+/**
+ * With --binned <grid> the data and accepted MC of ROOTDataReader are read
+ * as one weighted event per bin of the grid (see ROOTDataReaderGrid), so a
+ * fit of a very large sample evaluates the amplitudes only at the bins
+ * that are not empty.  With --binned-check the binned fit is written to
+ * <fitName>_binned.fit and followed by the fit of all events from its
+ * minimum, and the difference of every parameter in units of its error
+ * in the unbinned fit is written to <fitName>_binned_bias.txt, to choose
+ * a grid whose bias is small before the binned fits of many bins or
+ * samples.
+ */
+void runBinnedCheck( FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile );
+
+#endif
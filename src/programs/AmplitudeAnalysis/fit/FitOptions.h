@@ -0,0 +1,158 @@
+#if !defined(FITOPTIONS)
+#define FITOPTIONS
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The options of the command line of fit that the modes of a fit (single
+ * fits, random restarts, scans, studies, the server) use.  main fills
+ * them once, before the first fit, and every mode reads them from its
+ * FitSession; the options that only main uses are kept there.
+ */
+
+struct FitOptions
+{
+
+  FitOptions() :
+    useMinos( false ), maxIter( 10000 ), numWorkers( 1 ),
+    usePreFit( false ), useProjection( false ), screenStarts( 1 ), gradientProcesses( 0 ),
+    useHypercube( false ), pruneCalls( 0 ), pruneMargin( 10 ), keepRestarts( false ),
+    distinctTolerance( 0 ), useHessian( false ),
+    writeIntensityColumns( false ), writeIntensityTable( false ), writeCompactResults( false ),
+    fuseBkgnd( false ), dropZeroWaves( false ), memoryReport( false ), cacheUserVars( false ),
+    resumeFit( false ), followSeconds( 0 ) { }
+
+  // -n:  MINOS instead of MIGRAD
+  bool useMinos;
+
+  // -m:  the maximum number of function calls of a minimization
+  int maxIter;
+
+  // -w:  the worker processes of the restarts, studies, scans and errors
+  int numWorkers;
+
+  // -a:  the production parameters are brought close to their minimum with
+  // an analytic gradient before every MIGRAD fit (see ProductionPreFit)
+  bool usePreFit;
+
+  // --projection:  the pre-fit is followed by a minimization in the
+  // amplitude parameters with the production parameters projected out (see
+  // VariableProjection); it needs the pre-fit
+  bool useProjection;
+
+  // --screen-starts:  every random restart draws this many sets of
+  // production parameters and starts from the one of lowest likelihood; the
+  // pre-fit evaluates them all in one pass over its cached amplitudes
+  int screenStarts;
+
+  // --parallel-gradient:  the parameters are brought close to their minimum
+  // in all floating parameters before MIGRAD by a minimization with a
+  // finite-difference gradient computed in this many processes (see
+  // ParallelGradient); after the pre-fit if it is used
+  int gradientProcesses;
+
+  // --coarse:  every random restart is first fit to subsamples of the data
+  // and accepted MC of these ascending fractions (see SubsampleSampler),
+  // each stage starting from the minimum of the one before, and then
+  // polished on all events
+  vector< double > coarseFractions;
+
+  // --lhs:  the starts of the random restarts form a Latin hypercube in the
+  // production and parRange parameters (see LatinHypercubeStarts) instead
+  // of independent random points
+  bool useHypercube;
+
+  // --prune-calls:  a random restart is checked every this many function
+  // calls of MIGRAD against the best restart so far (of the worker, with
+  // -w) and stopped if its likelihood is above the best by more than
+  // pruneMargin (--prune-margin), or if it stays above the best even after
+  // ten times the decrease that MIGRAD still expects (the EDM)
+  int pruneCalls;
+  double pruneMargin;
+
+  // --keep-restarts:  every random restart i writes <fit>_<i>.fit and
+  // <seed>_<i>.txt; otherwise only the best restart is written
+  bool keepRestarts;
+
+  // --distinct:  the converged restarts are grouped into minima, a restart
+  // whose floating parameters differ from those of a better one by less
+  // than this times their norm is the same minimum, and the restart table
+  // gives the best restart of the minimum of every restart
+  double distinctTolerance;
+
+  // --profile-errors <all|p1,p2,...>:  the asymmetric errors of all
+  // floating Minuit parameters, or of the listed ones, are found after the
+  // fit by ProfileErrors in the workers of -w and written to
+  // <fitName>_profile_errors.txt; MINOS (-n) is not affected and writes its
+  // errors to the .fit file as before
+  string profilePars;
+
+  // --hessian:  the matrix of second derivatives is computed after MIGRAD
+  // by HessianEvaluator, its finite differences in the workers of -w (in
+  // this process on GPU builds), and the covariance matrix is written to
+  // <fitName>_hessian.txt
+  bool useHessian;
+
+  // --intensity-columns:  the intensities of every accepted and generated MC
+  // event are written next to each fit results file (see IntensityColumns)
+  bool writeIntensityColumns;
+
+  // --intensity-table:  the intensities and fractions of every amplitude,
+  // interference term, sum and reaction are written to <fit>.intensities
+  // (see IntensityTable)
+  bool writeIntensityTable;
+
+  // --binary-results:  a <fit>.fitb is written next to each .fit file, which
+  // the moment tools read in place of the text (see CompactFitResults)
+  bool writeCompactResults;
+
+  // --plot <generator>:  the histograms of the plot generator are filled
+  // from the samples of the fit and written to <fit>_plots.root (see
+  // FitProjections), so no plotter has to load the fit again
+  string plotGenerator;
+
+  // --fuse-bkgnd:  the data and background of every reaction are one sample
+  // with the background weights negated (see SignedDataReader), so the data
+  // term of the likelihood is one pass over one set of amplitudes; the fit
+  // files keep the samples of the config file
+  bool fuseBkgnd;
+
+  // --drop-zero-waves:  the amplitudes whose production coefficients are
+  // fixed to zero are removed from each configuration (see WavePruner)
+  bool dropZeroWaves;
+
+  // --profile:  the amplitudes are registered as ProfiledAmplitude and the
+  // report is written to this file at the end
+  string profileFile;
+
+  // --memory-report:  the memory that the events of every source and the
+  // user variables of every amplitude instance take is printed once the
+  // events are loaded (see MemoryReport)
+  bool memoryReport;
+
+  // --keep-uservars:  the static user variables of the events are kept
+  // between the AmpToolsInterfaces of the process (see UserVarsCache)
+  bool cacheUserVars;
+
+  // --telemetry:  every evaluation of the likelihood is recorded to this
+  // destination (see FitTelemetry)
+  string telemetryDest;
+
+  // --checkpoint:  the parameters, the function calls and the fits that are
+  // done are saved to this file now and then (see FitCheckpoint), with
+  // --resume a job continues from it.  Like the seed file it is relative to
+  // the directory of the fit.
+  string checkpointFile;
+  bool resumeFit;
+
+  // --follow:  the seconds between the checks of the data files
+  double followSeconds;
+
+  // --binned:  the grid of ROOTDataReaderGrid
+  string binnedGrid;
+};
+
+#endif
@@ -0,0 +1,196 @@
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_AMPS/UserVarsCache.h"
+
+#include "IUAmpTools/ConfigFileParser.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "FitSession.h"
+#include "FitServer.h"
+
+namespace {
+
+const char* kServedFit = "SERVED FIT ";
+
+// the socket address of path, false if the path is too long
+bool socketAddress(const string& path, sockaddr_un& address) {
+   memset( &address, 0, sizeof( address ) );
+   address.sun_family = AF_UNIX;
+   if( path.size() >= sizeof( address.sun_path ) ){
+      cout << "ERROR:  the socket path " << path << " is too long" << endl;
+      return false;
+   }
+   strncpy( address.sun_path, path.c_str(), sizeof( address.sun_path ) - 1 );
+   return true;
+}
+
+// the fit of one request, with the output to the client on fd
+void serveFit(FitSession& session, int fd, const map<string, string>& request, const char* startDir) {
+   map<string, string>::const_iterator dir = request.find( "dir" );
+   map<string, string>::const_iterator config = request.find( "config" );
+   map<string, string>::const_iterator seed = request.find( "seed" );
+
+   // everything the fit prints, also through ROOT and printf, goes to the client
+   cout.flush();
+   fflush( stdout );
+   int savedOut = dup( 1 );
+   dup2( fd, 1 );
+
+   bool converged = false;
+   double likelihood = 0;
+   string fitFile;
+   if( dir == request.end() || config == request.end() ){
+      cout << "ERROR:  the request has no directory or config file" << endl;
+   }
+   else if( chdir( dir->second.c_str() ) != 0 ){
+      cout << "ERROR:  the server cannot change to " << dir->second << endl;
+   }
+   else if( access( config->second.c_str(), R_OK ) != 0 ){
+      cout << "ERROR:  the server cannot read " << config->second << " in " << dir->second << endl;
+   }
+   else{
+      ConfigFileParser parser(config->second);
+      ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
+      session.pruneWaves(cfgInfo);
+      session.fuseBackground(cfgInfo);
+      cfgInfo->display();
+      session.registerAmplitudes(cfgInfo);
+      if (session.normIntCache() != NULL) session.normIntCache()->prepare(cfgInfo);
+
+      likelihood = session.runSingleFit(cfgInfo, seed != request.end() ? seed->second : "");
+      converged = ( likelihood != 1e6 );
+      fitFile = dir->second + "/" + cfgInfo->fitName() + ".fit";
+   }
+
+   cout << kServedFit << ( converged ? "converged" : "failed" ) << " " << setprecision(12) << likelihood
+        << " " << fitFile << endl;
+
+   cout.flush();
+   fflush( stdout );
+   dup2( savedOut, 1 );
+   close( savedOut );
+
+   if (startDir != NULL && chdir(startDir) != 0)
+      cout << "ERROR:  cannot change back to " << startDir << endl;
+}
+
+}
+
+void serveFits(FitSession& session, const string& socketPath, const char* startDir) {
+   sockaddr_un address;
+   if( !socketAddress( socketPath, address ) ) exit(1);
+
+   // only the socket of a server that is gone is replaced
+   struct stat info;
+   if( lstat( socketPath.c_str(), &info ) == 0 ){
+      int probe = socket( AF_UNIX, SOCK_STREAM, 0 );
+      bool live = ( probe >= 0 && connect( probe, (sockaddr*)&address, sizeof( address ) ) == 0 );
+      if( probe >= 0 ) close( probe );
+      if( !S_ISSOCK( info.st_mode ) || live ){
+         cout << "ERROR:  " << socketPath << ( live ? " is used by another fit server" : " exists and is not a socket" ) << endl;
+         exit(1);
+      }
+      unlink( socketPath.c_str() );
+   }
+
+   // the fits run with the permissions of the server, so only its user may submit them
+   int server = socket( AF_UNIX, SOCK_STREAM, 0 );
+   mode_t savedMask = umask( 0177 );
+   bool bound = ( server >= 0 && bind( server, (sockaddr*)&address, sizeof( address ) ) == 0 );
+   umask( savedMask );
+   if( !bound || chmod( socketPath.c_str(), 0600 ) != 0 || listen( server, 8 ) != 0 ){
+      cout << "ERROR:  cannot listen on " << socketPath << endl;
+      exit(1);
+   }
+
+   // a client that goes away during its fit does not stop the server
+   signal( SIGPIPE, SIG_IGN );
+
+   cout << "SERVING FITS ON " << socketPath << endl;
+   while( true ){
+      int fd = accept( server, NULL, NULL );
+      if( fd < 0 ) continue;
+
+      // the request is lines of key and value up to an empty line
+      string text;
+      char buffer[4096];
+      ssize_t n;
+      while( text.find( "\n\n" ) == string::npos && ( n = read( fd, buffer, sizeof( buffer ) ) ) > 0 )
+         text.append( buffer, n );
+
+      map<string, string> request;
+      istringstream lines( text );
+      string line;
+      while( getline( lines, line ) && line.size() != 0 ){
+         size_t space = line.find( ' ' );
+         if( space != string::npos ) request[line.substr( 0, space )] = line.substr( space + 1 );
+      }
+
+      cout << endl << "FITTING " << request["config"] << " IN " << request["dir"] << endl;
+      serveFit( session, fd, request, startDir );
+      close( fd );
+
+      if (session.options().cacheUserVars)
+         cout << "STATIC USER VARIABLES OF " << UserVarsCache::numHits() << " BLOCKS REUSED, "
+              << UserVarsCache::numStored() << " KEPT" << endl;
+      cout << "WAITING FOR THE NEXT FIT" << endl;
+   }
+}
+
+int submitFit(const string& socketPath, const string& configfile, const string& seedfile) {
+   sockaddr_un address;
+   if( !socketAddress( socketPath, address ) ) return 1;
+
+   int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+   if( fd < 0 || connect( fd, (sockaddr*)&address, sizeof( address ) ) != 0 ){
+      cout << "ERROR:  no fit server on " << socketPath << ", start one with fit --serve " << socketPath << endl;
+      return 1;
+   }
+
+   char* dir = getcwd(NULL, 0);
+   ostringstream request;
+   request << "dir " << ( dir != NULL ? dir : "." ) << "\n" << "config " << configfile << "\n";
+   if( seedfile.size() != 0 ) request << "seed " << seedfile << "\n";
+   request << "\n";
+   free(dir);
+
+   string text = request.str();
+   if( write( fd, text.data(), text.size() ) != (ssize_t)text.size() ){
+      cout << "ERROR:  cannot send the fit to " << socketPath << endl;
+      close( fd );
+      return 1;
+   }
+
+   // the output is printed as it comes, and the last line tells the result
+   string output;
+   char buffer[4096];
+   ssize_t n;
+   while( ( n = read( fd, buffer, sizeof( buffer ) ) ) > 0 ){
+      cout.write( buffer, n );
+      cout.flush();
+      output.append( buffer, n );
+   }
+   close( fd );
+
+   size_t result = output.rfind( kServedFit );
+   if( result == string::npos ){
+      cout << "ERROR:  the fit server stopped before the fit ended" << endl;
+      return 1;
+   }
+   return output.compare( result + strlen( kServedFit ), 9, "converged" ) == 0 ? 0 : 1;
+}
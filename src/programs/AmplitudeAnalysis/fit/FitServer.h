@@ -0,0 +1,36 @@
+#if !defined(FITSERVER)
+#define FITSERVER
+
+#include <string>
+
+using namespace std;
+
+class FitSession;
+
+/**
+ * With --serve <socket> the program stays resident and fits the config
+ * files that fit --submit <socket> -c <file> [-s <seed>] sends over a local
+ * socket, one after the other, in the directory of the client, with the
+ * other options the server was started with.  The sources of
+ * ROOTDataReader are read into columns once and kept until their files
+ * change (see ROOTDataReader::setKeepColumns), and the static user
+ * variables are kept by UserVarsCache, so a fit of an edited config file
+ * only decodes the sources it has not read before and computes the user
+ * variables of the amplitudes whose arguments changed.  The output of the
+ * fit goes to the client, which ends with the line
+ *
+ *   SERVED FIT <converged|failed> <likelihood> <fit file>
+ *
+ * The integrals of the MC and the buffers of the device belong to the
+ * AmpToolsInterface of each fit; with -N the integrals are kept as well.
+ */
+
+// serves the fits of --submit until the program is stopped; every fit
+// changes to the directory of its client and back to startDir
+void serveFits( FitSession& session, const string& socketPath, const char* startDir );
+
+// sends configfile to the server of --serve and prints its output;
+// returns 0 if the fit converged
+int submitFit( const string& socketPath, const string& configfile, const string& seedfile );
+
+#endif
@@ -0,0 +1,413 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+#include <utility>
+
+#include "TString.h"
+
+#include "AMPTOOLS_DATAIO/SignedDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_DATAIO/ChunkedNormInt.h"
+#include "AMPTOOLS_DATAIO/IntensityColumns.h"
+#include "AMPTOOLS_DATAIO/IntensityTable.h"
+#include "AMPTOOLS_DATAIO/CompactFitResults.h"
+#include "AMPTOOLS_DATAIO/FitProjections.h"
+#include "AMPTOOLS_DATAIO/FitTelemetry.h"
+#include "AMPTOOLS_DATAIO/FitCheckpoint.h"
+#include "AMPTOOLS_DATAIO/MemoryReport.h"
+#include "AMPTOOLS_DATAIO/WavePruner.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "ProductionPreFit.h"
+#include "VariableProjection.h"
+#include "SubsampleSampler.h"
+#include "LatinHypercubeStarts.h"
+#include "ParallelGradient.h"
+#include "LikelihoodMemo.h"
+#include "FitWorkers.h"
+#include "FitSession.h"
+
+// an AmpToolsInterface for every fraction of --coarse, which read the
+// subsamples from memory
+struct CoarseStages {
+  CoarseStages( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo, const vector< double >& fractions, int maxIter );
+  ~CoarseStages();
+  SubsampleSampler sampler;
+  vector< double > fractions;
+  vector< AmpToolsInterface* > atis;
+};
+
+CoarseStages::CoarseStages( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo,
+                            const vector< double >& fractions, int maxIter ) :
+  sampler( ati, cfgInfo, fractions.back() ),
+  fractions( fractions )
+{
+  AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+  for( unsigned int k = 0; k < fractions.size(); ++k ){
+
+    sampler.setFraction( fractions[k] );
+    sampler.useSubsample( cfgInfo );
+    atis.push_back( new AmpToolsInterface( cfgInfo ) );
+    atis.back()->minuitMinimizationManager()->setMaxIterations( maxIter );
+  }
+  sampler.useFullSample( cfgInfo );
+  AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+}
+
+CoarseStages::~CoarseStages(){
+
+  for( unsigned int k = 0; k < atis.size(); ++k ) delete atis[k];
+}
+
+// sets the floating parameters of to those of the same name of from
+static void
+copyParameters( AmpToolsInterface& from, AmpToolsInterface& to ){
+
+  map< string, double > values;
+  MinuitParameterManager& fromPars = from.minuitMinimizationManager()->parameterManager();
+  for( unsigned int k = 0; k < fromPars.size(); ++k ) values[fromPars[k]->name()] = fromPars[k]->value();
+
+  MinuitParameterManager& pars = to.minuitMinimizationManager()->parameterManager();
+  for( unsigned int k = 0; k < pars.size(); ++k ){
+
+    map< string, double >::const_iterator value = values.find( pars[k]->name() );
+    if( pars[k]->floating() && value != values.end() ) pars[k]->setValue( value->second );
+  }
+}
+
+ScanStart
+fitStart( const FitResults& results, ConfigurationInfo* cfgInfo, const vector< ParameterInfo* >& freePars ){
+
+  ScanStart start;
+  vector< AmplitudeInfo* > ampInfoVec = cfgInfo->amplitudeList();
+  for( unsigned int iamp = 0; iamp < ampInfoVec.size(); ++iamp ){
+
+    if( ampInfoVec[iamp]->fixed() ) continue;
+    string ampName = ampInfoVec[iamp]->fullName();
+    start.prodPars[ampName] = results.productionParameter( ampName );
+  }
+  for( unsigned int ipar = 0; ipar < freePars.size(); ++ipar )
+    start.ampPars[freePars[ipar]->parName()] = results.parValue( freePars[ipar]->parName() );
+  return start;
+}
+
+vector< ParameterInfo* >
+freeParameters( ConfigurationInfo* cfgInfo ){
+
+  vector< ParameterInfo* > freePars;
+  vector< ParameterInfo* > parInfoVec = cfgInfo->parameterList();
+  for( unsigned int ipar = 0; ipar < parInfoVec.size(); ++ipar )
+    if( !parInfoVec[ipar]->fixed() ) freePars.push_back( parInfoVec[ipar] );
+  return freePars;
+}
+
+void
+startFrom( ParameterManager* parMgr, const ScanStart& start ){
+
+  for( auto par = start.prodPars.begin(); par != start.prodPars.end(); ++par )
+    parMgr->setProductionParameter( par->first, par->second );
+  for( auto par = start.ampPars.begin(); par != start.ampPars.end(); ++par )
+    parMgr->setAmpParameter( par->first, par->second );
+}
+
+const char* const FitSession::fitCompanions[3] = { ".intensities", ".fitb", "_plots.root" };
+
+FitSession::FitSession( const FitOptions& options ) :
+  m_options( options ),
+  m_normIntCache( NULL ),
+  m_deferredNormInt( NULL ),
+  m_telemetry( NULL ),
+  m_checkpoint( NULL ),
+  m_coarseStages( NULL ),
+  m_hypercube( NULL )
+{}
+
+FitSession::~FitSession(){
+
+  delete m_deferredNormInt;
+  delete m_normIntCache;
+}
+
+void
+FitSession::setNormIntCache( NormIntCache* cache ){
+
+  if( cache == m_normIntCache ) return;
+  delete m_normIntCache;
+  m_normIntCache = cache;
+}
+
+void
+FitSession::setDeferredNormInt( ChunkedNormInt* deferred ){
+
+  if( deferred == m_deferredNormInt ) return;
+  delete m_deferredNormInt;
+  m_deferredNormInt = deferred;
+}
+
+void
+FitSession::registerDataReader( const DataReader& reader ){
+
+  AmpToolsInterface::registerDataReader( reader );
+  ChunkedNormInt::registerDataReader( reader );
+  SignedDataReader::registerDataReader( reader );
+}
+
+void
+FitSession::registerAmplitudes( ConfigurationInfo* cfgInfo ) const {
+
+  AmplitudeRegistry::Options options;
+  options.profile = ( m_options.profileFile.size() != 0 );
+  options.onRegister = MemoryReport::registerAmplitude;
+  options.cacheUserVars = m_options.cacheUserVars;
+  AmplitudeRegistry::registerUsed( cfgInfo, options );
+}
+
+void
+FitSession::pruneWaves( ConfigurationInfo* cfgInfo ) const {
+
+  if( !m_options.dropZeroWaves ) return;
+  WavePruner pruner( cfgInfo );
+  if( pruner.prune() == 0 ) return;
+  pruner.print();
+  if( m_options.profileFile.size() != 0 ) AmplitudeProfiler::addDropped( pruner.droppedAmplitudes() );
+}
+
+void
+FitSession::fuseBackground( ConfigurationInfo* cfgInfo ) const {
+
+  if( !m_options.fuseBkgnd ) return;
+  int nFused = SignedDataReader::fuse( cfgInfo );
+  if( nFused > 0 ) cout << "DATA AND BACKGROUND OF " << nFused << " REACTIONS FUSED" << endl;
+}
+
+void
+FitSession::reportMemory( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) const {
+
+  if( m_options.memoryReport ) MemoryReport( ati, cfgInfo ).print();
+}
+
+void
+FitSession::finalizeFit( AmpToolsInterface& ati, const string& tag ){
+
+  if( m_deferredNormInt != NULL ) m_deferredNormInt->finish( ati );
+  if( m_options.fuseBkgnd ) SignedDataReader::split( ati.configurationInfo() );
+  ati.finalizeFit( tag );
+  if( m_options.fuseBkgnd ) SignedDataReader::fuse( ati.configurationInfo() );
+
+  string fitBase = ati.configurationInfo()->fitName() + ( tag.size() != 0 ? "_" + tag : "" );
+  if( m_options.writeIntensityColumns )
+    IntensityColumns::write( ati, fitBase );
+  if( m_options.writeIntensityTable && ati.fitResults() != NULL )
+    IntensityTable( *ati.fitResults() ).write( fitBase + ".intensities" );
+  if( m_options.writeCompactResults && ati.fitResults() != NULL )
+    CompactFitResults::write( *ati.fitResults(), fitBase + ".fitb" );
+  if( m_options.plotGenerator.size() != 0 )
+    FitProjections::write( ati, m_options.plotGenerator, fitBase + "_plots.root" );
+}
+
+ProductionPreFit*
+FitSession::makePreFit( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) const {
+
+  if( !m_options.usePreFit && !m_options.useProjection && m_options.screenStarts <= 1 ) return NULL;
+  return new ProductionPreFit( ati, cfgInfo );
+}
+
+void
+FitSession::preMinimize( ProductionPreFit* preFit, bool changedAmpPars, const string& heldPar ) const {
+
+  if( preFit == NULL || !preFit->valid() || !( m_options.usePreFit || m_options.useProjection ) ) return;
+  if( changedAmpPars ) preFit->refresh();
+  preFit->minimize();
+  if( m_options.useProjection ) VariableProjection( *preFit, heldPar ).minimize();
+}
+
+void
+FitSession::gradientMinimize( AmpToolsInterface& ati ) const {
+
+  if( m_options.gradientProcesses == 0 ) return;
+  ParallelGradient( ati, m_options.gradientProcesses ).minimize();
+}
+
+void
+FitSession::setLabel( const string& label ){
+
+  if( m_telemetry != NULL ) m_telemetry->setLabel( label );
+}
+
+void
+FitSession::recordFit( bool fitFailed, double likelihood ){
+
+  if( m_telemetry == NULL ) return;
+  m_telemetry->record( Form( "\"type\": \"fit\", \"failed\": %s, \"likelihood\": %.12g",
+                             fitFailed ? "true" : "false", likelihood ) );
+}
+
+bool
+FitSession::restoreFit( int fit ){
+
+  if( m_checkpoint == NULL ) return false;
+  m_checkpoint->startFit( fit );
+  return m_checkpoint->restore( fit );
+}
+
+void
+FitSession::checkpointFit( int fit, bool fitFailed, double likelihood ){
+
+  if( m_checkpoint != NULL ) m_checkpoint->finishFit( fit, fitFailed, likelihood );
+}
+
+bool
+FitSession::runCoarseStages( AmpToolsInterface& ati ){
+
+  if( m_coarseStages == NULL ) return false;
+
+  AmpToolsInterface* start = &ati;
+  for( unsigned int k = 0; k < m_coarseStages->atis.size(); ++k ){
+
+    AmpToolsInterface* stage = m_coarseStages->atis[k];
+    copyParameters( *start, *stage );
+    MinuitMinimizationManager* fitManager = stage->minuitMinimizationManager();
+    fitManager->migradMinimization();
+    cout << "LIKELIHOOD ON " << 100 * m_coarseStages->fractions[k] << "% OF THE EVENTS:  " << stage->likelihood()
+         << ( fitManager->status() != 0 ? " (NOT CONVERGED)" : "" ) << endl;
+    start = stage;
+  }
+  copyParameters( *start, ati );
+  return true;
+}
+
+double
+FitSession::runSingleFit( ConfigurationInfo* cfgInfo, const string& seedfile, ScanStart* start, const string& tag ){
+
+  AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+  AmpToolsInterface ati( cfgInfo );
+  TelemetryScope telemetryScope( *this, ati );
+  CheckpointScope checkpointScope( *this, ati );
+  LikelihoodMemo memo( ati );
+  reportMemory( ati, cfgInfo );
+
+  if( start != NULL ) startFrom( ati.parameterManager(), *start );
+
+  // a fit of a list that an earlier job finished is not done again
+  if( m_checkpoint != NULL && m_checkpoint->finished( -1 ) ){
+
+    const pair< bool, double >& done = m_checkpoint->finishedFits().find( -1 )->second;
+    cout << "FIT IS DONE IN THE CHECKPOINT, LIKELIHOOD:  " << done.second << endl;
+    return done.first ? 1e6 : done.second;
+  }
+
+  AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+  cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << LikelihoodMemo::likelihood( ati ) << endl;
+  if( m_normIntCache != NULL ) m_normIntCache->store( ati );
+  AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+
+  if( !restoreFit( -1 ) ){
+
+    ProductionPreFit* preFit = makePreFit( ati, cfgInfo );
+    preMinimize( preFit, false );
+    delete preFit;
+    gradientMinimize( ati );
+  }
+
+  MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+  fitManager->setMaxIterations( m_options.maxIter );
+
+  if( m_options.useMinos ) fitManager->minosMinimization();
+  else fitManager->migradMinimization();
+
+  bool fitFailed = ( fitManager->status() != 0 && fitManager->eMatrixStatus() != 3 );
+
+  recordFit( fitFailed, LikelihoodMemo::likelihood( ati ) );
+
+  if( fitFailed ){
+
+    cout << "ERROR: fit failed use results with caution..." << endl;
+    checkpointFit( -1, true, LikelihoodMemo::likelihood( ati ) );
+    return 1e6;
+  }
+
+  cout << "LIKELIHOOD AFTER MINIMIZATION:  " << LikelihoodMemo::likelihood( ati ) << endl;
+
+  if( m_options.useHessian ) runHessianWorkers( *this, ati, cfgInfo );
+  if( m_options.profilePars.size() != 0 ) runProfileWorkers( *this, ati, cfgInfo );
+
+  finalizeFit( ati, tag );
+
+  if( seedfile.size() != 0 ) ati.fitResults()->writeSeed( seedfile );
+
+  if( start != NULL ) *start = fitStart( *ati.fitResults(), cfgInfo, freeParameters( cfgInfo ) );
+
+  checkpointFit( -1, false, LikelihoodMemo::likelihood( ati ) );
+
+  return LikelihoodMemo::likelihood( ati );
+}
+
+FitSession::TelemetryScope::TelemetryScope( FitSession& session, AmpToolsInterface& ati, const string& suffix ) :
+  m_session( session )
+{
+  const string& dest = session.m_options.telemetryDest;
+  if( dest.size() == 0 ) return;
+  session.m_telemetry = new FitTelemetry( ati, suffix.size() == 0 ? dest :
+                                          FitTelemetry::workerDestination( dest, suffix ) );
+}
+
+FitSession::TelemetryScope::~TelemetryScope(){
+
+  delete m_session.m_telemetry;
+  m_session.m_telemetry = NULL;
+}
+
+FitSession::CheckpointScope::CheckpointScope( FitSession& session, AmpToolsInterface& ati, const string& suffix ) :
+  m_session( session )
+{
+  const string& file = session.m_options.checkpointFile;
+  if( file.size() == 0 ) return;
+  session.m_checkpoint = new FitCheckpoint( ati, suffix.size() == 0 ? file : file + "." + suffix );
+  if( session.m_options.resumeFit ) session.m_checkpoint->resume();
+}
+
+FitSession::CheckpointScope::~CheckpointScope(){
+
+  delete m_session.m_checkpoint;
+  m_session.m_checkpoint = NULL;
+}
+
+FitSession::CoarseScope::CoarseScope( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) :
+  m_session( session )
+{
+  const FitOptions& options = session.m_options;
+  if( options.coarseFractions.size() == 0 ) return;
+  session.m_coarseStages = new CoarseStages( ati, cfgInfo, options.coarseFractions, options.maxIter );
+}
+
+FitSession::CoarseScope::~CoarseScope(){
+
+  delete m_session.m_coarseStages;
+  m_session.m_coarseStages = NULL;
+}
+
+FitSession::HypercubeScope::HypercubeScope( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo,
+                                            double maxFraction, int numRnd ) :
+  m_session( session )
+{
+  if( !session.m_options.useHypercube ) return;
+  session.m_hypercube = new LatinHypercubeStarts( ati, cfgInfo, cfgInfo->userKeywordArguments( "parRange" ),
+                                                  maxFraction, numRnd );
+}
+
+FitSession::HypercubeScope::~HypercubeScope(){
+
+  delete m_session.m_hypercube;
+  m_session.m_hypercube = NULL;
+}
@@ -0,0 +1,193 @@
+#if !defined(FITSESSION)
+#define FITSESSION
+
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+
+#include "FitOptions.h"
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+class ParameterInfo;
+class ParameterManager;
+class FitResults;
+class DataReader;
+class NormIntCache;
+class ChunkedNormInt;
+class FitTelemetry;
+class FitCheckpoint;
+class ProductionPreFit;
+class LatinHypercubeStarts;
+struct CoarseStages;
+
+// the free parameters after a converged fit, the starting point of the
+// scan steps next to it, of the next fit of --follow or of the unbinned fit
+// of --binned-check
+struct ScanStart {
+  map< string, complex< double > > prodPars;
+  map< string, double > ampPars;
+};
+
+ScanStart fitStart( const FitResults& results, ConfigurationInfo* cfgInfo, const vector< ParameterInfo* >& freePars );
+
+// the parameters of cfgInfo that are not fixed
+vector< ParameterInfo* > freeParameters( ConfigurationInfo* cfgInfo );
+
+void startFrom( ParameterManager* parMgr, const ScanStart& start );
+
+/**
+ * What the fits of one process share:  the options of the command line,
+ * the cache of the normalization integrals (-N) and the deferred integrals
+ * of the generated MC (--defer-genmc), and the telemetry, checkpoint,
+ * coarse stages and hypercube of the fit running, which the scopes below
+ * set for as long as they last.  Every mode of fit (single fits, random
+ * restarts, scans, studies, the server) takes the session instead of
+ * reading the options itself; a forked worker has a copy of it.
+ *
+ * The steps that every fit shares are here as well:  the preparation of
+ * a configuration, the minimizations before MIGRAD, the single fit and
+ * the files written after a fit.
+ */
+
+class FitSession
+{
+
+public:
+
+  FitSession( const FitOptions& options );
+  ~FitSession();
+
+  const FitOptions& options() const { return m_options; }
+
+  // the cache of -N, which the session owns
+  NormIntCache* normIntCache() const { return m_normIntCache; }
+  void setNormIntCache( NormIntCache* cache );
+
+  // the integrals of --defer-genmc of the configuration being fit, which
+  // the session owns; NULL if the integrals are not deferred
+  void setDeferredNormInt( ChunkedNormInt* deferred );
+
+  // the readers of the fits, of the integrals of --normint-chunk and of
+  // the samples of --fuse-bkgnd
+  static void registerDataReader( const DataReader& reader );
+
+  // the amplitudes that a config file uses are registered before its
+  // AmpToolsInterface is built, wrapped as the options ask
+  void registerAmplitudes( ConfigurationInfo* cfgInfo ) const;
+
+  // --drop-zero-waves and --fuse-bkgnd on a configuration that was read
+  void pruneWaves( ConfigurationInfo* cfgInfo ) const;
+  void fuseBackground( ConfigurationInfo* cfgInfo ) const;
+
+  // --memory-report
+  void reportMemory( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) const;
+
+  // writes the fit results with tag and the files that the options ask for
+  void finalizeFit( AmpToolsInterface& ati, const string& tag = "" );
+
+  // the optional files that finalizeFit writes next to <fit>.fit
+  static const char* const fitCompanions[3];
+
+  // the pre-fit of -a, --projection or --screen-starts, NULL without them
+  ProductionPreFit* makePreFit( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) const;
+
+  // the minimizations of -a and --projection before MIGRAD; heldPar is an
+  // amplitude parameter that the projection leaves alone
+  void preMinimize( ProductionPreFit* preFit, bool changedAmpPars, const string& heldPar = "" ) const;
+
+  // the minimization of --parallel-gradient before MIGRAD
+  void gradientMinimize( AmpToolsInterface& ati ) const;
+
+  // the telemetry of the fit running, NULL without --telemetry
+  FitTelemetry* telemetry() const { return m_telemetry; }
+  void setLabel( const string& label );
+
+  // the outcome of the fit with the current label
+  void recordFit( bool fitFailed, double likelihood );
+
+  // the checkpoint of the fit running, NULL without --checkpoint
+  FitCheckpoint* checkpoint() const { return m_checkpoint; }
+
+  // starts fit from the checkpoint if it was interrupted; returns true if so
+  bool restoreFit( int fit );
+  void checkpointFit( int fit, bool fitFailed, double likelihood );
+
+  // the hypercube of --lhs, NULL without it
+  LatinHypercubeStarts* hypercube() const { return m_hypercube; }
+
+  /**
+   * Runs MIGRAD from the parameters of ati on the subsamples of --coarse,
+   * smallest first, and leaves the minimum of the largest in ati; returns
+   * false without --coarse.
+   */
+  bool runCoarseStages( AmpToolsInterface& ati );
+
+  /**
+   * Fits cfgInfo once and writes the fit with tag and the seed file;
+   * returns the likelihood at the minimum, 1e6 if the fit failed.  If start
+   * is not NULL the fit starts from it and it is set to the minimum, so
+   * that a later fit can start there.
+   */
+  double runSingleFit( ConfigurationInfo* cfgInfo, const string& seedfile,
+                       ScanStart* start = NULL, const string& tag = "" );
+
+  // the telemetry of an AmpToolsInterface for as long as the scope lasts,
+  // which has to end before the AmpToolsInterface goes away
+  class TelemetryScope {
+  public:
+    TelemetryScope( FitSession& session, AmpToolsInterface& ati, const string& suffix = "" );
+    ~TelemetryScope();
+  private:
+    FitSession& m_session;
+  };
+
+  // the checkpoint of an AmpToolsInterface for as long as the scope lasts
+  class CheckpointScope {
+  public:
+    CheckpointScope( FitSession& session, AmpToolsInterface& ati, const string& suffix = "" );
+    ~CheckpointScope();
+  private:
+    FitSession& m_session;
+  };
+
+  // the stages of --coarse for as long as the scope lasts
+  class CoarseScope {
+  public:
+    CoarseScope( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+    ~CoarseScope();
+  private:
+    FitSession& m_session;
+  };
+
+  // the hypercube of --lhs for as long as the scope lasts
+  class HypercubeScope {
+  public:
+    HypercubeScope( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo,
+                    double maxFraction, int numRnd );
+    ~HypercubeScope();
+  private:
+    FitSession& m_session;
+  };
+
+private:
+
+  // the session owns the cache, the deferred integrals and the scopes
+  FitSession( const FitSession& );
+  FitSession& operator=( const FitSession& );
+
+  FitOptions m_options;
+
+  NormIntCache* m_normIntCache;
+  ChunkedNormInt* m_deferredNormInt;
+
+  FitTelemetry* m_telemetry;
+  FitCheckpoint* m_checkpoint;
+  CoarseStages* m_coarseStages;
+  LatinHypercubeStarts* m_hypercube;
+};
+
+#endif
@@ -0,0 +1,320 @@
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+
+#include <unistd.h>
+
+#include "TString.h"
+
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "ProductionPreFit.h"
+#include "ToySampler.h"
+#include "BootstrapSampler.h"
+#include "ImportanceSampler.h"
+#include "LikelihoodMemo.h"
+#include "FitSession.h"
+#include "FitWorkers.h"
+#include "FitStudies.h"
+
+namespace {
+
+struct ToyResult {
+   int toy;
+   int failed;
+   double likelihood;
+};
+
+// one row of the table of a toy study:  the label, whether the fit failed,
+// the likelihood and the value and error of every parameter
+string toyRow(const string& label, bool failed, double likelihood, const FitResults* results) {
+   ostringstream row;
+   row << label << " " << ( failed ? 1 : 0 ) << " " << setprecision(12) << likelihood;
+   vector< double > values = results->parValueList();
+   vector< vector< double > > errors = results->errorMatrix();
+   for(size_t k=0; k<values.size(); k++) {
+      double error = ( k < errors.size() && errors[k][k] > 0 ? sqrt( errors[k][k] ) : 0 );
+      row << " " << values[k] << " " << error;
+   }
+   return row.str();
+}
+
+// draws and fits sample i of a toy study (kind "toy") or a bootstrap
+// (kind "replica") and appends its row to table
+template< class Sampler >
+ToyResult runSampleFit(FitSession& session, ConfigurationInfo* cfgInfo, Sampler& sampler, const string& kind, int i, int numSamples, ofstream& table) {
+   string label( kind );
+   transform( label.begin(), label.end(), label.begin(), ::toupper );
+
+   cout << endl << "###############################" << endl;
+   cout << label << " " << i << " OF " << numSamples << endl;
+   cout << endl << "###############################" << endl;
+
+   // sample i only depends on i, not on the worker that fits it
+   sampler.draw( i + 1 );
+
+   AmpToolsInterface ati( cfgInfo );
+   LikelihoodMemo memo( ati );
+
+   ProductionPreFit* preFit = session.makePreFit( ati, cfgInfo );
+   session.preMinimize( preFit, false );
+   delete preFit;
+
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   fitManager->setMaxIterations(session.options().maxIter);
+
+   if(session.options().useMinos)
+      fitManager->minosMinimization();
+   else
+      fitManager->migradMinimization();
+
+   ToyResult result;
+   result.toy = i;
+   result.failed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
+   result.likelihood = LikelihoodMemo::likelihood( ati );
+   session.recordFit( result.failed, result.likelihood );
+
+   // the table replaces the fit files of the samples
+   string tag = kind + to_string(i);
+   session.finalizeFit( ati, tag );
+   unlink( ( cfgInfo->fitName() + "_" + tag + ".fit" ).c_str() );
+   for( const char* companion : FitSession::fitCompanions )
+      unlink( ( cfgInfo->fitName() + "_" + tag + companion ).c_str() );
+
+   table << toyRow( to_string(i), result.failed, result.likelihood, ati.fitResults() ) << endl;
+
+   return result;
+}
+
+// Fits the samples 0 ... numSamples-1 of sampler, in numWorkers forked
+// processes if there are more than one, and writes the table
+// <fitName>_<study>.txt with the header, firstRow and a row per sample.
+template< class Sampler >
+void fitSamples(FitSession& session, ConfigurationInfo* cfgInfo, Sampler& sampler, const string& kind, const string& study,
+                int numSamples, int numWorkers, const string& header, const string& firstRow) {
+   string fitName = cfgInfo->fitName();
+   string label( kind );
+   transform( label.begin(), label.end(), label.begin(), ::toupper );
+
+   int nDone = 0, nFailed = 0;
+   auto workerTable = [&]( int w ){ return fitName + "_" + study + Form(".txt.worker%d", w); };
+
+   auto fitWorker = [&]( int w, int fd ){
+      ofstream table( workerTable( w ).c_str() );
+      for(int i=w; i<numSamples; i+=numWorkers) {
+         ToyResult result = runSampleFit( session, cfgInfo, sampler, kind, i, numSamples, table );
+         if( fd >= 0 ) reportResult( fd, result );
+         else{
+            ++nDone;
+            if( result.failed ) ++nFailed;
+         }
+      }
+   };
+
+   if( numWorkers > 1 ){
+      runWorkers< ToyResult >( session, numWorkers, fitWorker,
+         [&]( const ToyResult& result ){
+            ++nDone;
+            if( result.failed ) ++nFailed;
+            cout << "FINISHED " << label << " " << result.toy << " (" << nDone << " OF " << numSamples << "):  "
+                 << ( result.failed ? "FAILED" : Form("LIKELIHOOD = %f", result.likelihood) ) << endl;
+         } );
+   }
+   else{
+      fitWorker( 0, -1 );
+   }
+
+   if( nDone < numSamples )
+      cout << "ERROR:  only " << nDone << " of " << numSamples << " fits reported a result" << endl;
+
+   // the rows of the workers in the order of the samples
+   map< int, string > rows;
+   for(int w=0; w<numWorkers; w++) {
+      ifstream in( workerTable( w ).c_str() );
+      string line;
+      while( getline( in, line ) ) rows[atoi( line.c_str() )] = line;
+      in.close();
+      unlink( workerTable( w ).c_str() );
+   }
+
+   string tableName = fitName + "_" + study + ".txt";
+   ofstream table( tableName.c_str() );
+   table << header << endl << firstRow << endl;
+   for( map< int, string >::iterator row = rows.begin(); row != rows.end(); ++row )
+      table << row->second << endl;
+
+   cout << endl << label << "S:  " << nDone << " FITS (" << nFailed << " FAILED) WRITTEN TO " << tableName << endl;
+}
+
+// the header of the table of a toy study or a bootstrap
+string sampleHeader(const string& kind, const FitResults* results) {
+   ostringstream header;
+   header << "# " << kind << " failed likelihood";
+   vector< string > parNames = results->parNameList();
+   for(size_t k=0; k<parNames.size(); k++) header << " " << parNames[k] << " " << parNames[k] << "_err";
+   return header.str();
+}
+
+// the cache of the normalization integrals of a study, the one of -N or
+// <fitName>_<study>_normint without -N, and the number of workers of -w
+// that the study can use
+int prepareStudy(FitSession& session, ConfigurationInfo* cfgInfo, const string& study, int numSamples) {
+   if( session.normIntCache() == NULL ){
+      session.setNormIntCache( new NormIntCache( cfgInfo->fitName() + "_" + study + "_normint" ) );
+      session.normIntCache()->prepare( cfgInfo );
+   }
+
+   int numWorkers = session.options().numWorkers;
+#ifdef GPU_ACCELERATION
+   // the workers would share the GPU context of the first fit
+   if( numWorkers > 1 ){
+      cout << "the " << study << " fits run one after the other with GPU acceleration" << endl;
+      numWorkers = 1;
+   }
+#endif
+   if( numWorkers > numSamples ) numWorkers = numSamples;
+   return numWorkers;
+}
+
+}
+
+void runToyStudy(FitSession& session, ConfigurationInfo* cfgInfo, int numToys) {
+   int numWorkers = prepareStudy( session, cfgInfo, "toys", numToys );
+   NormIntCache* normIntCache = session.normIntCache();
+
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   AmpToolsInterface* truth = new AmpToolsInterface( cfgInfo );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+   cout << "LIKELIHOOD AT THE TRUTH:  " << truth->likelihood() << endl;
+   normIntCache->store( *truth );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+
+   ToySampler sampler( *truth, cfgInfo );
+
+   session.finalizeFit( *truth, "truth" );
+   string header = sampleHeader( "toy", truth->fitResults() );
+   string truthRow = toyRow( "truth", false, truth->likelihood(), truth->fitResults() );
+
+   // the toys only need the integrals and the pseudo-data from here on
+   delete truth;
+   normIntCache->prepare( cfgInfo );
+   sampler.useToys( cfgInfo );
+
+   fitSamples( session, cfgInfo, sampler, "toy", "toys", numToys, numWorkers, header, truthRow );
+}
+
+void runBootstrapStudy(FitSession& session, ConfigurationInfo* cfgInfo, int numReplicas) {
+   int numWorkers = prepareStudy( session, cfgInfo, "bootstrap", numReplicas );
+   NormIntCache* normIntCache = session.normIntCache();
+
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   AmpToolsInterface* nominal = new AmpToolsInterface( cfgInfo );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+   cout << "LIKELIHOOD OF THE DATA:  " << nominal->likelihood() << endl;
+   normIntCache->store( *nominal );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+
+   BootstrapSampler sampler( *nominal, cfgInfo );
+
+   session.finalizeFit( *nominal, "nominal" );
+   string header = sampleHeader( "replica", nominal->fitResults() );
+   string nominalRow = toyRow( "data", false, nominal->likelihood(), nominal->fitResults() );
+
+   delete nominal;
+   normIntCache->prepare( cfgInfo );
+   sampler.useReplicas( cfgInfo );
+
+   fitSamples( session, cfgInfo, sampler, "replica", "bootstrap", numReplicas, numWorkers, header, nominalRow );
+}
+
+ImportanceSampler* prepareImportance(FitSession& session, ConfigurationInfo* cfgInfo, double fraction) {
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   AmpToolsInterface ati( cfgInfo );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+   cout << "LIKELIHOOD BEFORE THE PRELIMINARY FIT:  " << ati.likelihood() << endl;
+   if( session.normIntCache() != NULL ) session.normIntCache()->store( ati );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+
+   ProductionPreFit* preFit = session.makePreFit( ati, cfgInfo );
+   session.preMinimize( preFit, false );
+   delete preFit;
+
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   fitManager->setMaxIterations(session.options().maxIter);
+   fitManager->migradMinimization();
+   cout << "LIKELIHOOD AFTER THE PRELIMINARY FIT:  " << ati.likelihood() << endl;
+
+   ImportanceSampler* sampler = new ImportanceSampler( ati, cfgInfo, fraction );
+   if( sampler->numReactions() == 0 ){
+      cout << "no reaction has integrals that depend on free parameters, --importance is not used" << endl;
+      delete sampler;
+      return NULL;
+   }
+
+   sampler->useSubsample( cfgInfo );
+   return sampler;
+}
+
+void refitFullSample(FitSession& session, ConfigurationInfo* cfgInfo, const ImportanceSampler* sampler, const string& seedfile) {
+   string fitFile = cfgInfo->fitName() + ".fit";
+   if( access( fitFile.c_str(), R_OK ) != 0 ){
+      cout << "no fit in " << fitFile << " to continue on all accepted MC" << endl;
+      return;
+   }
+
+   FitResults results( fitFile );
+   map< string, double > values;
+   vector< string > parNames = results.parNameList();
+   vector< double > parValues = results.parValueList();
+   for(size_t k=0; k<parNames.size(); k++) values[parNames[k]] = parValues[k];
+
+   sampler->useFullSample( cfgInfo );
+
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   AmpToolsInterface ati( cfgInfo );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+   LikelihoodMemo memo( ati );
+
+   MinuitParameterManager& pars = ati.minuitMinimizationManager()->parameterManager();
+   for(size_t k=0; k<pars.size(); k++) {
+      map< string, double >::const_iterator value = values.find( pars[k]->name() );
+      if( pars[k]->floating() && value != values.end() ) pars[k]->setValue( value->second );
+   }
+
+   double subsampleLL = LikelihoodMemo::likelihood( ati );
+   cout << "LIKELIHOOD ON ALL ACCEPTED MC AT THE MINIMUM OF THE SUBSAMPLE:  " << subsampleLL << endl;
+
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   fitManager->setMaxIterations(session.options().maxIter);
+   fitManager->migradMinimization();
+
+   bool fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
+   session.recordFit( fitFailed, LikelihoodMemo::likelihood( ati ) );
+   if( fitFailed )
+      cout << "ERROR: fit failed use results with caution..." << endl;
+
+   cout << "LIKELIHOOD ON ALL ACCEPTED MC AFTER MINIMIZATION:  " << LikelihoodMemo::likelihood( ati )
+        << " (" << LikelihoodMemo::likelihood( ati ) - subsampleLL << ")" << endl;
+
+   session.finalizeFit(ati);
+
+   if( seedfile.size() != 0 && !fitFailed )
+      ati.fitResults()->writeSeed( seedfile );
+}
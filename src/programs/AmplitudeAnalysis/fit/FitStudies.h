@@ -0,0 +1,54 @@
+#if !defined(FITSTUDIES)
+#define FITSTUDIES
+
+#include <string>
+
+using namespace std;
+
+class ConfigurationInfo;
+class ImportanceSampler;
+class FitSession;
+
+/**
+ * A toy study (--toys <n>) fits n sets of pseudo-data drawn from the
+ * intensity at the starting parameters of the configuration, e.g., of a
+ * fit whose seed file is included.  The data and the accepted MC are read
+ * and the normalization integrals computed once:  the pseudo-data are
+ * drawn from the accepted MC in memory (ToySampler) and the integrals of
+ * the reactions without free amplitude parameters are read from the cache
+ * of -N, or of <fitName>_toys_normint without -N.  Toy i is drawn with
+ * seed i + 1, so the toys do not depend on the number of workers of -w.
+ * The results are one table, <fitName>_toys.txt, with a row per toy and
+ * the truth as the first row (and in <fitName>_truth.fit).
+ */
+void runToyStudy( FitSession& session, ConfigurationInfo* cfgInfo, int numToys );
+
+/**
+ * A Poisson bootstrap (--bootstrap <n>) fits n replicas of the data, in
+ * which every event has a Poisson-distributed multiplicity of mean one
+ * (BootstrapSampler).  The data are read once and kept in memory and the
+ * normalization integrals do not change between replicas, so they are
+ * computed once as in a toy study.  Replica i has seed i + 1.  The results
+ * are one table, <fitName>_bootstrap.txt, with a row per replica and the
+ * starting parameters with the likelihood of all data as the first row.
+ */
+void runBootstrapStudy( FitSession& session, ConfigurationInfo* cfgInfo, int numReplicas );
+
+/**
+ * With --importance <fraction> a preliminary fit on all accepted MC is
+ * followed by the fits of the configuration (-r, -p, --bootstrap, a
+ * single fit) on a weighted subsample of it (ImportanceSampler), whose
+ * size is the fraction of the accepted MC.  Returns NULL if no reaction
+ * has integrals that depend on free parameters.
+ */
+ImportanceSampler* prepareImportance( FitSession& session, ConfigurationInfo* cfgInfo, double fraction );
+
+/**
+ * The guard of --importance:  the fit in <fitName>.fit, found on the
+ * subsample, is continued by MIGRAD on all accepted MC, which writes the
+ * fit file (and the seed file) again.
+ */
+void refitFullSample( FitSession& session, ConfigurationInfo* cfgInfo, const ImportanceSampler* sampler,
+                      const string& seedfile );
+
+#endif
@@ -0,0 +1,158 @@
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "TString.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "ProductionPreFit.h"
+#include "ProfileErrors.h"
+#include "HessianEvaluator.h"
+#include "FitWorkers.h"
+
+namespace {
+
+struct ProfileResult {
+  int par;
+  int found;
+  double lower;
+  double upper;
+};
+
+struct HessianResult {
+  int entry;
+  double value;
+};
+
+}
+
+void
+runProfileWorkers( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ){
+
+  MinuitParameterManager& minuitPars = ati.minuitMinimizationManager()->parameterManager();
+  const string& profilePars = session.options().profilePars;
+
+  vector< string > names;
+  if( profilePars == "all" ) names = ProfileErrors( ati ).parameters();
+  else{
+
+    stringstream list( profilePars );
+    string name;
+    while( getline( list, name, ',' ) ) if( name.size() != 0 ) names.push_back( name );
+  }
+
+  int numPars = names.size();
+  int numWorkers = min( session.options().numWorkers, numPars );
+  if( numWorkers < 1 ) numWorkers = 1;
+
+  cout << endl << "PROFILE ERRORS OF " << numPars << " PARAMETERS IN " << numWorkers << " WORKERS" << endl;
+
+  vector< ProfileResult > results( numPars );
+  for( int i = 0; i < numPars; ++i ){
+
+    results[i].par = i;
+    results[i].found = -1;
+    results[i].lower = results[i].upper = 0;
+  }
+
+  runWorkers< ProfileResult >( session, numWorkers,
+    [&]( int w, int fd ){
+
+      ProfileErrors profile( ati );
+
+      for( int i = w; i < numPars; i += numWorkers ){
+
+        session.setLabel( "profile " + names[i] );
+
+        ProfileResult result;
+        result.par = i;
+        result.found = profile.errors( names[i], result.lower, result.upper );
+        reportResult( fd, result );
+      }
+    },
+    [&]( const ProfileResult& result ){
+
+      results[result.par] = result;
+      cout << "PROFILE " << names[result.par] << ":  " << result.lower << " +" << result.upper
+           << ( result.found ? "" : "  (NOT FOUND)" ) << endl;
+    } );
+
+  string fileName = cfgInfo->fitName() + "_profile_errors.txt";
+  ofstream out( fileName.c_str() );
+  out << "# parameter  value  parabolic  lower  upper  found" << endl;
+  for( int i = 0; i < numPars; ++i ){
+
+    double value = 0, parabolic = 0;
+    for( unsigned int j = 0; j < minuitPars.size(); ++j ){
+
+      if( minuitPars[j]->name() != names[i] ) continue;
+      value = minuitPars[j]->value();
+      parabolic = minuitPars[j]->error();
+    }
+    out << names[i] << "  " << value << "  " << parabolic << "  " << results[i].lower << "  "
+        << results[i].upper << "  " << ( results[i].found < 0 ? "missing" : results[i].found ? "yes" : "no" ) << endl;
+  }
+
+  if( out ) cout << "PROFILE ERRORS WRITTEN TO " << fileName << endl;
+  else cout << "ERROR:  cannot write " << fileName << endl;
+}
+
+void
+runHessianWorkers( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ){
+
+  ProductionPreFit preFit( ati, cfgInfo );
+  HessianEvaluator hessian( ati, &preFit );
+
+  int numEntries = hessian.entries().size();
+  int numWorkers = min( session.options().numWorkers, numEntries );
+#ifdef GPU_ACCELERATION
+  numWorkers = 1;
+#endif
+
+  cout << endl << "SECOND DERIVATIVES OF " << hessian.parameters().size() << " PARAMETERS:  "
+       << hessian.numAnalytic() << " EXACT, " << numEntries << " BY FINITE DIFFERENCES IN "
+       << max( numWorkers, 1 ) << " WORKERS" << endl;
+
+  if( numWorkers <= 1 ){
+
+    for( int k = 0; k < numEntries; ++k ) hessian.set( k, hessian.evaluate( k ) );
+  }
+  else{
+
+    int nDone = 0;
+    runWorkers< HessianResult >( session, numWorkers,
+      [&]( int w, int fd ){
+
+        session.setLabel( Form( "hessian %d", w ) );
+
+        for( int k = w; k < numEntries; k += numWorkers ){
+
+          HessianResult result;
+          result.entry = k;
+          result.value = hessian.evaluate( k );
+          reportResult( fd, result );
+        }
+      },
+      [&]( const HessianResult& result ){
+
+        hessian.set( result.entry, result.value );
+        ++nDone;
+      } );
+
+    if( nDone < numEntries )
+      cout << "ERROR:  only " << nDone << " of " << numEntries << " second derivatives were reported" << endl;
+  }
+
+  string fileName = cfgInfo->fitName() + "_hessian.txt";
+  if( hessian.write( fileName ) ) cout << "COVARIANCE MATRIX WRITTEN TO " << fileName << endl;
+  else cout << "ERROR:  the covariance matrix in " << fileName << " is not usable" << endl;
+}
@@ -0,0 +1,118 @@
+#if !defined(FITWORKERS)
+#define FITWORKERS
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "TString.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+#include "FitSession.h"
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * Runs work(w, fd) for w = 0 ... numWorkers-1 in processes forked from
+ * this one.  Each worker writes its results of type Result to fd as they
+ * are done, and collect is called with every result in this process.
+ * Returns the number of results.
+ *
+ * Each worker has a copy of the session, so the scopes it opens are its
+ * own, and reports the amplitude calls of --profile it made itself.
+ */
+template< class Result, class Work, class Collect >
+int runWorkers( const FitSession& session, int numWorkers, Work work, Collect collect ){
+
+  int fds[2];
+  if( pipe( fds ) != 0 ){
+
+    cout << "ERROR:  cannot create a pipe for the fit workers" << endl;
+    exit( 1 );
+  }
+
+  // flush so buffered output is not written again by every worker
+  cout << flush;
+
+  vector< pid_t > workers;
+  for( int w = 0; w < numWorkers; ++w ){
+
+    pid_t pid = fork();
+    if( pid < 0 ){
+
+      cout << "ERROR:  cannot start fit worker " << w << endl;
+      break;
+    }
+
+    if( pid == 0 ){
+
+      close( fds[0] );
+      AmplitudeProfiler::reset();
+      work( w, fds[1] );
+      close( fds[1] );
+
+      const string& profileFile = session.options().profileFile;
+      if( profileFile.size() != 0 )
+        AmplitudeProfiler::writeJSON( profileFile + Form( ".worker%d", w ) );
+      _exit( 0 );
+    }
+
+    workers.push_back( pid );
+  }
+
+  close( fds[1] );
+
+  int nResults = 0;
+  Result result;
+  while( read( fds[0], &result, sizeof( result ) ) == sizeof( result ) ){
+
+    ++nResults;
+    collect( result );
+  }
+  close( fds[0] );
+
+  for( unsigned int w = 0; w < workers.size(); ++w ) waitpid( workers[w], NULL, 0 );
+
+  return nResults;
+}
+
+template< class Result >
+void reportResult( int fd, const Result& result ){
+
+  if( write( fd, &result, sizeof( result ) ) != sizeof( result ) )
+    cout << "ERROR:  cannot report a result to the parent process" << endl;
+}
+
+/**
+ * The profile errors of --profile-errors at the minimum in ati, written to
+ * <fitName>_profile_errors.txt.  The parameters are independent of each
+ * other, so they are shared among the workers of -w, each starting from
+ * the minimum:  worker w profiles the parameters w, w + numWorkers, ...
+ * The profiles run in the workers even with one, so the state of Minuit
+ * here stays that of the minimum for finalizeFit.  A GPU context does not
+ * survive a fork, so --profile-errors is turned off with GPU acceleration
+ * (see main).
+ */
+void runProfileWorkers( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+
+/**
+ * The covariance matrix of --hessian at the minimum in ati, written to
+ * <fitName>_hessian.txt.  The entries of the matrix of second derivatives
+ * are independent of each other, so those that need finite differences
+ * are shared among the workers of -w:  worker w computes the entries w,
+ * w + numWorkers, ...  The entries between production parameters are
+ * computed here from the cached amplitudes of the pre-fit.  A GPU context
+ * does not survive a fork, so with GPU acceleration all entries are
+ * computed here.
+ */
+void runHessianWorkers( FitSession& session, AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+
+#endif
@@ -0,0 +1,158 @@
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+
+#include "TMatrixDSym.h"
+#include "TDecompChol.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+
+#include "ProductionPreFit.h"
+#include "LikelihoodMemo.h"
+#include "HessianEvaluator.h"
+
+HessianEvaluator::HessianEvaluator( AmpToolsInterface& ati, const ProductionPreFit* preFit ) :
+  m_ati( ati ),
+  m_minimum( LikelihoodMemo::likelihood( ati ) ),
+  m_nAnalytic( 0 )
+{
+  MinuitParameterManager& pars = ati.minuitMinimizationManager()->parameterManager();
+  for( unsigned int i = 0; i < pars.size(); ++i ){
+
+    if( !pars[i]->floating() ) continue;
+
+    double value = pars[i]->value();
+    double step = 0.2 * pars[i]->error();
+    if( !( step > 0 ) ) step = 1e-3 * max( 1., fabs( value ) );
+
+    m_pars.push_back( pars[i] );
+    m_names.push_back( pars[i]->name() );
+    m_values.push_back( value );
+    m_steps.push_back( step );
+  }
+
+  int n = m_pars.size();
+  m_hessian.assign( n, vector< double >( n, 0. ) );
+  vector< bool > analytic( n, false );
+
+  if( preFit != NULL && preFit->valid() ){
+
+    map< string, int > index;
+    for( int i = 0; i < n; ++i ) index[m_names[i]] = i;
+
+    vector< string > prodNames = preFit->parameterNames();
+    vector< vector< double > > H = preFit->hessian();
+
+    vector< int > row( prodNames.size(), -1 );
+    for( unsigned int a = 0; a < prodNames.size(); ++a ){
+
+      map< string, int >::const_iterator it = index.find( prodNames[a] );
+      if( it == index.end() ) continue;
+      row[a] = it->second;
+      analytic[it->second] = true;
+    }
+
+    for( unsigned int a = 0; a < prodNames.size(); ++a )
+      for( unsigned int b = 0; b < prodNames.size(); ++b )
+        if( row[a] >= 0 && row[b] >= 0 ) m_hessian[row[a]][row[b]] = H[a][b];
+  }
+
+  for( int i = 0; i < n; ++i )
+    for( int j = i; j < n; ++j ){
+
+      if( analytic[i] && analytic[j] ) ++m_nAnalytic;
+      else m_entries.push_back( make_pair( i, j ) );
+    }
+}
+
+double
+HessianEvaluator::likelihoodAt( int i, double di, int j, double dj ){
+
+  m_pars[i]->setValue( m_values[i] + di );
+  if( j != i ) m_pars[j]->setValue( m_values[j] + dj );
+
+  double likelihood = m_ati.likelihood();
+
+  m_pars[i]->setValue( m_values[i] );
+  m_pars[j]->setValue( m_values[j] );
+
+  return likelihood;
+}
+
+double
+HessianEvaluator::evaluate( int k ){
+
+  int i = m_entries[k].first;
+  int j = m_entries[k].second;
+  double hi = m_steps[i];
+  double hj = m_steps[j];
+
+  if( i == j )
+    return ( likelihoodAt( i, hi, i, 0 ) - 2 * m_minimum + likelihoodAt( i, -hi, i, 0 ) ) / ( hi * hi );
+
+  return ( likelihoodAt( i, hi, j, hj ) - likelihoodAt( i, hi, j, -hj ) -
+           likelihoodAt( i, -hi, j, hj ) + likelihoodAt( i, -hi, j, -hj ) ) / ( 4 * hi * hj );
+}
+
+void
+HessianEvaluator::set( int k, double value ){
+
+  int i = m_entries[k].first;
+  int j = m_entries[k].second;
+  m_hessian[i][j] = m_hessian[j][i] = value;
+}
+
+bool
+HessianEvaluator::covariance( vector< vector< double > >& cov ) const {
+
+  int n = m_hessian.size();
+  cov.assign( n, vector< double >( n, 0. ) );
+  if( n == 0 ) return true;
+
+  // -2 ln L rises by one at one standard deviation, so the covariance
+  // matrix is the inverse of half the second derivatives
+  TMatrixDSym H( n );
+  for( int i = 0; i < n; ++i )
+    for( int j = 0; j < n; ++j ) H( i, j ) = 0.5 * m_hessian[i][j];
+
+  TDecompChol chol( H );
+  TMatrixDSym inverse( n );
+  if( !chol.Decompose() || !chol.Invert( inverse ) ) return false;
+
+  for( int i = 0; i < n; ++i )
+    for( int j = 0; j < n; ++j ) cov[i][j] = inverse( i, j );
+
+  return true;
+}
+
+bool
+HessianEvaluator::write( const string& fileName ) const {
+
+  vector< vector< double > > cov;
+  bool positive = covariance( cov );
+
+  ofstream out( fileName.c_str() );
+  out.precision( 10 );
+
+  if( !positive ) out << "# the matrix of second derivatives is not positive definite" << endl;
+  out << "# parameter  value  error  MIGRAD error" << endl;
+  for( unsigned int i = 0; i < m_names.size(); ++i )
+    out << m_names[i] << "  " << m_values[i] << "  " << ( positive ? sqrt( cov[i][i] ) : 0. )
+        << "  " << m_pars[i]->error() << endl;
+
+  out << "# covariance matrix" << endl;
+  for( unsigned int i = 0; i < cov.size(); ++i ){
+
+    for( unsigned int j = 0; j < cov[i].size(); ++j ) out << ( j ? "  " : "" ) << cov[i][j];
+    out << endl;
+  }
+
+  return positive && out;
+}
@@ -0,0 +1,82 @@
+#if !defined(HESSIANEVALUATOR)
+#define HESSIANEVALUATOR
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class MinuitParameter;
+class ProductionPreFit;
+
+/**
+ * The matrix of second derivatives of -2 ln L in the floating parameters
+ * at the minimum, and the covariance matrix 2 H^-1 from it.  The second
+ * derivatives between production parameters are exact, from the cached
+ * amplitudes of ProductionPreFit if it is valid; the others are central
+ * finite differences of AmpToolsInterface::likelihood with a step of a
+ * fifth of the parabolic error, two evaluations for a diagonal entry and
+ * four for the others.
+ *
+ * Each entry is independent of the others, so they can be evaluated in
+ * any order and by different processes:  entries() lists those that need
+ * the likelihood, evaluate computes one of them, set stores a value that
+ * was computed elsewhere.
+ */
+
+class HessianEvaluator
+{
+
+public:
+
+  /**
+   * At the current parameters, which have to be at the minimum; preFit
+   * may be NULL and has to be up to date with the amplitude parameters.
+   */
+  HessianEvaluator( AmpToolsInterface& ati, const ProductionPreFit* preFit );
+
+  // the names of the floating Minuit parameters, the rows of the matrix
+  const vector< string >& parameters() const { return m_names; }
+
+  // the entries ( i, j ), i <= j, that need finite differences
+  const vector< pair< int, int > >& entries() const { return m_entries; }
+
+  int numAnalytic() const { return m_nAnalytic; }
+
+  // the finite difference of entry k; moves the parameters and back
+  double evaluate( int k );
+
+  void set( int k, double value );
+
+  /**
+   * The covariance matrix of the parameters; returns false if the matrix
+   * of second derivatives is not positive definite.
+   */
+  bool covariance( vector< vector< double > >& cov ) const;
+
+  /**
+   * Writes the parameters with their values, the errors from the
+   * covariance matrix and the ones of MIGRAD, and the covariance matrix.
+   */
+  bool write( const string& fileName ) const;
+
+private:
+
+  double likelihoodAt( int i, double di, int j, double dj );
+
+  AmpToolsInterface& m_ati;
+
+  vector< MinuitParameter* > m_pars;
+  vector< string > m_names;
+  vector< double > m_values;
+  vector< double > m_steps;
+  double m_minimum;
+
+  vector< vector< double > > m_hessian;
+  vector< pair< int, int > > m_entries;
+  int m_nAnalytic;
+};
+
+#endif
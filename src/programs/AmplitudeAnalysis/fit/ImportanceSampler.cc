@@ -0,0 +1,146 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+#include "TRandom3.h"
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+
+#include "ImportanceSampler.h"
+
+// the share of the selection probability that is uniform in the events
+static const double kUniformShare = 0.2;
+
+ImportanceSampler::ImportanceSampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo, double fraction )
+{
+  TRandom3 random( 1 );
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    // integrals that do not change during the fit are not subsampled
+    if( reactions[i]->normIntFileInput() || reactions[i]->accMC().first.empty() ) continue;
+    if( !NormIntCache::key( cfgInfo, reactions[i] ).empty() ) continue;
+
+    Sample* sample = new Sample;
+    sample->reaction = reactions[i]->reactionName();
+    sample->accMC = reactions[i]->accMC();
+    sample->nPart = 0;
+    sample->next = 0;
+
+    ati.loadEvents( ati.accMCReader( sample->reaction ) );
+    ati.processEvents( sample->reaction );
+
+    int nEvents = ati.numEvents();
+    vector< double > weights( nEvents );
+    vector< double > size( nEvents );
+    double sumSize = 0;
+
+    for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      Kinematics* event = ati.kinematics( iEvent );
+      weights[iEvent] = event->weight();
+      delete event;
+
+      double intensity = ati.intensity( iEvent );
+      size[iEvent] = fabs( weights[iEvent] ) * ( intensity > 0 ? intensity : 0 );
+      sumSize += size[iEvent];
+    }
+
+    if( !( sumSize > 0 ) ){
+
+      cout << "ImportanceSampler ERROR:  the intensity of reaction " << sample->reaction
+           << " vanishes on the accepted MC" << endl;
+      assert( false );
+    }
+
+    // the variance of the estimate of sum w I from the subsample,
+    // sum ( w I )^2 ( 1 - p ) / p, relative to the sum
+    double target = fraction * nEvents;
+    double sumIntensity = 0, variance = 0;
+
+    for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      double p = target * ( ( 1 - kUniformShare ) * size[iEvent] / sumSize + kUniformShare / nEvents );
+      if( p > 1 ) p = 1;
+
+      sumIntensity += size[iEvent];
+      variance += size[iEvent] * size[iEvent] * ( 1 - p ) / p;
+
+      if( random.Uniform() >= p ) continue;
+
+      Kinematics* event = ati.kinematics( iEvent );
+      const vector< TLorentzVector >& particles = event->particleList();
+      if( sample->weight.empty() ) sample->nPart = particles.size();
+      assert( static_cast< int >( particles.size() ) == sample->nPart );
+
+      for( int j = 0; j < sample->nPart; ++j ){
+
+        sample->p4.push_back( particles[j].E() );
+        sample->p4.push_back( particles[j].Px() );
+        sample->p4.push_back( particles[j].Py() );
+        sample->p4.push_back( particles[j].Pz() );
+      }
+      sample->weight.push_back( weights[iEvent] / p );
+
+      delete event;
+    }
+
+    ati.clearEvents();
+
+    cout << "ImportanceSampler:  " << sample->weight.size() << " of " << nEvents
+         << " accepted MC events of reaction " << sample->reaction
+         << " kept, relative error of the integrated intensity "
+         << sqrt( variance ) / sumIntensity << endl;
+
+    // the readers of the fits read the subsample, and again from its
+    // start if the framework reads the accepted MC more than once
+    StreamDataReader::registerSource( "importance_" + sample->reaction,
+      [sample]( vector< TLorentzVector >& particles, float& weight ){
+
+        if( sample->next == sample->weight.size() ){
+
+          sample->next = 0;
+          return false;
+        }
+
+        const float* p = &sample->p4[sample->next * 4 * sample->nPart];
+
+        particles.resize( sample->nPart );
+        for( int j = 0; j < sample->nPart; ++j, p += 4 )
+          particles[j].SetPxPyPzE( p[1], p[2], p[3], p[0] );
+
+        weight = sample->weight[sample->next++];
+        return true;
+      } );
+
+    m_samples.push_back( sample );
+  }
+}
+
+void
+ImportanceSampler::useSubsample( ConfigurationInfo* cfgInfo ) const
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    ReactionInfo* reaction = cfgInfo->reaction( m_samples[i]->reaction );
+    reaction->setAccMC( "StreamDataReader",
+                        vector< string >( 1, "callback:importance_" + m_samples[i]->reaction ) );
+  }
+}
+
+void
+ImportanceSampler::useFullSample( ConfigurationInfo* cfgInfo ) const
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    ReactionInfo* reaction = cfgInfo->reaction( m_samples[i]->reaction );
+    reaction->setAccMC( m_samples[i]->accMC.first, m_samples[i]->accMC.second );
+  }
+}
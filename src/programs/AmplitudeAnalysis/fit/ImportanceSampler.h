@@ -0,0 +1,71 @@
+#if !defined(IMPORTANCESAMPLER)
+#define IMPORTANCESAMPLER
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * A weighted subsample of the accepted MC for the normalization integrals.
+ * Phase-space MC mostly lands where the intensity is small, while the
+ * precision of the integrals is set where it is large.  At the current
+ * parameters of the AmpToolsInterface, e.g., after a preliminary fit,
+ * every accepted MC event is kept with a probability p proportional to
+ * |weight| times its intensity, mixed with a uniform part so that every
+ * region keeps events when the parameters move, and a kept event has its
+ * weight divided by p.  The sums over the subsample are unbiased estimates
+ * of the sums over all events, with the smallest variance for intensities
+ * close to the current one.
+ *
+ * Only reactions whose integrals depend on free amplitude parameters are
+ * subsampled:  the others are computed once, or read from a file, and do
+ * not cost anything during the minimization.  The subsample is kept in
+ * memory and read by the fits through StreamDataReader as
+ * "callback:importance_<reaction>".
+ */
+
+class ImportanceSampler
+{
+
+public:
+
+  /**
+   * fraction is the expected size of the subsample relative to the
+   * accepted MC.
+   */
+  ImportanceSampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo, double fraction );
+
+  // the number of reactions that are subsampled
+  int numReactions() const { return m_samples.size(); }
+
+  /**
+   * Makes the subsampled reactions of cfgInfo read the subsample, or
+   * again all accepted MC.
+   */
+  void useSubsample( ConfigurationInfo* cfgInfo ) const;
+  void useFullSample( ConfigurationInfo* cfgInfo ) const;
+
+private:
+
+  struct Sample {
+
+    string reaction;
+    pair< string, vector< string > > accMC;
+    int nPart;
+
+    // E, Px, Py, Pz of every particle of every kept event and its weight
+    vector< float > p4;
+    vector< float > weight;
+
+    unsigned int next;
+  };
+
+  vector< Sample* > m_samples;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#if !defined(LBFGS)
+#define LBFGS
+
+#include <vector>
+#include <deque>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Limited-memory BFGS with a backtracking line search, for the
+ * minimizations of fit that have a gradient (ProductionPreFit,
+ * ParallelGradient).  f( x, &g ) returns the function at x and fills its
+ * gradient g.  x is moved to the minimum found; returns the function
+ * there and sets nIter to the number of iterations, and fStart, if not
+ * NULL, to the function at the start.
+ */
+
+template< class Function >
+double minimizeLBFGS( Function& f, vector< double >& x, int maxIter, int& nIter,
+                      double* fStart = NULL ){
+
+  const unsigned int kHistory = 8;
+  int n = x.size();
+
+  deque< vector< double > > sHist, yHist;
+  deque< double > rhoHist;
+
+  vector< double > g;
+  double fx = f( x, &g );
+  if( fStart != NULL ) *fStart = fx;
+
+  vector< double > d( n ), xNew( n ), gNew;
+  int iter = 0;
+
+  for( ; iter < maxIter; ++iter ){
+
+    // d = - H g by the two-loop recursion
+    vector< double > q( g );
+    vector< double > alpha( sHist.size() );
+    for( int k = sHist.size() - 1; k >= 0; --k ){
+
+      double sq = 0;
+      for( int i = 0; i < n; ++i ) sq += sHist[k][i] * q[i];
+      alpha[k] = rhoHist[k] * sq;
+      for( int i = 0; i < n; ++i ) q[i] -= alpha[k] * yHist[k][i];
+    }
+
+    double gamma = 1;
+    if( !sHist.empty() ){
+
+      double sy = 0, yy = 0;
+      for( int i = 0; i < n; ++i ){
+        sy += sHist.back()[i] * yHist.back()[i];
+        yy += yHist.back()[i] * yHist.back()[i];
+      }
+      gamma = sy / yy;
+    }
+    else{
+
+      double gg = 0;
+      for( int i = 0; i < n; ++i ) gg += g[i] * g[i];
+      gamma = 1 / max( 1., sqrt( gg ) );
+    }
+
+    for( int i = 0; i < n; ++i ) q[i] *= gamma;
+    for( unsigned int k = 0; k < sHist.size(); ++k ){
+
+      double yq = 0;
+      for( int i = 0; i < n; ++i ) yq += yHist[k][i] * q[i];
+      double beta = rhoHist[k] * yq;
+      for( int i = 0; i < n; ++i ) q[i] += sHist[k][i] * ( alpha[k] - beta );
+    }
+
+    double slope = 0;
+    for( int i = 0; i < n; ++i ){
+      d[i] = -q[i];
+      slope += d[i] * g[i];
+    }
+
+    if( !( slope < 0 ) ){
+
+      // not a descent direction, start over from the gradient
+      sHist.clear(); yHist.clear(); rhoHist.clear();
+      slope = 0;
+      for( int i = 0; i < n; ++i ){
+        d[i] = -g[i] * gamma;
+        slope += d[i] * g[i];
+      }
+      if( !( slope < 0 ) ) break;
+    }
+
+    double step = 1;
+    double fNew = fx;
+    bool accepted = false;
+    for( int k = 0; k < 40; ++k, step *= 0.5 ){
+
+      for( int i = 0; i < n; ++i ) xNew[i] = x[i] + step * d[i];
+      fNew = f( xNew, &gNew );
+      if( fNew <= fx + 1e-4 * step * slope ){ accepted = true; break; }
+    }
+    if( !accepted ) break;
+
+    double sy = 0;
+    vector< double > s( n ), y( n );
+    for( int i = 0; i < n; ++i ){
+      s[i] = xNew[i] - x[i];
+      y[i] = gNew[i] - g[i];
+      sy += s[i] * y[i];
+    }
+    if( sy > 0 ){
+
+      sHist.push_back( s );
+      yHist.push_back( y );
+      rhoHist.push_back( 1 / sy );
+      if( sHist.size() > kHistory ){
+        sHist.pop_front(); yHist.pop_front(); rhoHist.pop_front();
+      }
+    }
+
+    bool converged = ( fx - fNew <= 1e-10 * ( 1 + fabs( fNew ) ) );
+
+    x = xNew;
+    g = gNew;
+    fx = fNew;
+
+    if( converged ) break;
+  }
+
+  nIter = iter;
+  return fx;
+}
+
+#endif
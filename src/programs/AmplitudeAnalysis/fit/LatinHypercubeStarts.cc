@@ -0,0 +1,119 @@
+#include <iostream>
+#include <complex>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <stdint.h>
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+#include "IUAmpTools/LikelihoodCalculator.h"
+#include "IUAmpTools/NormIntInterface.h"
+#include "IUAmpTools/IntensityManager.h"
+
+#include "LatinHypercubeStarts.h"
+
+namespace {
+
+  // the finalizer of splitmix64, as for BootstrapSampler
+  uint64_t mix( uint64_t z ){
+
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+  }
+
+  double uniform( unsigned int seed, int d, int i, int stream ){
+
+    uint64_t z = mix( ( ( (uint64_t)seed << 32 ) | (uint32_t)d ) * 0x9E3779B97F4A7C15ULL ^
+                      ( ( (uint64_t)stream << 32 ) | (uint32_t)i ) * 0xBF58476D1CE4E5B9ULL );
+    return ( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+  }
+}
+
+LatinHypercubeStarts::LatinHypercubeStarts( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo,
+                                            const vector< vector< string > >& parRanges,
+                                            double maxFraction, int numStarts, unsigned int seed ) :
+  m_ati( ati ),
+  m_numStarts( numStarts ),
+  m_seed( seed )
+{
+  // the ranges of the random restarts of AmpToolsInterface
+  vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList();
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+
+    if( amps[i]->fixed() ) continue;
+
+    string amp = amps[i]->fullName();
+    string reaction = amps[i]->reactionName();
+
+    double numSignalEvents = ati.likelihoodCalculator( reaction )->numSignalEvents();
+    double normInt = ati.normIntInterface( reaction )->ampInt( amp, amp ).real();
+    double scale = ati.intensityManager( reaction )->getScale( amp );
+
+    m_amps.push_back( amp );
+    m_real.push_back( amps[i]->real() );
+    m_magnitude.push_back( m_low.size() );
+
+    m_low.push_back( 0 );
+    m_high.push_back( sqrt( numSignalEvents * maxFraction / ( normInt * scale * scale ) ) );
+    if( amps[i]->real() ) continue;
+
+    m_low.push_back( 0 );
+    m_high.push_back( 2 * M_PI );
+  }
+
+  for( unsigned int i = 0; i < parRanges.size(); ++i ){
+
+    m_pars.push_back( parRanges[i][0] );
+    m_par.push_back( m_low.size() );
+    m_low.push_back( atof( parRanges[i][1].c_str() ) );
+    m_high.push_back( atof( parRanges[i][2].c_str() ) );
+  }
+
+  // an independent random order of the strata for every coordinate
+  m_strata.resize( m_low.size() );
+  for( unsigned int d = 0; d < m_strata.size(); ++d ){
+
+    vector< int >& strata = m_strata[d];
+    strata.resize( numStarts );
+    for( int i = 0; i < numStarts; ++i ) strata[i] = i;
+
+    for( int i = numStarts - 1; i > 0; --i ){
+
+      int j = static_cast< int >( uniform( seed, d, i, 1 ) * ( i + 1 ) );
+      swap( strata[i], strata[j] );
+    }
+  }
+
+  cout << "LatinHypercubeStarts:  " << numStarts << " starts in " << m_low.size()
+       << " coordinates" << endl;
+}
+
+double
+LatinHypercubeStarts::coordinate( int d, int i ) const
+{
+  return ( m_strata[d][i % m_numStarts] + uniform( m_seed, d, i, 0 ) ) / m_numStarts;
+}
+
+void
+LatinHypercubeStarts::setStart( int i ) const
+{
+  ParameterManager* parMgr = m_ati.parameterManager();
+
+  for( unsigned int a = 0; a < m_amps.size(); ++a ){
+
+    int d = m_magnitude[a];
+    double magnitude = m_low[d] + coordinate( d, i ) * ( m_high[d] - m_low[d] );
+    double phase = m_real[a] ? 0 : m_low[d + 1] + coordinate( d + 1, i ) * ( m_high[d + 1] - m_low[d + 1] );
+
+    parMgr->setProductionParameter( m_amps[a], polar( magnitude, phase ) );
+  }
+
+  for( unsigned int p = 0; p < m_pars.size(); ++p ){
+
+    int d = m_par[p];
+    parMgr->setAmpParameter( m_pars[p], m_low[d] + coordinate( d, i ) * ( m_high[d] - m_low[d] ) );
+  }
+}
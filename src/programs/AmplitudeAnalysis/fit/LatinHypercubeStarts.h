@@ -0,0 +1,71 @@
+#if !defined(LATINHYPERCUBESTARTS)
+#define LATINHYPERCUBESTARTS
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * Starting points of the random restarts that fill the space of the
+ * production parameters and the parRange parameters evenly.  The restarts
+ * of AmpToolsInterface::randomizeProductionPars draw every coordinate
+ * independently, so with few restarts some regions get several starts and
+ * others none.  Here the n starts form a Latin hypercube:  the range of
+ * every coordinate is cut into n strata of equal width and every stratum
+ * holds exactly one start, at a random place inside it, with independent
+ * random orders of the strata of the coordinates.
+ *
+ * The coordinates and their ranges are those of the random restarts:  the
+ * magnitude of a free production parameter between 0 and
+ * sqrt( maxFraction * signal events / ( integral * scale^2 ) ), its phase
+ * between 0 and 2 pi (none for a real amplitude) and every parRange
+ * parameter between its limits.  The design depends only on the number of
+ * starts and the seed, not on the random numbers drawn before, so
+ * workers and resumed jobs give restart i the same start.
+ */
+
+class LatinHypercubeStarts
+{
+
+public:
+
+  LatinHypercubeStarts( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo,
+                        const vector< vector< string > >& parRanges,
+                        double maxFraction, int numStarts, unsigned int seed = 0 );
+
+  // the number of coordinates
+  int dimension() const { return m_low.size(); }
+
+  // sets the parameters of the AmpToolsInterface to start i
+  void setStart( int i ) const;
+
+private:
+
+  // the coordinate d of start i in [0, 1)
+  double coordinate( int d, int i ) const;
+
+  AmpToolsInterface& m_ati;
+  int m_numStarts;
+  unsigned int m_seed;
+
+  // the free production parameters and the index of the coordinate of the
+  // magnitude of each; the phase follows unless the amplitude is real
+  vector< string > m_amps;
+  vector< int > m_magnitude;
+  vector< bool > m_real;
+
+  // the parRange parameters and the index of the coordinate of each
+  vector< string > m_pars;
+  vector< int > m_par;
+
+  vector< double > m_low, m_high;
+
+  // the stratum of every start for every coordinate
+  vector< vector< int > > m_strata;
+};
+
+#endif
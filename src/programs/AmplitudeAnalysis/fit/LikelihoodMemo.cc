@@ -0,0 +1,69 @@
+
+#include <vector>
+#include <list>
+#include <algorithm>
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+
+#include "LikelihoodMemo.h"
+
+vector< LikelihoodMemo* > LikelihoodMemo::m_memos;
+
+LikelihoodMemo::LikelihoodMemo( AmpToolsInterface& ati, unsigned int size ) :
+  m_ati( ati ),
+  m_size( max( size, 1u ) ),
+  m_hits( 0 ),
+  m_misses( 0 )
+{
+  m_memos.push_back( this );
+}
+
+LikelihoodMemo::~LikelihoodMemo(){
+
+  m_memos.erase( remove( m_memos.begin(), m_memos.end(), this ), m_memos.end() );
+}
+
+double
+LikelihoodMemo::likelihood( AmpToolsInterface& ati ){
+
+  // the most recent memo of ati
+  for( int k = m_memos.size() - 1; k >= 0; --k )
+    if( &m_memos[k]->m_ati == &ati ) return m_memos[k]->evaluate();
+
+  return ati.likelihood();
+}
+
+void
+LikelihoodMemo::clear(){
+
+  for( unsigned int k = 0; k < m_memos.size(); ++k ) m_memos[k]->m_points.clear();
+}
+
+double
+LikelihoodMemo::evaluate(){
+
+  MinuitParameterManager& pars = m_ati.minuitMinimizationManager()->parameterManager();
+  vector< double > point( pars.size() );
+  for( unsigned int i = 0; i < pars.size(); ++i ) point[i] = pars[i]->value();
+
+  for( list< pair< vector< double >, double > >::iterator it = m_points.begin();
+       it != m_points.end(); ++it ){
+
+    if( it->first != point ) continue;
+
+    ++m_hits;
+    m_points.splice( m_points.begin(), m_points, it );
+    return it->second;
+  }
+
+  ++m_misses;
+  double likelihood = m_ati.likelihood();
+
+  m_points.push_front( make_pair( point, likelihood ) );
+  if( m_points.size() > m_size ) m_points.pop_back();
+
+  return likelihood;
+}
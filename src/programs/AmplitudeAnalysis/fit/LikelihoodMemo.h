@@ -0,0 +1,67 @@
+#if !defined(LIKELIHOODMEMO)
+#define LIKELIHOODMEMO
+
+#include <list>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+class AmpToolsInterface;
+
+/**
+ * The likelihoods of an AmpToolsInterface at the last few points of its
+ * parameters.  After a minimization fit asks for the likelihood at the
+ * minimum several times (to print it, for the telemetry, the checkpoint,
+ * the Hessian and the profiles), and each of those is a pass over all
+ * events.  While a memo of the AmpToolsInterface lives,
+ * LikelihoodMemo::likelihood returns the value of a point that was
+ * evaluated before instead.
+ *
+ * A point is the values of all Minuit parameters, floating and fixed,
+ * and has to match exactly.  The memo cannot see the evaluations of MIGRAD
+ * itself, which go to AmpTools directly.  A memo has to be made after and
+ * destroyed before its AmpToolsInterface, and cleared if the data or the
+ * normalization integrals of it change.
+ */
+
+class LikelihoodMemo
+{
+
+public:
+
+  LikelihoodMemo( AmpToolsInterface& ati, unsigned int size = 8 );
+  ~LikelihoodMemo();
+
+  /**
+   * ati.likelihood() at the current parameters, from the memo of ati if
+   * there is one and it has evaluated them before.
+   */
+  static double likelihood( AmpToolsInterface& ati );
+
+  // forgets the points of all memos
+  static void clear();
+
+  int hits() const { return m_hits; }
+  int misses() const { return m_misses; }
+
+private:
+
+  // memos are tied to their AmpToolsInterface and never copied
+  LikelihoodMemo( const LikelihoodMemo& );
+  LikelihoodMemo& operator=( const LikelihoodMemo& );
+
+  double evaluate();
+
+  static vector< LikelihoodMemo* > m_memos;
+
+  AmpToolsInterface& m_ati;
+  unsigned int m_size;
+
+  // the points, the most recent first
+  list< pair< vector< double >, double > > m_points;
+
+  int m_hits, m_misses;
+};
+
+#endif
@@ -0,0 +1,248 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+
+#include "LBFGS.h"
+#include "ParallelGradient.h"
+
+namespace {
+
+  // the commands of the parent to the workers
+  enum { kStop = 0, kGradient = 1 };
+
+  bool readAll( int fd, void* data, size_t size ){
+
+    char* p = static_cast< char* >( data );
+    while( size > 0 ){
+
+      ssize_t n = read( fd, p, size );
+      if( n <= 0 ) return false;
+      p += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  bool writeAll( int fd, const void* data, size_t size ){
+
+    const char* p = static_cast< const char* >( data );
+    while( size > 0 ){
+
+      ssize_t n = write( fd, p, size );
+      if( n <= 0 ) return false;
+      p += n;
+      size -= n;
+    }
+    return true;
+  }
+}
+
+ParallelGradient::ParallelGradient( AmpToolsInterface& ati, int numProcesses ) :
+  m_ati( ati ),
+  m_numProcesses( max( numProcesses, 1 ) )
+{
+  MinuitParameterManager& pars = ati.minuitMinimizationManager()->parameterManager();
+  for( unsigned int i = 0; i < pars.size(); ++i ){
+
+    if( !pars[i]->floating() ) continue;
+
+    double value = pars[i]->value();
+    double step = 1e-5 * max( 1., fabs( value ) );
+    if( 1e-3 * pars[i]->error() > step ) step = 1e-3 * pars[i]->error();
+
+    m_pars.push_back( pars[i] );
+    m_names.push_back( pars[i]->name() );
+    m_steps.push_back( step );
+  }
+
+  // no more processes than components
+  if( m_numProcesses > (int)m_pars.size() ) m_numProcesses = max( (int)m_pars.size(), 1 );
+
+  // flush so buffered output is not written again by every worker
+  cout << flush;
+
+  for( int w = 1; w < m_numProcesses; ++w ){
+
+    int request[2], response[2];
+    if( pipe( request ) != 0 || pipe( response ) != 0 ){
+
+      cout << "ParallelGradient ERROR:  cannot create the pipes of worker " << w << endl;
+      m_numProcesses = w;
+      break;
+    }
+
+    pid_t pid = fork();
+    if( pid < 0 ){
+
+      cout << "ParallelGradient ERROR:  cannot start worker " << w << endl;
+      close( request[0] ); close( request[1] );
+      close( response[0] ); close( response[1] );
+      m_numProcesses = w;
+      break;
+    }
+
+    if( pid == 0 ){
+
+      close( request[1] );
+      close( response[0] );
+      // the pipes of the workers forked before belong to the parent
+      for( unsigned int k = 0; k < m_request.size(); ++k ){
+        close( m_request[k] );
+        close( m_response[k] );
+      }
+      serve( w, request[0], response[1] );
+      _exit( 0 );
+    }
+
+    close( request[0] );
+    close( response[1] );
+    m_workers.push_back( pid );
+    m_request.push_back( request[1] );
+    m_response.push_back( response[0] );
+  }
+
+  cout << "ParallelGradient:  " << m_pars.size() << " parameters in "
+       << m_numProcesses << " processes" << endl;
+}
+
+ParallelGradient::~ParallelGradient(){
+
+  int command = kStop;
+  for( unsigned int k = 0; k < m_workers.size(); ++k ){
+
+    writeAll( m_request[k], &command, sizeof( command ) );
+    close( m_request[k] );
+    close( m_response[k] );
+  }
+
+  for( unsigned int k = 0; k < m_workers.size(); ++k ) waitpid( m_workers[k], NULL, 0 );
+}
+
+vector< double >
+ParallelGradient::values() const {
+
+  vector< double > x( m_pars.size() );
+  for( unsigned int i = 0; i < m_pars.size(); ++i ) x[i] = m_pars[i]->value();
+  return x;
+}
+
+void
+ParallelGradient::setValues( const vector< double >& x ){
+
+  for( unsigned int i = 0; i < m_pars.size(); ++i ) m_pars[i]->setValue( x[i] );
+}
+
+void
+ParallelGradient::components( int w, const vector< double >& x, vector< double >& grad ){
+
+  grad.assign( m_pars.size(), 0. );
+
+  for( unsigned int i = w; i < m_pars.size(); i += m_numProcesses ){
+
+    double h = m_steps[i];
+
+    m_pars[i]->setValue( x[i] + h );
+    double up = m_ati.likelihood();
+    m_pars[i]->setValue( x[i] - h );
+    double down = m_ati.likelihood();
+    m_pars[i]->setValue( x[i] );
+
+    grad[i] = ( up - down ) / ( 2 * h );
+  }
+}
+
+void
+ParallelGradient::serve( int w, int request, int response ){
+
+  int n = m_pars.size();
+  vector< double > x( n ), grad;
+
+  int command;
+  while( readAll( request, &command, sizeof( command ) ) && command == kGradient ){
+
+    if( !readAll( request, &x[0], n * sizeof( double ) ) ) break;
+
+    setValues( x );
+    components( w, x, grad );
+
+    if( !writeAll( response, &grad[0], n * sizeof( double ) ) ) break;
+  }
+
+  close( request );
+  close( response );
+}
+
+double
+ParallelGradient::likelihood( const vector< double >& x, vector< double >* grad ){
+
+  int n = m_pars.size();
+
+  if( grad != NULL ){
+
+    int command = kGradient;
+    for( unsigned int k = 0; k < m_workers.size(); ++k ){
+
+      if( !writeAll( m_request[k], &command, sizeof( command ) ) ||
+          !writeAll( m_request[k], &x[0], n * sizeof( double ) ) ){
+
+        cout << "ParallelGradient ERROR:  lost worker " << k + 1 << endl;
+        assert( false );
+      }
+    }
+  }
+
+  setValues( x );
+  double f = m_ati.likelihood();
+
+  if( grad != NULL ){
+
+    components( 0, x, *grad );
+
+    vector< double > part( n );
+    for( unsigned int k = 0; k < m_workers.size(); ++k ){
+
+      if( !readAll( m_response[k], &part[0], n * sizeof( double ) ) ){
+
+        cout << "ParallelGradient ERROR:  lost worker " << k + 1 << endl;
+        assert( false );
+      }
+      for( int i = 0; i < n; ++i ) (*grad)[i] += part[i];
+    }
+  }
+
+  return f;
+}
+
+double
+ParallelGradient::minimize( int maxIter ){
+
+  if( m_pars.empty() ) return m_ati.likelihood();
+
+  struct Likelihood {
+    ParallelGradient& gradient;
+    double operator()( const vector< double >& x, vector< double >* grad ){
+      return gradient.likelihood( x, grad );
+    }
+  } likelihood = { *this };
+
+  vector< double > x = values();
+  int iter = 0;
+  double fStart = 0;
+  double f = minimizeLBFGS( likelihood, x, maxIter, iter, &fStart );
+  setValues( x );
+
+  cout << "ParallelGradient:  -2 ln L " << fStart << " -> " << f
+       << " in " << iter << " iterations" << endl;
+
+  return f;
+}
@@ -0,0 +1,79 @@
+#if !defined(PARALLELGRADIENT)
+#define PARALLELGRADIENT
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+class AmpToolsInterface;
+class MinuitParameter;
+
+/**
+ * The gradient of -2 ln L in all floating Minuit parameters by central
+ * finite differences, with its components spread over worker processes,
+ * and a limited-memory BFGS minimization with it (see LBFGS.h) that brings
+ * the parameters close to the minimum before MIGRAD.
+ *
+ * The gradient of a fit with many parameters costs two likelihoods per
+ * parameter, all independent, so they are computed in parallel:  the
+ * workers are forked once when the object is made and live until it is
+ * deleted, each with its own copy of the parameters and of the
+ * AmpToolsInterface, whose events and cached amplitudes are shared with
+ * this process until they are written.  Worker w computes the components
+ * w, w + n, w + 2n, ... of n processes, this process the components 0, n,
+ * 2n, ...  Processes and not threads, since the caches of the amplitudes
+ * are global and not locked.
+ *
+ * The step of parameter i is a thousandth of its error, and at least
+ * 1e-5 max( 1, |value| ).  The workers are forked from the process, so not
+ * with GPU acceleration.
+ */
+
+class ParallelGradient
+{
+
+public:
+
+  // at the current parameters, in numProcesses processes including this one
+  ParallelGradient( AmpToolsInterface& ati, int numProcesses );
+
+  // stops the workers
+  ~ParallelGradient();
+
+  // the names of the floating Minuit parameters, the coordinates of x
+  const vector< string >& parameters() const { return m_names; }
+
+  vector< double > values() const;
+  void setValues( const vector< double >& x );
+
+  // -2 ln L at x and, if grad is not NULL, its gradient; leaves the
+  // parameters at x
+  double likelihood( const vector< double >& x, vector< double >* grad );
+
+  // minimizes from the current parameters in at most maxIter iterations
+  // and leaves them at the minimum; returns -2 ln L there
+  double minimize( int maxIter = 200 );
+
+private:
+
+  // the components of the gradient of process w at x
+  void components( int w, const vector< double >& x, vector< double >& grad );
+
+  // the loop of worker w until it is told to stop
+  void serve( int w, int request, int response );
+
+  AmpToolsInterface& m_ati;
+  int m_numProcesses;
+
+  vector< MinuitParameter* > m_pars;
+  vector< string > m_names;
+  vector< double > m_steps;
+
+  // the workers 1 ... numProcesses-1 and their pipes
+  vector< pid_t > m_workers;
+  vector< int > m_request, m_response;
+};
+
+#endif
@@ -0,0 +1,259 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <iterator>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "TString.h"
+
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "ProductionPreFit.h"
+#include "LikelihoodMemo.h"
+#include "FitSession.h"
+#include "FitWorkers.h"
+#include "ParameterScan.h"
+
+namespace {
+
+struct ScanResult {
+   int step;
+   int failed;
+   double value;
+   double likelihood;
+};
+
+// the grid of a scan:  the step i is at minVal + i * stepSize
+struct ScanGrid {
+   string parScan;
+   vector<ParameterInfo*> freePars;
+   double minVal;
+   double stepSize;
+   int steps;
+};
+
+// Runs the scan steps first ... last-1 on ati.  The steps are run in
+// ascending order or, with outward, from the step closest to center
+// outward in both directions.  Every step starts from the parameters of
+// the nearest step that has converged, or from the current parameters if
+// there is none.  Results are written to fd if it is not negative.
+vector< ScanResult > runScanSteps(FitSession& session, AmpToolsInterface& ati, ProductionPreFit* preFit, ConfigurationInfo* cfgInfo,
+                                  const string& seedfile, const ScanGrid& grid,
+                                  int first, int last, int center, bool outward, int fd) {
+
+   ParameterManager* parMgr = ati.parameterManager();
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   LikelihoodMemo memo( ati );
+
+   vector<int> order;
+   if( outward ){
+      int c = max( first, min( last - 1, center ) );
+      order.push_back( c );
+      for(int d=1; c-d >= first || c+d < last; d++) {
+         if( c+d < last ) order.push_back( c+d );
+         if( c-d >= first ) order.push_back( c-d );
+      }
+   }
+   else{
+      for(int i=first; i<last; i++) order.push_back( i );
+   }
+
+   map< int, ScanStart > converged;
+   vector< ScanResult > results;
+
+   for(size_t k=0; k<order.size(); k++) {
+      int i = order[k];
+
+      cout << endl << "###############################" << endl;
+      cout << "FIT " << i << " OF " << grid.steps << endl;
+      cout << endl << "###############################" << endl;
+
+      // start from the nearest converged step
+      if( !converged.empty() ){
+         map< int, ScanStart >::iterator next = converged.lower_bound( i );
+         map< int, ScanStart >::iterator nearest = next;
+         if( next == converged.end() ||
+             ( next != converged.begin() && i - prev( next )->first < next->first - i ) )
+            nearest = prev( next );
+
+         startFrom( parMgr, nearest->second );
+      }
+
+      // set and fix parameter for scan
+      double value = grid.minVal + i*grid.stepSize;
+      parMgr->setAmpParameter( grid.parScan, value );
+      session.setLabel( Form("scan %d", i) );
+
+      session.preMinimize( preFit, true, grid.parScan );
+
+      if(session.options().useMinos)
+         fitManager->minosMinimization();
+      else
+         fitManager->migradMinimization();
+
+      bool fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
+      session.recordFit( fitFailed, LikelihoodMemo::likelihood( ati ) );
+
+      if( fitFailed )
+         cout << "ERROR: fit failed use results with caution..." << endl;
+
+      cout << "LIKELIHOOD AFTER MINIMIZATION:  " << LikelihoodMemo::likelihood( ati ) << endl;
+
+      session.finalizeFit(ati, to_string(i));
+
+      if( seedfile.size() != 0 && !fitFailed ){
+         string seedfile_scan = seedfile + Form("_scan_%d.txt", i);
+         ati.fitResults()->writeSeed( seedfile_scan );
+      }
+
+      if( !fitFailed )
+         converged[i] = fitStart( *ati.fitResults(), cfgInfo, grid.freePars );
+
+      ScanResult result;
+      result.step = i;
+      result.failed = fitFailed;
+      result.value = value;
+      result.likelihood = LikelihoodMemo::likelihood( ati );
+      results.push_back( result );
+
+      if( fd >= 0 ) reportResult( fd, result );
+   }
+
+   return results;
+}
+
+}
+
+void runParScan(FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile, const string& parScan, bool outward) {
+   const FitOptions& options = session.options();
+
+   ScanGrid grid;
+   grid.parScan = parScan;
+   grid.minVal = grid.stepSize = 0;
+   grid.steps = 0;
+   double maxVal = 0;
+
+   vector< vector<string> > parScanKeywords = cfgInfo->userKeywordArguments("parScan");
+
+   if(parScanKeywords.size()==0) {
+      cout << "No parScan keyword found in configuration file. Set up at least one parameter for scanning! Aborting." << endl;
+      return;
+   } else {
+      for(size_t ipar=0; ipar<parScanKeywords.size(); ipar++) {
+         if(parScanKeywords[ipar][0]==parScan) {
+            grid.minVal = atof(parScanKeywords[ipar][1].c_str());
+            maxVal = atof(parScanKeywords[ipar][2].c_str());
+            grid.stepSize = atof(parScanKeywords[ipar][3].c_str());
+            grid.steps = trunc((maxVal-grid.minVal)/grid.stepSize)+1;
+            break;
+         } else
+            cout << "Skipping configuration to scan " << parScanKeywords[ipar][0] << "since scanning of " << parScan << " was requested..." << endl;
+      }
+   }
+
+   // look up the scanned parameter once; the other free parameters are
+   // the ones that are carried from step to step
+   ParameterInfo* scanInfo = NULL;
+   vector<ParameterInfo*> parInfoVec = cfgInfo->parameterList();
+   for(size_t ipar=0; ipar<parInfoVec.size(); ipar++) {
+      if( parInfoVec[ipar]->parName() == parScan ) scanInfo = parInfoVec[ipar];
+      else if( !parInfoVec[ipar]->fixed() ) grid.freePars.push_back( parInfoVec[ipar] );
+   }
+
+   if( scanInfo == NULL ){
+      cout << "ERROR:  request to scan nonexistent parameter:  " << parScan << endl;
+      return;
+   }
+
+   int steps = grid.steps;
+   int center = 0;
+   if( outward && grid.stepSize != 0 )
+      center = max( 0, min( steps - 1, (int)lround( ( scanInfo->value() - grid.minVal ) / grid.stepSize ) ) );
+
+   string fitName = cfgInfo->fitName();
+   cfgInfo->setFitName(fitName + "_scan");
+
+   int numWorkers = min( options.numWorkers, steps );
+   if( numWorkers < 1 ) numWorkers = 1;
+
+   AmpToolsInterface* ati = NULL;
+   ProductionPreFit* preFit = NULL;
+#ifndef GPU_ACCELERATION
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   ati = new AmpToolsInterface( cfgInfo );
+   session.reportMemory( *ati, cfgInfo );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati->likelihood() << endl;
+   if( session.normIntCache() != NULL ) session.normIntCache()->store( *ati );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+   preFit = session.makePreFit( *ati, cfgInfo );
+#endif
+
+   vector< ScanResult > results;
+
+   if( numWorkers == 1 ){
+
+      if( ati == NULL ){
+         AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+         ati = new AmpToolsInterface( cfgInfo );
+         AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+         cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati->likelihood() << endl;
+         if( session.normIntCache() != NULL ) session.normIntCache()->store( *ati );
+         AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+         preFit = session.makePreFit( *ati, cfgInfo );
+      }
+      ati->minuitMinimizationManager()->setMaxIterations(options.maxIter);
+      FitSession::TelemetryScope telemetryScope( session, *ati );
+
+      results = runScanSteps(session, *ati, preFit, cfgInfo, seedfile, grid, 0, steps, center, outward, -1);
+   }
+   else{
+
+      runWorkers< ScanResult >( session, numWorkers,
+         [&]( int w, int fd ){
+
+            if( ati == NULL ){
+               AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+               ati = new AmpToolsInterface( cfgInfo );
+               AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+               preFit = session.makePreFit( *ati, cfgInfo );
+            }
+            ati->minuitMinimizationManager()->setMaxIterations(options.maxIter);
+            FitSession::TelemetryScope telemetryScope( session, *ati, Form("worker%d", w) );
+
+            runScanSteps(session, *ati, preFit, cfgInfo, seedfile, grid,
+                         w * steps / numWorkers, ( w + 1 ) * steps / numWorkers, center, outward, fd);
+         },
+         [&]( const ScanResult& result ){
+
+            results.push_back( result );
+            cout << "FINISHED SCAN STEP " << result.step << " (" << results.size() << " OF " << steps << "):  "
+                 << ( result.failed ? "FAILED" : Form("LIKELIHOOD = %f", result.likelihood) ) << endl;
+         } );
+   }
+
+   // likelihood profile of the scanned parameter
+   sort( results.begin(), results.end(),
+         []( const ScanResult& a, const ScanResult& b ){ return a.step < b.step; } );
+
+   cout << endl << "SCAN OF " << parScan << ":" << endl;
+   for(size_t i=0; i<results.size(); i++)
+      cout << "   " << results[i].step << "\t" << results[i].value << "\t"
+           << ( results[i].failed ? "FAILED" : Form("%f", results[i].likelihood) ) << endl;
+
+   if( (int)results.size() < steps )
+      cout << "ERROR:  only " << results.size() << " of " << steps << " scan steps reported a result" << endl;
+
+   delete preFit;
+   delete ati;
+}
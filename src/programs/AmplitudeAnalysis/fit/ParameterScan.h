@@ -0,0 +1,24 @@
+#if !defined(PARAMETERSCAN)
+#define PARAMETERSCAN
+
+#include <string>
+
+using namespace std;
+
+class ConfigurationInfo;
+class FitSession;
+
+/**
+ * The scan of -p:  parScan is fixed at the points of the grid of its
+ * parScan keyword and the other parameters are fit at every point, which
+ * writes <fitName>_scan_<i>.fit and prints the likelihood profile.  Every
+ * step starts from the parameters of the nearest step that has converged.
+ * With the workers of -w the grid is split into contiguous ranges that
+ * are scanned at the same time, each range warm-started within itself.
+ * With outward (-o) the scan starts at the grid point closest to the
+ * starting value of the parameter in the configuration file.
+ */
+void runParScan( FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile,
+                 const string& parScan, bool outward );
+
+#endif
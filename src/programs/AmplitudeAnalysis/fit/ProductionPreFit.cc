@@ -0,0 +1,760 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+#include "IUAmpTools/NormIntInterface.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+
+#include "ProductionPreFit.h"
+#include "LBFGS.h"
+
+// the cached decay amplitudes of all reactions are limited to this size
+static const double kMaxCacheBytes = 4e9;
+
+// adds P A of the n events of a tile to S, with the real and imaginary
+// parts of A and S in separate arrays
+static inline void
+addProduct( double pr, double pi, const double* ar, const double* ai, int n,
+            double* sr, double* si ){
+
+  for( int e = 0; e < n; ++e ){
+
+    sr[e] += pr * ar[e] - pi * ai[e];
+    si[e] += pr * ai[e] + pi * ar[e];
+  }
+}
+
+ProductionPreFit::ProductionPreFit( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo ) :
+  m_ati( ati ),
+  m_cfgInfo( cfgInfo ),
+  m_nPars( 0 ),
+  m_intScale( 0 ),
+  m_offset( 0 ),
+  m_valid( false )
+{
+  ParameterManager* parMgr = ati.parameterManager();
+
+  map< const complex< double >*, int > groupIndex;
+  double cacheBytes = 0;
+
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int irct = 0; irct < reactions.size(); ++irct ){
+
+    if( !reactions[irct]->bkgnd().first.empty() ){
+
+      cout << "ProductionPreFit:  reaction " << reactions[irct]->reactionName()
+           << " has a background sample, the pre-fit is not used" << endl;
+      return;
+    }
+
+    Reaction reaction;
+    reaction.name = reactions[irct]->reactionName();
+    reaction.nEvents = 0;
+
+    map< string, int > sumIndex;
+
+    vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( reaction.name );
+    for( unsigned int iamp = 0; iamp < amps.size(); ++iamp ){
+
+      string ampName = amps[iamp]->fullName();
+
+      // constrained amplitudes share their production parameter
+      const complex< double >* value = parMgr->getProdParPtr( ampName );
+      if( groupIndex.find( value ) == groupIndex.end() ){
+
+        Group group;
+        group.amp = ampName;
+        group.value = value;
+        group.fixed = amps[iamp]->fixed();
+        group.real = amps[iamp]->real();
+        group.re = group.im = -1;
+
+        groupIndex[value] = m_groups.size();
+        m_groups.push_back( group );
+      }
+
+      Term term;
+      term.group = groupIndex[value];
+      term.amp = iamp;
+
+      string scale = amps[iamp]->scale();
+      if( scale.size() > 2 && scale[0] == '[' )
+        term.scale = *( parMgr->getAmpParPtr( scale.substr( 1, scale.size() - 2 ) ) );
+      else
+        term.scale = atof( scale.c_str() );
+
+      string sumName = amps[iamp]->sumName();
+      if( sumIndex.find( sumName ) == sumIndex.end() ){
+
+        sumIndex[sumName] = reaction.sums.size();
+        reaction.sums.push_back( vector< Term >() );
+      }
+      reaction.sums[sumIndex[sumName]].push_back( term );
+      reaction.amps.push_back( ampName );
+    }
+
+    m_reactions.push_back( reaction );
+  }
+
+  for( unsigned int i = 0; i < m_groups.size(); ++i ){
+
+    if( m_groups[i].fixed ) continue;
+    m_groups[i].re = m_nPars++;
+    if( !m_groups[i].real ) m_groups[i].im = m_nPars++;
+  }
+
+  if( m_nPars == 0 ) return;
+
+  for( unsigned int i = 0; i < m_reactions.size(); ++i ){
+
+    load( m_reactions[i] );
+    cacheBytes += (double)m_reactions[i].nEvents * m_reactions[i].amps.size() *
+                  sizeof( complex< double > );
+
+    if( cacheBytes > kMaxCacheBytes ){
+
+      cout << "ProductionPreFit:  the decay amplitudes need more than " << kMaxCacheBytes
+           << " bytes, the pre-fit is not used" << endl;
+      m_reactions.clear();
+      return;
+    }
+  }
+
+  calibrate();
+}
+
+void
+ProductionPreFit::load( Reaction& reaction ){
+
+  DataReader* reader = m_ati.dataReader( reaction.name );
+  reader->resetSource();
+
+  m_ati.loadEvents( reader );
+  m_ati.processEvents( reaction.name );
+
+  int nAmps = reaction.amps.size();
+  reaction.nEvents = m_ati.numEvents();
+
+  reaction.weights.resize( reaction.nEvents );
+  reaction.decayAmps.assign( (size_t)reaction.numTiles() * nAmps * 2 * kTileEvents, 0. );
+
+  for( int iEvent = 0; iEvent < reaction.nEvents; ++iEvent ){
+
+    Kinematics* kin = m_ati.kinematics( iEvent );
+    reaction.weights[iEvent] = kin->weight();
+    delete kin;
+
+    double* re = &( reaction.decayAmps[(size_t)( iEvent / kTileEvents ) * nAmps * 2 * kTileEvents] ) +
+                 iEvent % kTileEvents;
+    for( int iamp = 0; iamp < nAmps; ++iamp ){
+
+      complex< double > amp = m_ati.decayAmplitude( iEvent, reaction.amps[iamp] );
+      re[2 * iamp * kTileEvents] = amp.real();
+      re[( 2 * iamp + 1 ) * kTileEvents] = amp.imag();
+    }
+  }
+
+  m_ati.clearEvents();
+
+  NormIntInterface* normInt = m_ati.normIntInterface( reaction.name );
+  reaction.normInts.resize( reaction.sums.size() );
+  for( unsigned int s = 0; s < reaction.sums.size(); ++s ){
+
+    const vector< Term >& terms = reaction.sums[s];
+    vector< complex< double > >& N = reaction.normInts[s];
+
+    N.clear();
+    N.reserve( terms.size() * ( terms.size() + 1 ) / 2 );
+    for( unsigned int ta = 0; ta < terms.size(); ++ta )
+      for( unsigned int tb = ta; tb < terms.size(); ++tb )
+        N.push_back( normInt->normInt( reaction.amps[terms[ta].amp], reaction.amps[terms[tb].amp] ) );
+  }
+}
+
+void
+ProductionPreFit::refresh(){
+
+  if( !m_valid ) return;
+
+  // brings the integrals of the AmpToolsInterface up to date
+  m_ati.likelihood();
+
+  for( unsigned int i = 0; i < m_reactions.size(); ++i ) load( m_reactions[i] );
+}
+
+vector< double >
+ProductionPreFit::currentPars() const {
+
+  vector< double > x( m_nPars );
+  for( unsigned int i = 0; i < m_groups.size(); ++i ){
+
+    if( m_groups[i].re >= 0 ) x[m_groups[i].re] = m_groups[i].value->real();
+    if( m_groups[i].im >= 0 ) x[m_groups[i].im] = m_groups[i].value->imag();
+  }
+  return x;
+}
+
+void
+ProductionPreFit::setPars( const vector< double >& x ){
+
+  ParameterManager* parMgr = m_ati.parameterManager();
+
+  for( unsigned int i = 0; i < m_groups.size(); ++i ){
+
+    const Group& group = m_groups[i];
+    if( group.re < 0 ) continue;
+
+    parMgr->setProductionParameter( group.amp,
+      complex< double >( x[group.re], group.im >= 0 ? x[group.im] : 0. ) );
+  }
+}
+
+void
+ProductionPreFit::evaluate( const vector< double >& x, double& dataTerm, double& intTerm,
+                            vector< double >* dataGrad, vector< double >* intGrad ) const {
+
+  dataTerm = 0;
+  intTerm = 0;
+  if( dataGrad != NULL ) dataGrad->assign( m_nPars, 0. );
+  if( intGrad != NULL ) intGrad->assign( m_nPars, 0. );
+
+  vector< complex< double > > prod = production( x );
+
+  for( unsigned int irct = 0; irct < m_reactions.size(); ++irct ){
+
+    const Reaction& reaction = m_reactions[irct];
+    vector< complex< double > > P = ampFactors( reaction, prod );
+
+    // sum_i w_i ln I_i with I = sum_s | sum_a P_a A_a |^2, and
+    // dI / dRe V = 2 Re( S* B ), dI / dIm V = -2 Im( S* B ) where B is the
+    // part of S that is proportional to V; per block of tiles
+    int nSums = reaction.sums.size();
+    int nTiles = reaction.numTiles();
+    int nBlocks = ( nTiles + kTilesPerBlock - 1 ) / kTilesPerBlock;
+
+    vector< double > blockTerm( nBlocks, 0. );
+    vector< char > blockValid( nBlocks, 1 );
+    vector< double > blockGrad( dataGrad != NULL ? (size_t)nBlocks * m_nPars : 0, 0. );
+
+    AmplitudeThreads::runChunks( nBlocks, 1, [&]( int begin, int end ){
+
+      vector< double > S( 2 * nSums * kTileEvents ), intensity( kTileEvents ), factor( kTileEvents );
+
+      for( int b = begin; b < end; ++b ){
+
+        double* grad = ( dataGrad != NULL ? &( blockGrad[(size_t)b * m_nPars] ) : NULL );
+        int lastTile = min( nTiles, ( b + 1 ) * kTilesPerBlock );
+
+        for( int t = b * kTilesPerBlock; t < lastTile; ++t ){
+
+          int n = min( (int)kTileEvents, reaction.nEvents - t * kTileEvents );
+          const double* tile = reaction.tile( t );
+          const double* weight = &( reaction.weights[(size_t)t * kTileEvents] );
+
+          fill( intensity.begin(), intensity.begin() + n, 0. );
+          for( int s = 0; s < nSums; ++s ){
+
+            double* sr = &( S[2 * s * kTileEvents] );
+            double* si = sr + kTileEvents;
+            fill( sr, sr + n, 0. );
+            fill( si, si + n, 0. );
+
+            for( unsigned int k = 0; k < reaction.sums[s].size(); ++k ){
+
+              int a = reaction.sums[s][k].amp;
+              addProduct( P[a].real(), P[a].imag(), tile + 2 * a * kTileEvents,
+                          tile + ( 2 * a + 1 ) * kTileEvents, n, sr, si );
+            }
+
+            for( int e = 0; e < n; ++e ) intensity[e] += sr[e] * sr[e] + si[e] * si[e];
+          }
+
+          double logSum = 0;
+          for( int e = 0; e < n; ++e ){
+
+            if( !( intensity[e] > 0 ) ){
+
+              blockValid[b] = 0;
+              return;
+            }
+            logSum += weight[e] * log( intensity[e] );
+          }
+          blockTerm[b] += logSum;
+
+          if( grad == NULL ) continue;
+
+          for( int e = 0; e < n; ++e ) factor[e] = 2 * weight[e] / intensity[e];
+
+          // sum_e factor conj( S ) A of the term, times its scale
+          for( int s = 0; s < nSums; ++s ){
+
+            const double* sr = &( S[2 * s * kTileEvents] );
+            const double* si = sr + kTileEvents;
+
+            for( unsigned int k = 0; k < reaction.sums[s].size(); ++k ){
+
+              const Term& term = reaction.sums[s][k];
+              const Group& group = m_groups[term.group];
+              if( group.re < 0 ) continue;
+
+              const double* ar = tile + 2 * term.amp * kTileEvents;
+              const double* ai = ar + kTileEvents;
+
+              double cr = 0, ci = 0;
+              for( int e = 0; e < n; ++e ){
+
+                cr += factor[e] * ( sr[e] * ar[e] + si[e] * ai[e] );
+                ci += factor[e] * ( sr[e] * ai[e] - si[e] * ar[e] );
+              }
+
+              grad[group.re] += term.scale * cr;
+              if( group.im >= 0 ) grad[group.im] -= term.scale * ci;
+            }
+          }
+        }
+      }
+    } );
+
+    for( int b = 0; b < nBlocks; ++b ){
+
+      if( !blockValid[b] ){
+
+        dataTerm = -HUGE_VAL;
+        return;
+      }
+
+      dataTerm += blockTerm[b];
+      if( dataGrad != NULL )
+        for( int p = 0; p < m_nPars; ++p ) (*dataGrad)[p] += blockGrad[(size_t)b * m_nPars + p];
+    }
+
+    intTerm += integralTerm( reaction, P, intGrad );
+  }
+}
+
+vector< complex< double > >
+ProductionPreFit::production( const vector< double >& x ) const {
+
+  vector< complex< double > > prod( m_groups.size() );
+  for( unsigned int i = 0; i < m_groups.size(); ++i ){
+
+    const Group& group = m_groups[i];
+    if( group.re < 0 ) prod[i] = *group.value;
+    else prod[i] = complex< double >( x[group.re], group.im >= 0 ? x[group.im] : 0. );
+  }
+  return prod;
+}
+
+vector< complex< double > >
+ProductionPreFit::ampFactors( const Reaction& reaction, const vector< complex< double > >& prod ){
+
+  vector< complex< double > > P( reaction.amps.size() );
+  for( unsigned int s = 0; s < reaction.sums.size(); ++s )
+    for( unsigned int t = 0; t < reaction.sums[s].size(); ++t ){
+
+      const Term& term = reaction.sums[s][t];
+      P[term.amp] = term.scale * prod[term.group];
+    }
+  return P;
+}
+
+double
+ProductionPreFit::integralTerm( const Reaction& reaction, const vector< complex< double > >& P,
+                                vector< double >* intGrad ) const {
+
+  // sum_s sum_ab P_a P_b* normInt( a, b ), with Q_a = sum_b P_b* normInt( a, b )
+  // filled from the upper triangle and normInt( b, a ) = normInt( a, b )*
+  double intTerm = 0;
+  vector< complex< double > > Q;
+  for( unsigned int s = 0; s < reaction.sums.size(); ++s ){
+
+    const vector< Term >& terms = reaction.sums[s];
+    if( terms.empty() ) continue;
+    const complex< double >* N = &( reaction.normInts[s][0] );
+
+    Q.assign( terms.size(), 0. );
+    for( unsigned int ta = 0; ta < terms.size(); ++ta ){
+
+      complex< double > Pa = conj( P[terms[ta].amp] );
+      Q[ta] += Pa * *N++;
+
+      for( unsigned int tb = ta + 1; tb < terms.size(); ++tb, ++N ){
+
+        Q[ta] += conj( P[terms[tb].amp] ) * *N;
+        Q[tb] += Pa * conj( *N );
+      }
+    }
+
+    for( unsigned int ta = 0; ta < terms.size(); ++ta ){
+
+      intTerm += real( P[terms[ta].amp] * Q[ta] );
+
+      const Group& group = m_groups[terms[ta].group];
+      if( intGrad == NULL || group.re < 0 ) continue;
+
+      complex< double > q = Q[ta] * terms[ta].scale;
+      (*intGrad)[group.re] += 2 * q.real();
+      if( group.im >= 0 ) (*intGrad)[group.im] -= 2 * q.imag();
+    }
+  }
+  return intTerm;
+}
+
+double
+ProductionPreFit::likelihood( const vector< double >& x, vector< double >* grad ) const {
+
+  double dataTerm, intTerm;
+
+  if( grad == NULL ){
+
+    evaluate( x, dataTerm, intTerm, NULL, NULL );
+    return -2 * dataTerm + 2 * m_intScale * intTerm + m_offset;
+  }
+
+  vector< double > dataGrad, intGrad;
+  evaluate( x, dataTerm, intTerm, &dataGrad, &intGrad );
+
+  grad->resize( m_nPars );
+  for( int i = 0; i < m_nPars; ++i )
+    (*grad)[i] = -2 * dataGrad[i] + 2 * m_intScale * intGrad[i];
+
+  return -2 * dataTerm + 2 * m_intScale * intTerm + m_offset;
+}
+
+vector< double >
+ProductionPreFit::likelihoods( const vector< vector< double > >& points ) const {
+
+  int K = points.size();
+  vector< double > dataTerms( K, 0. ), intTerms( K, 0. );
+
+  vector< vector< complex< double > > > prods( K );
+  for( int k = 0; k < K; ++k ) prods[k] = production( points[k] );
+
+  for( unsigned int irct = 0; irct < m_reactions.size(); ++irct ){
+
+    const Reaction& reaction = m_reactions[irct];
+    int nSums = reaction.sums.size();
+    int nTiles = reaction.numTiles();
+    int nBlocks = ( nTiles + kTilesPerBlock - 1 ) / kTilesPerBlock;
+
+    // the factors of the amplitudes by amplitude, then point, so that the
+    // factors of all points of an amplitude are adjacent
+    int nAmps = reaction.amps.size();
+    vector< double > Pr( (size_t)nAmps * K ), Pi( (size_t)nAmps * K );
+    for( int k = 0; k < K; ++k ){
+
+      vector< complex< double > > P = ampFactors( reaction, prods[k] );
+      for( int a = 0; a < nAmps; ++a ){
+
+        Pr[(size_t)a * K + k] = P[a].real();
+        Pi[(size_t)a * K + k] = P[a].imag();
+      }
+      intTerms[k] += integralTerm( reaction, P, NULL );
+    }
+
+    // as evaluate, with the sums S of every point for a sum of amplitudes
+    // of a tile built while its amplitudes are in cache
+    vector< double > blockTerm( (size_t)nBlocks * K, 0. );
+    vector< char > blockValid( (size_t)nBlocks * K, 1 );
+
+    AmplitudeThreads::runChunks( nBlocks, 1, [&]( int begin, int end ){
+
+      vector< double > S( (size_t)2 * K * kTileEvents ), intensity( (size_t)K * kTileEvents );
+
+      for( int b = begin; b < end; ++b ){
+
+        int lastTile = min( nTiles, ( b + 1 ) * kTilesPerBlock );
+
+        for( int t = b * kTilesPerBlock; t < lastTile; ++t ){
+
+          int n = min( (int)kTileEvents, reaction.nEvents - t * kTileEvents );
+          const double* tile = reaction.tile( t );
+          const double* weight = &( reaction.weights[(size_t)t * kTileEvents] );
+
+          fill( intensity.begin(), intensity.end(), 0. );
+          for( int s = 0; s < nSums; ++s ){
+
+            fill( S.begin(), S.end(), 0. );
+
+            for( unsigned int j = 0; j < reaction.sums[s].size(); ++j ){
+
+              int a = reaction.sums[s][j].amp;
+              const double* ar = tile + 2 * a * kTileEvents;
+              for( int k = 0; k < K; ++k ){
+
+                double* sr = &( S[(size_t)2 * k * kTileEvents] );
+                addProduct( Pr[(size_t)a * K + k], Pi[(size_t)a * K + k], ar, ar + kTileEvents,
+                            n, sr, sr + kTileEvents );
+              }
+            }
+
+            for( int k = 0; k < K; ++k ){
+
+              const double* sr = &( S[(size_t)2 * k * kTileEvents] );
+              const double* si = sr + kTileEvents;
+              double* I = &( intensity[(size_t)k * kTileEvents] );
+              for( int e = 0; e < n; ++e ) I[e] += sr[e] * sr[e] + si[e] * si[e];
+            }
+          }
+
+          for( int k = 0; k < K; ++k ){
+
+            const double* I = &( intensity[(size_t)k * kTileEvents] );
+            double logSum = 0;
+            for( int e = 0; e < n; ++e ){
+
+              if( !( I[e] > 0 ) ) blockValid[(size_t)b * K + k] = 0;
+              else logSum += weight[e] * log( I[e] );
+            }
+            blockTerm[(size_t)b * K + k] += logSum;
+          }
+        }
+      }
+    } );
+
+    for( int k = 0; k < K; ++k )
+      for( int b = 0; b < nBlocks; ++b ){
+
+        if( !blockValid[(size_t)b * K + k] ) dataTerms[k] = -HUGE_VAL;
+        dataTerms[k] += blockTerm[(size_t)b * K + k];
+      }
+  }
+
+  vector< double > L( K );
+  for( int k = 0; k < K; ++k )
+    L[k] = -2 * dataTerms[k] + 2 * m_intScale * intTerms[k] + m_offset;
+  return L;
+}
+
+void
+ProductionPreFit::calibrate(){
+
+  vector< double > x0 = currentPars();
+
+  double scale = 0;
+  for( int i = 0; i < m_nPars; ++i ) scale = max( scale, fabs( x0[i] ) );
+  if( scale == 0 ) scale = 1;
+
+  double L0 = m_ati.likelihood();
+  double D0, T0;
+  evaluate( x0, D0, T0, NULL, NULL );
+
+  // the integral term scales with |V|^2 and the data term with ln |V|^2,
+  // which separates the two
+  vector< double > x1( x0 );
+  for( int i = 0; i < m_nPars; ++i ) x1[i] *= 1.1;
+  setPars( x1 );
+  double L1 = m_ati.likelihood();
+  double D1, T1;
+  evaluate( x1, D1, T1, NULL, NULL );
+
+  if( T1 != T0 ){
+
+    m_intScale = ( ( L1 - L0 ) + 2 * ( D1 - D0 ) ) / ( 2 * ( T1 - T0 ) );
+    m_offset = L0 + 2 * D0 - 2 * m_intScale * T0;
+  }
+
+  // a different direction checks the model
+  vector< double > x2( x0 );
+  for( int i = 0; i < m_nPars; ++i )
+    x2[i] = x0[i] * ( 1 + 0.2 * ( i % 3 - 1 ) ) + 0.01 * scale * ( i % 2 ? 1 : -1 );
+  setPars( x2 );
+  double L2 = m_ati.likelihood();
+  double model = likelihood( x2, NULL );
+
+  setPars( x0 );
+
+  double tolerance = 1e-7 * fabs( L0 ) + 1e-6 * fabs( L2 - L0 ) + 1e-6;
+  m_valid = ( T1 != T0 && m_intScale > 0 && fabs( L2 - model ) <= tolerance );
+
+  if( m_valid )
+    cout << "ProductionPreFit:  " << m_nPars << " production parameters, cached likelihood agrees to "
+         << fabs( L2 - model ) << endl;
+  else
+    cout << "ProductionPreFit:  the cached likelihood does not reproduce the fit ("
+         << model << " instead of " << L2 << "), the pre-fit is not used" << endl;
+}
+
+double
+ProductionPreFit::minimize( int maxIter, bool verbose ){
+
+  vector< double > x = currentPars();
+  if( !m_valid ) return m_ati.likelihood();
+
+  struct Likelihood {
+
+    const ProductionPreFit& preFit;
+    double operator()( const vector< double >& x, vector< double >* grad ) const {
+      return preFit.likelihood( x, grad );
+    }
+  } likelihood = { *this };
+
+  double fStart;
+  int iter;
+  double f = minimizeLBFGS( likelihood, x, maxIter, iter, &fStart );
+
+  setPars( x );
+
+  if( verbose )
+    cout << "ProductionPreFit:  -2 ln L " << fStart << " -> " << f << " in "
+         << iter << " iterations" << endl;
+
+  return f;
+}
+
+vector< string >
+ProductionPreFit::parameterNames() const {
+
+  vector< string > names( m_nPars );
+  for( unsigned int i = 0; i < m_groups.size(); ++i ){
+
+    if( m_groups[i].re >= 0 ) names[m_groups[i].re] = m_groups[i].amp + "_re";
+    if( m_groups[i].im >= 0 ) names[m_groups[i].im] = m_groups[i].amp + "_im";
+  }
+  return names;
+}
+
+vector< vector< double > >
+ProductionPreFit::hessian() const {
+
+  vector< vector< double > > H( m_nPars, vector< double >( m_nPars, 0. ) );
+  if( !m_valid ) return H;
+
+  vector< double > x = currentPars();
+  vector< complex< double > > prod = production( x );
+
+  // the derivative of an amplitude's P by a parameter is u = scale for
+  // Re V and u = i scale for Im V; slot is the index of the parameter
+  // among those of the sum
+  struct Derivative {
+
+    int term;
+    int slot;
+    complex< double > u;
+  };
+
+  for( unsigned int irct = 0; irct < m_reactions.size(); ++irct ){
+
+    const Reaction& reaction = m_reactions[irct];
+    int nAmps = reaction.amps.size();
+    int nSums = reaction.sums.size();
+
+    vector< complex< double > > P( nAmps );
+    vector< vector< int > > pars( nSums );
+    vector< vector< Derivative > > derivs( nSums );
+    vector< int > touched;
+    vector< bool > isTouched( m_nPars, false );
+
+    for( int s = 0; s < nSums; ++s )
+      for( unsigned int t = 0; t < reaction.sums[s].size(); ++t ){
+
+        const Term& term = reaction.sums[s][t];
+        P[term.amp] = term.scale * prod[term.group];
+
+        const Group& group = m_groups[term.group];
+        if( group.re < 0 ) continue;
+
+        int par[2] = { group.re, group.im };
+        complex< double > u[2] = { complex< double >( term.scale, 0 ),
+                                   complex< double >( 0, term.scale ) };
+        for( int k = 0; k < 2 && par[k] >= 0; ++k ){
+
+          Derivative d;
+          d.term = t;
+          d.u = u[k];
+          d.slot = find( pars[s].begin(), pars[s].end(), par[k] ) - pars[s].begin();
+          if( d.slot == (int)pars[s].size() ) pars[s].push_back( par[k] );
+          derivs[s].push_back( d );
+
+          if( !isTouched[par[k]] ) touched.push_back( par[k] );
+          isTouched[par[k]] = true;
+        }
+      }
+
+    // d2 ln I = ( d2 I ) / I - dI dI / I^2 with dI / dx_k = 2 Re( S* B_k ),
+    // d2 I / dx_k dx_l = 2 Re( B_k* B_l ) summed over the sums, where B_k
+    // is the derivative of S by x_k
+    vector< complex< double > > S( nSums );
+    vector< vector< complex< double > > > B( nSums );
+    vector< double > g( m_nPars, 0. );
+    vector< complex< double > > A( nAmps );
+    for( int iEvent = 0; iEvent < reaction.nEvents; ++iEvent ){
+
+      for( int iamp = 0; iamp < nAmps; ++iamp ) A[iamp] = reaction.decayAmp( iEvent, iamp );
+
+      double intensity = 0;
+      for( int s = 0; s < nSums; ++s ){
+
+        S[s] = 0;
+        for( unsigned int t = 0; t < reaction.sums[s].size(); ++t )
+          S[s] += P[reaction.sums[s][t].amp] * A[reaction.sums[s][t].amp];
+        intensity += norm( S[s] );
+      }
+      if( !( intensity > 0 ) ) continue;
+
+      for( unsigned int k = 0; k < touched.size(); ++k ) g[touched[k]] = 0;
+
+      for( int s = 0; s < nSums; ++s ){
+
+        B[s].assign( pars[s].size(), 0. );
+        for( unsigned int d = 0; d < derivs[s].size(); ++d )
+          B[s][derivs[s][d].slot] += derivs[s][d].u * A[reaction.sums[s][derivs[s][d].term].amp];
+
+        for( unsigned int j = 0; j < pars[s].size(); ++j )
+          g[pars[s][j]] += 2 * real( conj( S[s] ) * B[s][j] );
+      }
+
+      double weight = reaction.weights[iEvent];
+      double c1 = -2 * weight / intensity;
+      double c2 = 2 * weight / ( intensity * intensity );
+
+      for( int s = 0; s < nSums; ++s )
+        for( unsigned int j = 0; j < pars[s].size(); ++j )
+          for( unsigned int l = 0; l < pars[s].size(); ++l )
+            H[pars[s][j]][pars[s][l]] += c1 * 2 * real( conj( B[s][j] ) * B[s][l] );
+
+      for( unsigned int k = 0; k < touched.size(); ++k )
+        for( unsigned int l = 0; l < touched.size(); ++l )
+          H[touched[k]][touched[l]] += c2 * g[touched[k]] * g[touched[l]];
+    }
+
+    // the integral term sum_ab P_a P_b* normInt( a, b ) has the second
+    // derivatives 2 Re( sum_ab u_ak u_bl* normInt( a, b ) ); the pairs
+    // a < b of the upper triangle count for ( k, l ) and ( l, k )
+    for( int s = 0; s < nSums; ++s ){
+
+      const vector< Term >& terms = reaction.sums[s];
+      if( terms.empty() ) continue;
+      const complex< double >* N = &( reaction.normInts[s][0] );
+
+      for( unsigned int ta = 0; ta < terms.size(); ++ta )
+        for( unsigned int tb = ta; tb < terms.size(); ++tb, ++N )
+          for( unsigned int da = 0; da < derivs[s].size(); ++da ){
+
+            if( derivs[s][da].term != (int)ta ) continue;
+            for( unsigned int db = 0; db < derivs[s].size(); ++db ){
+
+              if( derivs[s][db].term != (int)tb ) continue;
+
+              int k = pars[s][derivs[s][da].slot];
+              int l = pars[s][derivs[s][db].slot];
+              double v = 2 * m_intScale * 2 * real( derivs[s][da].u * conj( derivs[s][db].u ) * *N );
+              H[k][l] += v;
+              if( ta != tb ) H[l][k] += v;
+            }
+          }
+    }
+  }
+
+  return H;
+}
@@ -0,0 +1,185 @@
+#if !defined(PRODUCTIONPREFIT)
+#define PRODUCTIONPREFIT
+
+#include <complex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * A minimization of -2 ln L over the free production parameters only, with
+ * an analytic gradient, to bring a fit close to its minimum before MIGRAD
+ * takes over.  The production parameters enter the likelihood linearly
+ * through the amplitudes, so with the decay amplitudes of the data events
+ * and the normalization integrals cached the likelihood and its exact
+ * gradient cost one pass over the cached amplitudes.  MIGRAD's numerical
+ * gradient needs about two likelihood evaluations per parameter instead.
+ *
+ * Amplitude parameters, e.g., BreitWigner masses and widths or Piecewise
+ * bin values, are held at their current values; MIGRAD varies all
+ * parameters afterwards, so the result of the fit and its errors are those
+ * of MIGRAD alone.
+ *
+ * The decay amplitudes are kept in tiles of events with all amplitudes of
+ * a tile together, real and imaginary parts apart, so that the sum over
+ * the amplitudes is a multiply-add over contiguous arrays that the
+ * compiler vectorizes and that stays in cache for large wave sets.  The
+ * blocks of tiles are shared over the threads of AmplitudeThreads and
+ * their terms summed in a fixed order, so the result does not depend on
+ * the number of threads.
+ *
+ * The cached model is checked against AmpToolsInterface::likelihood at
+ * three points, which also fixes the normalization of the integral term.
+ * If it does not reproduce the likelihood (e.g., background samples, which
+ * it does not model) valid() is false and minimize does nothing.
+ */
+
+class ProductionPreFit
+{
+
+public:
+
+  ProductionPreFit( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+
+  bool valid() const { return m_valid; }
+
+  AmpToolsInterface& ati() const { return m_ati; }
+  ConfigurationInfo* configurationInfo() const { return m_cfgInfo; }
+
+  /**
+   * Reloads the decay amplitudes and integrals after amplitude parameters
+   * have changed, e.g., in a scan.
+   */
+  void refresh();
+
+  /**
+   * Moves the free production parameters of the AmpToolsInterface to the
+   * minimum of the likelihood in them and returns the likelihood there.
+   */
+  double minimize( int maxIter = 500, bool verbose = true );
+
+  /**
+   * The free production parameters as Minuit names them (the real and
+   * imaginary part of an amplitude), in the order of the rows of hessian.
+   */
+  vector< string > parameterNames() const;
+
+  /**
+   * The second derivatives of -2 ln L in the free production parameters
+   * at their current values, computed exactly from the cached amplitudes;
+   * call refresh first if amplitude parameters have changed since.
+   */
+  vector< vector< double > > hessian() const;
+
+  /**
+   * The free production parameters at their current values, and setting
+   * them, in the order of parameterNames.
+   */
+  vector< double > parameters() const { return currentPars(); }
+  void setParameters( const vector< double >& x ) { setPars( x ); }
+
+  /**
+   * -2 ln L at each of the points, vectors of the free production
+   * parameters in the order of parameterNames, e.g., the steps of a scan,
+   * finite differences or random starts.  The points are evaluated in one
+   * pass over the cached decay amplitudes:  every tile is multiplied with
+   * the production parameters of all points while it is in cache, so that
+   * the amplitudes are read from memory once rather than once per point.
+   */
+  vector< double > likelihoods( const vector< vector< double > >& points ) const;
+
+private:
+
+  // the events of a tile of the decay amplitudes and the tiles of a block
+  // that a thread evaluates at a time
+  enum { kTileEvents = 256, kTilesPerBlock = 16 };
+
+  struct Term {
+
+    int group;
+    int amp;     // index among the amplitudes of the reaction
+    double scale;
+  };
+
+  struct Reaction {
+
+    string name;
+    vector< string > amps;
+    vector< vector< Term > > sums;
+
+    int nEvents;
+    vector< double > weights;
+
+    // the decay amplitudes in tiles of kTileEvents events:  for each tile
+    // and each amplitude the real parts of the events of the tile, then
+    // their imaginary parts, so that the sums over the amplitudes stream
+    // through a tile in cache with unit stride
+    vector< double > decayAmps;
+
+    int numTiles() const { return ( nEvents + kTileEvents - 1 ) / kTileEvents; }
+
+    const double* tile( int t ) const {
+      return &( decayAmps[(size_t)t * amps.size() * 2 * kTileEvents] );
+    }
+
+    complex< double > decayAmp( int iEvent, int amp ) const {
+      const double* re = tile( iEvent / kTileEvents ) + 2 * amp * kTileEvents + iEvent % kTileEvents;
+      return complex< double >( re[0], re[kTileEvents] );
+    }
+    // the integrals are Hermitian and amplitudes of different sums do not
+    // interfere:  per sum, normInt( a, b ) of its terms ta <= tb, row by row
+    vector< vector< complex< double > > > normInts;
+  };
+
+  // production parameters that vary together, i.e., an amplitude and the
+  // ones constrained to it
+  struct Group {
+
+    string amp;
+    const complex< double >* value;
+    bool fixed;
+    bool real;
+    int re, im;  // index in the parameter vector, -1 if not free
+  };
+
+  void load( Reaction& reaction );
+
+  vector< double > currentPars() const;
+  void setPars( const vector< double >& x );
+
+  // the production parameter of every group at x, and from those the
+  // factors P_a = scale V of the amplitudes of a reaction
+  vector< complex< double > > production( const vector< double >& x ) const;
+  static vector< complex< double > > ampFactors( const Reaction& reaction,
+                                                 const vector< complex< double > >& prod );
+
+  // the integral term of a reaction, with its gradient added to intGrad
+  double integralTerm( const Reaction& reaction, const vector< complex< double > >& P,
+                       vector< double >* intGrad ) const;
+
+  // the data term sum_i w_i ln I_i and the integral term, with gradients
+  void evaluate( const vector< double >& x, double& dataTerm, double& intTerm,
+                 vector< double >* dataGrad, vector< double >* intGrad ) const;
+
+  double likelihood( const vector< double >& x, vector< double >* grad ) const;
+
+  void calibrate();
+
+  AmpToolsInterface& m_ati;
+  ConfigurationInfo* m_cfgInfo;
+
+  vector< Group > m_groups;
+  vector< Reaction > m_reactions;
+  int m_nPars;
+
+  // -2 ln L = -2 dataTerm + 2 m_intScale intTerm + m_offset
+  double m_intScale;
+  double m_offset;
+  bool m_valid;
+};
+
+#endif
@@ -0,0 +1,138 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+
+#include "LikelihoodMemo.h"
+#include "ProfileErrors.h"
+
+ProfileErrors::ProfileErrors( AmpToolsInterface& ati ) :
+  m_ati( ati ),
+  m_minimum( LikelihoodMemo::likelihood( ati ) )
+{
+  MinuitParameterManager& pars = ati.minuitMinimizationManager()->parameterManager();
+  for( unsigned int i = 0; i < pars.size(); ++i ){
+
+    if( !pars[i]->floating() ) continue;
+    m_pars.push_back( pars[i] );
+    m_values.push_back( pars[i]->value() );
+  }
+}
+
+vector< string >
+ProfileErrors::parameters() const {
+
+  vector< string > names;
+  for( unsigned int i = 0; i < m_pars.size(); ++i ) names.push_back( m_pars[i]->name() );
+  return names;
+}
+
+bool
+ProfileErrors::errors( const string& name, double& lower, double& upper ){
+
+  lower = upper = 0;
+
+  int ipar = -1;
+  for( unsigned int i = 0; i < m_pars.size(); ++i )
+    if( m_pars[i]->name() == name ) ipar = i;
+
+  if( ipar < 0 ){
+
+    cout << "ProfileErrors ERROR:  " << name << " is not a floating parameter" << endl;
+    return false;
+  }
+
+  bool foundUp, foundDown;
+  upper = crossing( ipar, +1, foundUp );
+  lower = -crossing( ipar, -1, foundDown );
+
+  restore();
+  return foundUp && foundDown;
+}
+
+void
+ProfileErrors::restore(){
+
+  for( unsigned int i = 0; i < m_pars.size(); ++i ) m_pars[i]->setValue( m_values[i] );
+}
+
+double
+ProfileErrors::profile( int ipar, double value ){
+
+  restore();
+  m_pars[ipar]->setValue( value );
+  m_pars[ipar]->fix();
+
+  m_ati.minuitMinimizationManager()->migradMinimization();
+  double likelihood = m_ati.likelihood();
+
+  m_pars[ipar]->free();
+
+  if( likelihood < m_minimum - 1e-3 )
+    cout << "ProfileErrors WARNING:  " << m_pars[ipar]->name() << " = " << value
+         << " is below the minimum by " << m_minimum - likelihood << endl;
+
+  return likelihood;
+}
+
+double
+ProfileErrors::crossing( int ipar, double direction, bool& found ){
+
+  // -2 ln L rises by one at one standard deviation
+  const double up = 1;
+
+  double x0 = m_values[ipar];
+  double step = m_pars[ipar]->error();
+  if( !( step > 0 ) ) step = ( x0 != 0 ? 0.1 * fabs( x0 ) : 0.1 );
+
+  // a and b bracket the crossing:  f( a ) < 0 <= f( b )
+  double a = 0, fa = -up;
+  double b = step, fb = profile( ipar, x0 + direction * b ) - m_minimum - up;
+  for( int i = 0; fb < 0 && i < 6; ++i ){
+
+    a = b;
+    fa = fb;
+    b *= 2;
+    fb = profile( ipar, x0 + direction * b ) - m_minimum - up;
+  }
+
+  found = ( fb >= 0 );
+  if( !found ){
+
+    cout << "ProfileErrors:  no crossing of " << m_pars[ipar]->name() << " within "
+         << direction * b << " of the minimum" << endl;
+    return b;
+  }
+
+  // regula falsi, halving the value kept twice in a row (Illinois)
+  int side = 0;
+  for( int i = 0; i < 10 && b - a > 0.01 * step; ++i ){
+
+    double c = b - fb * ( b - a ) / ( fb - fa );
+    double fc = profile( ipar, x0 + direction * c ) - m_minimum - up;
+    if( fabs( fc ) < 0.01 * up ) return c;
+
+    if( fc < 0 ){
+
+      a = c;
+      fa = fc;
+      if( side == -1 ) fb /= 2;
+      side = -1;
+    }
+    else{
+
+      b = c;
+      fb = fc;
+      if( side == +1 ) fa /= 2;
+      side = +1;
+    }
+  }
+
+  return b - fb * ( b - a ) / ( fb - fa );
+}
@@ -0,0 +1,66 @@
+#if !defined(PROFILEERRORS)
+#define PROFILEERRORS
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class MinuitParameter;
+
+/**
+ * The asymmetric errors of MINOS, one parameter at a time:  the values of
+ * a parameter where -2 ln L, minimized in all other parameters, rises by
+ * one above the minimum.  MINOS walks the parameters one after the other
+ * inside a single Minuit; here every parameter is independent of the
+ * others, so the parameters can be shared among forked workers that each
+ * start from the converged MIGRAD minimum.
+ *
+ * Each point of the profile fixes the parameter, runs MIGRAD from the
+ * minimum and frees it again.  The crossing is bracketed in steps of the
+ * parabolic error, doubling, and found by regula falsi to a hundredth of
+ * the parabolic error.  Bounds of the parameters are not known here, a
+ * crossing beyond a bound is reported as not found.
+ *
+ * Usage:  construct at the minimum, after MIGRAD; errors moves the
+ * parameters, restore brings them back to the minimum.
+ */
+
+class ProfileErrors
+{
+
+public:
+
+  ProfileErrors( AmpToolsInterface& ati );
+
+  // the names of the floating Minuit parameters
+  vector< string > parameters() const;
+
+  /**
+   * The lower (negative) and upper errors of parameter name; returns false
+   * if the parameter is not floating or one of the crossings was not found.
+   */
+  bool errors( const string& name, double& lower, double& upper );
+
+  // sets all parameters to the minimum
+  void restore();
+
+  double minimum() const { return m_minimum; }
+
+private:
+
+  // -2 ln L minimized with parameter ipar fixed at value
+  double profile( int ipar, double value );
+
+  // the distance from the minimum to the crossing in direction +1 or -1
+  double crossing( int ipar, double direction, bool& found );
+
+  AmpToolsInterface& m_ati;
+
+  vector< MinuitParameter* > m_pars;
+  vector< double > m_values;
+  double m_minimum;
+};
+
+#endif
@@ -0,0 +1,444 @@
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#include <unistd.h>
+
+#include "TString.h"
+#include "TRandom.h"
+
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_DATAIO/FitTelemetry.h"
+#include "AMPTOOLS_DATAIO/FitCheckpoint.h"
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "MinuitInterface/MinuitParameterManager.h"
+#include "MinuitInterface/MinuitParameter.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "ProductionPreFit.h"
+#include "LatinHypercubeStarts.h"
+#include "LikelihoodMemo.h"
+#include "FitSession.h"
+#include "FitWorkers.h"
+#include "RandomRestarts.h"
+
+namespace {
+
+struct RndFitResult {
+   int tag;
+   int failed;
+   double likelihood;
+};
+
+// the value of RndFitResult::failed of a restart stopped by --prune-calls
+const int kFitPruned = 2;
+
+// the random number generators that randomizeProductionPars and
+// randomizeParameter may draw from
+void seedRandom(unsigned int seed) {
+   srand( seed );
+   srand48( seed );
+   gRandom->SetSeed( seed );
+}
+
+// runs MIGRAD in pieces of --prune-calls function calls, up to -m in all;
+// a new piece continues from the minimum and covariance of the one before.
+// Returns false if the fit was stopped as not competitive with minLL.
+bool migradOrPrune(const FitOptions& options, MinuitMinimizationManager* fitManager, double minLL) {
+   int pruneCalls = options.pruneCalls;
+   int maxIter = options.maxIter;
+   bool pruned = false;
+   for(int calls=0; calls<maxIter; calls+=pruneCalls) {
+      fitManager->setMaxIterations( min( pruneCalls, maxIter - calls ) );
+      fitManager->migradMinimization();
+      if( fitManager->status() == 0 ) break;
+
+      double fmin = fitManager->bestMinimum();
+      if( fmin > minLL + options.pruneMargin || fmin - 10 * fitManager->estDistToMinimum() > minLL ) {
+         cout << "PRUNED AFTER " << calls + min( pruneCalls, maxIter - calls ) << " CALLS AT " << fmin
+              << " (EDM " << fitManager->estDistToMinimum() << "), BEST SO FAR " << minLL << endl;
+         pruned = true;
+         break;
+      }
+   }
+   fitManager->setMaxIterations( maxIter );
+   return !pruned;
+}
+
+// randomizes the parameters and runs fit i of numRnd; returns 0 if it
+// converged, 1 if it failed and kFitPruned if --prune-calls stopped it
+// as worse than minLL, the best converged restart so far (0 if none)
+int runRndFit(FitSession& session, AmpToolsInterface& ati, ProductionPreFit* preFit, const vector< vector<string> >& parRangeKeywords, double maxFraction, double minLL, int i, int numRnd) {
+   const FitOptions& options = session.options();
+
+   cout << endl << "###############################" << endl;
+   cout << "FIT " << i << " OF " << numRnd << endl;
+   cout << endl << "###############################" << endl;
+
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   session.setLabel( Form("rnd %d", i) );
+
+   // randomize parameters
+   if( session.hypercube() != NULL )
+      session.hypercube()->setStart( i );
+   else {
+      ati.randomizeProductionPars(maxFraction);
+      for(size_t ipar=0; ipar<parRangeKeywords.size(); ipar++) {
+         ati.randomizeParameter(parRangeKeywords[ipar][0], atof(parRangeKeywords[ipar][1].c_str()), atof(parRangeKeywords[ipar][2].c_str()));
+      }
+   }
+
+   // the previous fit or the randomization may have moved amplitude
+   // parameters; a fit that was interrupted continues where it stopped
+   if( !session.restoreFit( i ) ) {
+      bool changedAmpPars = i > 0 || parRangeKeywords.size() != 0;
+      if( options.screenStarts > 1 && preFit != NULL && preFit->valid() ) {
+         if( changedAmpPars ) preFit->refresh();
+         changedAmpPars = false;
+         vector< vector<double> > starts( 1, preFit->parameters() );
+         for(int k=1; k<options.screenStarts; k++) {
+            ati.randomizeProductionPars(maxFraction);
+            starts.push_back( preFit->parameters() );
+         }
+         vector<double> startLL = preFit->likelihoods( starts );
+         size_t best = min_element( startLL.begin(), startLL.end() ) - startLL.begin();
+         preFit->setParameters( starts[best] );
+         cout << "STARTING FROM " << best << " OF " << options.screenStarts << " RANDOM PRODUCTION PARS:  " << startLL[best] << endl;
+      }
+      if( session.runCoarseStages( ati ) ) changedAmpPars = true;
+      session.preMinimize( preFit, changedAmpPars );
+      session.gradientMinimize( ati );
+   }
+
+   if( options.useMinos )
+      fitManager->minosMinimization();
+   else if( options.pruneCalls > 0 && minLL < 0 ) {
+      if( !migradOrPrune( options, fitManager, minLL ) ) {
+         if( session.telemetry() != NULL )
+            session.telemetry()->record( Form("\"type\": \"pruned\", \"likelihood\": %.12g", fitManager->bestMinimum()) );
+         cout << "LIKELIHOOD OF PRUNED FIT:  " << LikelihoodMemo::likelihood( ati ) << endl;
+         return kFitPruned;
+      }
+   }
+   else
+      fitManager->migradMinimization();
+
+   bool fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
+   session.recordFit( fitFailed, LikelihoodMemo::likelihood( ati ) );
+
+   if( fitFailed )
+      cout << "ERROR: fit failed use results with caution..." << endl;
+
+   cout << "LIKELIHOOD AFTER MINIMIZATION:  " << LikelihoodMemo::likelihood( ati ) << endl;
+
+   return fitFailed ? 1 : 0;
+}
+
+// writes the restart i that was just fit, if it is kept or the best so far;
+// the best is written with bestTag, i.e., as <fit>.fit if it is empty
+void writeRndFit(FitSession& session, AmpToolsInterface& ati, const string& seedfile, int i, bool fitFailed, bool best, const string& bestTag) {
+   if( session.options().keepRestarts ) {
+      session.finalizeFit(ati, to_string(i));
+      if( seedfile.size() != 0 && !fitFailed )
+         ati.fitResults()->writeSeed( seedfile + Form("_%d.txt", i) );
+   }
+   if( best ) {
+      session.finalizeFit(ati, bestTag);
+      if( seedfile.size() != 0 )
+         ati.fitResults()->writeSeed( seedfile + ( bestTag.size() != 0 ? "_" + bestTag : "" ) + ".txt" );
+   }
+}
+
+// the floating Minuit parameters of ati
+vector<double> floatingParameters(AmpToolsInterface& ati) {
+   vector<double> values;
+   MinuitParameterManager& pars = ati.minuitMinimizationManager()->parameterManager();
+   for(size_t k=0; k<pars.size(); k++)
+      if( pars[k]->floating() ) values.push_back( pars[k]->value() );
+   return values;
+}
+
+// the best restart of the minimum of every restart, -1 for those that did
+// not converge or whose parameters are not known (see --distinct)
+vector<int> groupMinima(const vector< RndFitResult >& results, const vector< vector<double> >& values, double distinctTolerance) {
+   multimap< double, size_t > byLikelihood;
+   for(size_t i=0; i<results.size(); i++)
+      if( !results[i].failed && values[i].size() != 0 ) byLikelihood.insert( make_pair( results[i].likelihood, i ) );
+
+   vector<int> minimum( results.size(), -1 );
+   vector<size_t> best;
+   for(multimap< double, size_t >::iterator it=byLikelihood.begin(); it!=byLikelihood.end(); ++it) {
+      const vector<double>& x = values[it->second];
+      for(size_t b=0; b<best.size() && minimum[it->second] < 0; b++) {
+         const vector<double>& y = values[best[b]];
+         double diff = 0, norm = 0;
+         for(size_t k=0; k<x.size(); k++) {
+            diff += ( x[k] - y[k] ) * ( x[k] - y[k] );
+            norm += y[k] * y[k];
+         }
+         if( sqrt( diff ) <= distinctTolerance * sqrt( norm ) ) minimum[it->second] = results[best[b]].tag;
+      }
+      if( minimum[it->second] < 0 ) {
+         minimum[it->second] = results[it->second].tag;
+         best.push_back( it->second );
+      }
+   }
+
+   cout << "DISTINCT MINIMA:  " << best.size() << " OF " << byLikelihood.size() << " CONVERGED FITS" << endl;
+   return minimum;
+}
+
+// the status and likelihood of every restart, one line each, in
+// <fit>_restarts.txt; minimum, if not empty, is the best restart of the
+// minimum of every restart (see groupMinima)
+void writeRestartTable(const string& fitName, const vector< RndFitResult >& results, const vector<int>& minimum = vector<int>()) {
+   string fileName = fitName + "_restarts.txt";
+   ofstream out( fileName.c_str() );
+   out << "# fit\tstatus\tlikelihood" << ( minimum.size() != 0 ? "\tminimum" : "" ) << endl;
+   out << setprecision( 12 );
+   for(size_t i=0; i<results.size(); i++) {
+      out << results[i].tag << "\t" << ( results[i].failed == kFitPruned ? "pruned" : results[i].failed ? "failed" : "converged" ) << "\t"
+          << results[i].likelihood;
+      if( minimum.size() != 0 ) out << "\t" << minimum[i];
+      out << endl;
+   }
+   if( !out ) cout << "ERROR:  cannot write " << fileName << endl;
+}
+
+void reportBestRndFit(int numRnd, int minFitTag, double minLL) {
+   // print best fit results
+   if(minFitTag < 0) cout << "ALL FITS FAILED!" << endl;
+   else cout << "MINIMUM LIKELIHOOD FROM " << minFitTag << " of " << numRnd << " RANDOM PRODUCTION PARS = " << minLL << endl;
+}
+
+// moves the best fit that a worker wrote with tag to <fit>.fit, with its
+// companions, and its seed to <seed>.txt
+void moveBestRndFit(const string& fitName, const string& seedfile, const string& tag) {
+   string from = fitName + "_" + tag + ".fit";
+   if( rename( from.c_str(), ( fitName + ".fit" ).c_str() ) != 0 )
+      cout << "ERROR:  cannot move " << from << " to " << fitName << ".fit" << endl;
+   for( const char* companion : FitSession::fitCompanions ){
+      from = fitName + "_" + tag + companion;
+      if( access( from.c_str(), F_OK ) == 0 ) rename( from.c_str(), ( fitName + companion ).c_str() );
+   }
+   if( seedfile.size() != 0 ){
+      from = seedfile + "_" + tag + ".txt";
+      if( rename( from.c_str(), ( seedfile + ".txt" ).c_str() ) != 0 )
+         cout << "ERROR:  cannot move " << from << " to " << seedfile << ".txt" << endl;
+   }
+}
+
+}
+
+void runRndFits(FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile, int numRnd, double maxFraction) {
+   const FitOptions& options = session.options();
+
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   AmpToolsInterface ati( cfgInfo );
+   FitSession::TelemetryScope telemetryScope( session, ati );
+   FitSession::CheckpointScope checkpointScope( session, ati );
+   LikelihoodMemo memo( ati );
+   session.reportMemory( ati, cfgInfo );
+   string fitName = cfgInfo->fitName();
+
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << LikelihoodMemo::likelihood( ati ) << endl;
+   if( session.normIntCache() != NULL ) session.normIntCache()->store( ati );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+
+   ProductionPreFit* preFit = session.makePreFit( ati, cfgInfo );
+   FitSession::CoarseScope coarseScope( session, ati, cfgInfo );
+   FitSession::HypercubeScope hypercubeScope( session, ati, cfgInfo, maxFraction, numRnd );
+
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   fitManager->setMaxIterations(options.maxIter);
+
+   vector< vector<string> > parRangeKeywords = cfgInfo->userKeywordArguments("parRange");
+
+   // keep track of best fit (mininum log-likelihood)
+   double minLL = 0;
+   int minFitTag = -1;
+   vector< RndFitResult > results;
+   vector< vector<double> > values;
+   FitCheckpoint* checkpoint = session.checkpoint();
+
+   for(int i=0; i<numRnd; i++) {
+
+      RndFitResult result;
+      result.tag = i;
+
+      // the fits that an earlier job finished only count for the best fit,
+      // which that job has written
+      if( checkpoint != NULL && checkpoint->finished( i ) ) {
+         const pair< bool, double >& done = checkpoint->finishedFits().find( i )->second;
+         cout << "FIT " << i << " IS DONE IN THE CHECKPOINT" << endl;
+         if( !done.first && done.second < minLL ) {
+            minLL = done.second;
+            minFitTag = i;
+         }
+         result.failed = done.first;
+         result.likelihood = done.second;
+         results.push_back( result );
+         values.push_back( vector<double>() );
+         continue;
+      }
+
+      // with a checkpoint the starting point of a restart does not depend
+      // on the fits before it, which a resumed job skips
+      if( checkpoint != NULL ) seedRandom( i + 1 );
+
+      result.failed = runRndFit(session, ati, preFit, parRangeKeywords, maxFraction, minLL, i, numRnd);
+      result.likelihood = LikelihoodMemo::likelihood( ati );
+      results.push_back( result );
+      values.push_back( options.distinctTolerance > 0 ? floatingParameters( ati ) : vector<double>() );
+
+      // update best fit, which is written right away
+      bool best = ( !result.failed && result.likelihood < minLL );
+      if( best ) {
+         minLL = result.likelihood;
+         minFitTag = i;
+      }
+      writeRndFit(session, ati, seedfile, i, result.failed, best, "");
+
+      session.checkpointFit( i, result.failed, result.likelihood );
+   }
+
+   reportBestRndFit(numRnd, minFitTag, minLL);
+   writeRestartTable(fitName, results, options.distinctTolerance > 0 ?
+                     groupMinima( results, values, options.distinctTolerance ) : vector<int>());
+
+   delete preFit;
+}
+
+void runRndFitsParallel(FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile, int numRnd, double maxFraction) {
+   const FitOptions& options = session.options();
+   string fitName = cfgInfo->fitName();
+   vector< vector<string> > parRangeKeywords = cfgInfo->userKeywordArguments("parRange");
+
+   int numWorkers = min( options.numWorkers, numRnd );
+
+   AmpToolsInterface* ati = NULL;
+   ProductionPreFit* preFit = NULL;
+#ifndef GPU_ACCELERATION
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+   ati = new AmpToolsInterface( cfgInfo );
+   session.reportMemory( *ati, cfgInfo );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
+   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati->likelihood() << endl;
+   if( session.normIntCache() != NULL ) session.normIntCache()->store( *ati );
+   AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+   preFit = session.makePreFit( *ati, cfgInfo );
+#endif
+
+   // leaderboard of the converged fits, best first
+   multimap< double, int > leaderboard;
+   vector< RndFitResult > results;
+   int nDone = 0, nFailed = 0, nPruned = 0;
+
+   runWorkers< RndFitResult >( session, numWorkers,
+      [&]( int w, int fd ){
+
+         if( ati == NULL ){
+            AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
+            ati = new AmpToolsInterface( cfgInfo );
+            AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+            preFit = session.makePreFit( *ati, cfgInfo );
+         }
+         ati->minuitMinimizationManager()->setMaxIterations(options.maxIter);
+         FitSession::TelemetryScope telemetryScope( session, *ati, Form("worker%d", w) );
+         FitSession::CheckpointScope checkpointScope( session, *ati, Form("worker%d", w) );
+         FitSession::CoarseScope coarseScope( session, *ati, cfgInfo );
+         FitSession::HypercubeScope hypercubeScope( session, *ati, cfgInfo, maxFraction, numRnd );
+         FitCheckpoint* checkpoint = session.checkpoint();
+
+         // every worker writes the best of its own restarts, the parent
+         // moves that of the best worker
+         double minLL = 0;
+
+         for(int i=w; i<numRnd; i+=numWorkers) {
+
+            RndFitResult result;
+            result.tag = i;
+
+            // the fits that an earlier job finished are reported as they were
+            if( checkpoint != NULL && checkpoint->finished( i ) ) {
+               const pair< bool, double >& done = checkpoint->finishedFits().find( i )->second;
+               result.failed = done.first;
+               result.likelihood = done.second;
+               reportResult( fd, result );
+               continue;
+            }
+
+            seedRandom( i + 1 );
+
+            result.failed = runRndFit(session, *ati, preFit, parRangeKeywords, maxFraction, minLL, i, numRnd);
+            result.likelihood = ati->likelihood();
+
+            bool best = ( !result.failed && result.likelihood < minLL );
+            if( best ) minLL = result.likelihood;
+            writeRndFit(session, *ati, seedfile, i, result.failed, best, Form("worker%d", w));
+            session.checkpointFit( i, result.failed, result.likelihood );
+
+            reportResult( fd, result );
+         }
+      },
+      [&]( const RndFitResult& result ){
+
+         ++nDone;
+         results.push_back( result );
+         if( result.failed == kFitPruned ) ++nPruned;
+         else if( result.failed ) ++nFailed;
+         else leaderboard.insert( make_pair( result.likelihood, result.tag ) );
+
+         cout << "FINISHED FIT " << result.tag << " (" << nDone << " OF " << numRnd << "):  "
+              << ( result.failed == kFitPruned ? "PRUNED" : result.failed ? "FAILED" : Form("LIKELIHOOD = %f", result.likelihood) );
+         if( !leaderboard.empty() )
+            cout << "   BEST SO FAR " << leaderboard.begin()->second << ":  " << leaderboard.begin()->first;
+         cout << endl;
+      } );
+
+   if( nDone < numRnd )
+      cout << "ERROR:  only " << nDone << " of " << numRnd << " fits reported a result" << endl;
+
+   cout << endl << "LEADERBOARD (" << nFailed << " FAILED FITS, " << nPruned << " PRUNED):" << endl;
+   int rank = 0;
+   for( multimap< double, int >::iterator it = leaderboard.begin();
+        it != leaderboard.end() && rank < 10; ++it, ++rank )
+      cout << "   " << rank + 1 << ".  FIT " << it->second << ":  " << it->first << endl;
+
+   if( leaderboard.empty() ) reportBestRndFit(numRnd, -1, 0);
+   else {
+      int best = leaderboard.begin()->second;
+      reportBestRndFit(numRnd, best, leaderboard.begin()->first);
+
+      // a best fit that an earlier job finished was written by that job
+      if( session.checkpoint() == NULL || !session.checkpoint()->finished( best ) )
+         moveBestRndFit(fitName, seedfile, Form("worker%d", best % numWorkers));
+   }
+   for(int w=0; w<numWorkers; w++) {
+      remove( Form("%s_worker%d.fit", fitName.data(), w) );
+      for( const char* companion : FitSession::fitCompanions )
+         remove( Form("%s_worker%d%s", fitName.data(), w, companion) );
+      if( seedfile.size() != 0 ) remove( Form("%s_worker%d.txt", seedfile.data(), w) );
+   }
+
+   sort( results.begin(), results.end(),
+         []( const RndFitResult& a, const RndFitResult& b ){ return a.tag < b.tag; } );
+   writeRestartTable(fitName, results);
+
+   delete preFit;
+   delete ati;
+}
@@ -0,0 +1,37 @@
+#if !defined(RANDOMRESTARTS)
+#define RANDOMRESTARTS
+
+#include <string>
+
+using namespace std;
+
+class ConfigurationInfo;
+class FitSession;
+
+/**
+ * The random restarts of -r:  numRnd fits of cfgInfo, each from random
+ * production parameters (at most maxFraction of the intensity in any one
+ * amplitude) and random parameters of the parRange keywords, or from the
+ * points of the hypercube of --lhs.  The best restart is written to
+ * <fitName>.fit and <seedfile>.txt and every restart to a line of
+ * <fitName>_restarts.txt; with --keep-restarts every restart is written.
+ *
+ * runRndFits fits the restarts one after the other.  runRndFitsParallel
+ * runs them in the workers of -w:  on the CPU the workers are forked after
+ * the data have been read and the normalization integrals computed, so
+ * all of them share those pages (copy-on-write) and only hold their own
+ * parameter state; a GPU context cannot be shared by a forked process, so
+ * with GPU acceleration every worker builds its own AmpToolsInterface.
+ * Worker w runs the restarts w, w + numWorkers, ... and reports each
+ * result through a pipe; the parent keeps the leaderboard.  Restart i is
+ * seeded with i + 1, so the starting points do not depend on the number of
+ * workers.
+ */
+
+void runRndFits( FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile,
+                 int numRnd, double maxFraction );
+
+void runRndFitsParallel( FitSession& session, ConfigurationInfo* cfgInfo, const string& seedfile,
+                         int numRnd, double maxFraction );
+
+#endif
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <cassert>
+#include <stdint.h>
+
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+
+#include "SubsampleSampler.h"
+
+SubsampleSampler::SubsampleSampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo, double maxFraction )
+{
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    // integrals that do not change during the fit are not subsampled
+    bool fixedIntegrals = reactions[i]->normIntFileInput() || reactions[i]->accMC().first.empty() ||
+                          !NormIntCache::key( cfgInfo, reactions[i] ).empty();
+
+    for( int acc = 0; acc < ( fixedIntegrals ? 1 : 2 ); ++acc ){
+
+      Sample* sample = new Sample;
+      sample->reaction = reactions[i]->reactionName();
+      sample->accMC = ( acc == 1 );
+      sample->source = ( acc == 1 ? reactions[i]->accMC() : reactions[i]->data() );
+      sample->nPart = 0;
+      sample->fraction = maxFraction;
+      sample->next = 0;
+
+      unsigned int index = 2 * i + acc;
+
+      DataReader* reader = ( acc == 1 ? ati.accMCReader( sample->reaction ) :
+                                        ati.dataReader( sample->reaction ) );
+      assert( reader != NULL );
+      reader->resetSource();
+
+      unsigned int nEvents = 0;
+      Kinematics* event;
+      while( ( event = reader->getEvent() ) != NULL ){
+
+        double u = uniform( index, nEvents++ );
+        if( u >= maxFraction ){
+
+          delete event;
+          continue;
+        }
+
+        const vector< TLorentzVector >& particles = event->particleList();
+        if( sample->weight.empty() ) sample->nPart = particles.size();
+        assert( static_cast< int >( particles.size() ) == sample->nPart );
+
+        for( int j = 0; j < sample->nPart; ++j ){
+
+          sample->p4.push_back( particles[j].E() );
+          sample->p4.push_back( particles[j].Px() );
+          sample->p4.push_back( particles[j].Py() );
+          sample->p4.push_back( particles[j].Pz() );
+        }
+        sample->weight.push_back( event->weight() );
+        sample->u.push_back( u );
+
+        delete event;
+      }
+      reader->resetSource();
+
+      cout << "SubsampleSampler:  " << sample->weight.size() << " of " << nEvents
+           << ( sample->accMC ? " accepted MC" : " data" ) << " events of reaction "
+           << sample->reaction << " kept for the subsamples" << endl;
+
+      // the readers of the fits read the current subsample, and again
+      // from its start if the framework reads the events more than once
+      string name = ( sample->accMC ? "subsample_acc_" : "subsample_data_" ) + sample->reaction;
+      StreamDataReader::registerSource( name,
+        [sample]( vector< TLorentzVector >& particles, float& weight ){
+
+          unsigned int nKept = sample->weight.size();
+          while( sample->next < nKept && sample->u[sample->next] >= sample->fraction ) ++sample->next;
+
+          if( sample->next == nKept ){
+
+            sample->next = 0;
+            return false;
+          }
+
+          const float* p = &sample->p4[sample->next * 4 * sample->nPart];
+
+          particles.resize( sample->nPart );
+          for( int j = 0; j < sample->nPart; ++j, p += 4 )
+            particles[j].SetPxPyPzE( p[1], p[2], p[3], p[0] );
+
+          weight = sample->weight[sample->next++] / sample->fraction;
+          return true;
+        } );
+
+      m_samples.push_back( sample );
+    }
+  }
+}
+
+void
+SubsampleSampler::setFraction( double fraction )
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    m_samples[i]->fraction = fraction;
+    m_samples[i]->next = 0;
+  }
+}
+
+void
+SubsampleSampler::useSubsample( ConfigurationInfo* cfgInfo ) const
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    const Sample* sample = m_samples[i];
+    ReactionInfo* reaction = cfgInfo->reaction( sample->reaction );
+
+    if( sample->accMC )
+      reaction->setAccMC( "StreamDataReader",
+                          vector< string >( 1, "callback:subsample_acc_" + sample->reaction ) );
+    else
+      reaction->setData( "StreamDataReader",
+                         vector< string >( 1, "callback:subsample_data_" + sample->reaction ) );
+  }
+}
+
+void
+SubsampleSampler::useFullSample( ConfigurationInfo* cfgInfo ) const
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    const Sample* sample = m_samples[i];
+    ReactionInfo* reaction = cfgInfo->reaction( sample->reaction );
+
+    if( sample->accMC ) reaction->setAccMC( sample->source.first, sample->source.second );
+    else reaction->setData( sample->source.first, sample->source.second );
+  }
+}
+
+double
+SubsampleSampler::uniform( unsigned int sample, unsigned int event )
+{
+  // the finalizer of splitmix64 on the sample and the event, as for the
+  // counts of BootstrapSampler
+  uint64_t z = ( (uint64_t)sample + 1 ) * 0x9E3779B97F4A7C15ULL ^
+               ( (uint64_t)event + 1 ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  z = z ^ ( z >> 31 );
+  return ( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
@@ -0,0 +1,73 @@
+#if !defined(SUBSAMPLESAMPLER)
+#define SUBSAMPLESAMPLER
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * Deterministic subsamples of the data and the accepted MC for the early
+ * stages of a fit.  Every event has a fixed uniform number, a hash of its
+ * sample and its index, and the subsample of a fraction f keeps the events
+ * whose number is below f with their weights divided by f.  The sums over
+ * a subsample are unbiased estimates of the sums over all events, so its
+ * minimum estimates the same parameters, and the subsample of a smaller
+ * fraction is part of that of a larger one.
+ *
+ * The events below the largest fraction are read once and kept in memory;
+ * the fits read them through StreamDataReader as "callback:subsample_data_
+ * <reaction>" and "callback:subsample_acc_<reaction>".  The background is
+ * not subsampled, nor are the accepted MC of reactions whose integrals do
+ * not change during the fit (read from a file or cached with -N).
+ */
+
+class SubsampleSampler
+{
+
+public:
+
+  /**
+   * Keeps the events for subsamples of up to maxFraction.
+   */
+  SubsampleSampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo, double maxFraction );
+
+  // the fraction of the subsample that the fits read
+  void setFraction( double fraction );
+
+  /**
+   * Makes the reactions of cfgInfo read the subsample, or again all events.
+   */
+  void useSubsample( ConfigurationInfo* cfgInfo ) const;
+  void useFullSample( ConfigurationInfo* cfgInfo ) const;
+
+  // the uniform number in [0, 1) of event of sample
+  static double uniform( unsigned int sample, unsigned int event );
+
+private:
+
+  struct Sample {
+
+    string reaction;
+    bool accMC;
+    pair< string, vector< string > > source;
+    int nPart;
+
+    // E, Px, Py, Pz of every particle of every kept event, its weight and
+    // its uniform number
+    vector< float > p4;
+    vector< float > weight;
+    vector< double > u;
+
+    double fraction;
+    unsigned int next;
+  };
+
+  vector< Sample* > m_samples;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cassert>
+
+#include "TRandom3.h"
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+
+#include "ToySampler.h"
+
+ToySampler::ToySampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo )
+{
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  for( unsigned int i = 0; i < reactions.size(); ++i ){
+
+    Sample* sample = new Sample;
+    sample->reaction = reactions[i]->reactionName();
+    sample->nPart = 0;
+    sample->maxIntensity = 0;
+    sample->next = 0;
+
+    DataReader* data = ati.dataReader( sample->reaction );
+    assert( data != NULL );
+    sample->nData = data->numEvents();
+
+    if( !reactions[i]->bkgnd().first.empty() )
+      cout << "ToySampler:  the toys of reaction " << sample->reaction
+           << " have no background" << endl;
+
+    ati.loadEvents( ati.accMCReader( sample->reaction ) );
+    ati.processEvents( sample->reaction );
+
+    int nEvents = ati.numEvents();
+    sample->intensity.resize( nEvents );
+
+    for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      Kinematics* event = ati.kinematics( iEvent );
+      const vector< TLorentzVector >& particles = event->particleList();
+      if( iEvent == 0 ) sample->nPart = particles.size();
+      assert( static_cast< int >( particles.size() ) == sample->nPart );
+
+      for( int j = 0; j < sample->nPart; ++j ){
+
+        sample->p4.push_back( particles[j].E() );
+        sample->p4.push_back( particles[j].Px() );
+        sample->p4.push_back( particles[j].Py() );
+        sample->p4.push_back( particles[j].Pz() );
+      }
+
+      double intensity = ati.intensity( iEvent ) * event->weight();
+      if( intensity < 0 ) intensity = 0;
+
+      sample->intensity[iEvent] = intensity;
+      if( intensity > sample->maxIntensity ) sample->maxIntensity = intensity;
+    }
+
+    ati.clearEvents();
+
+    if( sample->maxIntensity <= 0 ){
+
+      cout << "ToySampler ERROR:  the intensity of reaction " << sample->reaction
+           << " vanishes on the accepted MC" << endl;
+      assert( false );
+    }
+
+    cout << "ToySampler:  " << nEvents << " accepted MC events for the toys of reaction "
+         << sample->reaction << " with " << sample->nData << " data events" << endl;
+
+    // the readers of the toy fits read the current draw, and again from
+    // its start if the framework reads the data more than once
+    StreamDataReader::registerSource( "toy_" + sample->reaction,
+      [sample]( vector< TLorentzVector >& particles, float& weight ){
+
+        if( sample->next == sample->drawn.size() ){
+
+          sample->next = 0;
+          return false;
+        }
+
+        const float* p = &sample->p4[sample->drawn[sample->next++] * 4 * sample->nPart];
+
+        particles.resize( sample->nPart );
+        for( int j = 0; j < sample->nPart; ++j, p += 4 )
+          particles[j].SetPxPyPzE( p[1], p[2], p[3], p[0] );
+
+        weight = 1.0;
+        return true;
+      } );
+
+    m_samples.push_back( sample );
+  }
+}
+
+void
+ToySampler::draw( unsigned int seed )
+{
+  TRandom3 random( seed );
+
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    Sample* sample = m_samples[i];
+
+    unsigned int nToy = random.Poisson( sample->nData );
+    unsigned int nMC = sample->intensity.size();
+
+    sample->drawn.clear();
+    sample->next = 0;
+
+    while( sample->drawn.size() < nToy ){
+
+      unsigned int iEvent = static_cast< unsigned int >( random.Integer( nMC ) );
+      if( random.Uniform() * sample->maxIntensity < sample->intensity[iEvent] )
+        sample->drawn.push_back( iEvent );
+    }
+  }
+}
+
+void
+ToySampler::useToys( ConfigurationInfo* cfgInfo ) const
+{
+  for( unsigned int i = 0; i < m_samples.size(); ++i ){
+
+    ReactionInfo* reaction = cfgInfo->reaction( m_samples[i]->reaction );
+    reaction->setData( "StreamDataReader",
+                       vector< string >( 1, "callback:toy_" + m_samples[i]->reaction ) );
+  }
+}
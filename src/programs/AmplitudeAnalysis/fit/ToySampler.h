@@ -0,0 +1,66 @@
+#if !defined(TOYSAMPLER)
+#define TOYSAMPLER
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class AmpToolsInterface;
+class ConfigurationInfo;
+
+/**
+ * The pseudo-data of a toy study.  The intensity of every accepted MC
+ * event of every reaction is computed once, at the current parameters of
+ * the AmpToolsInterface (the truth of the study), and the events are kept
+ * in memory.  Each toy is then drawn by accept-reject from these events,
+ * with a Poisson number of events around the size of the data sample, and
+ * read by the fits through StreamDataReader as "callback:toy_<reaction>",
+ * so no file is written and nothing is read from disk again.
+ *
+ * The toys reuse the accepted MC events, so the pseudo-data and the
+ * normalization integrals are not independent samples; the accepted MC
+ * should be much larger than the data for the study to be meaningful.
+ */
+
+class ToySampler
+{
+
+public:
+
+  ToySampler( AmpToolsInterface& ati, ConfigurationInfo* cfgInfo );
+
+  /**
+   * Draws the pseudo-data of every reaction; the toys only depend on the
+   * seed.
+   */
+  void draw( unsigned int seed );
+
+  /**
+   * Makes the reactions of cfgInfo read the pseudo-data of the last draw.
+   */
+  void useToys( ConfigurationInfo* cfgInfo ) const;
+
+private:
+
+  struct Sample {
+
+    string reaction;
+    int nPart;
+    double nData;
+    double maxIntensity;
+
+    // E, Px, Py, Pz of every particle of every accepted MC event and the
+    // intensity of the event times its weight
+    vector< float > p4;
+    vector< double > intensity;
+
+    // the events of the current toy and the next one to read
+    vector< unsigned int > drawn;
+    unsigned int next;
+  };
+
+  vector< Sample* > m_samples;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+
+#include "ProductionPreFit.h"
+#include "VariableProjection.h"
+
+VariableProjection::VariableProjection( ProductionPreFit& preFit, const string& heldPar ) :
+  m_preFit( preFit ),
+  m_nEvaluations( 0 )
+{
+  vector< ParameterInfo* > pars = preFit.configurationInfo()->parameterList();
+  for( unsigned int i = 0; i < pars.size(); ++i )
+    if( !pars[i]->fixed() && pars[i]->parName() != heldPar ) m_pars.push_back( pars[i] );
+}
+
+bool
+VariableProjection::valid() const {
+
+  return m_preFit.valid() && !m_pars.empty();
+}
+
+double
+VariableProjection::profile( vector< double >& y ){
+
+  ParameterManager* parMgr = m_preFit.ati().parameterManager();
+
+  for( unsigned int i = 0; i < m_pars.size(); ++i ){
+
+    if( m_pars[i]->bounded() )
+      y[i] = max( m_pars[i]->lowerBound(), min( m_pars[i]->upperBound(), y[i] ) );
+    parMgr->setAmpParameter( m_pars[i]->parName(), y[i] );
+  }
+
+  ++m_nEvaluations;
+  m_preFit.refresh();
+  m_preFit.minimize( 500, false );
+
+  // the likelihood of the framework includes the constraints of the
+  // amplitude parameters, which the cached model does not
+  return m_preFit.ati().likelihood();
+}
+
+double
+VariableProjection::minimize( int maxIter ){
+
+  if( !valid() ) return m_preFit.ati().likelihood();
+
+  int n = m_pars.size();
+  m_nEvaluations = 0;
+
+  // the simplex starts at the current values and one step along each
+  // parameter:  5% of the value, or of the range of a bounded parameter
+  vector< vector< double > > simplex( n + 1, vector< double >( n ) );
+  for( int i = 0; i < n; ++i ) simplex[0][i] = m_pars[i]->value();
+
+  for( int k = 0; k < n; ++k ){
+
+    simplex[k + 1] = simplex[0];
+    double step = 0.05 * fabs( simplex[0][k] );
+    if( m_pars[k]->bounded() )
+      step = 0.05 * ( m_pars[k]->upperBound() - m_pars[k]->lowerBound() );
+    if( step == 0 ) step = 0.01;
+    if( m_pars[k]->bounded() && simplex[0][k] + step > m_pars[k]->upperBound() ) step = -step;
+    simplex[k + 1][k] += step;
+  }
+
+  vector< double > f( n + 1 );
+  for( int k = 0; k <= n; ++k ) f[k] = profile( simplex[k] );
+  double fStart = f[0];
+
+  vector< int > order( n + 1 );
+  vector< double > centroid( n ), trial( n ), trial2( n );
+  int iter = 0;
+
+  for( ; iter < maxIter; ++iter ){
+
+    for( int k = 0; k <= n; ++k ) order[k] = k;
+    sort( order.begin(), order.end(), [&]( int a, int b ){ return f[a] < f[b]; } );
+
+    int best = order[0], worst = order[n], second = order[n - 1];
+    if( f[worst] - f[best] <= 1e-6 * ( 1 + fabs( f[best] ) ) ) break;
+
+    for( int i = 0; i < n; ++i ){
+
+      centroid[i] = 0;
+      for( int k = 0; k <= n; ++k ) if( k != worst ) centroid[i] += simplex[k][i] / n;
+    }
+
+    // reflection, expansion, contraction or shrink towards the best point
+    for( int i = 0; i < n; ++i ) trial[i] = centroid[i] + ( centroid[i] - simplex[worst][i] );
+    double fTrial = profile( trial );
+
+    if( fTrial < f[best] ){
+
+      for( int i = 0; i < n; ++i ) trial2[i] = centroid[i] + 2 * ( centroid[i] - simplex[worst][i] );
+      double fTrial2 = profile( trial2 );
+      if( fTrial2 < fTrial ){ simplex[worst] = trial2; f[worst] = fTrial2; }
+      else{ simplex[worst] = trial; f[worst] = fTrial; }
+    }
+    else if( fTrial < f[second] ){
+
+      simplex[worst] = trial; f[worst] = fTrial;
+    }
+    else{
+
+      bool outside = ( fTrial < f[worst] );
+      const vector< double >& from = ( outside ? trial : simplex[worst] );
+      for( int i = 0; i < n; ++i ) trial2[i] = centroid[i] + 0.5 * ( from[i] - centroid[i] );
+      double fTrial2 = profile( trial2 );
+
+      if( fTrial2 < min( fTrial, f[worst] ) ){ simplex[worst] = trial2; f[worst] = fTrial2; }
+      else{
+
+        for( int k = 0; k <= n; ++k ){
+
+          if( k == best ) continue;
+          for( int i = 0; i < n; ++i ) simplex[k][i] = simplex[best][i] + 0.5 * ( simplex[k][i] - simplex[best][i] );
+          f[k] = profile( simplex[k] );
+        }
+      }
+    }
+  }
+
+  int best = min_element( f.begin(), f.end() ) - f.begin();
+  double fBest = profile( simplex[best] );
+
+  cout << "VariableProjection:  " << n << " amplitude parameters, -2 ln L " << fStart
+       << " -> " << fBest << " in " << iter << " iterations, " << m_nEvaluations
+       << " profiled likelihoods" << endl;
+
+  return fBest;
+}
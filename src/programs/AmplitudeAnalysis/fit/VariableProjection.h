@@ -0,0 +1,62 @@
+#if !defined(VARIABLEPROJECTION)
+#define VARIABLEPROJECTION
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class ParameterInfo;
+class ProductionPreFit;
+
+/**
+ * A minimization of -2 ln L in the free amplitude parameters (BreitWigner
+ * masses and widths, Piecewise bins, Dalitz parameters, ...) with the
+ * production parameters projected out:  for every value of the amplitude
+ * parameters the production parameters are moved to their minimum by
+ * ProductionPreFit, which is cheap because they enter the likelihood
+ * through a quadratic form in the cached decay amplitudes.  The outer
+ * minimization therefore only sees the handful of amplitude parameters,
+ * whose likelihood surface has far fewer local minima than the one of all
+ * parameters together.
+ *
+ * The outer minimization is a Nelder-Mead simplex, which needs no gradient
+ * of the profiled likelihood; bounds of the parameters are respected.
+ * Every step reloads the decay amplitudes (ProductionPreFit::refresh), so
+ * each one costs about a pass over the data and the integrals.  MIGRAD
+ * varies all parameters afterwards, so the result and its errors are those
+ * of MIGRAD.
+ */
+
+class VariableProjection
+{
+
+public:
+
+  /**
+   * The amplitude parameters that are free in the configuration of the
+   * pre-fit, except heldPar (e.g., the parameter of a scan).
+   */
+  VariableProjection( ProductionPreFit& preFit, const string& heldPar = "" );
+
+  bool valid() const;
+
+  /**
+   * Moves the amplitude and production parameters to the minimum of the
+   * profiled likelihood and returns the likelihood there.
+   */
+  double minimize( int maxIter = 200 );
+
+private:
+
+  // sets the amplitude parameters and returns the likelihood at the
+  // minimum in the production parameters
+  double profile( vector< double >& y );
+
+  ProductionPreFit& m_preFit;
+
+  vector< ParameterInfo* > m_pars;
+  int m_nEvaluations;
+};
+
+#endif
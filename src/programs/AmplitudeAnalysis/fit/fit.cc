@@ -1,240 +1,101 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <complex>
 #include <string>
 #include <vector>
-#include <utility>
-#include <map>
+#include <cstdlib>
+#include <algorithm>
 
-#include "TSystem.h"
+#include <unistd.h>
 
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBinned.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
-#include "AMPTOOLS_AMPS/TwoPSAngles.h"
-#include "AMPTOOLS_AMPS/TwoPSHelicity.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles_amp.h"
-#include "AMPTOOLS_AMPS/TwoPiWt_primakoff.h"
-#include "AMPTOOLS_AMPS/TwoPiWt_sigma.h"
-#include "AMPTOOLS_AMPS/TwoPiW_brokenetas.h"
-#include "AMPTOOLS_AMPS/TwoPitdist.h"
-#include "AMPTOOLS_AMPS/TwoPiNC_tdist.h"
-#include "AMPTOOLS_AMPS/TwoPiEtas_tdist.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles_primakoff.h"
-#include "AMPTOOLS_AMPS/ThreePiAngles.h"
-#include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
-#include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.h"
-#include "AMPTOOLS_AMPS/Zlm.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
-#include "AMPTOOLS_AMPS/BreitWigner3body.h"
-#include "AMPTOOLS_AMPS/b1piAngAmp.h"
-#include "AMPTOOLS_AMPS/omegapiAngAmp.h"
-#include "AMPTOOLS_AMPS/Uniform.h"
-#include "AMPTOOLS_AMPS/polCoef.h"
-#include "AMPTOOLS_AMPS/dblRegge.h"
-#include "AMPTOOLS_AMPS/dblReggeMod.h"
-#include "AMPTOOLS_AMPS/omegapi_amplitude.h"
-#include "AMPTOOLS_AMPS/Vec_ps_refl.h"
-#include "AMPTOOLS_AMPS/Piecewise.h"
-
-#include "MinuitInterface/MinuitMinimizationManager.h"
-#include "IUAmpTools/AmpToolsInterface.h"
-#include "IUAmpTools/FitResults.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderFlat.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderPipeline.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderGrid.h"
+#include "AMPTOOLS_DATAIO/SignedDataReader.h"
+#include "AMPTOOLS_DATAIO/BinaryDataReader.h"
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+#include "AMPTOOLS_DATAIO/PhaseSpaceDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_DATAIO/ChunkedNormInt.h"
+#include "AMPTOOLS_DATAIO/FitProjections.h"
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+#include "AMPTOOLS_AMPS/UserVarsCache.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
+
 #include "IUAmpTools/ConfigFileParser.h"
 #include "IUAmpTools/ConfigurationInfo.h"
 
-using std::complex;
-using namespace std;
-
-double runSingleFit(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile) {
-   AmpToolsInterface ati( cfgInfo );
-
-   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
-
-   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
-   fitManager->setMaxIterations(maxIter);
-
-   if( useMinos ){
-
-      fitManager->minosMinimization();
-   }
-   else{
-
-      fitManager->migradMinimization();
-   }
-
-   bool fitFailed =
-      ( fitManager->status() != 0 && fitManager->eMatrixStatus() != 3 );
-
-   if( fitFailed ){
-      cout << "ERROR: fit failed use results with caution..." << endl;
-      return 1e6;
-   }
-
-   cout << "LIKELIHOOD AFTER MINIMIZATION:  " << ati.likelihood() << endl;
-
-   ati.finalizeFit();
-
-   if( seedfile.size() != 0 && !fitFailed ){
-      ati.fitResults()->writeSeed( seedfile );
-   }
-
-   return ati.likelihood();
-}
-
-void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, int numRnd, double maxFraction) {
-   AmpToolsInterface ati( cfgInfo );
-   string fitName = cfgInfo->fitName();
-
-   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
-
-   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
-   fitManager->setMaxIterations(maxIter);
-
-   vector< vector<string> > parRangeKeywords = cfgInfo->userKeywordArguments("parRange");
-
-   // keep track of best fit (mininum log-likelihood)
-   double minLL = 0;
-   int minFitTag = -1;
-
-   for(int i=0; i<numRnd; i++) {
-      cout << endl << "###############################" << endl;
-      cout << "FIT " << i << " OF " << numRnd << endl;
-      cout << endl << "###############################" << endl;
-
-      // randomize parameters
-      ati.randomizeProductionPars(maxFraction);
-      for(size_t ipar=0; ipar<parRangeKeywords.size(); ipar++) {
-         ati.randomizeParameter(parRangeKeywords[ipar][0], atof(parRangeKeywords[ipar][1].c_str()), atof(parRangeKeywords[ipar][2].c_str()));
-      }
-
-      if(useMinos)
-         fitManager->minosMinimization();
-      else
-         fitManager->migradMinimization();
-
-      bool fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
-
-      if( fitFailed )
-         cout << "ERROR: fit failed use results with caution..." << endl;
-
-      cout << "LIKELIHOOD AFTER MINIMIZATION:  " << ati.likelihood() << endl;
-
-      ati.finalizeFit(to_string(i));
-
-      if( seedfile.size() != 0 && !fitFailed ){
-         string seedfile_rand = seedfile + Form("_%d.txt", i);
-         ati.fitResults()->writeSeed( seedfile_rand );
-      }
-
-      // update best fit
-      if( !fitFailed && ati.likelihood() < minLL ) {
-         minLL = ati.likelihood();
-         minFitTag = i;
-      }
-   }
-
-   // print best fit results
-   if(minFitTag < 0) cout << "ALL FITS FAILED!" << endl;
-   else {
-      cout << "MINIMUM LIKELIHOOD FROM " << minFitTag << " of " << numRnd << " RANDOM PRODUCTION PARS = " << minLL << endl;
-      gSystem->Exec(Form("cp %s_%d.fit %s.fit", fitName.data(), minFitTag, fitName.data()));
-      if( seedfile.size() != 0 )
-         gSystem->Exec(Form("cp %s_%d.txt %s.txt", seedfile.data(), minFitTag, seedfile.data()));
-   }
-}
-
-void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, string parScan) {
-   double minVal=0, maxVal=0, stepSize=0;
-   int steps=0;
-
-   vector< vector<string> > parScanKeywords = cfgInfo->userKeywordArguments("parScan");
-
-   if(parScanKeywords.size()==0) {
-      cout << "No parScan keyword found in configuration file. Set up at least one parameter for scanning! Aborting." << endl;
-      return;
-   } else {
-      for(size_t ipar=0; ipar<parScanKeywords.size(); ipar++) {
-         if(parScanKeywords[ipar][0]==parScan) {
-            minVal = atof(parScanKeywords[ipar][1].c_str());
-            maxVal = atof(parScanKeywords[ipar][2].c_str());
-            stepSize = atof(parScanKeywords[ipar][3].c_str());
-            steps = trunc((maxVal-minVal)/stepSize)+1;
-            break;
-         } else
-            cout << "Skipping configuration to scan " << parScanKeywords[ipar][0] << "since scanning of " << parScan << " was requested..." << endl;
-      }
-   }
-
-   AmpToolsInterface ati( cfgInfo );
-
-   string fitName = cfgInfo->fitName();
-   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
-
-   ParameterManager* parMgr = ati.parameterManager();
-   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
-   fitManager->setMaxIterations(maxIter);
-
-
-   for(int i=0; i<steps; i++) {
-      cout << endl << "###############################" << endl;
-      cout << "FIT " << i << " OF " << steps << endl;
-      cout << endl << "###############################" << endl;
-
-      // set parameter to be scanned
-      vector<ParameterInfo*> parInfoVec = cfgInfo->parameterList();
-
-      auto parItr = parInfoVec.begin();
-      for( ; parItr != parInfoVec.end(); ++parItr ) {
-         if( (**parItr).parName() == parScan ) break;
-      }
-
-      if( parItr == parInfoVec.end() ){
-         cout << "ERROR:  request to scan nonexistent parameter:  " << parScan << endl;
-         return;
-      }
+#include "ImportanceSampler.h"
+#include "FitOptions.h"
+#include "FitSession.h"
+#include "RandomRestarts.h"
+#include "ParameterScan.h"
+#include "FitStudies.h"
+#include "ChainedFits.h"
+#include "FitServer.h"
 
-      // set and fix parameter for scan
-      double value = minVal + i*stepSize;
-      parMgr->setAmpParameter( parScan, value );
-
-      cfgInfo->setFitName(fitName + "_scan");
-
-      if(useMinos)
-         fitManager->minosMinimization();
-      else
-         fitManager->migradMinimization();
-
-      bool fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
-
-      if( fitFailed )
-         cout << "ERROR: fit failed use results with caution..." << endl;
-
-      cout << "LIKELIHOOD AFTER MINIMIZATION:  " << ati.likelihood() << endl;
+using namespace std;
 
-      ati.finalizeFit(to_string(i));
-
-      if( seedfile.size() != 0 && !fitFailed ){
-         string seedfile_scan = seedfile + Form("_scan_%d.txt", i);
-         ati.fitResults()->writeSeed( seedfile_scan );
-      }
-   }
-}
+// The modes of a fit are in their own files:  the single fit and what the
+// fits share in FitSession, the random restarts of -r in RandomRestarts,
+// the scan of -p in ParameterScan, the toys, bootstrap and importance
+// sampling in FitStudies, --follow and --binned-check in ChainedFits, and
+// --serve and --submit in FitServer.  The options of the command line that
+// they use are a FitOptions, which main fills and hands to the session.
 
 int main( int argc, char* argv[] ){
 
    // set default parameters
 
-   bool useMinos = false;
+   FitOptions options;
 
    string configfile;
+   string listfile;
    string seedfile;
+   string normIntDir;
+   unsigned int normIntChunk = 0;
+   bool deferGenMC = false;
    string scanPar;
    int numRnd = 0;
-   int maxIter = 10000;
+   int numToys = 0;
+   int numReplicas = 0;
+   double importanceFraction = 0;
+   bool outwardScan = false;
+   bool checkBinned = false;
+   string serveSocket;
+   string submitSocket;
+
+   // with -j the user variables and amplitudes of the events are computed on
+   // this many threads by ThreadedAmplitude, with --numa the threads are
+   // pinned and keep their events, and with --huge-pages the arrays of the
+   // events are backed by huge pages (see AmplitudeThreads)
+   unsigned int numThreads = 1;
+   bool pinThreads = false;
+   bool hugePages = false;
+
+   // with --uservars-dir <dir> the static user variables are also kept in
+   // files in <dir>, which the later fits of the same events read instead
+   // of computing them, e.g., the jobs of the restarts and systematic
+   // variations of a bin
+   string userVarsDir;
+
+   // with --share-sources every ROOTDataReader source is read into columns,
+   // and the reactions that read the same source, e.g., the MC of the
+   // polarization orientations, share one copy that is decoded once (see
+   // ROOTDataReader)
+   bool shareSources = false;
+
+   // with --compact-factors the factors of the amplitudes that do not depend
+   // on a parameter are cached in single precision (see FactorCache), with
+   // --compact-factors-check also their largest rounding error is printed
+   bool compactFactors = false;
+   bool checkCompactFactors = false;
 
    // parse command line
 
@@ -245,74 +106,434 @@ int main( int argc, char* argv[] ){
       if (arg == "-c"){  
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  configfile = argv[++i]; }
+      if (arg == "-l"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  listfile = argv[++i]; }
+      if (arg == "-N"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  normIntDir = argv[++i]; }
+      if (arg == "--normint-chunk"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  normIntChunk = atoi(argv[++i]); }
+      if (arg == "--defer-genmc") deferGenMC = true;
       if (arg == "-s"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  seedfile = argv[++i]; }
       if (arg == "-r"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  numRnd = atoi(argv[++i]); }
+      if (arg == "--bootstrap"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numReplicas = atoi(argv[++i]); }
+      if (arg == "--importance"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  importanceFraction = atof(argv[++i]); }
+      if (arg == "--toys"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numToys = atoi(argv[++i]); }
       if (arg == "-m"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
-         else  maxIter = atoi(argv[++i]); }
-      if (arg == "-n") useMinos = true;
+         else  options.maxIter = atoi(argv[++i]); }
+      if (arg == "-n") options.useMinos = true;
+      if (arg == "--hessian") options.useHessian = true;
+      if (arg == "--profile-errors"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.profilePars = argv[++i]; }
       if (arg == "-p"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  scanPar = argv[++i]; }
+      if (arg == "-o") outwardScan = true;
+      if (arg == "-a") options.usePreFit = true;
+      if (arg == "--projection") options.useProjection = true;
+      if (arg == "--screen-starts"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.screenStarts = atoi(argv[++i]); }
+      if (arg == "--lhs") options.useHypercube = true;
+      if (arg == "--parallel-gradient"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.gradientProcesses = atoi(argv[++i]); }
+      if (arg == "--distinct"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.distinctTolerance = atof(argv[++i]); }
+      if (arg == "--prune-calls"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.pruneCalls = atoi(argv[++i]); }
+      if (arg == "--prune-margin"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.pruneMargin = atof(argv[++i]); }
+      if (arg == "--coarse"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else {
+            stringstream list(argv[++i]);
+            string fraction;
+            while( getline( list, fraction, ',' ) ) if( fraction.size() != 0 ) options.coarseFractions.push_back( atof(fraction.c_str()) );
+            sort( options.coarseFractions.begin(), options.coarseFractions.end() );
+            if( options.coarseFractions.size() == 0 || options.coarseFractions[0] <= 0 || options.coarseFractions.back() >= 1 ) arg = "-h";
+         } }
+      if (arg == "--profile"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) options.profileFile = "profile.json";
+         else  options.profileFile = argv[++i]; }
+      if (arg == "--memory-report") options.memoryReport = true;
+      if (arg == "--drop-zero-waves") options.dropZeroWaves = true;
+      if (arg == "--intensity-columns") options.writeIntensityColumns = true;
+      if (arg == "--intensity-table") options.writeIntensityTable = true;
+      if (arg == "--binary-results") options.writeCompactResults = true;
+      if (arg == "--plot"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-') || !FitProjections::known(argv[i+1])) arg = "-h";
+         else  options.plotGenerator = argv[++i]; }
+      if (arg == "--keep-restarts") options.keepRestarts = true;
+      if (arg == "--keep-uservars") options.cacheUserVars = true;
+      if (arg == "--uservars-dir"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  userVarsDir = argv[++i]; }
+      if (arg == "--follow"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.followSeconds = atof(argv[++i]); }
+      if (arg == "--binned"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.binnedGrid = argv[++i]; }
+      if (arg == "--binned-check") checkBinned = true;
+      if (arg == "--fuse-bkgnd") options.fuseBkgnd = true;
+      if (arg == "--serve"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  serveSocket = argv[++i]; }
+      if (arg == "--submit"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  submitSocket = argv[++i]; }
+      if (arg == "--share-sources") shareSources = true;
+      if (arg == "--compact-factors") compactFactors = true;
+      if (arg == "--compact-factors-check") compactFactors = checkCompactFactors = true;
+      if (arg == "--telemetry"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.telemetryDest = argv[++i]; }
+      if (arg == "--checkpoint"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.checkpointFile = argv[++i]; }
+      if (arg == "--resume") options.resumeFit = true;
+      if (arg == "-w"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  options.numWorkers = atoi(argv[++i]); }
+      if (arg == "-j"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numThreads = atoi(argv[++i]); }
+      if (arg == "--numa") pinThreads = true;
+      if (arg == "--huge-pages") hugePages = true;
       if (arg == "-h"){
          cout << endl << " Usage for: " << argv[0] << endl << endl;
          cout << "   -n \t\t\t\t\t use MINOS instead of MIGRAD" << endl;
+         cout << "   --profile-errors <all|p1,p2,...>\t After the fit, find the asymmetric errors of all or these Minuit parameters by profiling, in the workers of -w, to <fitName>_profile_errors.txt" << endl;
+         cout << "   --hessian\t\t\t\t Compute the covariance matrix after MIGRAD, in the workers of -w (not on GPU builds), to <fitName>_hessian.txt" << endl;
          cout << "   -c <file>\t\t\t\t config file" << endl;
+         cout << "   -l <file>\t\t\t\t list of config files, fit one after the other in their directories" << endl;
          cout << "   -s <output file>\t\t\t for seeding next fit based on this fit (optional)" << endl;
          cout << "   -r <int>\t\t\t Perform <int> fits each seeded with random parameters" << endl;
+         cout << "   --toys <int>\t\t\t Fit <int> toys drawn from the accepted MC at the starting parameters, results in <fitName>_toys.txt" << endl;
+         cout << "   --bootstrap <int>\t\t Fit <int> Poisson bootstrap replicas of the data, read once, results in <fitName>_bootstrap.txt" << endl;
+         cout << "   --importance <fraction>\t\t After a preliminary fit, fit on a subsample of <fraction> of the accepted MC weighted by the intensity, then continue the final fit on all of it" << endl;
          cout << "   -p <parameter> \t\t\t\t Perform a scan of given parameter. Stepsize, min, max are to be set in cfg file" << endl;
          cout << "   -m <int>\t\t\t Maximum number of fit iterations" << endl; 
+         cout << "   -N <dir>\t\t\t Cache the normalization integrals of reactions without free amplitude parameters in <dir>" << endl;
+         cout << "   --normint-chunk <int>\t\t With -N, compute the integrals missing in the cache from <int> MC events at a time instead of loading all MC" << endl;
+         cout << "   --defer-genmc\t\t\t With -N, compute the generated MC integrals missing in the cache in chunks only when the fit is finalized" << endl;
+         cout << "   -a \t\t\t\t\t Minimize in the production parameters with an analytic gradient before MIGRAD" << endl;
+         cout << "   --projection\t\t\t Minimize in the amplitude parameters with the production parameters projected out before MIGRAD (implies -a)" << endl;
+         cout << "   --screen-starts <int>\t\t With -r, draw <int> random production parameters per fit and start from the one of lowest likelihood, all evaluated in one pass" << endl;
+         cout << "   --parallel-gradient <int>\t Minimize in all floating parameters with a finite-difference gradient computed in <int> processes before MIGRAD" << endl;
+         cout << "   --lhs\t\t\t\t With -r, start the restarts from a Latin hypercube of the production and parRange parameters instead of independent random points" << endl;
+         cout << "   --distinct <double>\t\t With -r and without -w, group the converged restarts whose parameters agree within this relative distance and write the minimum of each to the restart table" << endl;
+         cout << "   --prune-calls <int>\t\t With -r, check every <int> MIGRAD calls and stop restarts that are not competitive with the best so far" << endl;
+         cout << "   --prune-margin <double>\t With --prune-calls, stop restarts whose likelihood is above the best by more than this (default: 10)" << endl;
+         cout << "   --coarse <f1,f2,...>\t\t With -r, fit every restart to fixed random subsamples of these fractions of the data and accepted MC, smallest first, before all events" << endl;
+         cout << "   --profile [file]\t\t\t Time the amplitudes, print a table and write it to <file> (default: profile.json)" << endl;
+         cout << "   --memory-report\t\t\t Print the memory of the events of every source and of the user variables of every amplitude" << endl;
+         cout << "   --drop-zero-waves\t\t\t Do not compute the amplitudes whose production coefficients are fixed to zero" << endl;
+         cout << "   --keep-uservars\t\t\t Keep the static user variables of the samples for the later configurations of -l and the studies" << endl;
+         cout << "   --uservars-dir <dir>\t\t Keep the static user variables in files in <dir>, keyed by the amplitude, its arguments and the events, and read them there in later fits of the same events" << endl;
+         cout << "   --follow <seconds>\t\t After a single fit, check the data files every <seconds> and fit again from the last minimum when they change, computing only the user variables of the new events (with -N the MC integrals are kept)" << endl;
+         cout << "   --binned <grid>\t\t Fit the data and accepted MC of ROOTDataReader as one weighted event per bin of <grid>, e.g., mass:40,costheta:20,phi:20,Phi:10 (variables mass[:bins:low:high], costheta, phi, Phi)" << endl;
+         cout << "   --binned-check\t\t\t With --binned and a single fit, fit the binned samples to <fit>_binned.fit, then all events from its minimum, and write the bias of every parameter to <fit>_binned_bias.txt" << endl;
+         cout << "   --fuse-bkgnd\t\t\t Read the data and background of each reaction as one sample with negated background weights, so the likelihood evaluates them in one pass" << endl;
+         cout << "   --serve <socket>\t\t Stay resident and fit the config files sent by --submit on the local <socket>, keeping the sources and static user variables loaded between fits" << endl;
+         cout << "   --submit <socket>\t\t Fit the config file of -c (with the seed file of -s) in the server of --serve on <socket> and print its output" << endl;
+         cout << "   --share-sources\t\t\t Read every ROOTDataReader source into memory once and share it between the reactions that read it" << endl;
+         cout << "   --compact-factors\t\t Cache the per-event factors of fixed-shape amplitudes (Zlm, Vec_ps_refl) in single precision" << endl;
+         cout << "   --compact-factors-check\t\t As --compact-factors and print the largest relative rounding error of the cached factors" << endl;
+         cout << "   --intensity-columns\t\t Write the intensity of every accepted and generated MC event, per sum and amplitude, next to each .fit file for the plotters" << endl;
+         cout << "   --intensity-table\t\t Write the intensities and fractions of every amplitude, interference term and sum, with errors, next to each .fit file" << endl;
+         cout << "   --binary-results\t\t Also write each fit as a binary .fitb file, which the moment tools load faster" << endl;
+         cout << "   --plot <generator>\t\t Fill the histograms of the plot generator (TwoPiPlotGenerator, VecPsPlotGenerator, ThreePiPlotGeneratorSchilling, EtaPiDeltaPlotGenerator) from the samples of each fit and write them to <fit>_plots.root" << endl;
+         cout << "   --keep-restarts\t\t\t With -r, also write the .fit and seed files of every restart, not only of the best" << endl;
+         cout << "   --telemetry <dest>\t\t\t Record every likelihood evaluation to <dest>: a JSON lines file, a .prom file, udp://host:port or http://[host]:port" << endl;
+         cout << "   --checkpoint <file>\t\t Save the parameters and the fits done to <file> every minute and after every fit (-r, single fits)" << endl;
+         cout << "   --resume\t\t\t\t Continue from the file of --checkpoint:  skip the fits done and start the one interrupted where it stopped (with the same -w)" << endl;
+         cout << "   -o \t\t\t\t\t Run the scan of -p outward from the starting value of the parameter" << endl;
+         cout << "   -w <int>\t\t\t Run the random fits of -r, the toys of --toys, the replicas of --bootstrap, the scan of -p or the profile errors of --profile-errors in <int> parallel worker processes" << endl;
+         cout << "   -j <int>\t\t\t Compute the user variables and amplitudes of the events on <int> threads" << endl;
+         cout << "   --numa\t\t\t Pin the threads of -j to CPUs and give each the same events every time, so its arrays are on its socket" << endl;
+         cout << "   --huge-pages\t\t Back the user variables and amplitudes of -j with 2 MB transparent huge pages" << endl;
          exit(1);}
    }
 
-   if (configfile.size() == 0){
+   if (submitSocket.size() != 0){
+      if (configfile.size() == 0){
+         cout << "--submit needs the config file of -c" << endl;
+         exit(1);
+      }
+      return submitFit(submitSocket, configfile, seedfile);
+   }
+
+   if (serveSocket.size() != 0){
+      if (configfile.size() != 0 || listfile.size() != 0 || numRnd != 0 || scanPar != "" || numToys != 0 || numReplicas != 0 || importanceFraction > 0 || options.followSeconds > 0 || checkBinned || options.checkpointFile.size() != 0){
+         cout << "--serve takes the config files from --submit and only runs single fits, without --checkpoint" << endl;
+         exit(1);
+      }
+      shareSources = true;
+      options.cacheUserVars = true;
+      ROOTDataReader::setKeepColumns(true);
+   }
+
+   // with a list, every fit runs in the directory of its config file and
+   // paths in the config file and the seed file are relative to it
+   vector<string> configfiles;
+   if (configfile.size() != 0) configfiles.push_back(configfile);
+   if (listfile.size() != 0){
+      ifstream list(listfile.c_str());
+      if (!list){
+         cout << "Cannot open the list of config files " << listfile << endl;
+         exit(1);
+      }
+      string line;
+      while (list >> line){
+         if (line[0] == '#') getline(list, line);
+         else configfiles.push_back(line);
+      }
+   }
+
+   if (configfiles.size() == 0 && serveSocket.size() == 0){
       cout << "No config file specified" << endl;
       exit(1);
    }
 
-   ConfigFileParser parser(configfile);
-   ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
-   cfgInfo->display();
-
-   AmpToolsInterface::registerAmplitude( BreitWigner() );
-   AmpToolsInterface::registerAmplitude( BreitWigner3body() );
-   AmpToolsInterface::registerAmplitude( TwoPSAngles() );
-   AmpToolsInterface::registerAmplitude( TwoPSHelicity() );
-   AmpToolsInterface::registerAmplitude( TwoPiAngles() );
-   AmpToolsInterface::registerAmplitude( TwoPiAngles_amp() );
-   AmpToolsInterface::registerAmplitude( TwoPiAngles_primakoff() );
-   AmpToolsInterface::registerAmplitude( TwoPiWt_primakoff() );
-   AmpToolsInterface::registerAmplitude( TwoPiWt_sigma() );
-   AmpToolsInterface::registerAmplitude( TwoPitdist() );
-   AmpToolsInterface::registerAmplitude( ThreePiAngles() );
-   AmpToolsInterface::registerAmplitude( ThreePiAnglesSchilling() );
-   AmpToolsInterface::registerAmplitude( TwoPiAnglesRadiative() );
-   AmpToolsInterface::registerAmplitude( Zlm() );
-   AmpToolsInterface::registerAmplitude( b1piAngAmp() );
-   AmpToolsInterface::registerAmplitude( omegapiAngAmp() );
-   AmpToolsInterface::registerAmplitude( polCoef() );
-   AmpToolsInterface::registerAmplitude( Uniform() );
-   AmpToolsInterface::registerAmplitude( dblRegge() );
-   AmpToolsInterface::registerAmplitude( omegapi_amplitude() );
-   AmpToolsInterface::registerAmplitude( Vec_ps_refl() );
-   AmpToolsInterface::registerAmplitude( Piecewise() );
-
-   AmpToolsInterface::registerDataReader( ROOTDataReader() );
-   AmpToolsInterface::registerDataReader( ROOTDataReaderBootstrap() );
-   AmpToolsInterface::registerDataReader( ROOTDataReaderWithTCut() );
-   AmpToolsInterface::registerDataReader( ROOTDataReaderTEM() );
-
-   if(numRnd==0){
-      if(scanPar=="")
-         runSingleFit(cfgInfo, useMinos, maxIter, seedfile);
-      else
-         runParScan(cfgInfo, useMinos, maxIter, seedfile, scanPar);
-   } else {
-      runRndFits(cfgInfo, useMinos, maxIter, seedfile, numRnd, 0.5);
+   if (options.followSeconds > 0){
+      if (configfiles.size() != 1 || numRnd != 0 || scanPar != "" || numToys != 0 || numReplicas != 0 || importanceFraction > 0 || options.checkpointFile.size() != 0){
+         cout << "--follow is only used with a single fit of one config file, without --checkpoint" << endl;
+         exit(1);
+      }
+      options.cacheUserVars = true;
+   }
+
+   if (options.binnedGrid.size() != 0 || checkBinned){
+      if (options.binnedGrid.size() == 0){
+         cout << "--binned-check needs the grid of --binned" << endl;
+         exit(1);
+      }
+      if (!ROOTDataReaderGrid::setGrid(options.binnedGrid)) exit(1);
+      // the cache does not tell the binned samples from the events
+      if (normIntDir.size() != 0){
+         cout << "--binned is not used with -N, the integrals of the binned MC differ from those of its events" << endl;
+         exit(1);
+      }
+      if (checkBinned && (configfiles.size() != 1 || numRnd != 0 || scanPar != "" || numToys != 0 || numReplicas != 0 || importanceFraction > 0 || options.followSeconds > 0 || options.checkpointFile.size() != 0)){
+         cout << "--binned-check is only used with a single fit of one config file, without --follow and --checkpoint" << endl;
+         exit(1);
+      }
+   }
+
+   if ((normIntChunk > 0 || deferGenMC) && normIntDir.size() == 0){
+      cout << "--normint-chunk and --defer-genmc need the cache of -N" << endl;
+      exit(1);
+   }
+
+   // the workers of -w would each compute the deferred integrals
+   if (deferGenMC && options.numWorkers > 1){
+      cout << "--defer-genmc is not used with -w, the integrals are computed before the fits" << endl;
+      deferGenMC = false;
+   }
+   if (deferGenMC && normIntChunk == 0) normIntChunk = 100000;
+
+   if (options.resumeFit && options.checkpointFile.size() == 0){
+      cout << "--resume needs the file of --checkpoint" << endl;
+      exit(1);
+   }
+
+   // the threads of the pool are not in the workers forked by -w
+#ifndef GPU_ACCELERATION
+   if (numThreads > 1 && options.numWorkers > 1){
+      cout << "-j is not used with -w, the fits run in " << options.numWorkers << " single-threaded workers" << endl;
+      numThreads = 1;
+   }
+   if (numThreads > 1 && options.gradientProcesses > 0){
+      cout << "-j is not used with --parallel-gradient, the gradient is computed in " << options.gradientProcesses << " single-threaded processes" << endl;
+      numThreads = 1;
+   }
+   if (numThreads > 1){
+      AmplitudeThreads::setNumThreads(numThreads);
+      AmplitudeThreads::setPinned(pinThreads);
+      AmplitudeThreads::setHugePages(hugePages);
+   }
+#else
+   numThreads = 1;
+   if (options.gradientProcesses > 0){
+      cout << "--parallel-gradient is not used with GPU acceleration, the workers cannot be forked" << endl;
+      options.gradientProcesses = 0;
+   }
+   if (options.profilePars.size() != 0){
+      cout << "--profile-errors is not used with GPU acceleration, the workers cannot be forked" << endl;
+      options.profilePars = "";
+   }
+#endif
+
+   ROOTDataReader::setBulkByDefault( shareSources );
+   FitSession::registerDataReader( ROOTDataReader() );
+   FitSession::registerDataReader( ROOTDataReaderBootstrap() );
+   FitSession::registerDataReader( ROOTDataReaderWithTCut() );
+   FitSession::registerDataReader( ROOTDataReaderBinned() );
+   FitSession::registerDataReader( ROOTDataReaderTEM() );
+   FitSession::registerDataReader( ROOTDataReaderFlat() );
+   FitSession::registerDataReader( ROOTDataReaderPipeline() );
+   FitSession::registerDataReader( BinaryDataReader() );
+   FitSession::registerDataReader( StreamDataReader() );
+   FitSession::registerDataReader( PhaseSpaceDataReader() );
+   if (options.fuseBkgnd) FitSession::registerDataReader( SignedDataReader() );
+
+   // the binned reader has the name of ROOTDataReader and replaces it
+   if (options.binnedGrid.size() != 0) FitSession::registerDataReader( ROOTDataReaderGrid() );
+
+   // The data readers are registered once for all fits and the amplitudes
+   // as the config files that use them are read.  Tables that do not depend
+   // on the fit (polarization tables, Regge and SAID grids, Clebsch-Gordan
+   // coefficients) are shared by the amplitudes for the life of the process,
+   // so only the data and the AmpToolsInterface of each config file are
+   // built again.
+   char* startDir = getcwd(NULL, 0);
+
+   // the report is written where the program was started
+   if (options.profileFile.size() != 0 && options.profileFile[0] != '/' && startDir != NULL)
+      options.profileFile = string(startDir) + "/" + options.profileFile;
+   if (options.telemetryDest.size() != 0 && options.telemetryDest[0] != '/' &&
+       options.telemetryDest.compare(0, 6, "udp://") != 0 && options.telemetryDest.compare(0, 7, "http://") != 0 &&
+       startDir != NULL)
+      options.telemetryDest = string(startDir) + "/" + options.telemetryDest;
+
+   FactorCache::setCompact(compactFactors, checkCompactFactors);
+
+   // the files are only kept in memory as well for the later fits of the
+   // process that --keep-uservars or --follow ask for
+   if (userVarsDir.size() != 0){
+      if (userVarsDir[0] != '/' && startDir != NULL) userVarsDir = string(startDir) + "/" + userVarsDir;
+      UserVarsCache::setDirectory(userVarsDir);
+      if (!options.cacheUserVars) UserVarsCache::setMaxBytes(0);
+      options.cacheUserVars = true;
+   }
+
+   FitSession session(options);
+
+   // the fits of a list change directory, the cache stays where it is
+   if (normIntDir.size() != 0){
+      if (normIntDir[0] != '/' && startDir != NULL) normIntDir = string(startDir) + "/" + normIntDir;
+      session.setNormIntCache(new NormIntCache(normIntDir));
+   }
+
+   if (serveSocket.size() != 0) serveFits(session, serveSocket, startDir);
+
+   for (size_t icfg = 0; icfg < configfiles.size(); icfg++){
+
+      string cfgName = configfiles[icfg];
+      if (listfile.size() != 0){
+         size_t slash = cfgName.rfind('/');
+         if (slash != string::npos){
+            string dir = cfgName.substr(0, slash + 1);
+            cfgName = cfgName.substr(slash + 1);
+            if (chdir(dir.c_str()) != 0){
+               cout << "ERROR:  cannot change to directory " << dir << ", skipping " << configfiles[icfg] << endl;
+               continue;
+            }
+         }
+         cout << endl << "FITTING " << configfiles[icfg] << " (" << icfg + 1 << " OF " << configfiles.size() << ")" << endl;
+      }
+
+      ConfigFileParser parser(cfgName);
+      ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
+      session.pruneWaves(cfgInfo);
+      session.fuseBackground(cfgInfo);
+      cfgInfo->display();
+
+      session.registerAmplitudes(cfgInfo);
+
+      // the generated MC only normalizes the fit fractions and is read as it is
+      if (options.binnedGrid.size() != 0){
+         vector<ReactionInfo*> reactions = cfgInfo->reactionList();
+         for (size_t i = 0; i < reactions.size(); i++)
+            ROOTDataReaderGrid::setUnbinned(reactions[i]->genMC().second);
+      }
+
+      NormIntCache* normIntCache = session.normIntCache();
+      if (normIntCache != NULL) normIntCache->prepare(cfgInfo);
+
+      // the fit reads the integrals computed from the chunks from the cache;
+      // with --defer-genmc the session keeps them until the fit is finalized
+      if (normIntChunk > 0){
+         ChunkedNormInt* chunked = new ChunkedNormInt(normIntChunk, deferGenMC);
+         session.setDeferredNormInt(deferGenMC ? chunked : NULL);
+         if (chunked->compute(cfgInfo, *normIntCache) > 0) normIntCache->prepare(cfgInfo);
+         if (!deferGenMC) delete chunked;
+      }
+
+      ImportanceSampler* importance = NULL;
+      if(importanceFraction > 0 && numToys == 0)
+         importance = prepareImportance(session, cfgInfo, importanceFraction);
+
+      if(numToys > 0){
+         runToyStudy(session, cfgInfo, numToys);
+      } else if(numReplicas > 0){
+         runBootstrapStudy(session, cfgInfo, numReplicas);
+      } else if(numRnd==0){
+         if(scanPar==""){
+            if(checkBinned) runBinnedCheck(session, cfgInfo, seedfile);
+            else if(options.followSeconds > 0) followData(session, cfgName, cfgInfo, seedfile);
+            else session.runSingleFit(cfgInfo, seedfile);
+         }
+         else
+            runParScan(session, cfgInfo, seedfile, scanPar, outwardScan);
+      } else {
+         if(options.numWorkers > 1)
+            runRndFitsParallel(session, cfgInfo, seedfile, numRnd, 0.5);
+         else
+            runRndFits(session, cfgInfo, seedfile, numRnd, 0.5);
+      }
+
+      // the result of a single fit or the best random fit is the one on
+      // all accepted MC
+      if(importance != NULL){
+         if(numReplicas == 0 && scanPar == "")
+            refitFullSample(session, cfgInfo, importance,
+                            numRnd == 0 || seedfile.size() == 0 ? seedfile : seedfile + ".txt");
+         delete importance;
+      }
+
+      if (startDir != NULL && chdir(startDir) != 0){
+         cout << "ERROR:  cannot change back to " << startDir << endl;
+         exit(1);
+      }
+   }
+
+   free(startDir);
+
+   if (options.cacheUserVars)
+      cout << "STATIC USER VARIABLES OF " << UserVarsCache::numHits() << " BLOCKS REUSED, "
+           << UserVarsCache::numStored() << " KEPT" << endl;
+   if (userVarsDir.size() != 0)
+      cout << "STATIC USER VARIABLES OF " << UserVarsCache::numRead() << " BLOCKS READ FROM AND "
+           << UserVarsCache::numWritten() << " WRITTEN TO " << userVarsDir << endl;
+
+   if (checkCompactFactors)
+      cout << "LARGEST RELATIVE ROUNDING ERROR OF " << FactorCache::numValidated()
+           << " COMPACT FACTORS:  " << FactorCache::maxRoundingError() << endl;
+
+   if (options.profileFile.size() != 0){
+      AmplitudeProfiler::report();
+      if (AmplitudeProfiler::writeJSON(options.profileFile))
+         cout << "AMPLITUDE PROFILE WRITTEN TO " << options.profileFile << endl;
    }
 
    return 0;
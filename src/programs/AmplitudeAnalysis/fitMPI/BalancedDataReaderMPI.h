@@ -0,0 +1,264 @@
+#if !defined(BALANCEDDATAREADERMPI)
+#define BALANCEDDATAREADERMPI
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TLorentzVector.h"
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+using namespace std;
+
+/**
+ * A replacement for DataReaderMPI< T > that shares the events of reader T
+ * among the worker ranks in proportion to a weight per rank, e.g., the
+ * events per second the rank managed in an earlier fit, instead of in
+ * equal numbers.  Rank 0 reads all events with T and deals them out one
+ * at a time, so that every worker gets a sample of the whole file rather
+ * than a contiguous range:  events of different cost (e.g., sorted in
+ * mass) are spread evenly even with equal weights.
+ *
+ * As with DataReaderMPI, rank 0 reports all events and returns none, and
+ * the workers return the events they were dealt.  The reader has the name
+ * of T, so it replaces DataReaderMPI< T > without changes to the
+ * configuration file.
+ */
+
+namespace balancedDataReaderMPI {
+
+  // by rank; ranks without a weight get the mean of the others
+  inline vector< double >& rankWeights(){
+
+    static vector< double > weights;
+    return weights;
+  }
+
+  // the weights of the readers that are built from now on
+  inline void setRankWeights( const vector< double >& weights ){
+
+    rankWeights() = weights;
+  }
+
+  // events are sent in messages of this many events
+  const unsigned int kEventsPerMessage = 1024;
+  const int kTag = 7401;
+}
+
+template< class T >
+class BalancedDataReaderMPI : public UserDataReader< BalancedDataReaderMPI< T > >
+{
+
+public:
+
+  BalancedDataReaderMPI() : UserDataReader< BalancedDataReaderMPI< T > >(),
+    m_numEvents( 0 ), m_hasWeight( false ), m_next( 0 ) {}
+
+  BalancedDataReaderMPI( const vector< string >& args );
+
+  ~BalancedDataReaderMPI();
+
+  string name() const { return T().name(); }
+
+  Kinematics* getEvent();
+  void resetSource() { m_next = 0; }
+  unsigned int numEvents() const { return m_numEvents; }
+  bool hasWeight() { return m_hasWeight; }
+
+private:
+
+  void distributeEvents( const vector< string >& args, int numProc );
+  void receiveEvents();
+
+  static void send( vector< double >& buffer, int rank );
+
+  unsigned int m_numEvents;
+  bool m_hasWeight;
+
+  vector< Kinematics* > m_events;
+  unsigned int m_next;
+};
+
+template< class T >
+BalancedDataReaderMPI< T >::BalancedDataReaderMPI( const vector< string >& args ) :
+  UserDataReader< BalancedDataReaderMPI< T > >( args ),
+  m_numEvents( 0 ),
+  m_hasWeight( false ),
+  m_next( 0 )
+{
+  int rank, numProc;
+  MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+  MPI_Comm_size( MPI_COMM_WORLD, &numProc );
+
+  if( rank == 0 ) distributeEvents( args, numProc );
+  else receiveEvents();
+}
+
+template< class T >
+BalancedDataReaderMPI< T >::~BalancedDataReaderMPI(){
+
+  for( unsigned int i = 0; i < m_events.size(); ++i ) delete m_events[i];
+}
+
+template< class T >
+Kinematics*
+BalancedDataReaderMPI< T >::getEvent(){
+
+  if( m_next == m_events.size() ) return NULL;
+  return new Kinematics( *m_events[m_next++] );
+}
+
+template< class T >
+void
+BalancedDataReaderMPI< T >::send( vector< double >& buffer, int rank ){
+
+  MPI_Send( buffer.empty() ? NULL : &( buffer[0] ), buffer.size(), MPI_DOUBLE,
+            rank, balancedDataReaderMPI::kTag, MPI_COMM_WORLD );
+  buffer.clear();
+}
+
+template< class T >
+void
+BalancedDataReaderMPI< T >::distributeEvents( const vector< string >& args, int numProc ){
+
+  T reader( args );
+  m_numEvents = reader.numEvents();
+  m_hasWeight = reader.hasWeight();
+
+  int hasWeight = m_hasWeight;
+  MPI_Bcast( &hasWeight, 1, MPI_INT, 0, MPI_COMM_WORLD );
+
+  int numWorkers = numProc - 1;
+  assert( numWorkers > 0 );
+
+  // the share of each worker, missing weights set to the mean
+  vector< double > weights( numWorkers, 0 );
+  const vector< double >& given = balancedDataReaderMPI::rankWeights();
+  double sum = 0;
+  int nGiven = 0;
+  for( int w = 0; w < numWorkers; ++w ){
+
+    if( w + 1 < (int)given.size() && given[w+1] > 0 ){
+
+      weights[w] = given[w+1];
+      sum += weights[w];
+      ++nGiven;
+    }
+  }
+  double mean = ( nGiven > 0 ? sum / nGiven : 1 );
+  sum = 0;
+  for( int w = 0; w < numWorkers; ++w ){
+
+    if( weights[w] == 0 ) weights[w] = mean;
+    sum += weights[w];
+  }
+
+  // the number of events of each worker, the largest remainders rounded up
+  vector< unsigned int > quota( numWorkers );
+  vector< pair< double, int > > remainders;
+  unsigned int assigned = 0;
+  for( int w = 0; w < numWorkers; ++w ){
+
+    double exact = m_numEvents * weights[w] / sum;
+    quota[w] = (unsigned int)exact;
+    assigned += quota[w];
+    remainders.push_back( make_pair( exact - quota[w], w ) );
+  }
+  sort( remainders.rbegin(), remainders.rend() );
+  for( unsigned int i = 0; assigned < m_numEvents; ++i, ++assigned ) ++quota[remainders[i].second];
+
+  // every event goes to the worker furthest behind its quota
+  typedef pair< double, int > Progress;
+  priority_queue< Progress, vector< Progress >, greater< Progress > > next;
+  for( int w = 0; w < numWorkers; ++w )
+    if( quota[w] > 0 ) next.push( Progress( 1.0 / quota[w], w ) );
+
+  vector< unsigned int > dealt( numWorkers, 0 );
+  vector< vector< double > > buffers( numWorkers );
+  vector< unsigned int > inBuffer( numWorkers, 0 );
+
+  Kinematics* kin;
+  while( !next.empty() && ( kin = reader.getEvent() ) != NULL ){
+
+    int w = next.top().second;
+    next.pop();
+
+    // nParticles, weight, then ( E, px, py, pz ) of each particle
+    const vector< TLorentzVector >& particles = kin->particleList();
+    vector< double >& buffer = buffers[w];
+    buffer.push_back( particles.size() );
+    buffer.push_back( kin->weight() );
+    for( unsigned int i = 0; i < particles.size(); ++i ){
+
+      buffer.push_back( particles[i].E() );
+      buffer.push_back( particles[i].Px() );
+      buffer.push_back( particles[i].Py() );
+      buffer.push_back( particles[i].Pz() );
+    }
+    delete kin;
+
+    if( ++inBuffer[w] == balancedDataReaderMPI::kEventsPerMessage ){
+
+      send( buffer, w + 1 );
+      inBuffer[w] = 0;
+    }
+
+    if( ++dealt[w] < quota[w] ) next.push( Progress( ( dealt[w] + 1.0 ) / quota[w], w ) );
+  }
+
+  // the rest, and an empty message to end
+  for( int w = 0; w < numWorkers; ++w ){
+
+    if( !buffers[w].empty() ) send( buffers[w], w + 1 );
+    send( buffers[w], w + 1 );
+  }
+}
+
+template< class T >
+void
+BalancedDataReaderMPI< T >::receiveEvents(){
+
+  int hasWeight;
+  MPI_Bcast( &hasWeight, 1, MPI_INT, 0, MPI_COMM_WORLD );
+  m_hasWeight = hasWeight;
+
+  vector< double > buffer;
+  while( true ){
+
+    MPI_Status status;
+    MPI_Probe( 0, balancedDataReaderMPI::kTag, MPI_COMM_WORLD, &status );
+
+    int count;
+    MPI_Get_count( &status, MPI_DOUBLE, &count );
+    buffer.resize( count );
+    MPI_Recv( count ? &( buffer[0] ) : NULL, count, MPI_DOUBLE, 0,
+              balancedDataReaderMPI::kTag, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+
+    if( count == 0 ) break;
+
+    unsigned int pos = 0;
+    while( pos < buffer.size() ){
+
+      unsigned int nParticles = buffer[pos++];
+      float weight = buffer[pos++];
+
+      vector< TLorentzVector > particles( nParticles );
+      for( unsigned int i = 0; i < nParticles; ++i, pos += 4 )
+        particles[i].SetPxPyPzE( buffer[pos+1], buffer[pos+2], buffer[pos+3], buffer[pos] );
+
+      m_events.push_back( new Kinematics( particles, weight ) );
+    }
+  }
+
+  m_numEvents = m_events.size();
+}
+
+#endif
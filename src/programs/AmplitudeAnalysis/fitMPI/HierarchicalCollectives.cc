@@ -0,0 +1,182 @@
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <iostream>
+
+#include "HierarchicalCollectives.h"
+
+using namespace std;
+
+// The functions return false, without doing anything, if the collective
+// has to go to the library unchanged; otherwise result is the MPI error
+// code of the first step that failed.  Only PMPI is called here, so the
+// steps are neither intercepted again nor counted twice as wait time.
+
+namespace {
+
+  bool enabled = false;
+
+  // the ranks of this node, and the node leaders ordered by world rank,
+  // so that world rank 0 is rank 0 in both
+  MPI_Comm nodeComm = MPI_COMM_NULL;
+  MPI_Comm leaderComm = MPI_COMM_NULL;
+  int nodeRank = 0;
+
+  // only depends on what all ranks pass alike, so that they all take the
+  // same path; e.g., only the root may reduce in place
+  bool applies( MPI_Comm comm, int root, MPI_Op op ){
+
+    if( !enabled || comm != MPI_COMM_WORLD || root != 0 ) return false;
+
+    int commutative = 0;
+    PMPI_Op_commutative( op, &commutative );
+    return commutative != 0;
+  }
+
+  // a buffer for count elements of type
+  vector< char > buffer( int count, MPI_Datatype type ){
+
+    MPI_Aint lowerBound, extent;
+    PMPI_Type_get_extent( type, &lowerBound, &extent );
+    return vector< char >( count > 0 ? count * extent : 1 );
+  }
+
+  // the send buffer of a rank that reduces in place is a copy of its
+  // receive buffer, since the node sums go to other buffers
+  const void* sendBuffer( const void* sendbuf, const void* recvbuf, int count,
+                          MPI_Datatype type, vector< char >& copy ){
+
+    if( sendbuf != MPI_IN_PLACE ) return sendbuf;
+
+    copy = buffer( count, type );
+    memcpy( &( copy[0] ), recvbuf, count > 0 ? copy.size() : 0 );
+    return &( copy[0] );
+  }
+
+  // Compares the two-level reductions and broadcast with those of the
+  // library on integers, whose sums do not depend on their order, with
+  // and without MPI_IN_PLACE.  Returns true on all ranks if they agree.
+  bool checkCollectives(){
+
+    int worldRank, worldSize;
+    PMPI_Comm_rank( MPI_COMM_WORLD, &worldRank );
+    PMPI_Comm_size( MPI_COMM_WORLD, &worldSize );
+
+    const int count = 4;
+    vector< int > values( count ), expected( count ), sums( count );
+    for( int i = 0; i < count; ++i ) values[i] = worldRank + i + 1;
+    PMPI_Allreduce( &( values[0] ), &( expected[0] ), count, MPI_INT, MPI_SUM, MPI_COMM_WORLD );
+
+    int result;
+    bool agree = true;
+
+    sums.assign( count, 0 );
+    hierarchicalReduce( &( values[0] ), &( sums[0] ), count, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD, &result );
+    if( worldRank == 0 ) agree = agree && ( sums == expected );
+
+    sums = values;
+    hierarchicalReduce( worldRank == 0 ? MPI_IN_PLACE : &( sums[0] ), &( sums[0] ), count,
+                        MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD, &result );
+    if( worldRank == 0 ) agree = agree && ( sums == expected );
+
+    sums.assign( count, 0 );
+    hierarchicalAllreduce( &( values[0] ), &( sums[0] ), count, MPI_INT, MPI_SUM, MPI_COMM_WORLD, &result );
+    agree = agree && ( sums == expected );
+
+    sums = values;
+    hierarchicalAllreduce( MPI_IN_PLACE, &( sums[0] ), count, MPI_INT, MPI_SUM, MPI_COMM_WORLD, &result );
+    agree = agree && ( sums == expected );
+
+    sums = ( worldRank == 0 ? expected : vector< int >( count, 0 ) );
+    hierarchicalBcast( &( sums[0] ), count, MPI_INT, 0, MPI_COMM_WORLD, &result );
+    agree = agree && ( sums == expected );
+
+    int allAgree = ( agree ? 1 : 0 );
+    PMPI_Allreduce( MPI_IN_PLACE, &allAgree, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD );
+    return allAgree != 0;
+  }
+}
+
+void
+enableHierarchicalCollectives(){
+
+  int worldRank;
+  PMPI_Comm_rank( MPI_COMM_WORLD, &worldRank );
+
+  PMPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, worldRank, MPI_INFO_NULL, &nodeComm );
+  PMPI_Comm_rank( nodeComm, &nodeRank );
+
+  PMPI_Comm_split( MPI_COMM_WORLD, nodeRank == 0 ? 0 : MPI_UNDEFINED, worldRank, &leaderComm );
+
+  int nodeSize, maxNodeSize;
+  PMPI_Comm_size( nodeComm, &nodeSize );
+  PMPI_Allreduce( &nodeSize, &maxNodeSize, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+
+  enabled = ( maxNodeSize > 1 );
+
+  if( enabled && !checkCollectives() ){
+
+    if( worldRank == 0 )
+      cout << "ERROR:  the two-level collectives differ from those of MPI, they are not used" << endl;
+    enabled = false;
+  }
+}
+
+bool
+hierarchicalReduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                    MPI_Op op, int root, MPI_Comm comm, int* result ){
+
+  if( !applies( comm, root, op ) ) return false;
+
+  vector< char > sendCopy;
+  sendbuf = sendBuffer( sendbuf, recvbuf, count, type, sendCopy );
+
+  vector< char > nodeSum( nodeRank == 0 ? buffer( count, type ) : vector< char >() );
+
+  *result = PMPI_Reduce( sendbuf, nodeRank == 0 ? &( nodeSum[0] ) : NULL,
+                         count, type, op, 0, nodeComm );
+
+  if( *result == MPI_SUCCESS && nodeRank == 0 )
+    *result = PMPI_Reduce( &( nodeSum[0] ), recvbuf, count, type, op, 0, leaderComm );
+
+  return true;
+}
+
+bool
+hierarchicalAllreduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                       MPI_Op op, MPI_Comm comm, int* result ){
+
+  if( !applies( comm, 0, op ) ) return false;
+
+  vector< char > sendCopy;
+  sendbuf = sendBuffer( sendbuf, recvbuf, count, type, sendCopy );
+
+  vector< char > nodeSum( nodeRank == 0 ? buffer( count, type ) : vector< char >() );
+
+  *result = PMPI_Reduce( sendbuf, nodeRank == 0 ? &( nodeSum[0] ) : NULL,
+                         count, type, op, 0, nodeComm );
+
+  if( *result == MPI_SUCCESS && nodeRank == 0 )
+    *result = PMPI_Allreduce( &( nodeSum[0] ), recvbuf, count, type, op, leaderComm );
+
+  if( *result == MPI_SUCCESS )
+    *result = PMPI_Bcast( recvbuf, count, type, 0, nodeComm );
+
+  return true;
+}
+
+bool
+hierarchicalBcast( void* buf, int count, MPI_Datatype type, int root, MPI_Comm comm,
+                   int* result ){
+
+  if( !enabled || comm != MPI_COMM_WORLD || root != 0 ) return false;
+
+  *result = MPI_SUCCESS;
+  if( nodeRank == 0 ) *result = PMPI_Bcast( buf, count, type, 0, leaderComm );
+
+  if( *result == MPI_SUCCESS )
+    *result = PMPI_Bcast( buf, count, type, 0, nodeComm );
+
+  return true;
+}
@@ -0,0 +1,40 @@
+#if !defined(HIERARCHICALCOLLECTIVES)
+#define HIERARCHICALCOLLECTIVES
+
+#include <mpi.h>
+
+/**
+ * Two-level versions of the reductions and the broadcast that AmpTools
+ * uses on MPI_COMM_WORLD in every likelihood call.  The ranks of a node
+ * first reduce through shared memory to the lowest rank of the node, and
+ * only these node leaders take part in the step between nodes; a
+ * broadcast goes the other way.  With many ranks per node this replaces
+ * one collective over all ranks by one over the nodes, which is what
+ * limits a fit on many ranks with few events each.
+ *
+ * The MPI calls of AmpTools are intercepted through the profiling
+ * interface (see MPIWaitTime.cc), which sends the collectives here once
+ * enableHierarchicalCollectives has been called.  Only collectives on
+ * MPI_COMM_WORLD with root 0 and a commutative operation take the
+ * two-level path; a rank that passes MPI_IN_PLACE sends a copy of its
+ * receive buffer.  The partial sums are added in a different order, so
+ * results can differ in the last bits from those of the library's own
+ * reduction.
+ */
+
+// Has to be called by all ranks, after MPI_Init; does nothing if every
+// node has a single rank.  The two-level collectives are first compared
+// with those of the library, with and without MPI_IN_PLACE, and not used
+// if they differ.
+void enableHierarchicalCollectives();
+
+bool hierarchicalReduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                         MPI_Op op, int root, MPI_Comm comm, int* result );
+
+bool hierarchicalAllreduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                            MPI_Op op, MPI_Comm comm, int* result );
+
+bool hierarchicalBcast( void* buf, int count, MPI_Datatype type, int root, MPI_Comm comm,
+                        int* result );
+
+#endif
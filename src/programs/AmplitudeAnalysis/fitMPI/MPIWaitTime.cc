@@ -0,0 +1,106 @@
+
+#include <atomic>
+
+#include <mpi.h>
+
+#include "MPIWaitTime.h"
+#include "HierarchicalCollectives.h"
+#include "ReproducibleCollectives.h"
+
+// only the thread that calls MPI adds to it, others may read it
+static std::atomic< double > waitSeconds( 0 );
+
+double
+mpiWaitSeconds(){
+
+  return waitSeconds;
+}
+
+void
+resetMPIWaitTime(){
+
+  waitSeconds = 0;
+}
+
+namespace {
+
+  // MPI_Wtime is not intercepted, so it can be called in the wrappers
+  struct WaitTimer {
+
+    WaitTimer() : start( MPI_Wtime() ) {}
+    ~WaitTimer() { waitSeconds.store( waitSeconds.load() + MPI_Wtime() - start ); }
+
+    double start;
+  };
+}
+
+// the MPI-3 signatures; every call goes on to the library through PMPI,
+// the collectives on the two-level path of HierarchicalCollectives and
+// the sums of doubles through ReproducibleCollectives if they are enabled
+
+int
+MPI_Send( const void* buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm ){
+
+  WaitTimer timer;
+  return PMPI_Send( buf, count, type, dest, tag, comm );
+}
+
+int
+MPI_Recv( void* buf, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm,
+          MPI_Status* status ){
+
+  WaitTimer timer;
+  return PMPI_Recv( buf, count, type, source, tag, comm, status );
+}
+
+int
+MPI_Probe( int source, int tag, MPI_Comm comm, MPI_Status* status ){
+
+  WaitTimer timer;
+  return PMPI_Probe( source, tag, comm, status );
+}
+
+int
+MPI_Bcast( void* buf, int count, MPI_Datatype type, int root, MPI_Comm comm ){
+
+  WaitTimer timer;
+  int result;
+  if( hierarchicalBcast( buf, count, type, root, comm, &result ) ) return result;
+  return PMPI_Bcast( buf, count, type, root, comm );
+}
+
+int
+MPI_Reduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, MPI_Op op,
+            int root, MPI_Comm comm ){
+
+  WaitTimer timer;
+  int result;
+  if( reproducibleReduce( sendbuf, recvbuf, count, type, op, root, comm, &result ) ) return result;
+  if( hierarchicalReduce( sendbuf, recvbuf, count, type, op, root, comm, &result ) ) return result;
+  return PMPI_Reduce( sendbuf, recvbuf, count, type, op, root, comm );
+}
+
+int
+MPI_Allreduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, MPI_Op op,
+               MPI_Comm comm ){
+
+  WaitTimer timer;
+  int result;
+  if( reproducibleAllreduce( sendbuf, recvbuf, count, type, op, comm, &result ) ) return result;
+  if( hierarchicalAllreduce( sendbuf, recvbuf, count, type, op, comm, &result ) ) return result;
+  return PMPI_Allreduce( sendbuf, recvbuf, count, type, op, comm );
+}
+
+int
+MPI_Barrier( MPI_Comm comm ){
+
+  WaitTimer timer;
+  return PMPI_Barrier( comm );
+}
+
+int
+MPI_Wait( MPI_Request* request, MPI_Status* status ){
+
+  WaitTimer timer;
+  return PMPI_Wait( request, status );
+}
@@ -0,0 +1,19 @@
+#if !defined(MPIWAITTIME)
+#define MPIWAITTIME
+
+/**
+ * The wall time this rank has spent inside the blocking MPI calls that
+ * AmpTools uses to broadcast the parameters and collect the likelihood
+ * (send, receive, broadcast, reductions, barrier, wait, probe).  The calls
+ * are intercepted through the MPI profiling interface, so the AmpTools
+ * library is measured without changes.  The rest of the wall time of a
+ * worker rank is the time it spends on its events.  It can be read from
+ * any thread.
+ */
+
+double mpiWaitSeconds();
+
+// starts the measurement again from zero
+void resetMPIWaitTime();
+
+#endif
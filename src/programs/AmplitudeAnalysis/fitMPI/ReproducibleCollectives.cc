@@ -0,0 +1,193 @@
+
+#include <cmath>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "ReproducibleCollectives.h"
+#include "HierarchicalCollectives.h"
+
+using namespace std;
+
+// As in HierarchicalCollectives, the functions return false if the
+// collective has to go to the library unchanged, and only PMPI is called.
+
+namespace {
+
+  // An exact sum of doubles: a double is m 2^p with an integer |m| < 2^53
+  // and -1126 <= p <= 971, so its bits lie in [0, 2150) after an offset of
+  // 1126.  They are kept in limbs of 32 bits in signed 64-bit integers,
+  // which take about 2^31 additions before they can overflow; the last two
+  // limbs take the carries.  Infinities and NaN are counted apart.
+  struct ExactSum {
+
+    enum { kLimbBits = 32, kOffset = 1126, kLimbs = 70 };
+
+    int64_t limb[kLimbs];
+    int64_t plusInf, minusInf, nan;
+
+    ExactSum(){
+
+      for( int k = 0; k < kLimbs; ++k ) limb[k] = 0;
+      plusInf = minusInf = nan = 0;
+    }
+
+    void add( double x ){
+
+      if( x == 0 ) return;
+      if( std::isnan( x ) ){ ++nan; return; }
+      if( std::isinf( x ) ){ ++( x > 0 ? plusInf : minusInf ); return; }
+
+      int exponent;
+      double fraction = frexp( x, &exponent );
+      int64_t m = (int64_t)ldexp( fraction, 53 );
+      int position = exponent - 53 + kOffset;
+
+      int64_t sign = ( m < 0 ? -1 : 1 );
+      uint64_t magnitude = ( m < 0 ? -m : m );
+
+      int k = position / kLimbBits;
+      int shift = position % kLimbBits;
+
+      // the low and the high 32 bits of the magnitude, each shifted into
+      // at most two limbs
+      const uint64_t mask = 0xffffffffULL;
+      uint64_t low = ( magnitude & mask ) << shift;
+      uint64_t high = ( magnitude >> 32 ) << shift;
+
+      limb[k] += sign * (int64_t)( low & mask );
+      limb[k+1] += sign * (int64_t)( ( low >> 32 ) + ( high & mask ) );
+      limb[k+2] += sign * (int64_t)( high >> 32 );
+    }
+
+    void add( const ExactSum& other ){
+
+      for( int k = 0; k < kLimbs; ++k ) limb[k] += other.limb[k];
+      plusInf += other.plusInf;
+      minusInf += other.minusInf;
+      nan += other.nan;
+    }
+
+    // the limbs in [0, 2^32) but the last, which keeps the sign
+    void normalize(){
+
+      int64_t carry = 0;
+      for( int k = 0; k < kLimbs - 1; ++k ){
+
+        limb[k] += carry;
+        carry = limb[k] >> kLimbBits;
+        limb[k] -= carry << kLimbBits;
+      }
+      limb[kLimbs-1] += carry;
+    }
+
+    double value() const {
+
+      if( nan > 0 || ( plusInf > 0 && minusInf > 0 ) ) return NAN;
+      if( plusInf > 0 ) return INFINITY;
+      if( minusInf > 0 ) return -INFINITY;
+
+      ExactSum sum( *this );
+      sum.normalize();
+
+      double sign = 1;
+      if( sum.limb[kLimbs-1] < 0 ){
+
+        for( int k = 0; k < kLimbs; ++k ) sum.limb[k] = -sum.limb[k];
+        sum.normalize();
+        sign = -1;
+      }
+
+      int top = kLimbs - 1;
+      while( top >= 0 && sum.limb[top] == 0 ) --top;
+      if( top < 0 ) return 0;
+
+      // the four leading limbs hold more than the 53 bits of a double;
+      // they are added from the largest, so the result is within an ulp
+      double result = 0;
+      for( int k = top; k >= 0 && k > top - 4; --k )
+        result += ldexp( (double)sum.limb[k], k * kLimbBits - kOffset );
+
+      return sign * result;
+    }
+  };
+
+  bool enabled = false;
+
+  MPI_Datatype sumType = MPI_DATATYPE_NULL;
+  MPI_Op sumOp = MPI_OP_NULL;
+
+  void addSums( void* in, void* inout, int* len, MPI_Datatype* ){
+
+    const ExactSum* a = static_cast< const ExactSum* >( in );
+    ExactSum* b = static_cast< ExactSum* >( inout );
+    for( int i = 0; i < *len; ++i ) b[i].add( a[i] );
+  }
+
+  bool applies( MPI_Datatype type, MPI_Op op, MPI_Comm comm ){
+
+    return enabled && type == MPI_DOUBLE && op == MPI_SUM && comm == MPI_COMM_WORLD;
+  }
+
+  vector< ExactSum > toSums( const void* values, int count ){
+
+    vector< ExactSum > sums( count > 0 ? count : 1 );
+    const double* x = static_cast< const double* >( values );
+    for( int i = 0; i < count; ++i ) sums[i].add( x[i] );
+    return sums;
+  }
+
+  void fromSums( const vector< ExactSum >& sums, void* values, int count ){
+
+    double* x = static_cast< double* >( values );
+    for( int i = 0; i < count; ++i ) x[i] = sums[i].value();
+  }
+}
+
+void
+enableReproducibleCollectives(){
+
+  PMPI_Type_contiguous( sizeof( ExactSum ) / sizeof( int64_t ), MPI_INT64_T, &sumType );
+  PMPI_Type_commit( &sumType );
+  PMPI_Op_create( &addSums, 1, &sumOp );
+
+  enabled = true;
+}
+
+bool
+reproducibleReduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                    MPI_Op op, int root, MPI_Comm comm, int* result ){
+
+  if( !applies( type, op, comm ) ) return false;
+
+  int rank;
+  PMPI_Comm_rank( comm, &rank );
+
+  vector< ExactSum > local = toSums( sendbuf == MPI_IN_PLACE ? recvbuf : sendbuf, count );
+  vector< ExactSum > total( rank == root ? local.size() : 0 );
+  void* totalBuffer = ( rank == root ? &( total[0] ) : NULL );
+
+  if( !hierarchicalReduce( &( local[0] ), totalBuffer, count, sumType, sumOp, root, comm, result ) )
+    *result = PMPI_Reduce( &( local[0] ), totalBuffer, count, sumType, sumOp, root, comm );
+
+  if( *result == MPI_SUCCESS && rank == root ) fromSums( total, recvbuf, count );
+
+  return true;
+}
+
+bool
+reproducibleAllreduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                       MPI_Op op, MPI_Comm comm, int* result ){
+
+  if( !applies( type, op, comm ) ) return false;
+
+  vector< ExactSum > local = toSums( sendbuf == MPI_IN_PLACE ? recvbuf : sendbuf, count );
+  vector< ExactSum > total( local.size() );
+
+  if( !hierarchicalAllreduce( &( local[0] ), &( total[0] ), count, sumType, sumOp, comm, result ) )
+    *result = PMPI_Allreduce( &( local[0] ), &( total[0] ), count, sumType, sumOp, comm );
+
+  if( *result == MPI_SUCCESS ) fromSums( total, recvbuf, count );
+
+  return true;
+}
@@ -0,0 +1,43 @@
+#if !defined(REPRODUCIBLECOLLECTIVES)
+#define REPRODUCIBLECOLLECTIVES
+
+#include <mpi.h>
+
+/**
+ * Reproducible sums of doubles over the ranks for the reductions that
+ * AmpTools uses to collect the likelihood and the normalization integrals.
+ * MPI adds the partial sums of the ranks in an order that depends on the
+ * library, the number of ranks and their placement on the nodes (and on
+ * -H, see HierarchicalCollectives), so a fit can differ in the last bits
+ * from one job to the next and random restarts cannot be compared bit by
+ * bit.
+ *
+ * Here every rank converts its values to exact fixed-point accumulators
+ * that cover the whole range of a double, and these are added with
+ * integer arithmetic, which does not depend on the order.  The sum is
+ * rounded to a double once, at the end, so it is the same for any
+ * reduction tree and any order of the ranks.  An accumulator is 584
+ * bytes per value, which is small for the few sums of the likelihood.
+ *
+ * The partial sums of each rank are still computed by AmpTools over the
+ * events of the rank, so a different number of ranks splits the events
+ * differently and can change the result; with the same number of ranks
+ * the result is bit for bit the same.
+ *
+ * The calls of AmpTools are intercepted through the profiling interface
+ * (see MPIWaitTime.cc), which sends the reductions here once
+ * enableReproducibleCollectives has been called.  Only sums of MPI_DOUBLE
+ * on MPI_COMM_WORLD take this path; with -H the accumulators go through
+ * the two-level reduction.
+ */
+
+// Has to be called by all ranks, after MPI_Init.
+void enableReproducibleCollectives();
+
+bool reproducibleReduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                         MPI_Op op, int root, MPI_Comm comm, int* result );
+
+bool reproducibleAllreduce( const void* sendbuf, void* recvbuf, int count, MPI_Datatype type,
+                            MPI_Op op, MPI_Comm comm, int* result );
+
+#endif
@@ -0,0 +1,94 @@
+#if !defined(SLICEDDATAREADERMPI)
+#define SLICEDDATAREADERMPI
+
+#include <mpi.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/UserDataReader.h"
+
+using namespace std;
+
+/**
+ * A replacement for DataReaderMPI< T > in which every worker rank reads
+ * its own slice of the source with T, instead of rank 0 reading all
+ * events and sending them out.  T must take the option slice=<i>/<n>
+ * (ROOTDataReader and BinaryDataReader do); worker i of n opens the
+ * file itself and reads only its entries, so the start-up time no longer
+ * grows with the number of ranks and no events pass through rank 0.
+ * The only communication is the sum of the slice sizes.
+ *
+ * As with DataReaderMPI, rank 0 reports all events and returns none, and
+ * the workers return the events of their slice.  The reader has the name
+ * of T, so it replaces DataReaderMPI< T > without changes to the
+ * configuration file.  All ranks must be able to open the file.
+ */
+
+template< class T >
+class SlicedDataReaderMPI : public UserDataReader< SlicedDataReaderMPI< T > >
+{
+
+public:
+
+  SlicedDataReaderMPI() : UserDataReader< SlicedDataReaderMPI< T > >(),
+    m_reader( NULL ), m_numEvents( 0 ), m_hasWeight( false ) {}
+
+  SlicedDataReaderMPI( const vector< string >& args );
+
+  ~SlicedDataReaderMPI() { if( m_reader != NULL ) delete m_reader; }
+
+  string name() const { return T().name(); }
+
+  Kinematics* getEvent() { return m_reader != NULL ? m_reader->getEvent() : NULL; }
+  void resetSource() { if( m_reader != NULL ) m_reader->resetSource(); }
+  unsigned int numEvents() const { return m_numEvents; }
+  bool hasWeight() { return m_hasWeight; }
+
+private:
+
+  T* m_reader;
+  unsigned int m_numEvents;
+  bool m_hasWeight;
+};
+
+template< class T >
+SlicedDataReaderMPI< T >::SlicedDataReaderMPI( const vector< string >& args ) :
+  UserDataReader< SlicedDataReaderMPI< T > >( args ),
+  m_reader( NULL ),
+  m_numEvents( 0 ),
+  m_hasWeight( false )
+{
+  int rank, numProc;
+  MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+  MPI_Comm_size( MPI_COMM_WORLD, &numProc );
+
+  unsigned long long sliceEvents = 0;
+  int hasWeight = 0;
+
+  if( rank > 0 ){
+
+    ostringstream slice;
+    slice << "slice=" << rank - 1 << "/" << numProc - 1;
+
+    vector< string > sliceArgs( args );
+    sliceArgs.push_back( slice.str() );
+
+    m_reader = new T( sliceArgs );
+    sliceEvents = m_reader->numEvents();
+    hasWeight = m_reader->hasWeight();
+  }
+
+  // rank 0 reports the events of all slices; a source has weights if
+  // any slice has them
+  unsigned long long totalEvents;
+  MPI_Allreduce( &sliceEvents, &totalEvents, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD );
+  MPI_Allreduce( MPI_IN_PLACE, &hasWeight, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+
+  m_numEvents = ( rank == 0 ? totalEvents : sliceEvents );
+  m_hasWeight = hasWeight;
+}
+
+#endif
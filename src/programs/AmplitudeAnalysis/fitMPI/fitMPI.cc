@@ -6,40 +6,44 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#ifdef GPU_ACCELERATION
+#include <cuda_runtime.h>
+#endif
 
 #include "TSystem.h"
+#include "TRandom.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBinned.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
-#include "AMPTOOLS_AMPS/TwoPSAngles.h"
-#include "AMPTOOLS_AMPS/TwoPSHelicity.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles_amp.h"
-#include "AMPTOOLS_AMPS/TwoPiWt_primakoff.h"
-#include "AMPTOOLS_AMPS/TwoPiWt_sigma.h"
-#include "AMPTOOLS_AMPS/TwoPiW_brokenetas.h"
-#include "AMPTOOLS_AMPS/TwoPitdist.h"
-#include "AMPTOOLS_AMPS/TwoPiNC_tdist.h"
-#include "AMPTOOLS_AMPS/TwoPiEtas_tdist.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles_primakoff.h"
-#include "AMPTOOLS_AMPS/ThreePiAngles.h"
-#include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
-#include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.h"
-#include "AMPTOOLS_AMPS/Zlm.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
-#include "AMPTOOLS_AMPS/BreitWigner3body.h"
-#include "AMPTOOLS_AMPS/b1piAngAmp.h"
-#include "AMPTOOLS_AMPS/omegapiAngAmp.h"
-#include "AMPTOOLS_AMPS/Uniform.h"
-#include "AMPTOOLS_AMPS/polCoef.h"
-#include "AMPTOOLS_AMPS/dblRegge.h"
-#include "AMPTOOLS_AMPS/dblReggeMod.h"
-#include "AMPTOOLS_AMPS/omegapi_amplitude.h"
-#include "AMPTOOLS_AMPS/Vec_ps_refl.h"
-#include "AMPTOOLS_AMPS/Piecewise.h"
-#include "AMPTOOLS_AMPS/Flatte.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderFlat.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderPipeline.h"
+#include "AMPTOOLS_DATAIO/BinaryDataReader.h"
+#include "AMPTOOLS_DATAIO/PhaseSpaceDataReader.h"
+#include "AMPTOOLS_DATAIO/NormIntCache.h"
+#include "AMPTOOLS_DATAIO/FitTelemetry.h"
+#include "AMPTOOLS_DATAIO/MetricsEndpoint.h"
+#include "AMPTOOLS_DATAIO/FitCheckpoint.h"
+#include "AMPTOOLS_DATAIO/MemoryReport.h"
+#include "AMPTOOLS_DATAIO/IntensityTable.h"
+#include "AMPTOOLS_DATAIO/CompactFitResults.h"
+#include "AMPTOOLS_DATAIO/FitProjections.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
+#include "AMPTOOLS_AMPS/AmplitudeProfiler.h"
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+#include "AMPTOOLS_AMPS/FactorCache.h"
+#include "AMPTOOLS_AMPS/UserVarsCache.h"
 
 #include "MinuitInterface/MinuitMinimizationManager.h"
 #include "IUAmpToolsMPI/AmpToolsInterfaceMPI.h"
@@ -48,19 +52,486 @@
 #include "IUAmpTools/ConfigFileParser.h"
 #include "IUAmpTools/ConfigurationInfo.h"
 
+#include "BalancedDataReaderMPI.h"
+#include "SlicedDataReaderMPI.h"
+#include "MPIWaitTime.h"
+#include "HierarchicalCollectives.h"
+#include "ReproducibleCollectives.h"
+
 using std::complex;
 using namespace std;
 
 int rank_mpi;
 int size;
 
+// the normalization integrals of reactions without free amplitude
+// parameters are kept here between fits (-N <directory>)
+NormIntCache* normIntCache = NULL;
+
+// with --profile the amplitudes are registered as ProfiledAmplitude and
+// the report is written to this file at the end
+string profileFile;
+
+// with -j the events of every rank are shared over this many threads by
+// ThreadedAmplitude, so a node can run one rank with a thread per core and
+// hold the amplitudes, tables and configuration once
+unsigned int numThreads = 1;
+
+// with --numa the threads of -j are pinned and keep their events, and with
+// --huge-pages the arrays of the events are backed by huge pages (see
+// AmplitudeThreads)
+bool pinThreads = false;
+bool hugePages = false;
+
+// with --intensity-table rank 0 writes the intensities and fractions of
+// every amplitude, interference term, sum and reaction to <fit>.intensities
+// (see IntensityTable)
+bool writeIntensityTable = false;
+
+// with --binary-results rank 0 also writes <fit>.fitb (see
+// CompactFitResults)
+bool writeCompactResults = false;
+
+// the optional files that finalizeFit writes next to <fit>.fit
+const char* fitCompanions[] = { ".intensities", ".fitb" };
+
+void finalizeFit(AmpToolsInterfaceMPI& ati, const string& tag = "") {
+   ati.finalizeFit( tag );
+   if( rank_mpi != 0 || ati.fitResults() == NULL ) return;
+   string fitBase = ati.configurationInfo()->fitName() + ( tag.size() != 0 ? "_" + tag : "" );
+   if( writeIntensityTable ){
+      IntensityTable( *ati.fitResults() ).write( fitBase + ".intensities" );
+   }
+   if( writeCompactResults ){
+      CompactFitResults::write( *ati.fitResults(), fitBase + ".fitb" );
+   }
+}
+
+// with --uservars-dir <dir> every rank keeps the static user variables of
+// its events in files in <dir> and reads them there in later jobs over
+// the same events with the same number of ranks (see UserVarsCache)
+string userVarsDir;
+
+// the amplitudes that a config file uses are registered before its
+// AmpToolsInterface is built, wrapped as the options above ask
+void registerAmplitudes(ConfigurationInfo* cfgInfo) {
+   AmplitudeRegistry::Options options;
+   options.profile = ( profileFile.size() != 0 );
+   options.onRegister = MemoryReport::registerAmplitude;
+   options.cacheUserVars = ( userVarsDir.size() != 0 );
+   AmplitudeRegistry::registerUsed( cfgInfo, options );
+}
+
+// with --compact-factors the factors of the amplitudes that do not depend
+// on a parameter are cached in single precision (see FactorCache), with
+// --compact-factors-check rank 0 also prints the largest rounding error of
+// all ranks.  Has to be called by all ranks after exitMPI.
+bool compactFactors = false;
+bool checkCompactFactors = false;
+
+void reportCompactFactors() {
+   if( !checkCompactFactors ) return;
+
+   double error = FactorCache::maxRoundingError(), maxError = 0;
+   long long count = FactorCache::numValidated(), sumCount = 0;
+   MPI_Reduce( &error, &maxError, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD );
+   MPI_Reduce( &count, &sumCount, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD );
+
+   if( rank_mpi == 0 )
+      cout << "LARGEST RELATIVE ROUNDING ERROR OF " << sumCount
+           << " COMPACT FACTORS:  " << maxError << endl;
+}
+
+// With --plot <generator> the histograms of the plot generator are filled
+// from the samples of a single fit and written by rank 0 to
+// <fit>_plots.root (see FitProjections).  The workers only hold their
+// events, and only leave the likelihood once rank 0 calls exitMPI, so
+// every rank fills the histograms from its own events after the fit, with
+// the production parameters of the results of rank 0, and the sums are
+// added on rank 0.  The amplitude parameters are those the workers had at
+// the last evaluation of the likelihood.  Has to be called by all ranks
+// after exitMPI.
+string plotGenerator;
+
+void writePlots(AmpToolsInterfaceMPI& ati, ConfigurationInfo* cfgInfo) {
+   if( plotGenerator.size() == 0 ) return;
+
+   FitProjections projections( plotGenerator, cfgInfo );
+   if( !projections.valid() ) return;
+
+   vector< complex< double > > prodPars( FitProjections::numAmplitudes( cfgInfo ) );
+   if( rank_mpi == 0 && ati.fitResults() != NULL )
+      prodPars = FitProjections::productionParameters( *ati.fitResults(), cfgInfo );
+   if( prodPars.size() > 0 )
+      MPI_Bcast( &(prodPars[0]), 2 * prodPars.size(), MPI_DOUBLE, 0, MPI_COMM_WORLD );
+
+   projections.fill( ati, prodPars );
+
+   vector< double >& sums = projections.sums();
+   MPI_Reduce( rank_mpi == 0 ? MPI_IN_PLACE : &(sums[0]), &(sums[0]), sums.size(),
+               MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD );
+
+   if( rank_mpi == 0 )
+      projections.write( cfgInfo->fitName() + "_plots.root" );
+}
+
+// Every rank times the amplitudes of its share of the events.  The ranks
+// run the same configuration and so have the same profile entries; their
+// counters are summed on rank 0, which prints the table and writes the
+// report.  Only rank 0 marks the phases of the fit, so the calls of the
+// other ranks count as "other".  Has to be called by all ranks after
+// exitMPI.
+void reportProfile() {
+   if( profileFile.size() == 0 ) return;
+
+   vector< long long > values = AmplitudeProfiler::counterValues();
+
+   int n = values.size(), nMin, nMax;
+   MPI_Allreduce( &n, &nMin, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD );
+   MPI_Allreduce( &n, &nMax, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+
+   if( nMin != nMax ){
+      // the entries differ, every rank writes its own report
+      AmplitudeProfiler::writeJSON( profileFile + Form(".rank%d", rank_mpi) );
+      return;
+   }
+
+   vector< long long > sums( n );
+   if( n > 0 )
+      MPI_Reduce( &(values[0]), &(sums[0]), n, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD );
+
+   if( rank_mpi == 0 ){
+      if( n > 0 ) AmplitudeProfiler::setCounterValues( sums );
+      AmplitudeProfiler::report();
+      if( AmplitudeProfiler::writeJSON( profileFile ) )
+         cout << "AMPLITUDE PROFILE OF " << size << " RANKS WRITTEN TO " << profileFile << endl;
+   }
+}
+
+// With --memory-report the memory of the events of each rank is computed
+// (see MemoryReport).  The rank with the most prints its table and rank 0
+// the totals of all ranks.  Has to be called by all ranks.
+bool memoryReport = false;
+
+void reportMemory(AmpToolsInterface& ati, ConfigurationInfo* cfgInfo) {
+   if( !memoryReport ) return;
+
+   MemoryReport report( ati, cfgInfo );
+
+   struct { double bytes; int rank; } local = { report.totalBytes(), rank_mpi }, largest;
+   MPI_Allreduce( &local, &largest, 1, MPI_DOUBLE_INT, MPI_MAXLOC, MPI_COMM_WORLD );
+
+   if( rank_mpi == largest.rank ){
+      cout << "MEMORY OF RANK " << rank_mpi << ", THE LARGEST OF " << size << " RANKS" << endl;
+      report.print();
+      cout.flush();
+   }
+   MPI_Barrier( MPI_COMM_WORLD );
+
+   double totals[2] = { report.totalBytes(), report.totalGPUBytes() };
+   vector< double > all( 2 * size );
+   MPI_Gather( totals, 2, MPI_DOUBLE, &(all[0]), 2, MPI_DOUBLE, 0, MPI_COMM_WORLD );
+
+   if( rank_mpi == 0 ){
+      double sum = 0, gpuSum = 0;
+      cout << "MEMORY OF THE EVENTS PER RANK [MB]:";
+      for( int r = 0; r < size; ++r ){
+         cout << " " << Form("%.1f", all[2*r] / ( 1024. * 1024. ));
+         sum += all[2*r];
+         gpuSum += all[2*r+1];
+      }
+      cout << endl << "MEMORY OF THE EVENTS OF ALL RANKS:  " << Form("%.1f", sum / ( 1024. * 1024. )) << " MB";
+#ifdef GPU_ACCELERATION
+      cout << ", GPU " << Form("%.1f", gpuSum / ( 1024. * 1024. )) << " MB";
+#endif
+      cout << endl;
+   }
+}
+
+// with --telemetry rank 0 records every evaluation of the likelihood to
+// this destination (see FitTelemetry)
+string telemetryDest;
+FitTelemetry* telemetry = NULL;
+
+// with -B the events are shared among the workers in proportion to the
+// events per second each of them managed in the last fit (see
+// BalancedDataReaderMPI); they are read from and written to this file
+string balanceFile;
+
+// with --slice-read every worker reads its own slice of the ROOT and
+// binary sources (see SlicedDataReaderMPI) instead of rank 0 reading them
+bool sliceRead = false;
+
+chrono::steady_clock::time_point fitStart;
+
+// with an http:// telemetry destination every rank reports its compute
+// and MPI wait seconds and its memory to the endpoint of rank 0 while the
+// fit runs (see MetricsEndpoint)
+MetricsReporter* rankReporter = NULL;
+
+RankMetrics rankMetrics() {
+   RankMetrics metrics;
+   metrics.rank = rank_mpi;
+   metrics.wallSeconds = chrono::duration< double >( chrono::steady_clock::now() - fitStart ).count();
+   metrics.waitSeconds = mpiWaitSeconds();
+   metrics.computeSeconds = max( 0.0, metrics.wallSeconds - metrics.waitSeconds );
+   metrics.residentBytes = MetricsEndpoint::residentBytes();
+   metrics.gpuBytes = 0;
+#ifdef GPU_ACCELERATION
+   size_t freeBytes, totalBytes;
+   if( cudaMemGetInfo( &freeBytes, &totalBytes ) == cudaSuccess ) metrics.gpuBytes = totalBytes - freeBytes;
+#endif
+   return metrics;
+}
+
+void startRankReporter() {
+   string host;
+   int port;
+   if( !parseHttpDestination( telemetryDest, host, port ) ) return;
+
+   // the ranks send to the node of rank 0 unless the endpoint names a host
+   char name[MPI_MAX_PROCESSOR_NAME] = "";
+   int length = 0;
+   if( rank_mpi == 0 ) MPI_Get_processor_name( name, &length );
+   MPI_Bcast( name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
+   if( host.size() == 0 ) host = name;
+
+   rankReporter = new MetricsReporter( host, port, rankMetrics );
+}
+
+// Has to be called by all ranks before the AmpToolsInterfaceMPI is built.
+void startRankTimers() {
+   delete rankReporter;
+   rankReporter = NULL;
+   startRankReporter();
+
+   fitStart = chrono::steady_clock::now();
+   resetMPIWaitTime();
+}
+
+void attachTelemetry(AmpToolsInterface& ati) {
+   if( telemetryDest.size() != 0 && rank_mpi == 0 ) telemetry = new FitTelemetry( ati, telemetryDest );
+}
+
+// with --checkpoint rank 0 saves the parameters, the function calls and
+// the fits that are done to this file now and then (see FitCheckpoint),
+// with --resume a job continues from it
+string checkpointFile;
+bool resumeFit = false;
+FitCheckpoint* checkpoint = NULL;
+
+void attachCheckpoint(AmpToolsInterface& ati) {
+   if( checkpointFile.size() == 0 || rank_mpi != 0 ) return;
+   checkpoint = new FitCheckpoint( ati, checkpointFile );
+   if( resumeFit ) checkpoint->resume();
+}
+
+// has to be called before the AmpToolsInterfaceMPI goes away
+void detachCheckpoint() {
+   delete checkpoint;
+   checkpoint = NULL;
+}
+
+// starts fit from the checkpoint if it was interrupted; returns true if so
+bool restoreFit(int fit) {
+   if( checkpoint == NULL ) return false;
+   checkpoint->startFit( fit );
+   return checkpoint->restore( fit );
+}
+
+void checkpointFit(int fit, bool fitFailed, double likelihood) {
+   if( checkpoint != NULL ) checkpoint->finishFit( fit, fitFailed, likelihood );
+}
+
+template< class T >
+void registerDataReader() {
+   if( balanceFile.size() != 0 )
+      AmpToolsInterface::registerDataReader( BalancedDataReaderMPI<T>() );
+   else
+      AmpToolsInterface::registerDataReader( DataReaderMPI<T>() );
+}
+
+// for readers that take the option slice=<i>/<n>
+template< class T >
+void registerSlicedDataReader() {
+   if( sliceRead )
+      AmpToolsInterface::registerDataReader( SlicedDataReaderMPI<T>() );
+   else
+      registerDataReader<T>();
+}
+
+// the weights of the ranks from the last fit, if there is one
+void readBalanceFile() {
+   if( balanceFile.size() == 0 || rank_mpi != 0 ) return;
+
+   ifstream in( balanceFile.c_str() );
+   if( !in ){
+      cout << "NO RANK SPEEDS IN " << balanceFile << " YET, THE EVENTS ARE SHARED EQUALLY" << endl;
+      return;
+   }
+
+   vector< double > weights;
+   string line;
+   while( getline( in, line ) ){
+      if( line.size() == 0 || line[0] == '#' ) continue;
+      int rank;
+      double events, busy, wait, eventsPerSecond;
+      if( !( istringstream( line ) >> rank >> events >> busy >> wait >> eventsPerSecond ) || rank < 0 ) continue;
+      if( rank >= (int)weights.size() ) weights.resize( rank + 1, 0 );
+      weights[rank] = eventsPerSecond;
+   }
+
+   if( (int)weights.size() != size )
+      cout << "WARNING:  " << balanceFile << " has " << weights.size() << " ranks, this job "
+           << size << "; ranks without a speed get the mean" << endl;
+   cout << "SHARING THE EVENTS BY THE RANK SPEEDS IN " << balanceFile << endl;
+
+   balancedDataReaderMPI::setRankWeights( weights );
+}
+
+double localEvents(AmpToolsInterface& ati) {
+   double events = 0;
+   vector< ReactionInfo* > reactions = ati.configurationInfo()->reactionList();
+   for(size_t i=0; i<reactions.size(); i++) {
+      DataReader* reader = ati.dataReader( reactions[i]->reactionName() );
+      if( reader != NULL ) events += reader->numEvents();
+   }
+   return events;
+}
+
+// The worker ranks only evaluate the likelihood, inside the AmpToolsInterfaceMPI,
+// until rank 0 calls exitMPI, so their share of the work is collected once
+// the fit is done:  the events each rank holds, its CPU and wall time and
+// the time it waited in MPI calls (see MPIWaitTime).  The rest of the wall
+// time is the time a rank was busy with its events.  Rank 0 prints the
+// table with the imbalance of the workers (the slowest over the mean busy
+// time), records it and, with -B, writes the events per busy second of
+// every rank for the next fit.  Has to be called by all ranks after exitMPI.
+void reportRanks(AmpToolsInterface& ati) {
+   delete rankReporter;
+   rankReporter = NULL;
+
+   if( telemetryDest.size() == 0 && balanceFile.size() == 0 ) return;
+
+   struct rusage usage;
+   getrusage( RUSAGE_SELF, &usage );
+
+   const int n = 4;
+   double local[n] = { localEvents( ati ),
+                       usage.ru_utime.tv_sec + 1e-6 * usage.ru_utime.tv_usec +
+                       usage.ru_stime.tv_sec + 1e-6 * usage.ru_stime.tv_usec,
+                       chrono::duration< double >( chrono::steady_clock::now() - fitStart ).count(),
+                       mpiWaitSeconds() };
+
+   vector< double > all( rank_mpi == 0 ? n * size : 0 );
+   MPI_Gather( local, n, MPI_DOUBLE, rank_mpi == 0 ? &(all[0]) : NULL, n, MPI_DOUBLE, 0, MPI_COMM_WORLD );
+
+   if( rank_mpi != 0 ) return;
+
+   // rank 0 leads the fit, the others share the events
+   int first = ( size > 1 ? 1 : 0 );
+   vector< double > busy( size );
+   double sumBusy = 0, maxBusy = 0;
+   for(int r=0; r<size; r++) {
+      busy[r] = max( 0.0, all[n*r+2] - all[n*r+3] );
+      if( r < first ) continue;
+      sumBusy += busy[r];
+      maxBusy = max( maxBusy, busy[r] );
+   }
+   double imbalance = ( sumBusy > 0 ? maxBusy * ( size - first ) / sumBusy : 1 );
+
+   cout << endl << "RANKS:" << endl;
+   cout << "   rank\t      events\t     cpu [s]\t    wall [s]\t    wait [s]\t    busy [s]" << endl;
+   string ranks;
+   for(int r=0; r<size; r++) {
+      cout << Form("   %4d\t%12.0f\t%12.2f\t%12.2f\t%12.2f\t%12.2f", r, all[n*r], all[n*r+1],
+                   all[n*r+2], all[n*r+3], busy[r]) << endl;
+      ranks += Form("%s{ \"rank\": %d, \"events\": %.0f, \"cpuSeconds\": %.3f, \"wallSeconds\": %.3f, \"waitSeconds\": %.3f }",
+                    r ? ", " : "", r, all[n*r], all[n*r+1], all[n*r+2], all[n*r+3]);
+   }
+   cout << "   IMBALANCE OF THE WORKERS (MAX / MEAN BUSY TIME):  " << imbalance << endl;
+
+   if( telemetry != NULL ){
+      telemetry->record( Form("\"type\": \"ranks\", \"imbalance\": %.4f, \"ranks\": [ %s ]",
+                              imbalance, ranks.c_str()) );
+      delete telemetry;
+      telemetry = NULL;
+   }
+
+   if( balanceFile.size() != 0 ){
+      ofstream out( balanceFile.c_str() );
+      out << "# rank  events  busy [s]  wait [s]  events per busy second" << endl;
+      for(int r=first; r<size; r++)
+         out << r << "  " << all[n*r] << "  " << busy[r] << "  " << all[n*r+3] << "  "
+             << ( busy[r] > 0 ? all[n*r] / busy[r] : 0 ) << endl;
+      if( out ) cout << "RANK SPEEDS WRITTEN TO " << balanceFile << endl;
+      else cout << "ERROR:  cannot write " << balanceFile << endl;
+   }
+}
+
+// the outcome of the fit with the current label
+void recordFit(bool fitFailed, double likelihood) {
+   if( telemetry == NULL ) return;
+   telemetry->record( Form("\"type\": \"fit\", \"failed\": %s, \"likelihood\": %.12g",
+                           fitFailed ? "true" : "false", likelihood) );
+}
+
+// Restricts each rank to one GPU of its node, chosen by the rank on the node
+// rather than the global rank, so that all GPUs of a node are used once when
+// ranks are placed on nodes in any order.  This has to happen before CUDA is
+// initialized, i.e., before the AmpToolsInterfaceMPI is constructed.  The
+// devices are taken from CUDA_VISIBLE_DEVICES if it is set by the batch
+// system and are 0 ... gpusPerNode-1 otherwise.
+void bindRankToGPU(int gpusPerNode) {
+
+   MPI_Comm nodeComm;
+   MPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank_mpi, MPI_INFO_NULL, &nodeComm );
+
+   int nodeRank, nodeSize;
+   MPI_Comm_rank( nodeComm, &nodeRank );
+   MPI_Comm_size( nodeComm, &nodeSize );
+   MPI_Comm_free( &nodeComm );
+
+   vector<string> devices;
+   const char* visible = getenv("CUDA_VISIBLE_DEVICES");
+   if( visible != NULL ){
+      stringstream list( visible );
+      string device;
+      while( getline( list, device, ',' ) )
+         if( device.size() != 0 ) devices.push_back( device );
+   }
+   if( devices.size() == 0 ){
+      for( int i = 0; i < gpusPerNode; i++ )
+         devices.push_back( to_string(i) );
+   }
+
+   if( nodeSize > (int)devices.size() && nodeRank == 0 )
+      cout << "WARNING: " << nodeSize << " ranks share " << devices.size()
+           << " GPUs on one node" << endl;
+
+   string device = devices[nodeRank % devices.size()];
+   setenv( "CUDA_VISIBLE_DEVICES", device.c_str(), 1 );
+
+   cout << "rank " << rank_mpi << " (" << nodeRank << " on its node) uses GPU " << device << endl;
+}
+
 double runSingleFit(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile) {
+   startRankTimers();
+   if( rank_mpi == 0 ) AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
    AmpToolsInterfaceMPI ati( cfgInfo );
+   attachTelemetry( ati );
+   attachCheckpoint( ati );
+   reportMemory( ati, cfgInfo );
    bool fitFailed = true;
    double lh = 1e7;
 
    if(rank_mpi==0) {
+      AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
       cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
+      if( normIntCache != NULL ) normIntCache->store( ati );
+      AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
+
+      restoreFit( -1 );
 
       MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
       fitManager->setMaxIterations(maxIter);
@@ -71,6 +542,7 @@ double runSingleFit(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, stri
          fitManager->migradMinimization();
 
       fitFailed = ( fitManager->status() != 0 && fitManager->eMatrixStatus() != 3 );
+      recordFit( fitFailed, ati.likelihood() );
 
       if( fitFailed )
          cout << "ERROR: fit failed use results with caution..." << endl;
@@ -78,32 +550,111 @@ double runSingleFit(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, stri
          lh = ati.likelihood();
 
       cout << "LIKELIHOOD AFTER MINIMIZATION:  " << lh << endl;
-      ati.finalizeFit();
+      finalizeFit(ati);
    }
 
 
    if( rank_mpi==0 && seedfile.size() != 0 && !fitFailed )
       ati.fitResults()->writeSeed( seedfile );
 
+   checkpointFit( -1, fitFailed, lh );
+   detachCheckpoint();
+
    ati.exitMPI();
+   writePlots( ati, cfgInfo );
+   reportProfile();
+   reportCompactFactors();
+   reportRanks( ati );
    MPI_Finalize();
 
    return lh;
 }
 
-void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, int numRnd, double maxFraction) {
+// the random number generators that randomizeProductionPars and
+// randomizeParameter may draw from
+void seedRandom(unsigned int seed) {
+   srand( seed );
+   srand48( seed );
+   gRandom->SetSeed( seed );
+}
+
+// with --keep-restarts every random restart i writes <fit>_<i>.fit and
+// <seed>_<i>.txt; otherwise only the best restart is written
+bool keepRestarts = false;
+
+// writes the restart i that was just fit on rank 0, if it is kept or the
+// best so far; the best is written with bestTag, i.e., as <fit>.fit if it
+// is empty
+void writeRndFit(AmpToolsInterfaceMPI& ati, const string& seedfile, int i, bool fitFailed, bool best, const string& bestTag) {
+   if( keepRestarts ) {
+      finalizeFit(ati, to_string(i));
+      if( seedfile.size() != 0 && !fitFailed )
+         ati.fitResults()->writeSeed( seedfile + Form("_%d.txt", i) );
+   }
+   if( best ) {
+      finalizeFit(ati, bestTag);
+      if( seedfile.size() != 0 )
+         ati.fitResults()->writeSeed( seedfile + ( bestTag.size() != 0 ? "_" + bestTag : "" ) + ".txt" );
+   }
+}
+
+struct RndFitResult {
+   int tag;
+   bool failed;
+   double likelihood;
+};
+
+// the status and likelihood of every restart, one line each, in
+// <fit>_restarts.txt
+void writeRestartTable(const string& fitName, vector< RndFitResult > results) {
+   sort( results.begin(), results.end(),
+         []( const RndFitResult& a, const RndFitResult& b ){ return a.tag < b.tag; } );
+
+   string fileName = fitName + "_restarts.txt";
+   ofstream out( fileName.c_str() );
+   out << "# fit\tstatus\tlikelihood" << endl;
+   out << setprecision( 12 );
+   for(size_t i=0; i<results.size(); i++)
+      out << results[i].tag << "\t" << ( results[i].failed ? "failed" : "converged" ) << "\t"
+          << results[i].likelihood << endl;
+   if( !out ) cout << "ERROR:  cannot write " << fileName << endl;
+}
+
+void reportBestRndFit(int numRnd, int minFitTag, double minLH) {
+   if(minFitTag < 0) cout << "ALL FITS FAILED!" << endl;
+   else cout << "MINIMUM LIKELIHOOD FROM " << minFitTag << " of " << numRnd << " RANDOM PRODUCTION PARS = " << minLH << endl;
+}
+
+// Runs the random fits firstFit, firstFit + fitStride, ... of numRnd on all
+// ranks.  If this job was started by runRndFitGroups, each restart is seeded
+// with its index and rank 0 reports every result (tag, status, likelihood)
+// to the parent job, which keeps track of the best fit; the group writes
+// the best of its own restarts as <fit>_group<firstFit>.fit.
+void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, int numRnd, double maxFraction, int firstFit, int fitStride) {
+   MPI_Comm parent;
+   MPI_Comm_get_parent( &parent );
+
+   startRankTimers();
+   if( rank_mpi == 0 ) AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
    AmpToolsInterfaceMPI ati( cfgInfo );
+   attachTelemetry( ati );
+   attachCheckpoint( ati );
+   reportMemory( ati, cfgInfo );
 
    MinuitMinimizationManager* fitManager = NULL; 
    vector< vector<string> > parRangeKeywords;
    double minLH;
    int minFitTag;
    string fitName;
+   vector< RndFitResult > results;
 
    if(rank_mpi==0) {
       fitName = cfgInfo->fitName();
 
+      AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
       cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
+      if( normIntCache != NULL ) normIntCache->store( ati );
+      AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
 
       fitManager = ati.minuitMinimizationManager();
       fitManager->setMaxIterations(maxIter);
@@ -115,20 +666,44 @@ void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
       minFitTag = -1;
    }
 
-   for(int i=0; i<numRnd; i++) {
+   for(int i=firstFit; i<numRnd; i+=fitStride) {
       bool fitFailed = true;
       double curLH = 1e7;
 
       if(rank_mpi==0) {
+
+         // the fits that an earlier job finished are reported as they were
+         if( checkpoint != NULL && checkpoint->finished( i ) ) {
+            const pair< bool, double >& done = checkpoint->finishedFits().find( i )->second;
+            cout << "FIT " << i << " IS DONE IN THE CHECKPOINT" << endl;
+            if( !done.first && done.second < minLH ) {
+               minLH = done.second;
+               minFitTag = i;
+            }
+            RndFitResult result = { i, done.first, done.second };
+            results.push_back( result );
+            if( parent != MPI_COMM_NULL ){
+               double result[3] = { (double)i, (double)done.first, done.second };
+               MPI_Send( result, 3, MPI_DOUBLE, 0, 0, parent );
+            }
+            continue;
+         }
+
          cout << endl << "###############################" << endl;
          cout << "FIT " << i << " OF " << numRnd << endl;
          cout << endl << "###############################" << endl;
 
+         // with a checkpoint the starting point of a restart does not
+         // depend on the fits before it, which a resumed job skips
+         if( parent != MPI_COMM_NULL || checkpoint != NULL ) seedRandom( i + 1 );
+         if( telemetry != NULL ) telemetry->setLabel( Form("rnd %d", i) );
+
          // randomize parameters
          ati.randomizeProductionPars(maxFraction);
          for(size_t ipar=0; ipar<parRangeKeywords.size(); ipar++) {
             ati.randomizeParameter(parRangeKeywords[ipar][0], atof(parRangeKeywords[ipar][1].c_str()), atof(parRangeKeywords[ipar][2].c_str()));
          }
+         restoreFit( i );
 
          if(useMinos)
             fitManager->minosMinimization();
@@ -141,35 +716,164 @@ void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
             cout << "ERROR: fit failed use results with caution..." << endl;
 
          curLH = ati.likelihood();
+         recordFit( fitFailed, curLH );
          cout << "LIKELIHOOD AFTER MINIMIZATION:  " << curLH << endl;
 
-         if( seedfile.size() != 0 && !fitFailed ){
-            string seedfile_rand = seedfile + Form("_%d.txt", i);
-            ati.fitResults()->writeSeed( seedfile_rand );
-         }
+         RndFitResult result = { i, fitFailed, curLH };
+         results.push_back( result );
 
-         // update best fit
-         if( !fitFailed && curLH < minLH ) {
+         // update best fit, which is written right away
+         bool best = ( !fitFailed && curLH < minLH );
+         if( best ) {
             minLH = curLH;
             minFitTag = i;
          }
-         ati.finalizeFit(to_string(i));
+         writeRndFit(ati, seedfile, i, fitFailed, best,
+                     parent != MPI_COMM_NULL ? Form("group%d", firstFit) : "");
+         checkpointFit( i, fitFailed, curLH );
+
+         if( parent != MPI_COMM_NULL ){
+            double result[3] = { (double)i, (double)fitFailed, curLH };
+            MPI_Send( result, 3, MPI_DOUBLE, 0, 0, parent );
+         }
       }
    }
 
-
-   // print best fit results
    if(rank_mpi==0) {
-      if(minFitTag < 0) cout << "ALL FITS FAILED!" << endl;
+      if( parent != MPI_COMM_NULL ){
+         // tells the parent that this group is done
+         double result[3] = { -1, 1, 0 };
+         MPI_Send( result, 3, MPI_DOUBLE, 0, 0, parent );
+      }
       else {
-         cout << "MINIMUM LIKELIHOOD FROM " << minFitTag << " of " << numRnd << " RANDOM PRODUCTION PARS = " << minLH << endl;
-         gSystem->Exec(Form("cp %s_%d.fit %s.fit", fitName.data(), minFitTag, fitName.data()));
-         if( seedfile.size() != 0 )
-            gSystem->Exec(Form("cp %s_%d.txt %s.txt", seedfile.data(), minFitTag, seedfile.data()));
+         reportBestRndFit(numRnd, minFitTag, minLH);
+         writeRestartTable(fitName, results);
       }
    }
+   detachCheckpoint();
 
    ati.exitMPI();
+   reportProfile();
+   reportCompactFactors();
+   reportRanks( ati );
+   if( parent != MPI_COMM_NULL ) MPI_Comm_disconnect( &parent );
+   MPI_Finalize();
+}
+
+// Runs the random fits in numGroups concurrent jobs of groupSize ranks each,
+// e.g., 16 fits at a time on 32 ranks each instead of one fit on 512 ranks.
+// AmpToolsInterfaceMPI distributes the likelihood over all of
+// MPI_COMM_WORLD, so the groups cannot be sub-communicators of this job.
+// Instead every group is a job of its own, spawned with the command line of
+// this one plus the restarts it runs (-t <first> -T <stride>).  This job
+// runs on a single rank and only collects the results of the groups.
+void runRndFitGroups(int argc, char* argv[], ConfigurationInfo* cfgInfo, string seedfile, int numRnd, int numGroups, int groupSize) {
+
+   if( numGroups > numRnd ) numGroups = numRnd;
+
+   // the command line of the groups, without the options of this job
+   vector<string> args;
+   for (int i = 1; i < argc; i++){
+      string arg(argv[i]);
+      if (arg == "-G" || arg == "-P") { ++i; continue; }
+      args.push_back(arg);
+   }
+
+   vector<MPI_Comm> groups( numGroups, MPI_COMM_NULL );
+   for (int g = 0; g < numGroups; g++){
+
+      vector<string> groupArgs( args );
+      groupArgs.push_back("-t");
+      groupArgs.push_back(to_string(g));
+      groupArgs.push_back("-T");
+      groupArgs.push_back(to_string(numGroups));
+
+      vector<char*> groupArgv;
+      for (size_t i = 0; i < groupArgs.size(); i++)
+         groupArgv.push_back( const_cast<char*>( groupArgs[i].c_str() ) );
+      groupArgv.push_back( NULL );
+
+      cout << "starting fit group " << g << " on " << groupSize << " ranks" << endl;
+      MPI_Comm_spawn( argv[0], &groupArgv[0], groupSize, MPI_INFO_NULL, 0,
+                      MPI_COMM_SELF, &groups[g], MPI_ERRCODES_IGNORE );
+   }
+
+   // wait for results from any group
+   vector<MPI_Request> requests( numGroups );
+   vector< vector<double> > results( numGroups, vector<double>(3) );
+   for (int g = 0; g < numGroups; g++)
+      MPI_Irecv( &results[g][0], 3, MPI_DOUBLE, 0, 0, groups[g], &requests[g] );
+
+   multimap< double, int > leaderboard;
+   vector< RndFitResult > fitResults;
+   int nDone = 0, nFailed = 0, nRunning = numGroups;
+
+   while( nRunning > 0 ){
+
+      int g;
+      MPI_Waitany( numGroups, &requests[0], &g, MPI_STATUS_IGNORE );
+
+      int tag = (int)results[g][0];
+      if( tag < 0 ){
+         MPI_Comm_disconnect( &groups[g] );
+         --nRunning;
+         continue;
+      }
+
+      bool fitFailed = ( results[g][1] != 0 );
+      double curLH = results[g][2];
+
+      RndFitResult result = { tag, fitFailed, curLH };
+      fitResults.push_back( result );
+
+      ++nDone;
+      if( fitFailed ) ++nFailed;
+      else leaderboard.insert( make_pair( curLH, tag ) );
+
+      cout << "FINISHED FIT " << tag << " IN GROUP " << g << " (" << nDone << " OF " << numRnd << "):  "
+           << ( fitFailed ? "FAILED" : Form("LIKELIHOOD = %f", curLH) );
+      if( !leaderboard.empty() )
+         cout << "   BEST SO FAR " << leaderboard.begin()->second << ":  " << leaderboard.begin()->first;
+      cout << endl;
+
+      MPI_Irecv( &results[g][0], 3, MPI_DOUBLE, 0, 0, groups[g], &requests[g] );
+   }
+
+   if( nDone < numRnd )
+      cout << "ERROR:  only " << nDone << " of " << numRnd << " fits reported a result" << endl;
+
+   cout << endl << "LEADERBOARD (" << nFailed << " FAILED FITS):" << endl;
+   int rank = 0;
+   for( multimap< double, int >::iterator it = leaderboard.begin();
+        it != leaderboard.end() && rank < 10; ++it, ++rank )
+      cout << "   " << rank + 1 << ".  FIT " << it->second << ":  " << it->first << endl;
+
+   string fitName = cfgInfo->fitName();
+   if( leaderboard.empty() ) reportBestRndFit(numRnd, -1, 0);
+   else {
+      int best = leaderboard.begin()->second;
+      reportBestRndFit(numRnd, best, leaderboard.begin()->first);
+
+      // the best fit of the group that ran it
+      string from = fitName + Form("_group%d", best % numGroups);
+      if( rename( ( from + ".fit" ).c_str(), ( fitName + ".fit" ).c_str() ) != 0 )
+         cout << "ERROR:  cannot move " << from << ".fit to " << fitName << ".fit" << endl;
+      for( const char* companion : fitCompanions ){
+         if( access( ( from + companion ).c_str(), F_OK ) == 0 )
+            rename( ( from + companion ).c_str(), ( fitName + companion ).c_str() );
+      }
+      from = seedfile + Form("_group%d", best % numGroups);
+      if( seedfile.size() != 0 && rename( ( from + ".txt" ).c_str(), ( seedfile + ".txt" ).c_str() ) != 0 )
+         cout << "ERROR:  cannot move " << from << ".txt to " << seedfile << ".txt" << endl;
+   }
+   for (int g = 0; g < numGroups; g++){
+      remove( Form("%s_group%d.fit", fitName.data(), g) );
+      for( const char* companion : fitCompanions )
+         remove( Form("%s_group%d%s", fitName.data(), g, companion) );
+      if( seedfile.size() != 0 ) remove( Form("%s_group%d.txt", seedfile.data(), g) );
+   }
+   writeRestartTable(fitName, fitResults);
+
    MPI_Finalize();
 }
 
@@ -196,14 +900,21 @@ void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
       }
    }
 
+   startRankTimers();
+   if( rank_mpi == 0 ) AmplitudeProfiler::setPhase( AmplitudeProfiler::kSetup );
    AmpToolsInterfaceMPI ati( cfgInfo );
+   attachTelemetry( ati );
+   reportMemory( ati, cfgInfo );
    string fitName;
    ParameterManager* parMgr = NULL;
    MinuitMinimizationManager* fitManager = NULL;
 
    if(rank_mpi==0) {
       fitName = cfgInfo->fitName();
+      AmplitudeProfiler::setPhase( AmplitudeProfiler::kFirstLikelihood );
       cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
+      if( normIntCache != NULL ) normIntCache->store( ati );
+      AmplitudeProfiler::setPhase( AmplitudeProfiler::kFit );
 
       parMgr = ati.parameterManager();
       fitManager = ati.minuitMinimizationManager();
@@ -236,6 +947,7 @@ void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
          double value = minVal + i*stepSize;
          parMgr->setAmpParameter( parScan, value );
          cfgInfo->setFitName( fitName + "_scan" );
+         if( telemetry != NULL ) telemetry->setLabel( Form("scan %d", i) );
 
          if(useMinos)
             fitManager->minosMinimization();
@@ -244,6 +956,7 @@ void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
 
          fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
          curLH = ati.likelihood();
+         recordFit( fitFailed, curLH );
 
          if( fitFailed )
             cout << "ERROR: fit failed use results with caution..." << endl;
@@ -254,10 +967,13 @@ void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
             string seedfile_scan = seedfile + Form("_scan_%d.dat", i);
             ati.fitResults()->writeSeed( seedfile_scan );
          }
-         ati.finalizeFit(to_string(i));
+         finalizeFit(ati, to_string(i));
       }
    }
    ati.exitMPI();
+   reportProfile();
+   reportCompactFactors();
+   reportRanks( ati );
    MPI_Finalize();
 }
 
@@ -274,9 +990,17 @@ int main( int argc, char* argv[] ){
 
    string configfile;
    string seedfile;
+   string normIntDir;
    string scanPar;
    int numRnd = 0;
    int maxIter = 10000;
+   int gpusPerNode = 0;
+   int numGroups = 0;
+   int groupSize = 0;
+   int firstFit = 0;
+   int fitStride = 1;
+   bool hierarchical = false;
+   bool reproducible = false;
 
    // parse command line
 
@@ -287,6 +1011,9 @@ int main( int argc, char* argv[] ){
       if (arg == "-c"){  
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  configfile = argv[++i]; }
+      if (arg == "-N"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  normIntDir = argv[++i]; }
       if (arg == "-s"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  seedfile = argv[++i]; }
@@ -300,6 +1027,54 @@ int main( int argc, char* argv[] ){
       if (arg == "-p"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  scanPar = argv[++i]; }
+      if (arg == "-g"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  gpusPerNode = atoi(argv[++i]); }
+      if (arg == "-G"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numGroups = atoi(argv[++i]); }
+      if (arg == "-P"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  groupSize = atoi(argv[++i]); }
+      if (arg == "-t"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  firstFit = atoi(argv[++i]); }
+      if (arg == "-T"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  fitStride = atoi(argv[++i]); }
+      if (arg == "--profile"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) profileFile = "profile.json";
+         else  profileFile = argv[++i]; }
+      if (arg == "--uservars-dir"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  userVarsDir = argv[++i]; }
+      if (arg == "-H") hierarchical = true;
+      if (arg == "--reproducible") reproducible = true;
+      if (arg == "-j"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numThreads = atoi(argv[++i]); }
+      if (arg == "--numa") pinThreads = true;
+      if (arg == "--huge-pages") hugePages = true;
+      if (arg == "--compact-factors") compactFactors = true;
+      if (arg == "--compact-factors-check") compactFactors = checkCompactFactors = true;
+      if (arg == "--intensity-table") writeIntensityTable = true;
+      if (arg == "--binary-results") writeCompactResults = true;
+      if (arg == "--plot"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-') || !FitProjections::known(argv[i+1])) arg = "-h";
+         else  plotGenerator = argv[++i]; }
+      if (arg == "--keep-restarts") keepRestarts = true;
+      if (arg == "-B"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  balanceFile = argv[++i]; }
+      if (arg == "--memory-report") memoryReport = true;
+      if (arg == "--slice-read") sliceRead = true;
+      if (arg == "--telemetry"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  telemetryDest = argv[++i]; }
+      if (arg == "--checkpoint"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  checkpointFile = argv[++i]; }
+      if (arg == "--resume") resumeFit = true;
       if (arg == "-h"){
          if(rank_mpi==0) {
             cout << endl << " Usage for: " << argv[0] << endl << endl;
@@ -309,6 +1084,30 @@ int main( int argc, char* argv[] ){
             cout << "   -r <int>\t\t\t Perform <int> fits each seeded with random parameters" << endl;
             cout << "   -p <parameter> \t\t\t\t Perform a scan of given parameter. Stepsize, min, max are to be set in cfg file" << endl;
             cout << "   -m <int>\t\t\t Maximum number of fit iterations" << endl; 
+            cout << "   -N <dir>\t\t\t Cache the normalization integrals of reactions without free amplitude parameters in <dir>" << endl;
+            cout << "   --profile [file]\t\t\t Time the amplitudes, print a table and write it to <file> (default: profile.json)" << endl;
+            cout << "   --uservars-dir <dir>\t\t Keep the static user variables of the events of every rank in files in <dir> and read them there in later jobs with the same events and ranks" << endl;
+            cout << "   --memory-report\t\t\t Print the memory of the events and user variables of the rank with the most and the totals of all ranks" << endl;
+            cout << "   --telemetry <dest>\t\t\t Record every likelihood evaluation to <dest>: a JSON lines file, a .prom file, udp://host:port or http://[host]:port, served on rank 0 with the metrics of every rank" << endl;
+            cout << "   --checkpoint <file>\t\t Save the parameters and the fits done to <file> every minute and after every fit (-r, single fits)" << endl;
+            cout << "   --resume\t\t\t\t Continue from the file of --checkpoint:  skip the fits done and start the one interrupted where it stopped" << endl;
+            cout << "   -B <file>\t\t\t Share the events among the ranks by their speeds in the last fit, kept in <file>" << endl;
+            cout << "   --slice-read\t\t\t Each worker reads its own slice of the ROOTDataReader and BinaryDataReader files, instead of rank 0 reading and sending them" << endl;
+            cout << "   -j <int>\t\t\t Share the events of each rank over <int> threads (one rank per node or socket)" << endl;
+            cout << "   --numa\t\t\t Pin the threads of -j to the CPUs of the rank and give each the same events every time" << endl;
+            cout << "   --huge-pages\t\t Back the user variables and amplitudes of -j with 2 MB transparent huge pages" << endl;
+            cout << "   --compact-factors\t\t Cache the per-event factors of fixed-shape amplitudes (Zlm, Vec_ps_refl) in single precision" << endl;
+            cout << "   --compact-factors-check\t\t As --compact-factors and print the largest relative rounding error of the cached factors" << endl;
+            cout << "   --intensity-table\t\t Write the intensities and fractions of every amplitude, interference term and sum, with errors, next to each .fit file" << endl;
+            cout << "   --binary-results\t\t Also write each fit as a binary .fitb file, which the moment tools load faster" << endl;
+            cout << "   --plot <generator>\t\t Fill the histograms of the plot generator (TwoPiPlotGenerator, VecPsPlotGenerator, ThreePiPlotGeneratorSchilling, EtaPiDeltaPlotGenerator) from the events of all ranks after a single fit and write them to <fit>_plots.root" << endl;
+            cout << "   --keep-restarts\t\t With -r, also write the .fit and seed files of every restart, not only of the best" << endl;
+            cout << "   -H \t\t\t\t\t Reduce within each node before the reduction between nodes" << endl;
+            cout << "   --reproducible\t\t\t Add the sums of the ranks exactly, so the result does not depend on the order of the reduction" << endl;
+            cout << "   -g <int>\t\t\t Bind each rank to one of <int> GPUs per node (GPU builds)" << endl;
+            cout << "   -G <int>\t\t\t Run the fits of -r in <int> groups of ranks at the same time" << endl;
+            cout << "   -P <int>\t\t\t Number of ranks of each group of -G (default: MPI universe size / groups)" << endl;
+            cout << "   -t <int> -T <int>\t\t Only run the random fits <int>, <int> + stride, ... (set by -G)" << endl;
          }
          MPI_Finalize();
          exit(1);
@@ -321,38 +1120,89 @@ int main( int argc, char* argv[] ){
       exit(1);
    }
 
+   if (resumeFit && checkpointFile.size() == 0){
+      if (rank_mpi == 0) cout << "--resume needs the file of --checkpoint" << endl;
+      MPI_Finalize();
+      exit(1);
+   }
+
+   if (numGroups > 0 && numRnd > 0){
+
+      if (size != 1){
+         if (rank_mpi == 0) cout << "ERROR:  -G starts its own jobs and has to be run on one rank" << endl;
+         MPI_Finalize();
+         exit(1);
+      }
+
+      if (groupSize <= 0){
+         int* universeSize;
+         int flag;
+         MPI_Comm_get_attr( MPI_COMM_WORLD, MPI_UNIVERSE_SIZE, &universeSize, &flag );
+         if (flag && *universeSize > 1) groupSize = ( *universeSize - 1 ) / numGroups;
+      }
+
+      if (groupSize <= 0){
+         cout << "ERROR:  cannot tell the number of ranks per group, set it with -P" << endl;
+         MPI_Finalize();
+         exit(1);
+      }
+
+      ConfigFileParser parser(configfile);
+      runRndFitGroups(argc, argv, parser.getConfigurationInfo(), seedfile, numRnd, numGroups, groupSize);
+      return 0;
+   }
+
+   if (gpusPerNode > 0) bindRankToGPU(gpusPerNode);
+   if (hierarchical) enableHierarchicalCollectives();
+   if (reproducible) enableReproducibleCollectives();
+#ifndef GPU_ACCELERATION
+   if (numThreads > 1){
+      AmplitudeThreads::setNumThreads(numThreads);
+      AmplitudeThreads::setPinned(pinThreads);
+      AmplitudeThreads::setHugePages(hugePages);
+   }
+#else
+   numThreads = 1;
+#endif
+   FactorCache::setCompact(compactFactors, checkCompactFactors);
+
+   // the user variables are only needed once per process, from the files
+   if (userVarsDir.size() != 0){
+      UserVarsCache::setMaxBytes(0);
+      UserVarsCache::setDirectory(userVarsDir);
+   }
+
+   // the groups of -G are separate jobs with a report each
+   if (profileFile.size() != 0 && fitStride > 1)
+      profileFile += Form(".group%d", firstFit);
+   if (telemetryDest.size() != 0 && fitStride > 1)
+      telemetryDest = FitTelemetry::workerDestination(telemetryDest, Form("group%d", firstFit));
+   if (balanceFile.size() != 0 && fitStride > 1)
+      balanceFile += Form(".group%d", firstFit);
+   if (checkpointFile.size() != 0 && fitStride > 1)
+      checkpointFile += Form(".group%d", firstFit);
+   readBalanceFile();
+
    ConfigFileParser parser(configfile);
    ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
    if( rank_mpi == 0 ) cfgInfo->display();
 
-   AmpToolsInterface::registerAmplitude( BreitWigner() );
-   AmpToolsInterface::registerAmplitude( BreitWigner3body() );
-   AmpToolsInterface::registerAmplitude( TwoPSAngles() );
-   AmpToolsInterface::registerAmplitude( TwoPSHelicity() );
-   AmpToolsInterface::registerAmplitude( TwoPiAngles() );
-   AmpToolsInterface::registerAmplitude( TwoPiAngles_amp() );
-   AmpToolsInterface::registerAmplitude( TwoPiAngles_primakoff() );
-   AmpToolsInterface::registerAmplitude( TwoPiWt_primakoff() );
-   AmpToolsInterface::registerAmplitude( TwoPiWt_sigma() );
-   AmpToolsInterface::registerAmplitude( TwoPitdist() );
-   AmpToolsInterface::registerAmplitude( ThreePiAngles() );
-   AmpToolsInterface::registerAmplitude( ThreePiAnglesSchilling() );
-   AmpToolsInterface::registerAmplitude( TwoPiAnglesRadiative() );
-   AmpToolsInterface::registerAmplitude( Zlm() );
-   AmpToolsInterface::registerAmplitude( b1piAngAmp() );
-   AmpToolsInterface::registerAmplitude( omegapiAngAmp() );
-   AmpToolsInterface::registerAmplitude( polCoef() );
-   AmpToolsInterface::registerAmplitude( Uniform() );
-   AmpToolsInterface::registerAmplitude( dblRegge() );
-   AmpToolsInterface::registerAmplitude( omegapi_amplitude() );
-   AmpToolsInterface::registerAmplitude( Vec_ps_refl() );
-   AmpToolsInterface::registerAmplitude( Piecewise() );
-   AmpToolsInterface::registerAmplitude( Flatte() );
-
-   AmpToolsInterface::registerDataReader( DataReaderMPI<ROOTDataReader>() );
-   AmpToolsInterface::registerDataReader( DataReaderMPI<ROOTDataReaderBootstrap>() );
-   AmpToolsInterface::registerDataReader( DataReaderMPI<ROOTDataReaderWithTCut>() );
-   AmpToolsInterface::registerDataReader( DataReaderMPI<ROOTDataReaderTEM>() );
+   if (normIntDir.size() != 0){
+      normIntCache = new NormIntCache(normIntDir);
+      normIntCache->prepare(cfgInfo);
+   }
+
+   registerAmplitudes(cfgInfo);
+
+   registerSlicedDataReader< ROOTDataReader >();
+   registerDataReader< ROOTDataReaderBootstrap >();
+   registerDataReader< ROOTDataReaderWithTCut >();
+   registerDataReader< ROOTDataReaderBinned >();
+   registerDataReader< ROOTDataReaderTEM >();
+   registerDataReader< ROOTDataReaderFlat >();
+   registerDataReader< ROOTDataReaderPipeline >();
+   registerSlicedDataReader< BinaryDataReader >();
+   registerDataReader< PhaseSpaceDataReader >();
 
    if(numRnd==0){
       if(scanPar=="")
@@ -360,7 +1210,7 @@ int main( int argc, char* argv[] ){
       else
          runParScan(cfgInfo, useMinos, maxIter, seedfile, scanPar);
    } else {
-      runRndFits(cfgInfo, useMinos, maxIter, seedfile, numRnd, 0.5);
+      runRndFits(cfgInfo, useMinos, maxIter, seedfile, numRnd, 0.5, firstFit, fitStride);
    }
 
    return 0;
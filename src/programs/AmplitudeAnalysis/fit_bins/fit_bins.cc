@@ -0,0 +1,663 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// Runs the fits of a grid of bins, as made by divideData.pl or split_bins,
+// in a pool of fit processes.  Bin (i, j, ...) is fit in the directory
+// bin_i_j... of the fit directory with the configuration file
+// bin_i_j....cfg, which includes the seed file.
+//
+// Seeds are chained along neighbouring bins: the bins form a tree grown
+// outward from the start bins (breadth first, neighbours differ by one in
+// one index), and a bin is fit once its parent is done, starting from the
+// parameters of the nearest converged bin on its path to the start.  Bins
+// in different branches run at the same time.  The start bins use the
+// seed file of the fit directory if there is one.
+//
+// Bins of tens of thousands of events do not fill a GPU, and a process
+// per bin spends much of its time creating its device context and
+// loading the amplitudes.  With -b a fit process takes up to that many
+// bins that are ready and fits them one after the other (fit -l) with one
+// context, and with -g the processes are spread over the GPUs of the node
+// (CUDA_VISIBLE_DEVICES), -j / -g of them on each, so that the small fits
+// of several processes overlap on every device.
+//
+// The bins are started largest first.  The time of a bin is estimated
+// from its configuration, as the bytes of its data and accepted MC files
+// (for the events) times its amplitudes times the fits of -r, plus the
+// generated MC once, and calibrated with the times measured before:  the
+// wall time of every bin that fit_bins ran is kept in fit_bins_times.txt
+// of the fit directory, and a bin fit with --profile has the time of its
+// fit in profile.json.  A measured bin takes its measured time, the others
+// the model scaled by the measured bins.  Of the bins that are ready, the
+// one with the longest chain of bins still to fit below it goes first, so
+// the largest bins and long chains do not start last and keep the pool
+// waiting.  With -F the bins are instead split into farm jobs of about
+// equal time, largest first onto the least loaded job, and written as
+// lists for fit -l.
+
+enum BinState { kWaiting, kRunning, kDone };
+
+struct Bin {
+
+  string name;
+  vector< int > index;
+
+  int parent;
+  BinState state;
+  bool converged;
+
+  pid_t pid;
+  time_t start;
+
+  // the model of the configuration, the time measured in an earlier run
+  // (0 if none), the estimated time, and the estimated time of the longest
+  // chain of bins from this one
+  double units;
+  double measured;
+  double seconds;
+  double priority;
+};
+
+// the seed a fit process of -b writes in the directory of each of its
+// bins, renamed to the seed of the bin when it is done
+static const char* kBatchSeed = "fit_bins_seed.cfg";
+
+// the wall time of every bin fit, one line "<bin> <seconds>" per fit, the
+// last line of a bin counting
+static const char* kTimesFile = "fit_bins_times.txt";
+
+void Usage()
+{
+  cout << "Usage:\n  fit_bins <fitDir> <nBins> [nBins ...] [OPTIONS]\n\n";
+  cout << "  Fits bin_<i>[_<j>...]/bin_<i>[_<j>...].cfg for every bin of the grid\n";
+  cout << "  with nBins bins along each axis.\n\n";
+  cout << "  Options: \n";
+  cout << "   -j [nFits]   : Number of fits run at the same time (default: number of cores)\n";
+  cout << "   -S [bin]     : Start the seed chains at this bin, e.g. 10 or 3_2 (may be repeated, default: 0)\n";
+  cout << "   -i           : Independent bins, every bin starts from the seed file of the fit directory\n";
+  cout << "   -s [file]    : Seed file included by the bin configurations (default: param_init.cfg)\n";
+  cout << "   -R           : Resume, skip bins that have a fit result already\n";
+  cout << "   -e [program] : Fit program (default: fit)\n";
+  cout << "   -a [args]    : Additional arguments of the fit program, e.g. \"-r 10\"\n";
+  cout << "   -b [nBins]   : Fit up to nBins ready bins per fit process, one after the other (default: 1)\n";
+  cout << "   -g [nGPUs]   : Spread the fit processes over nGPUs GPUs, -j / nGPUs on each\n";
+  cout << "   -F [nJobs]   : With -i, write the bins as nJobs lists of about equal time for a farm job array,\n";
+  cout << "                  fit_bins_array<k>.list for fit -l, instead of fitting them\n";
+  exit(1);
+}
+
+bool FileExists( const string& name )
+{
+  return access( name.c_str(), F_OK ) == 0;
+}
+
+bool CopyFile( const string& from, const string& to )
+{
+  ifstream in( from.c_str(), ios::binary );
+  ofstream out( to.c_str(), ios::binary );
+  return in && ( out << in.rdbuf() );
+}
+
+string BinName( const vector< int >& index )
+{
+  ostringstream name;
+  name << "bin";
+  for( unsigned int i = 0; i < index.size(); ++i ) name << "_" << index[i];
+  return name.str();
+}
+
+// the seed the fit of a bin writes, which the bins next to it start from
+string SeedOut( const Bin& bin )
+{
+  return bin.name + "_seed.cfg";
+}
+
+double FileBytes( const string& name )
+{
+  struct stat info;
+  return stat( name.c_str(), &info ) == 0 ? info.st_size : 0;
+}
+
+// The cost of the fit of a bin in the units of the model:  the bytes of
+// the data and accepted MC, which the likelihood loops over in every
+// iteration, and of the generated MC, which is integrated once, times
+// the amplitudes, the data and accepted MC again for every fit of -r.
+// Files of readers that are not files count as nothing; a bin without
+// files counts its amplitudes only.
+double ModelUnits( const Bin& bin, int nFits )
+{
+  ifstream cfg( ( bin.name + "/" + bin.name + ".cfg" ).c_str() );
+
+  double loopBytes = 0, genBytes = 0;
+  int nAmps = 0;
+
+  string line;
+  while( getline( cfg, line ) ){
+
+    istringstream words( line );
+    string keyword, reaction, reader, file;
+    words >> keyword >> reaction >> reader >> file;
+
+    if( keyword == "amplitude" ) ++nAmps;
+    else if( keyword == "data" || keyword == "accmc" || keyword == "bkgnd" )
+      loopBytes += FileBytes( bin.name + "/" + file );
+    else if( keyword == "genmc" )
+      genBytes += FileBytes( bin.name + "/" + file );
+  }
+
+  if( loopBytes + genBytes == 0 ) loopBytes = 1;
+  return ( nFits * loopBytes + genBytes ) * ( nAmps > 0 ? nAmps : 1 );
+}
+
+// the seconds of the phases of a profile of AmplitudeProfiler, 0 if
+// there is none
+double ProfiledSeconds( const string& fileName )
+{
+  ifstream in( fileName.c_str() );
+
+  string line;
+  while( getline( in, line ) ){
+
+    if( line.find( "\"phases\"" ) == string::npos ) continue;
+
+    double seconds = 0;
+    for( size_t pos = line.find( ':', line.find( '{' ) ); pos != string::npos;
+         pos = line.find( ':', pos + 1 ) )
+      seconds += atof( line.c_str() + pos + 1 );
+
+    return seconds;
+  }
+
+  return 0;
+}
+
+// the number of fits of the arguments of the fit program, 1 + the random
+// fits of -r
+int NumFits( const string& fitArgs )
+{
+  istringstream words( fitArgs );
+  string word;
+  while( words >> word )
+    if( word == "-r" && words >> word ) return 1 + max( 0, atoi( word.c_str() ) );
+
+  return 1;
+}
+
+int main( int argc, char* argv[] ){
+
+  if( argc < 3 ) Usage();
+
+  string fitDir( argv[1] );
+  vector< int > numBins;
+
+  int nJobs = sysconf( _SC_NPROCESSORS_ONLN );
+  vector< string > startNames;
+  bool independent = false;
+  bool resume = false;
+  string seedFile( "param_init.cfg" );
+  string fitProgram( "fit" );
+  string fitArgs;
+  int batchSize = 1;
+  int nGPUs = 0;
+  int nFarmJobs = 0;
+
+  for( int i = 2; i < argc; ++i ){
+
+    string arg = argv[i];
+
+    if( arg[0] != '-' ){
+      if( !startNames.empty() || independent || resume ) Usage();
+      numBins.push_back( atoi( argv[i] ) );
+      if( numBins.back() <= 0 ) Usage();
+    }
+    else if( arg == "-j" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else nJobs = atoi( argv[++i] );
+    } else if( arg == "-S" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else startNames.push_back( string( "bin_" ) + argv[++i] );
+    } else if( arg == "-i" ){
+      independent = true;
+    } else if( arg == "-s" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else seedFile = argv[++i];
+    } else if( arg == "-R" ){
+      resume = true;
+    } else if( arg == "-e" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else fitProgram = argv[++i];
+    } else if( arg == "-a" ){
+      if (i+1 == argc) Usage();
+      else fitArgs = argv[++i];
+    } else if( arg == "-b" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else batchSize = atoi( argv[++i] );
+    } else if( arg == "-g" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else nGPUs = atoi( argv[++i] );
+    } else if( arg == "-F" ){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else nFarmJobs = atoi( argv[++i] );
+    } else {
+      Usage();
+    }
+  }
+
+  if( numBins.empty() || nJobs <= 0 || batchSize <= 0 || nGPUs < 0 || nFarmJobs < 0 ) Usage();
+
+  // the jobs of a farm run at the same time, so they cannot wait for seeds
+  if( nFarmJobs > 0 && !independent ){
+
+    cout << "fit_bins ERROR:  -F needs independent bins (-i)" << endl;
+    exit(1);
+  }
+
+  // the grid, the last index varies fastest as in split_bins
+  vector< Bin > bins;
+  map< string, int > binIndex;
+
+  int nTotal = 1;
+  for( unsigned int i = 0; i < numBins.size(); ++i ) nTotal *= numBins[i];
+
+  for( int iBin = 0; iBin < nTotal; ++iBin ){
+
+    Bin bin;
+    bin.index.resize( numBins.size() );
+    int rest = iBin;
+    for( int i = numBins.size() - 1; i >= 0; --i ){
+
+      bin.index[i] = rest % numBins[i];
+      rest /= numBins[i];
+    }
+    bin.name = BinName( bin.index );
+    bin.parent = -1;
+    bin.state = kWaiting;
+    bin.converged = false;
+    bin.pid = 0;
+    bin.start = 0;
+    bin.units = 0;
+    bin.measured = 0;
+    bin.seconds = 0;
+    bin.priority = 0;
+
+    binIndex[bin.name] = iBin;
+    bins.push_back( bin );
+  }
+
+  if( startNames.empty() ) startNames.push_back( bins[0].name );
+
+  // the seed chains, breadth first from the start bins
+  vector< int > order;
+  if( independent ){
+
+    for( int iBin = 0; iBin < nTotal; ++iBin ) order.push_back( iBin );
+  }
+  else{
+
+    vector< bool > seen( nTotal, false );
+    deque< int > queue;
+    for( unsigned int i = 0; i < startNames.size(); ++i ){
+
+      if( binIndex.find( startNames[i] ) == binIndex.end() ){
+
+        cout << "fit_bins ERROR:  start bin " << startNames[i] << " is not in the grid" << endl;
+        exit(1);
+      }
+      int iBin = binIndex[startNames[i]];
+      if( !seen[iBin] ) queue.push_back( iBin );
+      seen[iBin] = true;
+    }
+
+    while( !queue.empty() ){
+
+      int iBin = queue.front();
+      queue.pop_front();
+      order.push_back( iBin );
+
+      for( unsigned int axis = 0; axis < numBins.size(); ++axis ){
+        for( int step = -1; step <= 1; step += 2 ){
+
+          vector< int > index( bins[iBin].index );
+          index[axis] += step;
+          if( index[axis] < 0 || index[axis] >= numBins[axis] ) continue;
+
+          int iNext = binIndex[BinName( index )];
+          if( seen[iNext] ) continue;
+
+          seen[iNext] = true;
+          bins[iNext].parent = iBin;
+          queue.push_back( iNext );
+        }
+      }
+    }
+  }
+
+  if( chdir( fitDir.c_str() ) != 0 ){
+
+    cout << "fit_bins ERROR:  cannot change to the fit directory " << fitDir << endl;
+    exit(1);
+  }
+
+  int nDone = 0, nFailed = 0, nRunning = 0, nRun = 0;
+  double runTime = 0, runUnits = 0;
+  time_t begin = time( NULL );
+
+  if( resume ){
+
+    for( int iBin = 0; iBin < nTotal; ++iBin ){
+
+      Bin& bin = bins[iBin];
+      if( !FileExists( bin.name + "/" + bin.name + ".fit" ) ) continue;
+
+      bin.state = kDone;
+      bin.converged = FileExists( bin.name + "/" + SeedOut( bin ) );
+      ++nDone;
+    }
+    cout << "fit_bins:  resuming with " << nDone << " of " << nTotal << " bins done" << endl;
+  }
+
+  // the estimated times, in seconds if any bin was measured before and in
+  // the units of the model otherwise, which only order the bins
+  map< string, double > times;
+  {
+    ifstream in( kTimesFile );
+    string name;
+    double seconds;
+    while( in >> name >> seconds ) times[name] = seconds;
+  }
+
+  int nFits = NumFits( fitArgs );
+  double measuredSeconds = 0, measuredUnits = 0;
+  for( int iBin = 0; iBin < nTotal; ++iBin ){
+
+    Bin& bin = bins[iBin];
+    bin.units = ModelUnits( bin, nFits );
+    bin.measured = times.count( bin.name ) ? times[bin.name] : ProfiledSeconds( bin.name + "/profile.json" );
+    if( bin.measured > 0 ){
+
+      measuredSeconds += bin.measured;
+      measuredUnits += bin.units;
+    }
+  }
+
+  bool calibrated = measuredUnits > 0;
+  double secondsPerUnit = calibrated ? measuredSeconds / measuredUnits : 1;
+  for( int iBin = 0; iBin < nTotal; ++iBin ){
+
+    Bin& bin = bins[iBin];
+    bin.seconds = bin.measured > 0 ? bin.measured : bin.units * secondsPerUnit;
+    bin.priority = bin.state == kDone ? 0 : bin.seconds;
+  }
+
+  // the longest chain below every bin, from the ends of the chains (the
+  // order is breadth first, so the bins of a chain come after its parent)
+  for( int k = order.size() - 1; k >= 0; --k ){
+
+    Bin& bin = bins[order[k]];
+    if( bin.parent < 0 ) continue;
+
+    Bin& parent = bins[bin.parent];
+    double own = parent.state == kDone ? 0 : parent.seconds;
+    parent.priority = max( parent.priority, own + bin.priority );
+  }
+
+  stable_sort( order.begin(), order.end(),
+               [&]( int a, int b ){ return bins[a].priority > bins[b].priority; } );
+
+  cout << "fit_bins:  estimated the bins from their configurations";
+  if( calibrated ) cout << ", calibrated with " << measuredSeconds << " s measured before";
+  cout << endl;
+
+  // farm jobs of about equal time, each bin onto the least loaded job
+  if( nFarmJobs > 0 ){
+
+    vector< vector< int > > jobs( nFarmJobs );
+    vector< double > load( nFarmJobs, 0 );
+    for( unsigned int k = 0; k < order.size(); ++k ){
+
+      const Bin& bin = bins[order[k]];
+      if( bin.state == kDone ) continue;
+
+      int job = min_element( load.begin(), load.end() ) - load.begin();
+      jobs[job].push_back( order[k] );
+      load[job] += bin.seconds;
+    }
+
+    for( int job = 0; job < nFarmJobs; ++job ){
+
+      string listName = "fit_bins_array" + to_string( job ) + ".list";
+      ofstream list( listName.c_str() );
+      for( unsigned int b = 0; b < jobs[job].size(); ++b ){
+
+        const Bin& bin = bins[jobs[job][b]];
+        list << bin.name << "/" << bin.name << ".cfg" << endl;
+
+        if( FileExists( seedFile ) && !CopyFile( seedFile, bin.name + "/" + seedFile ) )
+          cout << "fit_bins ERROR:  cannot copy seed " << seedFile << " to " << bin.name << endl;
+      }
+
+      if( !list ){
+
+        cout << "fit_bins ERROR:  cannot write " << listName << endl;
+        exit(1);
+      }
+
+      cout << "fit_bins:  " << listName << " with " << jobs[job].size() << " bins, ~"
+           << (int)load[job] << ( calibrated ? " s" : " units" ) << endl;
+    }
+
+    cout << "fit_bins:  longest job ~" << (int)*max_element( load.begin(), load.end() )
+         << ( calibrated ? " s" : " units" ) << "; run job <k> in " << fitDir << " as" << endl
+         << "   " << fitProgram << " -l fit_bins_array<k>.list -s " << kBatchSeed << " " << fitArgs << endl;
+
+    return 0;
+  }
+
+  // the process of each slot of -j, which picks its GPU
+  vector< pid_t > slots( nJobs, 0 );
+  int nBatches = 0;
+
+  while( nDone < nTotal ){
+
+    // start every bin whose parent is done, in the order of the chains,
+    // batchSize of them per process
+    for( unsigned int k = 0; k < order.size() && nRunning < nJobs; ){
+
+      vector< int > batch;
+      for( ; k < order.size() && (int)batch.size() < batchSize; ++k ){
+
+        Bin& bin = bins[order[k]];
+        if( bin.state != kWaiting ) continue;
+        if( bin.parent >= 0 && bins[bin.parent].state != kDone ) continue;
+
+        // seed from the nearest converged bin towards the start of the chain
+        string seed = FileExists( seedFile ) ? seedFile : "";
+        for( int iSeed = bin.parent; iSeed >= 0; iSeed = bins[iSeed].parent ){
+
+          if( bins[iSeed].converged ){
+
+            seed = bins[iSeed].name + "/" + SeedOut( bins[iSeed] );
+            break;
+          }
+        }
+
+        if( !FileExists( bin.name + "/" + bin.name + ".cfg" ) ){
+
+          cout << "fit_bins ERROR:  no configuration file " << bin.name << "/" << bin.name << ".cfg" << endl;
+          bin.state = kDone;
+          ++nDone;
+          ++nFailed;
+          continue;
+        }
+
+        if( seed.size() != 0 && !CopyFile( seed, bin.name + "/" + seedFile ) )
+          cout << "fit_bins ERROR:  cannot copy seed " << seed << " to " << bin.name << endl;
+
+        remove( ( bin.name + "/" + SeedOut( bin ) ).c_str() );
+        remove( ( bin.name + "/" + kBatchSeed ).c_str() );
+
+        cout << "fit_bins:  starting " << bin.name
+             << ( seed.size() != 0 ? " from " + seed : string( "" ) ) << endl;
+
+        batch.push_back( order[k] );
+      }
+
+      if( batch.empty() ) break;
+
+      // a single bin is fit in its directory, a batch from a list of its
+      // configuration files with the log in the fit directory
+      const Bin& first = bins[batch[0]];
+      string command, dir;
+      if( batch.size() == 1 ){
+
+        dir = first.name;
+        command = fitProgram + " -c " + first.name + ".cfg -s " + SeedOut( first ) + " " +
+                  fitArgs + " > " + first.name + ".log 2>&1";
+      }
+      else{
+
+        string listName = "fit_bins_batch" + to_string( nBatches ) + ".list";
+        ofstream list( listName.c_str() );
+        for( unsigned int b = 0; b < batch.size(); ++b )
+          list << bins[batch[b]].name << "/" << bins[batch[b]].name << ".cfg" << endl;
+
+        if( !list ){
+
+          cout << "fit_bins ERROR:  cannot write " << listName << endl;
+          exit(1);
+        }
+
+        dir = ".";
+        command = fitProgram + " -l " + listName + " -s " + kBatchSeed + " " + fitArgs +
+                  " > fit_bins_batch" + to_string( nBatches ) + ".log 2>&1";
+      }
+      ++nBatches;
+
+      int slot = find( slots.begin(), slots.end(), 0 ) - slots.begin();
+
+      cout << flush;
+      pid_t pid = fork();
+      if( pid < 0 ){
+
+        cout << "fit_bins ERROR:  cannot start the fit of " << first.name << endl;
+        exit(1);
+      }
+      if( pid == 0 ){
+
+        if( nGPUs > 0 ) setenv( "CUDA_VISIBLE_DEVICES", to_string( slot % nGPUs ).c_str(), 1 );
+        if( chdir( dir.c_str() ) != 0 ) _exit(1);
+        execl( "/bin/sh", "sh", "-c", command.c_str(), (char*)NULL );
+        _exit(1);
+      }
+
+      slots[slot] = pid;
+      for( unsigned int b = 0; b < batch.size(); ++b ){
+
+        Bin& bin = bins[batch[b]];
+        bin.pid = pid;
+        bin.start = time( NULL );
+        bin.state = kRunning;
+      }
+      ++nRunning;
+
+      if( batch.size() > 1 )
+        cout << "fit_bins:  " << batch.size() << " bins fit by one process from fit_bins_batch"
+             << nBatches - 1 << ".list" << endl;
+    }
+
+    if( nRunning == 0 ){
+
+      if( nDone == nTotal ) break;
+
+      // only bins without a way to start are left
+      cout << "fit_bins ERROR:  " << nTotal - nDone << " bins cannot be started" << endl;
+      break;
+    }
+
+    int status;
+    pid_t pid = wait( &status );
+    if( pid < 0 ) break;
+
+    vector< pid_t >::iterator slot = find( slots.begin(), slots.end(), pid );
+    if( slot == slots.end() ) continue;
+    *slot = 0;
+    --nRunning;
+
+    // the bins of the process, which share its time
+    vector< int > finished;
+    for( int iBin = 0; iBin < nTotal; ++iBin )
+      if( bins[iBin].state == kRunning && bins[iBin].pid == pid ) finished.push_back( iBin );
+
+    for( unsigned int b = 0; b < finished.size(); ++b ){
+
+      Bin& bin = bins[finished[b]];
+
+      if( finished.size() > 1 ){
+
+        // the process fit a list, its seeds have the same name in every bin
+        string batchSeed = bin.name + "/" + kBatchSeed;
+        if( FileExists( batchSeed ) ) rename( batchSeed.c_str(), ( bin.name + "/" + SeedOut( bin ) ).c_str() );
+        bin.converged = FileExists( bin.name + "/" + SeedOut( bin ) );
+      }
+      else{
+
+        bin.converged = WIFEXITED( status ) && WEXITSTATUS( status ) == 0 &&
+                        FileExists( bin.name + "/" + SeedOut( bin ) );
+      }
+
+      bin.state = kDone;
+      if( !bin.converged ) ++nFailed;
+
+      ++nDone;
+      ++nRun;
+
+      double seconds = double( time( NULL ) - bin.start ) / finished.size();
+      runTime += seconds;
+      runUnits += bin.units;
+
+      ofstream( kTimesFile, ios::app ) << bin.name << " " << seconds << endl;
+
+      // progress: the estimated times of the remaining bins, the model
+      // calibrated with all the bins measured so far
+      double rate = ( measuredSeconds + runTime ) / ( measuredUnits + runUnits );
+      double leftSeconds = 0, largest = 0;
+      for( int iLeft = 0; iLeft < nTotal; ++iLeft ){
+
+        if( bins[iLeft].state == kDone ) continue;
+
+        double estimate = bins[iLeft].measured > 0 ? bins[iLeft].measured : bins[iLeft].units * rate;
+        leftSeconds += estimate;
+        largest = max( largest, estimate );
+      }
+
+      int left = nTotal - nDone;
+      int parallel = left < nJobs ? left : nJobs;
+      int eta = parallel > 0 ? (int)max( leftSeconds / parallel, largest ) : 0;
+
+      cout << "fit_bins:  [" << nDone << "/" << nTotal << "] " << bin.name
+           << ( bin.converged ? " converged" : " FAILED" ) << " in " << (int)seconds << " s,  "
+           << nRunning << " running,  " << nFailed << " failed,  "
+           << time( NULL ) - begin << " s elapsed,  ~" << eta << " s left" << endl;
+    }
+  }
+
+  cout << "fit_bins:  " << nDone - nFailed << " of " << nTotal << " bins converged in "
+       << time( NULL ) - begin << " s" << endl;
+
+  return nFailed == 0 ? 0 : 1;
+}
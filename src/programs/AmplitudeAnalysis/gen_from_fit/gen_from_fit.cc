@@ -0,0 +1,296 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cassert>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/FitResults.h"
+
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_DATAIO/StreamDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriterPool.h"
+#include "AMPTOOLS_DATAIO/BinaryDataWriter.h"
+
+#include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+
+using namespace std;
+
+#define DEFTREENAME "kin"
+
+void Usage()
+{
+  cout << "Usage:\n  gen_from_fit <fit results> <infile> <outfile> [options]\n\n";
+  cout << "   Keeps each event of infile (phase space or accepted MC) with a\n";
+  cout << "   probability proportional to the intensity of the fit at the event\n";
+  cout << "   times its weight.  The intensities are computed by the amplitudes of\n";
+  cout << "   the fit, on the GPU with GPU acceleration, a block of events at a\n";
+  cout << "   time.  An outfile that ends in .bin is written in the binary format\n";
+  cout << "   of BinaryDataReader, otherwise as a ROOT tree.\n";
+  cout << "   Use -r [reaction] to set the reaction (default: the first of the fit).\n";
+  cout << "   Use -m [max] to set the maximum intensity; without it the\n";
+  cout << "     intensities are computed in a first pass over infile and the\n";
+  cout << "     events are read again to select them.\n";
+  cout << "   Use -s [seed] to set the seed (default 0); the random number of an\n";
+  cout << "     event only depends on the seed and the entry.\n";
+  cout << "   Use -b [events] to set the size of the blocks (default 100000).\n";
+  cout << "   Use -T [tree name] to set the tree name, inKin:outKin for both.\n";
+  cout << "   Use -C [codec[:level]] to set the output compression (zlib, lzma, lz4, zstd, none).\n";
+  exit(1);
+}
+
+pair <string,string> GetTreeNames(char* treeArg)
+{
+  pair <string,string> treeNames(DEFTREENAME,"");
+  string treeArgStr(treeArg);
+  size_t delimPos=treeArgStr.find(':',1);
+
+  if (delimPos != string::npos){
+    treeNames.first=treeArgStr.substr(0,delimPos);
+    treeNames.second=treeArgStr.substr(delimPos+1);
+  }else
+    treeNames.second=treeArgStr;
+
+  return treeNames;
+}
+
+// A uniform number in [0,1) from the seed and the entry (the splitmix64
+// finalizer, as in toy_detector), so that the selection does not depend
+// on the blocks or on where the intensities are computed.
+double entryRandom( uint64_t seed, uint64_t entry )
+{
+  uint64_t z = seed * 0x9E3779B97F4A7C15ULL + entry + 1;
+  z *= 0x9E3779B97F4A7C15ULL;
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  z = z ^ ( z >> 31 );
+
+  return ( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+// The events of a block, served to the framework through a source of
+// StreamDataReader.
+struct Block {
+
+  vector< ROOTDataEvent > events;
+  int n;
+  int next;
+};
+
+// The intensity times the weight of the n events of block, not below 0.
+void blockIntensities( AmpToolsInterface& ati, const string& reaction,
+                       Block& block, double* intensity )
+{
+  block.next = 0;
+  StreamDataReader reader( vector< string >( 1, "callback:gen_from_fit" ) );
+  assert( static_cast< int >( reader.numEvents() ) == block.n );
+
+  ati.loadEvents( &reader );
+  ati.processEvents( reaction );
+
+  for( int i = 0; i < block.n; ++i ){
+
+    intensity[i] = ati.intensity( i ) * block.events[i].weight;
+    if( intensity[i] < 0 ) intensity[i] = 0;
+  }
+
+  ati.clearEvents();
+}
+
+int main( int argc, char* argv[] ){
+
+  pair <string,string> treeNames(DEFTREENAME,DEFTREENAME);
+
+  string reaction;
+  double maxIntensity = 0;
+  uint64_t seed = 0;
+  int blockSize = 100000;
+  ROOTDataWriterOptions writerOptions;
+
+  if( argc < 4 ) Usage();
+
+  for( int i = 4; i < argc; ++i ){
+
+    string arg = argv[i];
+    if( i + 1 == argc ) Usage();
+
+    if( arg == "-r" ) reaction = argv[++i];
+    else if( arg == "-m" ) maxIntensity = atof( argv[++i] );
+    else if( arg == "-s" ) seed = strtoull( argv[++i], NULL, 10 );
+    else if( arg == "-b" ) blockSize = atoi( argv[++i] );
+    else if( arg == "-T" ) treeNames = GetTreeNames( argv[++i] );
+    else if( arg == "-C" ) writerOptions.compression = argv[++i];
+    else Usage();
+  }
+
+  if( blockSize <= 0 ) Usage();
+
+  TH1::AddDirectory( kFALSE );
+
+  FitResults results( argv[1] );
+  if( !results.valid() ){
+
+    cout << "gen_from_fit ERROR:  cannot read the fit results " << argv[1] << endl;
+    exit(1);
+  }
+
+  ConfigurationInfo* cfgInfo = const_cast< ConfigurationInfo* >( results.configInfo() );
+  if( reaction == "" ) reaction = results.reactionList()[0];
+  if( cfgInfo->reaction( reaction ) == NULL ){
+
+    cout << "gen_from_fit ERROR:  the fit has no reaction " << reaction << endl;
+    exit(1);
+  }
+
+  AmplitudeRegistry::registerUsed( cfgInfo );
+  AmpToolsInterface::registerDataReader( ROOTDataReader() );
+
+  // the amplitudes without data, at the parameters of the fit
+  AmpToolsInterface ati( cfgInfo, AmpToolsInterface::kMCGeneration );
+
+  ParameterManager* parMgr = ati.parameterManager();
+  vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( reaction );
+  for( unsigned int i = 0; i < amps.size(); ++i )
+    parMgr->setProductionParameter( amps[i]->fullName(), results.productionParameter( amps[i]->fullName() ) );
+
+  vector< ParameterInfo* > parInfo = cfgInfo->parameterList();
+  for( unsigned int i = 0; i < parInfo.size(); ++i )
+    if( !parInfo[i]->fixed() ) parMgr->setAmpParameter( parInfo[i]->parName(), results.parValue( parInfo[i]->parName() ) );
+
+  TFile* inFile = TFile::Open( argv[2] );
+  TTree* inTree = dynamic_cast< TTree* >( inFile->Get( treeNames.first.c_str() ) );
+  assert( inTree != NULL );
+
+  unsigned int nEntries = static_cast< unsigned int >( inTree->GetEntries() );
+
+  Block block;
+  block.events.resize( blockSize );
+  block.n = 0;
+  block.next = 0;
+
+  StreamDataReader::registerSource( "gen_from_fit",
+    [&block]( vector< TLorentzVector >& particles, float& weight ){
+
+      if( block.next == block.n ) return false;
+
+      const ROOTDataEvent& event = block.events[block.next++];
+
+      particles.resize( event.nPart + 1 );
+      particles[0] = event.beam();
+      for( int j = 0; j < event.nPart; ++j ) particles[j + 1] = event.finalState( j );
+
+      weight = event.weight;
+      return true;
+    } );
+
+  // without a maximum the intensities of all events are computed first
+  vector< double > intensity;
+  bool twoPass = !( maxIntensity > 0 );
+  if( twoPass ){
+
+    intensity.resize( nEntries );
+
+    ROOTDataPrefetcher in( inTree );
+    in.startAll();
+
+    for( unsigned int first = 0; first < nEntries; first += blockSize ){
+
+      block.n = ( nEntries - first < (unsigned int)blockSize ? nEntries - first : blockSize );
+      for( int i = 0; i < block.n; ++i ) in.next( block.events[i] );
+
+      blockIntensities( ati, reaction, block, &intensity[first] );
+      for( int i = 0; i < block.n; ++i )
+        if( intensity[first + i] > maxIntensity ) maxIntensity = intensity[first + i];
+    }
+
+    in.stop();
+
+    if( !( maxIntensity > 0 ) ){
+
+      cout << "gen_from_fit ERROR:  the intensity vanishes on " << argv[2] << endl;
+      exit(1);
+    }
+
+    cout << "Maximum intensity " << maxIntensity << " in " << nEntries << " events" << endl;
+  }
+
+  string outName = argv[3];
+  bool binary = ( outName.size() > 4 && outName.substr( outName.size() - 4 ) == ".bin" );
+
+  ROOTDataWriterPool* rootOut = NULL;
+  BinaryDataWriter* binaryOut = NULL;
+  if( binary ) binaryOut = new BinaryDataWriter( outName );
+  // the ROOT output is compressed on a thread of its own
+  else rootOut = new ROOTDataWriterPool( vector< string >( 1, outName ), treeNames.second,
+                                         true, false, 1, writerOptions );
+
+  ROOTDataPrefetcher in( inTree );
+  in.startAll();
+
+  vector< double > blockIntensity( twoPass ? 0 : blockSize );
+  unsigned int nAccepted = 0, nAboveMax = 0;
+
+  for( unsigned int first = 0; first < nEntries; first += blockSize ){
+
+    block.n = ( nEntries - first < (unsigned int)blockSize ? nEntries - first : blockSize );
+    for( int i = 0; i < block.n; ++i ) in.next( block.events[i] );
+
+    if( !twoPass ) blockIntensities( ati, reaction, block, &blockIntensity[0] );
+    const double* blockInt = ( twoPass ? &intensity[first] : &blockIntensity[0] );
+
+    // the accepted events are moved to the front of the block
+    int nKept = 0;
+    for( int i = 0; i < block.n; ++i ){
+
+      ROOTDataEvent& event = block.events[i];
+      if( blockInt[i] > maxIntensity ) ++nAboveMax;
+      if( entryRandom( seed, event.entry ) * maxIntensity >= blockInt[i] ) continue;
+
+      event.weight = 1;
+      if( nKept != i ) block.events[nKept] = event;
+      ++nKept;
+    }
+    nAccepted += nKept;
+
+    if( binary ){
+
+      for( int i = 0; i < nKept; ++i ){
+
+        const ROOTDataEvent& event = block.events[i];
+        vector< TLorentzVector > particles( 1, event.beam() );
+        for( int j = 0; j < event.nPart; ++j ) particles.push_back( event.finalState( j ) );
+        binaryOut->writeEvent( Kinematics( particles ) );
+      }
+    }
+    else rootOut->writeEvents( 0, &block.events[0], nKept );
+  }
+
+  in.stop();
+  delete binaryOut;
+  if( rootOut != NULL ){
+    rootOut->close();
+    delete rootOut;
+  }
+
+  inFile->Close();
+
+  if( nAboveMax > 0 )
+    cout << "gen_from_fit WARNING:  " << nAboveMax << " events have an intensity above the maximum "
+         << maxIntensity << ", the sample is biased there" << endl;
+
+  cout << "Kept " << nAccepted << " of " << nEntries << " events" << endl;
+
+  return 0;
+}
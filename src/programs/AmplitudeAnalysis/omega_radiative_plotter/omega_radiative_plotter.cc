@@ -21,15 +21,13 @@
 #include "AMPTOOLS_DATAIO/OmegaRadiativePlotGenerator.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
-#include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.cc"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
 
 typedef OmegaRadiativePlotGenerator PlotGen;
 
-void atiSetup(){
+void atiSetup( const ConfigurationInfo* cfgInfo ){
   
-  AmpToolsInterface::registerAmplitude( TwoPiAnglesRadiative() );
-  AmpToolsInterface::registerAmplitude( BreitWigner() );
+  AmplitudeRegistry::registerUsed( cfgInfo );
   AmpToolsInterface::registerDataReader( ROOTDataReader() );
   AmpToolsInterface::registerDataReader( ROOTDataReaderWithTCut() );
 }
@@ -64,10 +62,14 @@ int main( int argc, char* argv[] ){
     if (arg == "-o"){
       outName = argv[++i];
     }
+    if (arg == "-j"){
+      AmplitudeThreads::setNumThreads( atoi( argv[++i] ) );
+    }
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "\t -o <file>\t output file path" << endl;
       cout << "\t -g <file>\t show GUI" << endl;
+      cout << "\t -j <int>\t evaluate the amplitudes on <int> threads" << endl;
       exit(1);
     }
   }
@@ -96,7 +98,7 @@ int main( int argc, char* argv[] ){
     // set up the plot generator
     // ************************
 
-  atiSetup();
+  atiSetup( results.configInfo() );
   PlotGen plotGen( results );
   cout << " Initialized ati and PlotGen" << endl;
 
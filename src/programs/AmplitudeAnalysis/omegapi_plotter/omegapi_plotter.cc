@@ -24,12 +24,7 @@
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
-#include "AMPTOOLS_AMPS/omegapiAngAmp.h"
-#include "AMPTOOLS_AMPS/omegapi_amplitude.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
-#include "AMPTOOLS_AMPS/Uniform.h"
-#include "AMPTOOLS_AMPS/Vec_ps_refl.h"
-#include "AMPTOOLS_AMPS/Piecewise.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
 
 #include "MinuitInterface/MinuitMinimizationManager.h"
 #include "IUAmpTools/ConfigFileParser.h"
@@ -37,15 +32,9 @@
 
 typedef OmegaPiPlotGenerator omegapi_PlotGen;
 
-void atiSetup(){
+void atiSetup( const ConfigurationInfo* cfgInfo ){
   
-  AmpToolsInterface::registerAmplitude( omegapiAngAmp() );
-  AmpToolsInterface::registerAmplitude( omegapi_amplitude() );
-  AmpToolsInterface::registerAmplitude( BreitWigner() );
-  AmpToolsInterface::registerAmplitude( Uniform() );
-  AmpToolsInterface::registerAmplitude( Vec_ps_refl() );
-  AmpToolsInterface::registerAmplitude( Piecewise() );
-
+  AmplitudeRegistry::registerUsed( cfgInfo );
   AmpToolsInterface::registerDataReader( ROOTDataReader() );
   AmpToolsInterface::registerDataReader( ROOTDataReaderTEM() );
 }
@@ -80,10 +69,14 @@ int main( int argc, char* argv[] ){
     if (arg == "-o"){
       outName = argv[++i];
     }
+    if (arg == "-j"){
+      AmplitudeThreads::setNumThreads( atoi( argv[++i] ) );
+    }
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "\t -o <file>\t output file path" << endl;
       cout << "\t -g <file>\t show GUI" << endl;
+      cout << "\t -j <int>\t evaluate the amplitudes on <int> threads" << endl;
       exit(1);
     }
   }
@@ -112,7 +105,7 @@ int main( int argc, char* argv[] ){
     // set up the plot generator
     // ************************
 	cout << "before atisetup();"<< endl;
-  atiSetup();
+  atiSetup( results.configInfo() );
         cout << "Plotgen results"<< endl;
 
   omegapi_PlotGen plotGen( results , PlotGenerator::kNoGenMC );
@@ -7,6 +7,8 @@ using namespace std;
 
 #include "Math/SpecFunc.h"
 
+#include "AMPTOOLS_AMPS/clebschGordan.h"
+
 #include "wave.h"
 #include "3j.h"
 
@@ -81,6 +83,11 @@ getCoefficient(int eps, int L, int M, int l1, int m1, int l2, int m2)
 double
 threeJ(long j1, long j2, long j3, long m1, long m2, long m3)
 {
+  // small spins come from the precomputed table of AMPTOOLS_AMPS
+  if (j1 <= CLEBSCHGORDAN_TABLE_MAX_J && j2 <= CLEBSCHGORDAN_TABLE_MAX_J &&
+      j3 <= CLEBSCHGORDAN_TABLE_MAX_J)
+    return threeJSymbol(j1, j2, j3, m1, m2, m3);
+
 #if ROOT_VERSION_CODE >= ROOT_VERSION(5,28,0)
   return ROOT::Math::wigner_3j(2*j1, 2*j2, 2*j3, 2*m1, 2*m2, 2*m3);
 #else
@@ -271,3 +278,106 @@ decomposeMomentError(int L, int M, const waveset& ws, const vector<double>& x, c
 
   return sqrt(resultSquare);
 }
+
+
+std::vector< std::vector<momentTerm> >
+momentTerms(const std::vector<std::pair<size_t, size_t> >& LM, const waveset& ws)
+{
+  std::vector< std::vector<momentTerm> > result(LM.size());
+  for (size_t k = 0; k < LM.size(); k++)
+    for (size_t iWs = 0; iWs < ws.size(); iWs++)
+      {
+	int eps = ws[iWs].reflectivity;
+
+	const vector<wave>& w = ws[iWs].waves;
+	for (size_t iW1 = 0; iW1 < w.size(); iW1++)
+	  for (size_t iW2 = 0; iW2 < w.size(); iW2++)
+	    {
+	      momentTerm term;
+	      term.idx1 = w[iW1].getIndex();
+	      term.idx2 = w[iW2].getIndex();
+	      term.coeff = getCoefficient(eps, LM[k].first, LM[k].second, w[iW1].l, w[iW1].m, w[iW2].l, w[iW2].m);
+	      if (term.coeff != 0)
+		result[k].push_back(term);
+	    }
+      }
+
+  return result;
+}
+
+double
+decomposeMoment(const std::vector<momentTerm>& terms, const double* x)
+{
+  double result = 0;
+  for (size_t i = 0; i < terms.size(); i++)
+    {
+      const momentTerm& t = terms[i];
+      result += t.coeff*(x[t.idx1]*x[t.idx2] + x[t.idx1+1]*x[t.idx2+1]);
+    }
+  return result;
+}
+
+
+// The moments are bilinear in the fit parameters, so their derivatives
+// are built in one pass over the waves; the errors are then the diagonal
+// of J C J^T over the parameters that enter any moment.
+std::vector<double>
+decomposeMomentErrors(const std::vector<std::pair<size_t, size_t> >& LM,
+		      const waveset& ws, const vector<double>& x, const vector< vector< double > >& covMat)
+{
+  return decomposeMomentErrors(momentTerms(LM, ws), x, covMat);
+}
+
+std::vector<double>
+decomposeMomentErrors(const std::vector< std::vector<momentTerm> >& terms,
+		      const vector<double>& x, const vector< vector< double > >& covMat)
+{
+  // the columns of J:  Re and Im of every wave that enters a moment
+  std::vector<size_t> params;
+  std::vector<size_t> column(x.size(), x.size());
+  for (size_t k = 0; k < terms.size(); k++)
+    for (size_t i = 0; i < terms[k].size(); i++)
+      {
+	size_t idx[2] = { terms[k][i].idx1, terms[k][i].idx2 };
+	for (int a = 0; a < 2; a++)
+	  for (int part = 0; part < 2; part++)
+	    if (column[idx[a] + part] == x.size())
+	      {
+		column[idx[a] + part] = params.size();
+		params.push_back(idx[a] + part);
+	      }
+      }
+
+  std::vector< std::vector<double> > jacobian(terms.size(), std::vector<double>(params.size(), 0.));
+  for (size_t k = 0; k < terms.size(); k++)
+    for (size_t i = 0; i < terms[k].size(); i++)
+      {
+	const momentTerm& t = terms[k][i];
+
+	// coeff*(re1*re2 + im1*im2)
+	jacobian[k][column[t.idx1]] += t.coeff*x[t.idx2];
+	jacobian[k][column[t.idx2]] += t.coeff*x[t.idx1];
+	jacobian[k][column[t.idx1 + 1]] += t.coeff*x[t.idx2 + 1];
+	jacobian[k][column[t.idx2 + 1]] += t.coeff*x[t.idx1 + 1];
+      }
+
+  std::vector<double> result(terms.size(), 0.);
+  for (size_t k = 0; k < terms.size(); k++)
+    {
+      const std::vector<double>& J = jacobian[k];
+      double resultSquare = 0;
+      for (size_t a = 0; a < params.size(); a++)
+	{
+	  if (J[a] == 0)
+	    continue;
+
+	  double JC = 0;
+	  for (size_t b = 0; b < params.size(); b++)
+	    JC += covMat[params[a]][params[b]]*J[b];
+	  resultSquare += J[a]*JC;
+	}
+      result[k] = sqrt(std::max(resultSquare, 0.));
+    }
+
+  return result;
+}
@@ -35,5 +35,22 @@ double decomposeMoment(int L, int M, const waveset& ws, const double* x);
 double decomposeMomentError(const std::pair<size_t, size_t>& LM, const waveset& ws, const vector<double>& x, const vector< vector< double > >& covMat);
 double decomposeMomentError(int L, int M, const waveset& ws, const vector<double>& x, const vector< vector< double > >& covMat);
 
+// The errors of all moments LM at once, from the full covariance matrix
+std::vector<double> decomposeMomentErrors(const std::vector<std::pair<size_t, size_t> >& LM, const waveset& ws, const vector<double>& x, const vector< vector< double > >& covMat);
+
+// A non-zero term coeff*(re1*re2 + im1*im2) of a moment, with the real
+// parts of the two waves at idx1 and idx2 and their imaginary parts after
+// them.  The terms depend only on the waveset, so they are computed once
+// for all bins.
+struct momentTerm {
+  size_t idx1, idx2;
+  double coeff;
+};
+
+std::vector< std::vector<momentTerm> > momentTerms(const std::vector<std::pair<size_t, size_t> >& LM, const waveset& ws);
+
+double decomposeMoment(const std::vector<momentTerm>& terms, const double* x);
+std::vector<double> decomposeMomentErrors(const std::vector< std::vector<momentTerm> >& terms, const vector<double>& x, const vector< vector< double > >& covMat);
+
 
 #endif
@@ -6,9 +6,12 @@
 #include <vector>
 #include <cassert>
 #include <cstdlib>
+#include <cstdio>
 #include <unistd.h>
 
 #include "IUAmpTools/FitResults.h"
+#include "AMPTOOLS_DATAIO/CompactFitResults.h"
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
 
 #include "wave.h"
 #include "3j.h"
@@ -17,6 +20,61 @@
 
 using namespace std;
 
+// the parameters of a bin with their error matrix
+struct binResults {
+  bool valid;
+  vector<string> parNames;
+  vector<double> x;
+  vector< vector<double> > errorMatrix;
+};
+
+template< class Results >
+void readResults(const Results& results, binResults& bin){
+
+  bin.valid = results.valid();
+  bin.parNames = results.parNameList();
+  bin.x = results.parValueList();
+  bin.errorMatrix = results.errorMatrix();
+}
+
+// reads the binary companion of the fit file if fit wrote one with
+// --binary-results, the fit file otherwise
+binResults readResults(const string& resultsFile){
+
+  binResults bin;
+  if( CompactFitResults::exists( resultsFile ) ){
+
+    CompactFitResults results( resultsFile );
+    if( results.ok() ){
+      readResults( results, bin );
+      return bin;
+    }
+  }
+
+  FitResults results( resultsFile );
+  readResults( results, bin );
+  return bin;
+}
+
+// the bin edges in edgeFile, increasing and separated by white space, as
+// for split_mass -b
+vector<double> readEdges(const string& edgeFile){
+
+  vector<double> edges;
+  ifstream in( edgeFile.c_str() );
+  double edge;
+  while( in >> edge ) edges.push_back( edge );
+
+  for( size_t i = 1; i < edges.size(); ++i ){
+    if( edges[i] <= edges[i-1] ) edges.clear();
+  }
+  if( edges.size() < 2 ){
+    cout << "ERROR:  " << edgeFile << " does not hold two or more increasing bin edges" << endl;
+    exit(1);
+  }
+  return edges;
+}
+
 int main( int argc, char* argv[] ){
 
   // set default parameters
@@ -25,6 +83,9 @@ int main( int argc, char* argv[] ){
   double highMass = 2.00;
   int kNumBins = 86;
   string fitDir("");
+  string wavesetFile("");
+  string edgeFile("");
+  int nThreads = 1;
   
   string outfileName("moments.root");
   bool print = false;
@@ -41,44 +102,82 @@ int main( int argc, char* argv[] ){
     if (arg == "-o"){  
       if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
       else  outfileName = argv[++i]; }
+    if (arg == "-w"){  
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+      else  wavesetFile = argv[++i]; }
+    if (arg == "-m"){  
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+      else if (sscanf(argv[++i], "%lf:%lf:%d", &lowMass, &highMass, &kNumBins) != 3 ||
+               kNumBins <= 0 || highMass <= lowMass) arg = "-h"; }
+    if (arg == "-b"){  
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+      else  edgeFile = argv[++i]; }
+    if (arg == "-j"){  
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+      else  nThreads = atoi(argv[++i]); }
     if (arg == "-p")  
       print = true;
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "(optional) -f <fit dir>\t : Fit Directory" << endl;
       cout << "(optional) -o <file>\t : Output file (default: moments.root)" << endl;
+      cout << "(optional) -w <file>\t : Waveset, a line \"<reflectivity> <name> <l> <m>\" per wave in the order of fit.cfg" << endl;
+      cout << "\t\t\t   (default: from the parameter names of the fit)" << endl;
+      cout << "(optional) -m <low>:<high>:<n> : Mass bins of the fit (default: 0.28:2.0:86)" << endl;
+      cout << "(optional) -b <file>\t : Mass bin edges, as for split_mass -b" << endl;
+      cout << "(optional) -j <n>\t : Threads for the moments of the bins (default: 1)" << endl;
       cout << "(optional) -p\t\t : Print equations" << endl;
       exit(1);}
   }
   
-  // Set waveset, has to be same order as in fit.cfg!
+  vector<double> edges;
+  if (edgeFile.size() != 0){
+    edges = readEdges(edgeFile);
+    kNumBins = edges.size() - 1;
+  }
+  else{
+    for (int i = 0; i <= kNumBins; i++)
+      edges.push_back(lowMass + i * (highMass - lowMass) / kNumBins);
+  }
 
-  vector<wave> negative;
-  negative.push_back(wave("S0", 0, 0));
-  negative.push_back(wave("P0", 1, 0));
-  negative.push_back(wave("P-", 1, 1));
-  negative.push_back(wave("D0", 2, 0));
-  negative.push_back(wave("D-", 2, 1));
+  // Set waveset, from the file in the same order as in fit.cfg, or from
+  // the parameter names of the first valid bin
 
-  vector<wave> positive;
-  positive.push_back(wave("P+", 1, 1));
-  positive.push_back(wave("D+", 2, 1));
+  waveset ws;
+  if (wavesetFile.size() != 0 && !readWaveset(wavesetFile, ws)) exit(1);
 
-  coherent_waves wsPos, wsNeg;
-  wsPos.reflectivity = +1;
-  wsPos.waves = positive;
+  if (fitDir.size() == 0 && (!print || ws.size() == 0)){
+    cout << "No fit directory specified. Try -h for usage." << endl;
+    exit(1);
+  }
+
+  // the fit results of all bins, read before the moments so that these
+  // can be computed for all bins at once
+  vector<binResults> bins;
+  size_t nPar = 0;
+  for( int i = 0; fitDir.size() != 0 && i < kNumBins; ++i ){
+    
+    ostringstream resultsFile;
+    resultsFile << fitDir << "/bin_" << i << "/bin_" << i << ".fit";
+    bins.push_back( readResults( resultsFile.str() ) );
+    
+    if( !bins.back().valid ) continue;
 
-  wsNeg.reflectivity = -1;
-  wsNeg.waves = negative;
+    if( ws.size() == 0 && !wavesetFromParameters( bins.back().parNames, ws ) ) exit(1);
 
-  waveset ws;
-  ws.push_back(wsNeg);
-  ws.push_back(wsPos);
+    // the waves of the file are at the positions of the parameters, those
+    // from the names at the indices of the parameters of the first bin
+    if( nPar == 0 ) nPar = ( wavesetFile.size() != 0 ? 2*ws.getNwaves() : bins.back().x.size() );
+    if( bins.back().x.size() != nPar ){
+      cout << "Different number of waves in fit result " << resultsFile.str() << ". Check waveset!" << endl;
+      exit(1);
+    }
+  }
 
-  size_t lastIdx = 0;
-  for (size_t i = 0; i < ws.size(); i++)
-    for (size_t j = 0; j < ws[i].waves.size(); j++, lastIdx += 2)
-      ws[i].waves[j].setIndex(lastIdx);
+  if (ws.size() == 0){
+    cout << "No valid fit to read the waveset from. Try -w." << endl;
+    exit(1);
+  }
 
   // Find the non-zero moments for the given waveset.
   std::vector<std::pair<size_t, size_t> > vecMom = listOfMoments(ws);
@@ -92,7 +191,7 @@ int main( int argc, char* argv[] ){
       char title[999];
       snprintf(name, 999, "hMoment%zd%zd", it->first, it->second);
       snprintf(title, 999, "Moment H(%zd,%zd)", it->first, it->second);
-      hMoments[*it] = new TH1D(name, title, kNumBins, lowMass, highMass);
+      hMoments[*it] = new TH1D(name, title, kNumBins, &edges[0]);
 
       if (print){
 	cout << "H(" << it->first << ", " << it->second << ") = ";
@@ -136,47 +235,40 @@ int main( int argc, char* argv[] ){
     }
   
   
-  if (fitDir.size() == 0){
-    cout << "No fit directory specified. Try -h for usage." << endl;
-    exit(1);
-  }
-  
+  if (fitDir.size() == 0)
+    exit(0);
+
   TFile *outfile = new TFile(outfileName.c_str(), "recreate");
   if (!outfile->IsOpen()) exit(1);
 
-  // descend into the directory that contains the bins
-  chdir( fitDir.c_str() );
-  
-  for( int i = 0; i < kNumBins; ++i ){
-    
-    ostringstream dir;
-    dir << "bin_" << i;
-    chdir( dir.str().c_str() );
-    
-    ostringstream resultsFile;
-    resultsFile << "bin_" << i << ".fit";
-    
-    FitResults results( resultsFile.str() );
-    if( !results.valid() ){
-      
-      chdir( ".." );
-      continue;
-    }
+  // the coefficients of the moments are the same for all bins
+  std::vector< std::vector<momentTerm> > terms = momentTerms(vecMom, ws);
 
-    if (  2*ws.getNwaves() != results.parValueList().size() ){
-      cout << "Different number of waves in fit result. Check waveset!" << endl;
-      outfile->Close();
-      exit(1);
-    }
-    
-    for (std::vector<std::pair<size_t, size_t> >::const_iterator it = vecMom.begin(); it != vecMom.end(); it++)
+  vector< vector<double> > values(kNumBins), errors(kNumBins);
+  AmplitudeThreads::setNumThreads(nThreads > 0 ? nThreads : 1);
+  // a bin per call:  there are too few bins for AmplitudeThreads::run to
+  // share them over the threads
+  AmplitudeThreads::runChunks(kNumBins, 1, [&](int begin, int end){
+
+    for (int i = begin; i < end; i++)
       {
-	hMoments[*it]->SetBinContent(i + 1, decomposeMoment(*it, ws, results.parValueList()));
-	hMoments[*it]->SetBinError(i + 1, decomposeMomentError(*it, ws, results.parValueList(), results.errorMatrix()));
+	const binResults& bin = bins[i];
+	if (!bin.valid)
+	  continue;
+
+	values[i].resize(vecMom.size());
+	for (size_t k = 0; k < vecMom.size(); k++)
+	  values[i][k] = decomposeMoment(terms[k], &bin.x[0]);
+	errors[i] = decomposeMomentErrors(terms, bin.x, bin.errorMatrix);
+      }
+  });
+
+  for (int i = 0; i < kNumBins; i++)
+    for (size_t k = 0; k < values[i].size(); k++)
+      {
+	hMoments[vecMom[k]]->SetBinContent(i + 1, values[i][k]);
+	hMoments[vecMom[k]]->SetBinError(i + 1, errors[i][k]);
       }
-    
-    chdir( ".." );
-  }
   
   
   for (std::vector<std::pair<size_t, size_t> >::const_iterator it = vecMom.begin(); it != vecMom.end(); it++)
@@ -1,5 +1,9 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 
 #include "wave.h"
 
@@ -15,3 +19,119 @@ wave::wave(const wave& o)
 
 waveset::waveset() { return; }
 
+
+namespace {
+  // the coherent sum of reflectivity eps, added if there is none yet
+  coherent_waves&
+  sumOf(waveset& ws, int eps)
+  {
+    for (size_t i = 0; i < ws.size(); i++)
+      if (ws[i].reflectivity == eps)
+	return ws[i];
+
+    coherent_waves waves;
+    waves.reflectivity = eps;
+    waves.spinflip = 0;
+    ws.push_back(waves);
+    return ws.back();
+  }
+}
+
+bool
+readWaveset(const string& fileName, waveset& ws)
+{
+  ifstream in(fileName.c_str());
+  if (!in)
+    {
+      cout << "ERROR:  cannot read the waveset " << fileName << endl;
+      return false;
+    }
+
+  ws.clear();
+  size_t idx = 0;
+  string line;
+  while (getline(in, line))
+    {
+      istringstream fields(line);
+      string name;
+      int eps, l, m;
+      if (!(fields >> name) || name[0] == '#')
+	continue;
+
+      fields.clear();
+      fields.str(line);
+      if (!(fields >> eps >> name >> l >> m) || abs(eps) != 1 || l < 0 || m < 0 || m > l)
+	{
+	  cout << "ERROR:  bad wave in " << fileName << ":  " << line << endl;
+	  return false;
+	}
+
+      wave w(name.c_str(), l, m);
+      w.setIndex(idx);
+      idx += 2;
+      sumOf(ws, eps).waves.push_back(w);
+    }
+
+  return ws.getNwaves() != 0;
+}
+
+bool
+wavesetFromParameters(const vector<string>& parNames, waveset& ws)
+{
+  static const string kSpins = "SPDFGHIJK";
+
+  ws.clear();
+  for (size_t iPar = 0; iPar + 1 < parNames.size(); iPar++)
+    {
+      const string& re = parNames[iPar];
+      if (re.size() < 3 || re.compare(re.size() - 3, 3, "_re") != 0)
+	continue;
+
+      string amp = re.substr(0, re.size() - 3);
+      if (parNames[iPar + 1] != amp + "_im")
+	{
+	  cout << "ERROR:  " << re << " is not followed by " << amp << "_im" << endl;
+	  return false;
+	}
+
+      size_t waveSep = amp.rfind("::");
+      size_t sumSep = (waveSep == string::npos || waveSep == 0 ? string::npos : amp.rfind("::", waveSep - 1));
+      if (sumSep == string::npos)
+	{
+	  cout << "ERROR:  " << amp << " is not of the form reaction::sum::wave" << endl;
+	  return false;
+	}
+
+      string sum = amp.substr(sumSep + 2, waveSep - sumSep - 2);
+      string name = amp.substr(waveSep + 2);
+      for (size_t i = 0; i < sum.size(); i++)
+	sum[i] = tolower(sum[i]);
+
+      int eps = 0;
+      if (sum.find("neg") != string::npos)
+	eps = -1;
+      else if (sum.find("pos") != string::npos)
+	eps = +1;
+
+      size_t l = (name.empty() ? string::npos : kSpins.find(name[0]));
+      int m = -1;
+      if (name.size() == 2 && (name[1] == '+' || name[1] == '-'))
+	m = 1;
+      else if (name.size() == 2 && isdigit(name[1]))
+	m = name[1] - '0';
+
+      if (eps == 0 || l == string::npos || m < 0 || m > (int)l)
+	{
+	  cout << "ERROR:  cannot tell the reflectivity, l and m of " << amp
+	       << "; give the waveset with -w" << endl;
+	  return false;
+	}
+
+      wave w(name.c_str(), l, m);
+      w.setIndex(iPar);
+      sumOf(ws, eps).waves.push_back(w);
+      iPar++;
+    }
+
+  return ws.getNwaves() != 0;
+}
@@ -2,6 +2,7 @@
 #define WAVE_H__
 
 #include <complex>
+#include <string>
 #include <vector>
 #include <map>
 #include <iostream>
@@ -78,4 +79,21 @@ public:
 
 };
 
+// Reads the waveset from a file with a line per wave, in the order of the
+// waves in fit.cfg:
+//
+//   <reflectivity> <name> <l> <m>
+//
+// e.g. "-1 S0 0 0".  Waves of the same reflectivity form a coherent sum;
+// lines starting with # are comments.  The wave on line k (not counting
+// comments) has its real and imaginary parts at 2k and 2k+1.
+bool readWaveset(const string& fileName, waveset& ws);
+
+// Builds the waveset from the parameter names of a fit,
+// <reaction>::<sum>::<wave>_re and _im, for the naming of fit.cfg:  the
+// sum contains "neg" or "pos" (any case) for the reflectivity, the wave
+// is the letter of l (S, P, D, F, G, ...) followed by m, or by + or -
+// for m = 1.  Each wave is read from the indices of its parameters.
+bool wavesetFromParameters(const vector<string>& parNames, waveset& ws);
+
 #endif
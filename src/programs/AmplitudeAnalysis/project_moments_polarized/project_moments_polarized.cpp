@@ -18,6 +18,7 @@
 #include <time.h>
 
 #include "IUAmpTools/FitResults.h"
+#include "AMPTOOLS_DATAIO/CompactFitResults.h"
 #include "TFile.h"
 
 #include "wave.h"
@@ -26,7 +27,36 @@
 #include "TFile.h"
 
 
+// the parameters of a bin with their error matrix
+struct BinResults {
+  bool valid;
+  vector< double > x;
+  vector< vector< double > > errorMatrix;
+};
 
+template< class Results >
+BinResults readResults( const Results& results ){
+
+  BinResults bin;
+  bin.valid = results.valid();
+  bin.x = results.parValueList();
+  bin.errorMatrix = results.errorMatrix();
+  return bin;
+}
+
+// reads the binary companion of the fit file if fit wrote one with
+// --binary-results, the fit file otherwise
+BinResults readResults( const string& resultsFile ){
+
+  if( CompactFitResults::exists( resultsFile ) ){
+
+    CompactFitResults results( resultsFile );
+    if( results.ok() ) return readResults( results );
+  }
+
+  FitResults results( resultsFile );
+  return readResults( results );
+}
 
 
 int main( int argc, char* argv[] ){
@@ -104,6 +134,11 @@ positive.push_back(wave("G1+", 4, 1));
   size_t LMAX;    //highest wave
   Biggest_lm(ws, &LMAX);
 
+  // the coefficients of the moments are the same in every bin
+  MomentCoefficients coeffs(momentWaves(ws), LMAX);
+  vector< complex<double> > H(coeffs.numMoments());
+  vector< double > Herr(coeffs.numMoments());
+
 
   double step = ( highMass - lowMass ) / kNumBins;
     double stept = ( hight - lowt ) / kNumBinst;
@@ -139,10 +174,10 @@ positive.push_back(wave("G1+", 4, 1));
         
         string resultsFile;
         resultsFile ="bin_" + std::to_string(i)+"_"+ std::to_string(j)+".fit";
-        FitResults results(resultsFile);
+        BinResults results = readResults(resultsFile);
 	
 
-	if( !results.valid() ){
+	if( !results.valid ){
 	  outfile<< lowMass + step * i + step / 2. << "\t";
 	  outfile<< lowt + stept * j + stept / 2. << "\t";
 	  for (int L = 0; L<= pow(LMAX,1); L++) {// calculating moments and writing to a file
@@ -165,12 +200,16 @@ positive.push_back(wave("G1+", 4, 1));
 	outfile << lowt + stept * j + stept / 2. << "\t";
   
   
-    for (int L = 0; L<= pow(LMAX,1); L++) {// calculating moments and writing to a file
+    vector< double >& x = results.x;
+    coeffs.moments(&x[0], &H[0]);
+    coeffs.realErrors(&x[0], results.errorMatrix, &Herr[0]);
+
+    for (int L = 0; L<= pow(LMAX,1); L++) {// writing the moments to a file
     for (int M = 0; M<= L; M++) {
      
-      outfile << real(decomposeMoment(0, L, M, ws, results.parValueList()))<< "\t"<< 0 <<"\t";
-      outfile << real(decomposeMoment(1, L, M, ws, results.parValueList()))<< "\t"<< 0 <<"\t";
-      // if(L==0 && M==0 && i==44 && j==3)cout <<" H0_00=  "<< real(decomposeMoment(0, L, M, ws, results.parValueList()))<<" H1_00=  "<< real(decomposeMoment(1, L, M, ws, results.parValueList()))<<" H2_00=  "<< decomposeMoment(2, L, M, ws, results.parValueList())<<endl;
+      outfile << real(H[coeffs.index(0, L, M)])<< "\t"<< Herr[coeffs.index(0, L, M)] <<"\t";
+      outfile << real(H[coeffs.index(1, L, M)])<< "\t"<< Herr[coeffs.index(1, L, M)] <<"\t";
+      // if(L==0 && M==0 && i==44 && j==3)cout <<" H0_00=  "<< real(H[coeffs.index(0, L, M)])<<" H1_00=  "<< real(H[coeffs.index(1, L, M)])<<" H2_00=  "<< H[coeffs.index(2, L, M)]<<endl;
 
         }}
         outfile << endl;
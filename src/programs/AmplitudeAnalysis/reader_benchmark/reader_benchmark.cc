@@ -0,0 +1,603 @@
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <dirent.h>
+#include <signal.h>
+
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/DataReader.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBinned.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderPipeline.h"
+#include "AMPTOOLS_DATAIO/BinaryDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+#include "AMPTOOLS_DATAIO/BinaryDataWriter.h"
+
+#include "TLorentzVector.h"
+#include "TRandom3.h"
+#include "TFile.h"
+#include "TH1.h"
+
+using namespace std;
+
+// Reads a file through each data reader of the fits and reports the time
+// to construct the reader, the events and MB per second of a pass over
+// the events with getEvent, the heap allocations per event and the peak
+// memory.  Every reader runs in its own process, so the peak memory is its
+// own and the readers do not share what the others left in memory.
+
+// every allocation of the process is counted; the readers are measured
+// from the start of the pass to its end
+static atomic< long long > allocations( 0 );
+
+void* operator new( size_t size ){
+
+  ++allocations;
+  void* p = malloc( size > 0 ? size : 1 );
+  if( p == NULL ) throw bad_alloc();
+  return p;
+}
+
+void operator delete( void* p ) noexcept { free( p ); }
+void operator delete( void* p, size_t ) noexcept { free( p ); }
+
+namespace {
+
+  template< class R >
+  DataReader* makeReader( const vector< string >& args ){ return new R( args ); }
+
+  struct ReaderType {
+
+    string name;
+    DataReader* (*make)( const vector< string >& );
+  };
+
+  const ReaderType kReaderTypes[] = {
+
+    { "ROOTDataReader",          makeReader< ROOTDataReader > },
+    { "ROOTDataReaderBootstrap", makeReader< ROOTDataReaderBootstrap > },
+    { "ROOTDataReaderWithTCut",  makeReader< ROOTDataReaderWithTCut > },
+    { "ROOTDataReaderBinned",    makeReader< ROOTDataReaderBinned > },
+    { "ROOTDataReaderTEM",       makeReader< ROOTDataReaderTEM > },
+    { "ROOTDataReaderPipeline",  makeReader< ROOTDataReaderPipeline > },
+    { "BinaryDataReader",        makeReader< BinaryDataReader > }
+  };
+
+  // the default readers, with the ROOT file as FILE and the binary file
+  // as BINFILE; the cuts are wide enough to keep every event
+  const char* kDefaultReaders[] = {
+
+    "ROOTDataReader FILE",
+    "ROOTDataReader FILE kin bulk=1",
+    "ROOTDataReader FILE kin async=1",
+    "ROOTDataReaderBootstrap FILE 1",
+    "ROOTDataReaderWithTCut FILE 0 1000",
+    "ROOTDataReaderTEM FILE 0 1000 0 1000 0 1000",
+    "ROOTDataReaderBinned FILE 0 1000 1 0",
+    "BinaryDataReader BINFILE"
+  };
+
+  // the readers of -m, which read FILE into shared columns
+  const char* kSharedReaders[] = {
+
+    "ROOTDataReader FILE kin shm=1",
+    "ROOTDataReaderPipeline FILE kin shm=1",
+    "ROOTDataReaderBootstrap FILE 1 shm=1",
+    "ROOTDataReaderWithTCut FILE 0 1000 shm=1",
+    "ROOTDataReaderTEM FILE 0 1000 0 1000 0 1000 shm=1",
+    "ROOTDataReaderBinned FILE 0 1000 1 0 shm=1"
+  };
+
+  bool isURL( const string& fileName ){
+
+    return fileName.find( "://" ) != string::npos;
+  }
+
+  // the size of a local file or one behind a URL
+  double fileSize( const string& fileName ){
+
+    if( !isURL( fileName ) ){
+
+      struct stat info;
+      return ( stat( fileName.c_str(), &info ) == 0 ? info.st_size : 0 );
+    }
+
+    TFile* file = TFile::Open( fileName.c_str() );
+    if( file == NULL ) return 0;
+    double size = file->GetSize();
+    file->Close();
+    delete file;
+    return size;
+  }
+
+  // drops the pages of a local file from the page cache so that it is
+  // read from the disk; this works for clean pages without privileges
+  void dropFromCache( const string& fileName ){
+
+    if( isURL( fileName ) ) return;
+
+    int fd = open( fileName.c_str(), O_RDONLY );
+    if( fd < 0 ) return;
+    fdatasync( fd );
+    posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+    close( fd );
+  }
+
+  string binaryName( const string& fileName ){
+
+    size_t dot = fileName.rfind( ".root" );
+    return ( dot == string::npos ? fileName : fileName.substr( 0, dot ) ) + ".bin";
+  }
+
+  // nEvents events of nPart final state particles with random momenta and
+  // a weight, in the ROOT file and the same events in the binary file
+  void writeSynthetic( const string& fileName, int nEvents, int nPart, unsigned int seed ){
+
+    TRandom3 random( seed );
+
+    ROOTDataWriter rootOut( fileName, "kin", true, true );
+    BinaryDataWriter binaryOut( binaryName( fileName ), true );
+
+    vector< TLorentzVector > particles( nPart + 1 );
+
+    for( int i = 0; i < nEvents; ++i ){
+
+      double eBeam = random.Uniform( 8, 9 );
+      particles[0].SetPxPyPzE( 0, 0, eBeam, eBeam );
+
+      for( int j = 1; j <= nPart; ++j ){
+
+        double px = random.Gaus( 0, 0.5 ), py = random.Gaus( 0, 0.5 );
+        double pz = random.Uniform( 0, 4 );
+        double m = ( j == 1 ? 0.938272 : 0.13957 );
+        particles[j].SetPxPyPzE( px, py, pz, sqrt( px * px + py * py + pz * pz + m * m ) );
+      }
+
+      Kinematics kin( particles, random.Uniform( 0.5, 1.5 ) );
+      rootOut.writeEvent( kin );
+      binaryOut.writeEvent( kin );
+    }
+
+    cout << "Wrote " << nEvents << " events with " << nPart << " particles to "
+         << fileName << " and " << binaryName( fileName ) << endl;
+  }
+
+  vector< string > splitSpec( const string& spec, const string& fileName ){
+
+    vector< string > fields;
+    istringstream in( spec );
+    string field;
+    while( in >> field ){
+
+      if( field == "FILE" ) field = fileName;
+      else if( field == "BINFILE" ) field = binaryName( fileName );
+      fields.push_back( field );
+    }
+    return fields;
+  }
+
+  const ReaderType* readerType( const string& name ){
+
+    for( unsigned int t = 0; t < sizeof( kReaderTypes ) / sizeof( kReaderTypes[0] ); ++t ){
+
+      if( kReaderTypes[t].name == name ) return &kReaderTypes[t];
+    }
+
+    cout << "reader_benchmark ERROR:  unknown reader " << name << endl;
+    return NULL;
+  }
+
+  struct Result {
+
+    double openSeconds;
+    double readSeconds;
+    long long events;
+    double allocationsPerEvent;
+    double maxRSSMB;
+    bool valid;
+  };
+
+  Result runReader( const vector< string >& fields ){
+
+    Result result = { 0, 0, 0, 0, 0, false };
+
+    const ReaderType* type = readerType( fields[0] );
+    if( type == NULL ) return result;
+
+    typedef chrono::steady_clock Clock;
+
+    Clock::time_point start = Clock::now();
+    DataReader* reader = type->make( vector< string >( fields.begin() + 1, fields.end() ) );
+    Clock::time_point opened = Clock::now();
+
+    long long before = allocations;
+
+    Kinematics* kin;
+    while( ( kin = reader->getEvent() ) != NULL ){
+
+      ++result.events;
+      delete kin;
+    }
+
+    Clock::time_point done = Clock::now();
+
+    // the Kinematics of every event is one of the allocations
+    result.allocationsPerEvent =
+      ( result.events > 0 ? double( allocations - before ) / result.events : 0 );
+
+    delete reader;
+
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+
+    result.openSeconds = chrono::duration< double >( opened - start ).count();
+    result.readSeconds = chrono::duration< double >( done - opened ).count();
+    result.maxRSSMB = usage.ru_maxrss / 1024.;
+    result.valid = true;
+
+    return result;
+  }
+
+  // the number of events of a pass over reader and the sum of their
+  // weighted energies, which tells whether two readers return the same
+  struct Pass {
+
+    long long events;
+    double sum;
+  };
+
+  Pass readAll( DataReader* reader ){
+
+    Pass pass = { 0, 0 };
+
+    Kinematics* kin;
+    while( ( kin = reader->getEvent() ) != NULL ){
+
+      ++pass.events;
+      for( unsigned int i = 0; i < kin->particleList().size(); ++i )
+        pass.sum += kin->weight() * kin->particleList()[i].E();
+      delete kin;
+    }
+
+    return pass;
+  }
+
+  int numFiles( const string& dir ){
+
+    int n = 0;
+    DIR* entries = opendir( dir.c_str() );
+    if( entries == NULL ) return -1;
+
+    dirent* entry;
+    while( ( entry = readdir( entries ) ) != NULL ) if( entry->d_name[0] != '.' ) ++n;
+    closedir( entries );
+
+    return n;
+  }
+
+  // The check of -m:  two readers in this process share the mapping of
+  // the columns, a reader in another process attaches to them while these
+  // are alive, all return the same events, and the file of the columns is
+  // removed after the last reader is gone.  Returns an empty string if the
+  // readers pass, else what went wrong.  The other process is stopped after
+  // timeout seconds.
+  string checkShared( const ReaderType* type, const vector< string >& args, const string& shmDir,
+                      int timeout ){
+
+    DataReader* first = type->make( args );
+    DataReader* second = type->make( args );
+
+    Pass firstPass = readAll( first );
+    Pass secondPass = readAll( second );
+    if( firstPass.events == 0 ) return "no events";
+    if( secondPass.events != firstPass.events || secondPass.sum != firstPass.sum )
+      return "the second reader in the process returns other events";
+    if( numFiles( shmDir ) != 1 ) return "the columns are not in one shared file";
+
+    int toOther[2], fromOther[2];
+    if( pipe( toOther ) != 0 || pipe( fromOther ) != 0 ) return "cannot create a pipe";
+
+    cout.flush();
+    pid_t pid = fork();
+    if( pid < 0 ) return "cannot fork";
+
+    if( pid == 0 ){
+
+      // a process of its own, so it does not share the mapping of this one
+      close( toOther[1] );
+      close( fromOther[0] );
+      alarm( timeout );
+
+      DataReader* other = type->make( args );
+      Pass otherPass = readAll( other );
+      ssize_t written = write( fromOther[1], &otherPass, sizeof( otherPass ) );
+
+      char go;
+      if( read( toOther[0], &go, 1 ) != 1 ) _exit( 1 );
+      delete other;
+
+      written += write( fromOther[1], &go, 1 );
+      _exit( written == sizeof( otherPass ) + 1 ? 0 : 1 );
+    }
+
+    close( toOther[0] );
+    close( fromOther[1] );
+
+    string problem;
+    Pass otherPass = { 0, 0 };
+    if( read( fromOther[0], &otherPass, sizeof( otherPass ) ) != sizeof( otherPass ) )
+      problem = "the reader in another process failed";
+    else if( otherPass.events != firstPass.events || otherPass.sum != firstPass.sum )
+      problem = "the reader in another process returns other events";
+
+    delete first;
+    delete second;
+    if( problem == "" && numFiles( shmDir ) != 1 )
+      problem = "the columns were removed while another process used them";
+
+    char go = 'x';
+    if( write( toOther[1], &go, 1 ) != 1 || read( fromOther[0], &go, 1 ) != 1 )
+      if( problem == "" ) problem = "the reader in another process failed";
+    waitpid( pid, NULL, 0 );
+    close( toOther[1] );
+    close( fromOther[0] );
+
+    if( problem == "" && numFiles( shmDir ) != 0 )
+      problem = "the columns were not removed after the last reader";
+
+    return problem;
+  }
+
+  // runs checkShared in a child process, which is stopped if the readers
+  // wait for each other for longer than timeout seconds
+  string checkSharedProcess( const vector< string >& fields, const string& shmDir, int timeout ){
+
+    const ReaderType* type = readerType( fields[0] );
+    if( type == NULL ) return "unknown reader";
+
+    vector< string > args( fields.begin() + 1, fields.end() );
+    args.push_back( "shmdir=" + shmDir );
+
+    int fd[2];
+    if( pipe( fd ) != 0 ) return "cannot create a pipe";
+
+    cout.flush();
+    pid_t pid = fork();
+    if( pid < 0 ) return "cannot fork";
+
+    if( pid == 0 ){
+
+      close( fd[0] );
+      alarm( timeout );
+      string problem = checkShared( type, args, shmDir, timeout );
+      ssize_t written = write( fd[1], problem.data(), problem.size() );
+      close( fd[1] );
+      _exit( written == (ssize_t)problem.size() ? 0 : 1 );
+    }
+
+    close( fd[1] );
+
+    string problem;
+    char buffer[256];
+    ssize_t n;
+    while( ( n = read( fd[0], buffer, sizeof( buffer ) ) ) > 0 ) problem.append( buffer, n );
+    close( fd[0] );
+
+    int status;
+    waitpid( pid, &status, 0 );
+    if( WIFSIGNALED( status ) ){
+
+      problem = ( WTERMSIG( status ) == SIGALRM ?
+                  "the readers waited for each other for longer than the timeout" :
+                  "the check stopped with a signal" );
+    }
+    else if( WEXITSTATUS( status ) != 0 && problem == "" ) problem = "the check failed";
+
+    return problem;
+  }
+
+  // runs the reader in a child process and reads its result from a pipe
+  Result runReaderProcess( const vector< string >& fields ){
+
+    Result result = { 0, 0, 0, 0, 0, false };
+
+    int fd[2];
+    if( pipe( fd ) != 0 ) return result;
+
+    cout.flush();
+    pid_t pid = fork();
+
+    if( pid == 0 ){
+
+      close( fd[0] );
+      Result childResult = runReader( fields );
+      ssize_t written = write( fd[1], &childResult, sizeof( childResult ) );
+      close( fd[1] );
+      _exit( written == sizeof( childResult ) ? 0 : 1 );
+    }
+
+    close( fd[1] );
+    if( pid > 0 ){
+
+      if( read( fd[0], &result, sizeof( result ) ) != sizeof( result ) ) result.valid = false;
+      waitpid( pid, NULL, 0 );
+    }
+    close( fd[0] );
+
+    return result;
+  }
+}
+
+void Usage()
+{
+  cout << "Usage:\n  reader_benchmark <file> [options]\n\n";
+  cout << "   Reads <file> (a path or a root:// URL) through each data reader and\n";
+  cout << "   reports the construction time, events/s, MB/s, allocations per event\n";
+  cout << "   and peak memory.  BinaryDataReader reads <file> with .bin for .root.\n";
+  cout << "   Use -g [events] to first write a synthetic <file> and its .bin copy.\n";
+  cout << "   Use -p [particles] to set the final state particles of -g (default 4).\n";
+  cout << "   Use -s [seed] to set the seed of -g (default 1).\n";
+  cout << "   Use -r [spec] to time the reader spec instead of the defaults, e.g.\n";
+  cout << "     -r \"ROOTDataReader FILE kin async=1\" (FILE and BINFILE are replaced\n";
+  cout << "     by the file names); may be given more than once.\n";
+  cout << "   Use -c to drop local files from the page cache before each reader.\n";
+  cout << "   Use -m to check the readers of shm=1 (or those of -r) instead:  two\n";
+  cout << "     readers in one process and one in another share one copy of the\n";
+  cout << "     events, which is removed after the last of them.\n";
+  cout << "   Use -l to list the default readers.\n";
+  exit(1);
+}
+
+int main( int argc, char* argv[] ){
+
+  int nGenerate = 0, nPart = 4;
+  unsigned int seed = 1;
+  bool coldCache = false;
+  bool checkSharing = false;
+  vector< string > specs;
+
+  if( argc > 1 && string( argv[1] ) == "-l" ){
+
+    for( unsigned int i = 0; i < sizeof( kDefaultReaders ) / sizeof( kDefaultReaders[0] ); ++i ){
+
+      cout << kDefaultReaders[i] << endl;
+    }
+    return 0;
+  }
+
+  if( argc < 2 || argv[1][0] == '-' ) Usage();
+  string fileName = argv[1];
+
+  for( int i = 2; i < argc; ++i ){
+
+    string arg = argv[i];
+
+    if( arg == "-c" ){ coldCache = true; continue; }
+    if( arg == "-m" ){ checkSharing = true; continue; }
+    if( i + 1 == argc ) Usage();
+
+    if( arg == "-g" ) nGenerate = atoi( argv[++i] );
+    else if( arg == "-p" ) nPart = atoi( argv[++i] );
+    else if( arg == "-s" ) seed = atoi( argv[++i] );
+    else if( arg == "-r" ) specs.push_back( argv[++i] );
+    else Usage();
+  }
+
+  TH1::AddDirectory( kFALSE );
+
+  if( nGenerate > 0 ){
+
+    if( isURL( fileName ) ){
+
+      cout << "reader_benchmark ERROR:  cannot write to " << fileName << endl;
+      assert( false );
+    }
+    writeSynthetic( fileName, nGenerate, nPart, seed );
+  }
+
+  if( checkSharing ){
+
+    if( specs.empty() ){
+
+      specs.assign( kSharedReaders,
+                    kSharedReaders + sizeof( kSharedReaders ) / sizeof( kSharedReaders[0] ) );
+    }
+
+    // the shared columns of the check are in a directory of their own
+    char shmDir[] = "/tmp/reader_benchmark_XXXXXX";
+    if( mkdtemp( shmDir ) == NULL ){
+
+      cout << "reader_benchmark ERROR:  cannot create a directory for the shared columns" << endl;
+      return 1;
+    }
+
+    int nFailed = 0;
+    for( unsigned int s = 0; s < specs.size(); ++s ){
+
+      vector< string > fields = splitSpec( specs[s], fileName );
+      if( fields.size() < 2 ) Usage();
+
+      string problem = checkSharedProcess( fields, shmDir, 60 );
+      cout << setw( 52 ) << left << specs[s] << ( problem == "" ? "ok" : "FAILED:  " + problem ) << endl;
+      if( problem != "" ) ++nFailed;
+
+      // the columns a failed check left behind are not those of the next
+      if( DIR* entries = opendir( shmDir ) ){
+
+        dirent* entry;
+        while( ( entry = readdir( entries ) ) != NULL )
+          if( entry->d_name[0] != '.' ) unlink( ( string( shmDir ) + "/" + entry->d_name ).c_str() );
+        closedir( entries );
+      }
+    }
+
+    rmdir( shmDir );
+    return ( nFailed == 0 ? 0 : 1 );
+  }
+
+  if( specs.empty() ){
+
+    specs.assign( kDefaultReaders,
+                  kDefaultReaders + sizeof( kDefaultReaders ) / sizeof( kDefaultReaders[0] ) );
+  }
+
+  cout << endl << setw( 46 ) << left << "reader"
+       << setw( 9 ) << right << "open[s]"
+       << setw( 12 ) << "events/s"
+       << setw( 9 ) << "MB/s"
+       << setw( 12 ) << "allocs/ev"
+       << setw( 11 ) << "maxRSS[MB]" << endl;
+
+  for( unsigned int s = 0; s < specs.size(); ++s ){
+
+    vector< string > fields = splitSpec( specs[s], fileName );
+    if( fields.size() < 2 ) Usage();
+
+    // the file the reader reads is its first argument
+    if( coldCache ) dropFromCache( fields[1] );
+
+    Result result = runReaderProcess( fields );
+
+    cout << setw( 46 ) << left << specs[s];
+
+    if( !result.valid ){
+
+      cout << "  failed" << endl;
+      continue;
+    }
+
+    double totalSeconds = result.openSeconds + result.readSeconds;
+    double MB = fileSize( fields[1] ) / ( 1024. * 1024. );
+
+    // the file is read when the reader is constructed by some readers
+    // (bulk=1, the index of the cuts) and in the pass of the others, so
+    // the rates are of both
+    cout << right << fixed
+         << setw( 9 ) << setprecision( 3 ) << result.openSeconds
+         << setw( 12 ) << setprecision( 0 ) << ( totalSeconds > 0 ? result.events / totalSeconds : 0 )
+         << setw( 9 ) << setprecision( 1 ) << ( totalSeconds > 0 ? MB / totalSeconds : 0 )
+         << setw( 12 ) << setprecision( 2 ) << result.allocationsPerEvent
+         << setw( 11 ) << setprecision( 1 ) << result.maxRSSMB << endl;
+  }
+
+  return 0;
+}
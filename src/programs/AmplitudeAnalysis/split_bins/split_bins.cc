@@ -0,0 +1,350 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+#include <cmath>
+#include <utility>
+
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriterPool.h"
+
+#include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+#include "TH1.h"
+
+using namespace std;
+
+#define DEFTREENAME "kin"
+
+void Usage()
+{
+  cout << "Usage:\n  split_bins <infile> <outputBase> <axis> [axis ...] [OPTIONS]\n\n";
+  cout << "  Each axis has the form  variable:nBins:low:high[:log]  where variable is\n";
+  cout << "   mass  : invariant mass of the final state excluding the recoil\n";
+  cout << "   t     : -t computed from the recoil (first final state particle)\n";
+  cout << "   ebeam : beam energy\n";
+  cout << "  or any expression of the input tree branches, e.g. E_FinalState[1].\n";
+  cout << "  Events are written to <outputBase>_<bin1>[_<bin2>...].root\n\n";
+  cout << "  Options: \n";
+  cout << "   -M [maxEvents] : Limit total number of events\n";
+  cout << "   -T [treeName]  : Overwrites the default ROOT tree name (\"kin\") in output and/or input files\n";
+  cout << "                    To specify input and output names delimit with \':\' ex. -T inKin:outKin\n";
+  cout << "   -t [treeName]  : Update existing files with new tree, instead of overwriting.\n";
+  cout << "   -j [nThreads]  : Number of threads used to write the output files (default: 4)\n";
+  cout << "   -C [codec[:level]] : Output compression (zlib, lzma, lz4, zstd, none)\n";
+  cout << "   -B [bytes]     : Output basket size\n";
+  cout << "   -F [n]         : Output auto-flush (entries if n > 0, bytes if n < 0)\n";
+  exit(1);
+}
+
+
+pair <string,string> GetTreeNames(char* treeArg)
+{
+  pair <string,string> treeNames(DEFTREENAME,"");
+  string treeArgStr(treeArg);
+  size_t delimPos=treeArgStr.find(':',1);
+
+  if (delimPos != string::npos){
+    treeNames.first=treeArgStr.substr(0,delimPos);
+    treeNames.second=treeArgStr.substr(delimPos+1);
+  }else
+    treeNames.second=treeArgStr;
+
+  return treeNames;
+}
+
+
+struct Axis {
+
+  enum Variable { kMass, kT, kEBeam, kFormula };
+
+  Variable var;
+  string expression;
+  TTreeFormula* formula;
+  int numBins;
+  double low;
+  double high;
+  bool logarithmic;
+  double step;
+
+  int bin( double x ) const {
+
+    if( logarithmic ){
+
+      if( x <= 0 ) return -1;
+      return static_cast< int >( floor( ( log10( x ) - log10( low ) ) / step ) );
+    }
+
+    return static_cast< int >( floor( ( x - low ) / step ) );
+  }
+};
+
+
+Axis ParseAxis( const string& spec )
+{
+  vector< string > tokens;
+  size_t start = 0, end;
+  while( ( end = spec.find( ':', start ) ) != string::npos ){
+
+    tokens.push_back( spec.substr( start, end - start ) );
+    start = end + 1;
+  }
+  tokens.push_back( spec.substr( start ) );
+
+  Axis axis;
+  axis.formula = NULL;
+  axis.logarithmic = false;
+
+  if( tokens.back() == "log" ){
+
+    axis.logarithmic = true;
+    tokens.pop_back();
+  }
+
+  if( tokens.size() < 4 ) Usage();
+
+  // the expression itself may contain ':'
+  axis.high = atof( tokens.back().c_str() ); tokens.pop_back();
+  axis.low = atof( tokens.back().c_str() ); tokens.pop_back();
+  axis.numBins = atoi( tokens.back().c_str() ); tokens.pop_back();
+
+  axis.expression = tokens[0];
+  for( unsigned int i = 1; i < tokens.size(); ++i ) axis.expression += ":" + tokens[i];
+
+  if( axis.expression == "mass" ) axis.var = Axis::kMass;
+  else if( axis.expression == "t" ) axis.var = Axis::kT;
+  else if( axis.expression == "ebeam" ) axis.var = Axis::kEBeam;
+  else axis.var = Axis::kFormula;
+
+  if( axis.numBins <= 0 || axis.high <= axis.low ) Usage();
+  if( axis.logarithmic && axis.low <= 0 ) Usage();
+
+  if( axis.logarithmic )
+    axis.step = ( log10( axis.high ) - log10( axis.low ) ) / axis.numBins;
+  else
+    axis.step = ( axis.high - axis.low ) / axis.numBins;
+
+  return axis;
+}
+
+
+double AxisValue( const Axis& axis, const ROOTDataEvent& event )
+{
+  switch( axis.var ){
+
+    case Axis::kMass: {
+
+      // the first final state particle is the recoil; skip it
+      TLorentzVector x;
+      for( int i = 1; i < event.nPart; ++i ) x += event.finalState( i );
+      return x.M();
+    }
+    case Axis::kT: {
+
+      TLorentzVector target( 0, 0, 0, 0.938272046 );
+      return -1 * ( event.finalState( 0 ) - target ).M2();
+    }
+    case Axis::kEBeam:
+
+      return event.eBeam;
+
+    case Axis::kFormula:
+
+      return axis.formula->EvalInstance();
+  }
+
+  return 0;
+}
+
+
+int main( int argc, char* argv[] ){
+
+  unsigned int maxEvents = 4294967000; //close to 4byte int range
+
+  pair <string,string> treeNames(DEFTREENAME,DEFTREENAME);
+
+  bool recreate=true;
+  unsigned int nThreads = 4;
+  ROOTDataWriterOptions writerOptions;
+
+  if( argc < 4 ) Usage();
+
+  string inFileName( argv[1] );
+  string outBase( argv[2] );
+
+  vector< Axis > axes;
+
+  for( int i = 3; i < argc; ++i ){
+
+    string arg = argv[i];
+
+    if (arg == "-t"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else{
+        treeNames = GetTreeNames(argv[++i]);
+        recreate=false;
+      }
+    }else if (arg == "-T"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else{
+        treeNames = GetTreeNames(argv[++i]);
+        recreate=true;
+      }
+    }else if (arg == "-M"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else maxEvents = atoi( argv[++i] );
+    }else if (arg == "-j"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else nThreads = atoi( argv[++i] );
+    }else if (arg == "-C"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else writerOptions.compression = argv[++i];
+    }else if (arg == "-B"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else writerOptions.basketSize = atoi( argv[++i] );
+    }else if (arg == "-F"){
+      if (i+1 == argc) Usage();
+      else writerOptions.autoFlush = atoll( argv[++i] );
+    }else if (arg[0] == '-'){
+      Usage();
+    }else{
+      axes.push_back( ParseAxis( arg ) );
+    }
+  }
+
+  if( axes.empty() ) Usage();
+
+  enum { kMaxOutputs = 1000 };
+
+  unsigned int numOutputs = 1;
+  for( unsigned int i = 0; i < axes.size(); ++i ) numOutputs *= axes[i].numBins;
+  assert( numOutputs < kMaxOutputs );
+
+  TH1::AddDirectory( kFALSE );
+
+  //this way of opening files works with URLs of the form
+  // root://xrootdserver/path/to/myfile.root
+  TFile* inFile = TFile::Open( inFileName.c_str() );
+  TTree* inTree = dynamic_cast< TTree* >( inFile->Get( treeNames.first.c_str() ) );
+  assert( inTree != NULL );
+
+  bool hasWeight = ( inTree->GetBranch( "Weight" ) != NULL );
+
+  // expressions of the tree branches have to be evaluated on the tree
+  // itself, so read in this thread if there are any; otherwise read
+  // ahead on a background thread
+  bool useFormula = false;
+  for( unsigned int i = 0; i < axes.size(); ++i ){
+
+    if( axes[i].var != Axis::kFormula ) continue;
+
+    useFormula = true;
+    axes[i].formula = new TTreeFormula( axes[i].expression.c_str(),
+                                        axes[i].expression.c_str(), inTree );
+    if( axes[i].formula->GetNdim() == 0 ){
+
+      cout << "split_bins ERROR:  cannot evaluate " << axes[i].expression << endl;
+      exit(1);
+    }
+  }
+
+  ROOTDataEvent event;
+  event.weight = 1.0;
+
+  ROOTDataPrefetcher* prefetcher = NULL;
+
+  if( useFormula ){
+
+    inTree->SetBranchAddress( "NumFinalState", &event.nPart );
+    inTree->SetBranchAddress( "E_FinalState", event.e );
+    inTree->SetBranchAddress( "Px_FinalState", event.px );
+    inTree->SetBranchAddress( "Py_FinalState", event.py );
+    inTree->SetBranchAddress( "Pz_FinalState", event.pz );
+    inTree->SetBranchAddress( "E_Beam", &event.eBeam );
+    inTree->SetBranchAddress( "Px_Beam", &event.pxBeam );
+    inTree->SetBranchAddress( "Py_Beam", &event.pyBeam );
+    inTree->SetBranchAddress( "Pz_Beam", &event.pzBeam );
+    if( hasWeight ) inTree->SetBranchAddress( "Weight", &event.weight );
+  }
+  else{
+
+    prefetcher = new ROOTDataPrefetcher( inTree );
+    prefetcher->startAll();
+  }
+
+  vector< string > outNames;
+
+  for( unsigned int iOut = 0; iOut < numOutputs; ++iOut ){
+
+    // the last axis varies fastest
+    ostringstream outName;
+    outName << outBase;
+
+    vector< int > bins( axes.size() );
+    unsigned int rest = iOut;
+    for( int i = axes.size() - 1; i >= 0; --i ){
+
+      bins[i] = rest % axes[i].numBins;
+      rest /= axes[i].numBins;
+    }
+    for( unsigned int i = 0; i < axes.size(); ++i ) outName << "_" << bins[i];
+
+    outName << ".root";
+    outNames.push_back( outName.str() );
+  }
+
+  ROOTDataWriterPool out( outNames, treeNames.second, recreate, hasWeight, nThreads,
+                          writerOptions );
+
+  unsigned int nEntries = static_cast< unsigned int >( inTree->GetEntries() );
+  if( nEntries > maxEvents ) nEntries = maxEvents;
+
+  for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
+
+    if( prefetcher != NULL ){
+
+      prefetcher->next( event );
+    }
+    else{
+
+      inTree->GetEntry( iEntry );
+    }
+
+    assert( event.nPart < Kinematics::kMaxParticles );
+
+    int iOut = 0;
+    for( unsigned int i = 0; i < axes.size(); ++i ){
+
+      int bin = axes[i].bin( AxisValue( axes[i], event ) );
+      if( bin < 0 || bin >= axes[i].numBins ){ iOut = -1; break; }
+
+      iOut = iOut * axes[i].numBins + bin;
+    }
+
+    if( iOut >= 0 ) out.writeEvent( iOut, event );
+  }
+
+  if( prefetcher != NULL ) delete prefetcher;
+
+  out.close();
+
+  for( unsigned int i = 0; i < numOutputs; ++i ){
+
+    printf("%s  %10i events\n", outNames[i].c_str(), out.eventCounter( i ) );
+  }
+
+  for( unsigned int i = 0; i < axes.size(); ++i ){
+
+    if( axes[i].formula != NULL ) delete axes[i].formula;
+  }
+
+  inFile->Close();
+
+  return 0;
+}
@@ -7,11 +7,18 @@
 #include <cstdlib>
 #include <utility>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
 
-#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
-#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriterPool.h"
 
 #include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
 
 #include "TH1F.h"
 using namespace std;
@@ -25,6 +32,13 @@ void Usage()
   cout << "   overwrites the default ROOT tree name (\"kin\") in output and/or input files\n";
   cout << "   To specify input and output names delimit with \':\' ex. -T inKin:outKin\n";
   cout << "   Use -t to update existing files with new tree, instead of overwritting.\n";
+  cout << "   Use -j [nThreads] to write the output files on nThreads threads.\n";
+  cout << "   Use -b [edgeFile] for the bin edges in edgeFile (increasing, separated by white space)\n";
+  cout << "      instead of lowMass, highMass and nBins.\n";
+  cout << "   Use -q for nBins bins between lowMass and highMass with equal numbers of events.\n";
+  cout << "   Use -C [codec[:level]] to set the output compression (zlib, lzma, lz4, zstd, none).\n";
+  cout << "   Use -B [bytes] to set the output basket size.\n";
+  cout << "   Use -F [n] to set the output auto-flush (entries if n > 0, bytes if n < 0).\n";
   exit(1);
 }
 
@@ -45,6 +59,88 @@ pair <string,string> GetTreeNames(char* treeArg)
 }
 
 
+vector< double > ReadEdges(const string& edgeFile)
+{
+  vector< double > edges;
+  ifstream in(edgeFile.c_str());
+  double edge;
+  while( in >> edge ) edges.push_back( edge );
+
+  if( edges.size() < 2 ){
+    cout << "split_mass ERROR:  " << edgeFile << " has fewer than two bin edges" << endl;
+    exit(1);
+  }
+  for( unsigned int i = 1; i < edges.size(); ++i ){
+    if( edges[i] <= edges[i-1] ){
+      cout << "split_mass ERROR:  the bin edges in " << edgeFile << " do not increase" << endl;
+      exit(1);
+    }
+  }
+
+  return edges;
+}
+
+
+// the mass of the final state without the recoil, the first particle
+double SystemMass(const ROOTDataEvent& event)
+{
+  double e = 0, px = 0, py = 0, pz = 0;
+  for( int i = 1; i < event.nPart; ++i ){
+    e += event.e[i];
+    px += event.px[i];
+    py += event.py[i];
+    pz += event.pz[i];
+  }
+
+  double m2 = e*e - px*px - py*py - pz*pz;
+  return ( m2 < 0 ? -sqrt( -m2 ) : sqrt( m2 ) );
+}
+
+
+// Edges of numBins bins between lowMass and highMass with equal numbers of
+// events.  The masses are counted in a fine histogram on a first pass, so
+// the memory does not grow with the input; the edges are good to a
+// fraction kSketchBins of the range.
+vector< double > EqualStatisticsEdges(ROOTDataPrefetcher& in, unsigned int nEntries,
+                                      double lowMass, double highMass, int numBins)
+{
+  const int kSketchBins = 100000;
+  vector< unsigned int > counts( kSketchBins, 0 );
+  double width = ( highMass - lowMass ) / kSketchBins;
+
+  ROOTDataEvent event;
+  unsigned long long inRange = 0;
+
+  in.startAll();
+  for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
+
+    in.next( event );
+
+    int bin = static_cast< int >( floor( ( SystemMass( event ) - lowMass ) / width ) );
+    if( ( bin < kSketchBins ) && ( bin >= 0 ) ){
+      ++counts[bin];
+      ++inRange;
+    }
+  }
+  in.stop();
+
+  vector< double > edges( 1, lowMass );
+  unsigned long long sum = 0;
+  for( int i = 0; i < kSketchBins && (int)edges.size() < numBins; ++i ){
+
+    sum += counts[i];
+    if( sum * numBins >= inRange * edges.size() ) edges.push_back( lowMass + ( i + 1 ) * width );
+  }
+  while( (int)edges.size() < numBins ) edges.push_back( highMass );
+  edges.push_back( highMass );
+
+  cout << "Bin edges with about " << inRange / numBins << " events per bin:" << endl;
+  for( unsigned int i = 0; i < edges.size(); ++i ) cout << "  " << edges[i] << endl;
+
+  return edges;
+}
+
+
 int main( int argc, char* argv[] ){
   
   unsigned int maxEvents = 4294967000; //close to 4byte int range
@@ -53,6 +149,10 @@ int main( int argc, char* argv[] ){
   pair <string,string> treeNames(DEFTREENAME,DEFTREENAME);
 
   bool recreate=true;
+  unsigned int nThreads = 0;
+  string edgeFile;
+  bool equalStatistics = false;
+  ROOTDataWriterOptions writerOptions;
 
   if( argc < 6 ) Usage();
   
@@ -65,7 +165,7 @@ int main( int argc, char* argv[] ){
   // A somewhat convoluted way to allow tree name specification
   // via "-t [name]" in the arg. list after the standard args
   if( argc > 6 ) {
-    for(int i=6; i<=7 && i<argc ; ++i){
+    for(int i=6; i<argc ; ++i){
       string arg=argv[i];
       if (arg == "-t"){
 	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
@@ -79,6 +179,23 @@ int main( int argc, char* argv[] ){
 	  treeNames = GetTreeNames(argv[++i]);
 	  recreate=true;
 	}
+      }else if (arg == "-j"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else nThreads = atoi( argv[++i] );
+      }else if (arg == "-b"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else edgeFile = argv[++i];
+      }else if (arg == "-q"){
+	equalStatistics = true;
+      }else if (arg == "-C"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else writerOptions.compression = argv[++i];
+      }else if (arg == "-B"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else writerOptions.basketSize = atoi( argv[++i] );
+      }else if (arg == "-F"){
+	if (i+1 == argc) Usage();
+	else writerOptions.autoFlush = atoll( argv[++i] );
       }else
 	if(i==6) maxEvents = atoi( arg.c_str() );
 	else Usage();
@@ -86,57 +203,77 @@ int main( int argc, char* argv[] ){
   }
 
   
-  vector< string > dataReaderArgs;
-  dataReaderArgs.push_back( argv[1] );
-  dataReaderArgs.push_back( treeNames.first );
-  
-  // open reader
-  ROOTDataReader in( dataReaderArgs );
+  TH1::AddDirectory( kFALSE );
+
+  //this way of opening files works with URLs of the form
+  // root://xrootdserver/path/to/myfile.root
+  TFile* inFile = TFile::Open( argv[1] );
+  TTree* inTree = dynamic_cast< TTree* >( inFile->Get( treeNames.first.c_str() ) );
+  assert( inTree != NULL );
+
+  bool hasWeight = ( inTree->GetBranch( "Weight" ) != NULL );
+
+  unsigned int nEntries = static_cast< unsigned int >( inTree->GetEntries() );
+  if( nEntries > maxEvents ) nEntries = maxEvents;
+
+  // reading and decompressing the input runs ahead on its own thread
+  ROOTDataPrefetcher in( inTree );
+
+  // the bins are looked up by their edges, which are uniform unless they
+  // are read from a file or chosen for equal numbers of events
+  vector< double > edges;
+  if( edgeFile.size() != 0 ){
+    edges = ReadEdges( edgeFile );
+    numBins = edges.size() - 1;
+  }
+  else if( equalStatistics ){
+    edges = EqualStatisticsEdges( in, nEntries, lowMass, highMass, numBins );
+  }
+  else{
+    for( int i = 0; i <= numBins; ++i ) edges.push_back( lowMass + i * ( highMass - lowMass ) / numBins );
+  }
+
+  in.startAll();
   
   enum { kMaxBins = 1000 };
   assert( numBins < kMaxBins );
   
-  double step = ( highMass - lowMass ) / numBins;
-  
-  ROOTDataWriter* outFile[kMaxBins];
+  vector< string > outNames;
   
   for( int i = 0; i < numBins; ++i ){
     
     ostringstream outName;
     outName << outBase << "_" << i << ".root";
-    outFile[i] = new ROOTDataWriter( outName.str(),
-				     treeNames.second.c_str(), 
-				     recreate, in.hasWeight());
+    outNames.push_back( outName.str() );
   }
+
+  // with nThreads > 0 the filling and compression of the output trees
+  // is done by nThreads threads, each owning a subset of the files
+  ROOTDataWriterPool outFile( outNames, treeNames.second, recreate,
+                              hasWeight, nThreads, writerOptions );
   
-  unsigned int eventCount = 0;
-  
-  Kinematics* event;
-  while( ( event = in.getEvent() ) != NULL && eventCount++ < maxEvents ){
-    
-    vector< TLorentzVector > fs = event->particleList();
+  ROOTDataEvent event;
+  event.weight = 1.0;
+
+  for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
     
-    TLorentzVector x;
-    // the first two entries in this list are the beam and the recoil
-    // skip them in computing the mass
-    for( vector< TLorentzVector >::iterator particle = fs.begin() + 2;
-	 particle != fs.end(); ++particle ){
-      
-      x += *particle;
-    }
+    in.next( event );
     
-    int bin = static_cast< int >( floor( ( x.M() - lowMass ) / step ) );
+    // the first entry in the final state list is the recoil
+    // skip it in computing the mass
+    double mass = SystemMass( event );
+
+    int bin = static_cast< int >( upper_bound( edges.begin(), edges.end(), mass ) - edges.begin() ) - 1;
     if( ( bin < numBins ) && ( bin >= 0 ) ){
       
-      outFile[bin]->writeEvent( *event );
-      delete event;
+      outFile.writeEvent( bin, event );
     }
   }
-  
-  for( int i = 0; i < numBins; ++i ){
-    
-    delete outFile[i];
-  }
+
+  in.stop();
+  outFile.close();
+
+  inFile->Close();
   
   return 0;
 }
@@ -7,11 +7,18 @@
 #include <cstdlib>
 #include <utility>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
 
-#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
-#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriterPool.h"
 
-#include "TLorentzVector.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TMath.h"
 
 #include "TH1F.h"
 using namespace std;
@@ -27,6 +34,12 @@ void Usage()
   cout << "                    To specify input and output names delimit with \':\' ex. -T inKin:outKin\n";
   cout << "   -t [treeName]  : Update existing files with new tree, instead of overwriting.\n";
   cout << "   -e             : Use a logarithmic binning (cannot have lowT = 0).\n";
+  cout << "   -b [edgeFile]  : Use the bin edges in edgeFile (increasing, separated by\n";
+  cout << "                    white space) instead of lowT, highT and nBins\n";
+  cout << "   -j [nThreads]  : Write the output files on nThreads threads\n";
+  cout << "   -C [codec[:level]] : Output compression (zlib, lzma, lz4, zstd, none)\n";
+  cout << "   -B [bytes]     : Output basket size\n";
+  cout << "   -F [n]         : Output auto-flush (entries if n > 0, bytes if n < 0)\n";
   exit(1);
 }
 
@@ -47,6 +60,28 @@ pair <string,string> GetTreeNames(char* treeArg)
 }
 
 
+vector< double > ReadEdges(const string& edgeFile)
+{
+  vector< double > edges;
+  ifstream in(edgeFile.c_str());
+  double edge;
+  while( in >> edge ) edges.push_back( edge );
+
+  if( edges.size() < 2 ){
+    cout << "split_t ERROR:  " << edgeFile << " has fewer than two bin edges" << endl;
+    exit(1);
+  }
+  for( unsigned int i = 1; i < edges.size(); ++i ){
+    if( edges[i] <= edges[i-1] ){
+      cout << "split_t ERROR:  the bin edges in " << edgeFile << " do not increase" << endl;
+      exit(1);
+    }
+  }
+
+  return edges;
+}
+
+
 int main( int argc, char* argv[] ){
   
   unsigned int maxEvents = 4294967000; //close to 4byte int range
@@ -57,6 +92,10 @@ int main( int argc, char* argv[] ){
   bool recreate=true;
 
   bool exponential=false;
+  string edgeFile;
+  unsigned int nThreads = 0;
+
+  ROOTDataWriterOptions writerOptions;
 
   if( argc < 6 ) Usage();
   
@@ -88,82 +127,118 @@ int main( int argc, char* argv[] ){
 	else{
 	  maxEvents = atoi( argv[++i] );
 	}
+      }else if (arg == "-C"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else writerOptions.compression = argv[++i];
+      }else if (arg == "-B"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else writerOptions.basketSize = atoi( argv[++i] );
+      }else if (arg == "-F"){
+	if (i+1 == argc) Usage();
+	else writerOptions.autoFlush = atoll( argv[++i] );
       }else if (arg == "-e"){
 	if (lowT == 0) Usage();
 	else exponential = true;
+      }else if (arg == "-b"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else edgeFile = argv[++i];
+      }else if (arg == "-j"){
+	if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+	else nThreads = atoi( argv[++i] );
       }
       else Usage();
     }
   }
 
   
-  vector< string > dataReaderArgs;
-  dataReaderArgs.push_back( argv[1] );
-  dataReaderArgs.push_back( treeNames.first );
-  
-  // open reader
-  ROOTDataReader in( dataReaderArgs );
-  
+  // the bins are looked up by their edges, which are the same for
+  // uniform, logarithmic and custom bins
+  vector< double > edges;
+  if( edgeFile.size() != 0 ){
+    edges = ReadEdges( edgeFile );
+    numBins = edges.size() - 1;
+  }
+  else{
+    for( int i = 0; i <= numBins; ++i ){
+      if (exponential)
+        edges.push_back( pow( 10, TMath::Log10(lowT) +
+                              i * ( TMath::Log10(highT) - TMath::Log10(lowT) ) / numBins ) );
+      else
+        edges.push_back( lowT + i * ( highT - lowT ) / numBins );
+    }
+  }
+
   enum { kMaxBins = 1000 };
   assert( numBins < kMaxBins );
-  
-  double step;
-  if (exponential)
-    step = ( TMath::Log10(highT) - TMath::Log10(lowT) ) / numBins;
-  else
-    step = ( highT - lowT ) / numBins;
 
-  int events[numBins];
-  double Tsum[numBins];
-  double TsumSq[numBins+1];
+  TH1::AddDirectory( kFALSE );
 
-  ROOTDataWriter* outFile[kMaxBins];
-  
+  //this way of opening files works with URLs of the form
+  // root://xrootdserver/path/to/myfile.root
+  TFile* inFile = TFile::Open( argv[1] );
+  TTree* inTree = dynamic_cast< TTree* >( inFile->Get( treeNames.first.c_str() ) );
+  assert( inTree != NULL );
+
+  bool hasWeight = ( inTree->GetBranch( "Weight" ) != NULL );
+
+  // reading and decompressing the input runs ahead on its own thread
+  ROOTDataPrefetcher in( inTree );
+  in.startAll();
+
+  vector< string > outNames;
   for( int i = 0; i < numBins; ++i ){
-    events[i]=0;
-    Tsum[i]=0;
-    TsumSq[i]=0;
 
     ostringstream outName;
     outName << outBase << "_" << i << ".root";
-    outFile[i] = new ROOTDataWriter( outName.str(),
-				     treeNames.second.c_str(), 
-				     recreate, in.hasWeight());
+    outNames.push_back( outName.str() );
   }
-  
-  unsigned int eventCount = 0;
-  
-  Kinematics* event;
-  while( ( event = in.getEvent() ) != NULL && eventCount++ < maxEvents ){
-    
-    vector< TLorentzVector > fs = event->particleList();
-    
-    // the second entry in this list is the recoil
-    TLorentzVector Target(0,0,0,0.938272046);
-    TLorentzVector Recoil(fs[1]);
-
-    double t = -1 * (Recoil - Target).M2();
-    
-    int bin;
-    if (exponential)
-      bin = static_cast< int >( floor( ( TMath::Log10(t) - TMath::Log10(lowT) ) / step ) );
-    else
-      bin = static_cast< int >( floor( ( t - lowT ) / step ) );
+
+  // with nThreads > 0 the filling and compression of the output trees
+  // is done by nThreads threads, each owning a subset of the files
+  ROOTDataWriterPool outFile( outNames, treeNames.second, recreate,
+                              hasWeight, nThreads, writerOptions );
+
+  vector< int > events( numBins, 0 );
+  vector< double > Tsum( numBins, 0 );
+  vector< double > TsumSq( numBins, 0 );
+
+  unsigned int nEntries = static_cast< unsigned int >( inTree->GetEntries() );
+  if( nEntries > maxEvents ) nEntries = maxEvents;
+
+  ROOTDataEvent event;
+  event.weight = 1.0;
+
+  const double mTarget = 0.938272046;
+
+  for( unsigned int iEntry = 0; iEntry < nEntries; ++iEntry ){
+
+    in.next( event );
+
+    // the first entry in the final state list is the recoil; with the
+    // target at rest -t = |p|^2 - ( E - M )^2 of the recoil
+    double dE = event.e[0] - mTarget;
+    double t = event.px[0] * event.px[0] + event.py[0] * event.py[0] +
+      event.pz[0] * event.pz[0] - dE * dE;
+
+    int bin = static_cast< int >( upper_bound( edges.begin(), edges.end(), t ) - edges.begin() ) - 1;
     if( ( bin < numBins ) && ( bin >= 0 ) ){
       Tsum[bin]+=t;
       TsumSq[bin]+=t*t;
       events[bin]++;
-      outFile[bin]->writeEvent( *event );
-      delete event;
+      outFile.writeEvent( bin, event );
     }
   }
-  
+
+  in.stop();
+  outFile.close();
+
+  inFile->Close();
+
   for( int i = 0; i < numBins; ++i ){
     double mean = Tsum[i]/events[i];
     double RMS = sqrt(TsumSq[i]/events[i] - mean*mean);
     printf("bin %2i  %10i events  mean T %.3f  RMS %.3f\n",
 	   i,events[i],mean,RMS);
-    delete outFile[i];
   }
   
   return 0;
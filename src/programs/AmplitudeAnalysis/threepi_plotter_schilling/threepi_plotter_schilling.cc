@@ -11,8 +11,13 @@
 #include "TStyle.h"
 #include "TClass.h"
 #include "TFile.h"
+#include "TH1D.h"
 
 #include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/FitResults.h"
 
 #include "AmpPlotter/PlotterMainWindow.h"
@@ -21,17 +26,14 @@
 #include "AMPTOOLS_DATAIO/ThreePiPlotGeneratorSchilling.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
-#include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
-#include "AMPTOOLS_AMPS/BreitWigner3body.h"
+#include "AMPTOOLS_DATAIO/FitProjections.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
 
 typedef ThreePiPlotGeneratorSchilling PlotGen;
 
-void atiSetup(){
+void atiSetup( const ConfigurationInfo* cfgInfo ){
   
-  AmpToolsInterface::registerAmplitude( ThreePiAnglesSchilling() );
-  AmpToolsInterface::registerAmplitude( BreitWigner() );
-  AmpToolsInterface::registerAmplitude( BreitWigner3body() );
+  AmplitudeRegistry::registerUsed( cfgInfo );
   AmpToolsInterface::registerDataReader( ROOTDataReader() );
   AmpToolsInterface::registerDataReader( ROOTDataReaderWithTCut() );
 }
@@ -66,10 +68,14 @@ int main( int argc, char* argv[] ){
     if (arg == "-o"){
       outName = argv[++i];
     }
+    if (arg == "-j"){
+      AmplitudeThreads::setNumThreads( atoi( argv[++i] ) );
+    }
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "\t -o <file>\t output file path" << endl;
       cout << "\t -g <file>\t show GUI" << endl;
+      cout << "\t -j <int>\t evaluate the amplitudes on <int> threads" << endl;
       exit(1);
     }
   }
@@ -95,12 +101,62 @@ int main( int argc, char* argv[] ){
   }
    cout << "Fit results loaded" << endl;
     // ************************
-    // set up the plot generator
+    // set up the samples at the parameters of the fit
     // ************************
 
-  atiSetup();
-  PlotGen plotGen( results );
-  cout << " Initialized ati and PlotGen" << endl;
+  ConfigurationInfo* cfgInfo = const_cast< ConfigurationInfo* >( results.configInfo() );
+  atiSetup( cfgInfo );
+  AmpToolsInterface ati( cfgInfo, AmpToolsInterface::kPlotGeneration );
+
+  vector< ParameterInfo* > parInfo = cfgInfo->parameterList();
+  for (unsigned int i = 0; i < parInfo.size(); i++){
+    if (!parInfo[i]->fixed())
+      ati.parameterManager()->setAmpParameter( parInfo[i]->parName(), results.parValue( parInfo[i]->parName() ) );
+  }
+  cout << " Initialized ati" << endl;
+
+  string reactionName = results.reactionList()[0];
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  int reaction = 0;
+  while (reactions[reaction]->reactionName() != reactionName) reaction++;
+
+    // ************************
+    // fill the projections of every sum configuration in one pass over
+    // the MC (see FitProjections), instead of one pass of PlotGenerator
+    // for each sum and one for the total
+    // ************************
+
+  cout << "Looping over input data" << endl;
+  FitProjections projections( "ThreePiPlotGeneratorSchilling", cfgInfo );
+  projections.fill( ati, FitProjections::productionParameters( results, cfgInfo ), reactionName );
+  vector<string> sums = projections.sumNames( reaction );
+  cout << "Reaction " << reactionName << " filled" << endl;
+
+  // the background only needs its weights
+  vector< TH1D* > bkgndHists( ThreePiPlotGeneratorSchilling::kNumHists );
+  for (unsigned int ivar = 0; ivar < ThreePiPlotGeneratorSchilling::kNumHists; ivar++){
+    int nBins;
+    double low, high;
+    ThreePiPlotGeneratorSchilling::histogramBinning(ivar, nBins, low, high);
+    string name = ThreePiPlotGeneratorSchilling::histogramName(ivar);
+    bkgndHists[ivar] = new TH1D(name.c_str(), name.c_str(), nBins, low, high);
+    bkgndHists[ivar]->SetDirectory(NULL);
+    bkgndHists[ivar]->Sumw2();
+  }
+
+  DataReader* bkgndReader = ati.bkgndReader( reactionName );
+  if (bkgndReader != NULL){
+    ThreePiPlotGeneratorSchilling projector;
+    vector< double > values( ThreePiPlotGeneratorSchilling::kNumHists );
+    bkgndReader->resetSource();
+    Kinematics* kin;
+    while ((kin = bkgndReader->getEvent()) != NULL){
+      projector.computeProjections(kin, &(values[0]));
+      for (unsigned int ivar = 0; ivar < ThreePiPlotGeneratorSchilling::kNumHists; ivar++)
+        bkgndHists[ivar]->Fill(values[ivar], kin->weight());
+      delete kin;
+    }
+  }
 
     // ************************
     // set up an output ROOT file to store histograms
@@ -109,27 +165,9 @@ int main( int argc, char* argv[] ){
   TFile* plotfile = new TFile( outName.c_str(), "recreate");
   TH1::AddDirectory(kFALSE);
 
-  string reactionName = results.reactionList()[0];
-  plotGen.enableReaction( reactionName );
-  vector<string> sums = plotGen.uniqueSums();
-  cout << "Reaction " << reactionName << " enabled" << endl;
-
   // loop over sum configurations (one for each of the individual contributions, and the combined sum of all)
   for (unsigned int isum = 0; isum <= sums.size(); isum++){
 
-    // turn on all sums by default
-    for (unsigned int i = 0; i < sums.size(); i++){
-      plotGen.enableSum(i);
-    }
-
-    // for individual contributions turn off all sums but the one of interest
-    if (isum < sums.size()){
-      for (unsigned int i = 0; i < sums.size(); i++){
-        if (i != isum) plotGen.disableSum(i);
-      }
-    }
-
-   cout << "Looping over input data" << endl;
     // loop over data, accMC, and genMC
     for (unsigned int iplot = 0; iplot < PlotGenerator::kNumTypes; iplot++){
       if (isum < sums.size() && iplot == PlotGenerator::kData) continue; // only plot data once
@@ -140,7 +178,7 @@ int main( int argc, char* argv[] ){
         // set unique histogram name for each plot (could put in directories...)
         string histname =  "";
         if (ivar == ThreePiPlotGeneratorSchilling::k3PiMass)  histname += "M3pi";
-	     else if (ivar == ThreePiPlotGeneratorSchilling::kCosTheta)  histname += "cosTheta";
+        else if (ivar == ThreePiPlotGeneratorSchilling::kCosTheta)  histname += "cosTheta";
         else if (ivar == ThreePiPlotGeneratorSchilling::kPhi)  histname += "Phi";
         else if (ivar == ThreePiPlotGeneratorSchilling::kphi)  histname += "phi";
         else if (ivar == ThreePiPlotGeneratorSchilling::kPsi)  histname += "psi";
@@ -152,27 +190,29 @@ int main( int argc, char* argv[] ){
         if (iplot == PlotGenerator::kAccMC) histname += "acc";
         if (iplot == PlotGenerator::kGenMC) histname += "gen";
 
-        if (isum < sums.size()){
-          //ostringstream sdig;  sdig << (isum + 1);
-          //histname += sdig.str();
+        // get name of sum for naming histogram
+        if (isum < sums.size()) histname += "_" + sums[isum];
 
-	  // get name of sum for naming histogram
-          string sumName = sums[isum];
-          histname += "_";
-          histname += sumName;
+        TH1* thist;
+        if (iplot == PlotGenerator::kBkgnd){
+          thist = (TH1*)bkgndHists[ivar]->Clone(histname.c_str());
+        }
+        else{
+          int type = ( iplot == PlotGenerator::kData ? FitProjections::kData :
+                       iplot == PlotGenerator::kAccMC ? FitProjections::kAccMC : FitProjections::kGenMC );
+          thist = projections.histogram(reaction, type, isum < sums.size() ? 1 + isum : 0, ivar);
         }
-
-        Histogram* hist = plotGen.projection(ivar, reactionName, iplot);
-        TH1* thist = hist->toRoot();
         thist->SetName(histname.c_str());
         plotfile->cd();
         thist->Write();
+        delete thist;
 
       }
     }
   }
 
   plotfile->Close();
+  for (unsigned int ivar = 0; ivar < bkgndHists.size(); ivar++) delete bkgndHists[ivar];
 
     // ************************
     // retrieve SDME parameters for plotting and asymmetry
@@ -229,6 +269,11 @@ int main( int argc, char* argv[] ){
 
   if(showGui) {
 
+	  // the interactive plots are those of PlotGenerator
+	  PlotGen plotGen( results );
+	  plotGen.enableReaction( reactionName );
+	  for (unsigned int i = 0; i < plotGen.uniqueSums().size(); i++) plotGen.enableSum(i);
+
 	  cout << ">> Plot generator ready, starting GUI..." << endl;
 	  
 	  int dummy_argc = 0;
@@ -5,57 +5,303 @@
 #include <string>
 #include <vector>
 #include <cassert>
-#include <utility>
+#include <cmath>
 #include <cstdlib>
+#include <stdint.h>
 
-#include "IUAmpTools/Kinematics.h"
-#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
-#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+#include "AMPTOOLS_AMPS/AmplitudeThreads.h"
+#include "AMPTOOLS_DATAIO/ROOTDataEvent.h"
+#include "AMPTOOLS_DATAIO/ROOTDataPrefetcher.h"
+#include "AMPTOOLS_DATAIO/ROOTDataWriterPool.h"
 
-#include "CLHEP/Vector/LorentzVector.h"
-
-#include "TRandom.h"
+#include "TLorentzVector.h"
+#include "TMath.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
 
 using namespace std;
-using namespace CLHEP;
+
+#define DEFTREENAME "kin"
+
+// An acceptance is the probability to keep an event.  The acceptances of
+// the command line are multiplied, and an event is kept if the product
+// exceeds a uniform random number.  New acceptances derive from
+// ToyAcceptance and are added to makeAcceptance.
+
+class ToyAcceptance
+{
+
+public:
+
+  virtual ~ToyAcceptance() {}
+
+  virtual double efficiency( const ROOTDataEvent& event ) const = 0;
+
+  // multiplies eff[i] by the efficiency of events[i]
+  void apply( const ROOTDataEvent* events, int n, double* eff ) const {
+
+    for( int i = 0; i < n; ++i ) eff[i] *= efficiency( events[i] );
+  }
+};
+
+// rising linearly with the mass of the final state without the recoil
+// (the first particle) up to scale:  mass[:scale]
+class MassAcceptance : public ToyAcceptance
+{
+
+public:
+
+  MassAcceptance( double scale ) : m_scale( scale ) {}
+
+  double efficiency( const ROOTDataEvent& event ) const {
+
+    TLorentzVector x;
+    for( int i = 1; i < event.nPart; ++i ) x += event.finalState( i );
+
+    double eff = x.M() / m_scale;
+    return ( eff < 1 ? eff : 1 );
+  }
+
+private:
+
+  double m_scale;
+};
+
+// every final state particle within the polar angles [min,max] in degrees
+// in the lab:  theta:min:max
+class ThetaAcceptance : public ToyAcceptance
+{
+
+public:
+
+  ThetaAcceptance( double minTheta, double maxTheta ) :
+    m_minTheta( minTheta * TMath::DegToRad() ),
+    m_maxTheta( maxTheta * TMath::DegToRad() ) {}
+
+  double efficiency( const ROOTDataEvent& event ) const {
+
+    for( int i = 0; i < event.nPart; ++i ){
+
+      double theta = event.finalState( i ).Theta();
+      if( theta < m_minTheta || theta > m_maxTheta ) return 0;
+    }
+
+    return 1;
+  }
+
+private:
+
+  double m_minTheta, m_maxTheta;
+};
+
+// a turn-on 1 - exp( -( p - pmin ) / scale ) in the momentum of every
+// final state particle:  momentum:pmin:scale
+class MomentumAcceptance : public ToyAcceptance
+{
+
+public:
+
+  MomentumAcceptance( double minP, double scale ) :
+    m_minP( minP ), m_scale( scale ) {}
+
+  double efficiency( const ROOTDataEvent& event ) const {
+
+    double eff = 1;
+    for( int i = 0; i < event.nPart; ++i ){
+
+      double p = event.finalState( i ).P();
+      if( p <= m_minP ) return 0;
+      eff *= 1 - exp( -( p - m_minP ) / m_scale );
+    }
+
+    return eff;
+  }
+
+private:
+
+  double m_minP, m_scale;
+};
+
+void Usage()
+{
+  cout << "Usage:\n  toy_detector <infile> <outfile> [options]\n\n";
+  cout << "   Keeps each event with the probability given by the acceptances.\n";
+  cout << "   Use -a [acceptance] to add an acceptance, the default is mass:3.\n";
+  cout << "     mass[:scale]         rising linearly with the mass of the final\n";
+  cout << "                          state without the recoil, 1 above scale\n";
+  cout << "     theta:min:max        all final state particles within [min,max]\n";
+  cout << "                          degrees of polar angle in the lab\n";
+  cout << "     momentum:pmin:scale  1 - exp( -( p - pmin ) / scale ) for each\n";
+  cout << "                          final state particle\n";
+  cout << "   Use -s [seed] to set the seed (default 0); the random number of an\n";
+  cout << "     event only depends on the seed and the entry, so the output does\n";
+  cout << "     not depend on the number of threads.\n";
+  cout << "   Use -j [nThreads] to evaluate the acceptance on nThreads threads.\n";
+  cout << "   Use -T [tree name] to set the tree name, inKin:outKin for both.\n";
+  cout << "   Use -C [codec[:level]] to set the output compression (zlib, lzma, lz4, zstd, none).\n";
+  cout << "   Use -B [bytes] to set the output basket size.\n";
+  cout << "   Use -F [n] to set the output auto-flush (entries if n > 0, bytes if n < 0).\n";
+  exit(1);
+}
+
+pair <string,string> GetTreeNames(char* treeArg)
+{
+  pair <string,string> treeNames(DEFTREENAME,"");
+  string treeArgStr(treeArg);
+  size_t delimPos=treeArgStr.find(':',1);
+
+  if (delimPos != string::npos){
+    treeNames.first=treeArgStr.substr(0,delimPos);
+    treeNames.second=treeArgStr.substr(delimPos+1);
+  }else
+    treeNames.second=treeArgStr;
+
+  return treeNames;
+}
+
+ToyAcceptance* makeAcceptance( const string& spec )
+{
+  vector< string > fields;
+  istringstream in( spec );
+  string field;
+  while( getline( in, field, ':' ) ) fields.push_back( field );
+
+  if( fields.size() == 0 ) Usage();
+
+  if( fields[0] == "mass" && fields.size() <= 2 ){
+
+    return new MassAcceptance( fields.size() == 2 ? atof( fields[1].c_str() ) : 3 );
+  }
+  if( fields[0] == "theta" && fields.size() == 3 ){
+
+    return new ThetaAcceptance( atof( fields[1].c_str() ), atof( fields[2].c_str() ) );
+  }
+  if( fields[0] == "momentum" && fields.size() == 3 ){
+
+    return new MomentumAcceptance( atof( fields[1].c_str() ), atof( fields[2].c_str() ) );
+  }
+
+  cout << "toy_detector ERROR:  unknown acceptance " << spec << endl;
+  Usage();
+  return NULL;
+}
+
+// A uniform number in [0,1) from the seed and the entry (the splitmix64
+// finalizer), so that every event has its own stream regardless of how
+// the events are shared out.
+double entryRandom( uint64_t seed, uint64_t entry )
+{
+  uint64_t z = seed * 0x9E3779B97F4A7C15ULL + entry + 1;
+  z *= 0x9E3779B97F4A7C15ULL;
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  z = z ^ ( z >> 31 );
+
+  return ( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
 
 int main( int argc, char* argv[] ){
-  
-  string treeName( "kin" );
-  
-	if( argc < 3 ){
-		
-		cout << "Usage:  toy_detector <infile> <outfile>" << endl;
-		return 1;
-	}
-	
-  vector< string > dataReaderArgs;
-  dataReaderArgs.push_back( argv[1] );
-  dataReaderArgs.push_back( treeName );
-  
-	ROOTDataReader in(  dataReaderArgs );
-  ROOTDataWriter out( argv[2] );
-	
-  Kinematics* event;
-  while( ( event = in.getEvent() ) != NULL ){
-    
-    vector< HepLorentzVector > fs = event->particleList();
-
-    HepLorentzVector x;
-    // the first two entries in this list are the beam and the recoil
-    // skip them in computing the mass
-		for( vector< HepLorentzVector >::iterator particle = fs.begin() + 2;
-        particle != fs.end(); ++particle ){
-			
-			x += *particle;
-		}
-
-    // an acceptance that is linearly rising with mass
-    if( x.m() > drand48() * 3 )
-      out.writeEvent( *event );
-    
-    delete event;
-  }
-  
-	return 0;
+
+  pair <string,string> treeNames(DEFTREENAME,DEFTREENAME);
+
+  unsigned int nThreads = 1;
+  uint64_t seed = 0;
+  vector< ToyAcceptance* > acceptances;
+  ROOTDataWriterOptions writerOptions;
+
+  if( argc < 3 ) Usage();
+
+  for( int i = 3; i < argc; ++i ){
+
+    string arg = argv[i];
+    if( i + 1 == argc ) Usage();
+
+    if( arg == "-a" ) acceptances.push_back( makeAcceptance( argv[++i] ) );
+    else if( arg == "-s" ) seed = strtoull( argv[++i], NULL, 10 );
+    else if( arg == "-j" ) nThreads = atoi( argv[++i] );
+    else if( arg == "-T" ) treeNames = GetTreeNames( argv[++i] );
+    else if( arg == "-C" ) writerOptions.compression = argv[++i];
+    else if( arg == "-B" ) writerOptions.basketSize = atoi( argv[++i] );
+    else if( arg == "-F" ) writerOptions.autoFlush = atoll( argv[++i] );
+    else Usage();
+  }
+
+  if( acceptances.empty() ) acceptances.push_back( new MassAcceptance( 3 ) );
+
+  AmplitudeThreads::setNumThreads( nThreads > 0 ? nThreads : 1 );
+
+  TH1::AddDirectory( kFALSE );
+
+  //this way of opening files works with URLs of the form
+  // root://xrootdserver/path/to/myfile.root
+  TFile* inFile = TFile::Open( argv[1] );
+  TTree* inTree = dynamic_cast< TTree* >( inFile->Get( treeNames.first.c_str() ) );
+  assert( inTree != NULL );
+
+  bool hasWeight = ( inTree->GetBranch( "Weight" ) != NULL );
+
+  // reading and decompressing the input runs ahead on its own thread
+  // and the output is compressed on another
+  ROOTDataPrefetcher in( inTree );
+  in.startAll();
+
+  ROOTDataWriterPool outFile( vector< string >( 1, argv[2] ), treeNames.second,
+                              true, hasWeight, 1, writerOptions );
+
+  // the acceptance is evaluated over blocks of events on all threads,
+  // the accepted events are written in their input order
+  enum { kBlockSize = 65536, kChunkSize = 1024 };
+
+  vector< ROOTDataEvent > events( kBlockSize );
+  vector< double > eff( kBlockSize );
+  vector< char > accept( kBlockSize );
+
+  unsigned int nEntries = static_cast< unsigned int >( inTree->GetEntries() );
+
+  for( unsigned int first = 0; first < nEntries; first += kBlockSize ){
+
+    int n = ( nEntries - first < kBlockSize ? nEntries - first : kBlockSize );
+
+    for( int i = 0; i < n; ++i ) in.next( events[i] );
+
+    AmplitudeThreads::runChunks( n, kChunkSize, [&]( int begin, int end ){
+
+      for( int i = begin; i < end; ++i ) eff[i] = 1;
+
+      for( unsigned int a = 0; a < acceptances.size(); ++a ){
+
+        acceptances[a]->apply( &events[begin], end - begin, &eff[begin] );
+      }
+
+      for( int i = begin; i < end; ++i ){
+
+        accept[i] = ( eff[i] > entryRandom( seed, events[i].entry ) );
+      }
+    } );
+
+    // the accepted events are moved to the front of the block and queued
+    // together
+    int nAccepted = 0;
+    for( int i = 0; i < n; ++i ){
+
+      if( !accept[i] ) continue;
+      if( nAccepted != i ) events[nAccepted] = events[i];
+      ++nAccepted;
+    }
+
+    outFile.writeEvents( 0, &events[0], nAccepted );
+  }
+
+  in.stop();
+  outFile.close();
+
+  inFile->Close();
+
+  cout << "Kept " << outFile.eventCounter( 0 ) << " of " << nEntries
+       << " events" << endl;
+
+  for( unsigned int a = 0; a < acceptances.size(); ++a ) delete acceptances[a];
+
+  return 0;
 }
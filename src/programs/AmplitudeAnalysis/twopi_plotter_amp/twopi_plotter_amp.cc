@@ -11,8 +11,13 @@
 #include "TStyle.h"
 #include "TClass.h"
 #include "TFile.h"
+#include "TH1D.h"
 
 #include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/FitResults.h"
 
 #include "AmpPlotter/PlotterMainWindow.h"
@@ -20,17 +25,15 @@
 
 #include "AMPTOOLS_DATAIO/TwoPiPlotGenerator.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles_amp.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_DATAIO/PlotSummaryWriter.h"
+#include "AMPTOOLS_DATAIO/FitProjections.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
 
 typedef TwoPiPlotGenerator PlotGen;
 
-void atiSetup(){
+void atiSetup( const ConfigurationInfo* cfgInfo ){
   
-  AmpToolsInterface::registerAmplitude( TwoPiAngles() );
-  AmpToolsInterface::registerAmplitude( TwoPiAngles_amp() );
-  AmpToolsInterface::registerAmplitude( BreitWigner() );
+  AmplitudeRegistry::registerUsed( cfgInfo );
   AmpToolsInterface::registerDataReader( ROOTDataReader() );
 }
 
@@ -54,6 +57,8 @@ int main( int argc, char* argv[] ){
   bool showGui = false;
   string outName = "twopi_plot.root";
   string resultsName(argv[1]);
+  vector< string > histNames;
+  string summaryName;
   for (int i = 2; i < argc; i++){
 
     string arg(argv[i]);
@@ -64,10 +69,26 @@ int main( int argc, char* argv[] ){
     if (arg == "-o"){
       outName = argv[++i];
     }
+    if (arg == "-j"){
+      AmplitudeThreads::setNumThreads( atoi( argv[++i] ) );
+    }
+    if (arg == "-p"){
+      string list = argv[++i];
+      for (size_t begin = 0, end = 0; end != string::npos; begin = end + 1){
+        end = list.find(',', begin);
+        histNames.push_back(list.substr(begin, end == string::npos ? end : end - begin));
+      }
+    }
+    if (arg == "-c"){
+      summaryName = argv[++i];
+    }
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "\t -o <file>\t output file path" << endl;
       cout << "\t -g <file>\t show GUI" << endl;
+      cout << "\t -j <int>\t evaluate the amplitudes on <int> threads" << endl;
+      cout << "\t -p <list>\t fill only these histograms, e.g., M2pi,cosTheta" << endl;
+      cout << "\t -c <file>\t also write the histograms as one tree of bins" << endl;
       exit(1);
     }
   }
@@ -92,11 +113,61 @@ int main( int argc, char* argv[] ){
   }
 
     // ************************
-    // set up the plot generator
+    // set up the samples at the parameters of the fit
     // ************************
 
-  atiSetup();
-  PlotGen plotGen( results );
+  ConfigurationInfo* cfgInfo = const_cast< ConfigurationInfo* >( results.configInfo() );
+  atiSetup( cfgInfo );
+  AmpToolsInterface ati( cfgInfo, AmpToolsInterface::kPlotGeneration );
+
+  vector< ParameterInfo* > parInfo = cfgInfo->parameterList();
+  for (unsigned int i = 0; i < parInfo.size(); i++){
+    if (!parInfo[i]->fixed())
+      ati.parameterManager()->setAmpParameter( parInfo[i]->parName(), results.parValue( parInfo[i]->parName() ) );
+  }
+
+  TwoPiPlotGenerator projector;
+  if (!histNames.empty() && !projector.requestHistograms(histNames)) exit(1);
+
+  string reactionName = results.reactionList()[0];
+  vector< ReactionInfo* > reactions = cfgInfo->reactionList();
+  int reaction = 0;
+  while (reactions[reaction]->reactionName() != reactionName) reaction++;
+
+    // ************************
+    // fill the projections of every sum configuration in one pass over
+    // the MC (see FitProjections), instead of one pass of PlotGenerator
+    // for each sum and one for the total
+    // ************************
+
+  FitProjections projections( "TwoPiPlotGenerator", cfgInfo );
+  projections.fill( ati, FitProjections::productionParameters( results, cfgInfo ), reactionName );
+  vector<string> sums = projections.sumNames( reaction );
+
+  // the background only needs its weights
+  vector< TH1D* > bkgndHists( TwoPiPlotGenerator::kNumHists );
+  for (unsigned int ivar = 0; ivar < TwoPiPlotGenerator::kNumHists; ivar++){
+    int nBins;
+    double low, high;
+    TwoPiPlotGenerator::histogramBinning(ivar, nBins, low, high);
+    string name = TwoPiPlotGenerator::histogramName(ivar);
+    bkgndHists[ivar] = new TH1D(name.c_str(), name.c_str(), nBins, low, high);
+    bkgndHists[ivar]->SetDirectory(NULL);
+    bkgndHists[ivar]->Sumw2();
+  }
+
+  DataReader* bkgndReader = ati.bkgndReader( reactionName );
+  if (bkgndReader != NULL){
+    vector< double > values( TwoPiPlotGenerator::kNumHists );
+    bkgndReader->resetSource();
+    Kinematics* kin;
+    while ((kin = bkgndReader->getEvent()) != NULL){
+      projector.computeProjections(kin, &(values[0]));
+      for (unsigned int ivar = 0; ivar < TwoPiPlotGenerator::kNumHists; ivar++)
+        if (projector.requested(ivar)) bkgndHists[ivar]->Fill(values[ivar], kin->weight());
+      delete kin;
+    }
+  }
 
     // ************************
     // set up an output ROOT file to store histograms
@@ -105,69 +176,56 @@ int main( int argc, char* argv[] ){
   TFile* plotfile = new TFile( outName.c_str(), "recreate");
   TH1::AddDirectory(kFALSE);
 
-  string reactionName = results.reactionList()[0];
-  plotGen.enableReaction( reactionName );
-  vector<string> sums = plotGen.uniqueSums();
-
+  PlotSummaryWriter* summary = NULL;
+  if (!summaryName.empty()) summary = new PlotSummaryWriter(summaryName);
 
   // loop over sum configurations (one for each of the individual contributions, and the combined sum of all)
   for (unsigned int isum = 0; isum <= sums.size(); isum++){
 
-    // turn on all sums by default
-    for (unsigned int i = 0; i < sums.size(); i++){
-      plotGen.enableSum(i);
-    }
-
-    // for individual contributions turn off all sums but the one of interest
-    if (isum < sums.size()){
-      for (unsigned int i = 0; i < sums.size(); i++){
-        if (i != isum) plotGen.disableSum(i);
-      }
-    }
-
-
     // loop over data, accMC, and genMC
     for (unsigned int iplot = 0; iplot < PlotGenerator::kNumTypes; iplot++){
       if (isum < sums.size() && iplot == PlotGenerator::kData) continue; // only plot data once
 
       // loop over different variables
       for (unsigned int ivar  = 0; ivar  < TwoPiPlotGenerator::kNumHists; ivar++){
+        if (!projector.requested(ivar)) continue;
+        if (ivar == TwoPiPlotGenerator::kPhiPiPlus || ivar == TwoPiPlotGenerator::kPhiPiMinus) continue;
 
         // set unique histogram name for each plot (could put in directories...)
-        string histname =  "";
-        if (ivar == TwoPiPlotGenerator::k2PiMass)  histname += "M2pi";
-	else if (ivar == TwoPiPlotGenerator::kPiPCosTheta)  histname += "cosTheta";
-        else if (ivar == TwoPiPlotGenerator::kPhi)  histname += "Phi";
-        else if (ivar == TwoPiPlotGenerator::kphi)  histname += "phi";
-        else if (ivar == TwoPiPlotGenerator::kPsi)  histname += "psi";
-        else if (ivar == TwoPiPlotGenerator::kt)  histname += "t";
-        else continue;
-
-        if (iplot == PlotGenerator::kData) histname += "dat";
-        if (iplot == PlotGenerator::kAccMC) histname += "acc";
-        if (iplot == PlotGenerator::kGenMC) histname += "gen";
-
-        if (isum < sums.size()){
-          //ostringstream sdig;  sdig << (isum + 1);
-          //histname += sdig.str();
-
-	  // get name of sum for naming histogram
-          string sumName = sums[isum];
-          histname += "_";
-          histname += sumName;
+        string varName = TwoPiPlotGenerator::histogramName(ivar);
+        string typeName = "";
+        if (iplot == PlotGenerator::kData) typeName = "dat";
+        if (iplot == PlotGenerator::kAccMC) typeName = "acc";
+        if (iplot == PlotGenerator::kGenMC) typeName = "gen";
+
+        // get name of sum for naming histogram
+        string histname = varName + typeName;
+        if (isum < sums.size()) histname += "_" + sums[isum];
+
+        TH1* thist;
+        if (iplot == PlotGenerator::kBkgnd){
+          thist = (TH1*)bkgndHists[ivar]->Clone(histname.c_str());
+        }
+        else{
+          int type = ( iplot == PlotGenerator::kData ? FitProjections::kData :
+                       iplot == PlotGenerator::kAccMC ? FitProjections::kAccMC : FitProjections::kGenMC );
+          thist = projections.histogram(reaction, type, isum < sums.size() ? 1 + isum : 0, ivar);
         }
-
-        Histogram* hist = plotGen.projection(ivar, reactionName, iplot);
-        TH1* thist = hist->toRoot();
         thist->SetName(histname.c_str());
         plotfile->cd();
         thist->Write();
 
+        if (summary != NULL)
+          summary->write(resultsName, isum < sums.size() ? sums[isum] : "", varName, typeName, *thist);
+
+        delete thist;
       }
     }
   }
 
   plotfile->Close();
+  delete summary;
+  for (unsigned int ivar = 0; ivar < bkgndHists.size(); ivar++) delete bkgndHists[ivar];
 
     // ************************
     // retrieve amplitudes for output
@@ -229,6 +287,12 @@ int main( int argc, char* argv[] ){
 
   if(showGui) {
 
+	  // the interactive plots are those of PlotGenerator
+	  PlotGen plotGen( results );
+	  if (!histNames.empty()) plotGen.requestHistograms(histNames);
+	  plotGen.enableReaction( reactionName );
+	  for (unsigned int i = 0; i < plotGen.uniqueSums().size(); i++) plotGen.enableSum(i);
+
 	  cout << ">> Plot generator ready, starting GUI..." << endl;
 	  
 	  int dummy_argc = 0;
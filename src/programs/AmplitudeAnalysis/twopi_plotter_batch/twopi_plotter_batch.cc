@@ -0,0 +1,550 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <map>
+#include <mutex>
+#include <cstdlib>
+#include <cmath>
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TH1D.h"
+
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+#include "IUAmpTools/ParameterManager.h"
+#include "IUAmpTools/DataReader.h"
+#include "IUAmpTools/Kinematics.h"
+#include "IUAmpTools/FitResults.h"
+
+#include "AMPTOOLS_DATAIO/TwoPiPlotGenerator.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
+#include "AMPTOOLS_DATAIO/PlotSummaryWriter.h"
+#include "AMPTOOLS_DATAIO/IntensityColumns.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
+
+using namespace std;
+
+// This writes the projections of twopi_plotter for many fits in one go,
+// e.g., the bootstrap replicas or the mass and t bins of an analysis.
+// twopi_plotter loads the accepted and generated MC again for every fit;
+// here they are loaded once, with their decay amplitudes and projected
+// quantities, and each fit only reweights them with its production
+// parameters.  The data are loaded again only when their source differs
+// from that of the fit before, and the MC only when a free amplitude
+// parameter (e.g., a mass or width) differs.  All fits must have the same
+// amplitudes and MC samples as the first fit of the manifest.
+//
+// The MC is weighted with the intensity divided by the (weighted) number
+// of generated events, so the accepted MC gives the predicted yield and
+// the generated MC the acceptance-corrected one.  Each fit is written to
+// a directory of the output file, named after the fit file, with the
+// histogram names of twopi_plotter.
+//
+// With -i the intensities are read from the files that fit writes with
+// --intensity-columns next to each fit results file, and the amplitudes
+// are not evaluated at all:  the MC is only read and projected once, even
+// if the amplitude parameters differ between fits.
+
+void Usage()
+{
+  cout << "Usage:\n  twopi_plotter_batch <manifest> -o <output file> [-j <int>] [-p <list>] [-c <file>] [-i]\n\n";
+  cout << "   the manifest lists one fit results file per line\n";
+  cout << "   -j <int>\t evaluate the amplitudes and weights on <int> threads\n";
+  cout << "   -p <list>\t write only these histograms, e.g., M2pi,cosTheta\n";
+  cout << "   -c <file>\t also write the histograms as one tree of bins\n";
+  cout << "   -i\t\t read the intensities of the MC from the files of fit --intensity-columns\n";
+  exit(1);
+}
+
+void atiSetup(){
+
+  AmpToolsInterface::registerDataReader( ROOTDataReader() );
+  AmpToolsInterface::registerDataReader( ROOTDataReaderBootstrap() );
+}
+
+// The events of a sample, with the projected quantities (kNumHists per
+// event) and, for the MC, the decay amplitudes (nAmps per event).
+struct Sample {
+
+  string source;
+  int nEvents;
+  double sumWeights;
+  vector< double > weights;
+  vector< double > values;
+  vector< complex< double > > decayAmps;
+
+  Sample() : nEvents( 0 ), sumWeights( 0 ) {}
+};
+
+// The weighted sums of the histograms (with under- and overflow) and of
+// the squared weights, for the total and for each sum.
+struct Histograms {
+
+  vector< double > sumW;
+  vector< double > sumW2;
+};
+
+static const int kNumHists = TwoPiPlotGenerator::kNumHists;
+
+string sourceName( const pair< string, vector< string > >& source ){
+
+  string name = source.first;
+  for( unsigned int i = 0; i < source.second.size(); ++i ) name += " " + source.second[i];
+  return name;
+}
+
+// the amplitudes, their factors and sums, which fix the decay amplitudes
+// up to the values of the amplitude parameters
+string amplitudeKey( const vector< AmplitudeInfo* >& amps ){
+
+  string key;
+  for( unsigned int i = 0; i < amps.size(); ++i ){
+
+    key += amps[i]->fullName() + ";";
+    vector< vector< string > > factors = amps[i]->factors();
+    for( unsigned int j = 0; j < factors.size(); ++j )
+      for( unsigned int k = 0; k < factors[j].size(); ++k ) key += factors[j][k] + " ";
+  }
+  return key;
+}
+
+// the free amplitude parameters of a fit and their values
+map< string, double > ampParameters( const FitResults& results, ConfigurationInfo* cfgInfo ){
+
+  map< string, double > pars;
+
+  vector< ParameterInfo* > parInfo = cfgInfo->parameterList();
+  for( unsigned int i = 0; i < parInfo.size(); ++i )
+    if( !parInfo[i]->fixed() ) pars[parInfo[i]->parName()] = results.parValue( parInfo[i]->parName() );
+
+  return pars;
+}
+
+void loadData( DataReader* reader, const TwoPiPlotGenerator& projector, Sample& sample ){
+
+  sample = Sample();
+  reader->resetSource();
+
+  Kinematics* kin;
+  while( ( kin = reader->getEvent() ) != NULL ){
+
+    sample.values.resize( ( sample.nEvents + 1 ) * kNumHists );
+    projector.computeProjections( kin, &( sample.values[sample.nEvents * kNumHists] ) );
+    sample.weights.push_back( kin->weight() );
+    sample.sumWeights += kin->weight();
+    ++sample.nEvents;
+
+    delete kin;
+  }
+}
+
+void loadMC( AmpToolsInterface& ati, DataReader* reader, const string& reaction,
+             const vector< string >& ampNames, const TwoPiPlotGenerator& projector,
+             Sample& sample ){
+
+  reader->resetSource();
+  ati.loadEvents( reader );
+  ati.processEvents( reaction );
+
+  int nAmps = ampNames.size();
+  sample.nEvents = ati.numEvents();
+  sample.sumWeights = 0;
+  sample.weights.resize( sample.nEvents );
+  sample.values.resize( (size_t)sample.nEvents * kNumHists );
+  sample.decayAmps.resize( (size_t)sample.nEvents * nAmps );
+
+  for( int iEvent = 0; iEvent < sample.nEvents; ++iEvent ){
+
+    Kinematics* kin = ati.kinematics( iEvent );
+    projector.computeProjections( kin, &( sample.values[(size_t)iEvent * kNumHists] ) );
+    sample.weights[iEvent] = kin->weight();
+    sample.sumWeights += kin->weight();
+    delete kin;
+
+    for( int iamp = 0; iamp < nAmps; ++iamp )
+      sample.decayAmps[(size_t)iEvent * nAmps + iamp] = ati.decayAmplitude( iEvent, ampNames[iamp] );
+  }
+
+  ati.clearEvents();
+}
+
+int bin( int hist, double value ){
+
+  int nBins;
+  double low, high;
+  TwoPiPlotGenerator::histogramBinning( hist, nBins, low, high );
+
+  if( value < low ) return 0;
+  if( value >= high ) return nBins + 1;
+  return 1 + (int)( ( value - low ) / ( high - low ) * nBins );
+}
+
+// Fills the histograms of nConfigs configurations; weights( event, w )
+// gives the weight of an event in each configuration.
+template< class F >
+void fill( const Sample& sample, const TwoPiPlotGenerator& projector, int nConfigs,
+           F weights, vector< Histograms >& hists ){
+
+  vector< int > offset( kNumHists + 1, 0 );
+  for( int hist = 0; hist < kNumHists; ++hist ){
+
+    int nBins;
+    double low, high;
+    TwoPiPlotGenerator::histogramBinning( hist, nBins, low, high );
+    offset[hist + 1] = offset[hist] + nBins + 2;
+  }
+
+  hists.assign( nConfigs, Histograms() );
+  for( int c = 0; c < nConfigs; ++c ){
+
+    hists[c].sumW.assign( offset[kNumHists], 0. );
+    hists[c].sumW2.assign( offset[kNumHists], 0. );
+  }
+
+  mutex merge;
+
+  AmplitudeThreads::run( sample.nEvents, [&]( int begin, int end ){
+
+    vector< Histograms > local( hists );
+    vector< double > w( nConfigs );
+
+    for( int iEvent = begin; iEvent < end; ++iEvent ){
+
+      weights( iEvent, &( w[0] ) );
+      const double* values = &( sample.values[(size_t)iEvent * kNumHists] );
+
+      for( int hist = 0; hist < kNumHists; ++hist ){
+
+        if( !projector.requested( hist ) ) continue;
+
+        int index = offset[hist] + bin( hist, values[hist] );
+        for( int c = 0; c < nConfigs; ++c ){
+
+          local[c].sumW[index] += w[c];
+          local[c].sumW2[index] += w[c] * w[c];
+        }
+      }
+    }
+
+    lock_guard< mutex > guard( merge );
+    for( int c = 0; c < nConfigs; ++c ){
+      for( unsigned int i = 0; i < local[c].sumW.size(); ++i ){
+
+        hists[c].sumW[i] += local[c].sumW[i];
+        hists[c].sumW2[i] += local[c].sumW2[i];
+      }
+    }
+  } );
+}
+
+void write( TDirectory* dir, const Histograms& hists, const TwoPiPlotGenerator& projector,
+            const string& type, const string& sum, const string& fit, PlotSummaryWriter* summary ){
+
+  dir->cd();
+
+  int offset = 0;
+  for( int hist = 0; hist < kNumHists; ++hist ){
+
+    int nBins;
+    double low, high;
+    TwoPiPlotGenerator::histogramBinning( hist, nBins, low, high );
+
+    if( projector.requested( hist ) ){
+
+      string name = TwoPiPlotGenerator::histogramName( hist ) + type + ( sum.empty() ? "" : "_" + sum );
+      TH1D thist( name.c_str(), name.c_str(), nBins, low, high );
+      for( int i = 0; i < nBins + 2; ++i ){
+
+        thist.SetBinContent( i, hists.sumW[offset + i] );
+        thist.SetBinError( i, sqrt( hists.sumW2[offset + i] ) );
+      }
+      thist.Write();
+
+      if( summary != NULL )
+        summary->write( fit, sum, TwoPiPlotGenerator::histogramName( hist ), type, thist );
+    }
+
+    offset += nBins + 2;
+  }
+}
+
+int main( int argc, char* argv[] ){
+
+  if( argc < 2 ) Usage();
+
+  string manifestName( argv[1] );
+  string outName;
+  vector< string > histNames;
+  string summaryName;
+  bool useColumns = false;
+
+  for( int i = 2; i < argc; i++ ){
+
+    string arg( argv[i] );
+
+    if( arg == "-o" ){
+      if( i + 1 == argc ) Usage();
+      outName = argv[++i];
+    }
+    else if( arg == "-j" ){
+      if( i + 1 == argc ) Usage();
+      AmplitudeThreads::setNumThreads( atoi( argv[++i] ) );
+    }
+    else if( arg == "-p" ){
+      if( i + 1 == argc ) Usage();
+      string list = argv[++i];
+      for( size_t begin = 0, end = 0; end != string::npos; begin = end + 1 ){
+        end = list.find( ',', begin );
+        histNames.push_back( list.substr( begin, end == string::npos ? end : end - begin ) );
+      }
+    }
+    else if( arg == "-c" ){
+      if( i + 1 == argc ) Usage();
+      summaryName = argv[++i];
+    }
+    else if( arg == "-i" ) useColumns = true;
+    else Usage();
+  }
+
+  if( outName.empty() ) Usage();
+
+  vector< string > fitFiles;
+  ifstream manifest( manifestName.c_str() );
+  string line;
+  while( getline( manifest, line ) ){
+
+    size_t begin = line.find_first_not_of( " \t" );
+    if( begin == string::npos || line[begin] == '#' ) continue;
+    fitFiles.push_back( line.substr( begin, line.find_last_not_of( " \t" ) + 1 - begin ) );
+  }
+
+  if( fitFiles.empty() ){
+
+    cout << "twopi_plotter_batch ERROR:  no fit results in " << manifestName << endl;
+    exit(1);
+  }
+
+  TwoPiPlotGenerator projector;
+  if( !histNames.empty() && !projector.requestHistograms( histNames ) ) exit(1);
+
+  atiSetup();
+
+  TFile* plotfile = new TFile( outName.c_str(), "recreate" );
+  TH1::AddDirectory( kFALSE );
+
+  PlotSummaryWriter* summary = ( summaryName.empty() ? NULL : new PlotSummaryWriter( summaryName ) );
+
+  // the MC of the first fit, which all others have to share; the
+  // configuration of the AmpToolsInterface belongs to firstResults
+  FitResults* firstResults = NULL;
+  AmpToolsInterface* mcATI = NULL;
+  string reaction, ampKey, accSource, genSource;
+  vector< string > ampNames;
+  map< string, double > mcAmpPars;
+  bool mcLoaded = false;
+
+  Sample data, accMC, genMC;
+  int nWritten = 0;
+
+  for( unsigned int ifit = 0; ifit < fitFiles.size(); ++ifit ){
+
+    FitResults* results = new FitResults( fitFiles[ifit] );
+    if( !results->valid() ){
+
+      cout << "twopi_plotter_batch ERROR:  invalid fit results in " << fitFiles[ifit]
+           << ", skipped" << endl;
+      delete results;
+      continue;
+    }
+
+    ConfigurationInfo* cfgInfo = const_cast< ConfigurationInfo* >( results->configInfo() );
+    AmplitudeRegistry::registerUsed( cfgInfo );
+    string fitReaction = results->reactionList()[0];
+    ReactionInfo* reactionInfo = cfgInfo->reaction( fitReaction );
+    vector< AmplitudeInfo* > amps = cfgInfo->amplitudeList( fitReaction );
+
+    if( mcATI == NULL ){
+
+      firstResults = results;
+      reaction = fitReaction;
+      ampKey = amplitudeKey( amps );
+      accSource = sourceName( reactionInfo->accMC() );
+      genSource = sourceName( reactionInfo->genMC() );
+      for( unsigned int i = 0; i < amps.size(); ++i ) ampNames.push_back( amps[i]->fullName() );
+
+      mcATI = new AmpToolsInterface( cfgInfo, AmpToolsInterface::kPlotGeneration );
+    }
+    else if( fitReaction != reaction || amplitudeKey( amps ) != ampKey ||
+             sourceName( reactionInfo->accMC() ) != accSource ||
+             sourceName( reactionInfo->genMC() ) != genSource ){
+
+      cout << "twopi_plotter_batch ERROR:  " << fitFiles[ifit] << " does not have the amplitudes "
+           << "and MC of " << fitFiles[0] << ", skipped" << endl;
+      delete results;
+      continue;
+    }
+
+    // the intensities of the fit do not need the amplitudes, only the
+    // events in the order of the readers
+    if( useColumns && !mcLoaded ){
+
+      mcLoaded = true;
+
+      cout << "Loading the MC" << endl;
+      loadData( mcATI->accMCReader( reaction ), projector, accMC );
+      loadData( mcATI->genMCReader( reaction ), projector, genMC );
+    }
+
+    // the decay amplitudes depend on the free amplitude parameters
+    map< string, double > ampPars = ( useColumns ? mcAmpPars : ampParameters( *results, cfgInfo ) );
+    if( !mcLoaded || ampPars != mcAmpPars ){
+
+      ParameterManager* parMgr = mcATI->parameterManager();
+      for( map< string, double >::iterator par = ampPars.begin(); par != ampPars.end(); ++par )
+        parMgr->setAmpParameter( par->first, par->second );
+      mcAmpPars = ampPars;
+      mcLoaded = true;
+
+      cout << "Loading the MC for " << fitFiles[ifit] << endl;
+      loadMC( *mcATI, mcATI->accMCReader( reaction ), reaction, ampNames, projector, accMC );
+      loadMC( *mcATI, mcATI->genMCReader( reaction ), reaction, ampNames, projector, genMC );
+    }
+
+    string dataSource = sourceName( reactionInfo->data() );
+    if( dataSource != data.source ){
+
+      if( results == firstResults ) loadData( mcATI->dataReader( reaction ), projector, data );
+      else {
+
+        AmpToolsInterface dataATI( cfgInfo, AmpToolsInterface::kPlotGeneration );
+        loadData( dataATI.dataReader( reaction ), projector, data );
+      }
+      data.source = dataSource;
+    }
+
+    // the sums, the (scaled) production parameters and the sum of each amplitude
+    vector< string > sums;
+    vector< int > ampSum( amps.size() );
+    vector< complex< double > > prodPars( amps.size() );
+    for( unsigned int iamp = 0; iamp < amps.size(); ++iamp ){
+
+      string sumName = amps[iamp]->sumName();
+      unsigned int isum = 0;
+      while( isum < sums.size() && sums[isum] != sumName ) ++isum;
+      if( isum == sums.size() ) sums.push_back( sumName );
+
+      ampSum[iamp] = isum;
+      prodPars[iamp] = results->scaledProductionParameter( ampNames[iamp] );
+    }
+
+    string fitBase = fitFiles[ifit];
+    if( fitBase.size() > 4 && fitBase.substr( fitBase.size() - 4 ) == ".fit" )
+      fitBase.erase( fitBase.size() - 4 );
+
+    // the intensity of each sum for the accepted and the generated MC
+    vector< IntensityColumns* > columns;
+    vector< vector< const float* > > sumColumns( 2 );
+    if( useColumns ){
+
+      bool found = true;
+      for( int itype = 0; itype < 2 && found; ++itype ){
+
+        string fileName = IntensityColumns::fileName( fitBase, reaction, itype == 0 ? "acc" : "gen" );
+        columns.push_back( new IntensityColumns( fileName ) );
+
+        found = columns[itype]->valid() &&
+                columns[itype]->aligned( itype == 0 ? accMC.weights : genMC.weights );
+        for( unsigned int isum = 0; isum < sums.size() && found; ++isum ){
+
+          int column = columns[itype]->column( "sum:" + sums[isum] );
+          if( column >= 0 ) sumColumns[itype].push_back( columns[itype]->values( column ) );
+          else found = false;
+        }
+      }
+
+      if( !found ){
+
+        cout << "twopi_plotter_batch ERROR:  no intensities of the sums of " << fitFiles[ifit]
+             << " for the MC of " << fitFiles[0] << ", skipped" << endl;
+        for( unsigned int i = 0; i < columns.size(); ++i ) delete columns[i];
+        if( results != firstResults ) delete results;
+        continue;
+      }
+    }
+
+    int nAmps = amps.size();
+    int nConfigs = sums.size() + 1;
+
+    vector< Histograms > dataHists, accHists, genHists;
+
+    fill( data, projector, 1, [&]( int iEvent, double* w ){ w[0] = data.weights[iEvent]; },
+          dataHists );
+
+    // configuration 0 is the sum of all, configuration 1 + isum the sum isum
+    for( int itype = 0; itype < 2; ++itype ){
+
+      const Sample& sample = ( itype == 0 ? accMC : genMC );
+      double scale = 1 / genMC.sumWeights;
+
+      fill( sample, projector, nConfigs, [&]( int iEvent, double* w ){
+
+        if( useColumns ){
+
+          w[0] = 0;
+          for( unsigned int isum = 0; isum < sums.size(); ++isum ){
+
+            w[1 + isum] = sample.weights[iEvent] * scale * sumColumns[itype][isum][iEvent];
+            w[0] += w[1 + isum];
+          }
+          return;
+        }
+
+        vector< complex< double > > sumAmp( sums.size() );
+        const complex< double >* decayAmps = &( sample.decayAmps[(size_t)iEvent * nAmps] );
+        for( int iamp = 0; iamp < nAmps; ++iamp )
+          sumAmp[ampSum[iamp]] += prodPars[iamp] * decayAmps[iamp];
+
+        w[0] = 0;
+        for( unsigned int isum = 0; isum < sums.size(); ++isum ){
+
+          w[1 + isum] = sample.weights[iEvent] * scale * norm( sumAmp[isum] );
+          w[0] += w[1 + isum];
+        }
+      }, ( itype == 0 ? accHists : genHists ) );
+    }
+
+    for( unsigned int i = 0; i < columns.size(); ++i ) delete columns[i];
+
+    string dirName = fitBase;
+    for( unsigned int i = 0; i < dirName.size(); ++i ) if( dirName[i] == '/' ) dirName[i] = '_';
+
+    TDirectory* dir = plotfile->mkdir( dirName.c_str() );
+
+    write( dir, dataHists[0], projector, "dat", "", fitFiles[ifit], summary );
+    write( dir, accHists[0], projector, "acc", "", fitFiles[ifit], summary );
+    write( dir, genHists[0], projector, "gen", "", fitFiles[ifit], summary );
+    for( unsigned int isum = 0; isum < sums.size(); ++isum ){
+
+      write( dir, accHists[1 + isum], projector, "acc", sums[isum], fitFiles[ifit], summary );
+      write( dir, genHists[1 + isum], projector, "gen", sums[isum], fitFiles[ifit], summary );
+    }
+    ++nWritten;
+
+    if( results != firstResults ) delete results;
+  }
+
+  plotfile->Close();
+  delete summary;
+
+  cout << "Wrote the projections of " << nWritten << " of " << fitFiles.size()
+       << " fits to " << outName << endl;
+
+  delete mcATI;
+  delete firstResults;
+
+  return 0;
+}
@@ -26,15 +26,7 @@
 
 #include "AMPTOOLS_DATAIO/TwoZPiPlotGenerator.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles.h"
-#include "AMPTOOLS_AMPS/TwoPiWt_primakoff.h"
-#include "AMPTOOLS_AMPS/TwoPiWt_sigma.h"
-#include "AMPTOOLS_AMPS/TwoPiW_brokenetas.h"
-#include "AMPTOOLS_AMPS/TwoPitdist.h"
-#include "AMPTOOLS_AMPS/TwoPiNC_tdist.h"
-#include "AMPTOOLS_AMPS/TwoPiEtas_tdist.h"
-#include "AMPTOOLS_AMPS/TwoPiAngles_primakoff.h"
-#include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_AMPS/AmplitudeRegistry.h"
 
 
 using namespace std;
@@ -59,17 +51,9 @@ vector<string> stringSplit (string s, string delimiter) {
 
 typedef TwoZPiPlotGenerator PlotGen;
 
-void atiSetup(){
+void atiSetup( const ConfigurationInfo* cfgInfo ){
   
-  AmpToolsInterface::registerAmplitude( TwoPiAngles() );
-  AmpToolsInterface::registerAmplitude( TwoPiAngles_primakoff() );
-  AmpToolsInterface::registerAmplitude( TwoPiWt_primakoff() );
-  AmpToolsInterface::registerAmplitude( TwoPiWt_sigma() );
-  AmpToolsInterface::registerAmplitude( TwoPiW_brokenetas() );
-  AmpToolsInterface::registerAmplitude( TwoPitdist() );
-  AmpToolsInterface::registerAmplitude( TwoPiNC_tdist() );
-  AmpToolsInterface::registerAmplitude( TwoPiEtas_tdist() );
-  AmpToolsInterface::registerAmplitude( BreitWigner() );
+  AmplitudeRegistry::registerUsed( cfgInfo );
   AmpToolsInterface::registerDataReader( ROOTDataReader() );
 }
 
@@ -103,10 +87,14 @@ int main( int argc, char* argv[] ){
     if (arg == "-o"){
       outName = argv[++i];
     }
+    if (arg == "-j"){
+      AmplitudeThreads::setNumThreads( atoi( argv[++i] ) );
+    }
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "\t -o <file>\t output file path" << endl;
       cout << "\t -g <file>\t show GUI" << endl;
+      cout << "\t -j <int>\t evaluate the amplitudes on <int> threads" << endl;
       exit(1);
     }
   }
@@ -134,7 +122,7 @@ int main( int argc, char* argv[] ){
     // set up the plot generator
     // ************************
 
-  atiSetup();
+  atiSetup( results.configInfo() );
   PlotGen plotGen( results );
 
     // ************************